@@ -1509,6 +1509,13 @@ static inline void update_mmu_cache_range(struct vm_fault *vmf,
  */
 #define arch_wants_old_prefaulted_pte	cpu_has_hw_af
 
+/*
+ * Request that executable file mappings are read into the page cache in
+ * folios of at least 64K. With 4K base pages that is exactly one contiguous
+ * PTE block, so the text can be mapped with a single iTLB entry per 64K.
+ */
+#define exec_folio_order()		ilog2(SZ_64K >> PAGE_SHIFT)
+
 static inline bool pud_sect_supported(void)
 {
 	return PAGE_SIZE == SZ_4K;
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Interleaved CRC32(C) for large buffers using AArch64 CRC instructions
+ *
+ * The CRC instructions have a latency of several cycles but can issue every
+ * cycle, so a single dependency chain leaves most of the unit idle. Buffers
+ * of at least 3 * CRC32_STRIDE bytes are instead consumed in blocks of three
+ * independent streams, which are then folded together by advancing the
+ * earlier partial CRCs over CRC32_STRIDE zero bytes. That shift is linear,
+ * so it is done with four byte-indexed tables computed at boot.
+ */
+
+#include <linux/cache.h>
+#include <linux/crc32.h>
+#include <linux/crc32poly.h>
+#include <linux/init.h>
+#include <linux/jump_label.h>
+#include <linux/linkage.h>
+#include <linux/types.h>
+#include <linux/unaligned.h>
+
+#include <asm/cpufeature.h>
+
+#define CRC32_STRIDE	256
+
+asmlinkage u32 crc32_le_arm64(u32 crc, unsigned char const *p, size_t len);
+asmlinkage u32 __crc32c_le_arm64(u32 crc, unsigned char const *p, size_t len);
+
+static DEFINE_STATIC_KEY_FALSE(have_crc32_3way);
+
+static u32 crc32_shift_tbl[4][256] __ro_after_init;
+static u32 crc32c_shift_tbl[4][256] __ro_after_init;
+
+static inline u32 crc32x(u32 crc, u64 val)
+{
+	asm(".arch_extension crc\n\tcrc32x %w0, %w0, %x1" : "+r" (crc) : "r" (val));
+	return crc;
+}
+
+static inline u32 crc32cx(u32 crc, u64 val)
+{
+	asm(".arch_extension crc\n\tcrc32cx %w0, %w0, %x1" : "+r" (crc) : "r" (val));
+	return crc;
+}
+
+/* Advance @crc over CRC32_STRIDE zero bytes */
+static inline u32 crc32_shift(const u32 (*tbl)[256], u32 crc)
+{
+	return tbl[0][crc & 0xff] ^ tbl[1][(crc >> 8) & 0xff] ^
+	       tbl[2][(crc >> 16) & 0xff] ^ tbl[3][crc >> 24];
+}
+
+static __always_inline u32 crc32_3way(u32 crc, const u8 *p, size_t nblocks,
+				      const u32 (*tbl)[256], bool castagnoli)
+{
+	while (nblocks--) {
+		u32 c0 = crc, c1 = 0, c2 = 0;
+		int i;
+
+		for (i = 0; i < CRC32_STRIDE; i += 8) {
+			u64 v0 = get_unaligned_le64(p + i);
+			u64 v1 = get_unaligned_le64(p + CRC32_STRIDE + i);
+			u64 v2 = get_unaligned_le64(p + 2 * CRC32_STRIDE + i);
+
+			if (castagnoli) {
+				c0 = crc32cx(c0, v0);
+				c1 = crc32cx(c1, v1);
+				c2 = crc32cx(c2, v2);
+			} else {
+				c0 = crc32x(c0, v0);
+				c1 = crc32x(c1, v1);
+				c2 = crc32x(c2, v2);
+			}
+		}
+
+		crc = crc32_shift(tbl, crc32_shift(tbl, c0) ^ c1) ^ c2;
+		p += 3 * CRC32_STRIDE;
+	}
+
+	return crc;
+}
+
+u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
+{
+	if (static_branch_likely(&have_crc32_3way) &&
+	    len >= 3 * CRC32_STRIDE) {
+		size_t nblocks = len / (3 * CRC32_STRIDE);
+
+		crc = crc32_3way(crc, p, nblocks, crc32_shift_tbl, false);
+		p += nblocks * 3 * CRC32_STRIDE;
+		len -= nblocks * 3 * CRC32_STRIDE;
+	}
+
+	return crc32_le_arm64(crc, p, len);
+}
+
+u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
+{
+	if (static_branch_likely(&have_crc32_3way) &&
+	    len >= 3 * CRC32_STRIDE) {
+		size_t nblocks = len / (3 * CRC32_STRIDE);
+
+		crc = crc32_3way(crc, p, nblocks, crc32c_shift_tbl, true);
+		p += nblocks * 3 * CRC32_STRIDE;
+		len -= nblocks * 3 * CRC32_STRIDE;
+	}
+
+	return __crc32c_le_arm64(crc, p, len);
+}
+
+static void __init crc32_build_shift_tbl(u32 (*tbl)[256], u32 poly)
+{
+	u32 basis[32];
+	int i, j;
+
+	/* Image of each single-bit CRC after CRC32_STRIDE zero bytes */
+	for (i = 0; i < 32; i++) {
+		u32 crc = BIT(i);
+
+		for (j = 0; j < CRC32_STRIDE * 8; j++)
+			crc = (crc >> 1) ^ (crc & 1 ? poly : 0);
+		basis[i] = crc;
+	}
+
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 256; j++) {
+			u32 val = 0;
+			int k;
+
+			for (k = 0; k < 8; k++)
+				if (j & BIT(k))
+					val ^= basis[i * 8 + k];
+			tbl[i][j] = val;
+		}
+	}
+}
+
+static int __init crc32_3way_init(void)
+{
+	if (!cpus_have_final_cap(ARM64_HAS_CRC32))
+		return 0;
+
+	crc32_build_shift_tbl(crc32_shift_tbl, CRC32_POLY_LE);
+	crc32_build_shift_tbl(crc32c_shift_tbl, CRC32C_POLY_LE);
+	static_branch_enable(&have_crc32_3way);
+	return 0;
+}
+arch_initcall(crc32_3way_init);
@@ -26,6 +26,17 @@
 
 #define AHCI_DWC_FBS_PMPN_MAX		15
 
+/* Generic AHCI Command Completion Coalescing control register fields */
+#define AHCI_DWC_CCC_TV_MASK		GENMASK(31, 16)
+#define AHCI_DWC_CCC_CC_MASK		GENMASK(15, 8)
+#define AHCI_DWC_CCC_INT_MASK		GENMASK(7, 3)
+#define AHCI_DWC_CCC_EN			BIT(0)
+
+/* Per-port interrupts which signal a command completion */
+#define AHCI_DWC_CCC_PORT_IRQ_MASK	(PORT_IRQ_SG_DONE | PORT_IRQ_SDB_FIS | \
+					 PORT_IRQ_DMAS_FIS | PORT_IRQ_PIOS_FIS | \
+					 PORT_IRQ_D2H_REG_FIS)
+
 /* DWC AHCI SATA controller specific registers */
 #define AHCI_DWC_HOST_OOBR		0xbc
 #define AHCI_DWC_HOST_OOB_WE		BIT(31)
@@ -120,6 +131,10 @@ struct ahci_dwc_host_priv {
 
 	u32 timv;
 	u32 dmacr[AHCI_MAX_PORTS];
+
+	u32 ccc_ctl;
+	u32 ccc_ports;
+	u32 ccc_irq_mask;
 };
 
 static int ahci_bt1_init(struct ahci_host_priv *hpriv)
@@ -185,9 +200,10 @@ static void ahci_dwc_check_cap(struct ahci_host_priv *hpriv)
 	struct ahci_dwc_host_priv *dpriv = hpriv->plat_data;
 	bool dev_mp, dev_cp, fbs_sup;
 	unsigned int fbs_pmp;
-	u32 param;
+	u32 param, cap;
 	int i;
 
+	cap = readl(hpriv->mmio + HOST_CAP);
 	param = readl(hpriv->mmio + AHCI_DWC_HOST_GPARAM2R);
 	dev_mp = !!(param & AHCI_DWC_HOST_DEV_MP);
 	dev_cp = !!(param & AHCI_DWC_HOST_DEV_CP);
@@ -205,6 +221,15 @@ static void ahci_dwc_check_cap(struct ahci_host_priv *hpriv)
 			 fbs_pmp);
 	}
 
+	/*
+	 * CAP.FBSS is a HwInit field which firmware doesn't always get right,
+	 * while the synthesized FBS support of the core is reported by the
+	 * GPARAM2R register. Let libahci turn it on if the core has been
+	 * built with both PMP and FBS.
+	 */
+	if (fbs_sup && (cap & HOST_CAP_PMP) && !(cap & HOST_CAP_FBS))
+		hpriv->flags |= AHCI_HFLAG_YES_FBS;
+
 	for_each_set_bit(i, &port_map, AHCI_MAX_PORTS) {
 		if (!dev_mp && hpriv->saved_port_cap[i] & PORT_CMD_MPSP) {
 			dev_warn(&dpriv->pdev->dev, "MPS incapable port %d\n", i);
@@ -236,6 +261,10 @@ static void ahci_dwc_init_timer(struct ahci_host_priv *hpriv)
 	if (!(cap & HOST_CAP_CCC) && !(cap2 & HOST_CAP2_SDS))
 		return;
 
+	/* Keep the pre-initialized tick if the clock can't be pinned down */
+	dpriv->timv = readl(hpriv->mmio + AHCI_DWC_HOST_TIMER1MS);
+	dpriv->timv = FIELD_GET(AHCI_DWC_HOST_TIMV_MASK, dpriv->timv);
+
 	/*
 	 * Tick is generated based on the AXI/AHB application clocks signal
 	 * so we need to be sure in the clock we are going to use.
@@ -245,8 +274,6 @@ static void ahci_dwc_init_timer(struct ahci_host_priv *hpriv)
 		return;
 
 	/* 1ms timer interval is set as TIMV = AMBA_FREQ[MHZ] * 1000 */
-	dpriv->timv = readl(hpriv->mmio + AHCI_DWC_HOST_TIMER1MS);
-	dpriv->timv = FIELD_GET(AHCI_DWC_HOST_TIMV_MASK, dpriv->timv);
 	rate = clk_get_rate(aclk) / 1000UL;
 	if (rate == dpriv->timv)
 		return;
@@ -302,6 +329,115 @@ static int ahci_dwc_init_dmacr(struct ahci_host_priv *hpriv)
 	return 0;
 }
 
+static irqreturn_t ahci_dwc_irq_intr(int irq, void *dev_instance)
+{
+	struct ata_host *host = dev_instance;
+	struct ahci_host_priv *hpriv = host->private_data;
+	struct ahci_dwc_host_priv *dpriv = hpriv->plat_data;
+	void __iomem *mmio = hpriv->mmio;
+	u32 irq_stat, irq_masked;
+	unsigned int rc;
+
+	irq_stat = readl(mmio + HOST_IRQ_STAT);
+	if (!irq_stat)
+		return IRQ_NONE;
+
+	irq_masked = irq_stat & hpriv->port_map;
+
+	/*
+	 * The coalesced completions of the CCC ports are signalled by the
+	 * dedicated CCC interrupt bit instead of the per-port IS.IPS bits.
+	 */
+	if (irq_stat & dpriv->ccc_irq_mask)
+		irq_masked |= dpriv->ccc_ports;
+
+	spin_lock(&host->lock);
+
+	rc = ahci_handle_port_intr(host, irq_masked);
+
+	/* HOST_IRQ_STAT is level latched, clear it after the port events */
+	writel(irq_stat, mmio + HOST_IRQ_STAT);
+
+	spin_unlock(&host->lock);
+
+	return IRQ_RETVAL(rc);
+}
+
+static void ahci_dwc_init_ccc(struct ahci_host_priv *hpriv)
+{
+	struct ahci_dwc_host_priv *dpriv = hpriv->plat_data;
+	struct device *dev = &dpriv->pdev->dev;
+	u32 tv, cc;
+
+	/*
+	 * Command Completion Coalescing is only worth it with a properly
+	 * calibrated 1ms tick, which is what the CCC timeout is counted in.
+	 */
+	if (!(readl(hpriv->mmio + HOST_CAP) & HOST_CAP_CCC) || !dpriv->timv)
+		return;
+
+	if (of_property_read_u32(dev->of_node, "snps,ccc-completions", &cc) ||
+	    of_property_read_u32(dev->of_node, "snps,ccc-timeout-ms", &tv))
+		return;
+
+	if (!cc || cc > FIELD_MAX(AHCI_DWC_CCC_CC_MASK) ||
+	    !tv || tv > FIELD_MAX(AHCI_DWC_CCC_TV_MASK)) {
+		dev_warn(dev, "Invalid CCC setup %u cmds/%u ms\n", cc, tv);
+		return;
+	}
+
+	dpriv->ccc_ctl = FIELD_PREP(AHCI_DWC_CCC_TV_MASK, tv) |
+			 FIELD_PREP(AHCI_DWC_CCC_CC_MASK, cc);
+
+	/* The default single level IRQ handler isn't aware of the CCC bit */
+	hpriv->irq_handler = ahci_dwc_irq_intr;
+}
+
+static void ahci_dwc_enable_ccc(struct ata_host *host)
+{
+	struct ahci_host_priv *hpriv = host->private_data;
+	struct ahci_dwc_host_priv *dpriv = hpriv->plat_data;
+	struct ahci_port_priv *pp;
+	struct ata_port *ap;
+	unsigned long flags;
+	u32 ccc_ctl;
+	int i;
+
+	if (!dpriv->ccc_ctl)
+		return;
+
+	/* The CCC parameters may only be changed while CCC is disabled */
+	writel(0, hpriv->mmio + HOST_CCC_CTL);
+
+	dpriv->ccc_ports = hpriv->port_map;
+	writel(dpriv->ccc_ports, hpriv->mmio + HOST_CCC_PORTS);
+	writel(dpriv->ccc_ctl, hpriv->mmio + HOST_CCC_CTL);
+
+	ccc_ctl = readl(hpriv->mmio + HOST_CCC_CTL);
+	dpriv->ccc_irq_mask = BIT(FIELD_GET(AHCI_DWC_CCC_INT_MASK, ccc_ctl));
+
+	writel(ccc_ctl | AHCI_DWC_CCC_EN, hpriv->mmio + HOST_CCC_CTL);
+
+	/*
+	 * Completions on the CCC ports must only be signalled through the
+	 * CCC interrupt, otherwise every command still raises its own port
+	 * IRQ. The error interrupts are left alone.
+	 */
+	for (i = 0; i < host->n_ports; i++) {
+		ap = host->ports[i];
+		pp = ap->private_data;
+		if (!(dpriv->ccc_ports & BIT(ap->port_no)) || !pp)
+			continue;
+
+		spin_lock_irqsave(ap->lock, flags);
+		pp->intr_mask &= ~AHCI_DWC_CCC_PORT_IRQ_MASK;
+		/* A frozen port gets pp->intr_mask restored on thaw */
+		if (!ata_port_is_frozen(ap))
+			writel(pp->intr_mask, ahci_port_base(ap) + PORT_IRQ_MASK);
+		spin_unlock_irqrestore(ap->lock, flags);
+	}
+}
+
 static int ahci_dwc_init_host(struct ahci_host_priv *hpriv)
 {
 	struct ahci_dwc_host_priv *dpriv = hpriv->plat_data;
@@ -321,6 +457,8 @@ static int ahci_dwc_init_host(struct ahci_host_priv *hpriv)
 
 	ahci_dwc_init_timer(hpriv);
 
+	ahci_dwc_init_ccc(hpriv);
+
 	rc = ahci_dwc_init_dmacr(hpriv);
 	if (rc)
 		goto err_clear_platform;
@@ -420,6 +558,8 @@ static int ahci_dwc_probe(struct platform_device *pdev)
 	if (rc)
 		goto err_clear_host;
 
+	ahci_dwc_enable_ccc(platform_get_drvdata(pdev));
+
 	return 0;
 
 err_clear_host:
@@ -453,7 +593,13 @@ static int ahci_dwc_resume(struct device *dev)
 	if (rc)
 		return rc;
 
-	return ahci_platform_resume_host(dev);
+	rc = ahci_platform_resume_host(dev);
+	if (rc)
+		return rc;
+
+	ahci_dwc_enable_ccc(host);
+
+	return 0;
 }
 
 static DEFINE_SIMPLE_DEV_PM_OPS(ahci_dwc_pm_ops, ahci_dwc_suspend,
@@ -98,6 +98,9 @@ struct driver_private {
  *	the device; typically because it depends on another driver getting
  *	probed first.
  * @async_driver - pointer to device driver awaiting probe via async_probe
+ * @probe_defers - number of probe attempts which returned -EPROBE_DEFER
+ * @probe_time - time spent in probe attempts, deferred ones included
+ * @probe_bound - time since boot at which the last successful probe ended
  * @device - pointer back to the struct device that this structure is
  * associated with.
  * @dead - This device is currently either in the process of or has been
@@ -115,6 +118,9 @@ struct device_private {
 	struct list_head deferred_probe;
 	const struct device_driver *async_driver;
 	char *deferred_probe_reason;
+	unsigned int probe_defers;
+	ktime_t probe_time;
+	ktime_t probe_bound;
 	struct device *device;
 	u8 dead:1;
 };
@@ -256,6 +256,37 @@ static int deferred_devs_show(struct seq_file *s, void *data)
 }
 DEFINE_SHOW_ATTRIBUTE(deferred_devs);
 
+/*
+ * probe_times_show() - Show the probe timeline of every device a driver was
+ * tried on: the bound driver, the number of deferrals, the time spent in
+ * probe and when the device got bound, in microseconds since boot.
+ */
+static int probe_times_show(struct seq_file *s, void *data)
+{
+	struct kobject *kobj;
+
+	seq_puts(s, "device\tdriver\tdefers\tprobe_us\tbound_us\n");
+
+	spin_lock(&devices_kset->list_lock);
+	list_for_each_entry(kobj, &devices_kset->list, entry) {
+		struct device *dev = kobj_to_dev(kobj);
+		struct device_private *p = dev->p;
+		const struct device_driver *drv = READ_ONCE(dev->driver);
+
+		if (!p->probe_time)
+			continue;
+
+		seq_printf(s, "%s\t%s\t%u\t%lld\t%lld\n", dev_name(dev),
+			   drv ? drv->name : "-", p->probe_defers,
+			   ktime_to_us(p->probe_time),
+			   ktime_to_us(p->probe_bound));
+	}
+	spin_unlock(&devices_kset->list_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(probe_times);
+
 #ifdef CONFIG_MODULES
 static int driver_deferred_probe_timeout = 10;
 #else
@@ -345,6 +376,8 @@ static int deferred_probe_initcall(void)
 {
 	debugfs_create_file("devices_deferred", 0444, NULL, NULL,
 			    &deferred_devs_fops);
+	debugfs_create_file("devices_probe_times", 0444, NULL, NULL,
+			    &probe_times_fops);
 
 	driver_deferred_probe_enable = true;
 	driver_deferred_probe_trigger();
@@ -377,6 +410,7 @@ late_initcall(deferred_probe_initcall);
 static void __exit deferred_probe_exit(void)
 {
 	debugfs_lookup_and_remove("devices_deferred", NULL);
+	debugfs_lookup_and_remove("devices_probe_times", NULL);
 }
 __exitcall(deferred_probe_exit);
 
@@ -777,6 +811,7 @@ EXPORT_SYMBOL_GPL(wait_for_device_probe);
 
 static int __driver_probe_device(const struct device_driver *drv, struct device *dev)
 {
+	ktime_t start, end;
 	int ret = 0;
 
 	if (dev->p->dead || !device_is_registered(dev))
@@ -793,12 +828,20 @@ static int __driver_probe_device(const struct device_driver *drv, struct device
 		pm_runtime_get_sync(dev->parent);
 
 	pm_runtime_barrier(dev);
+	start = ktime_get();
 	if (initcall_debug)
 		ret = really_probe_debug(dev, drv);
 	else
 		ret = really_probe(dev, drv);
+	end = ktime_get();
 	pm_request_idle(dev);
 
+	dev->p->probe_time = ktime_add(dev->p->probe_time, ktime_sub(end, start));
+	if (ret == -EPROBE_DEFER)
+		dev->p->probe_defers++;
+	else if (!ret)
+		dev->p->probe_bound = end;
+
 	if (dev->parent)
 		pm_runtime_put(dev->parent);
 
@@ -101,7 +101,7 @@ static void rk_rng_cleanup(struct hwrng *rng)
 static int rk_rng_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 {
 	struct rk_rng *rk_rng = container_of(rng, struct rk_rng, rng);
-	size_t to_read = min_t(size_t, max, RK_RNG_MAX_BYTE);
+	size_t done = 0, to_read;
 	u32 reg;
 	int ret = 0;
 
@@ -109,23 +109,36 @@ static int rk_rng_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 	if (ret < 0)
 		return ret;
 
-	/* Start collecting random data */
-	rk_rng_write_ctl(rk_rng, TRNG_RNG_CTL_START, TRNG_RNG_CTL_START);
-
-	ret = readl_poll_timeout(rk_rng->base + TRNG_RNG_CTL, reg,
-				 !(reg & TRNG_RNG_CTL_START),
-				 RK_RNG_POLL_PERIOD_US,
-				 RK_RNG_POLL_TIMEOUT_US);
-	if (ret < 0)
-		goto out;
+	/*
+	 * The TRNG produces 256 bits per run; when the caller is willing to
+	 * wait, collect back-to-back runs until the buffer is full rather
+	 * than handing out a single block per call.
+	 */
+	while (done < max) {
+		to_read = min_t(size_t, max - done, RK_RNG_MAX_BYTE);
+
+		/* Start collecting random data */
+		rk_rng_write_ctl(rk_rng, TRNG_RNG_CTL_START, TRNG_RNG_CTL_START);
+
+		ret = readl_poll_timeout(rk_rng->base + TRNG_RNG_CTL, reg,
+					 !(reg & TRNG_RNG_CTL_START),
+					 RK_RNG_POLL_PERIOD_US,
+					 RK_RNG_POLL_TIMEOUT_US);
+		if (ret < 0)
+			break;
+
+		/* Read random data stored in the registers */
+		memcpy_fromio(buf + done, rk_rng->base + TRNG_RNG_DOUT, to_read);
+		done += to_read;
+
+		if (!wait)
+			break;
+	}
 
-	/* Read random data stored in the registers */
-	memcpy_fromio(buf, rk_rng->base + TRNG_RNG_DOUT, to_read);
-out:
 	pm_runtime_mark_last_busy((struct device *) rk_rng->rng.priv);
 	pm_runtime_put_sync_autosuspend((struct device *) rk_rng->rng.priv);
 
-	return (ret < 0) ? ret : to_read;
+	return done ? done : ret;
 }
 
 static int rk_rng_probe(struct platform_device *pdev)
@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip CPUFreq nvmem based driver
+ *
+ * The rockchip-cpufreq-nvmem driver reads the speed bin of the SoC from its
+ * OTP and restricts the CPU OPP table to the operating points, including
+ * boost ones, that the part has been qualified for, before handing over to
+ * cpufreq-dt.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/cpu.h>
+#include <linux/module.h>
+#include <linux/nvmem-consumer.h>
+#include <linux/of.h>
+#include <linux/platform_device.h>
+#include <linux/pm_opp.h>
+#include <linux/slab.h>
+
+static struct platform_device *cpufreq_dt_pdev, *rockchip_cpufreq_pdev;
+
+/*
+ * The bin is only relevant if the OPP table tells which operating points
+ * depend on it; otherwise the OPP core would reject every entry.
+ */
+static bool dt_has_supported_hw(struct device *cpu_dev)
+{
+	struct device_node *np __free(device_node) =
+		dev_pm_opp_of_get_opp_desc_node(cpu_dev);
+
+	if (!np)
+		return false;
+
+	for_each_child_of_node_scoped(np, opp) {
+		if (of_property_present(opp, "opp-supported-hw"))
+			return true;
+	}
+
+	return false;
+}
+
+static int rockchip_cpufreq_read_speedbin(struct device *cpu_dev, u32 *bin)
+{
+	int ret;
+
+	ret = nvmem_cell_read_variable_le_u32(cpu_dev, "speed-bin", bin);
+	if (ret == -ENOENT || ret == -EOPNOTSUPP) {
+		/* No speed-bin cell: treat the part as the slowest bin. */
+		*bin = 0;
+		return 0;
+	}
+	if (ret)
+		return dev_err_probe(cpu_dev, ret,
+				     "Cannot read speed-bin\n");
+
+	if (*bin >= 32) {
+		dev_warn(cpu_dev, "Unexpected speed-bin %u, using 0\n", *bin);
+		*bin = 0;
+	}
+
+	return 0;
+}
+
+static int rockchip_cpufreq_nvmem_probe(struct platform_device *pdev)
+{
+	struct dev_pm_opp_config config = {};
+	struct device *cpu_dev;
+	unsigned int cpu;
+	u32 supported_hw, bin;
+	int *opp_tokens;
+	int ret;
+
+	cpu_dev = get_cpu_device(0);
+	if (!cpu_dev)
+		return -ENODEV;
+
+	ret = rockchip_cpufreq_read_speedbin(cpu_dev, &bin);
+	if (ret)
+		return ret;
+
+	opp_tokens = kcalloc(num_possible_cpus(), sizeof(*opp_tokens),
+			     GFP_KERNEL);
+	if (!opp_tokens)
+		return -ENOMEM;
+
+	if (dt_has_supported_hw(cpu_dev)) {
+		supported_hw = BIT(bin);
+		config.supported_hw = &supported_hw;
+		config.supported_hw_count = 1;
+	}
+
+	dev_dbg(&pdev->dev, "Using speed-bin %u\n", bin);
+
+	for_each_possible_cpu(cpu) {
+		cpu_dev = get_cpu_device(cpu);
+		if (!cpu_dev) {
+			ret = -ENODEV;
+			goto free_opp;
+		}
+
+		ret = dev_pm_opp_set_config(cpu_dev, &config);
+		if (ret < 0)
+			goto free_opp;
+
+		opp_tokens[cpu] = ret;
+	}
+
+	cpufreq_dt_pdev = platform_device_register_simple("cpufreq-dt", -1,
+							  NULL, 0);
+	if (!IS_ERR(cpufreq_dt_pdev)) {
+		platform_set_drvdata(pdev, opp_tokens);
+		return 0;
+	}
+
+	ret = PTR_ERR(cpufreq_dt_pdev);
+	pr_err("Failed to register platform device\n");
+
+free_opp:
+	for_each_possible_cpu(cpu)
+		dev_pm_opp_clear_config(opp_tokens[cpu]);
+	kfree(opp_tokens);
+
+	return ret;
+}
+
+static void rockchip_cpufreq_nvmem_remove(struct platform_device *pdev)
+{
+	int *opp_tokens = platform_get_drvdata(pdev);
+	unsigned int cpu;
+
+	platform_device_unregister(cpufreq_dt_pdev);
+
+	for_each_possible_cpu(cpu)
+		dev_pm_opp_clear_config(opp_tokens[cpu]);
+
+	kfree(opp_tokens);
+}
+
+static struct platform_driver rockchip_cpufreq_driver = {
+	.probe = rockchip_cpufreq_nvmem_probe,
+	.remove_new = rockchip_cpufreq_nvmem_remove,
+	.driver = {
+		.name = "rockchip-cpufreq-nvmem",
+	},
+};
+
+static const struct of_device_id rockchip_cpufreq_match_list[] = {
+	{ .compatible = "rockchip,rk3566" },
+	{ .compatible = "rockchip,rk3568" },
+	{}
+};
+MODULE_DEVICE_TABLE(of, rockchip_cpufreq_match_list);
+
+static const struct of_device_id *rockchip_cpufreq_match_node(void)
+{
+	struct device_node *np __free(device_node) = of_find_node_by_path("/");
+
+	return of_match_node(rockchip_cpufreq_match_list, np);
+}
+
+/*
+ * Since the driver depends on nvmem drivers, which may return EPROBE_DEFER,
+ * all the real activity is done in the probe, which may be defered as well.
+ * The init here is only registering the driver and the platform device.
+ */
+static int __init rockchip_cpufreq_init(void)
+{
+	int ret;
+
+	if (!rockchip_cpufreq_match_node())
+		return -ENODEV;
+
+	ret = platform_driver_register(&rockchip_cpufreq_driver);
+	if (unlikely(ret < 0))
+		return ret;
+
+	rockchip_cpufreq_pdev =
+		platform_device_register_simple("rockchip-cpufreq-nvmem",
+						-1, NULL, 0);
+	ret = PTR_ERR_OR_ZERO(rockchip_cpufreq_pdev);
+	if (ret == 0)
+		return 0;
+
+	platform_driver_unregister(&rockchip_cpufreq_driver);
+	return ret;
+}
+module_init(rockchip_cpufreq_init);
+
+static void __exit rockchip_cpufreq_exit(void)
+{
+	platform_device_unregister(rockchip_cpufreq_pdev);
+	platform_driver_unregister(&rockchip_cpufreq_driver);
+}
+module_exit(rockchip_cpufreq_exit);
+
+MODULE_DESCRIPTION("Rockchip nvmem based cpufreq driver");
+MODULE_LICENSE("GPL");
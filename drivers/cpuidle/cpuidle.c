@@ -38,6 +38,7 @@ LIST_HEAD(cpuidle_detected_devices);
 
 static int enabled_devices;
 static int off __read_mostly;
+static bool measure_latency __read_mostly;
 static int initialized __read_mostly;
 
 int cpuidle_disabled(void)
@@ -202,6 +203,31 @@ int cpuidle_enter_s2idle(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 }
 #endif /* CONFIG_SUSPEND */
 
+/* Timer wakeups later than this are assumed to have a different cause */
+#define CPUIDLE_LATENCY_SAMPLE_MAX_NS	(10 * NSEC_PER_MSEC)
+
+/*
+ * When the CPU was woken up by the timer it programmed before going idle, the
+ * time elapsed since that timer expired is how long the idle state took to
+ * exit, including the firmware and the broadcast timer if one was involved.
+ */
+static void cpuidle_update_exit_latency(struct cpuidle_state_usage *usage,
+					ktime_t next_event, ktime_t wakeup)
+{
+	s64 lat = ktime_sub(wakeup, next_event);
+
+	if (!next_event || lat < 0 || lat > CPUIDLE_LATENCY_SAMPLE_MAX_NS)
+		return;
+
+	if (usage->exit_latency_ns)
+		usage->exit_latency_ns += (lat - (s64)usage->exit_latency_ns) / 8;
+	else
+		usage->exit_latency_ns = lat;
+
+	if (lat > usage->exit_latency_max_ns)
+		usage->exit_latency_max_ns = lat;
+}
+
 /**
  * cpuidle_enter_state - enter the state and update stats
  * @dev: cpuidle device for this cpu
@@ -216,7 +242,7 @@ noinstr int cpuidle_enter_state(struct cpuidle_device *dev,
 
 	struct cpuidle_state *target_state = &drv->states[index];
 	bool broadcast = !!(target_state->flags & CPUIDLE_FLAG_TIMER_STOP);
-	ktime_t time_start, time_end;
+	ktime_t time_start, time_end, wakeup = 0;
 
 	instrumentation_begin();
 
@@ -274,6 +300,8 @@ noinstr int cpuidle_enter_state(struct cpuidle_device *dev,
 
 	sched_clock_idle_wakeup_event();
 	time_end = ns_to_ktime(local_clock_noinstr());
+	if (measure_latency)
+		wakeup = ktime_get();
 	trace_cpu_idle(PWR_EVENT_EXIT, dev->cpu);
 
 	/* The cpu is no longer idle or about to enter idle. */
@@ -300,6 +328,11 @@ noinstr int cpuidle_enter_state(struct cpuidle_device *dev,
 		dev->states_usage[entered_state].time_ns += diff;
 		dev->states_usage[entered_state].usage++;
 
+		if (wakeup)
+			cpuidle_update_exit_latency(&dev->states_usage[entered_state],
+						    READ_ONCE(dev->next_hrtimer),
+						    wakeup);
+
 		if (diff < drv->states[entered_state].target_residency_ns) {
 			for (i = entered_state - 1; i >= 0; i--) {
 				if (dev->states_usage[i].disable)
@@ -809,5 +842,6 @@ static int __init cpuidle_init(void)
 }
 
 module_param(off, int, 0444);
+module_param(measure_latency, bool, 0644);
 module_param_string(governor, param_governor, CPUIDLE_NAME_LEN, 0444);
 core_initcall(cpuidle_init);
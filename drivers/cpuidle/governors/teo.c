@@ -100,6 +100,7 @@
 #include <linux/cpuidle.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
+#include <linux/moduleparam.h>
 #include <linux/sched/clock.h>
 #include <linux/tick.h>
 
@@ -112,6 +113,13 @@
 #define PULSE		1024
 #define DECAY_SHIFT	3
 
+/*
+ * Use the exit latencies measured by the cpuidle core (cpuidle.measure_latency)
+ * instead of the firmware provided ones, which are often rough guesses.
+ */
+static bool measured_latency __read_mostly;
+module_param(measured_latency, bool, 0644);
+
 /**
  * struct teo_bin - Metrics used by the TEO cpuidle governor.
  * @intercepts: The "intercepts" metric.
@@ -140,6 +148,16 @@ struct teo_cpu {
 
 static DEFINE_PER_CPU(struct teo_cpu, teo_cpus);
 
+/* Latency constraints are worst case, so use the worst measured exit latency */
+static u64 teo_exit_latency_ns(struct cpuidle_driver *drv,
+			       struct cpuidle_device *dev, int i)
+{
+	if (measured_latency && dev->states_usage[i].exit_latency_max_ns)
+		return dev->states_usage[i].exit_latency_max_ns;
+
+	return drv->states[i].exit_latency_ns;
+}
+
 /**
  * teo_update - Update CPU metrics after wakeup.
  * @drv: cpuidle driver containing state data.
@@ -160,6 +178,7 @@ static void teo_update(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 		 */
 		measured_ns = U64_MAX;
 	} else {
+		struct cpuidle_state_usage *usage = &dev->states_usage[dev->last_state_idx];
 		u64 lat_ns = drv->states[dev->last_state_idx].exit_latency_ns;
 
 		/*
@@ -174,9 +193,12 @@ static void teo_update(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 		 * The delay between the wakeup and the first instruction
 		 * executed by the CPU is not likely to be worst-case every
 		 * time, so take 1/2 of the exit latency as a very rough
-		 * approximation of the average of it.
+		 * approximation of the average of it, unless the actual
+		 * average has been measured.
 		 */
-		if (measured_ns >= lat_ns)
+		if (measured_latency && usage->exit_latency_ns)
+			measured_ns -= min(measured_ns, usage->exit_latency_ns);
+		else if (measured_ns >= lat_ns)
 			measured_ns -= lat_ns / 2;
 		else
 			measured_ns /= 2;
@@ -320,7 +342,6 @@ static int teo_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 	/* Compute the sums of metrics for early wakeup pattern detection. */
 	for (i = 1; i < drv->state_count; i++) {
 		struct teo_bin *prev_bin = &cpu_data->state_bins[i-1];
-		struct cpuidle_state *s = &drv->states[i];
 
 		/*
 		 * Update the sums of idle state mertics for all of the states
@@ -337,7 +358,7 @@ static int teo_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 
 		idx = i;
 
-		if (s->exit_latency_ns <= latency_req)
+		if (teo_exit_latency_ns(drv, dev, i) <= latency_req)
 			constraint_idx = i;
 
 		/* Save the sums for the current state. */
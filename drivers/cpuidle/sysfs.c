@@ -276,6 +276,44 @@ static ssize_t show_state_time(struct cpuidle_state *state,
 	return sprintf(buf, "%llu\n", ktime_to_us(state_usage->time_ns));
 }
 
+static ssize_t show_state_measured_latency(struct cpuidle_state *state,
+					   struct cpuidle_state_usage *state_usage,
+					   char *buf)
+{
+	return sprintf(buf, "%llu\n", ktime_to_us(state_usage->exit_latency_ns));
+}
+
+static ssize_t show_state_measured_latency_max(struct cpuidle_state *state,
+					       struct cpuidle_state_usage *state_usage,
+					       char *buf)
+{
+	return sprintf(buf, "%llu\n",
+		       ktime_to_us(state_usage->exit_latency_max_ns));
+}
+
+/* Writing 0 restarts the worst case from the next measured exit */
+static ssize_t store_state_measured_latency_max(struct cpuidle_state *state,
+						struct cpuidle_state_usage *state_usage,
+						const char *buf, size_t size)
+{
+	unsigned int value;
+	int err;
+
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	err = kstrtouint(buf, 0, &value);
+	if (err)
+		return err;
+
+	if (value)
+		return -EINVAL;
+
+	WRITE_ONCE(state_usage->exit_latency_max_ns, 0);
+
+	return size;
+}
+
 static ssize_t show_state_disable(struct cpuidle_state *state,
 				  struct cpuidle_state_usage *state_usage,
 				  char *buf)
@@ -322,6 +360,9 @@ define_one_state_ro(power, show_state_power_usage);
 define_one_state_ro(usage, show_state_usage);
 define_one_state_ro(rejected, show_state_rejected);
 define_one_state_ro(time, show_state_time);
+define_one_state_ro(measured_latency, show_state_measured_latency);
+define_one_state_rw(measured_latency_max, show_state_measured_latency_max,
+		    store_state_measured_latency_max);
 define_one_state_rw(disable, show_state_disable, store_state_disable);
 define_one_state_ro(above, show_state_above);
 define_one_state_ro(below, show_state_below);
@@ -336,6 +377,8 @@ static struct attribute *cpuidle_state_default_attrs[] = {
 	&attr_usage.attr,
 	&attr_rejected.attr,
 	&attr_time.attr,
+	&attr_measured_latency.attr,
+	&attr_measured_latency_max.attr,
 	&attr_disable.attr,
 	&attr_above.attr,
 	&attr_below.attr,
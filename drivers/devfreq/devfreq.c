@@ -445,6 +445,24 @@ int update_devfreq(struct devfreq *devfreq)
 }
 EXPORT_SYMBOL(update_devfreq);
 
+/*
+ * Polling expires on multiples of the polling interval, so devices polling at
+ * the same interval, or at multiples of each other's, are sampled from the same
+ * timer tick instead of each waking the system up in its own time.
+ */
+static unsigned long devfreq_polling_delay(struct devfreq *devfreq)
+{
+	unsigned int polling_ms = READ_ONCE(devfreq->profile->polling_ms);
+	unsigned long period = msecs_to_jiffies(polling_ms);
+	unsigned long now = jiffies;
+
+	/* Polling is being turned off, there is no period to align to */
+	if (!period)
+		return 0;
+
+	return roundup(now + 1, period) - now;
+}
+
 /**
  * devfreq_monitor() - Periodically poll devfreq objects.
  * @work:	the work struct used to run devfreq_monitor periodically.
@@ -461,11 +479,11 @@ static void devfreq_monitor(struct work_struct *work)
 	if (err)
 		dev_err(&devfreq->dev, "dvfs failed with (%d) error\n", err);
 
-	if (devfreq->stop_polling)
+	if (devfreq->stop_polling || !devfreq->profile->polling_ms)
 		goto out;
 
 	queue_delayed_work(devfreq_wq, &devfreq->work,
-				msecs_to_jiffies(devfreq->profile->polling_ms));
+			   devfreq_polling_delay(devfreq));
 
 out:
 	mutex_unlock(&devfreq->lock);
@@ -504,7 +522,7 @@ void devfreq_monitor_start(struct devfreq *devfreq)
 
 	if (devfreq->profile->polling_ms)
 		queue_delayed_work(devfreq_wq, &devfreq->work,
-			msecs_to_jiffies(devfreq->profile->polling_ms));
+				   devfreq_polling_delay(devfreq));
 
 out:
 	devfreq->stop_polling = false;
@@ -591,7 +609,7 @@ void devfreq_monitor_resume(struct devfreq *devfreq)
 	if (!delayed_work_pending(&devfreq->work) &&
 			devfreq->profile->polling_ms)
 		queue_delayed_work(devfreq_wq, &devfreq->work,
-			msecs_to_jiffies(devfreq->profile->polling_ms));
+				   devfreq_polling_delay(devfreq));
 
 out_update:
 	devfreq->stats.last_update = get_jiffies_64();
@@ -638,7 +656,7 @@ void devfreq_update_interval(struct devfreq *devfreq, unsigned int *delay)
 	/* if current delay is zero, start polling with new delay */
 	if (!cur_delay) {
 		queue_delayed_work(devfreq_wq, &devfreq->work,
-			msecs_to_jiffies(devfreq->profile->polling_ms));
+				   devfreq_polling_delay(devfreq));
 		goto out;
 	}
 
@@ -649,7 +667,7 @@ void devfreq_update_interval(struct devfreq *devfreq, unsigned int *delay)
 		mutex_lock(&devfreq->lock);
 		if (!devfreq->stop_polling)
 			queue_delayed_work(devfreq_wq, &devfreq->work,
-				msecs_to_jiffies(devfreq->profile->polling_ms));
+					   devfreq_polling_delay(devfreq));
 	}
 out:
 	mutex_unlock(&devfreq->lock);
@@ -414,6 +414,21 @@ static int rockchip_ddr_perf_event_init(struct perf_event *event)
 		return -EINVAL;
 	}
 
+	if (event->attr.config >= PERF_ACCESS_TYPE_MAX)
+		return -EINVAL;
+
+	/* the counters are read on demand, don't mix them with other PMUs */
+	if (event->group_leader->pmu != event->pmu &&
+	    !is_software_event(event->group_leader))
+		return -EINVAL;
+
+	/*
+	 * The DFI counts for the whole system: let all events be handled on
+	 * the CPU advertised in the cpumask, which is also the one the
+	 * hrtimer accumulating the 32 bit hardware counters runs on.
+	 */
+	event->cpu = dfi->cpu;
+
 	return 0;
 }
 
@@ -602,7 +617,7 @@ static int rockchip_ddr_perf_init(struct rockchip_dfi *dfi)
 	seqlock_init(&dfi->count_seqlock);
 
 	pmu->module = THIS_MODULE;
-	pmu->capabilities = PERF_PMU_CAP_NO_EXCLUDE;
+	pmu->capabilities = PERF_PMU_CAP_NO_EXCLUDE | PERF_PMU_CAP_NO_INTERRUPT;
 	pmu->task_ctx_nr = perf_invalid_context;
 	pmu->attr_groups = attr_groups;
 	pmu->event_init  = rockchip_ddr_perf_event_init;
@@ -37,6 +37,19 @@
 
 #define RK3399_SET_ODT_PD_2_ODT_ENABLE			BIT(0)
 
+/**
+ * struct rk3399_dmcfreq_soc_data - SoC specific DMC data
+ * @sip_dram: the DRAM DVFS support of TF-A has to be initialized through
+ *	      the SIP interface, and the ODT/power-down timings can be
+ *	      programmed through it. Without it, rate changes go through
+ *	      dmc_clk only. There is no kernel driver for that clock: the
+ *	      device tree has to point it at the DDR clock of the firmware,
+ *	      e.g. the one of the TF-A SCMI clock protocol on RK3568.
+ */
+struct rk3399_dmcfreq_soc_data {
+	bool sip_dram;
+};
+
 struct rk3399_dmcfreq {
 	struct device *dev;
 	struct devfreq *devfreq;
@@ -336,12 +349,17 @@ static int rk3399_dmcfreq_probe(struct platform_device *pdev)
 	struct arm_smccc_res res;
 	struct device *dev = &pdev->dev;
 	struct device_node *np = pdev->dev.of_node, *node;
+	const struct rk3399_dmcfreq_soc_data *soc_data;
 	struct rk3399_dmcfreq *data;
 	int ret;
 	struct dev_pm_opp *opp;
 	u32 ddr_type;
 	u32 val;
 
+	soc_data = of_device_get_match_data(dev);
+	if (!soc_data)
+		return -ENODEV;
+
 	data = devm_kzalloc(dev, sizeof(struct rk3399_dmcfreq), GFP_KERNEL);
 	if (!data)
 		return -ENOMEM;
@@ -358,6 +376,11 @@ static int rk3399_dmcfreq_probe(struct platform_device *pdev)
 		return dev_err_probe(dev, PTR_ERR(data->dmc_clk),
 				     "Cannot get the clk dmc_clk\n");
 
+	/* Firmware without DRAM DVFS doesn't report a rate either */
+	if (!soc_data->sip_dram && !clk_get_rate(data->dmc_clk))
+		return dev_err_probe(dev, -ENODEV,
+				     "dmc_clk has no rate, no DRAM DVFS in the firmware?\n");
+
 	data->edev = devfreq_event_get_edev_by_phandle(dev, "devfreq-events", 0);
 	if (IS_ERR(data->edev))
 		return -EPROBE_DEFER;
@@ -370,6 +393,9 @@ static int rk3399_dmcfreq_probe(struct platform_device *pdev)
 
 	rk3399_dmcfreq_of_props(data, np);
 
+	if (!soc_data->sip_dram)
+		goto no_sip;
+
 	node = of_parse_phandle(np, "rockchip,pmu", 0);
 	if (!node)
 		goto no_pmu;
@@ -404,6 +430,7 @@ static int rk3399_dmcfreq_probe(struct platform_device *pdev)
 		      ROCKCHIP_SIP_CONFIG_DRAM_INIT,
 		      0, 0, 0, 0, &res);
 
+no_sip:
 	/*
 	 * We add a devfreq driver to our parent since it has a device tree node
 	 * with operating points.
@@ -466,8 +493,17 @@ static void rk3399_dmcfreq_remove(struct platform_device *pdev)
 	devfreq_event_disable_edev(dmcfreq->edev);
 }
 
+static const struct rk3399_dmcfreq_soc_data rk3399_dmcfreq_data = {
+	.sip_dram = true,
+};
+
+static const struct rk3399_dmcfreq_soc_data rk3568_dmcfreq_data = {
+	.sip_dram = false,
+};
+
 static const struct of_device_id rk3399dmc_devfreq_of_match[] = {
-	{ .compatible = "rockchip,rk3399-dmc" },
+	{ .compatible = "rockchip,rk3399-dmc", .data = &rk3399_dmcfreq_data },
+	{ .compatible = "rockchip,rk3568-dmc", .data = &rk3568_dmcfreq_data },
 	{ },
 };
 MODULE_DEVICE_TABLE(of, rk3399dmc_devfreq_of_match);
@@ -485,4 +521,4 @@ module_platform_driver(rk3399_dmcfreq_driver);
 
 MODULE_LICENSE("GPL v2");
 MODULE_AUTHOR("Lin Huang <hl@rock-chips.com>");
-MODULE_DESCRIPTION("RK3399 dmcfreq driver with devfreq framework");
+MODULE_DESCRIPTION("RK3399/RK3568 dmcfreq driver with devfreq framework");
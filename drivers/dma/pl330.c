@@ -26,6 +26,7 @@
 #include <linux/pm_runtime.h>
 #include <linux/bug.h>
 #include <linux/reset.h>
+#include <linux/workqueue.h>
 
 #include "dmaengine.h"
 #define PL330_MAX_CHAN		8
@@ -381,6 +382,8 @@ struct pl330_thread {
 	unsigned lstenq;
 	/* Index of the last submitted request or -1 if the DMA is stopped */
 	int req_running;
+	/* Periods signalled by a looped cyclic request, not yet reported */
+	unsigned int periods_elapsed;
 };
 
 enum pl330_dmac_state {
@@ -390,7 +393,7 @@ enum pl330_dmac_state {
 };
 
 enum desc_status {
-	/* In the DMAC pool */
+	/* In the DMAC pool or in a channel desc_cache */
 	FREE,
 	/*
 	 * Allocated to some channel during prep_xxx
@@ -417,8 +420,8 @@ enum desc_status {
 };
 
 struct dma_pl330_chan {
-	/* Schedule desc completion */
-	struct tasklet_struct task;
+	/* Schedule desc completion, runs on the BH workqueue */
+	struct work_struct task;
 
 	/* DMA-Engine Channel */
 	struct dma_chan chan;
@@ -429,6 +432,11 @@ struct dma_pl330_chan {
 	struct list_head work_list;
 	/* List of completed descriptors */
 	struct list_head completed_list;
+	/*
+	 * Descriptors released by this channel, reused before falling back
+	 * to the DMAC-wide pool so that channels don't contend on pool_lock
+	 */
+	struct list_head desc_cache;
 
 	/* Pointer to the DMAC that manages this channel,
 	 * NULL if the channel is available to be acquired.
@@ -537,6 +545,20 @@ struct dma_pl330_desc {
 	int bytes_requested;
 	bool last;
 
+	/*
+	 * Number of periods of a cyclic transfer looped by the microcode,
+	 * zero if the desc describes a single period or a plain transfer
+	 */
+	unsigned int num_periods;
+
+	/*
+	 * Number of frames of an interleaved transfer, each of px.bytes and
+	 * followed by the given gaps, zero for contiguous transfers
+	 */
+	unsigned int num_frames;
+	u16 src_icg;
+	u16 dst_icg;
+
 	/* The channel which currently holds this desc */
 	struct dma_pl330_chan *pchan;
 
@@ -705,6 +727,23 @@ static inline u32 _emit_LPEND(unsigned dry_run, u8 buf[],
 	return SZ_DMALPEND;
 }
 
+static inline u32 _emit_ADDH(unsigned int dry_run, u8 buf[],
+		enum pl330_dst da, u16 val)
+{
+	if (dry_run)
+		return SZ_DMAADDH;
+
+	buf[0] = CMD_DMAADDH;
+	buf[0] |= (da << 1);
+	buf[1] = val;
+	buf[2] = val >> 8;
+
+	PL330_DBGCMD_DUMP(SZ_DMAADDH, "\tDMAADDH %s %u\n",
+		da == DST ? "DA" : "SA", val);
+
+	return SZ_DMAADDH;
+}
+
 static inline u32 _emit_KILL(unsigned dry_run, u8 buf[])
 {
 	if (dry_run)
@@ -1407,6 +1446,133 @@ static inline int _setup_xfer(struct pl330_dmac *pl330,
 	return off;
 }
 
+/*
+ * One period of a looped cyclic transfer or one frame of an interleaved
+ * transfer. LC1 counts the periods/frames, so only LC0 is left to iterate
+ * over the bursts of a unit.
+ */
+static int _xfer_unit(struct pl330_dmac *pl330, unsigned int dry_run,
+		      u8 buf[], const struct _xfer_spec *pxs)
+{
+	struct pl330_xfer *x = &pxs->desc->px;
+	u32 ccr = pxs->ccr;
+	unsigned long bursts = BYTE_TO_BURST(x->bytes, ccr);
+	int num_dregs = (x->bytes - BURST_TO_BYTE(bursts, ccr)) /
+		BRST_SIZE(ccr);
+	unsigned int lcnt = 0, cyc = 0;
+	struct _arg_LPEND lpend;
+	int off = 0, ljmp;
+
+	/* The dregs of the previous unit have modified the CCR */
+	if (num_dregs)
+		off += _emit_MOV(dry_run, &buf[off], CCR, ccr);
+
+	if (bursts) {
+		cyc = DIV_ROUND_UP(bursts, 256);
+		lcnt = bursts / cyc;
+	}
+
+	if (lcnt > 1) {
+		off += _emit_LP(dry_run, &buf[off], 0, lcnt);
+		ljmp = off;
+
+		off += _bursts(pl330, dry_run, &buf[off], pxs, cyc);
+
+		lpend.cond = ALWAYS;
+		lpend.forever = false;
+		lpend.loop = 0;
+		lpend.bjump = off - ljmp;
+		off += _emit_LPEND(dry_run, &buf[off], &lpend);
+	} else if (lcnt) {
+		off += _bursts(pl330, dry_run, &buf[off], pxs, cyc);
+	}
+
+	if (bursts > lcnt * cyc)
+		off += _bursts(pl330, dry_run, &buf[off], pxs,
+			       bursts - lcnt * cyc);
+
+	off += _dregs(pl330, dry_run, &buf[off], pxs, num_dregs);
+
+	return off;
+}
+
+/*
+ * Loop over the whole ring forever, signalling the thread's event at
+ * the end of each period instead of completing the request.
+ */
+static int _setup_cyclic(struct pl330_dmac *pl330, unsigned int dry_run,
+			 u8 buf[], struct pl330_thread *thrd,
+			 const struct _xfer_spec *pxs)
+{
+	struct dma_pl330_desc *desc = pxs->desc;
+	struct pl330_xfer *x = &desc->px;
+	struct _arg_LPEND lpend;
+	int off = 0, ljmp1 = 0;
+
+	off += _emit_MOV(dry_run, &buf[off], SAR, x->src_addr);
+	off += _emit_MOV(dry_run, &buf[off], DAR, x->dst_addr);
+
+	if (desc->num_periods > 1) {
+		off += _emit_LP(dry_run, &buf[off], 1, desc->num_periods);
+		ljmp1 = off;
+	}
+
+	off += _xfer_unit(pl330, dry_run, &buf[off], pxs);
+
+	off += _emit_SEV(dry_run, &buf[off], thrd->ev);
+
+	if (desc->num_periods > 1) {
+		lpend.cond = ALWAYS;
+		lpend.forever = false;
+		lpend.loop = 1;
+		lpend.bjump = off - ljmp1;
+		off += _emit_LPEND(dry_run, &buf[off], &lpend);
+	}
+
+	lpend.cond = ALWAYS;
+	lpend.forever = true;
+	lpend.loop = 0;
+	lpend.bjump = off;
+	off += _emit_LPEND(dry_run, &buf[off], &lpend);
+
+	return off;
+}
+
+/* Copy the frames, skipping the inter-chunk gaps after each of them */
+static int _setup_interleaved(struct pl330_dmac *pl330, unsigned int dry_run,
+			      u8 buf[], const struct _xfer_spec *pxs)
+{
+	struct dma_pl330_desc *desc = pxs->desc;
+	struct pl330_xfer *x = &desc->px;
+	struct _arg_LPEND lpend;
+	int off = 0, ljmp1 = 0;
+
+	off += _emit_MOV(dry_run, &buf[off], SAR, x->src_addr);
+	off += _emit_MOV(dry_run, &buf[off], DAR, x->dst_addr);
+
+	if (desc->num_frames > 1) {
+		off += _emit_LP(dry_run, &buf[off], 1, desc->num_frames);
+		ljmp1 = off;
+	}
+
+	off += _xfer_unit(pl330, dry_run, &buf[off], pxs);
+
+	if (desc->src_icg)
+		off += _emit_ADDH(dry_run, &buf[off], SRC, desc->src_icg);
+	if (desc->dst_icg)
+		off += _emit_ADDH(dry_run, &buf[off], DST, desc->dst_icg);
+
+	if (desc->num_frames > 1) {
+		lpend.cond = ALWAYS;
+		lpend.forever = false;
+		lpend.loop = 1;
+		lpend.bjump = off - ljmp1;
+		off += _emit_LPEND(dry_run, &buf[off], &lpend);
+	}
+
+	return off;
+}
+
 /*
  * A req is a sequence of one or more xfer units.
  * Returns the number of bytes taken to setup the MC for the req.
@@ -1424,10 +1590,18 @@ static int _setup_req(struct pl330_dmac *pl330, unsigned dry_run,
 	/* DMAMOV CCR, ccr */
 	off += _emit_MOV(dry_run, &buf[off], CCR, pxs->ccr);
 
-	off += _setup_xfer(pl330, dry_run, &buf[off], pxs);
+	if (pxs->desc->num_periods) {
+		off += _setup_cyclic(pl330, dry_run, &buf[off], thrd, pxs);
+	} else {
+		if (pxs->desc->num_frames)
+			off += _setup_interleaved(pl330, dry_run, &buf[off],
+						  pxs);
+		else
+			off += _setup_xfer(pl330, dry_run, &buf[off], pxs);
 
-	/* DMASEV peripheral/event */
-	off += _emit_SEV(dry_run, &buf[off], thrd->ev);
+		/* DMASEV peripheral/event */
+		off += _emit_SEV(dry_run, &buf[off], thrd->ev);
+	}
 	/* DMAEND */
 	off += _emit_END(dry_run, &buf[off]);
 
@@ -1574,7 +1748,7 @@ static void dma_pl330_rqcb(struct dma_pl330_desc *desc, enum pl330_op_err err)
 
 	spin_unlock_irqrestore(&pch->lock, flags);
 
-	tasklet_schedule(&pch->task);
+	queue_work(system_bh_highpri_wq, &pch->task);
 }
 
 static void pl330_dotask(struct tasklet_struct *t)
@@ -1701,8 +1875,17 @@ static int pl330_update(struct pl330_dmac *pl330)
 			if (active == -1) /* Aborted */
 				continue;
 
-			/* Detach the req */
 			descdone = thrd->req[active].desc;
+
+			/* A looped cyclic req keeps running, just note the period */
+			if (descdone->num_periods) {
+				thrd->periods_elapsed++;
+				queue_work(system_bh_highpri_wq,
+					   &descdone->pchan->task);
+				continue;
+			}
+
+			/* Detach the req */
 			thrd->req[active].desc = NULL;
 
 			thrd->req_running = -1;
@@ -2061,20 +2244,27 @@ static inline void fill_queue(struct dma_pl330_chan *pch)
 			desc->status = DONE;
 			dev_err(pch->dmac->ddma.dev, "%s:%d Bad Desc(%d)\n",
 					__func__, __LINE__, desc->txd.cookie);
-			tasklet_schedule(&pch->task);
+			queue_work(system_bh_highpri_wq, &pch->task);
 		}
 	}
 }
 
-static void pl330_tasklet(struct tasklet_struct *t)
+static void pl330_complete_work(struct work_struct *t)
 {
-	struct dma_pl330_chan *pch = from_tasklet(pch, t, task);
+	struct dma_pl330_chan *pch = from_work(pch, t, task);
 	struct dma_pl330_desc *desc, *_dt;
+	struct dmaengine_desc_callback cb;
+	unsigned int periods;
 	unsigned long flags;
 	bool power_down = false;
 
 	spin_lock_irqsave(&pch->lock, flags);
 
+	spin_lock(&pch->thread->dmac->lock);
+	periods = pch->thread->periods_elapsed;
+	pch->thread->periods_elapsed = 0;
+	spin_unlock(&pch->thread->dmac->lock);
+
 	/* Pick up ripe tomatoes */
 	list_for_each_entry_safe(desc, _dt, &pch->work_list, node)
 		if (desc->status == DONE) {
@@ -2100,8 +2290,6 @@ static void pl330_tasklet(struct tasklet_struct *t)
 	}
 
 	while (!list_empty(&pch->completed_list)) {
-		struct dmaengine_desc_callback cb;
-
 		desc = list_first_entry(&pch->completed_list,
 					struct dma_pl330_desc, node);
 
@@ -2119,7 +2307,7 @@ static void pl330_tasklet(struct tasklet_struct *t)
 			}
 		} else {
 			desc->status = FREE;
-			list_move_tail(&desc->node, &pch->dmac->desc_pool);
+			list_move_tail(&desc->node, &pch->desc_cache);
 		}
 
 		dma_descriptor_unmap(&desc->txd);
@@ -2130,6 +2318,19 @@ static void pl330_tasklet(struct tasklet_struct *t)
 			spin_lock_irqsave(&pch->lock, flags);
 		}
 	}
+
+	/* Report the periods completed by a looped cyclic req */
+	desc = list_first_entry_or_null(&pch->work_list,
+					struct dma_pl330_desc, node);
+	if (periods && desc && desc->num_periods && desc->status == BUSY) {
+		dmaengine_desc_get_callback(&desc->txd, &cb);
+
+		while (dmaengine_desc_callback_valid(&cb) && periods--) {
+			spin_unlock_irqrestore(&pch->lock, flags);
+			dmaengine_desc_callback_invoke(&cb, NULL);
+			spin_lock_irqsave(&pch->lock, flags);
+		}
+	}
 	spin_unlock_irqrestore(&pch->lock, flags);
 
 	/* If work list empty, power down */
@@ -2176,7 +2377,7 @@ static int pl330_alloc_chan_resources(struct dma_chan *chan)
 		return -ENOMEM;
 	}
 
-	tasklet_setup(&pch->task, pl330_tasklet);
+	INIT_WORK(&pch->task, pl330_complete_work);
 
 	spin_unlock_irqrestore(&pl330->lock, flags);
 
@@ -2293,6 +2494,7 @@ static int pl330_terminate_all(struct dma_chan *chan)
 	pch->thread->req[0].desc = NULL;
 	pch->thread->req[1].desc = NULL;
 	pch->thread->req_running = -1;
+	pch->thread->periods_elapsed = 0;
 	spin_unlock(&pl330->lock);
 
 	power_down = pch->active;
@@ -2309,9 +2511,9 @@ static int pl330_terminate_all(struct dma_chan *chan)
 		dma_cookie_complete(&desc->txd);
 	}
 
-	list_splice_tail_init(&pch->submitted_list, &pl330->desc_pool);
-	list_splice_tail_init(&pch->work_list, &pl330->desc_pool);
-	list_splice_tail_init(&pch->completed_list, &pl330->desc_pool);
+	list_splice_tail_init(&pch->submitted_list, &pch->desc_cache);
+	list_splice_tail_init(&pch->work_list, &pch->desc_cache);
+	list_splice_tail_init(&pch->completed_list, &pch->desc_cache);
 	spin_unlock_irqrestore(&pch->lock, flags);
 	pm_runtime_mark_last_busy(pl330->ddma.dev);
 	if (power_down)
@@ -2359,7 +2561,7 @@ static void pl330_free_chan_resources(struct dma_chan *chan)
 	struct pl330_dmac *pl330 = pch->dmac;
 	unsigned long flags;
 
-	tasklet_kill(&pch->task);
+	cancel_work_sync(&pch->task);
 
 	pm_runtime_get_sync(pch->dmac->ddma.dev);
 	spin_lock_irqsave(&pl330->lock, flags);
@@ -2368,9 +2570,14 @@ static void pl330_free_chan_resources(struct dma_chan *chan)
 	pch->thread = NULL;
 
 	if (pch->cyclic)
-		list_splice_tail_init(&pch->work_list, &pch->dmac->desc_pool);
+		list_splice_tail_init(&pch->work_list, &pch->desc_cache);
 
 	spin_unlock_irqrestore(&pl330->lock, flags);
+
+	/* Hand the cached descriptors back to the DMAC */
+	spin_lock_irqsave(&pl330->pool_lock, flags);
+	list_splice_tail_init(&pch->desc_cache, &pl330->desc_pool);
+	spin_unlock_irqrestore(&pl330->pool_lock, flags);
 	pm_runtime_mark_last_busy(pch->dmac->ddma.dev);
 	pm_runtime_put_autosuspend(pch->dmac->ddma.dev);
 	pl330_unprep_slave_fifo(pch);
@@ -2382,16 +2589,19 @@ static int pl330_get_current_xferred_count(struct dma_pl330_chan *pch,
 	struct pl330_thread *thrd = pch->thread;
 	struct pl330_dmac *pl330 = pch->dmac;
 	void __iomem *regs = thrd->dmac->base;
-	u32 val, addr;
+	u32 val, addr, stride;
+	u16 icg;
 
 	pm_runtime_get_sync(pl330->ddma.dev);
 	val = addr = 0;
 	if (desc->rqcfg.src_inc) {
 		val = readl(regs + SA(thrd->id));
 		addr = desc->px.src_addr;
+		icg = desc->src_icg;
 	} else {
 		val = readl(regs + DA(thrd->id));
 		addr = desc->px.dst_addr;
+		icg = desc->dst_icg;
 	}
 	pm_runtime_mark_last_busy(pch->dmac->ddma.dev);
 	pm_runtime_put_autosuspend(pl330->ddma.dev);
@@ -2400,7 +2610,14 @@ static int pl330_get_current_xferred_count(struct dma_pl330_chan *pch,
 	if (!val)
 		return 0;
 
-	return val - addr;
+	if (!desc->num_frames || !icg)
+		return val - addr;
+
+	/* Don't account for the gaps skipped between the frames */
+	stride = desc->px.bytes + icg;
+
+	return (val - addr) / stride * desc->px.bytes +
+	       min((val - addr) % stride, desc->px.bytes);
 }
 
 static enum dma_status
@@ -2496,7 +2713,7 @@ static void pl330_issue_pending(struct dma_chan *chan)
 	list_splice_tail_init(&pch->submitted_list, &pch->work_list);
 	spin_unlock_irqrestore(&pch->lock, flags);
 
-	pl330_tasklet(&pch->task);
+	pl330_complete_work(&pch->task);
 }
 
 /*
@@ -2599,8 +2816,10 @@ static struct dma_pl330_desc *pl330_get_desc(struct dma_pl330_chan *pch)
 	u8 *peri_id = pch->chan.private;
 	struct dma_pl330_desc *desc;
 
-	/* Pluck one desc from the pool of DMAC */
-	desc = pluck_desc(&pl330->desc_pool, &pl330->pool_lock);
+	/* Prefer the descs released by this channel before the DMAC pool */
+	desc = pluck_desc(&pch->desc_cache, &pch->lock);
+	if (!desc)
+		desc = pluck_desc(&pl330->desc_pool, &pl330->pool_lock);
 
 	/* If the DMAC pool is empty, alloc new */
 	if (!desc) {
@@ -2616,6 +2835,10 @@ static struct dma_pl330_desc *pl330_get_desc(struct dma_pl330_chan *pch)
 
 	/* Initialize the descriptor */
 	desc->pchan = pch;
+	desc->num_periods = 0;
+	desc->num_frames = 0;
+	desc->src_icg = 0;
+	desc->dst_icg = 0;
 	desc->txd.cookie = 0;
 	async_tx_ack(&desc->txd);
 
@@ -2680,6 +2903,57 @@ static inline int get_burst_len(struct dma_pl330_desc *desc, size_t len)
 	return burst_len;
 }
 
+static void pl330_fill_cyclic_desc(struct dma_pl330_chan *pch,
+				   struct dma_pl330_desc *desc,
+				   enum dma_transfer_direction direction,
+				   dma_addr_t dma_addr, size_t period_len)
+{
+	dma_addr_t dst;
+	dma_addr_t src;
+
+	switch (direction) {
+	case DMA_MEM_TO_DEV:
+		desc->rqcfg.src_inc = 1;
+		desc->rqcfg.dst_inc = 0;
+		src = dma_addr;
+		dst = pch->fifo_dma;
+		break;
+	case DMA_DEV_TO_MEM:
+		desc->rqcfg.src_inc = 0;
+		desc->rqcfg.dst_inc = 1;
+		src = pch->fifo_dma;
+		dst = dma_addr;
+		break;
+	default:
+		return;
+	}
+
+	desc->rqtype = direction;
+	desc->rqcfg.brst_size = pch->burst_sz;
+	desc->rqcfg.brst_len = pch->burst_len;
+	desc->bytes_requested = period_len;
+	fill_px(&desc->px, dst, src, period_len);
+}
+
+/* Check if the looped microcode of the whole ring fits in one MC buffer */
+static bool pl330_cyclic_fits(struct dma_pl330_chan *pch,
+			      struct dma_pl330_desc *desc)
+{
+	struct pl330_thread *thrd = pch->thread;
+	struct pl330_dmac *pl330 = pch->dmac;
+	struct _xfer_spec xs;
+	int size;
+
+	xs.ccr = _prepare_ccr(&desc->rqcfg);
+	xs.desc = desc;
+
+	size = _setup_cyclic(pl330, 1, thrd->req[0].mc_cpu, thrd, &xs);
+
+	/* The DMALPFE backward jump is encoded in 8 bits */
+	return size - SZ_DMALPEND <= 255 &&
+	       SZ_DMAMOV + size + SZ_DMAEND <= pl330->mcbufsz / 2;
+}
+
 static struct dma_async_tx_descriptor *pl330_prep_dma_cyclic(
 		struct dma_chan *chan, dma_addr_t dma_addr, size_t len,
 		size_t period_len, enum dma_transfer_direction direction,
@@ -2688,9 +2962,7 @@ static struct dma_async_tx_descriptor *pl330_prep_dma_cyclic(
 	struct dma_pl330_desc *desc = NULL, *first = NULL;
 	struct dma_pl330_chan *pch = to_pchan(chan);
 	struct pl330_dmac *pl330 = pch->dmac;
-	unsigned int i;
-	dma_addr_t dst;
-	dma_addr_t src;
+	unsigned int i, num_periods;
 
 	if (len % period_len != 0)
 		return NULL;
@@ -2706,7 +2978,9 @@ static struct dma_async_tx_descriptor *pl330_prep_dma_cyclic(
 	if (!pl330_prep_slave_fifo(pch, direction))
 		return NULL;
 
-	for (i = 0; i < len / period_len; i++) {
+	num_periods = len / period_len;
+
+	for (i = 0; i < num_periods; i++) {
 		desc = pl330_get_desc(pch);
 		if (!desc) {
 			unsigned long iflags;
@@ -2732,28 +3006,23 @@ static struct dma_async_tx_descriptor *pl330_prep_dma_cyclic(
 			return NULL;
 		}
 
-		switch (direction) {
-		case DMA_MEM_TO_DEV:
-			desc->rqcfg.src_inc = 1;
-			desc->rqcfg.dst_inc = 0;
-			src = dma_addr;
-			dst = pch->fifo_dma;
-			break;
-		case DMA_DEV_TO_MEM:
-			desc->rqcfg.src_inc = 0;
-			desc->rqcfg.dst_inc = 1;
-			src = pch->fifo_dma;
-			dst = dma_addr;
-			break;
-		default:
-			break;
-		}
+		pl330_fill_cyclic_desc(pch, desc, direction, dma_addr,
+				       period_len);
 
-		desc->rqtype = direction;
-		desc->rqcfg.brst_size = pch->burst_sz;
-		desc->rqcfg.brst_len = pch->burst_len;
-		desc->bytes_requested = period_len;
-		fill_px(&desc->px, dst, src, period_len);
+		/*
+		 * Prefer letting the microcode loop over the whole ring and
+		 * only raise an event per period, so that periods don't have
+		 * to be recycled and resubmitted by the completion work.
+		 */
+		if (!first && num_periods <= 256) {
+			desc->num_periods = num_periods;
+			desc->bytes_requested = len;
+			if (pl330_cyclic_fits(pch, desc))
+				break;
+
+			desc->num_periods = 0;
+			desc->bytes_requested = period_len;
+		}
 
 		if (!first)
 			first = desc;
@@ -2904,6 +3173,117 @@ pl330_prep_slave_sg(struct dma_chan *chan, struct scatterlist *sgl,
 	return &desc->txd;
 }
 
+/* Check if the frame loop fits in one MC buffer */
+static bool pl330_interleaved_fits(struct dma_pl330_chan *pch,
+				   struct dma_pl330_desc *desc)
+{
+	struct pl330_thread *thrd = pch->thread;
+	struct pl330_dmac *pl330 = pch->dmac;
+	struct _xfer_spec xs;
+	int size;
+
+	xs.ccr = _prepare_ccr(&desc->rqcfg);
+	xs.desc = desc;
+
+	size = _setup_interleaved(pl330, 1, thrd->req[0].mc_cpu, &xs);
+
+	/* The DMALPEND backward jump is encoded in 8 bits */
+	return size - 2 * SZ_DMAMOV - SZ_DMALP - SZ_DMALPEND <= 255 &&
+	       SZ_DMAMOV + size + SZ_DMASEV + SZ_DMAEND <= pl330->mcbufsz / 2;
+}
+
+/*
+ * Only single chunk frames are supported, the frames are looped over by
+ * the microcode and the gaps skipped with DMAADDH. Up to 256 frames are
+ * handled by a desc, further ones are chained.
+ */
+static struct dma_async_tx_descriptor *
+pl330_prep_interleaved_dma(struct dma_chan *chan,
+			   struct dma_interleaved_template *xt,
+			   unsigned long flags)
+{
+	struct dma_pl330_desc *first = NULL, *desc = NULL;
+	struct dma_pl330_chan *pch = to_pchan(chan);
+	struct pl330_dmac *pl330;
+	size_t len, src_icg, dst_icg;
+	dma_addr_t src, dst;
+	unsigned int numf;
+	int burst;
+
+	if (unlikely(!pch || !xt || !xt->numf))
+		return NULL;
+
+	if (xt->dir != DMA_MEM_TO_MEM || xt->frame_size != 1)
+		return NULL;
+
+	pl330 = pch->dmac;
+	len = xt->sgl[0].size;
+	src_icg = xt->src_inc ? dmaengine_get_src_icg(xt, &xt->sgl[0]) : 0;
+	dst_icg = xt->dst_inc ? dmaengine_get_dst_icg(xt, &xt->sgl[0]) : 0;
+
+	if (!len || src_icg > U16_MAX || dst_icg > U16_MAX)
+		return NULL;
+
+	/* Select max possible burst size, see pl330_prep_dma_memcpy() */
+	burst = pl330->pcfg.data_bus_width / 8;
+	while ((xt->src_start | xt->dst_start | len | src_icg | dst_icg) &
+	       (burst - 1))
+		burst /= 2;
+
+	src = xt->src_start;
+	dst = xt->dst_start;
+
+	for (numf = xt->numf; numf; numf -= desc->num_frames) {
+		desc = pl330_get_desc(pch);
+		if (!desc) {
+			dev_err(pl330->ddma.dev, "%s:%d Unable to fetch desc\n",
+				__func__, __LINE__);
+			__pl330_giveback_desc(pl330, first);
+
+			return NULL;
+		}
+
+		if (!first)
+			first = desc;
+		else
+			list_add_tail(&desc->node, &first->node);
+
+		fill_px(&desc->px, dst, src, len);
+		desc->rqcfg.src_inc = xt->src_inc;
+		desc->rqcfg.dst_inc = xt->dst_inc;
+		desc->rqtype = DMA_MEM_TO_MEM;
+
+		desc->rqcfg.brst_size = 0;
+		while (burst != (1 << desc->rqcfg.brst_size))
+			desc->rqcfg.brst_size++;
+
+		desc->rqcfg.brst_len = get_burst_len(desc, len);
+		if (burst * 8 < pl330->pcfg.data_bus_width)
+			desc->rqcfg.brst_len = 1;
+
+		desc->num_frames = min(numf, 256U);
+		desc->src_icg = src_icg;
+		desc->dst_icg = dst_icg;
+		desc->bytes_requested = len * desc->num_frames;
+
+		if (!pl330_interleaved_fits(pch, desc)) {
+			dev_err(pl330->ddma.dev, "%s:%d Frame too complex\n",
+				__func__, __LINE__);
+			__pl330_giveback_desc(pl330, first);
+
+			return NULL;
+		}
+
+		if (xt->src_inc)
+			src += (len + src_icg) * desc->num_frames;
+		if (xt->dst_inc)
+			dst += (len + dst_icg) * desc->num_frames;
+	}
+
+	/* Return the last desc in the chain */
+	return &desc->txd;
+}
+
 static irqreturn_t pl330_irq_handler(int irq, void *data)
 {
 	if (pl330_update(data))
@@ -3111,6 +3491,7 @@ pl330_probe(struct amba_device *adev, const struct amba_id *id)
 		INIT_LIST_HEAD(&pch->submitted_list);
 		INIT_LIST_HEAD(&pch->work_list);
 		INIT_LIST_HEAD(&pch->completed_list);
+		INIT_LIST_HEAD(&pch->desc_cache);
 		spin_lock_init(&pch->lock);
 		pch->thread = NULL;
 		pch->chan.device = pd;
@@ -3122,6 +3503,7 @@ pl330_probe(struct amba_device *adev, const struct amba_id *id)
 	}
 
 	dma_cap_set(DMA_MEMCPY, pd->cap_mask);
+	dma_cap_set(DMA_INTERLEAVE, pd->cap_mask);
 	if (pcfg->num_peri) {
 		dma_cap_set(DMA_SLAVE, pd->cap_mask);
 		dma_cap_set(DMA_CYCLIC, pd->cap_mask);
@@ -3131,6 +3513,7 @@ pl330_probe(struct amba_device *adev, const struct amba_id *id)
 	pd->device_alloc_chan_resources = pl330_alloc_chan_resources;
 	pd->device_free_chan_resources = pl330_free_chan_resources;
 	pd->device_prep_dma_memcpy = pl330_prep_dma_memcpy;
+	pd->device_prep_interleaved_dma = pl330_prep_interleaved_dma;
 	pd->device_prep_dma_cyclic = pl330_prep_dma_cyclic;
 	pd->device_tx_status = pl330_tx_status;
 	pd->device_prep_slave_sg = pl330_prep_slave_sg;
@@ -30,6 +30,9 @@
 #define GPIO_TYPE_V2		(0x01000C2B)  /* GPIO Version ID 0x01000C2B */
 #define GPIO_TYPE_V2_1		(0x0101157C)  /* GPIO Version ID 0x0101157C */
 
+/* Rounds of the demux loop before leaving the rest to the parent IRQ */
+#define GPIO_DEMUX_MAX_LOOPS	8
+
 static const struct rockchip_gpio_regs gpio_regs_v1 = {
 	.port_dr = 0x00,
 	.port_ddr = 0x04,
@@ -181,6 +184,31 @@ static void rockchip_gpio_set(struct gpio_chip *gc, unsigned int offset,
 	raw_spin_unlock_irqrestore(&bank->slock, flags);
 }
 
+static void rockchip_gpio_set_multiple(struct gpio_chip *gc,
+				       unsigned long *mask, unsigned long *bits)
+{
+	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
+	void __iomem *reg = bank->reg_base + bank->gpio_regs->port_dr;
+	u32 m = *mask, b = *bits & m;
+	unsigned long flags;
+	u32 data;
+
+	raw_spin_lock_irqsave(&bank->slock, flags);
+	if (bank->gpio_type == GPIO_TYPE_V2) {
+		/* The write mask in the upper half selects the bits to update */
+		if (m & 0xffff)
+			writel((m & 0xffff) << 16 | (b & 0xffff), reg);
+		if (m >> 16)
+			writel((m >> 16) << 16 | (b >> 16), reg + 0x4);
+	} else {
+		data = readl(reg);
+		data &= ~m;
+		data |= b;
+		writel(data, reg);
+	}
+	raw_spin_unlock_irqrestore(&bank->slock, flags);
+}
+
 static int rockchip_gpio_get(struct gpio_chip *gc, unsigned int offset)
 {
 	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
@@ -193,6 +221,18 @@ static int rockchip_gpio_get(struct gpio_chip *gc, unsigned int offset)
 	return data;
 }
 
+static int rockchip_gpio_get_multiple(struct gpio_chip *gc,
+				      unsigned long *mask, unsigned long *bits)
+{
+	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
+	u32 data;
+
+	data = readl(bank->reg_base + bank->gpio_regs->ext_port);
+	*bits = (*bits & ~*mask) | (data & *mask);
+
+	return 0;
+}
+
 static int rockchip_gpio_set_debounce(struct gpio_chip *gc,
 				      unsigned int offset,
 				      unsigned int debounce)
@@ -320,6 +360,8 @@ static const struct gpio_chip rockchip_gpiolib_chip = {
 	.free = gpiochip_generic_free,
 	.set = rockchip_gpio_set,
 	.get = rockchip_gpio_get,
+	.set_multiple = rockchip_gpio_set_multiple,
+	.get_multiple = rockchip_gpio_get_multiple,
 	.get_direction	= rockchip_gpio_get_direction,
 	.direction_input = rockchip_gpio_direction_input,
 	.direction_output = rockchip_gpio_direction_output,
@@ -332,6 +374,7 @@ static void rockchip_irq_demux(struct irq_desc *desc)
 {
 	struct irq_chip *chip = irq_desc_get_chip(desc);
 	struct rockchip_pin_bank *bank = irq_desc_get_handler_data(desc);
+	unsigned int loops = GPIO_DEMUX_MAX_LOOPS;
 	unsigned long pending;
 	unsigned int irq;
 
@@ -339,42 +382,53 @@ static void rockchip_irq_demux(struct irq_desc *desc)
 
 	chained_irq_enter(chip, desc);
 
-	pending = readl_relaxed(bank->reg_base + bank->gpio_regs->int_status);
-	for_each_set_bit(irq, &pending, 32) {
-		dev_dbg(bank->dev, "handling irq %d\n", irq);
+	/*
+	 * Keep servicing the bank until no enabled line is pending. Edges
+	 * that arrive while earlier lines are being handled are then
+	 * dispatched, and timestamped, right away instead of after another
+	 * exit and re-entry of the parent interrupt. A line that keeps
+	 * firing must not pin this CPU though, so the loop is bounded and
+	 * whatever is still pending re-raises the level triggered parent.
+	 */
+	while (loops-- &&
+	       (pending = readl_relaxed(bank->reg_base +
+					bank->gpio_regs->int_status))) {
+		for_each_set_bit(irq, &pending, 32) {
+			dev_dbg(bank->dev, "handling irq %d\n", irq);
+
+			/*
+			 * Triggering IRQ on both rising and falling edge
+			 * needs manual intervention.
+			 */
+			if (bank->toggle_edge_mode & BIT(irq)) {
+				u32 data, data_old, polarity;
+				unsigned long flags;
 
-		/*
-		 * Triggering IRQ on both rising and falling edge
-		 * needs manual intervention.
-		 */
-		if (bank->toggle_edge_mode & BIT(irq)) {
-			u32 data, data_old, polarity;
-			unsigned long flags;
-
-			data = readl_relaxed(bank->reg_base +
-					     bank->gpio_regs->ext_port);
-			do {
-				raw_spin_lock_irqsave(&bank->slock, flags);
-
-				polarity = readl_relaxed(bank->reg_base +
-							 bank->gpio_regs->int_polarity);
-				if (data & BIT(irq))
-					polarity &= ~BIT(irq);
-				else
-					polarity |= BIT(irq);
-				writel(polarity,
-				       bank->reg_base +
-				       bank->gpio_regs->int_polarity);
-
-				raw_spin_unlock_irqrestore(&bank->slock, flags);
-
-				data_old = data;
 				data = readl_relaxed(bank->reg_base +
 						     bank->gpio_regs->ext_port);
-			} while ((data & BIT(irq)) != (data_old & BIT(irq)));
+				do {
+					raw_spin_lock_irqsave(&bank->slock, flags);
+
+					polarity = readl_relaxed(bank->reg_base +
+								 bank->gpio_regs->int_polarity);
+					if (data & BIT(irq))
+						polarity &= ~BIT(irq);
+					else
+						polarity |= BIT(irq);
+					writel(polarity,
+					       bank->reg_base +
+					       bank->gpio_regs->int_polarity);
+
+					raw_spin_unlock_irqrestore(&bank->slock, flags);
+
+					data_old = data;
+					data = readl_relaxed(bank->reg_base +
+							     bank->gpio_regs->ext_port);
+				} while ((data & BIT(irq)) != (data_old & BIT(irq)));
+			}
+
+			generic_handle_domain_irq(bank->domain, irq);
 		}
-
-		generic_handle_domain_irq(bank->domain, irq);
 	}
 
 	chained_irq_exit(chip, desc);
@@ -18,6 +18,9 @@ struct dw_hdmi_i2s_audio_data {
 	void (*write)(struct dw_hdmi *hdmi, u8 val, int offset);
 	u8 (*read)(struct dw_hdmi *hdmi, int offset);
 	u8 *(*get_eld)(struct dw_hdmi *hdmi);
+
+	/* Sample rate the N/CTS values were last programmed for */
+	unsigned int sample_rate;
 };
 
 #endif
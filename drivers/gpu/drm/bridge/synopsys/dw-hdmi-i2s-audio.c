@@ -34,6 +34,32 @@ static inline u8 hdmi_read(struct dw_hdmi_i2s_audio_data *audio, int offset)
 	return audio->read(hdmi, offset);
 }
 
+/*
+ * Check whether the audio sampler and frame composer are already set up for
+ * these parameters, so that restarting a stream with the same format does not
+ * reprogram N/CTS and the infoframe and make the sink resynchronise.
+ */
+static bool dw_hdmi_i2s_params_unchanged(struct dw_hdmi_i2s_audio_data *audio,
+					 struct hdmi_codec_params *hparms,
+					 u8 inputclkfs, u8 conf0, u8 conf1,
+					 u8 conf2)
+{
+	u8 cc = (hparms->channels - 1) << HDMI_FC_AUDICONF0_CC_OFFSET;
+	u8 conf0_hw = hdmi_read(audio, HDMI_AUD_CONF0) & ~HDMI_AUD_CONF0_SW_RESET;
+	u8 cc_hw = hdmi_read(audio, HDMI_FC_AUDICONF0) & HDMI_FC_AUDICONF0_CC_MASK;
+
+	return audio->sample_rate == hparms->sample_rate &&
+	       conf0_hw == conf0 &&
+	       hdmi_read(audio, HDMI_AUD_CONF1) == conf1 &&
+	       hdmi_read(audio, HDMI_AUD_CONF2) == conf2 &&
+	       hdmi_read(audio, HDMI_AUD_INPUTCLKFS) == inputclkfs &&
+	       hdmi_read(audio, HDMI_FC_AUDSCHNLS7) == hparms->iec.status[3] &&
+	       hdmi_read(audio, HDMI_FC_AUDSCHNLS8) == hparms->iec.status[4] &&
+	       cc_hw == cc &&
+	       hdmi_read(audio, HDMI_FC_AUDICONF2) ==
+			hparms->cea.channel_allocation;
+}
+
 static int dw_hdmi_i2s_hw_params(struct device *dev, void *data,
 				 struct hdmi_codec_daifmt *fmt,
 				 struct hdmi_codec_params *hparms)
@@ -42,7 +68,9 @@ static int dw_hdmi_i2s_hw_params(struct device *dev, void *data,
 	struct dw_hdmi *hdmi = audio->hdmi;
 	u8 conf0 = 0;
 	u8 conf1 = 0;
+	u8 conf2 = 0;
 	u8 inputclkfs = 0;
+	bool unchanged;
 
 	/* it cares I2S only */
 	if (fmt->bit_clk_provider | fmt->frame_clk_provider) {
@@ -50,10 +78,6 @@ static int dw_hdmi_i2s_hw_params(struct device *dev, void *data,
 		return -EINVAL;
 	}
 
-	/* Reset the FIFOs before applying new params */
-	hdmi_write(audio, HDMI_AUD_CONF0_SW_RESET, HDMI_AUD_CONF0);
-	hdmi_write(audio, (u8)~HDMI_MC_SWRSTZ_I2SSWRST_REQ, HDMI_MC_SWRSTZ);
-
 	inputclkfs	= HDMI_AUD_INPUTCLKFS_64FS;
 	conf0		= (HDMI_AUD_CONF0_I2S_SELECT | HDMI_AUD_CONF0_I2S_EN0);
 
@@ -101,14 +125,38 @@ static int dw_hdmi_i2s_hw_params(struct device *dev, void *data,
 		return -EINVAL;
 	}
 
-	dw_hdmi_set_sample_rate(hdmi, hparms->sample_rate);
-	dw_hdmi_set_channel_status(hdmi, hparms->iec.status);
-	dw_hdmi_set_channel_count(hdmi, hparms->channels);
-	dw_hdmi_set_channel_allocation(hdmi, hparms->cea.channel_allocation);
+	/*
+	 * IEC 61937 compressed streams: eight channels carry a high bit rate
+	 * stream (e.g. TrueHD, DTS-HD MA) over all four lanes, anything else
+	 * is plain non-linear PCM.
+	 */
+	if (hparms->iec.status[0] & IEC958_AES0_NONAUDIO) {
+		if (hparms->channels == 8)
+			conf2 = HDMI_AUD_CONF2_HBR;
+		else
+			conf2 = HDMI_AUD_CONF2_NLPCM;
+	}
+
+	unchanged = dw_hdmi_i2s_params_unchanged(audio, hparms, inputclkfs,
+						 conf0, conf1, conf2);
+
+	/* Reset the FIFOs before applying new params */
+	hdmi_write(audio, HDMI_AUD_CONF0_SW_RESET, HDMI_AUD_CONF0);
+	hdmi_write(audio, (u8)~HDMI_MC_SWRSTZ_I2SSWRST_REQ, HDMI_MC_SWRSTZ);
+
+	if (!unchanged) {
+		dw_hdmi_set_sample_rate(hdmi, hparms->sample_rate);
+		dw_hdmi_set_channel_status(hdmi, hparms->iec.status);
+		dw_hdmi_set_channel_count(hdmi, hparms->channels);
+		dw_hdmi_set_channel_allocation(hdmi,
+					       hparms->cea.channel_allocation);
+		audio->sample_rate = hparms->sample_rate;
+	}
 
 	hdmi_write(audio, inputclkfs, HDMI_AUD_INPUTCLKFS);
 	hdmi_write(audio, conf0, HDMI_AUD_CONF0);
 	hdmi_write(audio, conf1, HDMI_AUD_CONF1);
+	hdmi_write(audio, conf2, HDMI_AUD_CONF2);
 
 	return 0;
 }
@@ -1627,6 +1627,13 @@ static int hdmi_phy_configure(struct dw_hdmi *hdmi,
 	unsigned long mtmdsclock = hdmi->hdmi_data.video_mode.mtmdsclock;
 	int ret;
 
+	/*
+	 * In YCbCr 4:2:0 two pixels are carried per TMDS character period,
+	 * so the PHY has to be set up for half the pixel clock.
+	 */
+	if (hdmi_bus_fmt_is_yuv420(hdmi->hdmi_data.enc_out_bus_format))
+		mpixelclock /= 2;
+
 	dw_hdmi_phy_power_off(hdmi);
 
 	dw_hdmi_set_high_tmds_clock_ratio(hdmi, display);
@@ -2643,6 +2650,7 @@ static u32 *dw_hdmi_bridge_atomic_get_output_bus_fmts(struct drm_bridge *bridge,
 					struct drm_connector_state *conn_state,
 					unsigned int *num_output_fmts)
 {
+	struct dw_hdmi *hdmi = bridge->driver_private;
 	struct drm_connector *conn = conn_state->connector;
 	struct drm_display_info *info = &conn->display_info;
 	struct drm_display_mode *mode = &crtc_state->mode;
@@ -2659,9 +2667,14 @@ static u32 *dw_hdmi_bridge_atomic_get_output_bus_fmts(struct drm_bridge *bridge,
 	if (!output_fmts)
 		return NULL;
 
-	/* If dw-hdmi is the first or only bridge, avoid negociating with ourselves */
-	if (list_is_singular(&bridge->encoder->bridge_chain) ||
-	    list_is_first(&bridge->chain_node, &bridge->encoder->bridge_chain)) {
+	/*
+	 * If dw-hdmi is the first or only bridge, avoid negociating with
+	 * ourselves, unless the platform allows YCbCr 4:2:0 in which case the
+	 * encoder is expected to pick up the negotiated input format.
+	 */
+	if (!hdmi->plat_data->ycbcr_420_allowed &&
+	    (list_is_singular(&bridge->encoder->bridge_chain) ||
+	     list_is_first(&bridge->chain_node, &bridge->encoder->bridge_chain))) {
 		*num_output_fmts = 1;
 		output_fmts[0] = MEDIA_BUS_FMT_FIXED;
 
@@ -2675,17 +2688,23 @@ static u32 *dw_hdmi_bridge_atomic_get_output_bus_fmts(struct drm_bridge *bridge,
 	if (conn->ycbcr_420_allowed &&
 	    (drm_mode_is_420_only(info, mode) ||
 	     (is_hdmi2_sink && drm_mode_is_420_also(info, mode)))) {
+		u8 y420_max_bpc = max_bpc;
+
+		/* The platform may not be able to feed deep color 4:2:0 */
+		if (hdmi->plat_data->ycbcr_420_max_bpc)
+			y420_max_bpc = min(max_bpc,
+					   hdmi->plat_data->ycbcr_420_max_bpc);
 
 		/* Order bus formats from 16bit to 8bit if supported */
-		if (max_bpc >= 16 && info->bpc == 16 &&
+		if (y420_max_bpc >= 16 && info->bpc == 16 &&
 		    (info->hdmi.y420_dc_modes & DRM_EDID_YCBCR420_DC_48))
 			output_fmts[i++] = MEDIA_BUS_FMT_UYYVYY16_0_5X48;
 
-		if (max_bpc >= 12 && info->bpc >= 12 &&
+		if (y420_max_bpc >= 12 && info->bpc >= 12 &&
 		    (info->hdmi.y420_dc_modes & DRM_EDID_YCBCR420_DC_36))
 			output_fmts[i++] = MEDIA_BUS_FMT_UYYVYY12_0_5X36;
 
-		if (max_bpc >= 10 && info->bpc >= 10 &&
+		if (y420_max_bpc >= 10 && info->bpc >= 10 &&
 		    (info->hdmi.y420_dc_modes & DRM_EDID_YCBCR420_DC_30))
 			output_fmts[i++] = MEDIA_BUS_FMT_UYYVYY10_0_5X30;
 
@@ -3527,7 +3546,7 @@ struct dw_hdmi *dw_hdmi_probe(struct platform_device *pdev,
 		pdevinfo.dma_mask = DMA_BIT_MASK(32);
 		hdmi->audio = platform_device_register_full(&pdevinfo);
 	} else if (config0 & HDMI_CONFIG0_I2S) {
-		struct dw_hdmi_i2s_audio_data audio;
+		struct dw_hdmi_i2s_audio_data audio = {};
 
 		audio.hdmi	= hdmi;
 		audio.get_eld	= hdmi_audio_get_eld;
@@ -114,6 +114,7 @@
 #define DSI_VID_VFP_LINES		0x5c
 #define DSI_VID_VACTIVE_LINES		0x60
 #define DSI_EDPI_CMD_SIZE		0x64
+#define EDPI_ALLOWED_CMD_SIZE(p)	((p) & 0xffff)
 
 #define DSI_CMD_MODE_CFG		0x68
 #define MAX_RD_PKT_SIZE_LP		BIT(24)
@@ -280,6 +281,16 @@ static inline bool dw_mipi_is_dual_mode(struct dw_mipi_dsi *dsi)
 	return dsi->slave || dsi->master;
 }
 
+/*
+ * Check if the pixel stream of a command mode peripheral is sent as eDPI
+ * memory writes, which the glue has to opt in to
+ */
+static inline bool dw_mipi_is_edpi_mode(struct dw_mipi_dsi *dsi)
+{
+	return dsi->plat_data->edpi_cmd_mode &&
+	       !(dsi->mode_flags & MIPI_DSI_MODE_VIDEO);
+}
+
 /*
  * The controller should generate 2 frames before
  * preparing the peripheral.
@@ -747,7 +758,8 @@ static void dw_mipi_dsi_video_packet_config(struct dw_mipi_dsi *dsi,
 				VID_PKT_SIZE(mode->hdisplay));
 }
 
-static void dw_mipi_dsi_command_mode_config(struct dw_mipi_dsi *dsi)
+static void dw_mipi_dsi_command_mode_config(struct dw_mipi_dsi *dsi,
+					    const struct drm_display_mode *mode)
 {
 	/*
 	 * TODO dw drv improvements
@@ -761,6 +773,19 @@ static void dw_mipi_dsi_command_mode_config(struct dw_mipi_dsi *dsi)
 	 * according to byte lane...
 	 */
 	dsi_write(dsi, DSI_BTA_TO_CNT, 0xd00);
+
+	/*
+	 * Panels without MIPI_DSI_MODE_VIDEO have their own frame memory and
+	 * the host stays in command mode, sending the pixel stream as eDPI
+	 * write_memory_start/continue packets. Send one line per packet, which
+	 * is what command mode controllers expect for their column window.
+	 */
+	if (dw_mipi_is_edpi_mode(dsi))
+		dsi_write(dsi, DSI_EDPI_CMD_SIZE,
+			  EDPI_ALLOWED_CMD_SIZE(dw_mipi_is_dual_mode(dsi) ?
+						mode->hdisplay / 2 :
+						mode->hdisplay));
+
 	dsi_write(dsi, DSI_MODE_CFG, ENABLE_CMD_MODE);
 }
 
@@ -996,7 +1021,7 @@ static void dw_mipi_dsi_mode_set(struct dw_mipi_dsi *dsi,
 	dw_mipi_dsi_packet_handler_config(dsi);
 	dw_mipi_dsi_video_mode_config(dsi);
 	dw_mipi_dsi_video_packet_config(dsi, adjusted_mode);
-	dw_mipi_dsi_command_mode_config(dsi);
+	dw_mipi_dsi_command_mode_config(dsi, adjusted_mode);
 	dw_mipi_dsi_line_timer_config(dsi, adjusted_mode);
 	dw_mipi_dsi_vertical_timing_config(dsi, adjusted_mode);
 
@@ -1046,11 +1071,16 @@ static void dw_mipi_dsi_bridge_atomic_enable(struct drm_bridge *bridge,
 					     struct drm_bridge_state *old_bridge_state)
 {
 	struct dw_mipi_dsi *dsi = bridge_to_dsi(bridge);
+	unsigned long mode = dw_mipi_is_edpi_mode(dsi) ? 0 : MIPI_DSI_MODE_VIDEO;
 
-	/* Switch to video mode for panel-bridge enable & panel enable */
-	dw_mipi_dsi_set_mode(dsi, MIPI_DSI_MODE_VIDEO);
+	/*
+	 * Switch to video mode for panel-bridge enable & panel enable, unless
+	 * the panel is a command mode one, which keeps refreshing from its own
+	 * memory and only needs the link for updates.
+	 */
+	dw_mipi_dsi_set_mode(dsi, mode);
 	if (dsi->slave)
-		dw_mipi_dsi_set_mode(dsi->slave, MIPI_DSI_MODE_VIDEO);
+		dw_mipi_dsi_set_mode(dsi->slave, mode);
 }
 
 static enum drm_mode_status
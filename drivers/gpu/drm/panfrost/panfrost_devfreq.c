@@ -7,10 +7,18 @@
 #include <linux/nvmem-consumer.h>
 #include <linux/platform_device.h>
 #include <linux/pm_opp.h>
+#include <linux/units.h>
 
 #include "panfrost_device.h"
 #include "panfrost_devfreq.h"
 
+/* One 60fps frame: how far back a submit-time re-evaluation looks */
+#define PANFROST_DEVFREQ_WINDOW_MS	16
+/* Boost when a deadline is this close and the GPU is still busy */
+#define PANFROST_DEADLINE_MARGIN_MS	3
+/* How long a deadline boost holds the raised minimum frequency */
+#define PANFROST_BOOST_DURATION_MS	50
+
 static void panfrost_devfreq_update_utilization(struct panfrost_devfreq *pfdevfreq)
 {
 	ktime_t now, last;
@@ -82,6 +90,68 @@ static int panfrost_devfreq_get_dev_status(struct device *dev,
 	return 0;
 }
 
+static void panfrost_devfreq_update_work(struct work_struct *work)
+{
+	struct panfrost_devfreq *pfdevfreq =
+		container_of(work, struct panfrost_devfreq, update_work);
+	struct devfreq *devfreq = pfdevfreq->devfreq;
+
+	mutex_lock(&devfreq->lock);
+	update_devfreq(devfreq);
+	mutex_unlock(&devfreq->lock);
+}
+
+/*
+ * Raise the minimum frequency one OPP above the current one. This only
+ * asks for as much extra speed as needed to catch up, rather than going
+ * to the fastest OPP.
+ */
+static void panfrost_devfreq_boost_work(struct work_struct *work)
+{
+	struct panfrost_devfreq *pfdevfreq =
+		container_of(work, struct panfrost_devfreq, boost_work);
+	struct device *dev = pfdevfreq->devfreq->dev.parent;
+	unsigned long freq = pfdevfreq->current_frequency + 1;
+	struct dev_pm_opp *opp;
+
+	opp = dev_pm_opp_find_freq_ceil(dev, &freq);
+	if (IS_ERR(opp))
+		return;
+	dev_pm_opp_put(opp);
+
+	dev_pm_qos_update_request(&pfdevfreq->boost_req, freq / HZ_PER_KHZ);
+	mod_delayed_work(system_wq, &pfdevfreq->unboost_work,
+			 msecs_to_jiffies(PANFROST_BOOST_DURATION_MS));
+}
+
+static void panfrost_devfreq_unboost_work(struct work_struct *work)
+{
+	struct panfrost_devfreq *pfdevfreq =
+		container_of(to_delayed_work(work), struct panfrost_devfreq,
+			     unboost_work);
+
+	dev_pm_qos_update_request(&pfdevfreq->boost_req,
+				  PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE);
+}
+
+static enum hrtimer_restart panfrost_devfreq_deadline_timer(struct hrtimer *t)
+{
+	struct panfrost_devfreq *pfdevfreq =
+		container_of(t, struct panfrost_devfreq, deadline_timer);
+	unsigned long irqflags;
+	bool busy;
+
+	spin_lock_irqsave(&pfdevfreq->lock, irqflags);
+	busy = pfdevfreq->busy_count > 0;
+	pfdevfreq->deadline = KTIME_MAX;
+	spin_unlock_irqrestore(&pfdevfreq->lock, irqflags);
+
+	if (busy)
+		queue_work(system_highpri_wq, &pfdevfreq->boost_work);
+
+	return HRTIMER_NORESTART;
+}
+
 static struct devfreq_dev_profile panfrost_devfreq_profile = {
 	.timer = DEVFREQ_TIMER_DELAYED,
 	.polling_ms = 50, /* ~3 frames */
@@ -161,6 +231,15 @@ int panfrost_devfreq_init(struct panfrost_device *pfdev)
 
 	panfrost_devfreq_reset(pfdevfreq);
 
+	pfdevfreq->deadline = KTIME_MAX;
+	INIT_WORK(&pfdevfreq->update_work, panfrost_devfreq_update_work);
+	INIT_WORK(&pfdevfreq->boost_work, panfrost_devfreq_boost_work);
+	INIT_DELAYED_WORK(&pfdevfreq->unboost_work,
+			  panfrost_devfreq_unboost_work);
+	hrtimer_init(&pfdevfreq->deadline_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_ABS);
+	pfdevfreq->deadline_timer.function = panfrost_devfreq_deadline_timer;
+
 	cur_freq = clk_get_rate(pfdev->clock);
 
 	opp = devfreq_recommended_opp(dev, &cur_freq, 0);
@@ -212,6 +291,12 @@ int panfrost_devfreq_init(struct panfrost_device *pfdev)
 	}
 	pfdevfreq->devfreq = devfreq;
 
+	ret = dev_pm_qos_add_request(dev, &pfdevfreq->boost_req,
+				     DEV_PM_QOS_MIN_FREQUENCY,
+				     PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE);
+	if (ret < 0)
+		DRM_DEV_INFO(dev, "Failed to add boost request, deadline boost disabled\n");
+
 	cooling = devfreq_cooling_em_register(devfreq, NULL);
 	if (IS_ERR(cooling))
 		DRM_DEV_INFO(dev, "Failed to register cooling device\n");
@@ -229,6 +314,16 @@ void panfrost_devfreq_fini(struct panfrost_device *pfdev)
 		devfreq_cooling_unregister(pfdevfreq->cooling);
 		pfdevfreq->cooling = NULL;
 	}
+
+	if (!pfdevfreq->devfreq)
+		return;
+
+	hrtimer_cancel(&pfdevfreq->deadline_timer);
+	cancel_work_sync(&pfdevfreq->update_work);
+	cancel_work_sync(&pfdevfreq->boost_work);
+	cancel_delayed_work_sync(&pfdevfreq->unboost_work);
+	if (dev_pm_qos_request_active(&pfdevfreq->boost_req))
+		dev_pm_qos_remove_request(&pfdevfreq->boost_req);
 }
 
 void panfrost_devfreq_resume(struct panfrost_device *pfdev)
@@ -256,6 +351,8 @@ void panfrost_devfreq_suspend(struct panfrost_device *pfdev)
 void panfrost_devfreq_record_busy(struct panfrost_devfreq *pfdevfreq)
 {
 	unsigned long irqflags;
+	bool ramp_up = false;
+	ktime_t total;
 
 	if (!pfdevfreq->devfreq)
 		return;
@@ -266,7 +363,21 @@ void panfrost_devfreq_record_busy(struct panfrost_devfreq *pfdevfreq)
 
 	pfdevfreq->busy_count++;
 
+	/*
+	 * The devfreq poll only runs every ~3 frames. If a frame's worth of
+	 * history already shows the GPU above the up threshold, re-evaluate
+	 * now instead of dropping frames until the next poll.
+	 */
+	total = ktime_add(pfdevfreq->busy_time, pfdevfreq->idle_time);
+	if (ktime_to_ms(total) >= PANFROST_DEVFREQ_WINDOW_MS &&
+	    ktime_to_ns(pfdevfreq->busy_time) * 100 >
+	    ktime_to_ns(total) * pfdevfreq->gov_data.upthreshold)
+		ramp_up = true;
+
 	spin_unlock_irqrestore(&pfdevfreq->lock, irqflags);
+
+	if (ramp_up)
+		queue_work(system_highpri_wq, &pfdevfreq->update_work);
 }
 
 void panfrost_devfreq_record_idle(struct panfrost_devfreq *pfdevfreq)
@@ -284,3 +395,34 @@ void panfrost_devfreq_record_idle(struct panfrost_devfreq *pfdevfreq)
 
 	spin_unlock_irqrestore(&pfdevfreq->lock, irqflags);
 }
+
+/**
+ * panfrost_devfreq_set_deadline() - Note a deadline for pending GPU work
+ * @pfdevfreq: devfreq state
+ * @deadline: time by which a pending job fence should be signaled
+ *
+ * Called for dma_fence deadline hints, e.g. the next vblank for a buffer
+ * about to be flipped. If the GPU is still busy shortly before the
+ * earliest deadline, the minimum frequency is raised for a little while
+ * so the frame makes it.
+ */
+void panfrost_devfreq_set_deadline(struct panfrost_devfreq *pfdevfreq,
+				   ktime_t deadline)
+{
+	unsigned long irqflags;
+	ktime_t expires;
+
+	if (!pfdevfreq->devfreq ||
+	    !dev_pm_qos_request_active(&pfdevfreq->boost_req))
+		return;
+
+	expires = ktime_sub_ms(deadline, PANFROST_DEADLINE_MARGIN_MS);
+
+	spin_lock_irqsave(&pfdevfreq->lock, irqflags);
+	if (ktime_before(deadline, pfdevfreq->deadline)) {
+		pfdevfreq->deadline = deadline;
+		hrtimer_start(&pfdevfreq->deadline_timer, expires,
+			      HRTIMER_MODE_ABS);
+	}
+	spin_unlock_irqrestore(&pfdevfreq->lock, irqflags);
+}
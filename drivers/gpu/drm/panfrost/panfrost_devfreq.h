@@ -5,8 +5,11 @@
 #define __PANFROST_DEVFREQ_H__
 
 #include <linux/devfreq.h>
+#include <linux/hrtimer.h>
+#include <linux/pm_qos.h>
 #include <linux/spinlock.h>
 #include <linux/ktime.h>
+#include <linux/workqueue.h>
 
 struct devfreq;
 struct thermal_cooling_device;
@@ -26,11 +29,23 @@ struct panfrost_devfreq {
 	ktime_t idle_time;
 	ktime_t time_last_update;
 	int busy_count;
+	/* Earliest pending fence deadline, KTIME_MAX if none */
+	ktime_t deadline;
 	/*
-	 * Protect busy_time, idle_time, time_last_update and busy_count
-	 * because these can be updated concurrently between multiple jobs.
+	 * Protect busy_time, idle_time, time_last_update, busy_count and
+	 * deadline because these can be updated concurrently between
+	 * multiple jobs.
 	 */
 	spinlock_t lock;
+
+	/* Re-evaluates the OPP ahead of the next devfreq poll */
+	struct work_struct update_work;
+
+	/* Temporary min frequency raise on a fence deadline at risk */
+	struct hrtimer deadline_timer;
+	struct dev_pm_qos_request boost_req;
+	struct work_struct boost_work;
+	struct delayed_work unboost_work;
 };
 
 int panfrost_devfreq_init(struct panfrost_device *pfdev);
@@ -41,5 +56,7 @@ void panfrost_devfreq_suspend(struct panfrost_device *pfdev);
 
 void panfrost_devfreq_record_busy(struct panfrost_devfreq *devfreq);
 void panfrost_devfreq_record_idle(struct panfrost_devfreq *devfreq);
+void panfrost_devfreq_set_deadline(struct panfrost_devfreq *devfreq,
+				   ktime_t deadline);
 
 #endif /* __PANFROST_DEVFREQ_H__ */
@@ -12,6 +12,7 @@
 #include "panfrost_device.h"
 #include "panfrost_devfreq.h"
 #include "panfrost_features.h"
+#include "panfrost_gem.h"
 #include "panfrost_issues.h"
 #include "panfrost_gpu.h"
 #include "panfrost_job.h"
@@ -261,6 +262,8 @@ int panfrost_device_init(struct panfrost_device *pfdev)
 	if (err)
 		goto out_job;
 
+	panfrost_gemfs_init(pfdev);
+
 	return 0;
 out_job:
 	panfrost_job_fini(pfdev);
@@ -283,6 +286,7 @@ int panfrost_device_init(struct panfrost_device *pfdev)
 
 void panfrost_device_fini(struct panfrost_device *pfdev)
 {
+	panfrost_gemfs_fini(pfdev);
 	panfrost_perfcnt_fini(pfdev);
 	panfrost_job_fini(pfdev);
 	panfrost_mmu_fini(pfdev);
@@ -408,6 +412,7 @@ static int panfrost_device_runtime_resume(struct device *dev)
 	struct panfrost_device *pfdev = dev_get_drvdata(dev);
 
 	panfrost_device_reset(pfdev);
+	panfrost_perfcnt_resume(pfdev);
 	panfrost_devfreq_resume(pfdev);
 
 	return 0;
@@ -420,6 +425,7 @@ static int panfrost_device_runtime_suspend(struct device *dev)
 	if (!panfrost_job_is_idle(pfdev))
 		return -EBUSY;
 
+	panfrost_perfcnt_suspend(pfdev);
 	panfrost_devfreq_suspend(pfdev);
 	panfrost_job_suspend_irq(pfdev);
 	panfrost_mmu_suspend_irq(pfdev);
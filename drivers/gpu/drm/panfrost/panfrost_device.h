@@ -21,6 +21,7 @@ struct panfrost_mmu;
 struct panfrost_job_slot;
 struct panfrost_job;
 struct panfrost_perfcnt;
+struct vfsmount;
 
 #define NUM_JOB_SLOTS 3
 #define MAX_PM_DOMAINS 5
@@ -142,8 +143,13 @@ struct panfrost_device {
 
 	struct mutex shrinker_lock;
 	struct list_head shrinker_list;
+	/* BOs that can be evicted, least recently submitted first */
+	struct list_head evict_list;
 	struct shrinker *shrinker;
 
+	/* huge=within_size tmpfs backing BOs, NULL when not in use */
+	struct vfsmount *gemfs;
+
 	struct panfrost_devfreq pfdevfreq;
 
 	struct {
@@ -162,6 +168,8 @@ struct panfrost_mmu {
 	int as;
 	atomic_t as_count;
 	struct list_head list;
+	atomic64_t heap_faults;
+	atomic64_t heap_prefaults;
 };
 
 struct panfrost_engine_usage {
@@ -172,20 +172,54 @@ panfrost_lookup_bos(struct drm_device *dev,
 
 		atomic_inc(&bo->gpu_usecount);
 		job->mappings[i] = mapping;
+
+		ret = panfrost_gem_restore(bo);
+		if (ret)
+			break;
 	}
 
+	if (!ret)
+		panfrost_gem_mark_used(priv->pfdev, job->bos, job->bo_count);
+
 	return ret;
 }
 
+/*
+ * Returns the index of the last job in batch[0..count - 1] that signals
+ * the syncobj @handle, or -1 if none of them does.
+ */
+static int
+panfrost_batch_find_out_sync(const struct drm_panfrost_submit *batch,
+			     unsigned int count, u32 handle)
+{
+	int i;
+
+	if (!batch || !handle)
+		return -1;
+
+	for (i = count - 1; i >= 0; i--) {
+		if (batch[i].out_sync == handle)
+			return i;
+	}
+
+	return -1;
+}
+
 /**
  * panfrost_copy_in_sync() - Sets up job->deps with the sync objects
  * referenced by the job.
  * @dev: DRM device
  * @file_priv: DRM file for this fd
  * @args: IOCTL args
+ * @batch: descriptors of the jobs queued before this one in the same
+ *	   batch, or NULL
+ * @index: number of entries in @batch
  * @job: job being set up
  *
  * Resolve syncobjs from userspace to fences and attach them to job.
+ * A syncobj that an earlier job of the batch signals is not resolved
+ * here. Its fence would be the stale one from before the batch, so the
+ * job is marked in job->batch_deps to wait for that earlier job instead.
  *
  * Note that this function doesn't need to unreference the fences on
  * failure, because that will happen at panfrost_job_cleanup() time.
@@ -194,6 +228,8 @@ static int
 panfrost_copy_in_sync(struct drm_device *dev,
 		  struct drm_file *file_priv,
 		  struct drm_panfrost_submit *args,
+		  const struct drm_panfrost_submit *batch,
+		  unsigned int index,
 		  struct panfrost_job *job)
 {
 	u32 *handles;
@@ -221,6 +257,13 @@ panfrost_copy_in_sync(struct drm_device *dev,
 	}
 
 	for (i = 0; i < in_fence_count; i++) {
+		int dep = panfrost_batch_find_out_sync(batch, index, handles[i]);
+
+		if (dep >= 0) {
+			job->batch_deps |= BIT_ULL(dep);
+			continue;
+		}
+
 		ret = drm_sched_job_add_syncobj_dependency(&job->base, file_priv,
 							   handles[i], 0);
 		if (ret)
@@ -232,33 +275,38 @@ panfrost_copy_in_sync(struct drm_device *dev,
 	return ret;
 }
 
-static int panfrost_ioctl_submit(struct drm_device *dev, void *data,
-		struct drm_file *file)
+/**
+ * panfrost_job_prepare() - Creates a job from a submit descriptor
+ * @dev: DRM device
+ * @file: DRM file for this fd
+ * @args: submit descriptor
+ * @batch: descriptors of the jobs queued before this one in the same
+ *	   batch, or NULL for a single submit
+ * @index: number of entries in @batch
+ *
+ * Looks up the BOs and in-syncs of @args and returns a job ready to be
+ * handed to panfrost_job_push(), or an ERR_PTR() on failure.
+ */
+static struct panfrost_job *
+panfrost_job_prepare(struct drm_device *dev, struct drm_file *file,
+		     struct drm_panfrost_submit *args,
+		     const struct drm_panfrost_submit *batch,
+		     unsigned int index)
 {
 	struct panfrost_device *pfdev = dev->dev_private;
 	struct panfrost_file_priv *file_priv = file->driver_priv;
-	struct drm_panfrost_submit *args = data;
-	struct drm_syncobj *sync_out = NULL;
 	struct panfrost_job *job;
-	int ret = 0, slot;
+	int ret, slot;
 
 	if (!args->jc)
-		return -EINVAL;
+		return ERR_PTR(-EINVAL);
 
 	if (args->requirements && args->requirements != PANFROST_JD_REQ_FS)
-		return -EINVAL;
-
-	if (args->out_sync > 0) {
-		sync_out = drm_syncobj_find(file, args->out_sync);
-		if (!sync_out)
-			return -ENODEV;
-	}
+		return ERR_PTR(-EINVAL);
 
 	job = kzalloc(sizeof(*job), GFP_KERNEL);
-	if (!job) {
-		ret = -ENOMEM;
-		goto out_put_syncout;
-	}
+	if (!job)
+		return ERR_PTR(-ENOMEM);
 
 	kref_init(&job->refcount);
 
@@ -277,7 +325,7 @@ static int panfrost_ioctl_submit(struct drm_device *dev, void *data,
 	if (ret)
 		goto out_put_job;
 
-	ret = panfrost_copy_in_sync(dev, file, args, job);
+	ret = panfrost_copy_in_sync(dev, file, args, batch, index, job);
 	if (ret)
 		goto out_cleanup_job;
 
@@ -285,17 +333,46 @@ static int panfrost_ioctl_submit(struct drm_device *dev, void *data,
 	if (ret)
 		goto out_cleanup_job;
 
+	return job;
+
+out_cleanup_job:
+	drm_sched_job_cleanup(&job->base);
+out_put_job:
+	panfrost_job_put(job);
+
+	return ERR_PTR(ret);
+}
+
+static int panfrost_ioctl_submit(struct drm_device *dev, void *data,
+		struct drm_file *file)
+{
+	struct drm_panfrost_submit *args = data;
+	struct drm_syncobj *sync_out = NULL;
+	struct panfrost_job *job;
+	int ret = 0;
+
+	if (args->out_sync > 0) {
+		sync_out = drm_syncobj_find(file, args->out_sync);
+		if (!sync_out)
+			return -ENODEV;
+	}
+
+	job = panfrost_job_prepare(dev, file, args, NULL, 0);
+	if (IS_ERR(job)) {
+		ret = PTR_ERR(job);
+		goto out_put_syncout;
+	}
+
 	ret = panfrost_job_push(job);
-	if (ret)
-		goto out_cleanup_job;
+	if (ret) {
+		drm_sched_job_cleanup(&job->base);
+		goto out_put_job;
+	}
 
 	/* Update the return sync object for the job */
 	if (sync_out)
 		drm_syncobj_replace_fence(sync_out, job->render_done_fence);
 
-out_cleanup_job:
-	if (ret)
-		drm_sched_job_cleanup(&job->base);
 out_put_job:
 	panfrost_job_put(job);
 out_put_syncout:
@@ -305,6 +382,87 @@ static int panfrost_ioctl_submit(struct drm_device *dev, void *data,
 	return ret;
 }
 
+/*
+ * Bounds the descriptor copy and the BO de-duplication of a batch, and
+ * fits the batch indices in panfrost_job::batch_deps
+ */
+#define PANFROST_BATCH_MAX_JOBS		64
+
+static int panfrost_ioctl_batch_submit(struct drm_device *dev, void *data,
+				       struct drm_file *file)
+{
+	struct drm_panfrost_batch_submit *args = data;
+	struct drm_panfrost_submit *descs;
+	struct drm_syncobj **sync_outs;
+	struct panfrost_job **jobs;
+	unsigned int i, pushed = 0;
+	int ret;
+
+	if (args->pad || args->job_count > PANFROST_BATCH_MAX_JOBS)
+		return -EINVAL;
+
+	/* An empty batch lets userspace probe for the ioctl */
+	if (!args->job_count)
+		return 0;
+
+	descs = kvmalloc_array(args->job_count, sizeof(*descs), GFP_KERNEL);
+	jobs = kvcalloc(args->job_count, sizeof(*jobs), GFP_KERNEL);
+	sync_outs = kvcalloc(args->job_count, sizeof(*sync_outs), GFP_KERNEL);
+	if (!descs || !jobs || !sync_outs) {
+		ret = -ENOMEM;
+		goto out_free;
+	}
+
+	if (copy_from_user(descs, u64_to_user_ptr(args->jobs),
+			   args->job_count * sizeof(*descs))) {
+		ret = -EFAULT;
+		goto out_free;
+	}
+
+	for (i = 0; i < args->job_count; i++) {
+		if (descs[i].out_sync > 0) {
+			sync_outs[i] = drm_syncobj_find(file, descs[i].out_sync);
+			if (!sync_outs[i]) {
+				ret = -ENODEV;
+				goto out_put;
+			}
+		}
+
+		jobs[i] = panfrost_job_prepare(dev, file, &descs[i], descs, i);
+		if (IS_ERR(jobs[i])) {
+			ret = PTR_ERR(jobs[i]);
+			jobs[i] = NULL;
+			goto out_put;
+		}
+	}
+
+	ret = panfrost_job_push_batch(jobs, args->job_count, &pushed);
+
+	/* Update the return sync objects of the jobs that made it */
+	for (i = 0; i < pushed; i++) {
+		if (sync_outs[i])
+			drm_syncobj_replace_fence(sync_outs[i],
+						  jobs[i]->render_done_fence);
+	}
+
+out_put:
+	for (i = 0; i < args->job_count; i++) {
+		if (jobs[i]) {
+			if (i >= pushed)
+				drm_sched_job_cleanup(&jobs[i]->base);
+			panfrost_job_put(jobs[i]);
+		}
+		if (sync_outs[i])
+			drm_syncobj_put(sync_outs[i]);
+	}
+out_free:
+	kvfree(sync_outs);
+	kvfree(jobs);
+	kvfree(descs);
+
+	return ret;
+}
+
 static int
 panfrost_ioctl_wait_bo(struct drm_device *dev, void *data,
 		       struct drm_file *file_priv)
@@ -522,6 +680,7 @@ static const struct drm_ioctl_desc panfrost_drm_driver_ioctls[] = {
 	PANFROST_IOCTL(PERFCNT_ENABLE,	perfcnt_enable,	DRM_RENDER_ALLOW),
 	PANFROST_IOCTL(PERFCNT_DUMP,	perfcnt_dump,	DRM_RENDER_ALLOW),
 	PANFROST_IOCTL(MADVISE,		madvise,	DRM_RENDER_ALLOW),
+	PANFROST_IOCTL(BATCH_SUBMIT,	batch_submit,	DRM_RENDER_ALLOW),
 };
 
 static void panfrost_gpu_show_fdinfo(struct panfrost_device *pfdev,
@@ -561,6 +720,11 @@ static void panfrost_gpu_show_fdinfo(struct panfrost_device *pfdev,
 		drm_printf(p, "drm-curfreq-%s:\t%lu Hz\n",
 			   engine_names[i], pfdev->pfdevfreq.current_frequency);
 	}
+
+	drm_printf(p, "panfrost-heap-faults:\t%lld\n",
+		   atomic64_read(&panfrost_priv->mmu->heap_faults));
+	drm_printf(p, "panfrost-heap-prefaults:\t%lld\n",
+		   atomic64_read(&panfrost_priv->mmu->heap_prefaults));
 }
 
 static void panfrost_show_fdinfo(struct drm_printer *p, struct drm_file *file)
@@ -634,6 +798,7 @@ static int panfrost_probe(struct platform_device *pdev)
 
 	mutex_init(&pfdev->shrinker_lock);
 	INIT_LIST_HEAD(&pfdev->shrinker_list);
+	INIT_LIST_HEAD(&pfdev->evict_list);
 
 	err = panfrost_device_init(pfdev);
 	if (err) {
@@ -716,8 +881,19 @@ static ssize_t profiling_store(struct device *dev,
 
 static DEVICE_ATTR_RW(profiling);
 
+static ssize_t fence_latency_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct panfrost_device *pfdev = dev_get_drvdata(dev);
+
+	return panfrost_job_latency_show(pfdev, buf);
+}
+
+static DEVICE_ATTR_RO(fence_latency);
+
 static struct attribute *panfrost_attrs[] = {
 	&dev_attr_profiling.attr,
+	&dev_attr_fence_latency.attr,
 	NULL,
 };
 
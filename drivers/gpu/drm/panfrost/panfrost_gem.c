@@ -2,15 +2,89 @@
 /* Copyright 2019 Linaro, Ltd, Rob Herring <robh@kernel.org> */
 
 #include <linux/err.h>
+#include <linux/fs.h>
+#include <linux/mount.h>
+#include <linux/shmem_fs.h>
 #include <linux/slab.h>
 #include <linux/dma-buf.h>
 #include <linux/dma-mapping.h>
 
+#include <drm/drm_prime.h>
 #include <drm/panfrost_drm.h>
 #include "panfrost_device.h"
 #include "panfrost_gem.h"
 #include "panfrost_mmu.h"
 
+static bool transparent_hugepage;
+module_param(transparent_hugepage, bool, 0400);
+MODULE_PARM_DESC(transparent_hugepage, "Back BOs with huge pages when possible (default = false)");
+
+/*
+ * Cacheable CPU mappings are only offered through dma-buf, whose
+ * DMA_BUF_IOCTL_SYNC brackets give the driver a place to do the cache
+ * maintenance. A CREATE_BO flag for DRM fd mmaps would also need a new
+ * cache sync ioctl, as the uapi has no such bracket for those.
+ */
+static bool cached_dmabuf_mmap;
+module_param(cached_dmabuf_mmap, bool, 0600);
+MODULE_PARM_DESC(cached_dmabuf_mmap, "Map exported BOs cacheable, CPU access must be bracketed by DMA_BUF_IOCTL_SYNC (default = false)");
+
+void panfrost_gemfs_init(struct panfrost_device *pfdev)
+{
+	char huge_opt[] = "huge=within_size";
+	struct file_system_type *type;
+	struct vfsmount *gemfs;
+
+	/*
+	 * Huge pages let mmu_map_sg() use 2MB block entries for BOs whose
+	 * GPU VA is 2MB aligned, which cuts the GPU TLB misses on large
+	 * textures. Falls back to the regular shm mount on any failure.
+	 */
+	if (!IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE) || !transparent_hugepage)
+		return;
+
+	type = get_fs_type("tmpfs");
+	if (!type)
+		goto err;
+
+	gemfs = vfs_kern_mount(type, SB_KERNMOUNT, type->name, huge_opt);
+	if (IS_ERR(gemfs))
+		goto err;
+
+	pfdev->gemfs = gemfs;
+	dev_info(pfdev->dev, "Using transparent hugepages\n");
+
+	return;
+
+err:
+	dev_err(pfdev->dev, "Can't use transparent hugepages, using shm instead\n");
+}
+
+void panfrost_gemfs_fini(struct panfrost_device *pfdev)
+{
+	if (pfdev->gemfs)
+		kern_unmount(pfdev->gemfs);
+}
+
+static int panfrost_gem_use_gemfs(struct panfrost_device *pfdev,
+				  struct drm_gem_object *obj)
+{
+	struct file *filp;
+
+	filp = shmem_file_setup_with_mnt(pfdev->gemfs, "drm mm object",
+					 obj->size, VM_NORESERVE);
+	if (IS_ERR(filp))
+		return PTR_ERR(filp);
+
+	/* No pages have been allocated yet, so the swap is invisible */
+	fput(obj->filp);
+	obj->filp = filp;
+	mapping_set_gfp_mask(filp->f_mapping, GFP_HIGHUSER |
+			     __GFP_RETRY_MAYFAIL | __GFP_NOWARN);
+
+	return 0;
+}
+
 /* Called DRM core on the last userspace/kernel unreference of the
  * BO.
  */
@@ -27,6 +101,7 @@ static void panfrost_gem_free_object(struct drm_gem_object *obj)
 	 */
 	mutex_lock(&pfdev->shrinker_lock);
 	list_del_init(&bo->base.madv_list);
+	list_del_init(&bo->lru_node);
 	mutex_unlock(&pfdev->shrinker_lock);
 
 	/*
@@ -149,13 +224,19 @@ int panfrost_gem_open(struct drm_gem_object *obj, struct drm_file *file_priv)
 	if (ret)
 		goto err;
 
-	if (!bo->is_heap) {
+	/*
+	 * Map under the mappings lock so that the shrinker sees either no
+	 * mapping, or an active one it has to tear down on eviction.
+	 */
+	mutex_lock(&bo->mappings.lock);
+	if (!bo->is_heap && !bo->evicted) {
 		ret = panfrost_mmu_map(mapping);
-		if (ret)
+		if (ret) {
+			mutex_unlock(&bo->mappings.lock);
 			goto err;
+		}
 	}
 
-	mutex_lock(&bo->mappings.lock);
 	WARN_ON(bo->base.madv != PANFROST_MADV_WILLNEED);
 	list_add_tail(&mapping->node, &bo->mappings.list);
 	mutex_unlock(&bo->mappings.lock);
@@ -223,10 +304,117 @@ static size_t panfrost_gem_rss(struct drm_gem_object *obj)
 	return 0;
 }
 
+static int panfrost_gem_sync(struct dma_buf *dma_buf,
+			     enum dma_data_direction dir, bool for_cpu)
+{
+	struct drm_gem_object *obj = dma_buf->priv;
+	struct drm_gem_shmem_object *shmem = to_drm_gem_shmem_obj(obj);
+	struct dma_buf_attachment *attach;
+	int ret;
+
+	ret = dma_resv_lock_interruptible(obj->resv, NULL);
+	if (ret)
+		return ret;
+
+	/* No sgt means the GPU never had the pages mapped, or the shrinker
+	 * evicted them after cleaning the caches. Nothing to maintain.
+	 */
+	if (shmem->sgt) {
+		if (for_cpu)
+			dma_sync_sgtable_for_cpu(obj->dev->dev, shmem->sgt, dir);
+		else
+			dma_sync_sgtable_for_device(obj->dev->dev, shmem->sgt, dir);
+	}
+
+	/* Importers such as the display controller have their own mappings,
+	 * which the GPU sgt doesn't cover. The attachment list and the
+	 * cached sgts are protected by the reservation lock held here.
+	 */
+	list_for_each_entry(attach, &dma_buf->attachments, node) {
+		if (!attach->sgt)
+			continue;
+
+		if (for_cpu)
+			dma_sync_sgtable_for_cpu(attach->dev, attach->sgt, dir);
+		else
+			dma_sync_sgtable_for_device(attach->dev, attach->sgt, dir);
+	}
+
+	dma_resv_unlock(obj->resv);
+
+	return 0;
+}
+
+static int panfrost_gem_begin_cpu_access(struct dma_buf *dma_buf,
+					 enum dma_data_direction dir)
+{
+	return panfrost_gem_sync(dma_buf, dir, true);
+}
+
+static int panfrost_gem_end_cpu_access(struct dma_buf *dma_buf,
+				       enum dma_data_direction dir)
+{
+	return panfrost_gem_sync(dma_buf, dir, false);
+}
+
+static int panfrost_gem_dmabuf_mmap(struct dma_buf *dma_buf,
+				    struct vm_area_struct *vma)
+{
+	struct drm_gem_object *obj = dma_buf->priv;
+	int ret;
+
+	ret = drm_gem_dmabuf_mmap(dma_buf, vma);
+	if (ret || !cached_dmabuf_mmap || obj->import_attach)
+		return ret;
+
+	/* Nothing is faulted in yet, so undo the writecombine prot the shmem
+	 * helper picked. Coherency is handled by {begin,end}_cpu_access().
+	 */
+	vma->vm_page_prot = vm_get_page_prot(vma->vm_flags);
+
+	return 0;
+}
+
+static const struct dma_buf_ops panfrost_dmabuf_ops = {
+	.cache_sgt_mapping = true,
+	.attach = drm_gem_map_attach,
+	.detach = drm_gem_map_detach,
+	.map_dma_buf = drm_gem_map_dma_buf,
+	.unmap_dma_buf = drm_gem_unmap_dma_buf,
+	.release = drm_gem_dmabuf_release,
+	.mmap = panfrost_gem_dmabuf_mmap,
+	.vmap = drm_gem_dmabuf_vmap,
+	.vunmap = drm_gem_dmabuf_vunmap,
+	.begin_cpu_access = panfrost_gem_begin_cpu_access,
+	.end_cpu_access = panfrost_gem_end_cpu_access,
+};
+
+static struct dma_buf *panfrost_gem_prime_export(struct drm_gem_object *obj,
+						 int flags)
+{
+	struct dma_buf_export_info exp_info = {
+		.exp_name = KBUILD_MODNAME,
+		.owner = THIS_MODULE,
+		.ops = &panfrost_dmabuf_ops,
+		.size = obj->size,
+		.flags = flags,
+		.priv = obj,
+		.resv = obj->resv,
+	};
+	struct dma_buf *dmabuf;
+
+	dmabuf = drm_gem_dmabuf_export(obj->dev, &exp_info);
+	if (!IS_ERR(dmabuf))
+		to_panfrost_bo(obj)->exp_ino = dma_buf_ino(dmabuf);
+
+	return dmabuf;
+}
+
 static const struct drm_gem_object_funcs panfrost_gem_funcs = {
 	.free = panfrost_gem_free_object,
 	.open = panfrost_gem_open,
 	.close = panfrost_gem_close,
+	.export = panfrost_gem_prime_export,
 	.print_info = drm_gem_shmem_object_print_info,
 	.pin = panfrost_gem_pin,
 	.unpin = drm_gem_shmem_object_unpin,
@@ -257,6 +445,7 @@ struct drm_gem_object *panfrost_gem_create_object(struct drm_device *dev, size_t
 		return ERR_PTR(-ENOMEM);
 
 	INIT_LIST_HEAD(&obj->mappings.list);
+	INIT_LIST_HEAD(&obj->lru_node);
 	mutex_init(&obj->mappings.lock);
 	obj->base.base.funcs = &panfrost_gem_funcs;
 	obj->base.map_wc = !pfdev->coherent;
@@ -267,8 +456,10 @@ struct drm_gem_object *panfrost_gem_create_object(struct drm_device *dev, size_t
 struct panfrost_gem_object *
 panfrost_gem_create(struct drm_device *dev, size_t size, u32 flags)
 {
+	struct panfrost_device *pfdev = dev->dev_private;
 	struct drm_gem_shmem_object *shmem;
 	struct panfrost_gem_object *bo;
+	int ret;
 
 	/* Round up heap allocations to 2MB to keep fault handling simple */
 	if (flags & PANFROST_BO_HEAP)
@@ -278,13 +469,81 @@ panfrost_gem_create(struct drm_device *dev, size_t size, u32 flags)
 	if (IS_ERR(shmem))
 		return ERR_CAST(shmem);
 
+	if (pfdev->gemfs && size >= SZ_2M) {
+		ret = panfrost_gem_use_gemfs(pfdev, &shmem->base);
+		if (ret) {
+			drm_gem_object_put(&shmem->base);
+			return ERR_PTR(ret);
+		}
+	}
+
 	bo = to_panfrost_bo(&shmem->base);
 	bo->noexec = !!(flags & PANFROST_BO_NOEXEC);
 	bo->is_heap = !!(flags & PANFROST_BO_HEAP);
 
+	/* Heap BOs are grown by the fault handler and never evicted */
+	if (!bo->is_heap) {
+		mutex_lock(&pfdev->shrinker_lock);
+		list_add_tail(&bo->lru_node, &pfdev->evict_list);
+		mutex_unlock(&pfdev->shrinker_lock);
+	}
+
 	return bo;
 }
 
+/**
+ * panfrost_gem_restore() - Bring an evicted BO back before a job uses it
+ * @bo: BO referenced by a job being submitted
+ *
+ * Repopulates the pages from shmem (swapping them in as needed) and
+ * re-creates the GPU mappings the shrinker tore down. The caller must have
+ * raised bo->gpu_usecount, so that the BO can't be evicted again before
+ * the job is done with it.
+ *
+ * bo->evicted is only tested under bo->mappings.lock, which the shrinker
+ * holds across a whole eviction. Either the eviction has completed and the
+ * BO is restored here, or the shrinker sees the raised use count and skips
+ * the BO.
+ */
+int panfrost_gem_restore(struct panfrost_gem_object *bo)
+{
+	struct panfrost_gem_mapping *mapping;
+	int ret = 0;
+
+	mutex_lock(&bo->mappings.lock);
+	if (bo->evicted) {
+		list_for_each_entry(mapping, &bo->mappings.list, node) {
+			if (mapping->active)
+				continue;
+
+			ret = panfrost_mmu_map(mapping);
+			if (ret)
+				break;
+		}
+		if (!ret)
+			bo->evicted = false;
+	}
+	mutex_unlock(&bo->mappings.lock);
+
+	return ret;
+}
+
+/* Move the BOs of a job being submitted to the tail of the eviction LRU */
+void panfrost_gem_mark_used(struct panfrost_device *pfdev,
+			    struct drm_gem_object **bos, unsigned int count)
+{
+	unsigned int i;
+
+	mutex_lock(&pfdev->shrinker_lock);
+	for (i = 0; i < count; i++) {
+		struct panfrost_gem_object *bo = to_panfrost_bo(bos[i]);
+
+		if (!list_empty(&bo->lru_node))
+			list_move_tail(&bo->lru_node, &pfdev->evict_list);
+	}
+	mutex_unlock(&pfdev->shrinker_lock);
+}
+
 struct drm_gem_object *
 panfrost_gem_prime_import_sg_table(struct drm_device *dev,
 				   struct dma_buf_attachment *attach,
@@ -7,6 +7,7 @@
 #include <drm/drm_gem_shmem_helper.h>
 #include <drm/drm_mm.h>
 
+struct panfrost_device;
 struct panfrost_mmu;
 
 struct panfrost_gem_object {
@@ -41,6 +42,18 @@ struct panfrost_gem_object {
 	 */
 	size_t heap_rss_size;
 
+	/* Node in pfdev->evict_list, protected by pfdev->shrinker_lock */
+	struct list_head lru_node;
+
+	/*
+	 * Pages released to shmem and GPU mappings torn down, set under
+	 * both mappings.lock and the resv lock.
+	 */
+	bool evicted;
+
+	/* dma_buf_ino() of the last dma-buf exported from this BO, for traces */
+	unsigned long exp_ino;
+
 	bool noexec		:1;
 	bool is_heap		:1;
 };
@@ -85,6 +98,12 @@ panfrost_gem_mapping_get(struct panfrost_gem_object *bo,
 			 struct panfrost_file_priv *priv);
 void panfrost_gem_mapping_put(struct panfrost_gem_mapping *mapping);
 void panfrost_gem_teardown_mappings_locked(struct panfrost_gem_object *bo);
+int panfrost_gem_restore(struct panfrost_gem_object *bo);
+void panfrost_gem_mark_used(struct panfrost_device *pfdev,
+			    struct drm_gem_object **bos, unsigned int count);
+
+void panfrost_gemfs_init(struct panfrost_device *pfdev);
+void panfrost_gemfs_fini(struct panfrost_device *pfdev);
 
 int panfrost_gem_shrinker_init(struct drm_device *dev);
 void panfrost_gem_shrinker_cleanup(struct drm_device *dev);
@@ -6,20 +6,39 @@
  * Author: Rob Clark <robdclark@gmail.com>
  */
 
+#include <linux/dma-mapping.h>
 #include <linux/list.h>
+#include <linux/slab.h>
 
 #include <drm/drm_device.h>
 #include <drm/drm_gem_shmem_helper.h>
+#include <drm/panfrost_drm.h>
 
 #include "panfrost_device.h"
 #include "panfrost_gem.h"
 #include "panfrost_mmu.h"
 
+/*
+ * Unlocked estimate: resident, idle, not purgeable and with no CPU
+ * users, i.e. the only page reference left is the one backing the GPU
+ * mappings.
+ */
+static bool panfrost_gem_is_evictable(struct panfrost_gem_object *bo)
+{
+	struct drm_gem_shmem_object *shmem = &bo->base;
+
+	return shmem->sgt && shmem->pages_use_count == 1 &&
+	       shmem->madv == PANFROST_MADV_WILLNEED &&
+	       !shmem->base.import_attach &&
+	       !atomic_read(&bo->gpu_usecount);
+}
+
 static unsigned long
 panfrost_gem_shrinker_count(struct shrinker *shrinker, struct shrink_control *sc)
 {
 	struct panfrost_device *pfdev = shrinker->private_data;
 	struct drm_gem_shmem_object *shmem;
+	struct panfrost_gem_object *bo;
 	unsigned long count = 0;
 
 	if (!mutex_trylock(&pfdev->shrinker_lock))
@@ -30,6 +49,11 @@ panfrost_gem_shrinker_count(struct shrinker *shrinker, struct shrink_control *sc
 			count += shmem->base.size >> PAGE_SHIFT;
 	}
 
+	list_for_each_entry(bo, &pfdev->evict_list, lru_node) {
+		if (panfrost_gem_is_evictable(bo))
+			count += bo->base.base.size >> PAGE_SHIFT;
+	}
+
 	mutex_unlock(&pfdev->shrinker_lock);
 
 	return count;
@@ -61,12 +85,58 @@ static bool panfrost_gem_purge(struct drm_gem_object *obj)
 	return ret;
 }
 
+/*
+ * Tear the GPU mappings down and hand the pages back to shmem, which can
+ * then swap them out. panfrost_gem_restore() undoes this on the next
+ * submit referencing the BO.
+ */
+static bool panfrost_gem_evict(struct panfrost_gem_object *bo)
+{
+	struct drm_gem_shmem_object *shmem = &bo->base;
+	struct drm_gem_object *obj = &shmem->base;
+	struct panfrost_gem_mapping *mapping;
+	bool ret = false;
+
+	if (!mutex_trylock(&bo->mappings.lock))
+		return false;
+
+	if (!dma_resv_trylock(obj->resv))
+		goto unlock_mappings;
+
+	if (bo->evicted || !panfrost_gem_is_evictable(bo))
+		goto unlock_resv;
+
+	list_for_each_entry(mapping, &bo->mappings.list, node) {
+		if (mapping->active)
+			panfrost_mmu_unmap(mapping);
+	}
+
+	dma_unmap_sgtable(obj->dev->dev, shmem->sgt, DMA_BIDIRECTIONAL, 0);
+	sg_free_table(shmem->sgt);
+	kfree(shmem->sgt);
+	shmem->sgt = NULL;
+
+	/* The GPU may have written to the pages, don't let them be dropped */
+	shmem->pages_mark_dirty_on_put = true;
+	drm_gem_shmem_put_pages(shmem);
+
+	bo->evicted = true;
+	ret = true;
+
+unlock_resv:
+	dma_resv_unlock(obj->resv);
+unlock_mappings:
+	mutex_unlock(&bo->mappings.lock);
+	return ret;
+}
+
 static unsigned long
 panfrost_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 {
 	struct panfrost_device *pfdev = shrinker->private_data;
 	struct drm_gem_shmem_object *shmem, *tmp;
-	unsigned long freed = 0;
+	struct panfrost_gem_object *bo;
+	unsigned long freed = 0, evicted = 0;
 
 	if (!mutex_trylock(&pfdev->shrinker_lock))
 		return SHRINK_STOP;
@@ -81,12 +151,22 @@ panfrost_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 		}
 	}
 
+	/* Then swap out idle BOs, least recently submitted first */
+	list_for_each_entry(bo, &pfdev->evict_list, lru_node) {
+		if (freed + evicted >= sc->nr_to_scan)
+			break;
+		if (panfrost_gem_evict(bo))
+			evicted += bo->base.base.size >> PAGE_SHIFT;
+	}
+
 	mutex_unlock(&pfdev->shrinker_lock);
 
 	if (freed > 0)
 		pr_info_ratelimited("Purging %lu bytes\n", freed << PAGE_SHIFT);
+	if (evicted > 0)
+		pr_debug_ratelimited("Evicting %lu bytes\n", evicted << PAGE_SHIFT);
 
-	return freed;
+	return freed + evicted;
 }
 
 /**
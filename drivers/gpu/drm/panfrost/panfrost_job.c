@@ -7,6 +7,10 @@
 #include <linux/iopoll.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/sched.h>
+#include <linux/sort.h>
+#include <linux/sysfs.h>
+#include <linux/dma-buf.h>
 #include <linux/dma-resv.h>
 #include <drm/gpu_scheduler.h>
 #include <drm/panfrost_drm.h>
@@ -21,22 +25,39 @@
 #include "panfrost_gpu.h"
 #include "panfrost_mmu.h"
 #include "panfrost_dump.h"
+#include "panfrost_perfcnt.h"
+#include "panfrost_trace.h"
 
 #define JOB_TIMEOUT_MS 500
 
 #define job_write(dev, reg, data) writel(data, dev->iomem + (reg))
 #define job_read(dev, reg) readl(dev->iomem + (reg))
 
+static unsigned int preempt_threshold_us;
+MODULE_PARM_DESC(preempt_threshold_us,
+		 "Soft-stop lower priority jobs running for longer than this when a higher priority job is queued (0 = disabled)");
+module_param(preempt_threshold_us, uint, 0644);
+
 struct panfrost_queue_state {
 	struct drm_gpu_scheduler sched;
 	u64 fence_context;
 	u64 emit_seqno;
 };
 
+/* log2(us) buckets, the last one catches everything above 2^14us */
+#define PANFROST_FENCE_LATENCY_BUCKETS	16
+
 struct panfrost_job_slot {
 	struct panfrost_queue_state queue[NUM_JOB_SLOTS];
 	spinlock_t job_lock;
 	int irq;
+
+	/* Time the hard IRQ handler saw the job interrupt, 0 if not in an
+	 * IRQ cycle. Protected by job_lock outside of the hard handler.
+	 */
+	ktime_t irq_time;
+	/* IRQ to fence signal latency histogram, protected by job_lock */
+	u32 signal_latency[PANFROST_FENCE_LATENCY_BUCKETS];
 };
 
 static struct panfrost_job *
@@ -80,9 +101,19 @@ static const char *panfrost_fence_get_timeline_name(struct dma_fence *fence)
 	}
 }
 
+static void panfrost_fence_set_deadline(struct dma_fence *fence,
+					ktime_t deadline)
+{
+	struct panfrost_fence *f = to_panfrost_fence(fence);
+	struct panfrost_device *pfdev = f->dev->dev_private;
+
+	panfrost_devfreq_set_deadline(&pfdev->pfdevfreq, deadline);
+}
+
 static const struct dma_fence_ops panfrost_fence_ops = {
 	.get_driver_name = panfrost_fence_get_driver_name,
 	.get_timeline_name = panfrost_fence_get_timeline_name,
+	.set_deadline = panfrost_fence_set_deadline,
 };
 
 static struct dma_fence *panfrost_fence_create(struct panfrost_device *pfdev, int js_num)
@@ -194,6 +225,43 @@ panfrost_enqueue_job(struct panfrost_device *pfdev, int slot,
 	return 1;
 }
 
+/*
+ * Soft-stop the job running on @js if it belongs to a lower priority context
+ * and has been hogging the slot for long enough. The JM stops it at the next
+ * job boundary, at which point it is reported as STOPPED and requeued behind
+ * @job by panfrost_job_handle_err(). Must be called with job_lock held, after
+ * @job has been queued in the _NEXT registers.
+ */
+static void panfrost_job_try_preempt(struct panfrost_device *pfdev, int js,
+				     struct panfrost_job *job)
+{
+	struct panfrost_job *victim = pfdev->jobs[js][0];
+	unsigned int threshold_us = READ_ONCE(preempt_threshold_us);
+	u32 cmd;
+
+	/* Without chain disambiguation we could end up stopping @job itself */
+	if (!threshold_us ||
+	    !panfrost_has_hw_feature(pfdev, HW_FEATURE_JOBCHAIN_DISAMBIGUATION))
+		return;
+
+	if (!victim || victim == job || victim->preempted)
+		return;
+
+	/* Lower enum values are higher priorities */
+	if (job->base.s_priority >= victim->base.s_priority)
+		return;
+
+	if (ktime_us_delta(ktime_get(), victim->hw_start) < threshold_us)
+		return;
+
+	victim->preempted = true;
+	cmd = panfrost_get_job_chain_flag(victim) ?
+	      JS_COMMAND_SOFT_STOP_1 : JS_COMMAND_SOFT_STOP_0;
+	job_write(pfdev, JS_COMMAND(js), cmd);
+	dev_dbg(pfdev->dev, "JS: Preempting atom %p on js[%d] for atom %p",
+		victim, js, job);
+}
+
 static void panfrost_job_hw_submit(struct panfrost_job *job, int js)
 {
 	struct panfrost_device *pfdev = job->pfdev;
@@ -250,10 +318,15 @@ static void panfrost_job_hw_submit(struct panfrost_job *job, int js)
 			job->start_cycles = panfrost_cycle_counter_read(pfdev);
 		}
 
+		job->hw_start = ktime_get();
+		job->preempted = false;
 		job_write(pfdev, JS_COMMAND_NEXT(js), JS_COMMAND_START);
 		dev_dbg(pfdev->dev,
 			"JS: Submitting atom %p to js[%d][%d] with head=0x%llx AS %d",
 			job, js, subslot, jc_head, cfg & 0xf);
+
+		if (subslot)
+			panfrost_job_try_preempt(pfdev, js, job);
 	}
 	spin_unlock(&pfdev->js->job_lock);
 }
@@ -289,16 +362,13 @@ static void panfrost_attach_object_fences(struct drm_gem_object **bos,
 		dma_resv_add_fence(bos[i]->resv, fence, DMA_RESV_USAGE_WRITE);
 }
 
-int panfrost_job_push(struct panfrost_job *job)
+static void panfrost_job_requeue_work(struct work_struct *work);
+
+/* Called with the reservations of all of job->bos held */
+static int panfrost_job_push_locked(struct panfrost_job *job)
 {
 	struct panfrost_device *pfdev = job->pfdev;
-	struct ww_acquire_ctx acquire_ctx;
-	int ret = 0;
-
-	ret = drm_gem_lock_reservations(job->bos, job->bo_count,
-					    &acquire_ctx);
-	if (ret)
-		return ret;
+	int ret;
 
 	mutex_lock(&pfdev->sched_lock);
 	drm_sched_job_arm(&job->base);
@@ -309,11 +379,12 @@ int panfrost_job_push(struct panfrost_job *job)
 					     &job->base);
 	if (ret) {
 		mutex_unlock(&pfdev->sched_lock);
-		goto unlock;
+		return ret;
 	}
 
 	kref_get(&job->refcount); /* put by scheduler job completion */
 
+	INIT_WORK(&job->requeue_work, panfrost_job_requeue_work);
 	drm_sched_entity_push_job(&job->base);
 
 	mutex_unlock(&pfdev->sched_lock);
@@ -321,12 +392,127 @@ int panfrost_job_push(struct panfrost_job *job)
 	panfrost_attach_object_fences(job->bos, job->bo_count,
 				      job->render_done_fence);
 
-unlock:
-	drm_gem_unlock_reservations(job->bos, job->bo_count, &acquire_ctx);
+	return 0;
+}
+
+/* Make jobs[index] wait for the jobs of its batch named in batch_deps */
+static int panfrost_job_add_batch_deps(struct panfrost_job **jobs,
+				       unsigned int index)
+{
+	struct panfrost_job *job = jobs[index];
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < index; i++) {
+		if (!(job->batch_deps & BIT_ULL(i)))
+			continue;
+
+		ret = drm_sched_job_add_dependency(&job->base,
+				dma_fence_get(jobs[i]->render_done_fence));
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int panfrost_bo_ptr_cmp(const void *a, const void *b)
+{
+	const struct drm_gem_object *x = *(const struct drm_gem_object **)a;
+	const struct drm_gem_object *y = *(const struct drm_gem_object **)b;
+
+	if (x < y)
+		return -1;
+	return x > y;
+}
+
+/**
+ * panfrost_job_push_batch() - Queue several jobs under one reservation lock
+ * @jobs: jobs to queue, in submission order
+ * @count: number of jobs
+ * @pushed: set to the number of jobs that were queued
+ *
+ * The reservations of the union of all the jobs' BOs are taken once, and
+ * the jobs are then pushed in order. A job sharing a BO with an earlier
+ * one in the batch picks up that job's fence as an implicit dependency,
+ * and a job waiting on the out-sync of an earlier one waits for that
+ * job's fence, exactly as if they had been submitted one at a time.
+ *
+ * On error, jobs[0..*pushed - 1] have been queued and the rest have not.
+ */
+int panfrost_job_push_batch(struct panfrost_job **jobs, unsigned int count,
+			    unsigned int *pushed)
+{
+	struct ww_acquire_ctx acquire_ctx;
+	struct drm_gem_object **bos;
+	unsigned int i, bo_count = 0;
+	size_t j, n = 0, total = 0;
+	int ret;
+
+	*pushed = 0;
+
+	/* A single job locks its own BO array, there is nothing to merge */
+	if (count == 1) {
+		bos = jobs[0]->bos;
+		bo_count = jobs[0]->bo_count;
+		goto lock;
+	}
+
+	for (i = 0; i < count; i++)
+		total += jobs[i]->bo_count;
+
+	bos = kvmalloc_array(total, sizeof(*bos), GFP_KERNEL);
+	if (!bos)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		memcpy(&bos[n], jobs[i]->bos, jobs[i]->bo_count * sizeof(*bos));
+		n += jobs[i]->bo_count;
+	}
+
+	/*
+	 * ww_mutex doesn't allow taking the same lock twice in one ctx.
+	 * The BO counts come from userspace, so sort rather than compare
+	 * every pair. The locking order doesn't matter to ww_mutex.
+	 */
+	sort(bos, total, sizeof(*bos), panfrost_bo_ptr_cmp, NULL);
+	for (j = 0; j < total; j++) {
+		if (!bo_count || bos[bo_count - 1] != bos[j])
+			bos[bo_count++] = bos[j];
+	}
+
+lock:
+	ret = drm_gem_lock_reservations(bos, bo_count, &acquire_ctx);
+	if (ret)
+		goto out_free;
+
+	for (i = 0; i < count; i++) {
+		ret = panfrost_job_add_batch_deps(jobs, i);
+		if (ret)
+			break;
+
+		ret = panfrost_job_push_locked(jobs[i]);
+		if (ret)
+			break;
+		(*pushed)++;
+	}
+
+	drm_gem_unlock_reservations(bos, bo_count, &acquire_ctx);
+
+out_free:
+	if (count > 1)
+		kvfree(bos);
 
 	return ret;
 }
 
+int panfrost_job_push(struct panfrost_job *job)
+{
+	unsigned int pushed;
+
+	return panfrost_job_push_batch(&job, 1, &pushed);
+}
+
 static void panfrost_job_cleanup(struct kref *ref)
 {
 	struct panfrost_job *job = container_of(ref, struct panfrost_job,
@@ -371,6 +557,28 @@ static void panfrost_job_free(struct drm_sched_job *sched_job)
 	panfrost_job_put(job);
 }
 
+/*
+ * Name the dma-bufs a job uses, so its panfrost_job_signal event can be tied
+ * to the devices the buffers come from or go to.
+ */
+static void panfrost_job_trace_bos(struct panfrost_job *job)
+{
+	unsigned int i;
+
+	for (i = 0; i < job->bo_count; i++) {
+		struct drm_gem_object *obj = job->bos[i];
+		unsigned long ino;
+
+		if (obj->import_attach)
+			ino = dma_buf_ino(obj->import_attach->dmabuf);
+		else
+			ino = to_panfrost_bo(obj)->exp_ino;
+
+		if (ino)
+			trace_panfrost_job_bo(job, ino);
+	}
+}
+
 static struct dma_fence *panfrost_job_run(struct drm_sched_job *sched_job)
 {
 	struct panfrost_job *job = to_panfrost_job(sched_job);
@@ -395,6 +603,9 @@ static struct dma_fence *panfrost_job_run(struct drm_sched_job *sched_job)
 		dma_fence_put(job->done_fence);
 	job->done_fence = dma_fence_get(fence);
 
+	if (trace_panfrost_job_bo_enabled())
+		panfrost_job_trace_bos(job);
+
 	panfrost_job_hw_submit(job, slot);
 
 	return fence;
@@ -423,6 +634,59 @@ void panfrost_job_suspend_irq(struct panfrost_device *pfdev)
 	synchronize_irq(pfdev->js->irq);
 }
 
+static void panfrost_job_requeue_work(struct work_struct *work)
+{
+	struct panfrost_job *job = container_of(work, struct panfrost_job,
+						requeue_work);
+	struct panfrost_device *pfdev = job->pfdev;
+	int js = panfrost_job_get_slot(job);
+	bool requeue;
+	u32 cmd;
+
+	/* The job that preempted us is moving from _NEXT to the current slot,
+	 * wait for _NEXT to be free again. If that doesn't happen, leave it to
+	 * the timeout handler, the reset path resubmits jobs with a non-zero
+	 * ->jc.
+	 */
+	if (readl_poll_timeout(pfdev->iomem + JS_COMMAND_NEXT(js), cmd, !cmd,
+			       10, 10000))
+		goto out;
+
+	spin_lock(&pfdev->js->job_lock);
+	requeue = !atomic_read(&pfdev->reset.pending) && job->jc &&
+		  !dma_fence_is_signaled_locked(job->done_fence) &&
+		  pfdev->jobs[js][0] != job && !pfdev->jobs[js][1] &&
+		  (!pfdev->jobs[js][0] ||
+		   panfrost_get_job_chain_flag(pfdev->jobs[js][0]) !=
+		   panfrost_get_job_chain_flag(job));
+	spin_unlock(&pfdev->js->job_lock);
+
+	if (requeue)
+		panfrost_job_hw_submit(job, js);
+
+out:
+	panfrost_job_put(job);
+}
+
+static void panfrost_job_signal_fence(struct panfrost_device *pfdev,
+				      struct panfrost_job *job,
+				      unsigned int js)
+{
+	struct panfrost_job_slot *slot = pfdev->js;
+	s64 latency_ns = -1;
+
+	if (slot->irq_time) {
+		unsigned int bucket;
+
+		latency_ns = ktime_to_ns(ktime_sub(ktime_get(), slot->irq_time));
+		bucket = fls64(div_u64(latency_ns, NSEC_PER_USEC));
+		slot->signal_latency[min(bucket, PANFROST_FENCE_LATENCY_BUCKETS - 1)]++;
+	}
+
+	trace_panfrost_job_signal(job, js, latency_ns);
+	dma_fence_signal_locked(job->done_fence);
+}
+
 static void panfrost_job_handle_err(struct panfrost_device *pfdev,
 				    struct panfrost_job *job,
 				    unsigned int js)
@@ -450,6 +714,17 @@ static void panfrost_job_handle_err(struct panfrost_device *pfdev,
 
 		/* The job will be resumed, don't signal the fence */
 		signal_fence = false;
+
+		/* Preempted jobs are requeued from the scheduler workqueue,
+		 * which serializes us with ->run_job() on this slot. Other
+		 * stopped jobs are resubmitted by the reset path.
+		 */
+		if (job->preempted) {
+			job->preempted = false;
+			kref_get(&job->refcount);
+			queue_work(pfdev->js->queue[js].sched.submit_wq,
+				   &job->requeue_work);
+		}
 	} else if (js_status == DRM_PANFROST_EXCEPTION_TERMINATED) {
 		/* Job has been hard-stopped, flag it as canceled */
 		dma_fence_set_error(job->done_fence, -ECANCELED);
@@ -467,7 +742,7 @@ static void panfrost_job_handle_err(struct panfrost_device *pfdev,
 	panfrost_devfreq_record_idle(&pfdev->pfdevfreq);
 
 	if (signal_fence)
-		dma_fence_signal_locked(job->done_fence);
+		panfrost_job_signal_fence(pfdev, job, js);
 
 	pm_runtime_put_autosuspend(pfdev->dev);
 
@@ -487,7 +762,7 @@ static void panfrost_job_handle_done(struct panfrost_device *pfdev,
 	panfrost_mmu_as_put(pfdev, job->mmu);
 	panfrost_devfreq_record_idle(&pfdev->pfdevfreq);
 
-	dma_fence_signal_locked(job->done_fence);
+	panfrost_job_signal_fence(pfdev, job, panfrost_job_get_slot(job));
 	pm_runtime_put_autosuspend(pfdev->dev);
 }
 
@@ -703,7 +978,9 @@ panfrost_reset(struct panfrost_device *pfdev,
 	spin_unlock(&pfdev->js->job_lock);
 
 	/* Proceed with reset now. */
+	panfrost_perfcnt_suspend(pfdev);
 	panfrost_device_reset(pfdev);
+	panfrost_perfcnt_resume(pfdev);
 
 	/* panfrost_device_reset() unmasks job interrupts, but we want to
 	 * keep them masked a bit longer.
@@ -803,6 +1080,10 @@ static irqreturn_t panfrost_job_irq_handler_thread(int irq, void *data)
 
 	panfrost_job_handle_irqs(pfdev);
 
+	spin_lock(&pfdev->js->job_lock);
+	pfdev->js->irq_time = 0;
+	spin_unlock(&pfdev->js->job_lock);
+
 	/* Enable interrupts only if we're not about to get suspended */
 	if (!test_bit(PANFROST_COMP_BIT_JOB, pfdev->is_suspended))
 		job_write(pfdev, JOB_INT_MASK,
@@ -824,6 +1105,12 @@ static irqreturn_t panfrost_job_irq_handler(int irq, void *data)
 	if (!status)
 		return IRQ_NONE;
 
+	/* The thread is woken with the interrupt masked, so there's no
+	 * concurrent update of ->irq_time until it's done with it.
+	 */
+	pfdev->js->irq_time = ktime_get();
+	trace_panfrost_job_irq(status);
+
 	job_write(pfdev, JOB_INT_MASK, 0);
 	return IRQ_WAKE_THREAD;
 }
@@ -909,17 +1196,49 @@ void panfrost_job_fini(struct panfrost_device *pfdev)
 	destroy_workqueue(pfdev->reset.wq);
 }
 
+ssize_t panfrost_job_latency_show(struct panfrost_device *pfdev, char *buf)
+{
+	u32 hist[PANFROST_FENCE_LATENCY_BUCKETS];
+	ssize_t len = 0;
+	unsigned int i;
+
+	spin_lock(&pfdev->js->job_lock);
+	memcpy(hist, pfdev->js->signal_latency, sizeof(hist));
+	spin_unlock(&pfdev->js->job_lock);
+
+	for (i = 0; i < ARRAY_SIZE(hist); i++) {
+		if (i == ARRAY_SIZE(hist) - 1)
+			len += sysfs_emit_at(buf, len, ">=%uus: %u\n",
+					     1U << (i - 1), hist[i]);
+		else
+			len += sysfs_emit_at(buf, len, "<%uus: %u\n",
+					     1U << i, hist[i]);
+	}
+
+	return len;
+}
+
 int panfrost_job_open(struct panfrost_file_priv *panfrost_priv)
 {
 	struct panfrost_device *pfdev = panfrost_priv->pfdev;
 	struct panfrost_job_slot *js = pfdev->js;
 	struct drm_gpu_scheduler *sched;
+	enum drm_sched_priority priority = DRM_SCHED_PRIORITY_NORMAL;
 	int ret, i;
 
+	/* There's no uAPI to pick a context priority yet, so inherit it from
+	 * the scheduling policy of the opener. Raising it requires
+	 * CAP_SYS_NICE already, which is what we want for HIGH.
+	 */
+	if (task_nice(current) < 0)
+		priority = DRM_SCHED_PRIORITY_HIGH;
+	else if (task_nice(current) > 0)
+		priority = DRM_SCHED_PRIORITY_LOW;
+
 	for (i = 0; i < NUM_JOB_SLOTS; i++) {
 		sched = &js->queue[i].sched;
 		ret = drm_sched_entity_init(&panfrost_priv->sched_entity[i],
-					    DRM_SCHED_PRIORITY_NORMAL, &sched,
+					    priority, &sched,
 					    1, NULL);
 		if (WARN_ON(ret))
 			return ret;
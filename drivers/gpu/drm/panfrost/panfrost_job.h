@@ -33,10 +33,19 @@ struct panfrost_job {
 	/* Fence to be signaled by drm-sched once its done with the job */
 	struct dma_fence *render_done_fence;
 
+	/* Earlier jobs of the same batch to wait for, one bit per index */
+	u64 batch_deps;
+
 	struct panfrost_engine_usage *engine_usage;
 	bool is_profiled;
 	ktime_t start_time;
 	u64 start_cycles;
+
+	/* Time the job was handed to the JM, used to pick preemption victims */
+	ktime_t hw_start;
+	/* Soft-stopped to let a higher priority job run, resume on STOPPED */
+	bool preempted;
+	struct work_struct requeue_work;
 };
 
 int panfrost_job_init(struct panfrost_device *pfdev);
@@ -45,9 +54,12 @@ int panfrost_job_open(struct panfrost_file_priv *panfrost_priv);
 void panfrost_job_close(struct panfrost_file_priv *panfrost_priv);
 int panfrost_job_get_slot(struct panfrost_job *job);
 int panfrost_job_push(struct panfrost_job *job);
+int panfrost_job_push_batch(struct panfrost_job **jobs, unsigned int count,
+			    unsigned int *pushed);
 void panfrost_job_put(struct panfrost_job *job);
 void panfrost_job_enable_interrupts(struct panfrost_device *pfdev);
 void panfrost_job_suspend_irq(struct panfrost_device *pfdev);
 int panfrost_job_is_idle(struct panfrost_device *pfdev);
+ssize_t panfrost_job_latency_show(struct panfrost_device *pfdev, char *buf);
 
 #endif
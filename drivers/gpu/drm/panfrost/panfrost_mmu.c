@@ -293,7 +293,6 @@ static int mmu_map_sg(struct panfrost_device *pfdev, struct panfrost_mmu *mmu,
 	unsigned int count;
 	struct scatterlist *sgl;
 	struct io_pgtable_ops *ops = mmu->pgtbl_ops;
-	u64 start_iova = iova;
 
 	for_each_sgtable_dma_sg(sgt, sgl, count) {
 		unsigned long paddr = sg_dma_address(sgl);
@@ -315,8 +314,6 @@ static int mmu_map_sg(struct panfrost_device *pfdev, struct panfrost_mmu *mmu,
 		}
 	}
 
-	panfrost_mmu_flush_range(pfdev, mmu, start_iova, iova - start_iova);
-
 	return 0;
 }
 
@@ -326,6 +323,7 @@ int panfrost_mmu_map(struct panfrost_gem_mapping *mapping)
 	struct drm_gem_shmem_object *shmem = &bo->base;
 	struct drm_gem_object *obj = &shmem->base;
 	struct panfrost_device *pfdev = to_panfrost_device(obj->dev);
+	u64 iova = mapping->mmnode.start << PAGE_SHIFT;
 	struct sg_table *sgt;
 	int prot = IOMMU_READ | IOMMU_WRITE;
 
@@ -339,8 +337,9 @@ int panfrost_mmu_map(struct panfrost_gem_mapping *mapping)
 	if (WARN_ON(IS_ERR(sgt)))
 		return PTR_ERR(sgt);
 
-	mmu_map_sg(pfdev, mapping->mmu, mapping->mmnode.start << PAGE_SHIFT,
-		   prot, sgt);
+	mmu_map_sg(pfdev, mapping->mmu, iova, prot, sgt);
+	panfrost_mmu_flush_range(pfdev, mapping->mmu, iova,
+				 mapping->mmnode.size << PAGE_SHIFT);
 	mapping->active = true;
 
 	return 0;
@@ -438,16 +437,101 @@ addr_to_mapping(struct panfrost_device *pfdev, int as, u64 addr)
 
 #define NUM_FAULT_PAGES (SZ_2M / PAGE_SIZE)
 
+/*
+ * Upper bound on the number of extra 2MB chunks mapped ahead of a heap
+ * fault. Growth follows the size already mapped, so a tiler heap that
+ * needs N chunks faults O(log N) times instead of N times.
+ */
+#define MAX_PREFAULT_CHUNKS 8
+
+static int panfrost_mmu_map_heap_chunk(struct panfrost_device *pfdev,
+				       struct panfrost_gem_mapping *bomapping,
+				       pgoff_t page_offset)
+{
+	struct panfrost_gem_object *bo = bomapping->obj;
+	struct page **pages = bo->base.pages;
+	struct address_space *mapping;
+	struct sg_table *sgt;
+	u64 addr;
+	int ret, i;
+
+	mapping = bo->base.base.filp->f_mapping;
+	mapping_set_unevictable(mapping);
+
+	for (i = page_offset; i < page_offset + NUM_FAULT_PAGES; i++) {
+		/* Can happen if the last fault only partially filled this
+		 * section of the pages array before failing. In that case
+		 * we skip already filled pages.
+		 */
+		if (pages[i])
+			continue;
+
+		pages[i] = shmem_read_mapping_page(mapping, i);
+		if (IS_ERR(pages[i])) {
+			ret = PTR_ERR(pages[i]);
+			pages[i] = NULL;
+			return ret;
+		}
+	}
+
+	sgt = &bo->sgts[page_offset / NUM_FAULT_PAGES];
+	ret = sg_alloc_table_from_pages(sgt, pages + page_offset,
+					NUM_FAULT_PAGES, 0, SZ_2M, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	ret = dma_map_sgtable(pfdev->dev, sgt, DMA_BIDIRECTIONAL, 0);
+	if (ret) {
+		sg_free_table(sgt);
+		return ret;
+	}
+
+	addr = (bomapping->mmnode.start + page_offset) << PAGE_SHIFT;
+	mmu_map_sg(pfdev, bomapping->mmu, addr,
+		   IOMMU_WRITE | IOMMU_READ | IOMMU_NOEXEC, sgt);
+
+	bomapping->active = true;
+	bo->heap_rss_size += SZ_2M;
+
+	return 0;
+}
+
+/* Returns the number of chunks mapped after the one at page_offset */
+static unsigned int panfrost_mmu_prefault_heap(struct panfrost_device *pfdev,
+					       struct panfrost_gem_mapping *bomapping,
+					       pgoff_t page_offset,
+					       unsigned int count)
+{
+	struct panfrost_gem_object *bo = bomapping->obj;
+	pgoff_t npages = bo->base.base.size >> PAGE_SHIFT;
+	unsigned int mapped = 0;
+
+	while (mapped < count) {
+		page_offset += NUM_FAULT_PAGES;
+		if (page_offset >= npages ||
+		    bo->sgts[page_offset / NUM_FAULT_PAGES].sgl)
+			break;
+
+		/* Best effort, the GPU faults again if it gets there */
+		if (panfrost_mmu_map_heap_chunk(pfdev, bomapping, page_offset))
+			break;
+
+		atomic64_inc(&bomapping->mmu->heap_prefaults);
+		mapped++;
+	}
+
+	return mapped;
+}
+
 static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
 				       u64 addr)
 {
-	int ret, i;
+	int ret;
 	struct panfrost_gem_mapping *bomapping;
 	struct panfrost_gem_object *bo;
-	struct address_space *mapping;
 	struct drm_gem_object *obj;
+	unsigned int prefault;
 	pgoff_t page_offset;
-	struct sg_table *sgt;
 	struct page **pages;
 
 	bomapping = addr_to_mapping(pfdev, as, addr);
@@ -491,49 +575,31 @@ static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
 		bo->base.pages = pages;
 		bo->base.pages_use_count = 1;
 	} else {
-		pages = bo->base.pages;
-		if (pages[page_offset]) {
-			/* Pages are already mapped, bail out. */
+		/*
+		 * Only a chunk with an sg table is mapped. A failed prefault
+		 * can leave the first pages of a chunk populated but unmapped,
+		 * panfrost_mmu_map_heap_chunk() skips those pages.
+		 */
+		if (bo->sgts[page_offset / NUM_FAULT_PAGES].sgl)
 			goto out;
-		}
 	}
 
-	mapping = bo->base.base.filp->f_mapping;
-	mapping_set_unevictable(mapping);
-
-	for (i = page_offset; i < page_offset + NUM_FAULT_PAGES; i++) {
-		/* Can happen if the last fault only partially filled this
-		 * section of the pages array before failing. In that case
-		 * we skip already filled pages.
-		 */
-		if (pages[i])
-			continue;
-
-		pages[i] = shmem_read_mapping_page(mapping, i);
-		if (IS_ERR(pages[i])) {
-			ret = PTR_ERR(pages[i]);
-			pages[i] = NULL;
-			goto err_unlock;
-		}
-	}
+	prefault = min_t(unsigned int, bo->heap_rss_size / SZ_2M,
+			 MAX_PREFAULT_CHUNKS);
 
-	sgt = &bo->sgts[page_offset / (SZ_2M / PAGE_SIZE)];
-	ret = sg_alloc_table_from_pages(sgt, pages + page_offset,
-					NUM_FAULT_PAGES, 0, SZ_2M, GFP_KERNEL);
+	ret = panfrost_mmu_map_heap_chunk(pfdev, bomapping, page_offset);
 	if (ret)
 		goto err_unlock;
 
-	ret = dma_map_sgtable(pfdev->dev, sgt, DMA_BIDIRECTIONAL, 0);
-	if (ret)
-		goto err_map;
-
-	mmu_map_sg(pfdev, bomapping->mmu, addr,
-		   IOMMU_WRITE | IOMMU_READ | IOMMU_NOEXEC, sgt);
+	atomic64_inc(&bomapping->mmu->heap_faults);
+	dev_dbg(pfdev->dev, "mapped page fault @ AS%d %llx", as, addr);
 
-	bomapping->active = true;
-	bo->heap_rss_size += SZ_2M;
+	prefault = panfrost_mmu_prefault_heap(pfdev, bomapping, page_offset,
+					      prefault);
 
-	dev_dbg(pfdev->dev, "mapped page fault @ AS%d %llx", as, addr);
+	/* One flush covers the faulting chunk and the ones mapped ahead */
+	panfrost_mmu_flush_range(pfdev, bomapping->mmu, addr,
+				 (u64)(prefault + 1) * SZ_2M);
 
 out:
 	dma_resv_unlock(obj->resv);
@@ -542,8 +608,6 @@ static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
 
 	return 0;
 
-err_map:
-	sg_free_table(sgt);
 err_unlock:
 	dma_resv_unlock(obj->resv);
 err_bo:
@@ -2,11 +2,14 @@
 /* Copyright 2019 Collabora Ltd */
 
 #include <linux/completion.h>
+#include <linux/hrtimer.h>
 #include <linux/iopoll.h>
 #include <linux/iosys-map.h>
+#include <linux/module.h>
 #include <linux/pm_runtime.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/workqueue.h>
 
 #include <drm/drm_file.h>
 #include <drm/drm_gem_shmem_helper.h>
@@ -25,19 +28,130 @@
 #define BYTES_PER_COUNTER		4
 #define BLOCKS_PER_COREGROUP		8
 #define V4_SHADERS_PER_COREGROUP	4
+#define HEADER_COUNTERS_PER_BLOCK	4
+#define MIN_SAMPLE_PERIOD_US		100
+#define SAMPLE_TIMEOUT_MS		1000
+
+static unsigned int sample_period_us;
+module_param(sample_period_us, uint, 0644);
+MODULE_PARM_DESC(sample_period_us,
+		 "Perfcnt background sampling period in us, 0 to sample on dump only (default = 0)");
 
 struct panfrost_perfcnt {
+	struct panfrost_device *pfdev;
 	struct panfrost_gem_mapping *mapping;
 	size_t bosize;
 	void *buf;
 	struct panfrost_file_priv *user;
 	struct mutex lock;
 	struct completion dump_comp;
+	unsigned int counterset;
+
+	/*
+	 * Background sampling: a timer triggers a sample every period and
+	 * the result is folded into acc, which a dump hands out and resets,
+	 * and is also appended to the userspace ring BO when there is one.
+	 * acc and ring are NULL when disabled, and are only set or cleared
+	 * under both lock and acc_lock.
+	 */
+	struct hrtimer timer;
+	ktime_t period;
+	ktime_t sample_start;
+	struct work_struct accum_work;
+	atomic_t sampling;
+	spinlock_t acc_lock;
+	u32 *acc;
+	u32 *snapshot;
+	struct drm_gem_object *ring_obj;
+	struct drm_panfrost_perfcnt_ring *ring;
+	size_t ring_record_size;
+	u32 ring_count;
+	u32 ring_head;
 };
 
+static void panfrost_perfcnt_start_sample(struct panfrost_device *pfdev)
+{
+	u64 gpuva = pfdev->perfcnt->mapping->mmnode.start << PAGE_SHIFT;
+
+	gpu_write(pfdev, GPU_PERFCNT_BASE_LO, lower_32_bits(gpuva));
+	gpu_write(pfdev, GPU_PERFCNT_BASE_HI, upper_32_bits(gpuva));
+	gpu_write(pfdev, GPU_INT_CLEAR,
+		  GPU_IRQ_CLEAN_CACHES_COMPLETED |
+		  GPU_IRQ_PERFCNT_SAMPLE_COMPLETED);
+	gpu_write(pfdev, GPU_CMD, GPU_CMD_PERFCNT_SAMPLE);
+}
+
+static enum hrtimer_restart panfrost_perfcnt_timer(struct hrtimer *timer)
+{
+	struct panfrost_perfcnt *perfcnt =
+		container_of(timer, struct panfrost_perfcnt, timer);
+	ktime_t now = ktime_get();
+
+	/*
+	 * Skip this period if the previous sample is still being folded,
+	 * unless it never completed, in which case it is issued again.
+	 */
+	if (!atomic_xchg(&perfcnt->sampling, 1) ||
+	    ktime_ms_delta(now, perfcnt->sample_start) > SAMPLE_TIMEOUT_MS) {
+		perfcnt->sample_start = now;
+		panfrost_perfcnt_start_sample(perfcnt->pfdev);
+	}
+
+	hrtimer_forward_now(timer, perfcnt->period);
+
+	return HRTIMER_RESTART;
+}
+
+static void panfrost_perfcnt_ring_push(struct panfrost_perfcnt *perfcnt,
+				       const u32 *sample)
+{
+	void *record = (void *)(perfcnt->ring + 1) +
+		       (perfcnt->ring_head % perfcnt->ring_count) *
+		       perfcnt->ring_record_size;
+	u64 timestamp = ktime_to_ns(perfcnt->sample_start);
+
+	/* head lives in user memory, only ever trust our own copy */
+	memcpy(record, &timestamp, sizeof(timestamp));
+	memcpy(record + sizeof(timestamp), sample, perfcnt->bosize);
+	wmb();
+	WRITE_ONCE(perfcnt->ring->head, ++perfcnt->ring_head);
+}
+
+static void panfrost_perfcnt_accum_work(struct work_struct *work)
+{
+	struct panfrost_perfcnt *perfcnt =
+		container_of(work, struct panfrost_perfcnt, accum_work);
+	unsigned int i, n = perfcnt->bosize / BYTES_PER_COUNTER;
+	const u32 *sample = perfcnt->buf;
+
+	/*
+	 * The hardware resets the counters on each sample, so they add up.
+	 * The block headers are not counters and are simply overwritten.
+	 */
+	spin_lock_irq(&perfcnt->acc_lock);
+	if (perfcnt->ring)
+		panfrost_perfcnt_ring_push(perfcnt, sample);
+	/* acc is gone if sampling was disabled while this one was in flight */
+	for (i = 0; perfcnt->acc && i < n; i++) {
+		if (i % COUNTERS_PER_BLOCK < HEADER_COUNTERS_PER_BLOCK)
+			perfcnt->acc[i] = sample[i];
+		else
+			perfcnt->acc[i] += sample[i];
+	}
+	spin_unlock_irq(&perfcnt->acc_lock);
+
+	atomic_set(&perfcnt->sampling, 0);
+}
+
 void panfrost_perfcnt_clean_cache_done(struct panfrost_device *pfdev)
 {
-	complete(&pfdev->perfcnt->dump_comp);
+	struct panfrost_perfcnt *perfcnt = pfdev->perfcnt;
+
+	/* Dumps wait on dump_comp only when background sampling is off */
+	if (atomic_read(&perfcnt->sampling))
+		queue_work(system_highpri_wq, &perfcnt->accum_work);
+	else
+		complete(&perfcnt->dump_comp);
 }
 
 void panfrost_perfcnt_sample_done(struct panfrost_device *pfdev)
@@ -45,19 +159,43 @@ void panfrost_perfcnt_sample_done(struct panfrost_device *pfdev)
 	gpu_write(pfdev, GPU_CMD, GPU_CMD_CLEAN_CACHES);
 }
 
+static void panfrost_perfcnt_hw_enable(struct panfrost_device *pfdev, u32 as)
+{
+	u32 cfg = GPU_PERFCNT_CFG_AS(as) |
+		  GPU_PERFCNT_CFG_MODE(GPU_PERFCNT_CFG_MODE_MANUAL);
+
+	/*
+	 * Bifrost GPUs have 2 set of counters, but we're only interested by
+	 * the first one for now.
+	 */
+	if (panfrost_model_is_bifrost(pfdev))
+		cfg |= GPU_PERFCNT_CFG_SETSEL(pfdev->perfcnt->counterset);
+
+	gpu_write(pfdev, GPU_PRFCNT_JM_EN, 0xffffffff);
+	gpu_write(pfdev, GPU_PRFCNT_SHADER_EN, 0xffffffff);
+	gpu_write(pfdev, GPU_PRFCNT_MMU_L2_EN, 0xffffffff);
+
+	/*
+	 * Due to PRLAM-8186 we need to disable the Tiler before we enable HW
+	 * counters.
+	 */
+	if (panfrost_has_hw_issue(pfdev, HW_ISSUE_8186))
+		gpu_write(pfdev, GPU_PRFCNT_TILER_EN, 0);
+	else
+		gpu_write(pfdev, GPU_PRFCNT_TILER_EN, 0xffffffff);
+
+	gpu_write(pfdev, GPU_PERFCNT_CFG, cfg);
+
+	if (panfrost_has_hw_issue(pfdev, HW_ISSUE_8186))
+		gpu_write(pfdev, GPU_PRFCNT_TILER_EN, 0xffffffff);
+}
+
 static int panfrost_perfcnt_dump_locked(struct panfrost_device *pfdev)
 {
-	u64 gpuva;
 	int ret;
 
 	reinit_completion(&pfdev->perfcnt->dump_comp);
-	gpuva = pfdev->perfcnt->mapping->mmnode.start << PAGE_SHIFT;
-	gpu_write(pfdev, GPU_PERFCNT_BASE_LO, lower_32_bits(gpuva));
-	gpu_write(pfdev, GPU_PERFCNT_BASE_HI, upper_32_bits(gpuva));
-	gpu_write(pfdev, GPU_INT_CLEAR,
-		  GPU_IRQ_CLEAN_CACHES_COMPLETED |
-		  GPU_IRQ_PERFCNT_SAMPLE_COMPLETED);
-	gpu_write(pfdev, GPU_CMD, GPU_CMD_PERFCNT_SAMPLE);
+	panfrost_perfcnt_start_sample(pfdev);
 	ret = wait_for_completion_interruptible_timeout(&pfdev->perfcnt->dump_comp,
 							msecs_to_jiffies(1000));
 	if (!ret)
@@ -68,15 +206,77 @@ static int panfrost_perfcnt_dump_locked(struct panfrost_device *pfdev)
 	return ret;
 }
 
+static struct drm_panfrost_perfcnt_ring *
+panfrost_perfcnt_ring_get(struct panfrost_perfcnt *perfcnt,
+			  struct drm_file *file_priv, u32 handle)
+{
+	struct drm_panfrost_perfcnt_ring *ring;
+	struct drm_gem_object *obj;
+	struct iosys_map map;
+	size_t count;
+	int ret;
+
+	obj = drm_gem_object_lookup(file_priv, handle);
+	if (!obj)
+		return ERR_PTR(-ENOENT);
+
+	perfcnt->ring_record_size = sizeof(u64) + perfcnt->bosize;
+	count = obj->size < sizeof(*ring) ? 0 :
+		(obj->size - sizeof(*ring)) / perfcnt->ring_record_size;
+	if (to_panfrost_bo(obj)->is_heap || !count || count > U32_MAX) {
+		ret = -EINVAL;
+		goto err_put;
+	}
+
+	/* The vmap also keeps the shrinker away from the pages */
+	ret = drm_gem_vmap_unlocked(obj, &map);
+	if (ret)
+		goto err_put;
+	if (map.is_iomem) {
+		ret = -EINVAL;
+		goto err_vunmap;
+	}
+
+	ring = map.vaddr;
+	ring->head = 0;
+	ring->count = count;
+	ring->record_size = perfcnt->ring_record_size;
+	ring->pad = 0;
+	perfcnt->ring_obj = obj;
+	perfcnt->ring_count = count;
+	perfcnt->ring_head = 0;
+
+	return ring;
+
+err_vunmap:
+	drm_gem_vunmap_unlocked(obj, &map);
+err_put:
+	drm_gem_object_put(obj);
+	return ERR_PTR(ret);
+}
+
+static void panfrost_perfcnt_ring_put(struct panfrost_perfcnt *perfcnt,
+				      struct drm_panfrost_perfcnt_ring *ring)
+{
+	struct iosys_map map = IOSYS_MAP_INIT_VADDR(ring);
+
+	drm_gem_vunmap_unlocked(perfcnt->ring_obj, &map);
+	drm_gem_object_put(perfcnt->ring_obj);
+	perfcnt->ring_obj = NULL;
+}
+
 static int panfrost_perfcnt_enable_locked(struct panfrost_device *pfdev,
 					  struct drm_file *file_priv,
-					  unsigned int counterset)
+					  unsigned int counterset,
+					  u32 ring_handle)
 {
 	struct panfrost_file_priv *user = file_priv->driver_priv;
 	struct panfrost_perfcnt *perfcnt = pfdev->perfcnt;
 	struct iosys_map map;
 	struct drm_gem_shmem_object *bo;
-	u32 cfg, as;
+	struct drm_panfrost_perfcnt_ring *ring = NULL;
+	u32 *acc = NULL;
+	u32 as;
 	int ret;
 
 	if (user == perfcnt->user)
@@ -84,6 +284,10 @@ static int panfrost_perfcnt_enable_locked(struct panfrost_device *pfdev,
 	else if (perfcnt->user)
 		return -EBUSY;
 
+	/* Only background sampling has anything to put in the ring */
+	if (ring_handle && !sample_period_us)
+		return -EINVAL;
+
 	ret = pm_runtime_get_sync(pfdev->dev);
 	if (ret < 0)
 		goto err_put_pm;
@@ -129,41 +333,52 @@ static int panfrost_perfcnt_enable_locked(struct panfrost_device *pfdev,
 	}
 
 	perfcnt->user = user;
+	perfcnt->counterset = counterset;
 
 	as = panfrost_mmu_as_get(pfdev, perfcnt->mapping->mmu);
-	cfg = GPU_PERFCNT_CFG_AS(as) |
-	      GPU_PERFCNT_CFG_MODE(GPU_PERFCNT_CFG_MODE_MANUAL);
-
-	/*
-	 * Bifrost GPUs have 2 set of counters, but we're only interested by
-	 * the first one for now.
-	 */
-	if (panfrost_model_is_bifrost(pfdev))
-		cfg |= GPU_PERFCNT_CFG_SETSEL(counterset);
-
-	gpu_write(pfdev, GPU_PRFCNT_JM_EN, 0xffffffff);
-	gpu_write(pfdev, GPU_PRFCNT_SHADER_EN, 0xffffffff);
-	gpu_write(pfdev, GPU_PRFCNT_MMU_L2_EN, 0xffffffff);
-
-	/*
-	 * Due to PRLAM-8186 we need to disable the Tiler before we enable HW
-	 * counters.
-	 */
-	if (panfrost_has_hw_issue(pfdev, HW_ISSUE_8186))
-		gpu_write(pfdev, GPU_PRFCNT_TILER_EN, 0);
-	else
-		gpu_write(pfdev, GPU_PRFCNT_TILER_EN, 0xffffffff);
-
-	gpu_write(pfdev, GPU_PERFCNT_CFG, cfg);
-
-	if (panfrost_has_hw_issue(pfdev, HW_ISSUE_8186))
-		gpu_write(pfdev, GPU_PRFCNT_TILER_EN, 0xffffffff);
+	panfrost_perfcnt_hw_enable(pfdev, as);
+
+	if (sample_period_us) {
+		acc = kvzalloc(perfcnt->bosize, GFP_KERNEL);
+		perfcnt->snapshot = kvmalloc(perfcnt->bosize, GFP_KERNEL);
+		if (!acc || !perfcnt->snapshot) {
+			ret = -ENOMEM;
+			goto err_free_acc;
+		}
+
+		if (ring_handle) {
+			ring = panfrost_perfcnt_ring_get(perfcnt, file_priv,
+							 ring_handle);
+			if (IS_ERR(ring)) {
+				ret = PTR_ERR(ring);
+				goto err_free_acc;
+			}
+		}
+
+		perfcnt->period = us_to_ktime(max(sample_period_us,
+						  MIN_SAMPLE_PERIOD_US));
+		atomic_set(&perfcnt->sampling, 0);
+		spin_lock_irq(&perfcnt->acc_lock);
+		perfcnt->acc = acc;
+		perfcnt->ring = ring;
+		hrtimer_start(&perfcnt->timer, perfcnt->period,
+			      HRTIMER_MODE_REL);
+		spin_unlock_irq(&perfcnt->acc_lock);
+	}
 
 	/* The BO ref is retained by the mapping. */
 	drm_gem_object_put(&bo->base);
 
 	return 0;
 
+err_free_acc:
+	kvfree(acc);
+	kvfree(perfcnt->snapshot);
+	perfcnt->snapshot = NULL;
+	gpu_write(pfdev, GPU_PERFCNT_CFG,
+		  GPU_PERFCNT_CFG_MODE(GPU_PERFCNT_CFG_MODE_OFF));
+	perfcnt->user = NULL;
+	panfrost_mmu_as_put(pfdev, perfcnt->mapping->mmu);
 err_vunmap:
 	drm_gem_vunmap_unlocked(&bo->base, &map);
 err_put_mapping:
@@ -187,6 +402,37 @@ static int panfrost_perfcnt_disable_locked(struct panfrost_device *pfdev,
 	if (user != perfcnt->user)
 		return -EINVAL;
 
+	if (perfcnt->acc) {
+		struct drm_panfrost_perfcnt_ring *ring;
+		u32 *acc;
+		int busy;
+
+		/*
+		 * Detach acc first, so neither a late sample nor a resume can
+		 * use it once the timer is gone.
+		 */
+		spin_lock_irq(&perfcnt->acc_lock);
+		acc = perfcnt->acc;
+		ring = perfcnt->ring;
+		perfcnt->acc = NULL;
+		perfcnt->ring = NULL;
+		spin_unlock_irq(&perfcnt->acc_lock);
+
+		hrtimer_cancel(&perfcnt->timer);
+		/* Let an in-flight sample land before tearing things down */
+		read_poll_timeout(atomic_read, busy, !busy, 100,
+				  SAMPLE_TIMEOUT_MS * USEC_PER_MSEC, false,
+				  &perfcnt->sampling);
+		synchronize_irq(pfdev->gpu_irq);
+		flush_work(&perfcnt->accum_work);
+		atomic_set(&perfcnt->sampling, 0);
+		kvfree(acc);
+		kvfree(perfcnt->snapshot);
+		perfcnt->snapshot = NULL;
+		if (ring)
+			panfrost_perfcnt_ring_put(perfcnt, ring);
+	}
+
 	gpu_write(pfdev, GPU_PRFCNT_JM_EN, 0x0);
 	gpu_write(pfdev, GPU_PRFCNT_SHADER_EN, 0x0);
 	gpu_write(pfdev, GPU_PRFCNT_MMU_L2_EN, 0x0);
@@ -223,10 +469,14 @@ int panfrost_ioctl_perfcnt_enable(struct drm_device *dev, void *data,
 	if (req->counterset > (panfrost_model_is_bifrost(pfdev) ? 1 : 0))
 		return -EINVAL;
 
+	if (req->pad)
+		return -EINVAL;
+
 	mutex_lock(&perfcnt->lock);
 	if (req->enable)
 		ret = panfrost_perfcnt_enable_locked(pfdev, file_priv,
-						     req->counterset);
+						     req->counterset,
+						     req->ring_handle);
 	else
 		ret = panfrost_perfcnt_disable_locked(pfdev, file_priv);
 	mutex_unlock(&perfcnt->lock);
@@ -253,6 +503,18 @@ int panfrost_ioctl_perfcnt_dump(struct drm_device *dev, void *data,
 		goto out;
 	}
 
+	if (perfcnt->acc) {
+		/* Hand out what the timer collected, without stalling the GPU */
+		spin_lock_irq(&perfcnt->acc_lock);
+		memcpy(perfcnt->snapshot, perfcnt->acc, perfcnt->bosize);
+		memset(perfcnt->acc, 0, perfcnt->bosize);
+		spin_unlock_irq(&perfcnt->acc_lock);
+
+		if (copy_to_user(user_ptr, perfcnt->snapshot, perfcnt->bosize))
+			ret = -EFAULT;
+		goto out;
+	}
+
 	ret = panfrost_perfcnt_dump_locked(pfdev);
 	if (ret)
 		goto out;
@@ -266,6 +528,30 @@ int panfrost_ioctl_perfcnt_dump(struct drm_device *dev, void *data,
 	return ret;
 }
 
+void panfrost_perfcnt_suspend(struct panfrost_device *pfdev)
+{
+	/* A sample in flight is lost with the GPU state, resume restarts */
+	hrtimer_cancel(&pfdev->perfcnt->timer);
+}
+
+void panfrost_perfcnt_resume(struct panfrost_device *pfdev)
+{
+	struct panfrost_perfcnt *perfcnt = pfdev->perfcnt;
+	unsigned long flags;
+	u32 as;
+
+	spin_lock_irqsave(&perfcnt->acc_lock, flags);
+	if (perfcnt->acc) {
+		/* The reset dropped both the counter setup and the AS */
+		as = panfrost_mmu_as_get(pfdev, perfcnt->mapping->mmu);
+		panfrost_perfcnt_hw_enable(pfdev, as);
+		atomic_set(&perfcnt->sampling, 0);
+		hrtimer_start(&perfcnt->timer, perfcnt->period,
+			      HRTIMER_MODE_REL);
+	}
+	spin_unlock_irqrestore(&perfcnt->acc_lock, flags);
+}
+
 void panfrost_perfcnt_close(struct drm_file *file_priv)
 {
 	struct panfrost_file_priv *pfile = file_priv->driver_priv;
@@ -320,6 +606,7 @@ int panfrost_perfcnt_init(struct panfrost_device *pfdev)
 	if (!perfcnt)
 		return -ENOMEM;
 
+	perfcnt->pfdev = pfdev;
 	perfcnt->bosize = size;
 
 	/* Start with everything disabled. */
@@ -332,6 +619,10 @@ int panfrost_perfcnt_init(struct panfrost_device *pfdev)
 
 	init_completion(&perfcnt->dump_comp);
 	mutex_init(&perfcnt->lock);
+	hrtimer_init(&perfcnt->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	perfcnt->timer.function = panfrost_perfcnt_timer;
+	INIT_WORK(&perfcnt->accum_work, panfrost_perfcnt_accum_work);
+	spin_lock_init(&perfcnt->acc_lock);
 	pfdev->perfcnt = perfcnt;
 
 	return 0;
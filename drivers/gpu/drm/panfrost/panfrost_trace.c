@@ -0,0 +1,6 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#include "panfrost_job.h"
+
+#define CREATE_TRACE_POINTS
+#include "panfrost_trace.h"
@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#if !defined(_PANFROST_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _PANFROST_TRACE_H_
+
+#include <linux/tracepoint.h>
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM panfrost
+#define TRACE_INCLUDE_FILE panfrost_trace
+
+TRACE_EVENT(panfrost_job_irq,
+	TP_PROTO(u32 status),
+	TP_ARGS(status),
+	TP_STRUCT__entry(
+		__field(u32, status)
+		),
+
+	TP_fast_assign(
+		__entry->status = status;
+		),
+
+	TP_printk("status=0x%x", __entry->status)
+);
+
+TRACE_EVENT(panfrost_job_signal,
+	TP_PROTO(struct panfrost_job *job, unsigned int js, s64 irq_latency_ns),
+	TP_ARGS(job, js, irq_latency_ns),
+	TP_STRUCT__entry(
+		__field(u64, context)
+		__field(u64, seqno)
+		__field(unsigned int, js)
+		__field(s64, irq_latency_ns)
+		),
+
+	TP_fast_assign(
+		__entry->context = job->done_fence->context;
+		__entry->seqno = job->done_fence->seqno;
+		__entry->js = js;
+		__entry->irq_latency_ns = irq_latency_ns;
+		),
+
+	TP_printk("context=%llu seqno=%llu js=%u irq_latency=%lldns",
+		  __entry->context, __entry->seqno, __entry->js,
+		  __entry->irq_latency_ns)
+);
+
+TRACE_EVENT(panfrost_job_bo,
+	TP_PROTO(struct panfrost_job *job, unsigned long dmabuf),
+	TP_ARGS(job, dmabuf),
+	TP_STRUCT__entry(
+		__field(u64, context)
+		__field(u64, seqno)
+		__field(unsigned long, dmabuf)
+		),
+
+	TP_fast_assign(
+		__entry->context = job->done_fence->context;
+		__entry->seqno = job->done_fence->seqno;
+		__entry->dmabuf = dmabuf;
+		),
+
+	TP_printk("context=%llu seqno=%llu dmabuf=%lu",
+		  __entry->context, __entry->seqno, __entry->dmabuf)
+);
+
+#endif
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH ../../drivers/gpu/drm/panfrost
+#include <trace/define_trace.h>
@@ -146,6 +146,8 @@
 
 #define DW_MIPI_NEEDS_PHY_CFG_CLK	BIT(0)
 #define DW_MIPI_NEEDS_GRF_CLK		BIT(1)
+/* the VOP can feed command mode panels over eDPI */
+#define DW_MIPI_EDPI_CMD_MODE		BIT(2)
 
 #define PX30_GRF_PD_VO_CON1		0x0438
 #define PX30_DSI_FORCETXSTOPMODE	(0xf << 7)
@@ -1443,6 +1445,7 @@ static int dw_mipi_dsi_rockchip_probe(struct platform_device *pdev)
 	dsi->dev = dev;
 	dsi->pdata.base = dsi->base;
 	dsi->pdata.max_data_lanes = dsi->cdata->max_data_lanes;
+	dsi->pdata.edpi_cmd_mode = dsi->cdata->flags & DW_MIPI_EDPI_CMD_MODE;
 	dsi->pdata.phy_ops = &dw_mipi_dsi_rockchip_phy_ops;
 	dsi->pdata.host_ops = &dw_mipi_dsi_rockchip_host_ops;
 	dsi->pdata.priv_data = dsi;
@@ -1657,6 +1660,7 @@ static const struct rockchip_dw_dsi_chip_data rk3568_chip_data[] = {
 					  RK3568_DSI0_FORCETXSTOPMODE |
 					  RK3568_DSI0_TURNDISABLE |
 					  RK3568_DSI0_FORCERXMODE),
+		.flags = DW_MIPI_EDPI_CMD_MODE,
 		.max_data_lanes = 4,
 	},
 	{
@@ -1666,6 +1670,7 @@ static const struct rockchip_dw_dsi_chip_data rk3568_chip_data[] = {
 					  RK3568_DSI1_FORCETXSTOPMODE |
 					  RK3568_DSI1_TURNDISABLE |
 					  RK3568_DSI1_FORCERXMODE),
+		.flags = DW_MIPI_EDPI_CMD_MODE,
 		.max_data_lanes = 4,
 	},
 	{ /* sentinel */ }
@@ -12,6 +12,8 @@
 #include <linux/regulator/consumer.h>
 
 #include <drm/bridge/dw_hdmi.h>
+#include <drm/drm_atomic.h>
+#include <drm/drm_bridge.h>
 #include <drm/drm_edid.h>
 #include <drm/drm_of.h>
 #include <drm/drm_probe_helper.h>
@@ -252,12 +254,21 @@ dw_hdmi_rockchip_mode_valid(struct dw_hdmi *dw_hdmi, void *data,
 {
 	struct rockchip_hdmi *hdmi = data;
 	const struct dw_hdmi_mpll_config *mpll_cfg = rockchip_mpll_cfg;
-	int pclk = mode->clock * 1000;
+	int clock = mode->clock;
 	bool exact_match = hdmi->plat_data->phy_force_vendor;
-	int i;
+	int pclk, i;
+
+	/*
+	 * YCbCr 4:2:0 modes are output with two pixels per clock, which
+	 * halves both the VOP dclk and the TMDS clock.
+	 */
+	if (hdmi->plat_data->ycbcr_420_allowed && drm_mode_is_420(info, mode))
+		clock /= 2;
+
+	pclk = clock * 1000;
 
 	if (hdmi->chip_data->max_tmds_clock &&
-	    mode->clock > hdmi->chip_data->max_tmds_clock)
+	    clock > hdmi->chip_data->max_tmds_clock)
 		return MODE_CLOCK_HIGH;
 
 	if (hdmi->ref_clk) {
@@ -341,8 +352,28 @@ dw_hdmi_rockchip_encoder_atomic_check(struct drm_encoder *encoder,
 				      struct drm_connector_state *conn_state)
 {
 	struct rockchip_crtc_state *s = to_rockchip_crtc_state(crtc_state);
+	struct drm_bridge *bridge = drm_bridge_chain_get_first_bridge(encoder);
+	struct drm_bridge_state *bridge_state = NULL;
+	u32 bus_format = MEDIA_BUS_FMT_RGB888_1X24;
+
+	if (bridge)
+		bridge_state = drm_atomic_get_new_bridge_state(crtc_state->state,
+							       bridge);
+	if (bridge_state &&
+	    bridge_state->input_bus_cfg.format != MEDIA_BUS_FMT_FIXED)
+		bus_format = bridge_state->input_bus_cfg.format;
+
+	switch (bus_format) {
+	case MEDIA_BUS_FMT_UYYVYY8_0_5X24:
+	case MEDIA_BUS_FMT_UYYVYY10_0_5X30:
+		s->output_mode = ROCKCHIP_OUT_MODE_YUV420;
+		break;
+	default:
+		s->output_mode = ROCKCHIP_OUT_MODE_AAAA;
+		break;
+	}
 
-	s->output_mode = ROCKCHIP_OUT_MODE_AAAA;
+	s->bus_format = bus_format;
 	s->output_type = DRM_MODE_CONNECTOR_HDMIA;
 
 	return 0;
@@ -526,6 +557,9 @@ static const struct dw_hdmi_plat_data rk3568_hdmi_drv_data = {
 	.phy_config = rockchip_phy_config,
 	.phy_data = &rk3568_chip_data,
 	.use_drm_infoframe = true,
+	.ycbcr_420_allowed = true,
+	/* VOP2 has no 12 or 16-bit 4:2:0 output */
+	.ycbcr_420_max_bpc = 10,
 };
 
 static const struct of_device_id dw_hdmi_rockchip_dt_ids[] = {
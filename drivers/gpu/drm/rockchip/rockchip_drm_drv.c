@@ -108,11 +108,15 @@ static int rockchip_drm_init_iommu(struct drm_device *drm_dev)
 	if (IS_ERR_OR_NULL(private->iommu_dev))
 		return 0;
 
+	ret = iova_cache_get();
+	if (ret < 0)
+		return ret;
+
 	private->domain = iommu_paging_domain_alloc(private->iommu_dev);
 	if (IS_ERR(private->domain)) {
 		ret = PTR_ERR(private->domain);
 		private->domain = NULL;
-		return ret;
+		goto err_put_cache;
 	}
 
 	geometry = &private->domain->geometry;
@@ -121,10 +125,25 @@ static int rockchip_drm_init_iommu(struct drm_device *drm_dev)
 
 	DRM_DEBUG("IOMMU context initialized (aperture: %#llx-%#llx)\n",
 		  start, end);
-	drm_mm_init(&private->mm, start, end - start + 1);
-	mutex_init(&private->mm_lock);
+
+	/* pfn 0 is reserved, alloc_iova_fast() returns it on failure */
+	init_iova_domain(&private->iovad, PAGE_SIZE,
+			 max_t(unsigned long, 1, start >> PAGE_SHIFT));
+	private->iova_limit = end >> PAGE_SHIFT;
+
+	ret = iova_domain_init_rcaches(&private->iovad);
+	if (ret)
+		goto err_free_domain;
 
 	return 0;
+
+err_free_domain:
+	put_iova_domain(&private->iovad);
+	iommu_domain_free(private->domain);
+	private->domain = NULL;
+err_put_cache:
+	iova_cache_put();
+	return ret;
 }
 
 static void rockchip_iommu_cleanup(struct drm_device *drm_dev)
@@ -134,8 +153,9 @@ static void rockchip_iommu_cleanup(struct drm_device *drm_dev)
 	if (!private->domain)
 		return;
 
-	drm_mm_takedown(&private->mm);
+	put_iova_domain(&private->iovad);
 	iommu_domain_free(private->domain);
+	iova_cache_put();
 }
 
 static int rockchip_drm_bind(struct device *dev)
@@ -166,6 +186,8 @@ static int rockchip_drm_bind(struct device *dev)
 	}
 
 	drm_dev->dev_private = private;
+	mutex_init(&private->import_lock);
+	INIT_LIST_HEAD(&private->import_cache);
 
 	ret = drmm_mode_config_init(drm_dev);
 	if (ret)
@@ -218,18 +240,28 @@ static void rockchip_drm_unbind(struct device *dev)
 	drm_kms_helper_poll_fini(drm_dev);
 
 	drm_atomic_helper_shutdown(drm_dev);
+	rockchip_gem_import_cache_flush(drm_dev);
 	component_unbind_all(dev, drm_dev);
 	rockchip_iommu_cleanup(drm_dev);
 
 	drm_dev_put(drm_dev);
 }
 
+/* Don't pin the previous master's buffers once it has let go of the device */
+static void rockchip_drm_master_drop(struct drm_device *drm,
+				     struct drm_file *file_priv)
+{
+	rockchip_gem_import_cache_flush(drm);
+}
+
 DEFINE_DRM_GEM_FOPS(rockchip_drm_driver_fops);
 
 static const struct drm_driver rockchip_drm_driver = {
 	.driver_features	= DRIVER_MODESET | DRIVER_GEM | DRIVER_ATOMIC,
 	.dumb_create		= rockchip_gem_dumb_create,
+	.gem_prime_import	= rockchip_gem_prime_import,
 	.gem_prime_import_sg_table	= rockchip_gem_prime_import_sg_table,
+	.master_drop		= rockchip_drm_master_drop,
 	.fops			= &rockchip_drm_driver_fops,
 	.name	= DRIVER_NAME,
 	.desc	= DRIVER_DESC,
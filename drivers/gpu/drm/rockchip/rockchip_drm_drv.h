@@ -15,6 +15,7 @@
 #include <linux/bits.h>
 #include <linux/component.h>
 #include <linux/i2c.h>
+#include <linux/iova.h>
 #include <linux/module.h>
 
 #define ROCKCHIP_MAX_FB_BUFFER	3
@@ -53,6 +54,8 @@ struct rockchip_crtc_state {
 	u32 bus_format;
 	u32 bus_flags;
 	int color_space;
+	/* vop2: predicted peak DDR load in MB/s */
+	u32 bandwidth;
 };
 #define to_rockchip_crtc_state(s) \
 		container_of(s, struct rockchip_crtc_state, base)
@@ -62,13 +65,20 @@ struct rockchip_crtc_state {
  *
  * @crtc: array of enabled CRTCs, used to map from "pipe" to drm_crtc.
  * @num_pipe: number of pipes for this device.
- * @mm_lock: protect drm_mm on multi-threads.
+ * @iovad: iova space of @domain, with per-CPU caches so that buffer
+ *	   allocations from several threads don't serialize on a single lock.
+ * @iova_limit: last pfn of @iovad.
  */
 struct rockchip_drm_private {
 	struct iommu_domain *domain;
 	struct device *iommu_dev;
-	struct mutex mm_lock;
-	struct drm_mm mm;
+	struct iova_domain iovad;
+	unsigned long iova_limit;
+
+	/* Recently imported dma-bufs, most recent first, see rockchip_drm_gem.c */
+	struct mutex import_lock;
+	struct list_head import_cache;
+	unsigned int import_count;
 };
 
 struct rockchip_encoder {
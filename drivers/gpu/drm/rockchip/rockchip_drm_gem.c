@@ -6,6 +6,8 @@
 
 #include <linux/dma-buf.h>
 #include <linux/iommu.h>
+#include <linux/module.h>
+#include <linux/sizes.h>
 #include <linux/vmalloc.h>
 
 #include <drm/drm.h>
@@ -18,25 +20,37 @@
 #include "rockchip_drm_drv.h"
 #include "rockchip_drm_gem.h"
 
+static bool large_pages;
+module_param(large_pages, bool, 0644);
+MODULE_PARM_DESC(large_pages,
+		 "Back GEM buffers with 2 MiB/64 KiB physically contiguous blocks when available");
+
+static unsigned int import_cache_size = 8;
+module_param(import_cache_size, uint, 0644);
+MODULE_PARM_DESC(import_cache_size,
+		 "Number of imported dma-bufs kept mapped after their last user is gone (default 8)");
+
 static int rockchip_gem_iommu_map(struct rockchip_gem_object *rk_obj)
 {
 	struct drm_device *drm = rk_obj->base.dev;
 	struct rockchip_drm_private *private = drm->dev_private;
 	int prot = IOMMU_READ | IOMMU_WRITE;
+	unsigned long pfn;
 	ssize_t ret;
 
-	mutex_lock(&private->mm_lock);
-	ret = drm_mm_insert_node_generic(&private->mm, &rk_obj->mm,
-					 rk_obj->base.size, PAGE_SIZE,
-					 0, 0);
-	mutex_unlock(&private->mm_lock);
-
-	if (ret < 0) {
-		DRM_ERROR("out of I/O virtual memory: %zd\n", ret);
-		return ret;
+	/*
+	 * The iova is naturally aligned to the buffer size rounded up to a
+	 * power of two, so buffers built from large blocks get each block
+	 * mapped by a single iommu_map() run.
+	 */
+	pfn = alloc_iova_fast(&private->iovad, rk_obj->base.size >> PAGE_SHIFT,
+			      private->iova_limit, true);
+	if (!pfn) {
+		DRM_ERROR("out of I/O virtual memory\n");
+		return -ENOMEM;
 	}
 
-	rk_obj->dma_addr = rk_obj->mm.start;
+	rk_obj->dma_addr = (dma_addr_t)pfn << PAGE_SHIFT;
 
 	ret = iommu_map_sgtable(private->domain, rk_obj->dma_addr, rk_obj->sgt,
 				prot);
@@ -44,17 +58,15 @@ static int rockchip_gem_iommu_map(struct rockchip_gem_object *rk_obj)
 		DRM_ERROR("failed to map buffer: size=%zd request_size=%zd\n",
 			  ret, rk_obj->base.size);
 		ret = -ENOMEM;
-		goto err_remove_node;
+		goto err_free_iova;
 	}
 
 	rk_obj->size = ret;
 
 	return 0;
 
-err_remove_node:
-	mutex_lock(&private->mm_lock);
-	drm_mm_remove_node(&rk_obj->mm);
-	mutex_unlock(&private->mm_lock);
+err_free_iova:
+	free_iova_fast(&private->iovad, pfn, rk_obj->base.size >> PAGE_SHIFT);
 
 	return ret;
 }
@@ -66,11 +78,73 @@ static int rockchip_gem_iommu_unmap(struct rockchip_gem_object *rk_obj)
 
 	iommu_unmap(private->domain, rk_obj->dma_addr, rk_obj->size);
 
-	mutex_lock(&private->mm_lock);
+	free_iova_fast(&private->iovad, rk_obj->dma_addr >> PAGE_SHIFT,
+		       rk_obj->base.size >> PAGE_SHIFT);
+
+	return 0;
+}
 
-	drm_mm_remove_node(&rk_obj->mm);
+static void rockchip_gem_free_large_pages(struct rockchip_gem_object *rk_obj)
+{
+	unsigned long i;
 
-	mutex_unlock(&private->mm_lock);
+	for (i = 0; i < rk_obj->num_pages; i++)
+		__free_page(rk_obj->pages[i]);
+
+	kvfree(rk_obj->pages);
+}
+
+/*
+ * Allocate the backing pages from the largest physically contiguous blocks
+ * available, falling back to smaller blocks and eventually to single pages.
+ * The blocks are split, so that every page can be handled individually like
+ * the shmem backed ones, but contiguous runs collapse into a single sg entry
+ * and a single iommu_map() run.
+ */
+static int rockchip_gem_alloc_large_pages(struct rockchip_gem_object *rk_obj)
+{
+	const unsigned int orders[] = { get_order(SZ_2M), get_order(SZ_64K), 0 };
+	unsigned long remaining = rk_obj->base.size >> PAGE_SHIFT;
+	unsigned long i;
+
+	rk_obj->pages = kvmalloc_array(remaining, sizeof(*rk_obj->pages),
+				       GFP_KERNEL);
+	if (!rk_obj->pages)
+		return -ENOMEM;
+
+	rk_obj->num_pages = 0;
+	while (remaining) {
+		struct page *page = NULL;
+		unsigned int order, j;
+
+		for (j = 0; j < ARRAY_SIZE(orders); j++) {
+			gfp_t gfp = GFP_HIGHUSER | __GFP_ZERO;
+
+			order = orders[j];
+			if ((1UL << order) > remaining)
+				continue;
+
+			/* Don't try hard for a large block, smaller ones will do */
+			if (order)
+				gfp = (gfp | __GFP_NOWARN | __GFP_NORETRY) &
+				      ~__GFP_RECLAIM;
+
+			page = alloc_pages(gfp, order);
+			if (page)
+				break;
+		}
+
+		if (!page) {
+			rockchip_gem_free_large_pages(rk_obj);
+			return -ENOMEM;
+		}
+
+		split_page(page, order);
+		for (i = 0; i < (1UL << order); i++)
+			rk_obj->pages[rk_obj->num_pages++] = page + i;
+
+		remaining -= 1UL << order;
+	}
 
 	return 0;
 }
@@ -81,11 +155,18 @@ static int rockchip_gem_get_pages(struct rockchip_gem_object *rk_obj)
 	int ret, i;
 	struct scatterlist *s;
 
-	rk_obj->pages = drm_gem_get_pages(&rk_obj->base);
-	if (IS_ERR(rk_obj->pages))
-		return PTR_ERR(rk_obj->pages);
+	rk_obj->large_pages = READ_ONCE(large_pages);
+	if (rk_obj->large_pages) {
+		ret = rockchip_gem_alloc_large_pages(rk_obj);
+		if (ret)
+			return ret;
+	} else {
+		rk_obj->pages = drm_gem_get_pages(&rk_obj->base);
+		if (IS_ERR(rk_obj->pages))
+			return PTR_ERR(rk_obj->pages);
 
-	rk_obj->num_pages = rk_obj->base.size >> PAGE_SHIFT;
+		rk_obj->num_pages = rk_obj->base.size >> PAGE_SHIFT;
+	}
 
 	rk_obj->sgt = drm_prime_pages_to_sg(rk_obj->base.dev,
 					    rk_obj->pages, rk_obj->num_pages);
@@ -109,7 +190,10 @@ static int rockchip_gem_get_pages(struct rockchip_gem_object *rk_obj)
 	return 0;
 
 err_put_pages:
-	drm_gem_put_pages(&rk_obj->base, rk_obj->pages, false, false);
+	if (rk_obj->large_pages)
+		rockchip_gem_free_large_pages(rk_obj);
+	else
+		drm_gem_put_pages(&rk_obj->base, rk_obj->pages, false, false);
 	return ret;
 }
 
@@ -117,7 +201,10 @@ static void rockchip_gem_put_pages(struct rockchip_gem_object *rk_obj)
 {
 	sg_free_table(rk_obj->sgt);
 	kfree(rk_obj->sgt);
-	drm_gem_put_pages(&rk_obj->base, rk_obj->pages, true, true);
+	if (rk_obj->large_pages)
+		rockchip_gem_free_large_pages(rk_obj);
+	else
+		drm_gem_put_pages(&rk_obj->base, rk_obj->pages, true, true);
 }
 
 static int rockchip_gem_alloc_iommu(struct rockchip_gem_object *rk_obj,
@@ -294,6 +381,7 @@ static struct rockchip_gem_object *
 	obj = &rk_obj->base;
 
 	obj->funcs = &rockchip_gem_object_funcs;
+	INIT_LIST_HEAD(&rk_obj->import_node);
 
 	drm_gem_object_init(drm, obj, size);
 
@@ -510,6 +598,93 @@ rockchip_gem_prime_import_sg_table(struct drm_device *drm,
 	return ERR_PTR(ret);
 }
 
+/*
+ * Compositors import every frame's buffer again and drop it once it's been
+ * scanned out, which costs an IOVA allocation and a full IOMMU map each time.
+ * Keep the last import_cache_size imports alive so that a swapchain cycling
+ * through a few dma-bufs hits the same GEM object, and its mapping, again.
+ * The dma-buf pointer is a stable key since the attachment of a cached object
+ * holds a reference on it.
+ */
+static struct rockchip_gem_object *
+rockchip_gem_import_lookup(struct rockchip_drm_private *private,
+			   struct dma_buf *dma_buf)
+{
+	struct rockchip_gem_object *rk_obj;
+
+	lockdep_assert_held(&private->import_lock);
+
+	list_for_each_entry(rk_obj, &private->import_cache, import_node) {
+		if (rk_obj->base.import_attach->dmabuf == dma_buf)
+			return rk_obj;
+	}
+
+	return NULL;
+}
+
+struct drm_gem_object *rockchip_gem_prime_import(struct drm_device *drm,
+						 struct dma_buf *dma_buf)
+{
+	struct rockchip_drm_private *private = drm->dev_private;
+	struct rockchip_gem_object *rk_obj, *evict = NULL;
+	struct drm_gem_object *obj;
+
+	mutex_lock(&private->import_lock);
+	rk_obj = rockchip_gem_import_lookup(private, dma_buf);
+	if (rk_obj) {
+		list_move(&rk_obj->import_node, &private->import_cache);
+		drm_gem_object_get(&rk_obj->base);
+		mutex_unlock(&private->import_lock);
+		return &rk_obj->base;
+	}
+	mutex_unlock(&private->import_lock);
+
+	obj = drm_gem_prime_import(drm, dma_buf);
+	if (IS_ERR(obj) || !obj->import_attach || !import_cache_size)
+		return obj;
+
+	rk_obj = to_rockchip_obj(obj);
+
+	mutex_lock(&private->import_lock);
+	/* Lost a race against a concurrent import, leave this one uncached */
+	if (rockchip_gem_import_lookup(private, dma_buf)) {
+		mutex_unlock(&private->import_lock);
+		return obj;
+	}
+
+	drm_gem_object_get(obj);
+	list_add(&rk_obj->import_node, &private->import_cache);
+	if (++private->import_count > import_cache_size) {
+		evict = list_last_entry(&private->import_cache,
+					struct rockchip_gem_object, import_node);
+		list_del_init(&evict->import_node);
+		private->import_count--;
+	}
+	mutex_unlock(&private->import_lock);
+
+	if (evict)
+		drm_gem_object_put(&evict->base);
+
+	return obj;
+}
+
+void rockchip_gem_import_cache_flush(struct drm_device *drm)
+{
+	struct rockchip_drm_private *private = drm->dev_private;
+	struct rockchip_gem_object *rk_obj, *tmp;
+	LIST_HEAD(list);
+
+	mutex_lock(&private->import_lock);
+	list_splice_init(&private->import_cache, &list);
+	private->import_count = 0;
+	mutex_unlock(&private->import_lock);
+
+	list_for_each_entry_safe(rk_obj, tmp, &list, import_node) {
+		list_del_init(&rk_obj->import_node);
+		drm_gem_object_put(&rk_obj->base);
+	}
+}
+
 int rockchip_gem_prime_vmap(struct drm_gem_object *obj, struct iosys_map *map)
 {
 	struct rockchip_gem_object *rk_obj = to_rockchip_obj(obj);
@@ -19,14 +19,21 @@ struct rockchip_gem_object {
 	unsigned long dma_attrs;
 
 	/* Used when IOMMU is enabled */
-	struct drm_mm_node mm;
 	unsigned long num_pages;
 	struct page **pages;
 	struct sg_table *sgt;
 	size_t size;
+	/* pages come from split high-order blocks rather than shmem */
+	bool large_pages;
+
+	/* Entry in the import cache, which holds a reference while linked */
+	struct list_head import_node;
 };
 
 struct sg_table *rockchip_gem_prime_get_sg_table(struct drm_gem_object *obj);
+struct drm_gem_object *rockchip_gem_prime_import(struct drm_device *drm,
+						 struct dma_buf *dma_buf);
+void rockchip_gem_import_cache_flush(struct drm_device *drm);
 struct drm_gem_object *
 rockchip_gem_prime_import_sg_table(struct drm_device *dev,
 				   struct dma_buf_attachment *attach,
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#if !defined(_ROCKCHIP_DRM_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _ROCKCHIP_DRM_TRACE_H_
+
+#include <linux/dma-buf.h>
+#include <linux/tracepoint.h>
+
+#include <drm/drm_crtc.h>
+#include <drm/drm_framebuffer.h>
+#include <drm/drm_gem.h>
+#include <drm/drm_plane.h>
+#include <drm/drm_vblank.h>
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rockchip_drm
+#define TRACE_INCLUDE_FILE rockchip_drm_trace
+
+/*
+ * dmabuf is the dma_buf_ino() of an imported framebuffer, 0 for buffers
+ * allocated by the display driver itself.
+ */
+TRACE_EVENT(rockchip_vop2_plane_update,
+	TP_PROTO(struct drm_plane *plane, struct drm_crtc *crtc),
+	TP_ARGS(plane, crtc),
+	TP_STRUCT__entry(
+		__field(unsigned int, plane)
+		__field(unsigned int, crtc)
+		__field(u64, vblank)
+		__field(unsigned long, dmabuf)
+		),
+
+	TP_fast_assign(
+		struct drm_gem_object *obj = plane->state->fb->obj[0];
+
+		__entry->plane = plane->base.id;
+		__entry->crtc = drm_crtc_index(crtc);
+		__entry->vblank = drm_crtc_vblank_count(crtc);
+		__entry->dmabuf = obj->import_attach ?
+				  dma_buf_ino(obj->import_attach->dmabuf) : 0;
+		),
+
+	TP_printk("plane=%u crtc=%u vblank=%llu dmabuf=%lu",
+		  __entry->plane, __entry->crtc, __entry->vblank,
+		  __entry->dmabuf)
+);
+
+TRACE_EVENT(rockchip_vop2_flip_done,
+	TP_PROTO(struct drm_crtc *crtc),
+	TP_ARGS(crtc),
+	TP_STRUCT__entry(
+		__field(unsigned int, crtc)
+		__field(u64, vblank)
+		),
+
+	TP_fast_assign(
+		__entry->crtc = drm_crtc_index(crtc);
+		__entry->vblank = drm_crtc_vblank_count(crtc);
+		),
+
+	TP_printk("crtc=%u vblank=%llu", __entry->crtc, __entry->vblank)
+);
+
+#endif
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH ../../drivers/gpu/drm/rockchip
+#include <trace/define_trace.h>
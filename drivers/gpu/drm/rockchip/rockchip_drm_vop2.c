@@ -6,7 +6,9 @@
 #include <linux/bitfield.h>
 #include <linux/clk.h>
 #include <linux/component.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
+#include <linux/devfreq.h>
 #include <linux/iopoll.h>
 #include <linux/kernel.h>
 #include <linux/media-bus-format.h>
@@ -15,6 +17,7 @@
 #include <linux/of.h>
 #include <linux/of_graph.h>
 #include <linux/platform_device.h>
+#include <linux/pm_qos.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
 #include <linux/swab.h>
@@ -24,19 +27,29 @@
 #include <drm/drm_atomic_uapi.h>
 #include <drm/drm_blend.h>
 #include <drm/drm_crtc.h>
+#include <drm/drm_damage_helper.h>
 #include <drm/drm_debugfs.h>
+#include <drm/drm_edid.h>
 #include <drm/drm_flip_work.h>
 #include <drm/drm_framebuffer.h>
 #include <drm/drm_probe_helper.h>
+#include <drm/drm_self_refresh_helper.h>
 #include <drm/drm_vblank.h>
+#include <drm/drm_writeback.h>
 
 #include <uapi/linux/videodev2.h>
 #include <dt-bindings/soc/rockchip,vop2.h>
 
 #include "rockchip_drm_gem.h"
+#include "rockchip_drm_trace.h"
 #include "rockchip_drm_vop2.h"
 #include "rockchip_rgb.h"
 
+static bool cursor_plane;
+module_param(cursor_plane, bool, 0444);
+MODULE_PARM_DESC(cursor_plane,
+		 "Expose unused VOP2 primary windows as asynchronously updatable cursor planes");
+
 /*
  * VOP2 architecture
  *
@@ -169,11 +182,65 @@ struct vop2_video_port {
 	u32 win_mask;
 
 	struct vop2_win *primary_plane;
+	struct vop2_win *cursor_plane;
 	struct drm_pending_vblank_event *event;
 
+	/**
+	 * @fb_unref_work: releases framebuffers replaced by asynchronous
+	 * plane updates once the hardware stopped scanning them out.
+	 */
+	struct drm_flip_work fb_unref_work;
+	bool fb_unref_pending;
+
+	/**
+	 * @bandwidth: predicted peak DDR load of the committed state in MB/s
+	 */
+	u32 bandwidth;
+
+	/**
+	 * @handoff: the bootloader left this video port scanning out; its
+	 * dclk and the core resources are held until the first modeset.
+	 */
+	bool handoff;
+
 	unsigned int nlayers;
 };
 
+#define VOP2_WB_JOB_MAX		2
+
+struct vop2_wb_job {
+	struct vop2_video_port *vp;
+	/* frame starts seen since the job was latched */
+	unsigned int fs_cnt;
+};
+
+struct vop2_wb {
+	struct drm_writeback_connector conn;
+
+	/* protects all fields below against the interrupt handler */
+	spinlock_t job_lock;
+	/* video port the writeback is sourced from */
+	struct vop2_video_port *vp;
+	bool enabled;
+	/* video ports with a commit being programmed */
+	unsigned long busy;
+	/* queued jobs, oldest first */
+	unsigned int njobs;
+	struct vop2_wb_job jobs[VOP2_WB_JOB_MAX];
+};
+
+/*
+ * Predicted peak DDR load of each video port in MB/s, as last checked by a
+ * commit. A private object, so that the budget check runs against the
+ * state the other video ports are committed or being committed with.
+ */
+struct vop2_bw_state {
+	struct drm_private_state base;
+	u32 vp[ROCKCHIP_MAX_CRTC];
+};
+
+#define to_vop2_bw_state(s) container_of(s, struct vop2_bw_state, base)
+
 struct vop2 {
 	struct device *dev;
 	struct drm_device *drm;
@@ -209,6 +276,8 @@ struct vop2 {
 	 * we need a ref counter here.
 	 */
 	unsigned int enable_count;
+	/* video ports still held for the bootloader, see vop2_handoff_init() */
+	unsigned int handoff_count;
 	struct clk *hclk;
 	struct clk *aclk;
 	struct clk *pclk;
@@ -217,12 +286,47 @@ struct vop2 {
 	/* optional internal rgb encoder */
 	struct rockchip_rgb *rgb;
 
+	/* optional writeback of the mixer output to memory */
+	struct vop2_wb wb;
+
+	/*
+	 * Optional DMC devfreq device, kept at a minimum rate that covers
+	 * the predicted scanout bandwidth of all video ports.
+	 */
+	struct devfreq *dmc;
+	struct dev_pm_qos_request dmc_qos;
+	u32 dmc_khz;
+	struct delayed_work dmc_work;
+	/* protects dmc, dmc_qos, dmc_khz */
+	struct mutex dmc_lock;
+
+	/* DDR load of all video ports, see struct vop2_bw_state */
+	struct drm_private_obj bw_obj;
+
+	/* optional NoC QoS generators of the VOP2 bus masters */
+	struct regmap **qos;
+	int num_qos;
+	u32 qos_priority;
+
 	/* must be put at the end of the struct */
 	struct vop2_win win[];
 };
 
 #define VOP2_MAX_DCLK_RATE		600000000
 
+/* QoS generator register, same layout as used by the rockchip power domains */
+#define VOP2_QOS_PRIORITY		0x08
+
+/*
+ * DDR clock (in kHz) to request per MB/s of scanout: a 32 bit DDR bus
+ * moves 8 bytes per clock, and only about half of that is usable once
+ * refresh, page misses and the other masters are accounted for.
+ */
+#define VOP2_DMC_KHZ_PER_MBPS		250
+
+/* delay before the DMC request is lowered after the load dropped */
+#define VOP2_DMC_RELAX_MS		500
+
 #define vop2_output_if_is_hdmi(x)	((x) == ROCKCHIP_VOP2_EP_HDMI0 || \
 					 (x) == ROCKCHIP_VOP2_EP_HDMI1)
 
@@ -582,7 +686,26 @@ static bool rockchip_vop2_mod_supported(struct drm_plane *plane, u32 format,
 		return false;
 	}
 
-	return vop2_convert_afbc_format(format) >= 0;
+	switch (vop2_convert_afbc_format(format)) {
+	case VOP2_AFBC_FMT_ARGB8888:
+	case VOP2_AFBC_FMT_ARGB2101010:
+		break;
+	case VOP2_AFBC_FMT_RGB888:
+	case VOP2_AFBC_FMT_RGB565:
+		/* The decoder only splits blocks of 32 bpp formats */
+		if (modifier & AFBC_FORMAT_MOD_SPLIT)
+			return false;
+		break;
+	case VOP2_AFBC_FMT_INVALID:
+		return false;
+	default:
+		/* YTR is a colour transform for RGB data only */
+		if (modifier & (AFBC_FORMAT_MOD_YTR | AFBC_FORMAT_MOD_SPLIT))
+			return false;
+		break;
+	}
+
+	return true;
 }
 
 /*
@@ -872,31 +995,35 @@ static int vop2_convert_csc_mode(int csc_mode)
  * 11. RGB       --> bypass                --> RGB_OUTPUT(709)
  */
 
-static void vop2_setup_csc_mode(struct vop2_video_port *vp,
-				struct vop2_win *win,
-				struct drm_plane_state *pstate)
+static int vop2_get_csc_mode(struct vop2_video_port *vp,
+			     struct drm_plane_state *pstate,
+			     bool *y2r_en, bool *r2y_en)
 {
 	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(vp->crtc.state);
 	int is_input_yuv = pstate->fb->format->is_yuv;
 	int is_output_yuv = is_yuv_output(vcstate->bus_format);
 	int input_csc = V4L2_COLORSPACE_DEFAULT;
 	int output_csc = vcstate->color_space;
+
+	*y2r_en = is_input_yuv && !is_output_yuv;
+	*r2y_en = !is_input_yuv && is_output_yuv;
+
+	if (*y2r_en)
+		return vop2_convert_csc_mode(input_csc);
+	if (*r2y_en)
+		return vop2_convert_csc_mode(output_csc);
+
+	return 0;
+}
+
+static void vop2_setup_csc_mode(struct vop2_video_port *vp,
+				struct vop2_win *win,
+				struct drm_plane_state *pstate)
+{
 	bool r2y_en, y2r_en;
 	int csc_mode;
 
-	if (is_input_yuv && !is_output_yuv) {
-		y2r_en = true;
-		r2y_en = false;
-		csc_mode = vop2_convert_csc_mode(input_csc);
-	} else if (!is_input_yuv && is_output_yuv) {
-		y2r_en = false;
-		r2y_en = true;
-		csc_mode = vop2_convert_csc_mode(output_csc);
-	} else {
-		y2r_en = false;
-		r2y_en = false;
-		csc_mode = false;
-	}
+	csc_mode = vop2_get_csc_mode(vp, pstate, &y2r_en, &r2y_en);
 
 	vop2_win_write(win, VOP2_WIN_Y2R_EN, y2r_en);
 	vop2_win_write(win, VOP2_WIN_R2Y_EN, r2y_en);
@@ -949,6 +1076,59 @@ static int vop2_core_clks_prepare_enable(struct vop2 *vop2)
 	return ret;
 }
 
+/*
+ * Scanout has hard deadlines while the GPU and the other masters sharing
+ * the DDR path do not. The power domain restores the QoS generators with
+ * whatever they held before powering off, so writing them once every time
+ * VOP2 is powered up is enough.
+ */
+static void vop2_qos_apply(struct vop2 *vop2)
+{
+	int i;
+
+	for (i = 0; i < vop2->num_qos; i++)
+		regmap_write(vop2->qos[i], VOP2_QOS_PRIORITY, vop2->qos_priority);
+}
+
+static int vop2_qos_init(struct vop2 *vop2)
+{
+	struct device_node *np = vop2->dev->of_node;
+	int i;
+
+	vop2->num_qos = of_count_phandle_with_args(np, "rockchip,qos", NULL);
+	if (vop2->num_qos <= 0) {
+		vop2->num_qos = 0;
+		return 0;
+	}
+
+	if (of_property_read_u32(np, "rockchip,qos-priority", &vop2->qos_priority)) {
+		drm_warn(vop2->drm, "rockchip,qos without rockchip,qos-priority\n");
+		vop2->num_qos = 0;
+		return 0;
+	}
+
+	vop2->qos = devm_kcalloc(vop2->dev, vop2->num_qos, sizeof(*vop2->qos),
+				 GFP_KERNEL);
+	if (!vop2->qos)
+		return -ENOMEM;
+
+	for (i = 0; i < vop2->num_qos; i++) {
+		struct device_node *qos_node;
+
+		qos_node = of_parse_phandle(np, "rockchip,qos", i);
+		if (!qos_node)
+			return -ENODEV;
+
+		vop2->qos[i] = syscon_node_to_regmap(qos_node);
+		of_node_put(qos_node);
+		if (IS_ERR(vop2->qos[i]))
+			return dev_err_probe(vop2->dev, PTR_ERR(vop2->qos[i]),
+					     "cannot get qos %d\n", i);
+	}
+
+	return 0;
+}
+
 static void rk3588_vop2_power_domain_enable_all(struct vop2 *vop2)
 {
 	u32 pd;
@@ -960,6 +1140,67 @@ static void rk3588_vop2_power_domain_enable_all(struct vop2 *vop2)
 	vop2_writel(vop2, RK3588_SYS_PD_CTRL, pd);
 }
 
+static void vop2_handoff_release(struct vop2_video_port *vp)
+{
+	struct vop2 *vop2 = vp->vop2;
+
+	if (!vp->handoff)
+		return;
+
+	vp->handoff = false;
+	clk_disable_unprepare(vp->dclk);
+
+	if (--vop2->handoff_count)
+		return;
+
+	clk_disable_unprepare(vop2->pclk);
+	clk_disable_unprepare(vop2->aclk);
+	clk_disable_unprepare(vop2->hclk);
+	pm_runtime_put(vop2->dev);
+}
+
+/*
+ * The bootloader scans out of physical addresses. Stop the inherited
+ * video ports before the IOMMU gets attached, so they don't fetch
+ * through translations that don't exist, and drop what was held for
+ * them now that vop2_enable() owns the core resources.
+ */
+static void vop2_handoff_stop(struct vop2 *vop2)
+{
+	int i;
+
+	if (!vop2->handoff_count)
+		return;
+
+	for (i = 0; i < vop2->data->nr_vps; i++) {
+		struct vop2_video_port *vp = &vop2->vps[i];
+
+		if (!vp->handoff)
+			continue;
+
+		reinit_completion(&vp->dsp_hold_completion);
+		vop2_crtc_enable_irq(vp, VP_INT_DSP_HOLD_VALID);
+		vop2_vp_write(vp, RK3568_VP_DSP_CTRL, RK3568_VP_DSP_CTRL__STANDBY);
+		vop2_cfg_done(vp);
+	}
+
+	/* standby takes effect at the end of the current frame */
+	for (i = 0; i < vop2->data->nr_vps; i++) {
+		struct vop2_video_port *vp = &vop2->vps[i];
+
+		if (!vp->handoff)
+			continue;
+
+		if (!wait_for_completion_timeout(&vp->dsp_hold_completion,
+						 msecs_to_jiffies(50)))
+			drm_info(vop2->drm, "wait for vp%d dsp_hold timeout\n",
+				 vp->id);
+
+		vop2_crtc_disable_irq(vp, VP_INT_DSP_HOLD_VALID);
+		vop2_handoff_release(vp);
+	}
+}
+
 static void vop2_enable(struct vop2 *vop2)
 {
 	int ret;
@@ -976,6 +1217,8 @@ static void vop2_enable(struct vop2 *vop2)
 		return;
 	}
 
+	vop2_handoff_stop(vop2);
+
 	ret = rockchip_drm_dma_attach_device(vop2->drm, vop2->dev);
 	if (ret) {
 		drm_err(vop2->drm, "failed to attach dma mapping, %d\n", ret);
@@ -988,6 +1231,8 @@ static void vop2_enable(struct vop2 *vop2)
 	if (vop2->data->soc_id == 3588)
 		rk3588_vop2_power_domain_enable_all(vop2);
 
+	vop2_qos_apply(vop2);
+
 	vop2_writel(vop2, RK3568_REG_CFG_DONE, RK3568_REG_CFG_DONE__GLB_CFG_DONE_EN);
 
 	/*
@@ -1020,6 +1265,170 @@ static void vop2_disable(struct vop2 *vop2)
 	clk_disable_unprepare(vop2->hclk);
 }
 
+/* Called with job_lock held */
+static void vop2_wb_retire_job(struct vop2_wb *wb, int status)
+{
+	struct vop2_video_port *vp = wb->jobs[0].vp;
+
+	drm_writeback_signal_completion(&wb->conn, status);
+	drm_crtc_vblank_put(&vp->crtc);
+
+	wb->njobs--;
+	memmove(&wb->jobs[0], &wb->jobs[1], wb->njobs * sizeof(wb->jobs[0]));
+}
+
+/* The video port is in standby, complete whatever it wrote back */
+static void vop2_wb_disable(struct vop2_video_port *vp)
+{
+	struct vop2 *vop2 = vp->vop2;
+	struct vop2_wb *wb = &vop2->wb;
+
+	if (!vop2->data->wb)
+		return;
+
+	spin_lock_irq(&wb->job_lock);
+
+	if (wb->enabled && wb->vp == vp) {
+		vop2_writel(vop2, RK3568_WB_CTRL, 0);
+		wb->enabled = false;
+	}
+
+	while (wb->njobs && wb->jobs[0].vp == vp)
+		vop2_wb_retire_job(wb, 0);
+
+	spin_unlock_irq(&wb->job_lock);
+}
+
+/*
+ * A display brought up by the bootloader keeps scanning out its splash
+ * screen until the kernel takes over, as long as nothing turns off the
+ * clocks or the power domain underneath it. Hold references on both for
+ * every video port found running, so that neither clk_disable_unused
+ * nor genpd shut the picture off before the first modeset. Runtime PM
+ * must be enabled already, the registers are only read once the power
+ * domain and the core clocks are known to be on.
+ */
+static void vop2_handoff_init(struct vop2 *vop2)
+{
+	int i;
+
+	if (pm_runtime_resume_and_get(vop2->dev) < 0)
+		return;
+
+	if (vop2_core_clks_prepare_enable(vop2)) {
+		pm_runtime_put(vop2->dev);
+		return;
+	}
+
+	for (i = 0; i < vop2->data->nr_vps; i++) {
+		struct vop2_video_port *vp = &vop2->vps[i];
+		u32 val;
+
+		if (!vp->crtc.port)
+			continue;
+
+		val = readl(vop2->regs + vp->data->offset + RK3568_VP_DSP_CTRL);
+		if (val & RK3568_VP_DSP_CTRL__STANDBY)
+			continue;
+
+		if (clk_prepare_enable(vp->dclk))
+			continue;
+
+		drm_info(vop2->drm, "vp%d inherited from bootloader\n", vp->id);
+		vp->handoff = true;
+		vop2->handoff_count++;
+	}
+
+	if (!vop2->handoff_count) {
+		clk_disable_unprepare(vop2->pclk);
+		clk_disable_unprepare(vop2->aclk);
+		clk_disable_unprepare(vop2->hclk);
+		pm_runtime_put(vop2->dev);
+	}
+}
+
+static u32 vop2_dmc_min_khz(struct vop2 *vop2)
+{
+	u32 total = 0;
+	int i;
+
+	for (i = 0; i < vop2->data->nr_vps; i++)
+		total += READ_ONCE(vop2->vps[i].bandwidth);
+
+	return total * VOP2_DMC_KHZ_PER_MBPS;
+}
+
+/*
+ * Raise the DDR rate floor right away, so that it is in place before the
+ * new configuration gets latched. Lowering it is deferred, as the old
+ * configuration keeps fetching until the end of the current frame and
+ * a burst of small commits shouldn't bounce the DDR rate.
+ */
+static void vop2_dmc_update(struct vop2 *vop2)
+{
+	u32 khz = vop2_dmc_min_khz(vop2);
+
+	if (!of_property_present(vop2->dev->of_node, "devfreq"))
+		return;
+
+	mutex_lock(&vop2->dmc_lock);
+
+	if (!vop2->dmc) {
+		struct devfreq *dmc;
+
+		dmc = devfreq_get_devfreq_by_phandle(vop2->dev, "devfreq", 0);
+		if (IS_ERR(dmc))
+			goto out;
+
+		/*
+		 * Have the DMC unbind VOP2 before it goes away, so dmc and the
+		 * QoS request stay valid for as long as VOP2 is bound.
+		 */
+		if (!device_link_add(vop2->dev, dmc->dev.parent,
+				     DL_FLAG_AUTOREMOVE_CONSUMER))
+			goto out;
+
+		if (dev_pm_qos_add_request(dmc->dev.parent, &vop2->dmc_qos,
+					   DEV_PM_QOS_MIN_FREQUENCY, 0) < 0)
+			goto out;
+
+		vop2->dmc = dmc;
+	}
+
+	if (khz >= vop2->dmc_khz) {
+		cancel_delayed_work(&vop2->dmc_work);
+		dev_pm_qos_update_request(&vop2->dmc_qos, khz);
+		vop2->dmc_khz = khz;
+	} else {
+		mod_delayed_work(system_wq, &vop2->dmc_work,
+				 msecs_to_jiffies(VOP2_DMC_RELAX_MS));
+	}
+
+out:
+	mutex_unlock(&vop2->dmc_lock);
+}
+
+static void vop2_dmc_relax_work(struct work_struct *work)
+{
+	struct vop2 *vop2 = container_of(to_delayed_work(work), struct vop2,
+					 dmc_work);
+
+	mutex_lock(&vop2->dmc_lock);
+	if (vop2->dmc) {
+		vop2->dmc_khz = vop2_dmc_min_khz(vop2);
+		dev_pm_qos_update_request(&vop2->dmc_qos, vop2->dmc_khz);
+	}
+	mutex_unlock(&vop2->dmc_lock);
+}
+
+static void vop2_dmc_fini(struct vop2 *vop2)
+{
+	cancel_delayed_work_sync(&vop2->dmc_work);
+
+	if (vop2->dmc)
+		dev_pm_qos_remove_request(&vop2->dmc_qos);
+}
+
 static void vop2_crtc_atomic_disable(struct drm_crtc *crtc,
 				     struct drm_atomic_state *state)
 {
@@ -1033,6 +1442,20 @@ static void vop2_crtc_atomic_disable(struct drm_crtc *crtc,
 	old_crtc_state = drm_atomic_get_old_crtc_state(state, crtc);
 	drm_atomic_helper_disable_planes_on_crtc(old_crtc_state, false);
 
+	/*
+	 * The panel keeps displaying the last frame on its own. Stop all
+	 * DDR fetches, but keep the timing generator and clocks running so
+	 * that leaving self refresh is just re-enabling the windows.
+	 */
+	if (crtc->state->self_refresh_active) {
+		vop2_cfg_done(vp);
+		vop2_wb_disable(vp);
+		WRITE_ONCE(vp->bandwidth, 0);
+		vop2_dmc_update(vop2);
+		vop2_unlock(vop2);
+		goto out;
+	}
+
 	drm_crtc_vblank_off(crtc);
 
 	/*
@@ -1055,6 +1478,11 @@ static void vop2_crtc_atomic_disable(struct drm_crtc *crtc,
 
 	vop2_crtc_disable_irq(vp, VP_INT_DSP_HOLD_VALID);
 
+	vop2_wb_disable(vp);
+
+	WRITE_ONCE(vp->bandwidth, 0);
+	vop2_dmc_update(vop2);
+
 	if (vp->dclk_src)
 		clk_set_parent(vp->dclk, vp->dclk_src);
 
@@ -1067,6 +1495,7 @@ static void vop2_crtc_atomic_disable(struct drm_crtc *crtc,
 
 	vop2_unlock(vop2);
 
+out:
 	if (crtc->state->event && !crtc->state->active) {
 		spin_lock_irq(&crtc->dev->event_lock);
 		drm_crtc_send_vblank_event(crtc, crtc->state->event);
@@ -1216,6 +1645,45 @@ static void vop2_plane_setup_color_key(struct drm_plane *plane, u32 color_key)
 	vop2_win_write(win, VOP2_WIN_COLOR_KEY, (r << 20) | (g << 10) | b);
 }
 
+/*
+ * VOP2 fetches the whole of every enabled window each frame, damage can't
+ * shrink that. But a commit that leaves a window's framebuffer and
+ * geometry alone and reports no damage inside it doesn't need the window
+ * to be reprogrammed at all.
+ */
+static bool vop2_plane_unchanged(struct drm_plane *plane,
+				 struct drm_atomic_state *state)
+{
+	struct drm_plane_state *old_pstate = drm_atomic_get_old_plane_state(state, plane);
+	struct drm_plane_state *pstate = drm_atomic_get_new_plane_state(state, plane);
+	struct drm_crtc_state *cstate;
+	struct drm_rect damage;
+
+	/* Async updates and self refresh exit reprogram from plane->state */
+	if (!old_pstate || pstate != plane->state)
+		return false;
+
+	if (!old_pstate->visible || old_pstate->fb != pstate->fb ||
+	    old_pstate->crtc != pstate->crtc)
+		return false;
+
+	cstate = drm_atomic_get_new_crtc_state(state, pstate->crtc);
+	if (!cstate || drm_atomic_crtc_needs_modeset(cstate))
+		return false;
+
+	if (!drm_rect_equals(&old_pstate->src, &pstate->src) ||
+	    !drm_rect_equals(&old_pstate->dst, &pstate->dst) ||
+	    old_pstate->rotation != pstate->rotation ||
+	    old_pstate->alpha != pstate->alpha ||
+	    old_pstate->pixel_blend_mode != pstate->pixel_blend_mode ||
+	    old_pstate->normalized_zpos != pstate->normalized_zpos ||
+	    old_pstate->color_encoding != pstate->color_encoding ||
+	    old_pstate->color_range != pstate->color_range)
+		return false;
+
+	return !drm_atomic_helper_damage_merged(old_pstate, pstate, &damage);
+}
+
 static void vop2_plane_atomic_update(struct drm_plane *plane,
 				     struct drm_atomic_state *state)
 {
@@ -1260,6 +1728,11 @@ static void vop2_plane_atomic_update(struct drm_plane *plane,
 		return;
 	}
 
+	if (vop2_plane_unchanged(plane, state))
+		return;
+
+	trace_rockchip_vop2_plane_update(plane, crtc);
+
 	afbc_en = rockchip_afbc(plane, fb->modifier);
 
 	offset = (src->x1 >> 16) * fb->format->cpp[0];
@@ -1405,7 +1878,8 @@ static void vop2_plane_atomic_update(struct drm_plane *plane,
 		else
 			vop2_win_write(win, VOP2_WIN_AFBC_AUTO_GATING_EN, 1);
 
-		vop2_win_write(win, VOP2_WIN_AFBC_BLOCK_SPLIT_EN, 0);
+		vop2_win_write(win, VOP2_WIN_AFBC_BLOCK_SPLIT_EN,
+			       !!(fb->modifier & AFBC_FORMAT_MOD_SPLIT));
 		transform_offset = vop2_afbc_transform_offset(pstate, half_block_en);
 		vop2_win_write(win, VOP2_WIN_AFBC_HDR_PTR, yrgb_mst);
 		vop2_win_write(win, VOP2_WIN_AFBC_PIC_SIZE, act_info);
@@ -1469,10 +1943,84 @@ static void vop2_plane_atomic_update(struct drm_plane *plane,
 	}
 }
 
+static int vop2_plane_atomic_async_check(struct drm_plane *plane,
+					 struct drm_atomic_state *state)
+{
+	struct drm_plane_state *new_plane_state = drm_atomic_get_new_plane_state(state,
+										 plane);
+	struct drm_crtc_state *crtc_state;
+
+	if (!new_plane_state->crtc || plane != new_plane_state->crtc->cursor)
+		return -EINVAL;
+
+	if (!plane->state || !plane->state->fb || !plane->state->visible)
+		return -EINVAL;
+
+	/* Only position and framebuffer updates of a live window */
+	if (plane->state->crtc != new_plane_state->crtc)
+		return -EINVAL;
+
+	crtc_state = drm_atomic_get_existing_crtc_state(state, new_plane_state->crtc);
+
+	/* Special case for asynchronous cursor updates. */
+	if (!crtc_state)
+		crtc_state = plane->crtc->state;
+
+	return drm_atomic_helper_check_plane_state(plane->state, crtc_state,
+						   FRAC_16_16(1, 8),
+						   FRAC_16_16(8, 1),
+						   true, true);
+}
+
+static void vop2_plane_atomic_async_update(struct drm_plane *plane,
+					   struct drm_atomic_state *state)
+{
+	struct drm_plane_state *new_state = drm_atomic_get_new_plane_state(state,
+									   plane);
+	struct drm_crtc *crtc = plane->state->crtc;
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	struct drm_framebuffer *old_fb = plane->state->fb;
+
+	plane->state->crtc_x = new_state->crtc_x;
+	plane->state->crtc_y = new_state->crtc_y;
+	plane->state->crtc_h = new_state->crtc_h;
+	plane->state->crtc_w = new_state->crtc_w;
+	plane->state->src_x = new_state->src_x;
+	plane->state->src_y = new_state->src_y;
+	plane->state->src_h = new_state->src_h;
+	plane->state->src_w = new_state->src_w;
+	plane->state->src = new_state->src;
+	plane->state->dst = new_state->dst;
+	plane->state->visible = new_state->visible;
+	swap(plane->state->fb, new_state->fb);
+
+	if (!crtc->state->active)
+		return;
+
+	vop2_plane_atomic_update(plane, state);
+	vop2_cfg_done(vp);
+
+	/*
+	 * A scanout can still be occurring, so we can't drop the reference
+	 * to the old framebuffer. Hold a reference and let the vblank
+	 * handler release it once the new configuration has been latched.
+	 */
+	if (old_fb && plane->state->fb != old_fb) {
+		drm_framebuffer_get(old_fb);
+		WARN_ON(drm_crtc_vblank_get(crtc) != 0);
+		drm_flip_work_queue(&vp->fb_unref_work, old_fb);
+		spin_lock_irq(&crtc->dev->event_lock);
+		vp->fb_unref_pending = true;
+		spin_unlock_irq(&crtc->dev->event_lock);
+	}
+}
+
 static const struct drm_plane_helper_funcs vop2_plane_helper_funcs = {
 	.atomic_check = vop2_plane_atomic_check,
 	.atomic_update = vop2_plane_atomic_update,
 	.atomic_disable = vop2_plane_atomic_disable,
+	.atomic_async_check = vop2_plane_atomic_async_check,
+	.atomic_async_update = vop2_plane_atomic_async_update,
 };
 
 static const struct drm_plane_funcs vop2_plane_funcs = {
@@ -1533,7 +2081,8 @@ static void vop2_dither_setup(struct drm_crtc *crtc, u32 *dsp_ctrl)
 		break;
 	}
 
-	if (vcstate->output_mode != ROCKCHIP_OUT_MODE_AAAA)
+	if (vcstate->output_mode != ROCKCHIP_OUT_MODE_AAAA &&
+	    vcstate->bus_format != MEDIA_BUS_FMT_UYYVYY10_0_5X30)
 		*dsp_ctrl |= RK3568_VP_DSP_CTRL__PRE_DITHER_DOWN_EN;
 
 	*dsp_ctrl |= FIELD_PREP(RK3568_VP_DSP_CTRL__DITHER_DOWN_SEL,
@@ -1673,6 +2222,14 @@ static unsigned long rk3568_set_intf_mux(struct vop2_video_port *vp, int id, u32
 	vop2_writel(vop2, RK3568_DSP_IF_EN, die);
 	vop2_writel(vop2, RK3568_DSP_IF_POL, dip);
 
+	/*
+	 * YCbCr 4:2:0 is handed to the HDMI controller as two pixels
+	 * per cycle, so the dclk runs at half the pixel clock.
+	 */
+	if (id == ROCKCHIP_VOP2_EP_HDMI0 &&
+	    to_rockchip_crtc_state(crtc->state)->output_mode == ROCKCHIP_OUT_MODE_YUV420)
+		return crtc->state->adjusted_mode.crtc_clock * 500LL;
+
 	return crtc->state->adjusted_mode.crtc_clock  * 1000LL;
 }
 
@@ -1973,12 +2530,26 @@ static void vop2_crtc_atomic_enable(struct drm_crtc *crtc,
 	u32 val, polflags;
 	int ret;
 	struct drm_encoder *encoder;
+	struct drm_crtc_state *old_crtc_state = drm_atomic_get_old_crtc_state(state, crtc);
+	struct drm_plane *plane;
 
-	drm_dbg(vop2->drm, "Update mode to %dx%d%s%d, type: %d for vp%d\n",
-		hdisplay, vdisplay, mode->flags & DRM_MODE_FLAG_INTERLACE ? "i" : "p",
-		drm_mode_vrefresh(mode), vcstate->output_type, vp->id);
+	if (old_crtc_state && old_crtc_state->self_refresh_active) {
+		drm_crtc_vblank_on(crtc);
 
-	vop2_lock(vop2);
+		vop2_lock(vop2);
+		drm_atomic_crtc_for_each_plane(plane, crtc)
+			vop2_plane_atomic_update(plane, state);
+		vop2_cfg_done(vp);
+		vop2_unlock(vop2);
+
+		return;
+	}
+
+	drm_dbg(vop2->drm, "Update mode to %dx%d%s%d, type: %d for vp%d\n",
+		hdisplay, vdisplay, mode->flags & DRM_MODE_FLAG_INTERLACE ? "i" : "p",
+		drm_mode_vrefresh(mode), vcstate->output_type, vp->id);
+
+	vop2_lock(vop2);
 
 	ret = clk_prepare_enable(vp->dclk);
 	if (ret < 0) {
@@ -2006,7 +2577,12 @@ static void vop2_crtc_atomic_enable(struct drm_crtc *crtc,
 		polflags |= BIT(VSYNC_POSITIVE);
 
 	drm_for_each_encoder_mask(encoder, crtc->dev, crtc_state->encoder_mask) {
-		struct rockchip_encoder *rkencoder = to_rockchip_encoder(encoder);
+		struct rockchip_encoder *rkencoder;
+
+		if (encoder == &vop2->wb.conn.encoder)
+			continue;
+
+		rkencoder = to_rockchip_encoder(encoder);
 
 		/*
 		 * for drive a high resolution(4KP120, 8K), vop on rk3588/rk3576 need
@@ -2084,8 +2660,12 @@ static void vop2_crtc_atomic_enable(struct drm_crtc *crtc,
 	 */
 	if (vop2->pll_hdmiphy0 && clock <= VOP2_MAX_DCLK_RATE) {
 		drm_for_each_encoder_mask(encoder, crtc->dev, crtc_state->encoder_mask) {
-			struct rockchip_encoder *rkencoder = to_rockchip_encoder(encoder);
+			struct rockchip_encoder *rkencoder;
+
+			if (encoder == &vop2->wb.conn.encoder)
+				continue;
 
+			rkencoder = to_rockchip_encoder(encoder);
 			if (rkencoder->crtc_endpoint_id == ROCKCHIP_VOP2_EP_HDMI0) {
 				if (!vp->dclk_src)
 					vp->dclk_src = clk_get_parent(vp->dclk);
@@ -2112,13 +2692,125 @@ static void vop2_crtc_atomic_enable(struct drm_crtc *crtc,
 	vop2_unlock(vop2);
 }
 
+/*
+ * Peak fetch rate of a window in bytes per output line, times the number
+ * of output lines. Vertical down scaling by 2 or 4 and more skips source
+ * lines (see vop2_setup_scale()), anything below that has to fetch more
+ * lines than it outputs, which is what overloads the bus.
+ */
+static u64 vop2_plane_line_bytes(const struct drm_plane_state *pstate)
+{
+	const struct drm_format_info *info = pstate->fb->format;
+	u32 src_w = drm_rect_width(&pstate->src) >> 16;
+	u32 src_h = drm_rect_height(&pstate->src) >> 16;
+	u32 dst_h = drm_rect_height(&pstate->dst);
+	u64 bytes = 0;
+	int i;
+
+	if (src_h >= 4 * dst_h)
+		src_h >>= 2;
+	else if (src_h >= 2 * dst_h)
+		src_h >>= 1;
+
+	for (i = 0; i < info->num_planes; i++) {
+		unsigned int hsub = i ? info->hsub : 1;
+		unsigned int vsub = i ? info->vsub : 1;
+		unsigned int bpp = drm_format_info_bpp(info, i);
+
+		/* AFBC only YUV formats have no per pixel size */
+		if (!bpp)
+			bpp = 32;
+
+		bytes += (u64)DIV_ROUND_UP(src_w, hsub) * bpp / 8 *
+			 DIV_ROUND_UP(src_h, vsub);
+	}
+
+	return bytes;
+}
+
+static struct drm_private_state *
+vop2_bw_duplicate_state(struct drm_private_obj *obj)
+{
+	struct vop2_bw_state *state;
+
+	state = kmemdup(obj->state, sizeof(*state), GFP_KERNEL);
+	if (!state)
+		return NULL;
+
+	__drm_atomic_helper_private_obj_duplicate_state(obj, &state->base);
+
+	return &state->base;
+}
+
+static void vop2_bw_destroy_state(struct drm_private_obj *obj,
+				  struct drm_private_state *state)
+{
+	kfree(to_vop2_bw_state(state));
+}
+
+static const struct drm_private_state_funcs vop2_bw_state_funcs = {
+	.atomic_duplicate_state = vop2_bw_duplicate_state,
+	.atomic_destroy_state = vop2_bw_destroy_state,
+};
+
+static int vop2_bw_init(struct vop2 *vop2)
+{
+	struct vop2_bw_state *state;
+
+	state = kzalloc(sizeof(*state), GFP_KERNEL);
+	if (!state)
+		return -ENOMEM;
+
+	drm_atomic_private_obj_init(vop2->drm, &vop2->bw_obj, &state->base,
+				    &vop2_bw_state_funcs);
+
+	return 0;
+}
+
+/* Predicted DDR load of a single plane in bytes/s */
+static u64 vop2_plane_bandwidth(const struct drm_crtc_state *crtc_state,
+				const struct drm_plane_state *pstate)
+{
+	const struct drm_display_mode *mode = &crtc_state->adjusted_mode;
+	u32 dst_h = drm_rect_height(&pstate->dst);
+	u64 line_rate;
+
+	if (!crtc_state->active || !mode->crtc_htotal ||
+	    !pstate->visible || !pstate->fb || !dst_h)
+		return 0;
+
+	line_rate = div_u64((u64)mode->crtc_clock * 1000, mode->crtc_htotal);
+
+	return div_u64(vop2_plane_line_bytes(pstate) * line_rate, dst_h);
+}
+
+/* Predicted peak DDR load of a video port in MB/s */
+static u32 vop2_crtc_bandwidth(struct drm_crtc_state *crtc_state)
+{
+	const struct drm_plane_state *pstate;
+	struct drm_plane *plane;
+	u64 bw = 0;
+
+	drm_atomic_crtc_state_for_each_plane_state(plane, pstate, crtc_state)
+		bw += vop2_plane_bandwidth(crtc_state, pstate);
+
+	return div_u64(bw, 1000000);
+}
+
 static int vop2_crtc_atomic_check(struct drm_crtc *crtc,
 				  struct drm_atomic_state *state)
 {
 	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	struct vop2 *vop2 = vp->vop2;
 	struct drm_plane *plane;
 	int nplanes = 0;
 	struct drm_crtc_state *crtc_state = drm_atomic_get_new_crtc_state(state, crtc);
+	struct drm_crtc_state *old_crtc_state = drm_atomic_get_old_crtc_state(state, crtc);
+	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(crtc_state);
+	struct drm_private_state *priv_state;
+	struct vop2_bw_state *bw_state;
+	u32 total = 0;
+	int i;
 
 	drm_atomic_crtc_state_for_each_plane(plane, crtc_state)
 		nplanes++;
@@ -2126,6 +2818,49 @@ static int vop2_crtc_atomic_check(struct drm_crtc *crtc,
 	if (nplanes > vp->nlayers)
 		return -EINVAL;
 
+	vcstate->bandwidth = vop2_crtc_bandwidth(crtc_state);
+
+	if (!vop2->data->max_bandwidth)
+		return 0;
+
+	/* An unchanged load can't break the budget, and needs no update */
+	if (vcstate->bandwidth == to_rockchip_crtc_state(old_crtc_state)->bandwidth)
+		return 0;
+
+	priv_state = drm_atomic_get_private_obj_state(state, &vop2->bw_obj);
+	if (IS_ERR(priv_state))
+		return PTR_ERR(priv_state);
+
+	bw_state = to_vop2_bw_state(priv_state);
+	bw_state->vp[vp - vop2->vps] = vcstate->bandwidth;
+
+	/*
+	 * All video ports fetch through the same AXI ports. Take the other
+	 * video ports into account with their new state if they are part of
+	 * this commit, or with the load they were last checked with, which
+	 * the private object lock keeps stable, otherwise.
+	 */
+	for (i = 0; i < vop2->data->nr_vps; i++) {
+		struct vop2_video_port *other = &vop2->vps[i];
+		struct drm_crtc_state *other_state;
+
+		if (!other->crtc.dev)
+			continue;
+
+		other_state = drm_atomic_get_new_crtc_state(state, &other->crtc);
+		if (other != vp && other_state)
+			total += vop2_crtc_bandwidth(other_state);
+		else
+			total += bw_state->vp[i];
+	}
+
+	if (total > vop2->data->max_bandwidth) {
+		drm_dbg_kms(vop2->drm,
+			    "vp%d: predicted load %u MB/s exceeds %u MB/s\n",
+			    vp->id, total, vop2->data->max_bandwidth);
+		return -ENOSPC;
+	}
+
 	return 0;
 }
 
@@ -2551,6 +3286,297 @@ static void vop2_setup_dly_for_windows(struct vop2 *vop2)
 	vop2_writel(vop2, RK3568_SMART_DLY_NUM, sdly);
 }
 
+static int vop2_convert_wb_format(u32 format)
+{
+	switch (format) {
+	case DRM_FORMAT_XRGB8888:
+	case DRM_FORMAT_ARGB8888:
+		return VOP2_WB_ARGB8888;
+	case DRM_FORMAT_RGB565:
+		return VOP2_WB_RGB565;
+	case DRM_FORMAT_NV12:
+		return VOP2_WB_YUV420SP;
+	default:
+		DRM_ERROR("unsupported writeback format[%08x]\n", format);
+		return VOP2_WB_INVALID;
+	}
+}
+
+static struct vop2 *wb_conn_to_vop2(struct drm_connector *connector)
+{
+	struct drm_writeback_connector *wb_conn = drm_connector_to_writeback(connector);
+
+	return container_of(wb_conn, struct vop2, wb.conn);
+}
+
+static int vop2_wb_connector_get_modes(struct drm_connector *connector)
+{
+	struct vop2 *vop2 = wb_conn_to_vop2(connector);
+	const struct vop_rect *max_output = &vop2->data->wb->max_output;
+
+	return drm_add_modes_noedid(connector, max_output->width,
+				    max_output->height);
+}
+
+static const struct drm_connector_helper_funcs vop2_wb_connector_helper_funcs = {
+	.get_modes = vop2_wb_connector_get_modes,
+};
+
+static const struct drm_connector_funcs vop2_wb_connector_funcs = {
+	.reset = drm_atomic_helper_connector_reset,
+	.fill_modes = drm_helper_probe_single_connector_modes,
+	.destroy = drm_connector_cleanup,
+	.atomic_duplicate_state = drm_atomic_helper_connector_duplicate_state,
+	.atomic_destroy_state = drm_atomic_helper_connector_destroy_state,
+};
+
+static int vop2_wb_encoder_atomic_check(struct drm_encoder *encoder,
+					struct drm_crtc_state *crtc_state,
+					struct drm_connector_state *conn_state)
+{
+	struct vop2 *vop2 = wb_conn_to_vop2(conn_state->connector);
+	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(crtc_state);
+	const struct vop_rect *max_output = &vop2->data->wb->max_output;
+	struct drm_display_mode *mode = &crtc_state->adjusted_mode;
+	struct drm_framebuffer *fb;
+
+	if (!conn_state->writeback_job || !conn_state->writeback_job->fb)
+		return 0;
+
+	fb = conn_state->writeback_job->fb;
+
+	/*
+	 * The writeback only taps the mixer output of a video port that
+	 * drives a display, it can't run the timing generator on its own.
+	 */
+	if (hweight32(crtc_state->connector_mask) < 2) {
+		drm_dbg_kms(vop2->drm, "writeback needs an active display output\n");
+		return -EINVAL;
+	}
+
+	/* Jobs are retired by frame start, one per frame at most */
+	if (crtc_state->async_flip)
+		return -EINVAL;
+
+	if (fb->width != mode->hdisplay || fb->height != mode->vdisplay) {
+		drm_dbg_kms(vop2->drm, "writeback scaling is not supported: %dx%d -> %dx%d\n",
+			    mode->hdisplay, mode->vdisplay, fb->width, fb->height);
+		return -EINVAL;
+	}
+
+	if (fb->width > max_output->width || fb->height > max_output->height) {
+		drm_dbg_kms(vop2->drm, "writeback size %dx%d exceeds %dx%d\n",
+			    fb->width, fb->height, max_output->width,
+			    max_output->height);
+		return -EINVAL;
+	}
+
+	if (fb->modifier != DRM_FORMAT_MOD_LINEAR ||
+	    vop2_convert_wb_format(fb->format->format) == VOP2_WB_INVALID)
+		return -EINVAL;
+
+	/* There is no stride register, lines are written back to back */
+	if (fb->pitches[0] != fb->width * fb->format->cpp[0] ||
+	    (fb->format->num_planes > 1 && fb->pitches[1] != fb->pitches[0])) {
+		drm_dbg_kms(vop2->drm, "writeback needs a packed framebuffer\n");
+		return -EINVAL;
+	}
+
+	/* The mixer output can be converted to YUV, but not back to RGB */
+	if (is_yuv_output(vcstate->bus_format) && !fb->format->is_yuv) {
+		drm_dbg_kms(vop2->drm, "writeback of a YUV video port must be YUV\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static const struct drm_encoder_helper_funcs vop2_wb_encoder_helper_funcs = {
+	.atomic_check = vop2_wb_encoder_atomic_check,
+};
+
+static int vop2_wb_connector_init(struct vop2 *vop2, u32 possible_crtcs)
+{
+	const struct vop2_wb_data *wb_data = vop2->data->wb;
+	struct vop2_wb *wb = &vop2->wb;
+	int ret;
+
+	spin_lock_init(&wb->job_lock);
+
+	ret = drm_writeback_connector_init(vop2->drm, &wb->conn,
+					   &vop2_wb_connector_funcs,
+					   &vop2_wb_encoder_helper_funcs,
+					   wb_data->formats, wb_data->nformats,
+					   possible_crtcs);
+	if (ret)
+		return ret;
+
+	drm_connector_helper_add(&wb->conn.base, &vop2_wb_connector_helper_funcs);
+
+	return 0;
+}
+
+static void vop2_wb_connector_fini(struct vop2 *vop2)
+{
+	drm_connector_cleanup(&vop2->wb.conn.base);
+	drm_encoder_cleanup(&vop2->wb.conn.encoder);
+}
+
+static void vop2_wb_begin(struct vop2_video_port *vp)
+{
+	struct vop2_wb *wb = &vp->vop2->wb;
+
+	if (!vp->vop2->data->wb)
+		return;
+
+	spin_lock_irq(&wb->job_lock);
+	wb->busy |= BIT(vp->id);
+	spin_unlock_irq(&wb->job_lock);
+}
+
+/*
+ * Program the writeback for the commit being flushed on @vp. This runs
+ * before cfg_done, so the new configuration is latched together with the
+ * planes at the next frame start. Returns true if a job was queued.
+ */
+static bool vop2_wb_commit(struct vop2_video_port *vp)
+{
+	struct vop2 *vop2 = vp->vop2;
+	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(vp->crtc.state);
+	struct vop2_wb *wb = &vop2->wb;
+	struct drm_connector_state *conn_state;
+	struct rockchip_gem_object *rk_obj;
+	struct drm_framebuffer *fb;
+	dma_addr_t yrgb_mst, uv_mst = 0;
+	u32 wb_ctrl, fifo_throd;
+
+	if (!vop2->data->wb)
+		return false;
+
+	conn_state = wb->conn.base.state;
+	if (!conn_state || conn_state->crtc != &vp->crtc ||
+	    !conn_state->writeback_job || !conn_state->writeback_job->fb) {
+		spin_lock_irq(&wb->job_lock);
+		if (wb->enabled && wb->vp == vp) {
+			vop2_writel(vop2, RK3568_WB_CTRL, 0);
+			wb->enabled = false;
+		}
+		spin_unlock_irq(&wb->job_lock);
+
+		return false;
+	}
+
+	fb = conn_state->writeback_job->fb;
+
+	rk_obj = to_rockchip_obj(fb->obj[0]);
+	yrgb_mst = rk_obj->dma_addr + fb->offsets[0];
+	if (fb->format->num_planes > 1) {
+		rk_obj = to_rockchip_obj(fb->obj[1]);
+		uv_mst = rk_obj->dma_addr + fb->offsets[1];
+	}
+
+	fifo_throd = min_t(u32, fb->pitches[0] >> 4,
+			   FIELD_MAX(RK3568_WB_XSCAL_FACTOR__FIFO_THROD));
+
+	wb_ctrl = RK3568_WB_CTRL__EN;
+	wb_ctrl |= FIELD_PREP(RK3568_WB_CTRL__FORMAT,
+			      vop2_convert_wb_format(fb->format->format));
+	if (fb->format->is_yuv && !vcstate->yuv_overlay)
+		wb_ctrl |= RK3568_WB_CTRL__R2Y_EN;
+	if (fb->format->format == DRM_FORMAT_RGB565)
+		wb_ctrl |= RK3568_WB_CTRL__DITHER_EN;
+
+	WARN_ON(drm_crtc_vblank_get(&vp->crtc));
+
+	spin_lock_irq(&wb->job_lock);
+
+	/* The source port selection takes effect immediately */
+	regmap_update_bits(vop2->map, RK3568_LUT_PORT_SEL,
+			   RK3568_LUT_PORT_SEL__WB_PORT_SEL,
+			   FIELD_PREP(RK3568_LUT_PORT_SEL__WB_PORT_SEL, vp->id));
+
+	vop2_writel(vop2, RK3568_WB_YRGB_MST, yrgb_mst);
+	vop2_writel(vop2, RK3568_WB_CBR_MST, uv_mst);
+	vop2_writel(vop2, RK3568_WB_XSCAL_FACTOR,
+		    FIELD_PREP(RK3568_WB_XSCAL_FACTOR__FIFO_THROD, fifo_throd));
+	vop2_writel(vop2, RK3568_WB_CTRL, wb_ctrl);
+
+	wb->vp = vp;
+	wb->enabled = true;
+
+	spin_unlock_irq(&wb->job_lock);
+
+	drm_writeback_queue_job(&wb->conn, conn_state);
+
+	return true;
+}
+
+/*
+ * Account the job only once cfg_done has been written: a frame start that
+ * races with the flush must not be counted as the one latching the job.
+ */
+static void vop2_wb_commit_done(struct vop2_video_port *vp, bool queued)
+{
+	struct vop2_wb *wb = &vp->vop2->wb;
+
+	if (!vp->vop2->data->wb)
+		return;
+
+	spin_lock_irq(&wb->job_lock);
+
+	if (queued) {
+		if (WARN_ON_ONCE(wb->njobs == VOP2_WB_JOB_MAX))
+			vop2_wb_retire_job(wb, -EBUSY);
+
+		wb->jobs[wb->njobs].vp = vp;
+		wb->jobs[wb->njobs].fs_cnt = 0;
+		wb->njobs++;
+	}
+
+	wb->busy &= ~BIT(vp->id);
+
+	spin_unlock_irq(&wb->job_lock);
+}
+
+/*
+ * A job is latched at the first frame start after its commit and the
+ * frame is completely in memory at the second one.
+ */
+static void vop2_wb_handler(struct vop2_video_port *vp)
+{
+	struct vop2 *vop2 = vp->vop2;
+	struct vop2_wb *wb = &vop2->wb;
+	struct vop2_wb_job *last;
+	unsigned int i;
+
+	if (!vop2->data->wb)
+		return;
+
+	spin_lock(&wb->job_lock);
+
+	for (i = 0; i < wb->njobs; i++)
+		if (wb->jobs[i].vp == vp)
+			wb->jobs[i].fs_cnt++;
+
+	while (wb->njobs && wb->jobs[0].fs_cnt >= 2)
+		vop2_wb_retire_job(wb, 0);
+
+	/*
+	 * The last job is being captured now. Unless a new commit is on its
+	 * way, stop the writeback after this frame so the buffer isn't
+	 * overwritten once it has been handed back.
+	 */
+	last = wb->njobs ? &wb->jobs[wb->njobs - 1] : NULL;
+	if (last && last->vp == vp && last->fs_cnt == 1 && wb->enabled &&
+	    wb->vp == vp && !(wb->busy & BIT(vp->id))) {
+		vop2_writel(vop2, RK3568_WB_CTRL, 0);
+		vop2_cfg_done(vp);
+		wb->enabled = false;
+	}
+
+	spin_unlock(&wb->job_lock);
+}
+
 static void vop2_crtc_atomic_begin(struct drm_crtc *crtc,
 				   struct drm_atomic_state *state)
 {
@@ -2558,6 +3584,8 @@ static void vop2_crtc_atomic_begin(struct drm_crtc *crtc,
 	struct vop2 *vop2 = vp->vop2;
 	struct drm_plane *plane;
 
+	vop2_wb_begin(vp);
+
 	vp->win_mask = 0;
 
 	drm_atomic_crtc_for_each_plane(plane, crtc) {
@@ -2583,16 +3611,35 @@ static void vop2_crtc_atomic_flush(struct drm_crtc *crtc,
 				   struct drm_atomic_state *state)
 {
 	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	bool wb_queued;
 
 	vop2_post_config(crtc);
 
+	WRITE_ONCE(vp->bandwidth, to_rockchip_crtc_state(crtc->state)->bandwidth);
+	vop2_dmc_update(vp->vop2);
+
+	wb_queued = vop2_wb_commit(vp);
+
 	vop2_cfg_done(vp);
 
+	vop2_wb_commit_done(vp, wb_queued);
+
 	spin_lock_irq(&crtc->dev->event_lock);
 
 	if (crtc->state->event) {
-		WARN_ON(drm_crtc_vblank_get(crtc));
-		vp->event = crtc->state->event;
+		if (crtc->state->async_flip) {
+			/*
+			 * Don't hold back the completion of an async flip
+			 * until the frame start that latches it, so that the
+			 * next one can be queued right away. The atomic helpers
+			 * still wait for a vblank before the old framebuffers
+			 * are released.
+			 */
+			drm_crtc_send_vblank_event(crtc, crtc->state->event);
+		} else {
+			WARN_ON(drm_crtc_vblank_get(crtc));
+			vp->event = crtc->state->event;
+		}
 		crtc->state->event = NULL;
 	}
 
@@ -2648,6 +3695,124 @@ static void vop2_crtc_reset(struct drm_crtc *crtc)
 		__drm_atomic_helper_crtc_reset(crtc, NULL);
 }
 
+static int vop2_bandwidth_show(struct seq_file *s, void *data)
+{
+	struct vop2_video_port *vp = s->private;
+	struct vop2 *vop2 = vp->vop2;
+	u32 total = 0;
+	int i;
+
+	for (i = 0; i < vop2->data->nr_vps; i++)
+		total += READ_ONCE(vop2->vps[i].bandwidth);
+
+	seq_printf(s, "vp%d: %u MB/s\n", vp->id, READ_ONCE(vp->bandwidth));
+	seq_printf(s, "total: %u MB/s\n", total);
+	seq_printf(s, "limit: %u MB/s\n", vop2->data->max_bandwidth);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vop2_bandwidth);
+
+static const char *vop2_scl_mode_name(enum scale_mode mode)
+{
+	switch (mode) {
+	case SCALE_UP:
+		return "up";
+	case SCALE_DOWN:
+		return "down";
+	default:
+		return "none";
+	}
+}
+
+/*
+ * Report how the committed planes of a video port are handled by the
+ * scaler and CSC units, and what each of them is predicted to cost in
+ * DDR bandwidth. Combined with TEST_ONLY commits and the DFI counters
+ * this lets userspace measure which layer setups are cheaper to leave
+ * to the VOP than to composite on the GPU.
+ */
+static int vop2_planes_show(struct seq_file *s, void *data)
+{
+	struct vop2_video_port *vp = s->private;
+	struct drm_crtc *crtc = &vp->crtc;
+	struct drm_crtc_state *crtc_state;
+	struct drm_plane *plane;
+
+	drm_modeset_lock_all(crtc->dev);
+
+	crtc_state = crtc->state;
+	if (!crtc_state->active)
+		goto out;
+
+	drm_atomic_crtc_state_for_each_plane(plane, crtc_state) {
+		struct drm_plane_state *pstate = plane->state;
+		struct vop2_win *win = to_vop2_win(plane);
+		u32 src_w, src_h, dst_w, dst_h, vsd_h;
+		bool y2r_en, r2y_en;
+		const char *vsd;
+		int csc_mode;
+
+		if (!pstate->visible || !pstate->fb)
+			continue;
+
+		src_w = drm_rect_width(&pstate->src) >> 16;
+		src_h = drm_rect_height(&pstate->src) >> 16;
+		dst_w = drm_rect_width(&pstate->dst);
+		dst_h = drm_rect_height(&pstate->dst);
+
+		if (pstate->rotation & (DRM_MODE_ROTATE_90 | DRM_MODE_ROTATE_270))
+			swap(src_w, src_h);
+
+		/* vertical pre-scale down (see vop2_setup_scale()) */
+		if (src_h >= 4 * dst_h) {
+			vsd = "gt4";
+			vsd_h = src_h >> 2;
+		} else if (src_h >= 2 * dst_h) {
+			vsd = "gt2";
+			vsd_h = src_h >> 1;
+		} else {
+			vsd = "none";
+			vsd_h = src_h;
+		}
+
+		csc_mode = vop2_get_csc_mode(vp, pstate, &y2r_en, &r2y_en);
+
+		seq_printf(s, "%s: %p4cc%s %ux%u -> %ux%u\n", win->data->name,
+			   &pstate->fb->format->format,
+			   rockchip_afbc(plane, pstate->fb->modifier) ? " afbc" : "",
+			   src_w, src_h, dst_w, dst_h);
+		seq_printf(s, "\tscale: hor %s ver %s vsd %s\n",
+			   vop2_scl_mode_name(scl_get_scl_mode(src_w, dst_w)),
+			   vop2_scl_mode_name(scl_get_scl_mode(vsd_h, dst_h)),
+			   vsd);
+		if (vop2_cluster_window(win))
+			seq_printf(s, "\tline buffer mode: %d\n",
+				   vop2_get_cluster_lb_mode(win, pstate));
+		seq_printf(s, "\tcsc: y2r %d r2y %d mode %d\n",
+			   y2r_en, r2y_en, csc_mode);
+		seq_printf(s, "\tbandwidth: %llu MB/s\n",
+			   div_u64(vop2_plane_bandwidth(crtc_state, pstate),
+				   1000000));
+	}
+
+out:
+	drm_modeset_unlock_all(crtc->dev);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vop2_planes);
+
+static int vop2_crtc_late_register(struct drm_crtc *crtc)
+{
+	debugfs_create_file("bandwidth", 0444, crtc->debugfs_entry,
+			    to_vop2_video_port(crtc), &vop2_bandwidth_fops);
+	debugfs_create_file("planes", 0444, crtc->debugfs_entry,
+			    to_vop2_video_port(crtc), &vop2_planes_fops);
+
+	return 0;
+}
+
 static const struct drm_crtc_funcs vop2_crtc_funcs = {
 	.set_config = drm_atomic_helper_set_config,
 	.page_flip = drm_atomic_helper_page_flip,
@@ -2657,6 +3822,7 @@ static const struct drm_crtc_funcs vop2_crtc_funcs = {
 	.atomic_destroy_state = vop2_crtc_destroy_state,
 	.enable_vblank = vop2_crtc_enable_vblank,
 	.disable_vblank = vop2_crtc_disable_vblank,
+	.late_register = vop2_crtc_late_register,
 };
 
 static irqreturn_t vop2_isr(int irq, void *data)
@@ -2688,19 +3854,29 @@ static irqreturn_t vop2_isr(int irq, void *data)
 		}
 
 		if (irqs & VP_INT_FS_FIELD) {
+			bool fb_unref = false;
+
 			drm_crtc_handle_vblank(crtc);
 			spin_lock(&crtc->dev->event_lock);
 			if (vp->event) {
 				u32 val = vop2_readl(vop2, RK3568_REG_CFG_DONE);
 
 				if (!(val & BIT(vp->id))) {
+					trace_rockchip_vop2_flip_done(crtc);
 					drm_crtc_send_vblank_event(crtc, vp->event);
 					vp->event = NULL;
 					drm_crtc_vblank_put(crtc);
 				}
 			}
+			swap(fb_unref, vp->fb_unref_pending);
 			spin_unlock(&crtc->dev->event_lock);
 
+			if (fb_unref)
+				drm_flip_work_commit(&vp->fb_unref_work,
+						     system_unbound_wq);
+
+			vop2_wb_handler(vp);
+
 			ret = IRQ_HANDLED;
 		}
 
@@ -2756,12 +3932,43 @@ static int vop2_plane_init(struct vop2 *vop2, struct vop2_win *win,
 						   win->data->supported_rotations);
 	drm_plane_create_alpha_property(&win->base);
 	drm_plane_create_blend_mode_property(&win->base, blend_caps);
+	drm_plane_enable_fb_damage_clips(&win->base);
 	drm_plane_create_zpos_property(&win->base, win->win_id, 0,
 				       vop2->registered_num_wins - 1);
 
 	return 0;
 }
 
+static void vop2_fb_unref_worker(struct drm_flip_work *work, void *val)
+{
+	struct vop2_video_port *vp = container_of(work, struct vop2_video_port,
+						  fb_unref_work);
+	struct drm_framebuffer *fb = val;
+
+	drm_crtc_vblank_put(&vp->crtc);
+	drm_framebuffer_put(fb);
+}
+
+static struct vop2_video_port *find_vp_without_cursor(struct vop2 *vop2,
+						      unsigned int *crtc_index)
+{
+	int i;
+
+	*crtc_index = 0;
+	for (i = 0; i < vop2->data->nr_vps; i++) {
+		struct vop2_video_port *vp = &vop2->vps[i];
+
+		if (!vp->crtc.port)
+			continue;
+		if (!vp->cursor_plane)
+			return vp;
+
+		(*crtc_index)++;
+	}
+
+	return NULL;
+}
+
 static struct vop2_video_port *find_vp_without_primary(struct vop2 *vop2)
 {
 	int i;
@@ -2788,6 +3995,7 @@ static int vop2_create_crtcs(struct vop2 *vop2)
 	struct drm_plane *plane;
 	struct device_node *port;
 	struct vop2_video_port *vp;
+	unsigned int crtc_index;
 	int i, nvp, nvps = 0;
 	int ret;
 
@@ -2851,6 +4059,12 @@ static int vop2_create_crtcs(struct vop2 *vop2)
 				possible_crtcs = BIT(nvp);
 				vp->primary_plane = win;
 				nvp++;
+			} else if (cursor_plane &&
+				   (vp = find_vp_without_cursor(vop2, &crtc_index))) {
+				/* or use it as cursor of a single video port */
+				win->type = DRM_PLANE_TYPE_CURSOR;
+				possible_crtcs = BIT(crtc_index);
+				vp->cursor_plane = win;
 			} else {
 				/* change the unused primary window to overlay window */
 				win->type = DRM_PLANE_TYPE_OVERLAY;
@@ -2876,7 +4090,9 @@ static int vop2_create_crtcs(struct vop2 *vop2)
 
 		plane = &vp->primary_plane->base;
 
-		ret = drm_crtc_init_with_planes(drm, &vp->crtc, plane, NULL,
+		ret = drm_crtc_init_with_planes(drm, &vp->crtc, plane,
+						vp->cursor_plane ?
+						&vp->cursor_plane->base : NULL,
 						&vop2_crtc_funcs,
 						"video_port%d", vp->id);
 		if (ret) {
@@ -2886,6 +4102,15 @@ static int vop2_create_crtcs(struct vop2 *vop2)
 
 		drm_crtc_helper_add(&vp->crtc, &vop2_crtc_helper_funcs);
 
+		drm_flip_work_init(&vp->fb_unref_work, "fb_unref",
+				   vop2_fb_unref_worker);
+
+		ret = drm_self_refresh_helper_init(&vp->crtc);
+		if (ret)
+			drm_dbg_kms(vop2->drm,
+				    "Failed to init %s with SR helpers %d, ignoring\n",
+				    vp->crtc.name, ret);
+
 		init_completion(&vp->dsp_hold_completion);
 	}
 
@@ -2920,8 +4145,12 @@ static void vop2_destroy_crtcs(struct vop2 *vop2)
 	 * references the CRTC.
 	 */
 	list_for_each_entry_safe(crtc, tmpc, crtc_list, head) {
+		struct vop2_video_port *vp = to_vop2_video_port(crtc);
+
+		drm_self_refresh_helper_cleanup(crtc);
 		of_node_put(crtc->port);
 		drm_crtc_cleanup(crtc);
+		drm_flip_work_cleanup(&vp->fb_unref_work);
 	}
 }
 
@@ -3185,7 +4414,7 @@ static int vop2_bind(struct device *dev, struct device *master, void *data)
 	struct vop2 *vop2;
 	struct resource *res;
 	size_t alloc_size;
-	int ret;
+	int i, ret;
 
 	vop2_data = of_device_get_match_data(dev);
 	if (!vop2_data)
@@ -3276,6 +4505,10 @@ static int vop2_bind(struct device *dev, struct device *master, void *data)
 		return PTR_ERR(vop2->pll_hdmiphy0);
 	}
 
+	ret = vop2_qos_init(vop2);
+	if (ret)
+		return ret;
+
 	vop2->irq = platform_get_irq(pdev, 0);
 	if (vop2->irq < 0) {
 		drm_err(vop2->drm, "cannot find irq for vop2\n");
@@ -3283,15 +4516,39 @@ static int vop2_bind(struct device *dev, struct device *master, void *data)
 	}
 
 	mutex_init(&vop2->vop2_lock);
+	mutex_init(&vop2->dmc_lock);
+	INIT_DELAYED_WORK(&vop2->dmc_work, vop2_dmc_relax_work);
 
 	ret = devm_request_irq(dev, vop2->irq, vop2_isr, IRQF_SHARED, dev_name(dev), vop2);
 	if (ret)
 		return ret;
 
-	ret = vop2_create_crtcs(vop2);
+	ret = vop2_bw_init(vop2);
 	if (ret)
 		return ret;
 
+	ret = vop2_create_crtcs(vop2);
+	if (ret)
+		goto err_bw;
+
+	pm_runtime_enable(&pdev->dev);
+
+	vop2_handoff_init(vop2);
+
+	if (vop2_data->wb) {
+		u32 possible_crtcs = 0;
+
+		for (i = 0; i < vop2_data->nr_vps; i++)
+			if (vop2->vps[i].crtc.dev)
+				possible_crtcs |= drm_crtc_mask(&vop2->vps[i].crtc);
+
+		ret = vop2_wb_connector_init(vop2, possible_crtcs);
+		if (ret) {
+			drm_err(vop2->drm, "failed to init writeback connector: %d\n", ret);
+			goto err_crtcs;
+		}
+	}
+
 	ret = vop2_find_rgb_encoder(vop2);
 	if (ret >= 0) {
 		vop2->rgb = rockchip_rgb_init(dev, &vop2->vps[ret].crtc,
@@ -3299,7 +4556,7 @@ static int vop2_bind(struct device *dev, struct device *master, void *data)
 		if (IS_ERR(vop2->rgb)) {
 			if (PTR_ERR(vop2->rgb) == -EPROBE_DEFER) {
 				ret = PTR_ERR(vop2->rgb);
-				goto err_crtcs;
+				goto err_wb;
 			}
 			vop2->rgb = NULL;
 		}
@@ -3307,12 +4564,21 @@ static int vop2_bind(struct device *dev, struct device *master, void *data)
 
 	rockchip_drm_dma_init_device(vop2->drm, vop2->dev);
 
-	pm_runtime_enable(&pdev->dev);
+	/* Tearing flips of the primary plane, see vop2_crtc_atomic_flush() */
+	drm->mode_config.async_page_flip = true;
 
 	return 0;
 
+err_wb:
+	if (vop2_data->wb)
+		vop2_wb_connector_fini(vop2);
 err_crtcs:
+	for (i = 0; i < vop2_data->nr_vps; i++)
+		vop2_handoff_release(&vop2->vps[i]);
+	pm_runtime_disable(&pdev->dev);
 	vop2_destroy_crtcs(vop2);
+err_bw:
+	drm_atomic_private_obj_fini(&vop2->bw_obj);
 
 	return ret;
 }
@@ -3320,13 +4586,23 @@ static int vop2_bind(struct device *dev, struct device *master, void *data)
 static void vop2_unbind(struct device *dev, struct device *master, void *data)
 {
 	struct vop2 *vop2 = dev_get_drvdata(dev);
+	int i;
 
 	pm_runtime_disable(dev);
 
+	vop2_dmc_fini(vop2);
+
+	for (i = 0; i < vop2->data->nr_vps; i++)
+		vop2_handoff_release(&vop2->vps[i]);
+
 	if (vop2->rgb)
 		rockchip_rgb_fini(vop2->rgb);
 
+	if (vop2->data->wb)
+		vop2_wb_connector_fini(vop2);
+
 	vop2_destroy_crtcs(vop2);
+	drm_atomic_private_obj_fini(&vop2->bw_obj);
 }
 
 const struct component_ops vop2_component_ops = {
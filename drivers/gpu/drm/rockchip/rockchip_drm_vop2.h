@@ -163,13 +163,22 @@ struct vop2_video_port_data {
 	unsigned int offset;
 };
 
+struct vop2_wb_data {
+	u32 nformats;
+	const u32 *formats;
+	struct vop_rect max_output;
+};
+
 struct vop2_data {
 	u8 nr_vps;
 	u64 feature;
 	const struct vop2_win_data *win;
 	const struct vop2_video_port_data *vp;
+	const struct vop2_wb_data *wb;
 	struct vop_rect max_input;
 	struct vop_rect max_output;
+	/* DDR load in MB/s that all video ports can sustain together */
+	u32 max_bandwidth;
 
 	unsigned int win_size;
 	unsigned int soc_id;
@@ -194,6 +203,14 @@ struct vop2_data {
 #define WB_COMPLETE_INTR		BIT(19)
 
 
+enum vop2_wb_format {
+	VOP2_WB_ARGB8888,
+	VOP2_WB_BGR888,
+	VOP2_WB_RGB565,
+	VOP2_WB_YUV420SP = 4,
+	VOP2_WB_INVALID = -1,
+};
+
 enum vop_csc_format {
 	CSC_BT601L,
 	CSC_BT709L,
@@ -470,6 +487,20 @@ enum dst_factor_mode {
 #define RK3588_DSP_IF_POL__DP1_PIN_POL			GENMASK(14, 12)
 #define RK3588_DSP_IF_POL__DP0_PIN_POL			GENMASK(10, 8)
 
+#define RK3568_WB_CTRL__AXI_UV_ID			GENMASK(31, 27)
+#define RK3568_WB_CTRL__AXI_YRGB_ID			GENMASK(26, 19)
+#define RK3568_WB_CTRL__SCALE_Y_EN			BIT(8)
+#define RK3568_WB_CTRL__SCALE_X_EN			BIT(7)
+#define RK3568_WB_CTRL__R2Y_EN				BIT(5)
+#define RK3568_WB_CTRL__DITHER_EN			BIT(4)
+#define RK3568_WB_CTRL__FORMAT				GENMASK(3, 1)
+#define RK3568_WB_CTRL__EN				BIT(0)
+
+#define RK3568_WB_XSCAL_FACTOR__FACTOR			GENMASK(29, 16)
+#define RK3568_WB_XSCAL_FACTOR__FIFO_THROD		GENMASK(9, 0)
+
+#define RK3568_LUT_PORT_SEL__WB_PORT_SEL		GENMASK(9, 8)
+
 #define RK3568_VP0_MIPI_CTRL__DCLK_DIV2_PHASE_LOCK	BIT(5)
 #define RK3568_VP0_MIPI_CTRL__DCLK_DIV2			BIT(4)
 
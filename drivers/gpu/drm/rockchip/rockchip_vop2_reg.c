@@ -32,6 +32,13 @@ static const uint32_t formats_cluster[] = {
 	DRM_FORMAT_Y210, /* yuv422_10bit non-Linear mode only */
 };
 
+static const uint32_t formats_wb[] = {
+	DRM_FORMAT_XRGB8888,
+	DRM_FORMAT_ARGB8888,
+	DRM_FORMAT_RGB565,
+	DRM_FORMAT_NV12,
+};
+
 static const uint32_t formats_esmart[] = {
 	DRM_FORMAT_XRGB8888,
 	DRM_FORMAT_ARGB8888,
@@ -94,6 +101,23 @@ static const uint64_t format_modifiers[] = {
 	DRM_FORMAT_MOD_INVALID,
 };
 
+/*
+ * Only the cluster windows have an AFBC decoder, the Esmart and Smart
+ * windows of rk356x and rk3588 fetch linear buffers only.
+ *
+ * Mali Bifrost GPUs (rk356x Mali-G52, rk3588 Mali-G610) as driven by
+ * Mesa's panfrost render 16x16 AFBC with SPARSE, plus YTR for RGB formats
+ * and SPLIT for 32 bpp RGB formats. These buffers can be scanned out on
+ * a cluster window directly. The most compact choice for XRGB8888 and
+ * ARGB8888 is:
+ *
+ *   DRM_FORMAT_MOD_ARM_AFBC(AFBC_FORMAT_MOD_BLOCK_SIZE_16x16 |
+ *                           AFBC_FORMAT_MOD_YTR | AFBC_FORMAT_MOD_SPARSE |
+ *                           AFBC_FORMAT_MOD_SPLIT)
+ *
+ * YUV formats can't use YTR or SPLIT. 24 and 16 bpp RGB formats can't
+ * use SPLIT. See rockchip_vop2_mod_supported().
+ */
 static const uint64_t format_modifiers_afbc[] = {
 	DRM_FORMAT_MOD_ARM_AFBC(AFBC_FORMAT_MOD_BLOCK_SIZE_16x16),
 
@@ -462,14 +486,22 @@ static const struct vop2_win_data rk3588_vop_win_data[] = {
 	},
 };
 
+static const struct vop2_wb_data rk3568_vop_wb_data = {
+	.formats = formats_wb,
+	.nformats = ARRAY_SIZE(formats_wb),
+	.max_output = { 1920, 1080 },
+};
+
 static const struct vop2_data rk3566_vop = {
 	.feature = VOP2_FEATURE_HAS_SYS_GRF,
 	.nr_vps = 3,
 	.max_input = { 4096, 2304 },
 	.max_output = { 4096, 2304 },
+	.max_bandwidth = 5600,
 	.vp = rk3568_vop_video_ports,
 	.win = rk3568_vop_win_data,
 	.win_size = ARRAY_SIZE(rk3568_vop_win_data),
+	.wb = &rk3568_vop_wb_data,
 	.soc_id = 3566,
 };
 
@@ -478,9 +510,11 @@ static const struct vop2_data rk3568_vop = {
 	.nr_vps = 3,
 	.max_input = { 4096, 2304 },
 	.max_output = { 4096, 2304 },
+	.max_bandwidth = 5600,
 	.vp = rk3568_vop_video_ports,
 	.win = rk3568_vop_win_data,
 	.win_size = ARRAY_SIZE(rk3568_vop_win_data),
+	.wb = &rk3568_vop_wb_data,
 	.soc_id = 3568,
 };
 
@@ -490,6 +524,7 @@ static const struct vop2_data rk3588_vop = {
 	.nr_vps = 4,
 	.max_input = { 4096, 4320 },
 	.max_output = { 4096, 4320 },
+	.max_bandwidth = 12000,
 	.vp = rk3588_vop_video_ports,
 	.win = rk3588_vop_win_data,
 	.win_size = ARRAY_SIZE(rk3588_vop_win_data),
@@ -79,6 +79,11 @@ enum {
 #define WAIT_TIMEOUT      1000 /* ms */
 #define DEFAULT_SCL_RATE  (100 * 1000) /* Hz */
 
+static unsigned int polling_limit_us = 100;
+module_param(polling_limit_us, uint, 0664);
+MODULE_PARM_DESC(polling_limit_us,
+		 "time in us to run a transfer in polling mode");
+
 /**
  * struct i2c_spec_values - I2C specification values for various modes
  * @min_hold_start_ns: min hold time (repeated) START condition
@@ -184,6 +189,8 @@ struct rk3x_i2c_soc_data {
  * @wait: the waitqueue to wait for i2c transfer
  * @busy: the condition for the event to wait for
  * @msg: current i2c message
+ * @msgs: i2c messages of the transfer not set up yet
+ * @num: number of i2c messages left in @msgs
  * @addr: addr of i2c target device
  * @mode: mode of i2c transfer
  * @is_last_msg: flag determines whether it is the last msg in this transfer
@@ -213,6 +220,8 @@ struct rk3x_i2c {
 
 	/* Current message */
 	struct i2c_msg *msg;
+	struct i2c_msg *msgs;
+	int num;
 	u8 addr;
 	unsigned int mode;
 	bool is_last_msg;
@@ -260,6 +269,8 @@ static void rk3x_i2c_start(struct rk3x_i2c *i2c)
 	i2c_writel(i2c, val, REG_CON);
 }
 
+static int rk3x_i2c_setup_next(struct rk3x_i2c *i2c);
+
 /**
  * rk3x_i2c_stop - Generate a STOP condition, which triggers a REG_INT_STOP interrupt.
  * @i2c: target controller data
@@ -283,10 +294,6 @@ static void rk3x_i2c_stop(struct rk3x_i2c *i2c, int error)
 		ctrl |= REG_CON_STOP;
 		i2c_writel(i2c, ctrl, REG_CON);
 	} else {
-		/* Signal rk3x_i2c_xfer to start the next message. */
-		i2c->busy = false;
-		i2c->state = STATE_IDLE;
-
 		/*
 		 * The HW is actually not capable of REPEATED START. But we can
 		 * get the intended effect by resetting its internal state
@@ -295,7 +302,19 @@ static void rk3x_i2c_stop(struct rk3x_i2c *i2c, int error)
 		ctrl = i2c_readl(i2c, REG_CON) & REG_CON_TUNING_MASK;
 		i2c_writel(i2c, ctrl, REG_CON);
 
-		/* signal that we are finished with the current msg */
+		/*
+		 * Chain the next message right away instead of waking up
+		 * rk3x_i2c_xfer for each of them.
+		 */
+		if (!error && rk3x_i2c_setup_next(i2c) > 0) {
+			rk3x_i2c_start(i2c);
+			return;
+		}
+
+		i2c->busy = false;
+		i2c->state = STATE_IDLE;
+
+		/* signal rk3x_i2c_xfer that we are finished */
 		wake_up(&i2c->wait);
 	}
 }
@@ -1043,9 +1062,37 @@ static int rk3x_i2c_setup(struct rk3x_i2c *i2c, struct i2c_msg *msgs, int num)
 	return ret;
 }
 
-static int rk3x_i2c_wait_xfer_poll(struct rk3x_i2c *i2c)
+/**
+ * rk3x_i2c_setup_next - Setup the next message(s) of the transfer
+ * @i2c: target controller data
+ *
+ * Must be called with i2c->lock held.
+ *
+ * Return: Number of I2C msgs set up, 0 if none is left or negative in case
+ * of error
+ */
+static int rk3x_i2c_setup_next(struct rk3x_i2c *i2c)
+{
+	int ret;
+
+	if (!i2c->num)
+		return 0;
+
+	ret = rk3x_i2c_setup(i2c, i2c->msgs, i2c->num);
+	if (ret < 0)
+		return ret;
+
+	i2c->msgs += ret;
+	i2c->num -= ret;
+	i2c->is_last_msg = !i2c->num;
+
+	return ret;
+}
+
+static int rk3x_i2c_wait_xfer_poll(struct rk3x_i2c *i2c,
+				   unsigned int timeout_us)
 {
-	ktime_t timeout = ktime_add_ms(ktime_get(), WAIT_TIMEOUT);
+	ktime_t timeout = ktime_add_us(ktime_get(), timeout_us);
 
 	while (READ_ONCE(i2c->busy) &&
 	       ktime_compare(ktime_get(), timeout) < 0) {
@@ -1057,37 +1104,32 @@ static int rk3x_i2c_wait_xfer_poll(struct rk3x_i2c *i2c)
 }
 
 static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
-				struct i2c_msg *msgs, int num, bool polling)
+				struct i2c_msg *msgs, int num, bool polling,
+				bool atomic)
 {
 	struct rk3x_i2c *i2c = (struct rk3x_i2c *)adap->algo_data;
 	unsigned long flags;
 	long time_left;
 	u32 val;
 	int ret = 0;
-	int i;
 
 	spin_lock_irqsave(&i2c->lock, flags);
 
 	clk_enable(i2c->clk);
 	clk_enable(i2c->pclk);
 
-	i2c->is_last_msg = false;
+	i2c->msgs = msgs;
+	i2c->num = num;
 
 	/*
 	 * Process msgs. We can handle more than one message at once (see
-	 * rk3x_i2c_setup()).
+	 * rk3x_i2c_setup()), and the following ones are set up as soon as
+	 * the previous ones are done (see rk3x_i2c_stop()).
 	 */
-	for (i = 0; i < num; i += ret) {
-		ret = rk3x_i2c_setup(i2c, msgs + i, num - i);
-
-		if (ret < 0) {
-			dev_err(i2c->dev, "rk3x_i2c_setup() failed\n");
-			break;
-		}
-
-		if (i + ret >= num)
-			i2c->is_last_msg = true;
-
+	ret = rk3x_i2c_setup_next(i2c);
+	if (ret < 0) {
+		dev_err(i2c->dev, "rk3x_i2c_setup() failed\n");
+	} else {
 		spin_unlock_irqrestore(&i2c->lock, flags);
 
 		if (!polling) {
@@ -1099,9 +1141,21 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 			disable_irq(i2c->irq);
 			rk3x_i2c_start(i2c);
 
-			time_left = rk3x_i2c_wait_xfer_poll(i2c);
+			/*
+			 * Outside of atomic context only spin for about the
+			 * expected wire time, then leave a transfer that is
+			 * held up, e.g. by clock stretching, to the IRQ.
+			 */
+			time_left = rk3x_i2c_wait_xfer_poll(i2c, atomic ?
+					WAIT_TIMEOUT * USEC_PER_MSEC :
+					2 * READ_ONCE(polling_limit_us));
 
 			enable_irq(i2c->irq);
+
+			if (!time_left && !atomic)
+				time_left = wait_event_timeout(i2c->wait,
+						!i2c->busy,
+						msecs_to_jiffies(WAIT_TIMEOUT));
 		}
 
 		spin_lock_irqsave(&i2c->lock, flags);
@@ -1116,12 +1170,8 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 			i2c->state = STATE_IDLE;
 
 			ret = -ETIMEDOUT;
-			break;
-		}
-
-		if (i2c->error) {
+		} else if (i2c->error) {
 			ret = i2c->error;
-			break;
 		}
 	}
 
@@ -1133,16 +1183,41 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 	return ret < 0 ? ret : num;
 }
 
+/*
+ * Short transfers are done sooner than the IRQ and the wakeup of the
+ * caller would take, so spin for them. rk3x_i2c_xfer_common() falls
+ * back to the IRQ if the spin runs out.
+ */
+static bool rk3x_i2c_can_poll(struct rk3x_i2c *i2c,
+			      struct i2c_msg *msgs, int num)
+{
+	u64 bits = 0;
+	int i;
+
+	if (!polling_limit_us)
+		return false;
+
+	/* Address and data bytes, each with its ACK bit */
+	for (i = 0; i < num; i++)
+		bits += (msgs[i].len + 1) * 9;
+
+	return div_u64(bits * USEC_PER_SEC, i2c->t.bus_freq_hz) <=
+	       polling_limit_us;
+}
+
 static int rk3x_i2c_xfer(struct i2c_adapter *adap,
 			 struct i2c_msg *msgs, int num)
 {
-	return rk3x_i2c_xfer_common(adap, msgs, num, false);
+	struct rk3x_i2c *i2c = (struct rk3x_i2c *)adap->algo_data;
+
+	return rk3x_i2c_xfer_common(adap, msgs, num,
+				    rk3x_i2c_can_poll(i2c, msgs, num), false);
 }
 
 static int rk3x_i2c_xfer_polling(struct i2c_adapter *adap,
 				 struct i2c_msg *msgs, int num)
 {
-	return rk3x_i2c_xfer_common(adap, msgs, num, true);
+	return rk3x_i2c_xfer_common(adap, msgs, num, true, true);
 }
 
 static __maybe_unused int rk3x_i2c_resume(struct device *dev)
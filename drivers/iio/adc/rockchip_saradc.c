@@ -10,6 +10,7 @@
 #include <linux/platform_device.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
 #include <linux/of.h>
 #include <linux/clk.h>
 #include <linux/completion.h>
@@ -36,6 +37,7 @@
 #define SARADC_DLY_PU_SOC_MASK		0x3f
 
 #define SARADC_TIMEOUT			msecs_to_jiffies(100)
+#define SARADC_POLL_TIMEOUT_US		1000
 #define SARADC_MAX_CHANNELS		8
 
 /* v2 registers */
@@ -62,6 +64,7 @@ struct rockchip_saradc_data {
 	unsigned long			clk_rate;
 	void (*start)(struct rockchip_saradc *info, int chn);
 	int (*read)(struct rockchip_saradc *info);
+	int (*read_polled)(struct rockchip_saradc *info, int chn);
 	void (*power_down)(struct rockchip_saradc *info);
 };
 
@@ -121,6 +124,34 @@ static int rockchip_saradc_read_v1(struct rockchip_saradc *info)
 	return readl_relaxed(info->regs + SARADC_DATA);
 }
 
+/*
+ * Run a conversion without the end-of-conversion interrupt. A conversion
+ * only takes a few tens of converter clock cycles, so busy-waiting for it
+ * is much cheaper than taking an interrupt and waking the caller up for
+ * every sample when scanning channels from a trigger.
+ */
+static int rockchip_saradc_read_polled_v1(struct rockchip_saradc *info,
+					  int chn)
+{
+	u32 ctrl;
+	int ret;
+
+	writel_relaxed(8, info->regs + SARADC_DLY_PU_SOC);
+	writel(SARADC_CTRL_POWER_CTRL | (chn & SARADC_CTRL_CHN_MASK),
+	       info->regs + SARADC_CTRL);
+
+	ret = readl_relaxed_poll_timeout_atomic(info->regs + SARADC_CTRL, ctrl,
+						ctrl & SARADC_CTRL_IRQ_STATUS,
+						1, SARADC_POLL_TIMEOUT_US);
+	if (!ret)
+		ret = readl_relaxed(info->regs + SARADC_DATA);
+
+	/* Power down, which also clears the status bit */
+	writel_relaxed(0, info->regs + SARADC_CTRL);
+
+	return ret;
+}
+
 static int rockchip_saradc_read_v2(struct rockchip_saradc *info)
 {
 	int offset;
@@ -240,6 +271,7 @@ static const struct rockchip_saradc_data saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v1,
 	.read = rockchip_saradc_read_v1,
+	.read_polled = rockchip_saradc_read_polled_v1,
 	.power_down = rockchip_saradc_power_down_v1,
 };
 
@@ -254,6 +286,7 @@ static const struct rockchip_saradc_data rk3066_tsadc_data = {
 	.clk_rate = 50000,
 	.start = rockchip_saradc_start_v1,
 	.read = rockchip_saradc_read_v1,
+	.read_polled = rockchip_saradc_read_polled_v1,
 	.power_down = rockchip_saradc_power_down_v1,
 };
 
@@ -272,6 +305,7 @@ static const struct rockchip_saradc_data rk3399_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v1,
 	.read = rockchip_saradc_read_v1,
+	.read_polled = rockchip_saradc_read_polled_v1,
 	.power_down = rockchip_saradc_power_down_v1,
 };
 
@@ -292,6 +326,7 @@ static const struct rockchip_saradc_data rk3568_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v1,
 	.read = rockchip_saradc_read_v1,
+	.read_polled = rockchip_saradc_read_polled_v1,
 	.power_down = rockchip_saradc_power_down_v1,
 };
 
@@ -375,6 +410,16 @@ static irqreturn_t rockchip_saradc_trigger_handler(int irq, void *p)
 	iio_for_each_active_channel(i_dev, i) {
 		const struct iio_chan_spec *chan = &i_dev->channels[i];
 
+		if (info->data->read_polled) {
+			ret = info->data->read_polled(info, chan->channel);
+			if (ret < 0)
+				goto out;
+
+			data.values[j] = ret & GENMASK(chan->scan_type.realbits - 1, 0);
+			j++;
+			continue;
+		}
+
 		ret = rockchip_saradc_conversion(info, chan);
 		if (ret) {
 			rockchip_saradc_power_down(info);
@@ -588,6 +633,7 @@ static struct platform_driver rockchip_saradc_driver = {
 		.name	= "rockchip-saradc",
 		.of_match_table = rockchip_saradc_match,
 		.pm	= pm_sleep_ptr(&rockchip_saradc_pm_ops),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
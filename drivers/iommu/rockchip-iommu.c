@@ -18,6 +18,7 @@
 #include <linux/iopoll.h>
 #include <linux/list.h>
 #include <linux/mm.h>
+#include <linux/mutex.h>
 #include <linux/init.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
@@ -81,6 +82,12 @@
   */
 #define RK_IOMMU_PGSIZE_BITMAP 0x007ff000
 
+/*
+ * Above this many pages it is cheaper to shoot down the entire IOTLB with a
+ * single command than to zap it one line at a time.
+ */
+#define RK_IOMMU_ZAP_LINES_MAX	64
+
 struct rk_iommu_domain {
 	struct list_head iommus;
 	u32 *dt; /* page directory table */
@@ -112,6 +119,7 @@ struct rk_iommu {
 	struct clk_bulk_data *clocks;
 	int num_clocks;
 	bool reset_disabled;
+	bool shared_domain; /* masters join rk_shared_group */
 	struct iommu_device iommu;
 	struct list_head node; /* entry in rk_iommu_domain.iommus */
 	struct iommu_domain *domain; /* domain to which iommu is attached */
@@ -126,6 +134,15 @@ static struct device *dma_dev;
 static const struct rk_iommu_ops *rk_ops;
 static struct iommu_domain rk_identity_domain;
 
+/*
+ * Masters behind IOMMUs flagged with "rockchip,shared-domain" are put in a
+ * single iommu group, so that they all get attached to the same domain and
+ * share one page table. A buffer mapped once is then visible to all of them
+ * at the same iova.
+ */
+static struct iommu_group *rk_shared_group;
+static DEFINE_MUTEX(rk_shared_group_lock);
+
 static inline void rk_table_flush(struct rk_iommu_domain *dom, dma_addr_t dma,
 				  unsigned int count)
 {
@@ -318,6 +335,9 @@ static u32 rk_mk_pte_invalid(u32 pte)
 #define RK_IOVA_PAGE_MASK   0x00000fff
 #define RK_IOVA_PAGE_SHIFT  0
 
+/* iova range covered by one DTE (one page table) */
+#define RK_IOVA_DTE_SIZE    (1UL << RK_IOVA_DTE_SHIFT)
+
 static u32 rk_iova_dte_index(dma_addr_t iova)
 {
 	return (u32)(iova & RK_IOVA_DTE_MASK) >> RK_IOVA_DTE_SHIFT;
@@ -360,10 +380,12 @@ static void rk_iommu_zap_lines(struct rk_iommu *iommu, dma_addr_t iova_start,
 {
 	int i;
 	dma_addr_t iova_end = iova_start + size;
-	/*
-	 * TODO(djkurtz): Figure out when it is more efficient to shootdown the
-	 * entire iotlb rather than iterate over individual iovas.
-	 */
+
+	if (size > RK_IOMMU_ZAP_LINES_MAX * SPAGE_SIZE) {
+		rk_iommu_command(iommu, RK_MMU_CMD_ZAP_CACHE);
+		return;
+	}
+
 	for (i = 0; i < iommu->num_mmu; i++) {
 		dma_addr_t iova;
 
@@ -675,8 +697,31 @@ static phys_addr_t rk_iommu_iova_to_phys(struct iommu_domain *domain,
 	return phys;
 }
 
+/*
+ * Zap the first iova of each dte touched by the range, plus the last iova of
+ * the range, to evict from iotlb any previously mapped cachelines holding
+ * stale values for its dte and pte. Only those could have dte or pte shared
+ * with an existing mapping.
+ */
+static void rk_iommu_zap_dte_edges(struct rk_iommu *iommu, dma_addr_t iova,
+				   size_t size)
+{
+	dma_addr_t iova_end = iova + size;
+	dma_addr_t next;
+
+	for (; iova < iova_end; iova = next) {
+		rk_iommu_zap_lines(iommu, iova, SPAGE_SIZE);
+		next = ALIGN_DOWN(iova, RK_IOVA_DTE_SIZE) + RK_IOVA_DTE_SIZE;
+	}
+
+	if (size > SPAGE_SIZE)
+		rk_iommu_zap_lines(iommu, iova_end - SPAGE_SIZE, SPAGE_SIZE);
+}
+
 static void rk_iommu_zap_iova(struct rk_iommu_domain *rk_domain,
-			      dma_addr_t iova, size_t size)
+			      dma_addr_t iova, size_t size,
+			      void (*zap)(struct rk_iommu *iommu,
+					  dma_addr_t iova, size_t size))
 {
 	struct list_head *pos;
 	unsigned long flags;
@@ -696,7 +741,7 @@ static void rk_iommu_zap_iova(struct rk_iommu_domain *rk_domain,
 		if (ret) {
 			WARN_ON(clk_bulk_enable(iommu->num_clocks,
 						iommu->clocks));
-			rk_iommu_zap_lines(iommu, iova, size);
+			zap(iommu, iova, size);
 			clk_bulk_disable(iommu->num_clocks, iommu->clocks);
 			pm_runtime_put(iommu->dev);
 		}
@@ -704,22 +749,78 @@ static void rk_iommu_zap_iova(struct rk_iommu_domain *rk_domain,
 	spin_unlock_irqrestore(&rk_domain->iommus_lock, flags);
 }
 
-static void rk_iommu_zap_iova_first_last(struct rk_iommu_domain *rk_domain,
-					 dma_addr_t iova, size_t size)
+static u32 *rk_alloc_page_table(gfp_t gfp, dma_addr_t *pt_dma)
 {
-	rk_iommu_zap_iova(rk_domain, iova, SPAGE_SIZE);
-	if (size > SPAGE_SIZE)
-		rk_iommu_zap_iova(rk_domain, iova + size - SPAGE_SIZE,
-					SPAGE_SIZE);
+	u32 *page_table;
+
+	page_table = iommu_alloc_page(gfp | rk_ops->gfp_flags);
+	if (!page_table)
+		return NULL;
+
+	*pt_dma = dma_map_single(dma_dev, page_table, SPAGE_SIZE, DMA_TO_DEVICE);
+	if (dma_mapping_error(dma_dev, *pt_dma)) {
+		dev_err(dma_dev, "DMA mapping error while allocating page table\n");
+		iommu_free_page(page_table);
+		return NULL;
+	}
+
+	return page_table;
+}
+
+/*
+ * Allocate the page tables that are missing for [iova, iova + size) before
+ * taking dt_lock, so that large mappings do not have to allocate atomically
+ * one page table at a time. The dt is peeked at without the lock: page tables
+ * are never removed from a domain, so at worst a racing mapping installs a
+ * page table first and ours goes back unused.
+ */
+static void rk_prealloc_page_tables(struct rk_iommu_domain *rk_domain,
+				    dma_addr_t iova, size_t size, gfp_t gfp,
+				    struct list_head *pts)
+{
+	dma_addr_t iova_end = iova + size;
+	dma_addr_t pt_dma;
+	u32 *page_table;
+
+	for (; iova < iova_end;
+	     iova = ALIGN_DOWN(iova, RK_IOVA_DTE_SIZE) + RK_IOVA_DTE_SIZE) {
+		struct page *page;
+
+		if (rk_dte_is_pt_valid(READ_ONCE(rk_domain->dt[rk_iova_dte_index(iova)])))
+			continue;
+
+		/* Leave the rest to the atomic fallback */
+		page_table = rk_alloc_page_table(gfp, &pt_dma);
+		if (!page_table)
+			break;
+
+		page = virt_to_page(page_table);
+		set_page_private(page, pt_dma);
+		list_add_tail(&page->lru, pts);
+	}
+}
+
+static void rk_free_page_tables(struct list_head *pts)
+{
+	struct page *page, *next;
+
+	list_for_each_entry_safe(page, next, pts, lru) {
+		list_del(&page->lru);
+		dma_unmap_single(dma_dev, page_private(page), SPAGE_SIZE,
+				 DMA_TO_DEVICE);
+		set_page_private(page, 0);
+		iommu_free_page(page_address(page));
+	}
 }
 
 static u32 *rk_dte_get_page_table(struct rk_iommu_domain *rk_domain,
-				  dma_addr_t iova)
+				  dma_addr_t iova, struct list_head *pts)
 {
 	u32 *page_table, *dte_addr;
 	u32 dte_index, dte;
 	phys_addr_t pt_phys;
 	dma_addr_t pt_dma;
+	struct page *page;
 
 	assert_spin_locked(&rk_domain->dt_lock);
 
@@ -729,22 +830,21 @@ static u32 *rk_dte_get_page_table(struct rk_iommu_domain *rk_domain,
 	if (rk_dte_is_pt_valid(dte))
 		goto done;
 
-	page_table = iommu_alloc_page(GFP_ATOMIC | rk_ops->gfp_flags);
-	if (!page_table)
-		return ERR_PTR(-ENOMEM);
-
-	pt_dma = dma_map_single(dma_dev, page_table, SPAGE_SIZE, DMA_TO_DEVICE);
-	if (dma_mapping_error(dma_dev, pt_dma)) {
-		dev_err(dma_dev, "DMA mapping error while allocating page table\n");
-		iommu_free_page(page_table);
-		return ERR_PTR(-ENOMEM);
+	page = list_first_entry_or_null(pts, struct page, lru);
+	if (page) {
+		list_del(&page->lru);
+		pt_dma = page_private(page);
+		set_page_private(page, 0);
+	} else {
+		page_table = rk_alloc_page_table(GFP_ATOMIC, &pt_dma);
+		if (!page_table)
+			return ERR_PTR(-ENOMEM);
 	}
 
 	dte = rk_ops->mk_dtentries(pt_dma);
-	*dte_addr = dte;
+	WRITE_ONCE(*dte_addr, dte);
 
-	rk_table_flush(rk_domain,
-		       rk_domain->dt_dma + dte_index * sizeof(u32), 1);
+	/* The caller flushes the dt entries once the whole range is mapped */
 done:
 	pt_phys = rk_ops->pt_address(dte);
 	return (u32 *)phys_to_virt(pt_phys);
@@ -795,14 +895,7 @@ static int rk_iommu_map_iova(struct rk_iommu_domain *rk_domain, u32 *pte_addr,
 
 	rk_table_flush(rk_domain, pte_dma, pte_total);
 
-	/*
-	 * Zap the first and last iova to evict from iotlb any previously
-	 * mapped cachelines holding stale values for its dte and pte.
-	 * We only zap the first and last iova, since only they could have
-	 * dte or pte shared with an existing mapping.
-	 */
-	rk_iommu_zap_iova_first_last(rk_domain, iova, size);
-
+	/* The iotlb is zapped once for the whole range in ->iotlb_sync_map() */
 	return 0;
 unwind:
 	/* Unmap the range of iovas that we just mapped */
@@ -824,36 +917,67 @@ static int rk_iommu_map(struct iommu_domain *domain, unsigned long _iova,
 	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
 	unsigned long flags;
 	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
+	size_t total = size * count, done = 0;
 	u32 *page_table, *pte_addr;
-	u32 dte_index, pte_index;
-	int ret;
+	u32 dte_index, dte_first, dte_last, dte, pte_index;
+	bool dt_dirty = false, pt_new;
+	LIST_HEAD(pts);
+	int ret = 0;
+
+	rk_prealloc_page_tables(rk_domain, iova, total, gfp, &pts);
 
 	spin_lock_irqsave(&rk_domain->dt_lock, flags);
 
 	/*
-	 * pgsize_bitmap specifies iova sizes that fit in one page table
-	 * (1024 4-KiB pages = 4 MiB).
-	 * So, size will always be 4096 <= size <= 4194304.
+	 * Walk the range one page table (1024 4-KiB pages = 4 MiB) at a time.
 	 * Since iommu_map() guarantees that both iova and size will be
-	 * aligned, we will always only be mapping from a single dte here.
+	 * aligned, each chunk always starts and ends on a page boundary.
 	 */
-	page_table = rk_dte_get_page_table(rk_domain, iova);
-	if (IS_ERR(page_table)) {
-		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
-		return PTR_ERR(page_table);
-	}
+	dte_first = dte_last = rk_iova_dte_index(iova);
+	while (done < total) {
+		size_t chunk = min_t(size_t, total - done,
+				     RK_IOVA_DTE_SIZE - (iova & ~RK_IOVA_DTE_MASK));
 
-	dte_index = rk_domain->dt[rk_iova_dte_index(iova)];
-	pte_index = rk_iova_pte_index(iova);
-	pte_addr = &page_table[pte_index];
+		dte_index = rk_iova_dte_index(iova);
+		pt_new = !rk_dte_is_pt_valid(rk_domain->dt[dte_index]);
+
+		page_table = rk_dte_get_page_table(rk_domain, iova, &pts);
+		if (IS_ERR(page_table)) {
+			ret = PTR_ERR(page_table);
+			break;
+		}
 
-	pte_dma = rk_ops->pt_address(dte_index) + pte_index * sizeof(u32);
-	ret = rk_iommu_map_iova(rk_domain, pte_addr, pte_dma, iova,
-				paddr, size, prot);
+		if (pt_new) {
+			dt_dirty = true;
+			dte_last = dte_index;
+		}
+
+		dte = rk_domain->dt[dte_index];
+		pte_index = rk_iova_pte_index(iova);
+		pte_addr = &page_table[pte_index];
+
+		pte_dma = rk_ops->pt_address(dte) + pte_index * sizeof(u32);
+		ret = rk_iommu_map_iova(rk_domain, pte_addr, pte_dma, iova,
+					paddr, chunk, prot);
+		if (ret)
+			break;
+
+		iova += chunk;
+		paddr += chunk;
+		done += chunk;
+	}
+
+	/* Flush every dt entry that was filled in above at once */
+	if (dt_dirty)
+		rk_table_flush(rk_domain,
+			       rk_domain->dt_dma + dte_first * sizeof(u32),
+			       dte_last - dte_first + 1);
 
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
-	if (!ret)
-		*mapped = size;
+
+	rk_free_page_tables(&pts);
+
+	*mapped = done;
 
 	return ret;
 }
@@ -864,40 +988,93 @@ static size_t rk_iommu_unmap(struct iommu_domain *domain, unsigned long _iova,
 	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
 	unsigned long flags;
 	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
+	size_t total = size * count, unmap_size = 0;
 	phys_addr_t pt_phys;
 	u32 dte;
 	u32 *pte_addr;
-	size_t unmap_size;
 
 	spin_lock_irqsave(&rk_domain->dt_lock, flags);
 
 	/*
-	 * pgsize_bitmap specifies iova sizes that fit in one page table
-	 * (1024 4-KiB pages = 4 MiB).
-	 * So, size will always be 4096 <= size <= 4194304.
-	 * Since iommu_unmap() guarantees that both iova and size will be
-	 * aligned, we will always only be unmapping from a single dte here.
+	 * Walk the range one page table at a time, stopping at the first
+	 * page that is not mapped.
 	 */
-	dte = rk_domain->dt[rk_iova_dte_index(iova)];
-	/* Just return 0 if iova is unmapped */
-	if (!rk_dte_is_pt_valid(dte)) {
-		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
-		return 0;
-	}
+	while (unmap_size < total) {
+		size_t chunk = min_t(size_t, total - unmap_size,
+				     RK_IOVA_DTE_SIZE - (iova & ~RK_IOVA_DTE_MASK));
+		size_t chunk_unmapped;
+
+		dte = rk_domain->dt[rk_iova_dte_index(iova)];
+		/* Stop here if iova is unmapped */
+		if (!rk_dte_is_pt_valid(dte))
+			break;
 
-	pt_phys = rk_ops->pt_address(dte);
-	pte_addr = (u32 *)phys_to_virt(pt_phys) + rk_iova_pte_index(iova);
-	pte_dma = pt_phys + rk_iova_pte_index(iova) * sizeof(u32);
-	unmap_size = rk_iommu_unmap_iova(rk_domain, pte_addr, pte_dma, size);
+		pt_phys = rk_ops->pt_address(dte);
+		pte_addr = (u32 *)phys_to_virt(pt_phys) + rk_iova_pte_index(iova);
+		pte_dma = pt_phys + rk_iova_pte_index(iova) * sizeof(u32);
+		chunk_unmapped = rk_iommu_unmap_iova(rk_domain, pte_addr,
+						     pte_dma, chunk);
+		unmap_size += chunk_unmapped;
+		if (chunk_unmapped < chunk)
+			break;
+
+		iova += chunk;
+	}
 
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
 
-	/* Shootdown iotlb entries for iova range that was just unmapped */
-	rk_iommu_zap_iova(rk_domain, iova, unmap_size);
+	/*
+	 * Defer the shootdown of the iotlb entries for the iova range that was
+	 * just unmapped to ->iotlb_sync(), or to ->flush_iotlb_all() if the
+	 * flush has been queued.
+	 */
+	if (!unmap_size || iommu_iotlb_gather_queued(gather))
+		return unmap_size;
+
+	if (iommu_iotlb_gather_is_disjoint(gather, _iova, unmap_size))
+		iommu_iotlb_sync(domain, gather);
+	iommu_iotlb_gather_add_range(gather, _iova, unmap_size);
 
 	return unmap_size;
 }
 
+static int rk_iommu_iotlb_sync_map(struct iommu_domain *domain,
+				   unsigned long iova, size_t size)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+
+	rk_iommu_zap_iova(rk_domain, iova, size, rk_iommu_zap_dte_edges);
+
+	return 0;
+}
+
+static void rk_iommu_iotlb_sync(struct iommu_domain *domain,
+				struct iommu_iotlb_gather *gather)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+
+	/* Nothing gathered */
+	if (gather->start > gather->end)
+		return;
+
+	/* Shootdown iotlb entries for iova range that was unmapped */
+	rk_iommu_zap_iova(rk_domain, gather->start,
+			  gather->end - gather->start + 1, rk_iommu_zap_lines);
+}
+
+static void rk_iommu_zap_all(struct rk_iommu *iommu, dma_addr_t iova,
+			     size_t size)
+{
+	rk_iommu_command(iommu, RK_MMU_CMD_ZAP_CACHE);
+}
+
+static void rk_iommu_flush_iotlb_all(struct iommu_domain *domain)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+
+	rk_iommu_zap_iova(rk_domain, 0, 0, rk_iommu_zap_all);
+}
+
 static struct rk_iommu *rk_iommu_from_dev(struct device *dev)
 {
 	struct rk_iommudata *data = dev_iommu_priv_get(dev);
@@ -1117,6 +1294,16 @@ static void rk_iommu_domain_free(struct iommu_domain *domain)
 	kfree(rk_domain);
 }
 
+static bool rk_iommu_capable(struct device *dev, enum iommu_cap cap)
+{
+	switch (cap) {
+	case IOMMU_CAP_DEFERRED_FLUSH:
+		return true;
+	default:
+		return false;
+	}
+}
+
 static struct iommu_device *rk_iommu_probe_device(struct device *dev)
 {
 	struct rk_iommudata *data;
@@ -1141,6 +1328,38 @@ static void rk_iommu_release_device(struct device *dev)
 	device_link_del(data->link);
 }
 
+static void rk_iommu_shared_group_release(void *iommu_data)
+{
+	mutex_lock(&rk_shared_group_lock);
+	rk_shared_group = NULL;
+	mutex_unlock(&rk_shared_group_lock);
+}
+
+static struct iommu_group *rk_iommu_device_group(struct device *dev)
+{
+	struct rk_iommu *iommu = rk_iommu_from_dev(dev);
+	struct iommu_group *group;
+
+	if (!iommu->shared_domain)
+		return generic_single_device_group(dev);
+
+	mutex_lock(&rk_shared_group_lock);
+	group = rk_shared_group;
+	if (!group) {
+		group = iommu_group_alloc();
+		if (!IS_ERR(group)) {
+			iommu_group_set_iommudata(group, NULL,
+						  rk_iommu_shared_group_release);
+			rk_shared_group = group;
+		}
+	} else {
+		iommu_group_ref_get(group);
+	}
+	mutex_unlock(&rk_shared_group_lock);
+
+	return group;
+}
+
 static int rk_iommu_of_xlate(struct device *dev,
 			     const struct of_phandle_args *args)
 {
@@ -1162,17 +1381,21 @@ static int rk_iommu_of_xlate(struct device *dev,
 }
 
 static const struct iommu_ops rk_iommu_ops = {
+	.capable = rk_iommu_capable,
 	.identity_domain = &rk_identity_domain,
 	.domain_alloc_paging = rk_iommu_domain_alloc_paging,
 	.probe_device = rk_iommu_probe_device,
 	.release_device = rk_iommu_release_device,
-	.device_group = generic_single_device_group,
+	.device_group = rk_iommu_device_group,
 	.pgsize_bitmap = RK_IOMMU_PGSIZE_BITMAP,
 	.of_xlate = rk_iommu_of_xlate,
 	.default_domain_ops = &(const struct iommu_domain_ops) {
 		.attach_dev	= rk_iommu_attach_device,
 		.map_pages	= rk_iommu_map,
 		.unmap_pages	= rk_iommu_unmap,
+		.flush_iotlb_all = rk_iommu_flush_iotlb_all,
+		.iotlb_sync_map	= rk_iommu_iotlb_sync_map,
+		.iotlb_sync	= rk_iommu_iotlb_sync,
 		.iova_to_phys	= rk_iommu_iova_to_phys,
 		.free		= rk_iommu_domain_free,
 	}
@@ -1231,6 +1454,8 @@ static int rk_iommu_probe(struct platform_device *pdev)
 
 	iommu->reset_disabled = device_property_read_bool(dev,
 					"rockchip,disable-mmu-reset");
+	iommu->shared_domain = device_property_read_bool(dev,
+					"rockchip,shared-domain");
 
 	iommu->num_clocks = ARRAY_SIZE(rk_iommu_clocks);
 	iommu->clocks = devm_kcalloc(iommu->dev, iommu->num_clocks,
@@ -1290,6 +1515,9 @@ static int rk_iommu_probe(struct platform_device *pdev)
 
 	dma_set_mask_and_coherent(dev, rk_ops->dma_bit_mask);
 
+	/* Ordering against the masters is kept by their device links */
+	device_enable_async_suspend(dev);
+
 	return 0;
 err_pm_disable:
 	pm_runtime_disable(dev);
@@ -35,6 +35,9 @@ struct rockchip_mbox_chan {
 	int idx;
 	int irq;
 	struct rockchip_mbox_msg *msg;
+	/* Last B2A message, for doorbells and messages nobody waits for */
+	struct rockchip_mbox_msg rx_msg;
+	bool tx_active;
 	struct rockchip_mbox *mb;
 };
 
@@ -53,10 +56,21 @@ static int rockchip_mbox_send_data(struct mbox_chan *chan, void *data)
 {
 	struct rockchip_mbox *mb = dev_get_drvdata(chan->mbox->dev);
 	struct rockchip_mbox_msg *msg = data;
-	struct rockchip_mbox_chan *chans = mb->chans;
-
-	if (!msg)
-		return -EINVAL;
+	struct rockchip_mbox_chan *chans = chan->con_priv;
+
+	/*
+	 * Without a message the channel is used as a plain doorbell, e.g. by
+	 * transports that keep their payload in shared memory.
+	 */
+	if (!msg) {
+		dev_dbg(mb->mbox.dev, "Chan[%d]: A2B doorbell\n", chans->idx);
+
+		chans->msg = NULL;
+		chans->tx_active = true;
+		writel_relaxed(0, mb->mbox_base + MAILBOX_A2B_CMD(chans->idx));
+		writel_relaxed(0, mb->mbox_base + MAILBOX_A2B_DAT(chans->idx));
+		return 0;
+	}
 
 	if (msg->rx_size > mb->buf_size) {
 		dev_err(mb->mbox.dev, "Transmit size over buf size(%d)\n",
@@ -67,7 +81,8 @@ static int rockchip_mbox_send_data(struct mbox_chan *chan, void *data)
 	dev_dbg(mb->mbox.dev, "Chan[%d]: A2B message, cmd 0x%08x\n",
 		chans->idx, msg->cmd);
 
-	mb->chans[chans->idx].msg = msg;
+	chans->msg = msg;
+	chans->tx_active = true;
 
 	writel_relaxed(msg->cmd, mb->mbox_base + MAILBOX_A2B_CMD(chans->idx));
 	writel_relaxed(msg->rx_size, mb->mbox_base +
@@ -90,12 +105,13 @@ static int rockchip_mbox_startup(struct mbox_chan *chan)
 static void rockchip_mbox_shutdown(struct mbox_chan *chan)
 {
 	struct rockchip_mbox *mb = dev_get_drvdata(chan->mbox->dev);
-	struct rockchip_mbox_chan *chans = mb->chans;
+	struct rockchip_mbox_chan *chans = chan->con_priv;
 
 	/* Disable all B2A interrupts */
 	writel_relaxed(0, mb->mbox_base + MAILBOX_B2A_INTEN);
 
-	mb->chans[chans->idx].msg = NULL;
+	chans->msg = NULL;
+	chans->tx_active = false;
 }
 
 static const struct mbox_chan_ops rockchip_mbox_chan_ops = {
@@ -127,24 +143,40 @@ static irqreturn_t rockchip_mbox_isr(int irq, void *dev_id)
 	int idx;
 	struct rockchip_mbox_msg *msg = NULL;
 	struct rockchip_mbox *mb = (struct rockchip_mbox *)dev_id;
+	struct rockchip_mbox_chan *chans;
 
 	for (idx = 0; idx < mb->mbox.num_chans; idx++) {
 		if (irq != mb->chans[idx].irq)
 			continue;
 
-		msg = mb->chans[idx].msg;
+		chans = &mb->chans[idx];
+
+		/*
+		 * Replies to a message go back to its sender as before; an
+		 * unsolicited message or a doorbell reply is passed on as
+		 * read from the B2A registers.
+		 */
+		msg = chans->msg;
 		if (!msg) {
-			dev_err(mb->mbox.dev,
-				"Chan[%d]: B2A message is NULL\n", idx);
-			break; /* spurious */
+			chans->rx_msg.cmd = readl_relaxed(mb->mbox_base +
+							  MAILBOX_B2A_CMD(idx));
+			chans->rx_msg.rx_size = readl_relaxed(mb->mbox_base +
+							      MAILBOX_B2A_DAT(idx));
+			msg = &chans->rx_msg;
 		}
 
 		mbox_chan_received_data(&mb->mbox.chans[idx], msg);
-		mb->chans[idx].msg = NULL;
+		chans->msg = NULL;
 
 		dev_dbg(mb->mbox.dev, "Chan[%d]: B2A message, cmd 0x%08x\n",
 			idx, msg->cmd);
 
+		/* The remote answering is what completes our transmission */
+		if (chans->tx_active) {
+			chans->tx_active = false;
+			mbox_chan_txdone(&mb->mbox.chans[idx], 0);
+		}
+
 		break;
 	}
 
@@ -231,6 +263,7 @@ static int rockchip_mbox_probe(struct platform_device *pdev)
 		mb->chans[i].irq = irq;
 		mb->chans[i].mb = mb;
 		mb->chans[i].msg = NULL;
+		mb->mbox.chans[i].con_priv = &mb->chans[i];
 	}
 
 	ret = devm_mbox_controller_register(&pdev->dev, &mb->mbox);
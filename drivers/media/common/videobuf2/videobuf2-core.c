@@ -294,6 +294,18 @@ static void __vb2_buf_userptr_put(struct vb2_buffer *vb)
 	}
 }
 
+static void __vb2_plane_dmabuf_clear(struct vb2_plane *p)
+{
+	p->mem_priv = NULL;
+	p->dbuf = NULL;
+	p->dbuf_mapped = 0;
+	p->bytesused = 0;
+	p->length = 0;
+	p->m.fd = 0;
+	p->data_offset = 0;
+	p->dbuf_duplicated = false;
+}
+
 /*
  * __vb2_plane_dmabuf_put() - release memory associated with
  * a DMABUF shared plane
@@ -311,14 +323,7 @@ static void __vb2_plane_dmabuf_put(struct vb2_buffer *vb, struct vb2_plane *p)
 	}
 
 	dma_buf_put(p->dbuf);
-	p->mem_priv = NULL;
-	p->dbuf = NULL;
-	p->dbuf_mapped = 0;
-	p->bytesused = 0;
-	p->length = 0;
-	p->m.fd = 0;
-	p->data_offset = 0;
-	p->dbuf_duplicated = false;
+	__vb2_plane_dmabuf_clear(p);
 }
 
 /*
@@ -339,6 +344,100 @@ static void __vb2_buf_dmabuf_put(struct vb2_buffer *vb)
 		__vb2_plane_dmabuf_put(vb, &vb->planes[plane]);
 }
 
+/*
+ * __vb2_dmabuf_cache_evict() - release a cached DMABUF attachment
+ */
+static void __vb2_dmabuf_cache_evict(struct vb2_queue *q,
+				     struct vb2_dmabuf_cache_entry *e)
+{
+	if (!e->dbuf)
+		return;
+
+	q->mem_ops->unmap_dmabuf(e->mem_priv);
+	q->mem_ops->detach_dmabuf(e->mem_priv);
+	dma_buf_put(e->dbuf);
+	memset(e, 0, sizeof(*e));
+}
+
+static void __vb2_dmabuf_cache_flush(struct vb2_queue *q)
+{
+	unsigned int i;
+
+	for (i = 0; i < VB2_DMABUF_CACHE_SIZE; i++)
+		__vb2_dmabuf_cache_evict(q, &q->dmabuf_cache[i]);
+	q->dmabuf_cache_next = 0;
+}
+
+/*
+ * __vb2_dmabuf_cache_get() - take a mapped attachment of @dbuf for @dev
+ * out of the cache, returns NULL if there is none
+ */
+static void *__vb2_dmabuf_cache_get(struct vb2_buffer *vb, struct dma_buf *dbuf,
+				    struct device *dev, unsigned int length)
+{
+	struct vb2_queue *q = vb->vb2_queue;
+	unsigned int i;
+
+	for (i = 0; i < VB2_DMABUF_CACHE_SIZE; i++) {
+		struct vb2_dmabuf_cache_entry *e = &q->dmabuf_cache[i];
+		void *mem_priv = e->mem_priv;
+
+		if (e->dbuf != dbuf || e->dev != dev || e->length != length)
+			continue;
+
+		/* The caller holds its own reference */
+		dma_buf_put(e->dbuf);
+		memset(e, 0, sizeof(*e));
+#ifdef CONFIG_VIDEO_ADV_DEBUG
+		vb->cnt_mem_attach_dmabuf++;
+		vb->cnt_mem_map_dmabuf++;
+#endif
+		return mem_priv;
+	}
+
+	return NULL;
+}
+
+/*
+ * __vb2_buf_dmabuf_park() - release a DMABUF shared buffer like
+ * __vb2_buf_dmabuf_put(), but keep the mapped attachments in the cache
+ *
+ * Userspace often queues a pool of dma_bufs into whatever buffer is free,
+ * so each of them would otherwise be mapped again, paying for IOMMU setup
+ * and exporter cache maintenance, every time it lands in another buffer.
+ */
+static void __vb2_buf_dmabuf_park(struct vb2_buffer *vb)
+{
+	struct vb2_queue *q = vb->vb2_queue;
+	int plane;
+
+	for (plane = vb->num_planes - 1; plane >= 0; --plane) {
+		struct vb2_plane *p = &vb->planes[plane];
+		struct vb2_dmabuf_cache_entry *e;
+
+		if (!p->mem_priv || p->dbuf_duplicated || !p->dbuf_mapped) {
+			__vb2_plane_dmabuf_put(vb, p);
+			continue;
+		}
+
+		e = &q->dmabuf_cache[q->dmabuf_cache_next];
+		q->dmabuf_cache_next = (q->dmabuf_cache_next + 1) %
+				       VB2_DMABUF_CACHE_SIZE;
+		__vb2_dmabuf_cache_evict(q, e);
+
+		/* The plane's dma_buf reference moves to the cache */
+		e->dbuf = p->dbuf;
+		e->mem_priv = p->mem_priv;
+		e->dev = q->alloc_devs[plane] ? : q->dev;
+		e->length = p->length;
+#ifdef CONFIG_VIDEO_ADV_DEBUG
+		vb->cnt_mem_unmap_dmabuf++;
+		vb->cnt_mem_detach_dmabuf++;
+#endif
+		__vb2_plane_dmabuf_clear(p);
+	}
+}
+
 /*
  * __vb2_buf_mem_prepare() - call ->prepare() on buffer's private memory
  * to sync caches
@@ -597,6 +696,7 @@ static void __vb2_queue_free(struct vb2_queue *q, unsigned int start, unsigned i
 
 	/* Release video buffer memory */
 	__vb2_free_mem(q, start, count);
+	__vb2_dmabuf_cache_flush(q);
 
 #ifdef CONFIG_VIDEO_ADV_DEBUG
 	/*
@@ -1382,6 +1482,7 @@ static int __prepare_dmabuf(struct vb2_buffer *vb)
 {
 	struct vb2_plane planes[VB2_MAX_PLANES];
 	struct vb2_queue *q = vb->vb2_queue;
+	struct device *dev;
 	void *mem_priv;
 	unsigned int plane, i;
 	int ret = 0;
@@ -1432,7 +1533,7 @@ static int __prepare_dmabuf(struct vb2_buffer *vb)
 		if (vb->planes[0].mem_priv) {
 			vb->copied_timestamp = 0;
 			call_void_vb_qop(vb, buf_cleanup, vb);
-			__vb2_buf_dmabuf_put(vb);
+			__vb2_buf_dmabuf_park(vb);
 		}
 
 		for (plane = 0; plane < vb->num_planes; ++plane) {
@@ -1454,10 +1555,22 @@ static int __prepare_dmabuf(struct vb2_buffer *vb)
 			if (vb->planes[plane].dbuf_duplicated)
 				continue;
 
+			dev = q->alloc_devs[plane] ? : q->dev;
+
+			/* Reuse the mapping from a buffer this dma_buf was in */
+			mem_priv = __vb2_dmabuf_cache_get(vb, planes[plane].dbuf,
+							  dev, planes[plane].length);
+			if (mem_priv) {
+				vb->planes[plane].dbuf = planes[plane].dbuf;
+				vb->planes[plane].mem_priv = mem_priv;
+				vb->planes[plane].dbuf_mapped = 1;
+				continue;
+			}
+
 			/* Acquire each plane's memory */
 			mem_priv = call_ptr_memop(attach_dmabuf,
 						  vb,
-						  q->alloc_devs[plane] ? : q->dev,
+						  dev,
 						  planes[plane].dbuf,
 						  planes[plane].length);
 			if (IS_ERR(mem_priv)) {
@@ -2430,6 +2543,7 @@ int vb2_core_expbuf(struct vb2_queue *q, int *fd, unsigned int type,
 	struct vb2_plane *vb_plane;
 	int ret;
 	struct dma_buf *dbuf;
+	unsigned long ino;
 
 	if (q->memory != VB2_MEMORY_MMAP) {
 		dprintk(q, 1, "queue is not currently set up for mmap\n");
@@ -2473,6 +2587,8 @@ int vb2_core_expbuf(struct vb2_queue *q, int *fd, unsigned int type,
 		return -EINVAL;
 	}
 
+	/* Once installed, the descriptor may be closed under our feet */
+	ino = dma_buf_ino(dbuf);
 	ret = dma_buf_fd(dbuf, flags & ~O_ACCMODE);
 	if (ret < 0) {
 		dprintk(q, 3, "buffer %d, plane %d failed to export (%d)\n",
@@ -2480,6 +2596,7 @@ int vb2_core_expbuf(struct vb2_queue *q, int *fd, unsigned int type,
 		dma_buf_put(dbuf);
 		return ret;
 	}
+	vb_plane->exp_ino = ino;
 
 	dprintk(q, 3, "buffer %d, plane %d exported as %d descriptor\n",
 		vb->index, plane, ret);
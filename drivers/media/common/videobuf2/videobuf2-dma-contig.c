@@ -44,6 +44,14 @@ struct vb2_dc_buf {
 
 	struct vb2_buffer		*vb;
 	bool				non_coherent_mem;
+
+	/*
+	 * Non-coherent memory: cpu_mapped is set once a user or kernel mapping
+	 * was created, device_only while the CPU caches hold nothing of the
+	 * buffer that still needs maintenance.
+	 */
+	bool				cpu_mapped;
+	bool				device_only;
 };
 
 /*********************************************/
@@ -70,6 +78,22 @@ static unsigned long vb2_dc_get_contiguous_size(struct sg_table *sgt)
 /*         callbacks for all buffers         */
 /*********************************************/
 
+/*
+ * Cache maintenance is skipped while no CPU mapping of a non-coherent buffer
+ * exists. The lines speculative accesses may have pulled in meanwhile are
+ * dropped when the first mapping appears.
+ */
+static void vb2_dc_set_cpu_mapped(struct vb2_dc_buf *buf)
+{
+	if (buf->cpu_mapped)
+		return;
+
+	buf->cpu_mapped = true;
+	if (buf->device_only)
+		dma_sync_sgtable_for_cpu(buf->dev, buf->dma_sgt, buf->dma_dir);
+	buf->device_only = false;
+}
+
 static void *vb2_dc_cookie(struct vb2_buffer *vb, void *buf_priv)
 {
 	struct vb2_dc_buf *buf = buf_priv;
@@ -107,9 +131,12 @@ static void *vb2_dc_vaddr(struct vb2_buffer *vb, void *buf_priv)
 		return buf->vaddr;
 	}
 
-	if (buf->non_coherent_mem)
+	if (buf->non_coherent_mem) {
 		buf->vaddr = dma_vmap_noncontiguous(buf->dev, buf->size,
 						    buf->dma_sgt);
+		if (buf->vaddr)
+			vb2_dc_set_cpu_mapped(buf);
+	}
 	return buf->vaddr;
 }
 
@@ -126,10 +153,10 @@ static void vb2_dc_prepare(void *buf_priv)
 	struct sg_table *sgt = buf->dma_sgt;
 
 	/* This takes care of DMABUF and user-enforced cache sync hint */
-	if (buf->vb->skip_cache_sync_on_prepare)
+	if (buf->db_attach || buf->vb->skip_cache_sync_on_prepare)
 		return;
 
-	if (!buf->non_coherent_mem)
+	if (!buf->non_coherent_mem || buf->device_only)
 		return;
 
 	/* Non-coherent MMAP only */
@@ -138,6 +165,9 @@ static void vb2_dc_prepare(void *buf_priv)
 
 	/* For both USERPTR and non-coherent MMAP */
 	dma_sync_sgtable_for_device(buf->dev, sgt, buf->dma_dir);
+
+	/* Only the device touches the buffer until the CPU maps it */
+	buf->device_only = !buf->cpu_mapped;
 }
 
 static void vb2_dc_finish(void *buf_priv)
@@ -146,10 +176,10 @@ static void vb2_dc_finish(void *buf_priv)
 	struct sg_table *sgt = buf->dma_sgt;
 
 	/* This takes care of DMABUF and user-enforced cache sync hint */
-	if (buf->vb->skip_cache_sync_on_finish)
+	if (buf->db_attach || buf->vb->skip_cache_sync_on_finish)
 		return;
 
-	if (!buf->non_coherent_mem)
+	if (!buf->non_coherent_mem || buf->device_only)
 		return;
 
 	/* Non-coherent MMAP only */
@@ -292,6 +322,9 @@ static int vb2_dc_mmap(void *buf_priv, struct vm_area_struct *vma)
 		return ret;
 	}
 
+	if (buf->non_coherent_mem)
+		vb2_dc_set_cpu_mapped(buf);
+
 	vm_flags_set(vma, VM_DONTEXPAND | VM_DONTDUMP);
 	vma->vm_private_data	= &buf->handler;
 	vma->vm_ops		= &vb2_common_vm_ops;
@@ -659,6 +692,8 @@ static void *vb2_dc_get_userptr(struct vb2_buffer *vb, struct device *dev,
 	buf->dma_addr = sg_dma_address(sgt->sgl);
 	buf->dma_sgt = sgt;
 	buf->non_coherent_mem = 1;
+	/* User memory is mapped by definition */
+	buf->cpu_mapped = true;
 
 out:
 	buf->size = size;
@@ -203,7 +203,7 @@ static void vb2_dma_sg_prepare(void *buf_priv)
 	struct vb2_dma_sg_buf *buf = buf_priv;
 	struct sg_table *sgt = buf->dma_sgt;
 
-	if (buf->vb->skip_cache_sync_on_prepare)
+	if (buf->db_attach || buf->vb->skip_cache_sync_on_prepare)
 		return;
 
 	dma_sync_sgtable_for_device(buf->dev, sgt, buf->dma_dir);
@@ -214,7 +214,7 @@ static void vb2_dma_sg_finish(void *buf_priv)
 	struct vb2_dma_sg_buf *buf = buf_priv;
 	struct sg_table *sgt = buf->dma_sgt;
 
-	if (buf->vb->skip_cache_sync_on_finish)
+	if (buf->db_attach || buf->vb->skip_cache_sync_on_finish)
 		return;
 
 	dma_sync_sgtable_for_cpu(buf->dev, sgt, buf->dma_dir);
@@ -482,6 +482,23 @@ static void rkisp1_irq_frame_end_enable(struct rkisp1_capture *cap)
 	rkisp1_write(cap->rkisp1, RKISP1_CIF_MI_IMSC, mi_imsc);
 }
 
+/* Takes effect with the next frame, the register is shadowed */
+static void rkisp1_mp_fill_level_config(struct rkisp1_capture *cap)
+{
+	const struct v4l2_pix_format_mplane *pixm = &cap->pix.fmt;
+	u32 mi_imsc = rkisp1_read(cap->rkisp1, RKISP1_CIF_MI_IMSC);
+	u32 lines = min(cap->fill_lines, pixm->height);
+
+	if (lines) {
+		rkisp1_write(cap->rkisp1, RKISP1_CIF_MI_MP_Y_IRQ_OFFS_INIT,
+			     lines * pixm->plane_fmt[0].bytesperline);
+		mi_imsc |= RKISP1_CIF_MI_FILL_MP_Y;
+	} else {
+		mi_imsc &= ~RKISP1_CIF_MI_FILL_MP_Y;
+	}
+	rkisp1_write(cap->rkisp1, RKISP1_CIF_MI_IMSC, mi_imsc);
+}
+
 static void rkisp1_mp_config(struct rkisp1_capture *cap)
 {
 	const struct v4l2_pix_format_mplane *pixm = &cap->pix.fmt;
@@ -504,6 +521,7 @@ static void rkisp1_mp_config(struct rkisp1_capture *cap)
 	}
 
 	rkisp1_irq_frame_end_enable(cap);
+	rkisp1_mp_fill_level_config(cap);
 
 	/* set uv swapping for semiplanar formats */
 	if (cap->pix.info->comp_planes == 2) {
@@ -814,6 +832,33 @@ static void rkisp1_handle_buffer(struct rkisp1_capture *cap)
 	spin_unlock(&cap->buf.lock);
 }
 
+/*
+ * The fill level interrupt fires while the buffer which will be completed at
+ * the next frame end is being written.
+ */
+static void rkisp1_queue_fill_level_event(struct rkisp1_capture *cap)
+{
+	struct v4l2_event event = {
+		.type = V4L2_EVENT_RKISP1_FILL_LEVEL,
+	};
+	struct rkisp1_fill_level_event *data = (void *)event.u.data;
+	struct rkisp1_buffer *curr_buf;
+
+	spin_lock(&cap->buf.lock);
+	curr_buf = cap->buf.curr;
+	if (curr_buf)
+		data->index = curr_buf->vb.vb2_buf.index;
+	spin_unlock(&cap->buf.lock);
+
+	/* The frame goes to the dummy buffer */
+	if (!curr_buf)
+		return;
+
+	data->frame_sequence = cap->rkisp1->isp.frame_sequence;
+	data->lines = min(cap->fill_lines, cap->pix.fmt.height);
+	v4l2_event_queue(&cap->vnode.vdev, &event);
+}
+
 irqreturn_t rkisp1_capture_isr(int irq, void *ctx)
 {
 	struct device *dev = ctx;
@@ -834,6 +879,10 @@ irqreturn_t rkisp1_capture_isr(int irq, void *ctx)
 	for (i = 0; i < dev_count; ++i) {
 		struct rkisp1_capture *cap = &rkisp1->capture_devs[i];
 
+		if (cap->id == RKISP1_MAINPATH &&
+		    (status & RKISP1_CIF_MI_FILL_MP_Y) && !cap->is_stopping)
+			rkisp1_queue_fill_level_event(cap);
+
 		if (!(status & RKISP1_CIF_MI_FRAME(cap)))
 			continue;
 		if (!cap->is_stopping) {
@@ -1438,6 +1487,20 @@ rkisp1_querycap(struct file *file, void *priv, struct v4l2_capability *cap)
 	return 0;
 }
 
+static int rkisp1_subscribe_event(struct v4l2_fh *fh,
+				  const struct v4l2_event_subscription *sub)
+{
+	struct rkisp1_capture *cap = video_get_drvdata(fh->vdev);
+
+	if (sub->type != V4L2_EVENT_RKISP1_FILL_LEVEL)
+		return v4l2_ctrl_subscribe_event(fh, sub);
+
+	if (cap->id != RKISP1_MAINPATH)
+		return -EINVAL;
+
+	return v4l2_event_subscribe(fh, sub, 4, NULL);
+}
+
 static const struct v4l2_ioctl_ops rkisp1_v4l2_ioctl_ops = {
 	.vidioc_reqbufs = vb2_ioctl_reqbufs,
 	.vidioc_querybuf = vb2_ioctl_querybuf,
@@ -1454,10 +1517,61 @@ static const struct v4l2_ioctl_ops rkisp1_v4l2_ioctl_ops = {
 	.vidioc_enum_fmt_vid_cap = rkisp1_enum_fmt_vid_cap_mplane,
 	.vidioc_enum_framesizes = rkisp1_enum_framesizes,
 	.vidioc_querycap = rkisp1_querycap,
-	.vidioc_subscribe_event = v4l2_ctrl_subscribe_event,
+	.vidioc_subscribe_event = rkisp1_subscribe_event,
 	.vidioc_unsubscribe_event = v4l2_event_unsubscribe,
 };
 
+static int rkisp1_capture_s_ctrl(struct v4l2_ctrl *ctrl)
+{
+	struct rkisp1_capture *cap =
+		container_of(ctrl->handler, struct rkisp1_capture, ctrl_handler);
+
+	switch (ctrl->id) {
+	case V4L2_CID_RKISP1_FILL_LEVEL:
+		/* MI_IMSC is shared with the self path, see rkisp1_sp_config() */
+		mutex_lock(&cap->rkisp1->stream_lock);
+		cap->fill_lines = ctrl->val;
+		if (cap->is_streaming)
+			rkisp1_mp_fill_level_config(cap);
+		mutex_unlock(&cap->rkisp1->stream_lock);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+static const struct v4l2_ctrl_ops rkisp1_capture_ctrl_ops = {
+	.s_ctrl = rkisp1_capture_s_ctrl,
+};
+
+static const struct v4l2_ctrl_config rkisp1_fill_level_ctrl = {
+	.ops = &rkisp1_capture_ctrl_ops,
+	.id = V4L2_CID_RKISP1_FILL_LEVEL,
+	.name = "Fill Level Event Lines",
+	.type = V4L2_CTRL_TYPE_INTEGER,
+	.min = 0,
+	.max = RKISP1_RSZ_MP_SRC_MAX_HEIGHT,
+	.step = 1,
+	.def = 0,
+};
+
+static int rkisp1_capture_ctrls_init(struct rkisp1_capture *cap)
+{
+	struct v4l2_ctrl_handler *hdl = &cap->ctrl_handler;
+
+	v4l2_ctrl_handler_init(hdl, 1);
+	v4l2_ctrl_new_custom(hdl, &rkisp1_fill_level_ctrl, NULL);
+	if (hdl->error) {
+		int ret = hdl->error;
+
+		v4l2_ctrl_handler_free(hdl);
+		return ret;
+	}
+
+	cap->vnode.vdev.ctrl_handler = hdl;
+	return 0;
+}
+
 static int rkisp1_capture_link_validate(struct media_link *link)
 {
 	struct video_device *vdev =
@@ -1516,6 +1630,7 @@ static void rkisp1_unregister_capture(struct rkisp1_capture *cap)
 
 	media_entity_cleanup(&cap->vnode.vdev.entity);
 	vb2_video_unregister_device(&cap->vnode.vdev);
+	v4l2_ctrl_handler_free(cap->vnode.vdev.ctrl_handler);
 	mutex_destroy(&cap->vnode.vlock);
 }
 
@@ -1576,6 +1691,12 @@ static int rkisp1_register_capture(struct rkisp1_capture *cap)
 
 	vdev->queue = q;
 
+	if (cap->id == RKISP1_MAINPATH) {
+		ret = rkisp1_capture_ctrls_init(cap);
+		if (ret)
+			goto error;
+	}
+
 	ret = media_entity_pads_init(&vdev->entity, 1, &node->pad);
 	if (ret)
 		goto error;
@@ -1594,6 +1715,7 @@ static int rkisp1_register_capture(struct rkisp1_capture *cap)
 
 error:
 	media_entity_cleanup(&vdev->entity);
+	v4l2_ctrl_handler_free(vdev->ctrl_handler);
 	mutex_destroy(&node->vlock);
 	return ret;
 }
@@ -315,6 +315,9 @@ struct rkisp1_device;
  * @pix.cfg:	  pixel configuration
  * @pix.info:	  a pointer to the v4l2_format_info of the pixel format
  * @pix.fmt:	  buffer format
+ * @ctrl_handler: main path only, holds the fill level control
+ * @fill_lines:	  main path only, luma lines after which a fill level event is
+ *		  sent, 0 if disabled
  */
 struct rkisp1_capture {
 	struct rkisp1_vdev_node vnode;
@@ -339,6 +342,8 @@ struct rkisp1_capture {
 		const struct v4l2_format_info *info;
 		struct v4l2_pix_format_mplane fmt;
 	} pix;
+	struct v4l2_ctrl_handler ctrl_handler;
+	u32 fill_lines;
 };
 
 struct rkisp1_stats;
@@ -365,9 +370,14 @@ struct rkisp1_stats {
 	struct rkisp1_device *rkisp1;
 	const struct rkisp1_stats_ops *ops;
 
-	spinlock_t lock; /* locks the buffers list 'stats' */
+	spinlock_t lock; /* locks the buffers list 'stats' and pending_* */
 	struct list_head stat;
 	struct v4l2_format vdev_fmt;
+
+	/* Measurements latched by the hard IRQ, read out by the IRQ thread */
+	u32 pending_ris;
+	unsigned int pending_sequence;
+	u64 pending_timestamp;
 };
 
 struct rkisp1_params;
@@ -656,7 +666,8 @@ void rkisp1_params_disable(struct rkisp1_params *params);
 irqreturn_t rkisp1_isp_isr(int irq, void *ctx);
 irqreturn_t rkisp1_csi_isr(int irq, void *ctx);
 irqreturn_t rkisp1_capture_isr(int irq, void *ctx);
-void rkisp1_stats_isr(struct rkisp1_stats *stats, u32 isp_ris);
+bool rkisp1_stats_isr(struct rkisp1_stats *stats, u32 isp_ris);
+void rkisp1_stats_isr_thread(struct rkisp1_stats *stats);
 void rkisp1_params_isr(struct rkisp1_device *rkisp1);
 
 /* register/unregisters functions of the entities */
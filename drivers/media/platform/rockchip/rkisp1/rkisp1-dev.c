@@ -479,15 +479,34 @@ static irqreturn_t rkisp1_isr(int irq, void *ctx)
 	if (rkisp1_capture_isr(irq, ctx) == IRQ_HANDLED)
 		ret = IRQ_HANDLED;
 
-	if (rkisp1_isp_isr(irq, ctx) == IRQ_HANDLED)
-		ret = IRQ_HANDLED;
+	switch (rkisp1_isp_isr(irq, ctx)) {
+	case IRQ_WAKE_THREAD:
+		ret = IRQ_WAKE_THREAD;
+		break;
+	case IRQ_HANDLED:
+		if (ret == IRQ_NONE)
+			ret = IRQ_HANDLED;
+		break;
+	default:
+		break;
+	}
 
-	if (rkisp1_csi_isr(irq, ctx) == IRQ_HANDLED)
+	if (rkisp1_csi_isr(irq, ctx) == IRQ_HANDLED && ret == IRQ_NONE)
 		ret = IRQ_HANDLED;
 
 	return ret;
 }
 
+static irqreturn_t rkisp1_isr_thread(int irq, void *ctx)
+{
+	struct device *dev = ctx;
+	struct rkisp1_device *rkisp1 = dev_get_drvdata(dev);
+
+	rkisp1_stats_isr_thread(&rkisp1->stats);
+
+	return IRQ_HANDLED;
+}
+
 static const char * const px30_isp_clks[] = {
 	"isp",
 	"aclk",
@@ -562,6 +581,15 @@ static const struct rkisp1_info imx8mp_isp_info = {
 	.max_height = 3072,
 };
 
+/*
+ * Params and stats buffers can be bundled in a request so that a 3A update
+ * and the statistics it was computed for travel together.
+ */
+static const struct media_device_ops rkisp1_media_ops = {
+	.req_validate = vb2_request_validate,
+	.req_queue = vb2_request_queue,
+};
+
 static const struct of_device_id rkisp1_of_match[] = {
 	{
 		.compatible = "rockchip,px30-cif-isp",
@@ -628,8 +656,9 @@ static int rkisp1_probe(struct platform_device *pdev)
 				rkisp1->irqs[il] = irq;
 		}
 
-		ret = devm_request_irq(dev, irq, info->isrs[i].isr, IRQF_SHARED,
-				       dev_driver_string(dev), dev);
+		ret = devm_request_threaded_irq(dev, irq, info->isrs[i].isr,
+						rkisp1_isr_thread, IRQF_SHARED,
+						dev_driver_string(dev), dev);
 		if (ret) {
 			dev_err(dev, "request irq failed: %d\n", ret);
 			return ret;
@@ -673,6 +702,7 @@ static int rkisp1_probe(struct platform_device *pdev)
 	strscpy(rkisp1->media_dev.model, RKISP1_DRIVER_NAME,
 		sizeof(rkisp1->media_dev.model));
 	rkisp1->media_dev.dev = &pdev->dev;
+	rkisp1->media_dev.ops = &rkisp1_media_ops;
 	strscpy(rkisp1->media_dev.bus_info, RKISP1_BUS_INFO,
 		sizeof(rkisp1->media_dev.bus_info));
 	media_device_init(&rkisp1->media_dev);
@@ -1100,6 +1100,7 @@ irqreturn_t rkisp1_isp_isr(int irq, void *ctx)
 {
 	struct device *dev = ctx;
 	struct rkisp1_device *rkisp1 = dev_get_drvdata(dev);
+	irqreturn_t ret = IRQ_HANDLED;
 	u32 status, isp_err;
 
 	if (!rkisp1->irqs_enabled)
@@ -1142,8 +1143,9 @@ irqreturn_t rkisp1_isp_isr(int irq, void *ctx)
 
 		/* New frame from the sensor received */
 		isp_ris = rkisp1_read(rkisp1, RKISP1_CIF_ISP_RIS);
-		if (isp_ris & RKISP1_STATS_MEAS_MASK)
-			rkisp1_stats_isr(&rkisp1->stats, isp_ris);
+		if ((isp_ris & RKISP1_STATS_MEAS_MASK) &&
+		    rkisp1_stats_isr(&rkisp1->stats, isp_ris))
+			ret = IRQ_WAKE_THREAD;
 		/*
 		 * Then update changed configs. Some of them involve
 		 * lot of register writes. Do those only one per frame.
@@ -1152,5 +1154,5 @@ irqreturn_t rkisp1_isp_isr(int irq, void *ctx)
 		rkisp1_params_isr(rkisp1);
 	}
 
-	return IRQ_HANDLED;
+	return ret;
 }
@@ -6,6 +6,7 @@
  */
 
 #include <linux/math.h>
+#include <linux/module.h>
 #include <linux/string.h>
 
 #include <media/v4l2-common.h>
@@ -36,6 +37,11 @@
 #define RKISP1_ISP_CC_COEFF(n) \
 			(RKISP1_CIF_ISP_CC_COEFF_0 + (n) * 4)
 
+static bool params_coalesce;
+module_param(params_coalesce, bool, 0644);
+MODULE_PARM_DESC(params_coalesce,
+		 "Apply all pending params buffers at frame end instead of one per frame");
+
 #define RKISP1_EXT_PARAMS_BLOCK_GROUP_OTHERS	BIT(0)
 #define RKISP1_EXT_PARAMS_BLOCK_GROUP_LSC	BIT(1)
 
@@ -2169,10 +2175,25 @@ static void rkisp1_params_complete_buffer(struct rkisp1_params *params,
 	vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
 }
 
+static void rkisp1_params_apply_buffer(struct rkisp1_params *params,
+				       struct rkisp1_params_buffer *buf)
+{
+	if (params->metafmt->dataformat == V4L2_META_FMT_RK_ISP1_PARAMS) {
+		rkisp1_isp_isr_other_config(params, buf->cfg);
+		rkisp1_isp_isr_lsc_config(params, buf->cfg);
+		rkisp1_isp_isr_meas_config(params, buf->cfg);
+	} else {
+		rkisp1_ext_params_config(params, buf->cfg,
+					 RKISP1_EXT_PARAMS_BLOCK_GROUP_OTHERS |
+					 RKISP1_EXT_PARAMS_BLOCK_GROUP_LSC);
+	}
+}
+
 void rkisp1_params_isr(struct rkisp1_device *rkisp1)
 {
 	struct rkisp1_params *params = &rkisp1->params;
-	struct rkisp1_params_buffer *cur_buf;
+	struct rkisp1_params_buffer *cur_buf, *next;
+	LIST_HEAD(applied);
 
 	spin_lock(&params->config_lock);
 
@@ -2181,14 +2202,21 @@ void rkisp1_params_isr(struct rkisp1_device *rkisp1)
 	if (!cur_buf)
 		goto unlock;
 
-	if (params->metafmt->dataformat == V4L2_META_FMT_RK_ISP1_PARAMS) {
-		rkisp1_isp_isr_other_config(params, cur_buf->cfg);
-		rkisp1_isp_isr_lsc_config(params, cur_buf->cfg);
-		rkisp1_isp_isr_meas_config(params, cur_buf->cfg);
+	/*
+	 * When the 3A loop falls behind, several buffers pile up and would
+	 * otherwise be applied one per frame. In coalescing mode apply all of
+	 * them in queue order, which leaves the registers in the same state
+	 * as the last one would on its own, but on the next frame. Both the
+	 * legacy update masks and the extensible block enable/disable flags
+	 * are incremental, so none of them can simply be skipped.
+	 */
+	if (params_coalesce) {
+		list_splice_init(&params->params, &applied);
+		list_for_each_entry(cur_buf, &applied, queue)
+			rkisp1_params_apply_buffer(params, cur_buf);
 	} else {
-		rkisp1_ext_params_config(params, cur_buf->cfg,
-					 RKISP1_EXT_PARAMS_BLOCK_GROUP_OTHERS |
-					 RKISP1_EXT_PARAMS_BLOCK_GROUP_LSC);
+		list_move_tail(&cur_buf->queue, &applied);
+		rkisp1_params_apply_buffer(params, cur_buf);
 	}
 
 	/* update shadow register immediately */
@@ -2203,8 +2231,9 @@ void rkisp1_params_isr(struct rkisp1_device *rkisp1)
 	 * indicate to userspace on which frame these parameters are being
 	 * applied.
 	 */
-	rkisp1_params_complete_buffer(params, cur_buf,
-				      rkisp1->isp.frame_sequence + 1);
+	list_for_each_entry_safe(cur_buf, next, &applied, queue)
+		rkisp1_params_complete_buffer(params, cur_buf,
+					      rkisp1->isp.frame_sequence + 1);
 
 unlock:
 	spin_unlock(&params->config_lock);
@@ -2700,6 +2729,18 @@ static void rkisp1_params_vb2_stop_streaming(struct vb2_queue *vq)
 	params->enabled_blocks = 0;
 }
 
+/*
+ * A buffer bundled in a request that is cancelled before it reaches the
+ * driver still has to complete the request's control objects.
+ */
+static void rkisp1_params_vb2_buf_request_complete(struct vb2_buffer *vb)
+{
+	struct rkisp1_params *params = vb->vb2_queue->drv_priv;
+
+	v4l2_ctrl_request_complete(vb->req_obj.req,
+				   params->vnode.vdev.ctrl_handler);
+}
+
 static const struct vb2_ops rkisp1_params_vb2_ops = {
 	.queue_setup = rkisp1_params_vb2_queue_setup,
 	.buf_init = rkisp1_params_vb2_buf_init,
@@ -2708,6 +2749,7 @@ static const struct vb2_ops rkisp1_params_vb2_ops = {
 	.wait_finish = vb2_ops_wait_finish,
 	.buf_queue = rkisp1_params_vb2_buf_queue,
 	.buf_prepare = rkisp1_params_vb2_buf_prepare,
+	.buf_request_complete = rkisp1_params_vb2_buf_request_complete,
 	.stop_streaming = rkisp1_params_vb2_stop_streaming,
 };
 
@@ -2734,6 +2776,7 @@ static int rkisp1_params_init_vb2_queue(struct vb2_queue *q,
 	q->buf_struct_size = sizeof(struct rkisp1_params_buffer);
 	q->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
 	q->lock = &node->vlock;
+	q->supports_requests = true;
 
 	return vb2_queue_init(q);
 }
@@ -128,6 +128,14 @@ static int rkisp1_stats_vb2_buf_prepare(struct vb2_buffer *vb)
 	return 0;
 }
 
+static void rkisp1_stats_vb2_buf_request_complete(struct vb2_buffer *vb)
+{
+	struct rkisp1_stats *stats = vb->vb2_queue->drv_priv;
+
+	v4l2_ctrl_request_complete(vb->req_obj.req,
+				   stats->vnode.vdev.ctrl_handler);
+}
+
 static void rkisp1_stats_vb2_stop_streaming(struct vb2_queue *vq)
 {
 	struct rkisp1_stats *stats = vq->drv_priv;
@@ -143,13 +151,18 @@ static void rkisp1_stats_vb2_stop_streaming(struct vb2_queue *vq)
 		list_del(&buf->queue);
 		vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_ERROR);
 	}
+	stats->pending_ris = 0;
 	spin_unlock_irq(&stats->lock);
+
+	/* Let a running IRQ thread complete the buffer it may have taken */
+	synchronize_irq(stats->rkisp1->irqs[RKISP1_IRQ_ISP]);
 }
 
 static const struct vb2_ops rkisp1_stats_vb2_ops = {
 	.queue_setup = rkisp1_stats_vb2_queue_setup,
 	.buf_queue = rkisp1_stats_vb2_buf_queue,
 	.buf_prepare = rkisp1_stats_vb2_buf_prepare,
+	.buf_request_complete = rkisp1_stats_vb2_buf_request_complete,
 	.wait_prepare = vb2_ops_wait_prepare,
 	.wait_finish = vb2_ops_wait_finish,
 	.stop_streaming = rkisp1_stats_vb2_stop_streaming,
@@ -170,6 +183,7 @@ rkisp1_stats_init_vb2_queue(struct vb2_queue *q, struct rkisp1_stats *stats)
 	q->buf_struct_size = sizeof(struct rkisp1_buffer);
 	q->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
 	q->lock = &node->vlock;
+	q->supports_requests = true;
 
 	return vb2_queue_init(q);
 }
@@ -338,22 +352,11 @@ static struct rkisp1_stats_ops rkisp1_v12_stats_ops = {
 };
 
 static void
-rkisp1_stats_send_measurement(struct rkisp1_stats *stats, u32 isp_ris)
+rkisp1_stats_send_measurement(struct rkisp1_stats *stats,
+			      struct rkisp1_buffer *cur_buf, u32 isp_ris,
+			      unsigned int frame_sequence, u64 timestamp)
 {
 	struct rkisp1_stat_buffer *cur_stat_buf;
-	struct rkisp1_buffer *cur_buf = NULL;
-	unsigned int frame_sequence = stats->rkisp1->isp.frame_sequence;
-	u64 timestamp = ktime_get_ns();
-
-	/* get one empty buffer */
-	if (!list_empty(&stats->stat)) {
-		cur_buf = list_first_entry(&stats->stat,
-					   struct rkisp1_buffer, queue);
-		list_del(&cur_buf->queue);
-	}
-
-	if (!cur_buf)
-		return;
 
 	cur_stat_buf = (struct rkisp1_stat_buffer *)
 			vb2_plane_vaddr(&cur_buf->vb.vb2_buf, 0);
@@ -378,10 +381,20 @@ rkisp1_stats_send_measurement(struct rkisp1_stats *stats, u32 isp_ris)
 	vb2_buffer_done(&cur_buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
 }
 
-void rkisp1_stats_isr(struct rkisp1_stats *stats, u32 isp_ris)
+/*
+ * Reading out the measurements takes a few hundred register reads with the
+ * v12 histogram and AE grid. Only latch which of them are ready in the hard
+ * IRQ handler and leave the reads to the IRQ thread. The results stay valid
+ * until the end of the next frame. If the thread hasn't caught up by then,
+ * the previous frame's results are lost, which is accounted as a stats error.
+ *
+ * Returns true if the IRQ thread needs to run.
+ */
+bool rkisp1_stats_isr(struct rkisp1_stats *stats, u32 isp_ris)
 {
 	struct rkisp1_device *rkisp1 = stats->rkisp1;
 	unsigned int isp_mis_tmp = 0;
+	bool wake = false;
 
 	spin_lock(&stats->lock);
 
@@ -391,10 +404,47 @@ void rkisp1_stats_isr(struct rkisp1_stats *stats, u32 isp_ris)
 	if (isp_mis_tmp & RKISP1_STATS_MEAS_MASK)
 		rkisp1->debug.stats_error++;
 
-	if (isp_ris & RKISP1_STATS_MEAS_MASK)
-		rkisp1_stats_send_measurement(stats, isp_ris);
+	if (isp_ris & RKISP1_STATS_MEAS_MASK) {
+		if (stats->pending_ris)
+			rkisp1->debug.stats_error++;
+
+		stats->pending_ris = isp_ris & RKISP1_STATS_MEAS_MASK;
+		stats->pending_sequence = rkisp1->isp.frame_sequence;
+		stats->pending_timestamp = ktime_get_ns();
+		wake = true;
+	}
 
 	spin_unlock(&stats->lock);
+
+	return wake;
+}
+
+void rkisp1_stats_isr_thread(struct rkisp1_stats *stats)
+{
+	struct rkisp1_buffer *cur_buf = NULL;
+	unsigned int sequence;
+	u64 timestamp;
+	u32 isp_ris;
+
+	spin_lock_irq(&stats->lock);
+
+	isp_ris = stats->pending_ris;
+	sequence = stats->pending_sequence;
+	timestamp = stats->pending_timestamp;
+	stats->pending_ris = 0;
+
+	/* get one empty buffer */
+	if (isp_ris && !list_empty(&stats->stat)) {
+		cur_buf = list_first_entry(&stats->stat,
+					   struct rkisp1_buffer, queue);
+		list_del(&cur_buf->queue);
+	}
+
+	spin_unlock_irq(&stats->lock);
+
+	if (cur_buf)
+		rkisp1_stats_send_measurement(stats, cur_buf, isp_ris,
+					      sequence, timestamp);
 }
 
 static void rkisp1_init_stats(struct rkisp1_stats *stats)
@@ -110,6 +110,16 @@ static inline void mmc_should_fail_request(struct mmc_host *host,
 
 #endif /* CONFIG_FAIL_MMC_REQUEST */
 
+static void mmc_account_latency(struct mmc_host *host,
+				struct mmc_request *mrq)
+{
+	s64 us = ktime_us_delta(ktime_get(), mrq->start_time);
+	unsigned int bucket = us > 0 ? ilog2(us) + 1 : 0;
+
+	bucket = min_t(unsigned int, bucket, MMC_LAT_BUCKETS - 1);
+	host->lat_hist[!!(mrq->data->flags & MMC_DATA_WRITE)][bucket]++;
+}
+
 static inline void mmc_complete_cmd(struct mmc_request *mrq)
 {
 	if (mrq->cap_cmd_during_tfr && !completion_done(&mrq->cmd_completion))
@@ -173,6 +183,9 @@ void mmc_request_done(struct mmc_host *host, struct mmc_request *mrq)
 	if (!err || !cmd->retries || mmc_card_removed(host->card)) {
 		mmc_should_fail_request(host, mrq);
 
+		if (mrq->data)
+			mmc_account_latency(host, mrq);
+
 		if (!host->ongoing_mrq)
 			led_trigger_event(host->led, LED_OFF);
 
@@ -217,6 +230,8 @@ static void __mmc_start_request(struct mmc_host *host, struct mmc_request *mrq)
 {
 	int err;
 
+	mrq->start_time = ktime_get();
+
 	/* Assumes host controller has been runtime resumed by mmc_claim_host */
 	err = mmc_retune(host);
 	if (err) {
@@ -432,6 +447,8 @@ int mmc_cqe_start_req(struct mmc_host *host, struct mmc_request *mrq)
 {
 	int err;
 
+	mrq->start_time = ktime_get();
+
 	/*
 	 * CQE cannot process re-tuning commands. Caller must hold retuning
 	 * while CQE is in use.  Re-tuning can happen here only when CQE has no
@@ -482,6 +499,9 @@ void mmc_cqe_request_done(struct mmc_host *host, struct mmc_request *mrq)
 {
 	mmc_should_fail_request(host, mrq);
 
+	if (mrq->data)
+		mmc_account_latency(host, mrq);
+
 	/* Flag re-tuning needed on CRC errors */
 	if ((mrq->cmd && mrq->cmd->error == -EILSEQ) ||
 	    (mrq->data && mrq->data->error == -EILSEQ))
@@ -87,8 +87,48 @@ static int mmc_host_classdev_shutdown(struct device *dev)
 	return 0;
 }
 
+/*
+ * One line per latency bucket: the bucket's upper bound in microseconds, then
+ * the number of data reads and writes which completed within it. Writing
+ * anything clears the histogram.
+ */
+static ssize_t latency_hist_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct mmc_host *host = cls_dev_to_mmc_host(dev);
+	int i, len = 0;
+
+	for (i = 0; i < MMC_LAT_BUCKETS - 1; i++)
+		len += sysfs_emit_at(buf, len, "%lu %u %u\n", 1UL << i,
+				     READ_ONCE(host->lat_hist[0][i]),
+				     READ_ONCE(host->lat_hist[1][i]));
+	len += sysfs_emit_at(buf, len, "inf %u %u\n",
+			     READ_ONCE(host->lat_hist[0][i]),
+			     READ_ONCE(host->lat_hist[1][i]));
+
+	return len;
+}
+
+static ssize_t latency_hist_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t count)
+{
+	struct mmc_host *host = cls_dev_to_mmc_host(dev);
+
+	memset(host->lat_hist, 0, sizeof(host->lat_hist));
+	return count;
+}
+static DEVICE_ATTR_RW(latency_hist);
+
+static struct attribute *mmc_host_attrs[] = {
+	&dev_attr_latency_hist.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(mmc_host);
+
 static const struct class mmc_host_class = {
 	.name		= "mmc_host",
+	.dev_groups	= mmc_host_groups,
 	.dev_release	= mmc_host_classdev_release,
 	.shutdown_pre	= mmc_host_classdev_shutdown,
 	.pm		= MMC_HOST_CLASS_DEV_PM_OPS,
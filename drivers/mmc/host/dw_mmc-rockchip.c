@@ -296,6 +296,8 @@ static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 	int longest_range_len = -1;
 	int longest_range = -1;
 	int middle_phase;
+	int last_bad = -1;
+	int start;
 	int phase;
 
 	if (IS_ERR(priv->sample_clk)) {
@@ -321,8 +323,23 @@ static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 			first_v = v;
 
 		if ((!prev_v) && v) {
+			/*
+			 * Skipping after a bad phase may have stepped over the
+			 * start of this range. Walk back to its real edge, so
+			 * that the middle phase picked below is the one with
+			 * the most margin on both sides.
+			 */
+			for (start = i; start - 1 > last_bad; start--) {
+				rockchip_mmc_set_phase(host, true,
+						       TUNING_ITERATION_TO_PHASE(
+								start - 1,
+								priv->num_phases));
+				if (mmc_send_tuning(mmc, opcode, NULL))
+					break;
+			}
+
 			range_count++;
-			ranges[range_count-1].start = i;
+			ranges[range_count-1].start = start;
 		}
 		if (v) {
 			ranges[range_count-1].end = i;
@@ -331,6 +348,8 @@ static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 			/* No extra skipping rules if we're at the end */
 			i++;
 		} else {
+			last_bad = i;
+
 			/*
 			 * No need to check too close to an invalid
 			 * one since testing bad phases is slow.  Skip
@@ -398,7 +417,12 @@ static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 	middle_phase = ranges[longest_range].start + longest_range_len / 2;
 	middle_phase %= priv->num_phases;
 	phase = TUNING_ITERATION_TO_PHASE(middle_phase, priv->num_phases);
-	dev_info(host->dev, "Successfully tuned phase to %d\n", phase);
+	dev_info(host->dev, "Successfully tuned phase to %d (window %d-%d)\n",
+		 phase,
+		 TUNING_ITERATION_TO_PHASE(ranges[longest_range].start,
+					   priv->num_phases),
+		 TUNING_ITERATION_TO_PHASE(ranges[longest_range].end,
+					   priv->num_phases));
 
 	rockchip_mmc_set_phase(host, true, phase);
 
@@ -506,6 +530,7 @@ static const struct dw_mci_drv_data rk3288_drv_data = {
 	.execute_tuning		= dw_mci_rk3288_execute_tuning,
 	.parse_dt		= dw_mci_rk3288_parse_dt,
 	.init			= dw_mci_rockchip_init,
+	.use_hsq		= true,
 };
 
 static const struct dw_mci_drv_data rk3576_drv_data = {
@@ -514,6 +539,7 @@ static const struct dw_mci_drv_data rk3576_drv_data = {
 	.execute_tuning		= dw_mci_rk3288_execute_tuning,
 	.parse_dt		= dw_mci_rk3576_parse_dt,
 	.init			= dw_mci_rockchip_init,
+	.use_hsq		= true,
 };
 
 static const struct of_device_id dw_mci_rockchip_match[] = {
@@ -38,6 +38,7 @@
 #include <linux/mmc/slot-gpio.h>
 
 #include "dw_mmc.h"
+#include "mmc_hsq.h"
 
 /* Common flag combinations */
 #define DW_MCI_DATA_ERROR_FLAGS	(SDMMC_INT_DRTO | SDMMC_INT_DCRC | \
@@ -1412,6 +1413,17 @@ static void dw_mci_queue_request(struct dw_mci *host, struct dw_mci_slot *slot,
 	}
 }
 
+static void dw_mci_mmc_request_done(struct mmc_host *mmc,
+				    struct mmc_request *mrq)
+{
+	/* Requests issued by the software queue are completed through it */
+	if (IS_REACHABLE(CONFIG_MMC_HSQ) && mmc->cqe_private &&
+	    mmc_hsq_finalize_request(mmc, mrq))
+		return;
+
+	mmc_request_done(mmc, mrq);
+}
+
 static void dw_mci_request(struct mmc_host *mmc, struct mmc_request *mrq)
 {
 	struct dw_mci_slot *slot = mmc_priv(mmc);
@@ -1427,7 +1439,7 @@ static void dw_mci_request(struct mmc_host *mmc, struct mmc_request *mrq)
 
 	if (!dw_mci_get_cd(mmc)) {
 		mrq->cmd->error = -ENOMEDIUM;
-		mmc_request_done(mmc, mrq);
+		dw_mci_mmc_request_done(mmc, mrq);
 		return;
 	}
 
@@ -1920,8 +1932,12 @@ static void dw_mci_request_end(struct dw_mci *host, struct mmc_request *mrq)
 			host->state = STATE_IDLE;
 	}
 
+	/*
+	 * The software queue may issue its next request from here, which
+	 * takes host->lock again.
+	 */
 	spin_unlock(&host->lock);
-	mmc_request_done(prev_mmc, mrq);
+	dw_mci_mmc_request_done(prev_mmc, mrq);
 	spin_lock(&host->lock);
 }
 
@@ -3005,8 +3021,10 @@ static int dw_mci_init_slot_caps(struct dw_mci_slot *slot)
 
 static int dw_mci_init_slot(struct dw_mci *host)
 {
+	const struct dw_mci_drv_data *drv_data = host->drv_data;
 	struct mmc_host *mmc;
 	struct dw_mci_slot *slot;
+	struct mmc_hsq *hsq;
 	int ret;
 
 	mmc = mmc_alloc_host(sizeof(struct dw_mci_slot), host->dev);
@@ -3062,6 +3080,22 @@ static int dw_mci_init_slot(struct dw_mci *host)
 		mmc->max_seg_size = mmc->max_req_size;
 	}
 
+	/*
+	 * The software queue is selected by the glue drivers that use it,
+	 * it can't be reached from a built-in core when it is a module.
+	 */
+	if (IS_REACHABLE(CONFIG_MMC_HSQ) && drv_data && drv_data->use_hsq) {
+		hsq = devm_kzalloc(host->dev, sizeof(*hsq), GFP_KERNEL);
+		if (!hsq) {
+			ret = -ENOMEM;
+			goto err_host_allocated;
+		}
+
+		ret = mmc_hsq_init(hsq, mmc);
+		if (ret)
+			goto err_host_allocated;
+	}
+
 	dw_mci_get_cd(mmc);
 
 	ret = mmc_add_host(mmc);
@@ -3617,6 +3651,10 @@ int dw_mci_runtime_suspend(struct device *dev)
 {
 	struct dw_mci *host = dev_get_drvdata(dev);
 
+	if (IS_REACHABLE(CONFIG_MMC_HSQ) && host->slot &&
+	    host->slot->mmc->hsq_enabled)
+		mmc_hsq_suspend(host->slot->mmc);
+
 	if (host->use_dma && host->dma_ops->exit)
 		host->dma_ops->exit(host);
 
@@ -3687,6 +3725,10 @@ int dw_mci_runtime_resume(struct device *dev)
 	/* Now that slots are all setup, we can enable card detect */
 	dw_mci_enable_cd(host);
 
+	if (IS_REACHABLE(CONFIG_MMC_HSQ) && host->slot &&
+	    host->slot->mmc->hsq_enabled)
+		mmc_hsq_resume(host->slot->mmc);
+
 	return 0;
 
 err:
@@ -594,6 +594,7 @@ struct dw_mci_slot {
  * @set_data_timeout: implementation specific timeout.
  * @get_drto_clks: implementation specific cycle count for data read timeout.
  * @hw_reset: implementation specific HW reset.
+ * @use_hsq: issue requests through the MMC host software queue.
  *
  * Provide controller implementation specific extensions. The usage of this
  * data structure is fully optional and usage of each member in this structure
@@ -615,5 +616,6 @@ struct dw_mci_drv_data {
 					  unsigned int timeout_ns);
 	u32		(*get_drto_clks)(struct dw_mci *host);
 	void		(*hw_reset)(struct dw_mci *host);
+	bool		use_hsq;
 };
 #endif /* _DW_MMC_H_ */
@@ -328,6 +328,19 @@ static void rk_nfc_write_buf(struct rk_nfc *nfc, const u8 *buf, int len)
 		writeb(buf[i], nfc->regs + nfc->band_offset + BANK_DATA);
 }
 
+/*
+ * The page data is laid out contiguously in memory by the DMA engine, so
+ * a linear, word aligned caller buffer can be handed to the DMA engine as
+ * is instead of bouncing it through nfc->page_buf.
+ */
+static u8 *rk_nfc_dma_buf(struct rk_nfc *nfc, const u8 *buf)
+{
+	if (buf && virt_addr_valid(buf) && IS_ALIGNED((unsigned long)buf, 4))
+		return (u8 *)buf;
+
+	return nfc->page_buf;
+}
+
 static int rk_nfc_cmd(struct nand_chip *chip,
 		      const struct nand_subop *subop)
 {
@@ -597,15 +610,19 @@ static int rk_nfc_write_page_hwecc(struct nand_chip *chip, const u8 *buf,
 	int pages_per_blk = mtd->erasesize / mtd->writesize;
 	int ret = 0, i, boot_rom_mode = 0;
 	dma_addr_t dma_data, dma_oob;
+	u8 *dma_buf;
 	u32 tmp;
 	u8 *oob;
 
 	nand_prog_page_begin_op(chip, page, 0, NULL, 0);
 
-	if (buf)
-		memcpy(nfc->page_buf, buf, mtd->writesize);
-	else
-		memset(nfc->page_buf, 0xFF, mtd->writesize);
+	dma_buf = rk_nfc_dma_buf(nfc, buf);
+	if (dma_buf != buf) {
+		if (buf)
+			memcpy(dma_buf, buf, mtd->writesize);
+		else
+			memset(dma_buf, 0xFF, mtd->writesize);
+	}
 
 	/*
 	 * The first blocks (4, 8 or 16 depending on the device) are used
@@ -654,7 +671,7 @@ static int rk_nfc_write_page_hwecc(struct nand_chip *chip, const u8 *buf,
 			nfc->oob_buf[i * (oob_step / 4)] = tmp;
 	}
 
-	dma_data = dma_map_single(nfc->dev, (void *)nfc->page_buf,
+	dma_data = dma_map_single(nfc->dev, dma_buf,
 				  mtd->writesize, DMA_TO_DEVICE);
 	if (dma_mapping_error(nfc->dev, dma_data))
 		return -ENOMEM;
@@ -771,12 +788,15 @@ static int rk_nfc_read_page_hwecc(struct nand_chip *chip, u8 *buf, int oob_on,
 	dma_addr_t dma_data, dma_oob;
 	int ret = 0, i, cnt, boot_rom_mode = 0;
 	int max_bitflips = 0, bch_st, ecc_fail = 0;
+	u8 *dma_buf;
 	u8 *oob;
 	u32 tmp;
 
+	dma_buf = rk_nfc_dma_buf(nfc, buf);
+
 	nand_read_page_op(chip, page, 0, NULL, 0);
 
-	dma_data = dma_map_single(nfc->dev, nfc->page_buf,
+	dma_data = dma_map_single(nfc->dev, dma_buf,
 				  mtd->writesize,
 				  DMA_FROM_DEVICE);
 	if (dma_mapping_error(nfc->dev, dma_data))
@@ -864,8 +884,8 @@ static int rk_nfc_read_page_hwecc(struct nand_chip *chip, u8 *buf, int oob_on,
 		}
 	}
 
-	if (buf)
-		memcpy(buf, nfc->page_buf, mtd->writesize);
+	if (buf && dma_buf != buf)
+		memcpy(buf, dma_buf, mtd->writesize);
 
 timeout_err:
 	if (boot_rom_mode && rknand->boot_ecc != ecc->strength)
@@ -119,6 +119,9 @@ const struct class ubi_class = {
 
 static ssize_t dev_attribute_show(struct device *dev,
 				  struct device_attribute *attr, char *buf);
+static ssize_t dev_attribute_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t count);
 
 /* UBI device attributes (correspond to files in '/<sysfs>/class/ubi/ubiX') */
 static struct device_attribute dev_eraseblock_size =
@@ -145,6 +148,9 @@ static struct device_attribute dev_mtd_num =
 	__ATTR(mtd_num, S_IRUGO, dev_attribute_show, NULL);
 static struct device_attribute dev_ro_mode =
 	__ATTR(ro_mode, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_latency_hist =
+	__ATTR(latency_hist, S_IRUGO | S_IWUSR, dev_attribute_show,
+	       dev_attribute_store);
 
 /**
  * ubi_volume_notify - send a volume change notification.
@@ -340,6 +346,29 @@ int ubi_major2num(int major)
 	return ubi_num;
 }
 
+/*
+ * One line per latency bucket: the bucket's upper bound in microseconds, then
+ * the number of MTD reads, writes and erases which completed within it.
+ */
+static ssize_t latency_hist_show(struct ubi_device *ubi, char *buf)
+{
+	struct ubi_io_lat *lat = ubi->io_lat;
+	int i, len = 0;
+
+	for (i = 0; i < UBI_IO_LAT_BUCKETS; i++) {
+		if (i < UBI_IO_LAT_BUCKETS - 1)
+			len += sysfs_emit_at(buf, len, "%lu", 1UL << i);
+		else
+			len += sysfs_emit_at(buf, len, "inf");
+		len += sysfs_emit_at(buf, len, " %ld %ld %ld\n",
+			atomic_long_read(&lat->hist[UBI_IO_LAT_READ][i]),
+			atomic_long_read(&lat->hist[UBI_IO_LAT_WRITE][i]),
+			atomic_long_read(&lat->hist[UBI_IO_LAT_ERASE][i]));
+	}
+
+	return len;
+}
+
 /* "Show" method for files in '/<sysfs>/class/ubi/ubiX/' */
 static ssize_t dev_attribute_show(struct device *dev,
 				  struct device_attribute *attr, char *buf)
@@ -383,12 +412,33 @@ static ssize_t dev_attribute_show(struct device *dev,
 		ret = sprintf(buf, "%d\n", ubi->mtd->index);
 	else if (attr == &dev_ro_mode)
 		ret = sprintf(buf, "%d\n", ubi->ro_mode);
+	else if (attr == &dev_latency_hist)
+		ret = latency_hist_show(ubi, buf);
 	else
 		ret = -EINVAL;
 
 	return ret;
 }
 
+/* "Store" method for files in '/<sysfs>/class/ubi/ubiX/' */
+static ssize_t dev_attribute_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t count)
+{
+	struct ubi_device *ubi = container_of(dev, struct ubi_device, dev);
+	int i, j;
+
+	if (attr != &dev_latency_hist)
+		return -EINVAL;
+
+	/* Writing anything clears the histograms */
+	for (i = 0; i < UBI_IO_LAT_OPS; i++)
+		for (j = 0; j < UBI_IO_LAT_BUCKETS; j++)
+			atomic_long_set(&ubi->io_lat->hist[i][j], 0);
+
+	return count;
+}
+
 static struct attribute *ubi_dev_attrs[] = {
 	&dev_eraseblock_size.attr,
 	&dev_avail_eraseblocks.attr,
@@ -402,6 +452,7 @@ static struct attribute *ubi_dev_attrs[] = {
 	&dev_bgt_enabled.attr,
 	&dev_mtd_num.attr,
 	&dev_ro_mode.attr,
+	&dev_latency_hist.attr,
 	NULL
 };
 ATTRIBUTE_GROUPS(ubi_dev);
@@ -410,6 +461,7 @@ static void dev_release(struct device *dev)
 {
 	struct ubi_device *ubi = container_of(dev, struct ubi_device, dev);
 
+	kfree(ubi->io_lat);
 	kfree(ubi);
 }
 
@@ -934,6 +986,12 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 	if (!ubi)
 		return -ENOMEM;
 
+	ubi->io_lat = kzalloc(sizeof(struct ubi_io_lat), GFP_KERNEL);
+	if (!ubi->io_lat) {
+		kfree(ubi);
+		return -ENOMEM;
+	}
+
 	device_initialize(&ubi->dev);
 	ubi->dev.release = dev_release;
 	ubi->dev.class = &ubi_class;
@@ -580,6 +580,28 @@ static const struct file_operations eraseblk_count_fops = {
 	.release = eraseblk_count_release,
 };
 
+static int bgt_stats_show(struct seq_file *s, void *unused)
+{
+	unsigned long ubi_num = (unsigned long)s->private;
+	struct ubi_bgt_stats *stats;
+	struct ubi_device *ubi;
+
+	ubi = ubi_get_device(ubi_num);
+	if (!ubi)
+		return -ENODEV;
+	stats = &ubi->bgt_stats;
+
+	seq_printf(s, "works:\t\t%llu\n", stats->works);
+	seq_printf(s, "work_us_total:\t%llu\n", stats->work_us_total);
+	seq_printf(s, "work_us_max:\t%llu\n", stats->work_us_max);
+	seq_printf(s, "deferrals:\t%llu\n", stats->deferrals);
+	seq_printf(s, "defer_us_max:\t%llu\n", stats->defer_us_max);
+
+	ubi_put_device(ubi);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(bgt_stats);
+
 /**
  * ubi_debugfs_init_dev - initialize debugfs for an UBI device.
  * @ubi: UBI device description object
@@ -646,6 +668,9 @@ int ubi_debugfs_init_dev(struct ubi_device *ubi)
 	debugfs_create_file("detailed_erase_block_info", S_IRUSR, d->dfs_dir,
 			    (void *)ubi_num, &eraseblk_count_fops);
 
+	debugfs_create_file("bgt_stats", S_IRUSR, d->dfs_dir,
+			    (void *)ubi_num, &bgt_stats_fops);
+
 #ifdef CONFIG_MTD_UBI_FAULT_INJECTION
 	d->dfs_emulate_failures = debugfs_create_file("emulate_failures",
 						       mode, d->dfs_dir,
@@ -75,6 +75,7 @@
 
 #include <linux/crc32.h>
 #include <linux/err.h>
+#include <linux/log2.h>
 #include <linux/slab.h>
 #include "ubi.h"
 
@@ -88,6 +89,16 @@ static int self_check_vid_hdr(const struct ubi_device *ubi, int pnum,
 static int self_check_write(struct ubi_device *ubi, const void *buf, int pnum,
 			    int offset, int len);
 
+/* Accounts an MTD call started at @start in the latency histogram of @op */
+static void io_account(const struct ubi_device *ubi, int op, ktime_t start)
+{
+	s64 us = ktime_us_delta(ktime_get(), start);
+	unsigned int bucket = us > 0 ? ilog2(us) + 1 : 0;
+
+	bucket = min_t(unsigned int, bucket, UBI_IO_LAT_BUCKETS - 1);
+	atomic_long_inc(&ubi->io_lat->hist[op][bucket]);
+}
+
 /**
  * ubi_io_read - read data from a physical eraseblock.
  * @ubi: UBI device description object
@@ -116,6 +127,7 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 	int err, retries = 0;
 	size_t read;
 	loff_t addr;
+	ktime_t start;
 
 	dbg_io("read %d bytes from PEB %d:%d", len, pnum, offset);
 
@@ -151,7 +163,9 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 
 	addr = (loff_t)pnum * ubi->peb_size + offset;
 retry:
+	start = ktime_get();
 	err = mtd_read(ubi->mtd, addr, len, &read, buf);
+	io_account(ubi, UBI_IO_LAT_READ, start);
 	if (err) {
 		const char *errstr = mtd_is_eccerr(err) ? " (ECC error)" : "";
 
@@ -237,6 +251,7 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	int err;
 	size_t written;
 	loff_t addr;
+	ktime_t start;
 
 	dbg_io("write %d bytes to PEB %d:%d", len, pnum, offset);
 
@@ -280,7 +295,9 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	}
 
 	addr = (loff_t)pnum * ubi->peb_size + offset;
+	start = ktime_get();
 	err = mtd_write(ubi->mtd, addr, len, &written, buf);
+	io_account(ubi, UBI_IO_LAT_WRITE, start);
 	if (err) {
 		ubi_err(ubi, "error %d while writing %d bytes to PEB %d:%d, written %zd bytes",
 			err, len, pnum, offset, written);
@@ -320,6 +337,7 @@ static int do_sync_erase(struct ubi_device *ubi, int pnum)
 {
 	int err, retries = 0;
 	struct erase_info ei;
+	ktime_t start;
 
 	dbg_io("erase PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
@@ -335,7 +353,9 @@ static int do_sync_erase(struct ubi_device *ubi, int pnum)
 	ei.addr     = (loff_t)pnum * ubi->peb_size;
 	ei.len      = ubi->peb_size;
 
+	start = ktime_get();
 	err = mtd_erase(ubi->mtd, &ei);
+	io_account(ubi, UBI_IO_LAT_ERASE, start);
 	if (err) {
 		if (retries++ < UBI_IO_RETRIES) {
 			ubi_warn(ubi, "error %d while erasing PEB %d, retry",
@@ -434,6 +434,48 @@ struct ubi_debug_info {
 	struct dentry *dfs_emulate_failures;
 };
 
+/**
+ * struct ubi_bgt_stats - background thread statistics.
+ * @works: count of works done by the background thread
+ * @work_us_total: total time spent doing these works in microseconds
+ * @work_us_max: longest time spent in a single work in microseconds
+ * @deferrals: how many times works were held off for foreground reads
+ * @defer_us_max: longest time works were held off in microseconds
+ *
+ * The fields are only written by the background thread and are exposed via
+ * debugfs.
+ */
+struct ubi_bgt_stats {
+	u64 works;
+	u64 work_us_total;
+	u64 work_us_max;
+	u64 deferrals;
+	u64 defer_us_max;
+};
+
+/* Flash operations with a latency histogram */
+enum {
+	UBI_IO_LAT_READ,
+	UBI_IO_LAT_WRITE,
+	UBI_IO_LAT_ERASE,
+	UBI_IO_LAT_OPS,
+};
+
+#define UBI_IO_LAT_BUCKETS 24
+
+/**
+ * struct ubi_io_lat - flash operation latency histograms.
+ * @hist: per operation count of MTD calls by log2 of their duration in
+ *        microseconds: bucket 0 counts calls taking less than 1us, bucket n
+ *        those taking [2^(n-1), 2^n) us and the last bucket everything slower
+ *
+ * Exposed via sysfs. Kept apart from &struct ubi_device, as reads are done
+ * with a const pointer to the device.
+ */
+struct ubi_io_lat {
+	atomic_long_t hist[UBI_IO_LAT_OPS][UBI_IO_LAT_BUCKETS];
+};
+
 /**
  * struct ubi_device - UBI device description structure
  * @dev: UBI device object to use the Linux device model
@@ -516,6 +558,9 @@ struct ubi_debug_info {
  * @bgt_thread: background thread description object
  * @thread_enabled: if the background thread is enabled
  * @bgt_name: background thread name
+ * @fg_reads: count of LEB reads in progress, the background thread defers its
+ *            works while this is non-zero
+ * @bgt_stats: background thread work latency statistics
  *
  * @flash_size: underlying MTD device size (in bytes)
  * @peb_count: count of physical eraseblocks on the MTD device
@@ -545,6 +590,7 @@ struct ubi_debug_info {
  * @max_write_size: maximum amount of bytes the underlying flash can write at a
  *                  time (MTD write buffer size)
  * @mtd: MTD device descriptor
+ * @io_lat: flash operation latency histograms
  *
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
@@ -623,6 +669,8 @@ struct ubi_device {
 	struct task_struct *bgt_thread;
 	int thread_enabled;
 	char bgt_name[sizeof(UBI_BGT_NAME_PATTERN)+2];
+	atomic_t fg_reads;
+	struct ubi_bgt_stats bgt_stats;
 
 	/* I/O sub-system's stuff */
 	long long flash_size;
@@ -647,6 +695,7 @@ struct ubi_device {
 	unsigned int nor_flash:1;
 	int max_write_size;
 	struct mtd_info *mtd;
+	struct ubi_io_lat *io_lat;
 
 	void *peb_buf;
 	struct mutex buf_mutex;
@@ -89,6 +89,7 @@
 #include <linux/crc32.h>
 #include <linux/freezer.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
 #include "ubi.h"
 #include "wl.h"
 
@@ -122,6 +123,13 @@
  */
 #define WL_MAX_FAILURES 32
 
+/*
+ * Longest time the background thread holds off its works while there are
+ * foreground LEB reads in progress. A WL work may copy a whole eraseblock, so
+ * starting it in the middle of a burst of reads makes them stall behind it.
+ */
+#define WL_MAX_DEFER_MS 100
+
 static int self_check_ec(struct ubi_device *ubi, int pnum, int ec);
 static int self_check_in_wl_tree(const struct ubi_device *ubi,
 				 struct ubi_wl_entry *e, struct rb_root *root);
@@ -1668,13 +1676,16 @@ int ubi_thread(void *u)
 {
 	int failures = 0;
 	struct ubi_device *ubi = u;
+	struct ubi_bgt_stats *stats = &ubi->bgt_stats;
+	ktime_t start, defer_start = 0;
+	u64 delta;
 
 	ubi_msg(ubi, "background thread \"%s\" started, PID %d",
 		ubi->bgt_name, task_pid_nr(current));
 
 	set_freezable();
 	for (;;) {
-		int err;
+		int err, executed;
 
 		if (kthread_should_stop())
 			break;
@@ -1687,6 +1698,7 @@ int ubi_thread(void *u)
 		    !ubi->thread_enabled || ubi_dbg_is_bgt_disabled(ubi)) {
 			set_current_state(TASK_INTERRUPTIBLE);
 			spin_unlock(&ubi->wl_lock);
+			defer_start = 0;
 
 			/*
 			 * Check kthread_should_stop() after we set the task
@@ -1705,7 +1717,31 @@ int ubi_thread(void *u)
 		}
 		spin_unlock(&ubi->wl_lock);
 
-		err = do_work(ubi, NULL);
+		if (atomic_read(&ubi->fg_reads)) {
+			if (!defer_start)
+				defer_start = ktime_get();
+			if (ktime_ms_delta(ktime_get(), defer_start) <
+			    WL_MAX_DEFER_MS) {
+				schedule_timeout_interruptible(1);
+				continue;
+			}
+		}
+
+		if (defer_start) {
+			delta = ktime_us_delta(ktime_get(), defer_start);
+			stats->deferrals++;
+			stats->defer_us_max = max(stats->defer_us_max, delta);
+			defer_start = 0;
+		}
+
+		start = ktime_get();
+		err = do_work(ubi, &executed);
+		if (executed) {
+			delta = ktime_us_delta(ktime_get(), start);
+			stats->works++;
+			stats->work_us_total += delta;
+			stats->work_us_max = max(stats->work_us_max, delta);
+		}
 		if (err) {
 			ubi_err(ubi, "%s: work failed with error code %d",
 				ubi->bgt_name, err);
@@ -2021,6 +2021,12 @@ static int rk_gmac_probe(struct platform_device *pdev)
 	if (ret)
 		goto err_gmac_powerdown;
 
+	/*
+	 * Resume mostly waits for the PHY to come out of reset, don't hold
+	 * up the other devices meanwhile.
+	 */
+	device_enable_async_suspend(&pdev->dev);
+
 	return 0;
 
 err_gmac_powerdown:
@@ -301,6 +301,9 @@ enum power_event {
 #define GMAC_HI_REG_AE			BIT(31)
 
 /* L3/L4 Filters regs */
+#define GMAC_L3L4_DMCHEN0		BIT(28)
+#define GMAC_L3L4_DMCHN0		GENMASK(27, 24)
+#define GMAC_L3L4_DMCHN0_SHIFT		24
 #define GMAC_L4DPIM0			BIT(21)
 #define GMAC_L4DPM0			BIT(20)
 #define GMAC_L4SPIM0			BIT(19)
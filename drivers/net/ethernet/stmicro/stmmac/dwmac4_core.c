@@ -1150,6 +1150,36 @@ static int dwmac4_config_l4_filter(struct mac_device_info *hw, u32 filter_no,
 	return 0;
 }
 
+static int dwmac4_config_l3l4_dma_chan(struct mac_device_info *hw,
+				       u32 filter_no, bool en, u32 chan)
+{
+	void __iomem *ioaddr = hw->pcsr;
+	u32 value;
+
+	value = readl(ioaddr + GMAC_L3L4_CTRL(filter_no));
+	value &= ~(GMAC_L3L4_DMCHEN0 | GMAC_L3L4_DMCHN0);
+	if (en) {
+		value |= GMAC_L3L4_DMCHEN0;
+		value |= (chan << GMAC_L3L4_DMCHN0_SHIFT) & GMAC_L3L4_DMCHN0;
+	}
+	writel(value, ioaddr + GMAC_L3L4_CTRL(filter_no));
+
+	return 0;
+}
+
+static void dwmac4_set_l3l4_filter_drop(struct mac_device_info *hw, bool en)
+{
+	void __iomem *ioaddr = hw->pcsr;
+	u32 value;
+
+	value = readl(ioaddr + GMAC_PACKET_FILTER);
+	if (en)
+		value |= GMAC_PACKET_FILTER_IPFE;
+	else
+		value &= ~GMAC_PACKET_FILTER_IPFE;
+	writel(value, ioaddr + GMAC_PACKET_FILTER);
+}
+
 static void dwmac4_rx_hw_vlan(struct mac_device_info *hw,
 			      struct dma_desc *rx_desc, struct sk_buff *skb)
 {
@@ -1316,6 +1346,8 @@ const struct stmmac_ops dwmac510_ops = {
 	.set_arp_offload = dwmac4_set_arp_offload,
 	.config_l3_filter = dwmac4_config_l3_filter,
 	.config_l4_filter = dwmac4_config_l4_filter,
+	.config_l3l4_dma_chan = dwmac4_config_l3l4_dma_chan,
+	.set_l3l4_filter_drop = dwmac4_set_l3l4_filter_drop,
 	.fpe_configure = dwmac5_fpe_configure,
 	.fpe_send_mpacket = dwmac5_fpe_send_mpacket,
 	.fpe_irq_status = dwmac5_fpe_irq_status,
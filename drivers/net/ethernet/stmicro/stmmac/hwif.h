@@ -419,6 +419,9 @@ struct stmmac_ops {
 	int (*config_l4_filter)(struct mac_device_info *hw, u32 filter_no,
 				bool en, bool udp, bool sa, bool inv,
 				u32 match);
+	int (*config_l3l4_dma_chan)(struct mac_device_info *hw, u32 filter_no,
+				    bool en, u32 chan);
+	void (*set_l3l4_filter_drop)(struct mac_device_info *hw, bool en);
 	void (*set_arp_offload)(struct mac_device_info *hw, bool en, u32 addr);
 	void (*fpe_configure)(void __iomem *ioaddr, struct stmmac_fpe_cfg *cfg,
 			      u32 num_txq, u32 num_rxq,
@@ -528,6 +531,10 @@ struct stmmac_ops {
 	stmmac_do_callback(__priv, mac, config_l3_filter, __args)
 #define stmmac_config_l4_filter(__priv, __args...) \
 	stmmac_do_callback(__priv, mac, config_l4_filter, __args)
+#define stmmac_config_l3l4_dma_chan(__priv, __args...) \
+	stmmac_do_callback(__priv, mac, config_l3l4_dma_chan, __args)
+#define stmmac_set_l3l4_filter_drop(__priv, __args...) \
+	stmmac_do_void_callback(__priv, mac, set_l3l4_filter_drop, __args)
 #define stmmac_set_arp_offload(__priv, __args...) \
 	stmmac_do_void_callback(__priv, mac, set_arp_offload, __args)
 #define stmmac_fpe_configure(__priv, __args...) \
@@ -12,6 +12,7 @@
 #define STMMAC_RESOURCE_NAME   "stmmaceth"
 
 #include <linux/clk.h>
+#include <linux/dim.h>
 #include <linux/hrtimer.h>
 #include <linux/if_vlan.h>
 #include <linux/stmmac.h>
@@ -134,9 +135,29 @@ struct stmmac_rx_queue {
 		struct sk_buff *skb;
 		unsigned int len;
 		unsigned int error;
+		/* Head of a multi-buffer XDP frame still being gathered */
+		struct xdp_buff xdp;
+		bool xdp_mb;
 	} state;
 };
 
+enum stmmac_hist_type {
+	STMMAC_HIST_RX_IRQ_LAT,		/* us from DMA IRQ to RX poll */
+	STMMAC_HIST_RX_POLL,		/* us spent in the RX poll */
+	STMMAC_HIST_RX_WORK,		/* descriptors per RX poll */
+	STMMAC_HIST_RX_REFILL,		/* dirty descriptors at refill */
+	STMMAC_HIST_TX_IRQ_LAT,		/* us from DMA IRQ to TX poll */
+	STMMAC_HIST_TX_POLL,		/* us spent in the TX poll */
+	STMMAC_HIST_TX_WORK,		/* descriptors cleaned per TX poll */
+	STMMAC_HIST_TX_CLEAN,		/* descriptors pending at TX clean */
+	STMMAC_HIST_MAX,
+};
+
+/* Bucket 0 counts zero, bucket n counts [2^(n-1), 2^n), the last one
+ * everything above.
+ */
+#define STMMAC_HIST_BUCKETS	16
+
 struct stmmac_channel {
 	struct napi_struct rx_napi ____cacheline_aligned_in_smp;
 	struct napi_struct tx_napi ____cacheline_aligned_in_smp;
@@ -144,6 +165,16 @@ struct stmmac_channel {
 	struct stmmac_priv *priv_data;
 	spinlock_t lock;
 	u32 index;
+	struct dim rx_dim;
+	struct dim tx_dim;
+	u16 rx_dim_events;
+	u16 tx_dim_events;
+#ifdef CONFIG_STMMAC_LATENCY_HIST
+	/* Stamped by the DMA IRQ, consumed and cleared by the NAPI poll */
+	u64 rx_irq_ns;
+	u64 tx_irq_ns;
+	u64 hist[STMMAC_HIST_MAX][STMMAC_HIST_BUCKETS];
+#endif
 };
 
 /* FPE link-partner hand-shaking mPacket type */
@@ -217,6 +248,16 @@ struct stmmac_flow_entry {
 	int in_use;
 	int idx;
 	int is_l4;
+	/* Steering to an RX queue (ethtool ntuple / aRFS) */
+	int is_rxnfc;
+	int is_arfs;
+	int arfs_pending;
+	__be32 src;
+	__be32 dst;
+	__be16 sport;
+	__be16 dport;
+	u32 queue;
+	u32 flow_id;
 };
 
 /* Rx Frame Steering */
@@ -332,6 +373,8 @@ struct stmmac_priv {
 	u32 systime_flags;
 	u32 adv_ts;
 	int use_riwt;
+	bool rx_dim_enabled;
+	bool tx_dim_enabled;
 	int irq_wake;
 	rwlock_t ptp_lock;
 	/* Protects auxiliary snapshot registers from concurrent access. */
@@ -374,6 +417,11 @@ struct stmmac_priv {
 	struct stmmac_tc_entry *tc_entries;
 	unsigned int flow_entries_max;
 	struct stmmac_flow_entry *flow_entries;
+	/* Protects flow_entries slots taken for steering against aRFS */
+	spinlock_t flow_lock;
+#ifdef CONFIG_RFS_ACCEL
+	struct work_struct arfs_work;
+#endif
 	unsigned int rfs_entries_max[STMMAC_RFS_T_MAX];
 	unsigned int rfs_entries_cnt[STMMAC_RFS_T_MAX];
 	unsigned int rfs_entries_total;
@@ -403,6 +451,7 @@ int stmmac_mdio_reset(struct mii_bus *mii);
 int stmmac_pcs_setup(struct net_device *ndev);
 void stmmac_pcs_clean(struct net_device *ndev);
 void stmmac_set_ethtool_ops(struct net_device *netdev);
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv);
 
 int stmmac_init_tstamp_counter(struct stmmac_priv *priv, u32 systime_flags);
 void stmmac_ptp_register(struct stmmac_priv *priv);
@@ -421,6 +470,73 @@ int stmmac_reinit_queues(struct net_device *dev, u32 rx_cnt, u32 tx_cnt);
 int stmmac_reinit_ringparam(struct net_device *dev, u32 rx_size, u32 tx_size);
 int stmmac_bus_clks_config(struct stmmac_priv *priv, bool enabled);
 void stmmac_fpe_apply(struct stmmac_priv *priv);
+int stmmac_config_flow_steer(struct stmmac_priv *priv,
+			     struct stmmac_flow_entry *entry, bool en);
+void stmmac_update_l3l4_filter_drop(struct stmmac_priv *priv);
+
+#ifdef CONFIG_STMMAC_LATENCY_HIST
+extern const char * const stmmac_hist_names[STMMAC_HIST_MAX];
+
+static inline void stmmac_hist_add(struct stmmac_channel *ch,
+				   enum stmmac_hist_type type, u64 val)
+{
+	unsigned int b = min_t(unsigned int, fls64(val),
+			       STMMAC_HIST_BUCKETS - 1);
+
+	ch->hist[type][b]++;
+}
+
+static inline void stmmac_hist_irq(struct stmmac_channel *ch, bool tx)
+{
+	u64 *irq_ns = tx ? &ch->tx_irq_ns : &ch->rx_irq_ns;
+
+	if (!READ_ONCE(*irq_ns))
+		WRITE_ONCE(*irq_ns, ktime_get_ns());
+}
+
+static inline u64 stmmac_hist_poll_begin(struct stmmac_channel *ch, bool tx)
+{
+	u64 *irq_ns = tx ? &ch->tx_irq_ns : &ch->rx_irq_ns;
+	u64 ts = READ_ONCE(*irq_ns);
+	u64 now = ktime_get_ns();
+
+	/* Only the first poll after an interrupt has a latency */
+	if (ts) {
+		WRITE_ONCE(*irq_ns, 0);
+		stmmac_hist_add(ch, tx ? STMMAC_HIST_TX_IRQ_LAT :
+					 STMMAC_HIST_RX_IRQ_LAT,
+				div_u64(now - ts, NSEC_PER_USEC));
+	}
+
+	return now;
+}
+
+static inline void stmmac_hist_poll_end(struct stmmac_channel *ch, u64 start,
+					bool tx)
+{
+	stmmac_hist_add(ch, tx ? STMMAC_HIST_TX_POLL : STMMAC_HIST_RX_POLL,
+			div_u64(ktime_get_ns() - start, NSEC_PER_USEC));
+}
+#else
+static inline void stmmac_hist_add(struct stmmac_channel *ch,
+				   enum stmmac_hist_type type, u64 val)
+{
+}
+
+static inline void stmmac_hist_irq(struct stmmac_channel *ch, bool tx)
+{
+}
+
+static inline u64 stmmac_hist_poll_begin(struct stmmac_channel *ch, bool tx)
+{
+	return 0;
+}
+
+static inline void stmmac_hist_poll_end(struct stmmac_channel *ch, u64 start,
+					bool tx)
+{
+}
+#endif
 
 static inline bool stmmac_xdp_is_enabled(struct stmmac_priv *priv)
 {
@@ -298,6 +298,12 @@ static const char stmmac_qstats_rx_string[][ETH_GSTRING_LEN] = {
 #define STMMAC_RXQ_STATS ARRAY_SIZE(stmmac_qstats_rx_string)
 };
 
+#ifdef CONFIG_STMMAC_LATENCY_HIST
+#define STMMAC_HIST_STATS	(STMMAC_HIST_MAX * STMMAC_HIST_BUCKETS)
+#else
+#define STMMAC_HIST_STATS	0
+#endif
+
 static void stmmac_ethtool_getdrvinfo(struct net_device *dev,
 				      struct ethtool_drvinfo *info)
 {
@@ -619,6 +625,20 @@ static void stmmac_get_per_qstats(struct stmmac_priv *priv, u64 *data)
 	}
 }
 
+static void stmmac_get_hist_stats(struct stmmac_priv *priv, u64 *data)
+{
+#ifdef CONFIG_STMMAC_LATENCY_HIST
+	u32 maxq = max(priv->plat->rx_queues_to_use,
+		       priv->plat->tx_queues_to_use);
+	int q, t, b;
+
+	for (q = 0; q < maxq; q++)
+		for (t = 0; t < STMMAC_HIST_MAX; t++)
+			for (b = 0; b < STMMAC_HIST_BUCKETS; b++)
+				*data++ = READ_ONCE(priv->channel[q].hist[t][b]);
+#endif
+}
+
 static void stmmac_get_ethtool_stats(struct net_device *dev,
 				 struct ethtool_stats *dummy, u64 *data)
 {
@@ -723,6 +743,10 @@ static void stmmac_get_ethtool_stats(struct net_device *dev,
 	data[j++] = napi_poll;
 
 	stmmac_get_per_qstats(priv, &data[j]);
+	j += STMMAC_TXQ_STATS * tx_queues_count +
+	     STMMAC_RXQ_STATS * rx_queues_count;
+
+	stmmac_get_hist_stats(priv, &data[j]);
 }
 
 static int stmmac_get_sset_count(struct net_device *netdev, int sset)
@@ -736,7 +760,8 @@ static int stmmac_get_sset_count(struct net_device *netdev, int sset)
 	case ETH_SS_STATS:
 		len = STMMAC_STATS_LEN + STMMAC_QSTATS +
 		      STMMAC_TXQ_STATS * tx_cnt +
-		      STMMAC_RXQ_STATS * rx_cnt;
+		      STMMAC_RXQ_STATS * rx_cnt +
+		      STMMAC_HIST_STATS * max(tx_cnt, rx_cnt);
 
 		if (priv->dma_cap.rmon)
 			len += STMMAC_MMC_STATS_LEN;
@@ -781,6 +806,26 @@ static void stmmac_get_qstats_string(struct stmmac_priv *priv, u8 *data)
 	}
 }
 
+static void stmmac_get_hist_strings(struct stmmac_priv *priv, u8 *data)
+{
+#ifdef CONFIG_STMMAC_LATENCY_HIST
+	u32 maxq = max(priv->plat->rx_queues_to_use,
+		       priv->plat->tx_queues_to_use);
+	int q, t, b;
+
+	for (q = 0; q < maxq; q++) {
+		for (t = 0; t < STMMAC_HIST_MAX; t++) {
+			for (b = 0; b < STMMAC_HIST_BUCKETS; b++) {
+				snprintf(data, ETH_GSTRING_LEN, "q%d_%s_%lu",
+					 q, stmmac_hist_names[t],
+					 b ? BIT(b - 1) : 0);
+				data += ETH_GSTRING_LEN;
+			}
+		}
+	}
+#endif
+}
+
 static void stmmac_get_strings(struct net_device *dev, u32 stringset, u8 *data)
 {
 	int i;
@@ -815,6 +860,10 @@ static void stmmac_get_strings(struct net_device *dev, u32 stringset, u8 *data)
 			p += ETH_GSTRING_LEN;
 		}
 		stmmac_get_qstats_string(priv, p);
+		p += (STMMAC_TXQ_STATS * priv->plat->tx_queues_to_use +
+		      STMMAC_RXQ_STATS * priv->plat->rx_queues_to_use) *
+		     ETH_GSTRING_LEN;
+		stmmac_get_hist_strings(priv, p);
 		break;
 	case ETH_SS_TEST:
 		stmmac_selftest_get_strings(priv, p);
@@ -933,7 +982,7 @@ static int stmmac_ethtool_op_set_eee(struct net_device *dev,
 	return 0;
 }
 
-static u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv)
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv)
 {
 	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
 
@@ -994,6 +1043,9 @@ static int __stmmac_get_coalesce(struct net_device *dev,
 		ec->rx_coalesce_usecs = 0;
 	}
 
+	ec->use_adaptive_rx_coalesce = priv->rx_dim_enabled;
+	ec->use_adaptive_tx_coalesce = priv->tx_dim_enabled;
+
 	return 0;
 }
 
@@ -1031,6 +1083,12 @@ static int __stmmac_set_coalesce(struct net_device *dev,
 	else if (queue >= max_cnt)
 		return -EINVAL;
 
+	/* Adaptive RX moderation drives the RX watchdog, so it is only
+	 * available when the RIWT is in use.
+	 */
+	if (ec->use_adaptive_rx_coalesce && !priv->use_riwt)
+		return -EOPNOTSUPP;
+
 	if (priv->use_riwt) {
 		rx_riwt = stmmac_usec2riwt(ec->rx_coalesce_usecs, priv);
 
@@ -1080,6 +1138,9 @@ static int __stmmac_set_coalesce(struct net_device *dev,
 			ec->tx_coalesce_usecs;
 	}
 
+	priv->rx_dim_enabled = ec->use_adaptive_rx_coalesce;
+	priv->tx_dim_enabled = ec->use_adaptive_tx_coalesce;
+
 	return 0;
 }
 
@@ -1097,6 +1158,77 @@ static int stmmac_set_per_queue_coalesce(struct net_device *dev, u32 queue,
 	return __stmmac_set_coalesce(dev, ec, queue);
 }
 
+static int stmmac_get_ntuple_rule(struct stmmac_priv *priv,
+				  struct ethtool_rxnfc *rxnfc)
+{
+	struct ethtool_rx_flow_spec *fs = &rxnfc->fs;
+	struct stmmac_flow_entry *entry;
+
+	if (fs->location >= priv->flow_entries_max)
+		return -EINVAL;
+
+	entry = &priv->flow_entries[fs->location];
+	if (!entry->in_use || !entry->is_rxnfc)
+		return -ENOENT;
+
+	memset(&fs->h_u, 0, sizeof(fs->h_u));
+	memset(&fs->m_u, 0, sizeof(fs->m_u));
+
+	switch (entry->ip_proto) {
+	case IPPROTO_TCP:
+	case IPPROTO_UDP:
+		fs->flow_type = entry->ip_proto == IPPROTO_TCP ? TCP_V4_FLOW :
+								 UDP_V4_FLOW;
+		fs->h_u.tcp_ip4_spec.ip4src = entry->src;
+		fs->m_u.tcp_ip4_spec.ip4src = entry->src ? htonl(~0) : 0;
+		fs->h_u.tcp_ip4_spec.ip4dst = entry->dst;
+		fs->m_u.tcp_ip4_spec.ip4dst = entry->dst ? htonl(~0) : 0;
+		fs->h_u.tcp_ip4_spec.psrc = entry->sport;
+		fs->m_u.tcp_ip4_spec.psrc = entry->sport ? htons(~0) : 0;
+		fs->h_u.tcp_ip4_spec.pdst = entry->dport;
+		fs->m_u.tcp_ip4_spec.pdst = entry->dport ? htons(~0) : 0;
+		break;
+	default:
+		fs->flow_type = IPV4_USER_FLOW;
+		fs->h_u.usr_ip4_spec.ip_ver = ETH_RX_NFC_IP4;
+		fs->h_u.usr_ip4_spec.ip4src = entry->src;
+		fs->m_u.usr_ip4_spec.ip4src = entry->src ? htonl(~0) : 0;
+		fs->h_u.usr_ip4_spec.ip4dst = entry->dst;
+		fs->m_u.usr_ip4_spec.ip4dst = entry->dst ? htonl(~0) : 0;
+		break;
+	}
+
+	fs->ring_cookie = entry->queue;
+
+	return 0;
+}
+
+static int stmmac_get_ntuple_rules(struct stmmac_priv *priv,
+				   struct ethtool_rxnfc *rxnfc, u32 *rule_locs)
+{
+	u32 cnt = 0;
+	int i;
+
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		struct stmmac_flow_entry *entry = &priv->flow_entries[i];
+
+		if (!entry->in_use || !entry->is_rxnfc)
+			continue;
+
+		if (rule_locs) {
+			if (cnt == rxnfc->rule_cnt)
+				return -EMSGSIZE;
+			rule_locs[cnt] = i;
+		}
+		cnt++;
+	}
+
+	rxnfc->data = priv->flow_entries_max;
+	rxnfc->rule_cnt = cnt;
+
+	return 0;
+}
+
 static int stmmac_get_rxnfc(struct net_device *dev,
 			    struct ethtool_rxnfc *rxnfc, u32 *rule_locs)
 {
@@ -1106,6 +1238,14 @@ static int stmmac_get_rxnfc(struct net_device *dev,
 	case ETHTOOL_GRXRINGS:
 		rxnfc->data = priv->plat->rx_queues_to_use;
 		break;
+	case ETHTOOL_GRXCLSRLCNT:
+		if (!(dev->hw_features & NETIF_F_NTUPLE))
+			return -EOPNOTSUPP;
+		return stmmac_get_ntuple_rules(priv, rxnfc, NULL);
+	case ETHTOOL_GRXCLSRULE:
+		return stmmac_get_ntuple_rule(priv, rxnfc);
+	case ETHTOOL_GRXCLSRLALL:
+		return stmmac_get_ntuple_rules(priv, rxnfc, rule_locs);
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -1113,6 +1253,156 @@ static int stmmac_get_rxnfc(struct net_device *dev,
 	return 0;
 }
 
+/* The L3/L4 filters only match whole fields */
+static bool stmmac_ntuple_mask_ok(u32 value, u32 mask, u32 full)
+{
+	return (!mask && !value) || (mask == full && value);
+}
+
+static int stmmac_add_ntuple_rule(struct stmmac_priv *priv,
+				  struct ethtool_rx_flow_spec *fs)
+{
+	struct ethtool_tcpip4_spec *spec = &fs->h_u.tcp_ip4_spec;
+	struct ethtool_tcpip4_spec *mask = &fs->m_u.tcp_ip4_spec;
+	struct ethtool_usrip4_spec *uspec = &fs->h_u.usr_ip4_spec;
+	struct ethtool_usrip4_spec *umask = &fs->m_u.usr_ip4_spec;
+	struct stmmac_flow_entry *entry, rule = { };
+	bool was_in_use;
+	int ret;
+
+	if (fs->location >= priv->flow_entries_max)
+		return -EINVAL;
+	if (fs->ring_cookie == RX_CLS_FLOW_DISC)
+		return -EOPNOTSUPP;
+	if (ethtool_get_flow_spec_ring_vf(fs->ring_cookie) ||
+	    fs->ring_cookie >= priv->plat->rx_queues_to_use)
+		return -EINVAL;
+
+	switch (fs->flow_type) {
+	case TCP_V4_FLOW:
+	case UDP_V4_FLOW:
+		if (mask->tos)
+			return -EOPNOTSUPP;
+		if (!stmmac_ntuple_mask_ok(ntohl(spec->ip4src),
+					   ntohl(mask->ip4src), U32_MAX) ||
+		    !stmmac_ntuple_mask_ok(ntohl(spec->ip4dst),
+					   ntohl(mask->ip4dst), U32_MAX) ||
+		    !stmmac_ntuple_mask_ok(ntohs(spec->psrc),
+					   ntohs(mask->psrc), U16_MAX) ||
+		    !stmmac_ntuple_mask_ok(ntohs(spec->pdst),
+					   ntohs(mask->pdst), U16_MAX))
+			return -EOPNOTSUPP;
+		/* A filter holds a single L4 port */
+		if (spec->psrc && spec->pdst)
+			return -EOPNOTSUPP;
+
+		rule.ip_proto = fs->flow_type == TCP_V4_FLOW ? IPPROTO_TCP :
+							       IPPROTO_UDP;
+		rule.src = spec->ip4src;
+		rule.dst = spec->ip4dst;
+		rule.sport = spec->psrc;
+		rule.dport = spec->pdst;
+		break;
+	case IPV4_USER_FLOW:
+		if (umask->l4_4_bytes || umask->tos || umask->proto ||
+		    uspec->ip_ver != ETH_RX_NFC_IP4)
+			return -EOPNOTSUPP;
+		if (!stmmac_ntuple_mask_ok(ntohl(uspec->ip4src),
+					   ntohl(umask->ip4src), U32_MAX) ||
+		    !stmmac_ntuple_mask_ok(ntohl(uspec->ip4dst),
+					   ntohl(umask->ip4dst), U32_MAX))
+			return -EOPNOTSUPP;
+
+		rule.src = uspec->ip4src;
+		rule.dst = uspec->ip4dst;
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	if (!rule.src && !rule.dst && !rule.sport && !rule.dport)
+		return -EINVAL;
+
+	rule.queue = fs->ring_cookie;
+
+	entry = &priv->flow_entries[fs->location];
+
+	/* Slots used by tc flower or aRFS are not ours to take */
+	spin_lock_bh(&priv->flow_lock);
+	if (entry->in_use && !entry->is_rxnfc) {
+		spin_unlock_bh(&priv->flow_lock);
+		return -EBUSY;
+	}
+	was_in_use = entry->in_use;
+	entry->in_use = true;
+	entry->is_rxnfc = true;
+	spin_unlock_bh(&priv->flow_lock);
+
+	if (was_in_use && netif_running(priv->dev))
+		stmmac_config_flow_steer(priv, entry, false);
+
+	entry->ip_proto = rule.ip_proto;
+	entry->src = rule.src;
+	entry->dst = rule.dst;
+	entry->sport = rule.sport;
+	entry->dport = rule.dport;
+	entry->queue = rule.queue;
+
+	/* Otherwise programmed when the interface is brought up */
+	if (!netif_running(priv->dev))
+		return 0;
+
+	ret = stmmac_config_flow_steer(priv, entry, true);
+	if (ret) {
+		spin_lock_bh(&priv->flow_lock);
+		entry->in_use = false;
+		entry->is_rxnfc = false;
+		spin_unlock_bh(&priv->flow_lock);
+	}
+
+	return ret;
+}
+
+static int stmmac_del_ntuple_rule(struct stmmac_priv *priv, u32 location)
+{
+	struct stmmac_flow_entry *entry;
+
+	if (location >= priv->flow_entries_max)
+		return -EINVAL;
+
+	entry = &priv->flow_entries[location];
+	if (!entry->in_use || !entry->is_rxnfc)
+		return -ENOENT;
+
+	if (netif_running(priv->dev))
+		stmmac_config_flow_steer(priv, entry, false);
+
+	spin_lock_bh(&priv->flow_lock);
+	entry->in_use = false;
+	entry->is_rxnfc = false;
+	spin_unlock_bh(&priv->flow_lock);
+
+	return 0;
+}
+
+static int stmmac_set_rxnfc(struct net_device *dev,
+			    struct ethtool_rxnfc *rxnfc)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	if (!(dev->hw_features & NETIF_F_NTUPLE))
+		return -EOPNOTSUPP;
+
+	switch (rxnfc->cmd) {
+	case ETHTOOL_SRXCLSRLINS:
+		return stmmac_add_ntuple_rule(priv, &rxnfc->fs);
+	case ETHTOOL_SRXCLSRLDEL:
+		return stmmac_del_ntuple_rule(priv, rxnfc->fs.location);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
 static u32 stmmac_get_rxfh_key_size(struct net_device *dev)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
@@ -1358,7 +1648,8 @@ static void stmmac_get_mm_stats(struct net_device *ndev,
 
 static const struct ethtool_ops stmmac_ethtool_ops = {
 	.supported_coalesce_params = ETHTOOL_COALESCE_USECS |
-				     ETHTOOL_COALESCE_MAX_FRAMES,
+				     ETHTOOL_COALESCE_MAX_FRAMES |
+				     ETHTOOL_COALESCE_USE_ADAPTIVE,
 	.get_drvinfo = stmmac_ethtool_getdrvinfo,
 	.get_msglevel = stmmac_ethtool_getmsglevel,
 	.set_msglevel = stmmac_ethtool_setmsglevel,
@@ -1379,6 +1670,7 @@ static const struct ethtool_ops stmmac_ethtool_ops = {
 	.set_eee = stmmac_ethtool_op_set_eee,
 	.get_sset_count	= stmmac_get_sset_count,
 	.get_rxnfc = stmmac_get_rxnfc,
+	.set_rxnfc = stmmac_set_rxnfc,
 	.get_rxfh_key_size = stmmac_get_rxfh_key_size,
 	.get_rxfh_indir_size = stmmac_get_rxfh_indir_size,
 	.get_rxfh = stmmac_get_rxfh,
@@ -15,6 +15,7 @@
 *******************************************************************************/
 
 #include <linux/clk.h>
+#include <linux/cpu_rmap.h>
 #include <linux/kernel.h>
 #include <linux/interrupt.h>
 #include <linux/ip.h>
@@ -106,6 +107,14 @@ static int buf_sz = DEFAULT_BUFSIZE;
 module_param(buf_sz, int, 0644);
 MODULE_PARM_DESC(buf_sz, "DMA buffer size");
 
+/* Recycle ring of the RX page pools, 0 means as deep as the RX ring. The page
+ * pool refuses anything above 32768 entries.
+ */
+#define STMMAC_MAX_PP_SIZE	32768
+static int pp_size;
+module_param(pp_size, int, 0644);
+MODULE_PARM_DESC(pp_size, "RX page pool size per queue (0: RX ring size)");
+
 #define	STMMAC_RX_COPYBREAK	256
 
 static const u32 default_msg_level = (NETIF_MSG_DRV | NETIF_MSG_PROBE |
@@ -147,6 +156,19 @@ static void stmmac_exit_fs(struct net_device *dev);
 
 #define STMMAC_COAL_TIMER(x) (ns_to_ktime((x) * NSEC_PER_USEC))
 
+#ifdef CONFIG_STMMAC_LATENCY_HIST
+const char * const stmmac_hist_names[STMMAC_HIST_MAX] = {
+	[STMMAC_HIST_RX_IRQ_LAT] = "rx_irq_lat_us",
+	[STMMAC_HIST_RX_POLL] = "rx_poll_us",
+	[STMMAC_HIST_RX_WORK] = "rx_poll_desc",
+	[STMMAC_HIST_RX_REFILL] = "rx_refill_dirty",
+	[STMMAC_HIST_TX_IRQ_LAT] = "tx_irq_lat_us",
+	[STMMAC_HIST_TX_POLL] = "tx_poll_us",
+	[STMMAC_HIST_TX_WORK] = "tx_poll_desc",
+	[STMMAC_HIST_TX_CLEAN] = "tx_clean_pending",
+};
+#endif
+
 int stmmac_bus_clks_config(struct stmmac_priv *priv, bool enabled)
 {
 	int ret = 0;
@@ -198,6 +220,8 @@ static void stmmac_verify_args(void)
 		pause = PAUSE_TIME;
 	if (eee_timer < 0)
 		eee_timer = STMMAC_DEFAULT_LPI_TIMER;
+	if (unlikely((pp_size < 0) || (pp_size > STMMAC_MAX_PP_SIZE)))
+		pp_size = 0;
 }
 
 static void __stmmac_disable_all_queues(struct stmmac_priv *priv)
@@ -216,10 +240,14 @@ static void __stmmac_disable_all_queues(struct stmmac_priv *priv)
 			continue;
 		}
 
-		if (queue < rx_queues_cnt)
+		if (queue < rx_queues_cnt) {
 			napi_disable(&ch->rx_napi);
-		if (queue < tx_queues_cnt)
+			cancel_work_sync(&ch->rx_dim.work);
+		}
+		if (queue < tx_queues_cnt) {
 			napi_disable(&ch->tx_napi);
+			cancel_work_sync(&ch->tx_dim.work);
+		}
 	}
 }
 
@@ -1358,6 +1386,27 @@ static int stmmac_set_bfsize(int mtu, int bufsize)
 	return ret;
 }
 
+static int stmmac_rx_buf_size(struct stmmac_priv *priv, unsigned int mtu)
+{
+	int bfsize;
+
+	/* XDP needs the headroom, a full sized frame and the shared info
+	 * for the frags in one page. Jumbo frames are then received
+	 * across several descriptors as multi-buffer frames.
+	 */
+	if (stmmac_xdp_is_enabled(priv))
+		return DEFAULT_BUFSIZE;
+
+	bfsize = stmmac_set_16kib_bfsize(priv, mtu);
+	if (bfsize < 0)
+		bfsize = 0;
+
+	if (bfsize < BUF_SIZE_16KiB)
+		bfsize = stmmac_set_bfsize(mtu, 0);
+
+	return bfsize;
+}
+
 /**
  * stmmac_clear_rx_descriptors - clear RX descriptors
  * @priv: driver private structure
@@ -1933,6 +1982,22 @@ static void __free_dma_rx_desc_resources(struct stmmac_priv *priv,
 {
 	struct stmmac_rx_queue *rx_q = &dma_conf->rx_queue[queue];
 
+	/* Drop a multi-buffer XDP frame that was left half received */
+	if (rx_q->state_saved && rx_q->state.xdp_mb) {
+		struct xdp_buff *xdp = &rx_q->state.xdp;
+		struct skb_shared_info *sinfo;
+		int i;
+
+		sinfo = xdp_get_shared_info_from_buff(xdp);
+		for (i = 0; xdp_buff_has_frags(xdp) && i < sinfo->nr_frags; i++)
+			page_pool_put_full_page(rx_q->page_pool,
+						skb_frag_page(&sinfo->frags[i]),
+						false);
+		page_pool_put_full_page(rx_q->page_pool,
+					virt_to_head_page(xdp->data), false);
+		rx_q->state.xdp_mb = false;
+	}
+
 	/* Release the DMA RX socket buffers */
 	if (rx_q->xsk_pool)
 		dma_free_rx_xskbufs(priv, dma_conf, queue);
@@ -2044,14 +2109,18 @@ static int __alloc_dma_rx_desc_resources(struct stmmac_priv *priv,
 	rx_q->priv_data = priv;
 
 	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
-	pp_params.pool_size = dma_conf->dma_rx_size;
+	pp_params.pool_size = pp_size ? pp_size : dma_conf->dma_rx_size;
 	num_pages = DIV_ROUND_UP(dma_conf->dma_buf_sz, PAGE_SIZE);
 	pp_params.order = ilog2(num_pages);
 	pp_params.nid = dev_to_node(priv->device);
 	pp_params.dev = priv->device;
 	pp_params.dma_dir = xdp_prog ? DMA_BIDIRECTIONAL : DMA_FROM_DEVICE;
 	pp_params.offset = stmmac_rx_offset(priv);
-	pp_params.max_len = STMMAC_MAX_RX_BUF_SIZE(num_pages);
+	/* The DMA never writes past the programmed buffer size, so there is
+	 * no point in syncing the rest of the page for the device.
+	 */
+	pp_params.max_len = min_t(unsigned int, dma_conf->dma_buf_sz,
+				  STMMAC_MAX_RX_BUF_SIZE(num_pages));
 
 	rx_q->page_pool = page_pool_create(&pp_params);
 	if (IS_ERR(rx_q->page_pool)) {
@@ -2491,33 +2560,35 @@ static bool stmmac_xdp_xmit_zc(struct stmmac_priv *priv, u32 queue, u32 budget)
 	struct xsk_buff_pool *pool = tx_q->xsk_pool;
 	unsigned int entry = tx_q->cur_tx;
 	struct dma_desc *tx_desc = NULL;
-	struct xdp_desc xdp_desc;
 	bool work_done = true;
 	u32 tx_set_ic_bit = 0;
+	u32 avail, nb_pkts, i;
 
 	/* Avoids TX time-out as we are sharing with slow path */
 	txq_trans_cond_update(nq);
 
-	budget = min(budget, stmmac_tx_avail(priv, queue));
+	/* We are sharing with slow path and stop XSK TX desc submission when
+	 * available TX ring is less than threshold.
+	 */
+	avail = stmmac_tx_avail(priv, queue);
+	if (unlikely(avail < STMMAC_TX_XSK_AVAIL) ||
+	    !netif_carrier_ok(priv->dev))
+		return false;
+
+	if (budget > avail - STMMAC_TX_XSK_AVAIL + 1) {
+		budget = avail - STMMAC_TX_XSK_AVAIL + 1;
+		work_done = false;
+	}
+
+	nb_pkts = xsk_tx_peek_release_desc_batch(pool, budget);
 
-	for (; budget > 0; budget--) {
+	for (i = 0; i < nb_pkts; i++) {
+		struct xdp_desc xdp_desc = pool->tx_descs[i];
 		struct stmmac_metadata_request meta_req;
 		struct xsk_tx_metadata *meta = NULL;
 		dma_addr_t dma_addr;
 		bool set_ic;
 
-		/* We are sharing with slow path and stop XSK TX desc submission when
-		 * available TX ring is less than threshold.
-		 */
-		if (unlikely(stmmac_tx_avail(priv, queue) < STMMAC_TX_XSK_AVAIL) ||
-		    !netif_carrier_ok(priv->dev)) {
-			work_done = false;
-			break;
-		}
-
-		if (!xsk_tx_peek_desc(pool, &xdp_desc))
-			break;
-
 		if (priv->est && priv->est->enable &&
 		    priv->est->max_sdu[queue] &&
 		    xdp_desc.len > priv->est->max_sdu[queue]) {
@@ -2576,8 +2647,6 @@ static bool stmmac_xdp_xmit_zc(struct stmmac_priv *priv, u32 queue, u32 budget)
 				       true, priv->mode, true, true,
 				       xdp_desc.len);
 
-		stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
-
 		xsk_tx_metadata_to_compl(meta,
 					 &tx_q->tx_skbuff_dma[entry].xsk_meta);
 
@@ -2588,9 +2657,10 @@ static bool stmmac_xdp_xmit_zc(struct stmmac_priv *priv, u32 queue, u32 budget)
 	u64_stats_add(&txq_stats->napi.tx_set_ic_bit, tx_set_ic_bit);
 	u64_stats_update_end(&txq_stats->napi_syncp);
 
+	/* One tail pointer update for the whole batch */
 	if (tx_desc) {
 		stmmac_flush_tx_descriptors(priv, queue);
-		xsk_tx_release(pool);
+		stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
 	}
 
 	/* Return true if all of the 3 conditions are met
@@ -2598,7 +2668,7 @@ static bool stmmac_xdp_xmit_zc(struct stmmac_priv *priv, u32 queue, u32 budget)
 	 *  b) work_done = true when XSK TX desc peek is empty (no more
 	 *     pending XSK TX for transmission)
 	 */
-	return !!budget && work_done;
+	return nb_pkts < budget && work_done;
 }
 
 static void stmmac_bump_dma_threshold(struct stmmac_priv *priv, u32 chan)
@@ -2634,13 +2704,22 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue,
 	unsigned int bytes_compl = 0, pkts_compl = 0;
 	unsigned int entry, xmits = 0, count = 0;
 	u32 tx_packets = 0, tx_errors = 0;
+	struct xdp_frame_bulk bq;
 
 	__netif_tx_lock_bh(netdev_get_tx_queue(priv->dev, queue));
 
+	stmmac_hist_add(&priv->channel[queue], STMMAC_HIST_TX_CLEAN,
+			priv->dma_conf.dma_tx_size - 1 -
+			stmmac_tx_avail(priv, queue));
+
 	tx_q->xsk_frames_done = 0;
 
 	entry = tx_q->dirty_tx;
 
+	/* xdp_return_frame_bulk() needs RCU protection */
+	rcu_read_lock();
+	xdp_frame_bulk_init(&bq);
+
 	/* Try to clean all TX complete frame in 1 shot */
 	while ((entry != tx_q->cur_tx) && count < priv->dma_conf.dma_tx_size) {
 		struct xdp_frame *xdpf;
@@ -2734,7 +2813,7 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue,
 
 		if (xdpf &&
 		    tx_q->tx_skbuff_dma[entry].buf_type == STMMAC_TXBUF_T_XDP_NDO) {
-			xdp_return_frame(xdpf);
+			xdp_return_frame_bulk(xdpf, &bq);
 			tx_q->xdpf[entry] = NULL;
 		}
 
@@ -2745,7 +2824,7 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue,
 			if (likely(skb)) {
 				pkts_compl++;
 				bytes_compl += skb->len;
-				dev_consume_skb_any(skb);
+				napi_consume_skb(skb, budget);
 				tx_q->tx_skbuff[entry] = NULL;
 			}
 		}
@@ -2754,6 +2833,8 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue,
 
 		entry = STMMAC_GET_ENTRY(entry, priv->dma_conf.dma_tx_size);
 	}
+	xdp_flush_frame_bulk(&bq);
+	rcu_read_unlock();
 	tx_q->dirty_tx = entry;
 
 	netdev_tx_completed_queue(netdev_get_tx_queue(priv->dev, queue),
@@ -2900,20 +2981,30 @@ static int stmmac_napi_check(struct stmmac_priv *priv, u32 chan, u32 dir)
 	rx_napi = rx_q->xsk_pool ? &ch->rxtx_napi : &ch->rx_napi;
 	tx_napi = tx_q->xsk_pool ? &ch->rxtx_napi : &ch->tx_napi;
 
+	/* Mask the channel even when the NAPI instance is already owned,
+	 * e.g. by a socket busy polling it: whoever owns it unmasks the
+	 * IRQ again once napi_complete_done() allows it, which is never
+	 * the case while busy polling or deferring hard IRQs. Leaving it
+	 * unmasked here would just raise one interrupt per frame.
+	 */
 	if ((status & handle_rx) && (chan < priv->plat->rx_queues_to_use)) {
+		spin_lock_irqsave(&ch->lock, flags);
+		stmmac_disable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
+		spin_unlock_irqrestore(&ch->lock, flags);
+
 		if (napi_schedule_prep(rx_napi)) {
-			spin_lock_irqsave(&ch->lock, flags);
-			stmmac_disable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
-			spin_unlock_irqrestore(&ch->lock, flags);
+			stmmac_hist_irq(ch, false);
 			__napi_schedule(rx_napi);
 		}
 	}
 
 	if ((status & handle_tx) && (chan < priv->plat->tx_queues_to_use)) {
+		spin_lock_irqsave(&ch->lock, flags);
+		stmmac_disable_dma_irq(priv, priv->ioaddr, chan, 0, 1);
+		spin_unlock_irqrestore(&ch->lock, flags);
+
 		if (napi_schedule_prep(tx_napi)) {
-			spin_lock_irqsave(&ch->lock, flags);
-			stmmac_disable_dma_irq(priv, priv->ioaddr, chan, 0, 1);
-			spin_unlock_irqrestore(&ch->lock, flags);
+			stmmac_hist_irq(ch, true);
 			__napi_schedule(tx_napi);
 		}
 	}
@@ -3099,11 +3190,17 @@ static void stmmac_tx_timer_arm(struct stmmac_priv *priv, u32 queue)
 	/* Arm timer only if napi is not already scheduled.
 	 * Try to cancel any timer if napi is scheduled, timer will be armed
 	 * again in the next scheduled napi.
+	 *
+	 * The timer only reclaims completed descriptors, so give it a slack
+	 * of a quarter of its period: it may then expire up to that much
+	 * later, together with another timer, rather than waking an idle CPU
+	 * on its own.
 	 */
 	if (unlikely(!napi_is_scheduled(napi)))
-		hrtimer_start(&tx_q->txtimer,
-			      STMMAC_COAL_TIMER(tx_coal_timer),
-			      HRTIMER_MODE_REL);
+		hrtimer_start_range_ns(&tx_q->txtimer,
+				       STMMAC_COAL_TIMER(tx_coal_timer),
+				       tx_coal_timer * NSEC_PER_USEC / 4,
+				       HRTIMER_MODE_REL);
 	else
 		hrtimer_try_to_cancel(&tx_q->txtimer);
 }
@@ -3379,6 +3476,19 @@ static void stmmac_safety_feat_configuration(struct stmmac_priv *priv)
 	}
 }
 
+/* The MAC reset wipes the L3/L4 filters, put the ethtool ntuple rules back */
+static void stmmac_restore_flow_steer(struct stmmac_priv *priv)
+{
+	int i;
+
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		struct stmmac_flow_entry *entry = &priv->flow_entries[i];
+
+		if (entry->in_use && entry->is_rxnfc)
+			stmmac_config_flow_steer(priv, entry, true);
+	}
+}
+
 /**
  * stmmac_hw_setup - setup mac in a usable state.
  *  @dev : pointer to the device structure.
@@ -3445,6 +3555,10 @@ static int stmmac_hw_setup(struct net_device *dev, bool ptp_register)
 		priv->hw->rx_csum = 0;
 	}
 
+	/* The DMA reset above also cleared a loopback set through ethtool */
+	if (dev->features & NETIF_F_LOOPBACK)
+		stmmac_set_mac_loopback(priv, priv->ioaddr, true);
+
 	/* Enable the MAC Rx/Tx */
 	stmmac_mac_set(priv, priv->ioaddr, true);
 
@@ -3533,6 +3647,8 @@ static int stmmac_hw_setup(struct net_device *dev, bool ptp_register)
 
 	stmmac_set_hw_vlan_mode(priv, priv->hw);
 
+	stmmac_restore_flow_steer(priv);
+
 	return 0;
 }
 
@@ -3549,6 +3665,14 @@ static void stmmac_free_irq(struct net_device *dev,
 	struct stmmac_priv *priv = netdev_priv(dev);
 	int j;
 
+#ifdef CONFIG_RFS_ACCEL
+	/* Drop the affinity notifiers before the lines go away */
+	if (dev->rx_cpu_rmap) {
+		free_irq_cpu_rmap(dev->rx_cpu_rmap);
+		dev->rx_cpu_rmap = NULL;
+	}
+#endif
+
 	switch (irq_err) {
 	case REQ_IRQ_ERR_ALL:
 		irq_idx = priv->plat->tx_queues_to_use;
@@ -3759,6 +3883,22 @@ static int stmmac_request_irq_multi_msi(struct net_device *dev)
 				      cpumask_of(i % num_online_cpus()));
 	}
 
+#ifdef CONFIG_RFS_ACCEL
+	/* aRFS needs to know which CPU each RX queue interrupts, not having
+	 * it only means flows are not steered.
+	 */
+	if (dev->hw_features & NETIF_F_NTUPLE) {
+		dev->rx_cpu_rmap = alloc_irq_cpu_rmap(priv->plat->rx_queues_to_use);
+		for (i = 0; dev->rx_cpu_rmap && i < priv->plat->rx_queues_to_use; i++) {
+			if (priv->rx_irq[i] <= 0 ||
+			    irq_cpu_rmap_add(dev->rx_cpu_rmap, priv->rx_irq[i])) {
+				free_irq_cpu_rmap(dev->rx_cpu_rmap);
+				dev->rx_cpu_rmap = NULL;
+			}
+		}
+	}
+#endif
+
 	return 0;
 
 irq_error:
@@ -3860,7 +4000,7 @@ static struct stmmac_dma_conf *
 stmmac_setup_dma_desc(struct stmmac_priv *priv, unsigned int mtu)
 {
 	struct stmmac_dma_conf *dma_conf;
-	int chan, bfsize, ret;
+	int chan, ret;
 
 	dma_conf = kzalloc(sizeof(*dma_conf), GFP_KERNEL);
 	if (!dma_conf) {
@@ -3869,14 +4009,7 @@ stmmac_setup_dma_desc(struct stmmac_priv *priv, unsigned int mtu)
 		return ERR_PTR(-ENOMEM);
 	}
 
-	bfsize = stmmac_set_16kib_bfsize(priv, mtu);
-	if (bfsize < 0)
-		bfsize = 0;
-
-	if (bfsize < BUF_SIZE_16KiB)
-		bfsize = stmmac_set_bfsize(mtu, 0);
-
-	dma_conf->dma_buf_sz = bfsize;
+	dma_conf->dma_buf_sz = stmmac_rx_buf_size(priv, mtu);
 	/* Chose the tx/rx size from the already defined one in the
 	 * priv struct. (if defined)
 	 */
@@ -4027,6 +4160,38 @@ static int stmmac_open(struct net_device *dev)
 	return ret;
 }
 
+#ifdef CONFIG_RFS_ACCEL
+static void stmmac_arfs_flush(struct stmmac_priv *priv)
+{
+	struct stmmac_flow_entry *entry;
+	int i;
+
+	cancel_work_sync(&priv->arfs_work);
+
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		entry = &priv->flow_entries[i];
+
+		spin_lock_bh(&priv->flow_lock);
+		if (!entry->in_use || !entry->is_arfs) {
+			spin_unlock_bh(&priv->flow_lock);
+			continue;
+		}
+		entry->is_arfs = false;
+		spin_unlock_bh(&priv->flow_lock);
+
+		stmmac_config_flow_steer(priv, entry, false);
+
+		spin_lock_bh(&priv->flow_lock);
+		entry->in_use = false;
+		spin_unlock_bh(&priv->flow_lock);
+	}
+}
+#else
+static void stmmac_arfs_flush(struct stmmac_priv *priv)
+{
+}
+#endif /* CONFIG_RFS_ACCEL */
+
 /**
  *  stmmac_release - close entry point of the driver
  *  @dev : device pointer.
@@ -4062,6 +4227,10 @@ static int stmmac_release(struct net_device *dev)
 	/* Stop TX/RX DMA and clear the descriptors */
 	stmmac_stop_all_dma(priv);
 
+	/* The MAC is reset on open, accelerated flows are simply relearnt */
+	if (dev->hw_features & NETIF_F_NTUPLE)
+		stmmac_arfs_flush(priv);
+
 	/* Release and free the Rx/Tx resources */
 	free_dma_desc_resources(priv, &priv->dma_conf);
 
@@ -4224,7 +4393,7 @@ static netdev_tx_t stmmac_tso_xmit(struct sk_buff *skb, struct net_device *dev)
 	u32 pay_len, mss, queue;
 	dma_addr_t tso_des, des;
 	u8 proto_hdr_len, hdr;
-	bool set_ic;
+	bool doorbell, set_ic;
 	int i;
 
 	/* Always insert VLAN tag to SKB payload for TSO frames.
@@ -4267,6 +4436,9 @@ static netdev_tx_t stmmac_tso_xmit(struct sk_buff *skb, struct net_device *dev)
 				   "%s: Tx Ring full when queue awake\n",
 				   __func__);
 		}
+		/* Kick whatever an earlier xmit_more left pending */
+		stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
+		stmmac_flush_tx_descriptors(priv, queue);
 		return NETDEV_TX_BUSY;
 	}
 
@@ -4454,10 +4626,12 @@ static netdev_tx_t stmmac_tso_xmit(struct sk_buff *skb, struct net_device *dev)
 		print_pkt(skb->data, skb_headlen(skb));
 	}
 
-	netdev_tx_sent_queue(netdev_get_tx_queue(dev, queue), skb->len);
+	doorbell = __netdev_tx_sent_queue(netdev_get_tx_queue(dev, queue),
+					  skb->len, netdev_xmit_more());
 	skb_tx_timestamp(skb);
 
-	stmmac_flush_tx_descriptors(priv, queue);
+	if (doorbell)
+		stmmac_flush_tx_descriptors(priv, queue);
 	stmmac_tx_timer_arm(priv, queue);
 
 	return NETDEV_TX_OK;
@@ -4466,6 +4640,8 @@ static netdev_tx_t stmmac_tso_xmit(struct sk_buff *skb, struct net_device *dev)
 	dev_err(priv->device, "Tx dma map failed\n");
 	dev_kfree_skb(skb);
 	priv->xstats.tx_dropped++;
+	stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
+	stmmac_flush_tx_descriptors(priv, queue);
 	return NETDEV_TX_OK;
 }
 
@@ -4491,6 +4667,32 @@ static bool stmmac_has_ip_ethertype(struct sk_buff *skb)
 		(proto == htons(ETH_P_IP) || proto == htons(ETH_P_IPV6));
 }
 
+static netdev_features_t stmmac_features_check(struct sk_buff *skb,
+					       struct net_device *dev,
+					       netdev_features_t features)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	u16 queue = skb_get_queue_mapping(skb);
+
+	/* Stacked VLAN tags are never handled by the COE nor the TSO */
+	features = vlan_features_check(skb, features);
+
+	if (skb->ip_summed != CHECKSUM_PARTIAL)
+		return features;
+
+	/* Both the COE and the TSO engine rely on an IP header right after
+	 * the MAC header. Let the core checksum and segment anything else
+	 * before it gets here: skb_gso_segment() keeps the frags, whereas
+	 * a TSO frame the engine cannot parse would go out corrupted.
+	 */
+	if ((queue < priv->plat->tx_queues_to_use &&
+	     priv->plat->tx_queues_cfg[queue].coe_unsupported) ||
+	    !stmmac_has_ip_ethertype(skb))
+		features &= ~(NETIF_F_CSUM_MASK | NETIF_F_GSO_MASK);
+
+	return features;
+}
+
 /**
  *  stmmac_xmit - Tx entry point of the driver
  *  @skb : the socket buffer
@@ -4512,7 +4714,7 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 	struct dma_edesc *tbs_desc = NULL;
 	struct dma_desc *desc, *first;
 	struct stmmac_tx_queue *tx_q;
-	bool has_vlan, set_ic;
+	bool doorbell, has_vlan, set_ic;
 	int entry, first_tx;
 	dma_addr_t des;
 
@@ -4547,6 +4749,9 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 				   "%s: Tx Ring full when queue awake\n",
 				   __func__);
 		}
+		/* Kick whatever an earlier xmit_more left pending */
+		stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
+		stmmac_flush_tx_descriptors(priv, queue);
 		return NETDEV_TX_BUSY;
 	}
 
@@ -4742,11 +4947,15 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 
 	stmmac_set_tx_owner(priv, first);
 
-	netdev_tx_sent_queue(netdev_get_tx_queue(dev, queue), skb->len);
-
-	stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
+	doorbell = __netdev_tx_sent_queue(netdev_get_tx_queue(dev, queue),
+					  skb->len, netdev_xmit_more());
 	skb_tx_timestamp(skb);
-	stmmac_flush_tx_descriptors(priv, queue);
+
+	/* Only kick the DMA for the last frame of a bulk from the qdisc */
+	if (doorbell) {
+		stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
+		stmmac_flush_tx_descriptors(priv, queue);
+	}
 	stmmac_tx_timer_arm(priv, queue);
 
 	return NETDEV_TX_OK;
@@ -4756,6 +4965,8 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 max_sdu_err:
 	dev_kfree_skb(skb);
 	priv->xstats.tx_dropped++;
+	stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
+	stmmac_flush_tx_descriptors(priv, queue);
 	return NETDEV_TX_OK;
 }
 
@@ -4794,6 +5005,8 @@ static inline void stmmac_rx_refill(struct stmmac_priv *priv, u32 queue)
 	if (priv->dma_cap.host_dma_width <= 32)
 		gfp |= GFP_DMA32;
 
+	stmmac_hist_add(&priv->channel[queue], STMMAC_HIST_RX_REFILL, dirty);
+
 	while (dirty-- > 0) {
 		struct stmmac_rx_buffer *buf = &rx_q->buf_pool[entry];
 		struct dma_desc *p;
@@ -4872,6 +5085,10 @@ static unsigned int stmmac_rx_buf1_len(struct stmmac_priv *priv,
 
 	plen = stmmac_get_rx_frame_len(priv, p, coe);
 
+	/* Last descriptor of a multi-buffer frame and not split header */
+	if (len)
+		return plen - len;
+
 	/* First descriptor and last descriptor and not split header */
 	return min_t(unsigned int, priv->dma_conf.dma_buf_sz, plen);
 }
@@ -4900,61 +5117,93 @@ static unsigned int stmmac_rx_buf2_len(struct stmmac_priv *priv,
 static int stmmac_xdp_xmit_xdpf(struct stmmac_priv *priv, int queue,
 				struct xdp_frame *xdpf, bool dma_map)
 {
+	struct skb_shared_info *sinfo = xdp_get_shared_info_from_frame(xdpf);
 	struct stmmac_txq_stats *txq_stats = &priv->xstats.txq_stats[queue];
 	struct stmmac_tx_queue *tx_q = &priv->dma_conf.tx_queue[queue];
+	unsigned int frame_len = xdp_get_frame_len(xdpf);
 	unsigned int entry = tx_q->cur_tx;
-	struct dma_desc *tx_desc;
+	struct dma_desc *tx_desc, *first = NULL;
+	unsigned int nr_frags = 0;
 	dma_addr_t dma_addr;
+	unsigned int i;
 	bool set_ic;
 
-	if (stmmac_tx_avail(priv, queue) < STMMAC_TX_THRESH(priv))
+	if (unlikely(xdp_frame_has_frags(xdpf)))
+		nr_frags = sinfo->nr_frags;
+
+	if (stmmac_tx_avail(priv, queue) < STMMAC_TX_THRESH(priv) + nr_frags)
 		return STMMAC_XDP_CONSUMED;
 
 	if (priv->est && priv->est->enable &&
 	    priv->est->max_sdu[queue] &&
-	    xdpf->len > priv->est->max_sdu[queue]) {
+	    frame_len > priv->est->max_sdu[queue]) {
 		priv->xstats.max_sdu_txq_drop[queue]++;
 		return STMMAC_XDP_CONSUMED;
 	}
 
-	if (likely(priv->extend_desc))
-		tx_desc = (struct dma_desc *)(tx_q->dma_etx + entry);
-	else if (tx_q->tbs & STMMAC_TBS_AVAIL)
-		tx_desc = &tx_q->dma_entx[entry].basic;
-	else
-		tx_desc = tx_q->dma_tx + entry;
+	for (i = 0; i <= nr_frags; i++) {
+		skb_frag_t *frag = i ? &sinfo->frags[i - 1] : NULL;
+		unsigned int len = frag ? skb_frag_size(frag) : xdpf->len;
+		bool last_segment = i == nr_frags;
+
+		if (likely(priv->extend_desc))
+			tx_desc = (struct dma_desc *)(tx_q->dma_etx + entry);
+		else if (tx_q->tbs & STMMAC_TBS_AVAIL)
+			tx_desc = &tx_q->dma_entx[entry].basic;
+		else
+			tx_desc = tx_q->dma_tx + entry;
 
-	if (dma_map) {
-		dma_addr = dma_map_single(priv->device, xdpf->data,
-					  xdpf->len, DMA_TO_DEVICE);
-		if (dma_mapping_error(priv->device, dma_addr))
-			return STMMAC_XDP_CONSUMED;
+		if (dma_map) {
+			if (frag)
+				dma_addr = skb_frag_dma_map(priv->device, frag,
+							    0, len,
+							    DMA_TO_DEVICE);
+			else
+				dma_addr = dma_map_single(priv->device,
+							  xdpf->data, len,
+							  DMA_TO_DEVICE);
+			if (dma_mapping_error(priv->device, dma_addr))
+				goto dma_map_err;
 
-		tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_XDP_NDO;
-	} else {
-		struct page *page = virt_to_page(xdpf->data);
+			tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_XDP_NDO;
+		} else {
+			struct page *page;
+
+			if (frag) {
+				page = skb_frag_page(frag);
+				dma_addr = page_pool_get_dma_addr(page) +
+					   skb_frag_off(frag);
+			} else {
+				page = virt_to_page(xdpf->data);
+				dma_addr = page_pool_get_dma_addr(page) +
+					   sizeof(*xdpf) + xdpf->headroom;
+			}
+			dma_sync_single_for_device(priv->device, dma_addr,
+						   len, DMA_BIDIRECTIONAL);
 
-		dma_addr = page_pool_get_dma_addr(page) + sizeof(*xdpf) +
-			   xdpf->headroom;
-		dma_sync_single_for_device(priv->device, dma_addr,
-					   xdpf->len, DMA_BIDIRECTIONAL);
+			tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_XDP_TX;
+		}
 
-		tx_q->tx_skbuff_dma[entry].buf_type = STMMAC_TXBUF_T_XDP_TX;
-	}
+		tx_q->tx_skbuff_dma[entry].buf = dma_addr;
+		tx_q->tx_skbuff_dma[entry].map_as_page = dma_map && frag;
+		tx_q->tx_skbuff_dma[entry].len = len;
+		tx_q->tx_skbuff_dma[entry].last_segment = last_segment;
+		tx_q->tx_skbuff_dma[entry].is_jumbo = false;
 
-	tx_q->tx_skbuff_dma[entry].buf = dma_addr;
-	tx_q->tx_skbuff_dma[entry].map_as_page = false;
-	tx_q->tx_skbuff_dma[entry].len = xdpf->len;
-	tx_q->tx_skbuff_dma[entry].last_segment = true;
-	tx_q->tx_skbuff_dma[entry].is_jumbo = false;
+		/* The frame is returned once its last descriptor is done */
+		tx_q->xdpf[entry] = last_segment ? xdpf : NULL;
 
-	tx_q->xdpf[entry] = xdpf;
+		stmmac_set_desc_addr(priv, tx_desc, dma_addr);
 
-	stmmac_set_desc_addr(priv, tx_desc, dma_addr);
+		/* The OWN bit of the first descriptor is set last */
+		stmmac_prepare_tx_desc(priv, tx_desc, !i, len,
+				       true, priv->mode, !!i, last_segment,
+				       frame_len);
+		if (!i)
+			first = tx_desc;
 
-	stmmac_prepare_tx_desc(priv, tx_desc, 1, xdpf->len,
-			       true, priv->mode, true, true,
-			       xdpf->len);
+		entry = STMMAC_GET_ENTRY(entry, priv->dma_conf.dma_tx_size);
+	}
 
 	tx_q->tx_count_frames++;
 
@@ -4971,12 +5220,42 @@ static int stmmac_xdp_xmit_xdpf(struct stmmac_priv *priv, int queue,
 		u64_stats_update_end(&txq_stats->q_syncp);
 	}
 
-	stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
+	dma_wmb();
+	stmmac_set_tx_owner(priv, first);
 
-	entry = STMMAC_GET_ENTRY(entry, priv->dma_conf.dma_tx_size);
 	tx_q->cur_tx = entry;
 
 	return STMMAC_XDP_TX;
+
+dma_map_err:
+	/* Only the NDO path maps buffers, undo what was done so far */
+	for (entry = tx_q->cur_tx; i > 0; i--) {
+		struct stmmac_tx_info *tx_info = &tx_q->tx_skbuff_dma[entry];
+
+		if (likely(priv->extend_desc))
+			tx_desc = (struct dma_desc *)(tx_q->dma_etx + entry);
+		else if (tx_q->tbs & STMMAC_TBS_AVAIL)
+			tx_desc = &tx_q->dma_entx[entry].basic;
+		else
+			tx_desc = tx_q->dma_tx + entry;
+
+		if (tx_info->map_as_page)
+			dma_unmap_page(priv->device, tx_info->buf,
+				       tx_info->len, DMA_TO_DEVICE);
+		else
+			dma_unmap_single(priv->device, tx_info->buf,
+					 tx_info->len, DMA_TO_DEVICE);
+		tx_info->buf = 0;
+		tx_info->len = 0;
+		tx_info->map_as_page = false;
+		tx_info->last_segment = false;
+		tx_q->xdpf[entry] = NULL;
+		stmmac_release_tx_desc(priv, tx_desc, priv->mode);
+
+		entry = STMMAC_GET_ENTRY(entry, priv->dma_conf.dma_tx_size);
+	}
+
+	return STMMAC_XDP_CONSUMED;
 }
 
 static int stmmac_xdp_get_tx_queue(struct stmmac_priv *priv,
@@ -5012,9 +5291,8 @@ static int stmmac_xdp_xmit_back(struct stmmac_priv *priv,
 	/* Avoids TX time-out as we are sharing with slow path */
 	txq_trans_cond_update(nq);
 
+	/* The tail pointer is moved once per poll by stmmac_finalize_xdp_rx() */
 	res = stmmac_xdp_xmit_xdpf(priv, queue, xdpf, false);
-	if (res == STMMAC_XDP_TX)
-		stmmac_flush_tx_descriptors(priv, queue);
 
 	__netif_tx_unlock(nq);
 
@@ -5081,8 +5359,16 @@ static void stmmac_finalize_xdp_rx(struct stmmac_priv *priv,
 
 	queue = stmmac_xdp_get_tx_queue(priv, cpu);
 
-	if (xdp_status & STMMAC_XDP_TX)
+	if (xdp_status & STMMAC_XDP_TX) {
+		struct netdev_queue *nq = netdev_get_tx_queue(priv->dev, queue);
+
+		__netif_tx_lock(nq, cpu);
+		stmmac_flush_tx_descriptors(priv, queue);
+		stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
+		__netif_tx_unlock(nq);
+
 		stmmac_tx_timer_arm(priv, queue);
+	}
 
 	if (xdp_status & STMMAC_XDP_REDIRECT)
 		xdp_do_flush();
@@ -5404,6 +5690,72 @@ static int stmmac_rx_zc(struct stmmac_priv *priv, int limit, u32 queue)
 	return failure ? limit : (int)count;
 }
 
+static int stmmac_xdp_add_frag(struct xdp_buff *xdp, struct page *page,
+			       unsigned int offset, unsigned int len)
+{
+	struct skb_shared_info *sinfo = xdp_get_shared_info_from_buff(xdp);
+
+	if (!xdp_buff_has_frags(xdp)) {
+		sinfo->nr_frags = 0;
+		sinfo->xdp_frags_size = 0;
+		xdp_buff_set_frags_flag(xdp);
+	}
+
+	if (unlikely(sinfo->nr_frags == MAX_SKB_FRAGS))
+		return -ENOSPC;
+
+	skb_frag_fill_page_desc(&sinfo->frags[sinfo->nr_frags++], page,
+				offset, len);
+	sinfo->xdp_frags_size += len;
+	if (page_is_pfmemalloc(page))
+		xdp_buff_set_frag_pfmemalloc(xdp);
+
+	return 0;
+}
+
+/* Build an skb around the page pool page(s) backing an xdp_buff */
+static struct sk_buff *stmmac_build_skb(struct xdp_buff *xdp)
+{
+	struct skb_shared_info *sinfo = xdp_get_shared_info_from_buff(xdp);
+	unsigned int metasize = xdp->data - xdp->data_meta;
+	unsigned int nr_frags = 0;
+	struct sk_buff *skb;
+
+	/* build_skb() clears nr_frags in the shared info */
+	if (unlikely(xdp_buff_has_frags(xdp)))
+		nr_frags = sinfo->nr_frags;
+
+	skb = napi_build_skb(xdp->data_hard_start, xdp->frame_sz);
+	if (unlikely(!skb))
+		return NULL;
+
+	skb_reserve(skb, xdp->data - xdp->data_hard_start);
+	skb_put(skb, xdp->data_end - xdp->data);
+	if (metasize)
+		skb_metadata_set(skb, metasize);
+
+	if (unlikely(nr_frags))
+		xdp_update_skb_shared_info(skb, nr_frags,
+					   sinfo->xdp_frags_size,
+					   nr_frags * xdp->frame_sz,
+					   xdp_buff_is_frag_pfmemalloc(xdp));
+
+	skb_mark_for_recycle(skb);
+
+	return skb;
+}
+
+/* A RX buffer can be turned into the skb head directly when the DMA
+ * engine cannot write into the area needed for the skb_shared_info.
+ */
+static bool stmmac_rx_can_build_skb(struct stmmac_priv *priv,
+				    struct stmmac_rx_buffer *buf,
+				    unsigned int buf_sz)
+{
+	return buf->page_offset + priv->dma_conf.dma_buf_sz +
+	       SKB_DATA_ALIGN(sizeof(struct skb_shared_info)) <= buf_sz;
+}
+
 /**
  * stmmac_rx - manage the receive process
  * @priv: driver private structure
@@ -5426,6 +5778,7 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 	struct sk_buff *skb = NULL;
 	struct stmmac_xdp_buff ctx;
 	int xdp_status = 0;
+	bool xdp_mb = false;
 	int buf_sz;
 
 	dma_dir = page_pool_get_dma_dir(rx_q->page_pool);
@@ -5448,7 +5801,7 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 				    rx_q->dma_rx_phy, desc_size);
 	}
 	while (count < limit) {
-		unsigned int buf1_len = 0, buf2_len = 0;
+		unsigned int buf1_len = 0, buf2_len = 0, sync_len = 0;
 		enum pkt_hash_types hash_type;
 		struct stmmac_rx_buffer *buf;
 		struct dma_desc *np, *p;
@@ -5459,11 +5812,15 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 			skb = rx_q->state.skb;
 			error = rx_q->state.error;
 			len = rx_q->state.len;
+			xdp_mb = rx_q->state.xdp_mb;
+			if (xdp_mb)
+				ctx.xdp = rx_q->state.xdp;
 		} else {
 			rx_q->state_saved = false;
 			skb = NULL;
 			error = 0;
 			len = 0;
+			xdp_mb = false;
 		}
 
 read_again:
@@ -5500,7 +5857,8 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 		if (priv->extend_desc)
 			stmmac_rx_extended_status(priv, &priv->xstats, rx_q->dma_erx + entry);
 		if (unlikely(status == discard_frame)) {
-			page_pool_recycle_direct(rx_q->page_pool, buf->page);
+			/* Not touched by the CPU, nothing to sync back */
+			page_pool_put_page(rx_q->page_pool, buf->page, 0, true);
 			buf->page = NULL;
 			error = 1;
 			if (!priv->hwts_rx_en)
@@ -5512,6 +5870,10 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 		if (unlikely(error)) {
 			dev_kfree_skb(skb);
 			skb = NULL;
+			if (xdp_mb) {
+				xdp_return_buff(&ctx.xdp);
+				xdp_mb = false;
+			}
 			count++;
 			continue;
 		}
@@ -5538,8 +5900,76 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 			}
 		}
 
+		/* With XDP, frames spanning several buffers are gathered in
+		 * a multi-buffer xdp_buff and the program runs on the last one.
+		 */
+		if (!skb && stmmac_xdp_is_enabled(priv) &&
+		    (xdp_mb || (status & rx_not_ls))) {
+			dma_sync_single_for_cpu(priv->device, buf->addr,
+						buf1_len, dma_dir);
+
+			if (!xdp_mb) {
+				xdp_init_buff(&ctx.xdp, buf_sz, &rx_q->xdp_rxq);
+				xdp_prepare_buff(&ctx.xdp, page_address(buf->page),
+						 buf->page_offset, buf1_len, true);
+				xdp_mb = true;
+			} else if (!buf1_len ||
+				   stmmac_xdp_add_frag(&ctx.xdp, buf->page,
+						       buf->page_offset,
+						       buf1_len)) {
+				page_pool_recycle_direct(rx_q->page_pool,
+							 buf->page);
+				/* Out of frags: drop the rest of the frame */
+				error = !!buf1_len;
+			}
+			buf->page = NULL;
+
+			if (unlikely(error)) {
+				xdp_return_buff(&ctx.xdp);
+				xdp_mb = false;
+				rx_dropped++;
+				if (status & rx_not_ls)
+					goto read_again;
+				count++;
+				continue;
+			}
+
+			if (status & rx_not_ls)
+				goto read_again;
+
+			ctx.priv = priv;
+			ctx.desc = p;
+			ctx.ndesc = np;
+
+			xdp_mb = false;
+			skb = stmmac_xdp_run_prog(priv, &ctx.xdp);
+			if (IS_ERR(skb)) {
+				unsigned int xdp_res = -PTR_ERR(skb);
+
+				if (xdp_res & STMMAC_XDP_CONSUMED) {
+					xdp_return_buff(&ctx.xdp);
+					rx_dropped++;
+				} else {
+					xdp_status |= xdp_res;
+				}
+				skb = NULL;
+				count++;
+				continue;
+			}
+
+			skb = stmmac_build_skb(&ctx.xdp);
+			if (!skb) {
+				xdp_return_buff(&ctx.xdp);
+				rx_dropped++;
+				count++;
+				continue;
+			}
+
+			goto drain_data;
+		}
+
 		if (!skb) {
-			unsigned int pre_len, sync_len;
+			unsigned int pre_len;
 
 			dma_sync_single_for_cpu(priv->device, buf->addr,
 						buf1_len, dma_dir);
@@ -5599,19 +6029,37 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 			/* XDP program may expand or reduce tail */
 			buf1_len = ctx.xdp.data_end - ctx.xdp.data;
 
-			skb = napi_alloc_skb(&ch->rx_napi, buf1_len);
-			if (!skb) {
-				rx_dropped++;
-				count++;
-				goto drain_data;
-			}
-
-			/* XDP program may adjust header */
-			skb_copy_to_linear_data(skb, ctx.xdp.data, buf1_len);
-			skb_put(skb, buf1_len);
+			if (buf1_len > priv->rx_copybreak &&
+			    stmmac_rx_can_build_skb(priv, buf, buf_sz)) {
+				/* Hand the page itself upwards, it goes back
+				 * to the page pool when the skb is freed.
+				 */
+				skb = stmmac_build_skb(&ctx.xdp);
+				if (!skb) {
+					rx_dropped++;
+					count++;
+					goto drain_data;
+				}
+			} else {
+				skb = napi_alloc_skb(&ch->rx_napi, buf1_len);
+				if (!skb) {
+					rx_dropped++;
+					count++;
+					goto drain_data;
+				}
 
-			/* Data payload copied into SKB, page ready for recycle */
-			page_pool_recycle_direct(rx_q->page_pool, buf->page);
+				/* XDP program may adjust header */
+				skb_copy_to_linear_data(skb, ctx.xdp.data,
+							buf1_len);
+				skb_put(skb, buf1_len);
+
+				/* Data payload copied into SKB, page ready
+				 * for recycle. Only what the CPU may have
+				 * dirtied needs syncing for the device.
+				 */
+				page_pool_put_page(rx_q->page_pool, buf->page,
+						   sync_len, true);
+			}
 			buf->page = NULL;
 		} else if (buf1_len) {
 			dma_sync_single_for_cpu(priv->device, buf->addr,
@@ -5673,11 +6121,14 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 		count++;
 	}
 
-	if (status & rx_not_ls || skb) {
+	if (status & rx_not_ls || skb || xdp_mb) {
 		rx_q->state_saved = true;
 		rx_q->state.skb = skb;
 		rx_q->state.error = error;
 		rx_q->state.len = len;
+		rx_q->state.xdp_mb = xdp_mb;
+		if (xdp_mb)
+			rx_q->state.xdp = ctx.xdp;
 	}
 
 	stmmac_finalize_xdp_rx(priv, xdp_status);
@@ -5696,6 +6147,85 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 	return count;
 }
 
+static void stmmac_rx_dim_update(struct stmmac_priv *priv,
+				 struct stmmac_channel *ch)
+{
+	struct stmmac_rxq_stats *rxq_stats = &priv->xstats.rxq_stats[ch->index];
+	struct dim_sample sample = {};
+
+	if (!priv->rx_dim_enabled)
+		return;
+
+	/* rx stats are only written from this NAPI context */
+	dim_update_sample(++ch->rx_dim_events,
+			  u64_stats_read(&rxq_stats->napi.rx_packets),
+			  u64_stats_read(&rxq_stats->napi.rx_bytes),
+			  &sample);
+	net_dim(&ch->rx_dim, sample);
+}
+
+static void stmmac_tx_dim_update(struct stmmac_priv *priv,
+				 struct stmmac_channel *ch)
+{
+	struct stmmac_txq_stats *txq_stats = &priv->xstats.txq_stats[ch->index];
+	struct dim_sample sample = {};
+	unsigned int start;
+	u64 bytes;
+
+	if (!priv->tx_dim_enabled)
+		return;
+
+	do {
+		start = u64_stats_fetch_begin(&txq_stats->q_syncp);
+		bytes = u64_stats_read(&txq_stats->q.tx_bytes);
+	} while (u64_stats_fetch_retry(&txq_stats->q_syncp, start));
+
+	dim_update_sample(++ch->tx_dim_events,
+			  u64_stats_read(&txq_stats->napi.tx_packets),
+			  bytes, &sample);
+	net_dim(&ch->tx_dim, sample);
+}
+
+static void stmmac_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_channel *ch =
+		container_of(dim, struct stmmac_channel, rx_dim);
+	struct stmmac_priv *priv = ch->priv_data;
+	struct dim_cq_moder moder;
+	u32 queue = ch->index;
+	u32 riwt;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+	riwt = clamp_t(u32, stmmac_usec2riwt(moder.usec, priv),
+		       MIN_DMA_RIWT, MAX_DMA_RIWT);
+
+	priv->rx_riwt[queue] = riwt;
+	priv->rx_coal_frames[queue] = moder.pkts;
+	stmmac_rx_watchdog(priv, priv->ioaddr, riwt, queue);
+
+	dim->state = DIM_START_MEASURE;
+}
+
+static void stmmac_tx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_channel *ch =
+		container_of(dim, struct stmmac_channel, tx_dim);
+	struct stmmac_priv *priv = ch->priv_data;
+	struct dim_cq_moder moder;
+	u32 queue = ch->index;
+
+	moder = net_dim_get_tx_moderation(dim->mode, dim->profile_ix);
+
+	priv->tx_coal_timer[queue] = clamp_t(u32, moder.usec, 1,
+					     STMMAC_MAX_COAL_TX_TICK);
+	priv->tx_coal_frames[queue] = clamp_t(u32, moder.pkts, 1,
+					      STMMAC_TX_MAX_FRAMES);
+
+	dim->state = DIM_START_MEASURE;
+}
+
 static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 {
 	struct stmmac_channel *ch =
@@ -5704,6 +6234,9 @@ static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 	struct stmmac_rxq_stats *rxq_stats;
 	u32 chan = ch->index;
 	int work_done;
+	u64 start;
+
+	start = stmmac_hist_poll_begin(ch, false);
 
 	rxq_stats = &priv->xstats.rxq_stats[chan];
 	u64_stats_update_begin(&rxq_stats->napi_syncp);
@@ -5711,14 +6244,19 @@ static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 	u64_stats_update_end(&rxq_stats->napi_syncp);
 
 	work_done = stmmac_rx(priv, budget, chan);
+	stmmac_hist_add(ch, STMMAC_HIST_RX_WORK, work_done);
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		stmmac_rx_dim_update(priv, ch);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
 		spin_unlock_irqrestore(&ch->lock, flags);
 	}
 
+	stmmac_hist_poll_end(ch, start, false);
+
 	return work_done;
 }
 
@@ -5731,6 +6269,9 @@ static int stmmac_napi_poll_tx(struct napi_struct *napi, int budget)
 	bool pending_packets = false;
 	u32 chan = ch->index;
 	int work_done;
+	u64 start;
+
+	start = stmmac_hist_poll_begin(ch, true);
 
 	txq_stats = &priv->xstats.txq_stats[chan];
 	u64_stats_update_begin(&txq_stats->napi_syncp);
@@ -5739,10 +6280,13 @@ static int stmmac_napi_poll_tx(struct napi_struct *napi, int budget)
 
 	work_done = stmmac_tx_clean(priv, budget, chan, &pending_packets);
 	work_done = min(work_done, budget);
+	stmmac_hist_add(ch, STMMAC_HIST_TX_WORK, work_done);
 
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		stmmac_tx_dim_update(priv, ch);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 0, 1);
 		spin_unlock_irqrestore(&ch->lock, flags);
@@ -5752,6 +6296,8 @@ static int stmmac_napi_poll_tx(struct napi_struct *napi, int budget)
 	if (pending_packets)
 		stmmac_tx_timer_arm(priv, chan);
 
+	stmmac_hist_poll_end(ch, start, true);
+
 	return work_done;
 }
 
@@ -5864,8 +6410,9 @@ static int stmmac_change_mtu(struct net_device *dev, int new_mtu)
 
 	txfifosz /= priv->plat->tx_queues_to_use;
 
-	if (stmmac_xdp_is_enabled(priv) && new_mtu > ETH_DATA_LEN) {
-		netdev_dbg(priv->dev, "Jumbo frames not supported for XDP\n");
+	if (stmmac_xdp_is_enabled(priv) && new_mtu > ETH_DATA_LEN &&
+	    !priv->xdp_prog->aux->xdp_has_frags) {
+		netdev_dbg(priv->dev, "Jumbo frames need a multi-buffer XDP program\n");
 		return -EINVAL;
 	}
 
@@ -5936,6 +6483,215 @@ static netdev_features_t stmmac_fix_features(struct net_device *dev,
 	return features;
 }
 
+/**
+ * stmmac_config_flow_steer - program an L3/L4 filter to steer a flow
+ * @priv: driver private structure
+ * @entry: flow entry holding the match and the target RX queue
+ * @en: program (true) or clear (false) the filter
+ * Description: addresses and ports set to zero are not matched on. The L4
+ * filter only holds a single port, the source one is used when both are set.
+ */
+int stmmac_config_flow_steer(struct stmmac_priv *priv,
+			     struct stmmac_flow_entry *entry, bool en)
+{
+	bool udp = entry->ip_proto == IPPROTO_UDP;
+	int ret;
+
+	if (!en) {
+		ret = stmmac_config_l3_filter(priv, priv->hw, entry->idx, false,
+					      false, false, false, 0);
+		stmmac_update_l3l4_filter_drop(priv);
+		return ret;
+	}
+
+	if (entry->src) {
+		ret = stmmac_config_l3_filter(priv, priv->hw, entry->idx, true,
+					      false, true, false,
+					      ntohl(entry->src));
+		if (ret)
+			goto err_disable;
+	}
+
+	if (entry->dst) {
+		ret = stmmac_config_l3_filter(priv, priv->hw, entry->idx, true,
+					      false, false, false,
+					      ntohl(entry->dst));
+		if (ret)
+			goto err_disable;
+	}
+
+	if (entry->sport || entry->dport) {
+		bool sa = !!entry->sport;
+
+		ret = stmmac_config_l4_filter(priv, priv->hw, entry->idx, true,
+					      udp, sa, false,
+					      ntohs(sa ? entry->sport :
+							 entry->dport));
+		if (ret)
+			goto err_disable;
+	}
+
+	ret = stmmac_config_l3l4_dma_chan(priv, priv->hw, entry->idx, true,
+					  entry->queue);
+	if (ret)
+		goto err_disable;
+
+	stmmac_update_l3l4_filter_drop(priv);
+	return 0;
+
+err_disable:
+	stmmac_config_l3_filter(priv, priv->hw, entry->idx, false, false, false,
+				false, 0);
+	stmmac_update_l3l4_filter_drop(priv);
+	return ret;
+}
+
+/**
+ * stmmac_update_l3l4_filter_drop - drop IP packets no L3/L4 filter matches
+ * @priv: driver private structure
+ * Description: with IPFE set, the MAC drops the IP packets that match none
+ * of the enabled L3/L4 filters. tc flower relies on that, but a steering
+ * filter must let all other traffic through, and it routes the packets it
+ * matches to its DMA channel whether IPFE is set or not. So only keep IPFE
+ * while tc flower holds a filter slot. Programming a filter sets IPFE, so
+ * this is called after every change to the filters.
+ */
+void stmmac_update_l3l4_filter_drop(struct stmmac_priv *priv)
+{
+	bool drop = false;
+	int i;
+
+	spin_lock_bh(&priv->flow_lock);
+
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		struct stmmac_flow_entry *entry = &priv->flow_entries[i];
+
+		if (entry->in_use && entry->cookie) {
+			drop = true;
+			break;
+		}
+	}
+
+	stmmac_set_l3l4_filter_drop(priv, priv->hw, drop);
+
+	spin_unlock_bh(&priv->flow_lock);
+}
+
+#ifdef CONFIG_RFS_ACCEL
+static int stmmac_rx_flow_steer(struct net_device *dev,
+				const struct sk_buff *skb, u16 rxq_index,
+				u32 flow_id)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	struct stmmac_flow_entry *entry, *free = NULL;
+	struct flow_keys fk;
+	int i, ret;
+
+	if (!skb_flow_dissect_flow_keys(skb, &fk, 0))
+		return -EPROTONOSUPPORT;
+	if (fk.basic.n_proto != htons(ETH_P_IP) ||
+	    (fk.basic.ip_proto != IPPROTO_TCP &&
+	     fk.basic.ip_proto != IPPROTO_UDP) ||
+	    (fk.control.flags & FLOW_DIS_IS_FRAGMENT))
+		return -EPROTONOSUPPORT;
+
+	spin_lock_bh(&priv->flow_lock);
+
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		entry = &priv->flow_entries[i];
+
+		if (!entry->in_use) {
+			if (!free)
+				free = entry;
+			continue;
+		}
+
+		/* The remote port tells apart connections to the same
+		 * local service, and it is the only port the filter keeps.
+		 */
+		if (entry->is_arfs && entry->ip_proto == fk.basic.ip_proto &&
+		    entry->src == fk.addrs.v4addrs.src &&
+		    entry->dst == fk.addrs.v4addrs.dst &&
+		    entry->sport == fk.ports.src)
+			break;
+	}
+
+	if (i < priv->flow_entries_max) {
+		entry->flow_id = flow_id;
+		if (entry->queue != rxq_index) {
+			entry->queue = rxq_index;
+			entry->arfs_pending = true;
+		}
+		ret = entry->idx;
+	} else if (free) {
+		entry = free;
+		entry->in_use = true;
+		entry->is_arfs = true;
+		entry->arfs_pending = true;
+		entry->ip_proto = fk.basic.ip_proto;
+		entry->src = fk.addrs.v4addrs.src;
+		entry->dst = fk.addrs.v4addrs.dst;
+		entry->sport = fk.ports.src;
+		entry->dport = 0;
+		entry->queue = rxq_index;
+		entry->flow_id = flow_id;
+		ret = entry->idx;
+	} else {
+		/* Let the work expire old flows to make room */
+		ret = -ENOSPC;
+	}
+
+	spin_unlock_bh(&priv->flow_lock);
+
+	queue_work(priv->wq, &priv->arfs_work);
+
+	return ret;
+}
+
+static void stmmac_arfs_work(struct work_struct *work)
+{
+	struct stmmac_priv *priv = container_of(work, struct stmmac_priv,
+						arfs_work);
+	struct stmmac_flow_entry *entry, tmp;
+	bool expire, program;
+	int i;
+
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		entry = &priv->flow_entries[i];
+
+		spin_lock_bh(&priv->flow_lock);
+		if (!entry->in_use || !entry->is_arfs) {
+			spin_unlock_bh(&priv->flow_lock);
+			continue;
+		}
+
+		program = entry->arfs_pending;
+		expire = !program &&
+			 rps_may_expire_flow(priv->dev, entry->queue,
+					     entry->flow_id, entry->idx);
+		/* The slot stays reserved until the filter is cleared */
+		if (expire)
+			entry->is_arfs = false;
+		entry->arfs_pending = false;
+		tmp = *entry;
+		spin_unlock_bh(&priv->flow_lock);
+
+		if (program && !stmmac_config_flow_steer(priv, &tmp, true))
+			continue;
+		if (!program && !expire)
+			continue;
+
+		/* Expired, or could not be programmed */
+		stmmac_config_flow_steer(priv, &tmp, false);
+
+		spin_lock_bh(&priv->flow_lock);
+		entry->in_use = false;
+		entry->is_arfs = false;
+		spin_unlock_bh(&priv->flow_lock);
+	}
+}
+#endif /* CONFIG_RFS_ACCEL */
+
 static int stmmac_set_features(struct net_device *netdev,
 			       netdev_features_t features)
 {
@@ -5966,6 +6722,14 @@ static int stmmac_set_features(struct net_device *netdev,
 
 	stmmac_set_hw_vlan_mode(priv, priv->hw);
 
+	if ((netdev->hw_features & NETIF_F_NTUPLE) &&
+	    !(features & NETIF_F_NTUPLE))
+		stmmac_arfs_flush(priv);
+
+	if ((features ^ netdev->features) & NETIF_F_LOOPBACK)
+		stmmac_set_mac_loopback(priv, priv->ioaddr,
+					!!(features & NETIF_F_LOOPBACK));
+
 	return 0;
 }
 
@@ -6536,6 +7300,39 @@ static int stmmac_dma_cap_show(struct seq_file *seq, void *v)
 }
 DEFINE_SHOW_ATTRIBUTE(stmmac_dma_cap);
 
+#ifdef CONFIG_STMMAC_LATENCY_HIST
+static int stmmac_latency_hist_show(struct seq_file *seq, void *v)
+{
+	struct net_device *dev = seq->private;
+	struct stmmac_priv *priv = netdev_priv(dev);
+	u32 maxq = max(priv->plat->rx_queues_to_use,
+		       priv->plat->tx_queues_to_use);
+	u32 queue;
+	int t, b;
+
+	seq_printf(seq, "%-18s", "bucket");
+	for (b = 0; b < STMMAC_HIST_BUCKETS; b++)
+		seq_printf(seq, " %10lu", b ? BIT(b - 1) : 0);
+	seq_puts(seq, "\n");
+
+	for (queue = 0; queue < maxq; queue++) {
+		struct stmmac_channel *ch = &priv->channel[queue];
+
+		seq_printf(seq, "channel %u:\n", queue);
+		for (t = 0; t < STMMAC_HIST_MAX; t++) {
+			seq_printf(seq, "%-18s", stmmac_hist_names[t]);
+			for (b = 0; b < STMMAC_HIST_BUCKETS; b++)
+				seq_printf(seq, " %10llu",
+					   READ_ONCE(ch->hist[t][b]));
+			seq_puts(seq, "\n");
+		}
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stmmac_latency_hist);
+#endif
+
 /* Use network device events to rename debugfs file entries.
  */
 static int stmmac_device_event(struct notifier_block *unused,
@@ -6581,6 +7378,12 @@ static void stmmac_init_fs(struct net_device *dev)
 	debugfs_create_file("dma_cap", 0444, priv->dbgfs_dir, dev,
 			    &stmmac_dma_cap_fops);
 
+#ifdef CONFIG_STMMAC_LATENCY_HIST
+	/* Entry to report the per channel latency histograms */
+	debugfs_create_file("latency_hist", 0444, priv->dbgfs_dir, dev,
+			    &stmmac_latency_hist_fops);
+#endif
+
 	rtnl_unlock();
 }
 
@@ -6748,8 +7551,12 @@ static int stmmac_xdp_xmit(struct net_device *dev, int num_frames,
 		nxmit++;
 	}
 
+	/* A devmap bulk of up to DEV_MAP_BULK_SIZE frames, e.g. redirected
+	 * from the other GMAC, costs a single tail pointer update.
+	 */
 	if (flags & XDP_XMIT_FLUSH) {
 		stmmac_flush_tx_descriptors(priv, queue);
+		stmmac_enable_dma_transmission(priv, priv->ioaddr, queue);
 		stmmac_tx_timer_arm(priv, queue);
 	}
 
@@ -6920,6 +7727,9 @@ int stmmac_xdp_open(struct net_device *dev)
 	u32 chan;
 	int ret;
 
+	/* Attaching or removing a program changes the RX buffer layout */
+	priv->dma_conf.dma_buf_sz = stmmac_rx_buf_size(priv, dev->mtu);
+
 	ret = alloc_dma_desc_resources(priv, &priv->dma_conf);
 	if (ret < 0) {
 		netdev_err(dev, "%s: DMA descriptors allocation failed\n",
@@ -7108,6 +7918,7 @@ static void stmmac_get_stats64(struct net_device *dev, struct rtnl_link_stats64
 static const struct net_device_ops stmmac_netdev_ops = {
 	.ndo_open = stmmac_open,
 	.ndo_start_xmit = stmmac_xmit,
+	.ndo_features_check = stmmac_features_check,
 	.ndo_stop = stmmac_release,
 	.ndo_change_mtu = stmmac_change_mtu,
 	.ndo_fix_features = stmmac_fix_features,
@@ -7124,6 +7935,9 @@ static const struct net_device_ops stmmac_netdev_ops = {
 	.ndo_bpf = stmmac_bpf,
 	.ndo_xdp_xmit = stmmac_xdp_xmit,
 	.ndo_xsk_wakeup = stmmac_xsk_wakeup,
+#ifdef CONFIG_RFS_ACCEL
+	.ndo_rx_flow_steer = stmmac_rx_flow_steer,
+#endif
 };
 
 static void stmmac_reset_subtask(struct stmmac_priv *priv)
@@ -7307,10 +8121,14 @@ static void stmmac_napi_add(struct net_device *dev)
 
 		if (queue < priv->plat->rx_queues_to_use) {
 			netif_napi_add(dev, &ch->rx_napi, stmmac_napi_poll_rx);
+			INIT_WORK(&ch->rx_dim.work, stmmac_rx_dim_work);
+			ch->rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
 		}
 		if (queue < priv->plat->tx_queues_to_use) {
 			netif_napi_add_tx(dev, &ch->tx_napi,
 					  stmmac_napi_poll_tx);
+			INIT_WORK(&ch->tx_dim.work, stmmac_tx_dim_work);
+			ch->tx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
 		}
 		if (queue < priv->plat->rx_queues_to_use &&
 		    queue < priv->plat->tx_queues_to_use) {
@@ -7625,13 +8443,23 @@ int stmmac_dvr_probe(struct device *device,
 	ndev->hw_features = NETIF_F_SG | NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM |
 			    NETIF_F_RXCSUM;
 	ndev->xdp_features = NETDEV_XDP_ACT_BASIC | NETDEV_XDP_ACT_REDIRECT |
-			     NETDEV_XDP_ACT_XSK_ZEROCOPY;
+			     NETDEV_XDP_ACT_XSK_ZEROCOPY |
+			     NETDEV_XDP_ACT_RX_SG | NETDEV_XDP_ACT_NDO_XMIT_SG;
 
 	ret = stmmac_tc_init(priv, priv);
 	if (!ret) {
 		ndev->hw_features |= NETIF_F_HW_TC;
 	}
 
+	/* Flow steering needs the L3/L4 filters to select the DMA channel */
+	spin_lock_init(&priv->flow_lock);
+	if (priv->flow_entries_max && priv->hw->mac->config_l3l4_dma_chan) {
+		ndev->hw_features |= NETIF_F_NTUPLE;
+#ifdef CONFIG_RFS_ACCEL
+		INIT_WORK(&priv->arfs_work, stmmac_arfs_work);
+#endif
+	}
+
 	if ((priv->plat->flags & STMMAC_FLAG_TSO_EN) && (priv->dma_cap.tsoen)) {
 		ndev->hw_features |= NETIF_F_TSO | NETIF_F_TSO6;
 		if (priv->plat->has_gmac4)
@@ -7684,6 +8512,10 @@ int stmmac_dvr_probe(struct device *device,
 
 	ndev->features |= ndev->hw_features | NETIF_F_HIGHDMA;
 	ndev->watchdog_timeo = msecs_to_jiffies(watchdog);
+
+	/* MAC loopback can be toggled with ethtool, but is never on by default */
+	if (priv->hw->mac->set_mac_loopback)
+		ndev->hw_features |= NETIF_F_LOOPBACK;
 #ifdef STMMAC_VLAN_TAG_USED
 	/* Both mac100 and gmac support receive VLAN tag detection */
 	ndev->features |= NETIF_F_HW_VLAN_CTAG_RX | NETIF_F_HW_VLAN_STAG_RX;
@@ -8081,6 +8913,9 @@ static int __init stmmac_cmdline_opt(char *str)
 		} else if (!strncmp(opt, "chain_mode:", 11)) {
 			if (kstrtoint(opt + 11, 0, &chain_mode))
 				goto err;
+		} else if (!strncmp(opt, "pp_size:", 8)) {
+			if (kstrtoint(opt + 8, 0, &pp_size))
+				goto err;
 		}
 	}
 	return 1;
@@ -1590,6 +1590,60 @@ static int stmmac_test_l4filt_sa_udp(struct stmmac_priv *priv)
 	return __stmmac_test_l4filt(priv, 0, dummy_port, 0, ~0, true);
 }
 
+static int stmmac_test_flow_steer(struct stmmac_priv *priv)
+{
+	struct stmmac_packet_attrs attr = { };
+	struct ethtool_rxnfc rxnfc = { };
+	struct ethtool_rx_flow_spec *fs = &rxnfc.fs;
+	u32 addr = 0x10203040;
+	int ret, old_enable = 0;
+
+	if (!(priv->dev->hw_features & NETIF_F_NTUPLE))
+		return -EOPNOTSUPP;
+	if (priv->rss.enable) {
+		old_enable = priv->rss.enable;
+		priv->rss.enable = false;
+		stmmac_rss_configure(priv, priv->hw, NULL,
+				     priv->plat->rx_queues_to_use);
+	}
+
+	/* tc flower and aRFS take the first free slots, use the last one */
+	rxnfc.cmd = ETHTOOL_SRXCLSRLINS;
+	fs->flow_type = UDP_V4_FLOW;
+	fs->h_u.udp_ip4_spec.ip4dst = htonl(addr);
+	fs->m_u.udp_ip4_spec.ip4dst = htonl(~0);
+	fs->ring_cookie = 0;
+	fs->location = priv->flow_entries_max - 1;
+
+	ret = priv->dev->ethtool_ops->set_rxnfc(priv->dev, &rxnfc);
+	if (ret)
+		goto cleanup_rss;
+
+	attr.dst = priv->dev->dev_addr;
+
+	/* Shall receive the steered packet */
+	attr.ip_dst = addr;
+	ret = __stmmac_test_loopback(priv, &attr);
+	if (ret)
+		goto cleanup_rule;
+
+	/* Shall receive a packet no rule matches as well */
+	attr.ip_dst = addr + 1;
+	ret = __stmmac_test_loopback(priv, &attr);
+
+cleanup_rule:
+	rxnfc.cmd = ETHTOOL_SRXCLSRLDEL;
+	priv->dev->ethtool_ops->set_rxnfc(priv->dev, &rxnfc);
+cleanup_rss:
+	if (old_enable) {
+		priv->rss.enable = old_enable;
+		stmmac_rss_configure(priv, priv->hw, &priv->rss,
+				     priv->plat->rx_queues_to_use);
+	}
+
+	return ret;
+}
+
 static int stmmac_test_arp_validate(struct sk_buff *skb,
 				    struct net_device *ndev,
 				    struct packet_type *pt,
@@ -1815,6 +1869,142 @@ static int stmmac_test_tbs(struct stmmac_priv *priv)
 	return ret;
 }
 
+static u64 stmmac_test_get_systime(struct stmmac_priv *priv)
+{
+	unsigned long flags;
+	u64 systime = 0;
+
+	read_lock_irqsave(&priv->ptp_lock, flags);
+	stmmac_get_systime(priv, priv->ptpaddr, &systime);
+	read_unlock_irqrestore(&priv->ptp_lock, flags);
+
+	return systime;
+}
+
+#define STMMAC_EST_CLOSED_NS		(20 * NSEC_PER_MSEC)
+#define STMMAC_EST_OPEN_NS		(5 * NSEC_PER_MSEC)
+#define STMMAC_EST_TOLERANCE_NS		(2 * NSEC_PER_MSEC)
+#define STMMAC_EST_MAX_ENTRIES		32
+#define STMMAC_EST_SAMPLES		4
+
+static int stmmac_test_est(struct stmmac_priv *priv)
+{
+	u32 cycle = STMMAC_EST_CLOSED_NS + STMMAC_EST_OPEN_NS;
+	u32 queue = priv->plat->tx_queues_to_use - 1;
+	struct stmmac_packet_attrs attr = { };
+	struct tc_taprio_qopt_offload *qopt;
+	u32 interval, gates, phase, n, i;
+	s64 delay, worst = 0;
+	u64 start, now;
+	int ret;
+
+	/* Only the last TX queue is gated. With a single TX queue that would
+	 * be queue 0, which must stay open for all other traffic.
+	 */
+	if (!priv->dma_cap.estsel || !queue)
+		return -EOPNOTSUPP;
+
+	switch (priv->dma_cap.estwid) {
+	case 0x1:
+		interval = GENMASK(15, 0);
+		break;
+	case 0x2:
+		interval = GENMASK(19, 0);
+		break;
+	case 0x3:
+		interval = GENMASK(23, 0);
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	/* The closed window must be long enough to be told apart from the
+	 * loopback latency, build it out of several GCL entries if needed.
+	 */
+	n = DIV_ROUND_UP(STMMAC_EST_CLOSED_NS, interval);
+	if (n > STMMAC_EST_MAX_ENTRIES)
+		return -EOPNOTSUPP;
+
+	if (!stmmac_test_get_systime(priv))
+		return -EOPNOTSUPP;
+
+	qopt = kzalloc(struct_size(qopt, entries, n + 1), GFP_KERNEL);
+	if (!qopt)
+		return -ENOMEM;
+
+	/* The gate of the test queue is closed for the first part of every
+	 * cycle. The gates of all other queues are always open. A zero base
+	 * time aligns the cycles to multiples of the cycle time.
+	 */
+	gates = GENMASK(priv->plat->tx_queues_to_use - 1, 0);
+	for (i = 0; i < n; i++) {
+		qopt->entries[i].command = TC_TAPRIO_CMD_SET_GATES;
+		qopt->entries[i].gate_mask = gates & ~BIT(queue);
+		qopt->entries[i].interval = STMMAC_EST_CLOSED_NS / n;
+	}
+	qopt->entries[n - 1].interval += STMMAC_EST_CLOSED_NS % n;
+	qopt->entries[n].command = TC_TAPRIO_CMD_SET_GATES;
+	qopt->entries[n].gate_mask = gates;
+	qopt->entries[n].interval = STMMAC_EST_OPEN_NS;
+
+	qopt->cmd = TAPRIO_CMD_REPLACE;
+	qopt->base_time = 0;
+	qopt->cycle_time = cycle;
+	qopt->num_entries = n + 1;
+
+	ret = stmmac_tc_setup_taprio(priv, priv, qopt);
+	if (ret)
+		goto free;
+
+	/* Let the new list take over */
+	msleep(2 * cycle / NSEC_PER_MSEC);
+
+	attr.dst = priv->dev->dev_addr;
+	attr.queue_mapping = queue;
+	attr.timeout = nsecs_to_jiffies(2 * cycle);
+
+	for (i = 0; i < STMMAC_EST_SAMPLES; i++) {
+		/* Send from the first half of the closed window, so that the
+		 * frame has to wait for the gate to open.
+		 */
+		for (;;) {
+			start = stmmac_test_get_systime(priv);
+			now = start;
+			phase = do_div(now, cycle);
+			if (phase < STMMAC_EST_CLOSED_NS / 2)
+				break;
+
+			usleep_range((cycle - phase) / NSEC_PER_USEC,
+				     (cycle - phase) / NSEC_PER_USEC + 100);
+		}
+
+		ret = __stmmac_test_loopback(priv, &attr);
+		if (ret)
+			goto disable;
+
+		/* Error relative to the expected gate opening, being early
+		 * means the frame went through a closed gate.
+		 */
+		now = stmmac_test_get_systime(priv);
+		delay = (s64)(now - start) - (STMMAC_EST_CLOSED_NS - phase);
+		if (delay < 0 || delay > STMMAC_EST_TOLERANCE_NS) {
+			ret = -EINVAL;
+			goto disable;
+		}
+
+		worst = max(worst, delay);
+	}
+
+	netdev_dbg(priv->dev, "EST: worst gate opening error %lld ns\n", worst);
+
+disable:
+	qopt->cmd = TAPRIO_CMD_DESTROY;
+	stmmac_tc_setup_taprio(priv, priv, qopt);
+free:
+	kfree(qopt);
+	return ret;
+}
+
 #define STMMAC_LOOPBACK_NONE	0
 #define STMMAC_LOOPBACK_MAC	1
 #define STMMAC_LOOPBACK_PHY	2
@@ -1932,6 +2122,10 @@ static const struct stmmac_test {
 		.name = "L4 SA UDP Filtering        ",
 		.lb = STMMAC_LOOPBACK_PHY,
 		.fn = stmmac_test_l4filt_sa_udp,
+	}, {
+		.name = "L3/L4 Flow Steering        ",
+		.lb = STMMAC_LOOPBACK_PHY,
+		.fn = stmmac_test_flow_steer,
 	}, {
 		.name = "ARP Offload                ",
 		.lb = STMMAC_LOOPBACK_PHY,
@@ -1952,6 +2146,10 @@ static const struct stmmac_test {
 		.name = "TBS (ETF Scheduler)        ",
 		.lb = STMMAC_LOOPBACK_PHY,
 		.fn = stmmac_test_tbs,
+	}, {
+		.name = "EST (Gate Control List)    ",
+		.lb = STMMAC_LOOPBACK_PHY,
+		.fn = stmmac_test_est,
 	},
 };
 
@@ -2023,7 +2221,8 @@ void stmmac_selftest_run(struct net_device *dev,
 				break;
 			fallthrough;
 		case STMMAC_LOOPBACK_MAC:
-			stmmac_set_mac_loopback(priv, priv->ioaddr, false);
+			stmmac_set_mac_loopback(priv, priv->ioaddr,
+						!!(dev->features & NETIF_F_LOOPBACK));
 			break;
 		default:
 			break;
@@ -558,7 +558,7 @@ static struct stmmac_flow_entry *tc_find_flow(struct stmmac_priv *priv,
 	for (i = 0; i < priv->flow_entries_max; i++) {
 		struct stmmac_flow_entry *entry = &priv->flow_entries[i];
 
-		if (entry->cookie == cls->cookie)
+		if (entry->in_use && entry->cookie == cls->cookie)
 			return entry;
 		if (get_free && (entry->in_use == false))
 			return entry;
@@ -579,42 +579,67 @@ static struct {
 static int tc_add_flow(struct stmmac_priv *priv,
 		       struct flow_cls_offload *cls)
 {
-	struct stmmac_flow_entry *entry = tc_find_flow(priv, cls, false);
 	struct flow_rule *rule = flow_cls_offload_flow_rule(cls);
+	struct stmmac_flow_entry *entry;
+	bool was_in_use, programmed = false;
 	int i, ret;
 
+	/* Reserve the slot, so that aRFS and ethtool keep off it */
+	spin_lock_bh(&priv->flow_lock);
+	entry = tc_find_flow(priv, cls, false);
 	if (!entry) {
 		entry = tc_find_flow(priv, cls, true);
-		if (!entry)
+		if (!entry) {
+			spin_unlock_bh(&priv->flow_lock);
 			return -ENOENT;
+		}
 	}
+	was_in_use = entry->in_use;
+	entry->in_use = true;
+	spin_unlock_bh(&priv->flow_lock);
 
 	ret = tc_parse_flow_actions(priv, &rule->action, entry,
 				    cls->common.extack);
 	if (ret)
-		return ret;
+		goto err_release;
 
 	for (i = 0; i < ARRAY_SIZE(tc_flow_parsers); i++) {
 		ret = tc_flow_parsers[i].fn(priv, cls, entry);
 		if (!ret)
-			entry->in_use = true;
+			programmed = true;
 	}
 
-	if (!entry->in_use)
-		return -EINVAL;
+	if (!programmed && !was_in_use) {
+		ret = -EINVAL;
+		goto err_release;
+	}
 
 	entry->cookie = cls->cookie;
+	stmmac_update_l3l4_filter_drop(priv);
 	return 0;
+
+err_release:
+	if (!was_in_use) {
+		spin_lock_bh(&priv->flow_lock);
+		entry->in_use = false;
+		spin_unlock_bh(&priv->flow_lock);
+	}
+	return ret;
 }
 
 static int tc_del_flow(struct stmmac_priv *priv,
 		       struct flow_cls_offload *cls)
 {
-	struct stmmac_flow_entry *entry = tc_find_flow(priv, cls, false);
+	struct stmmac_flow_entry *entry;
 	int ret;
 
-	if (!entry || !entry->in_use)
+	spin_lock_bh(&priv->flow_lock);
+	entry = tc_find_flow(priv, cls, false);
+	if (!entry || !entry->in_use) {
+		spin_unlock_bh(&priv->flow_lock);
 		return -ENOENT;
+	}
+	spin_unlock_bh(&priv->flow_lock);
 
 	if (entry->is_l4) {
 		ret = stmmac_config_l4_filter(priv, priv->hw, entry->idx, false,
@@ -624,9 +649,14 @@ static int tc_del_flow(struct stmmac_priv *priv,
 					      false, false, false, 0);
 	}
 
+	/* The slot is still ours until in_use drops */
+	spin_lock_bh(&priv->flow_lock);
 	entry->in_use = false;
 	entry->cookie = 0;
 	entry->is_l4 = false;
+	spin_unlock_bh(&priv->flow_lock);
+
+	stmmac_update_l3l4_filter_drop(priv);
 	return ret;
 }
 
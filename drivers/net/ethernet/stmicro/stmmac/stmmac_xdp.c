@@ -109,11 +109,11 @@ int stmmac_xdp_set_prog(struct stmmac_priv *priv, struct bpf_prog *prog,
 
 	if_running = netif_running(dev);
 
-	if (prog && dev->mtu > ETH_DATA_LEN) {
-		/* For now, the driver doesn't support XDP functionality with
-		 * jumbo frames so we return error.
+	if (prog && dev->mtu > ETH_DATA_LEN && !prog->aux->xdp_has_frags) {
+		/* Jumbo frames span several RX buffers and can only be
+		 * handed to a program that understands frags.
 		 */
-		NL_SET_ERR_MSG_MOD(extack, "Jumbo frames not supported");
+		NL_SET_ERR_MSG_MOD(extack, "Jumbo frames need a multi-buffer XDP program");
 		return -EOPNOTSUPP;
 	}
 
@@ -66,7 +66,15 @@
 
 /* Interrupt enable Register */
 #define YTPHY_INTERRUPT_ENABLE_REG		0x12
+#define YTPHY_IER_LINK_FAILED			BIT(11)
+#define YTPHY_IER_LINK_SUCCESSED		BIT(10)
 #define YTPHY_IER_WOL				BIT(6)
+#define YTPHY_IER_SERDES_LINK_FAILED		BIT(3)
+#define YTPHY_IER_SERDES_LINK_SUCCESSED		BIT(2)
+#define YTPHY_IER_LINK_MASK	(YTPHY_IER_LINK_FAILED | \
+				 YTPHY_IER_LINK_SUCCESSED | \
+				 YTPHY_IER_SERDES_LINK_FAILED | \
+				 YTPHY_IER_SERDES_LINK_SUCCESSED)
 
 /* Interrupt Status Register */
 #define YTPHY_INTERRUPT_STATUS_REG		0x13
@@ -82,6 +90,10 @@
 #define YTPHY_ISR_SERDES_LINK_SUCCESSED		BIT(2)
 #define YTPHY_ISR_POLARITY_CHANGED		BIT(1)
 #define YTPHY_ISR_JABBER_HAPPENED		BIT(0)
+#define YTPHY_ISR_LINK_MASK	(YTPHY_ISR_LINK_FAILED | \
+				 YTPHY_ISR_LINK_SUCCESSED | \
+				 YTPHY_ISR_SERDES_LINK_FAILED | \
+				 YTPHY_ISR_SERDES_LINK_SUCCESSED)
 
 /* Speed Auto Downgrade Control Register */
 #define YTPHY_SPEED_AUTO_DOWNGRADE_CONTROL_REG	0x14
@@ -660,6 +672,113 @@ static int yt8531_set_wol(struct phy_device *phydev,
 	return 0;
 }
 
+/**
+ * ytphy_config_intr() - enable or disable the link change interrupts
+ * @phydev: a pointer to a &struct phy_device
+ *
+ * NOTE: The WOL interrupt enable bit is owned by set_wol and left untouched,
+ * so a magic packet keeps asserting the interrupt pin either way.
+ *
+ * returns 0 or negative errno code
+ */
+static int ytphy_config_intr(struct phy_device *phydev)
+{
+	int ret;
+
+	if (phydev->interrupts == PHY_INTERRUPT_ENABLED) {
+		/* Reading the status register clears it */
+		ret = phy_read(phydev, YTPHY_INTERRUPT_STATUS_REG);
+		if (ret < 0)
+			return ret;
+
+		return phy_modify(phydev, YTPHY_INTERRUPT_ENABLE_REG,
+				  YTPHY_IER_LINK_MASK, YTPHY_IER_LINK_MASK);
+	}
+
+	ret = phy_modify(phydev, YTPHY_INTERRUPT_ENABLE_REG,
+			 YTPHY_IER_LINK_MASK, 0);
+	if (ret < 0)
+		return ret;
+
+	ret = phy_read(phydev, YTPHY_INTERRUPT_STATUS_REG);
+
+	return ret < 0 ? ret : 0;
+}
+
+static irqreturn_t ytphy_handle_interrupt(struct phy_device *phydev)
+{
+	int irq_status;
+
+	irq_status = phy_read(phydev, YTPHY_INTERRUPT_STATUS_REG);
+	if (irq_status < 0) {
+		phy_error(phydev);
+		return IRQ_NONE;
+	}
+
+	if (!(irq_status & (YTPHY_ISR_LINK_MASK | YTPHY_ISR_WOL)))
+		return IRQ_NONE;
+
+	phy_trigger_machine(phydev);
+
+	return IRQ_HANDLED;
+}
+
+/**
+ * yt8521_config_intr() - enable or disable the link change interrupts
+ * @phydev: a pointer to a &struct phy_device
+ *
+ * NOTE: The interrupt registers of UTP are also used by fiber, see
+ * ytphy_set_wol(), so they are always accessed in the UTP reg space.
+ *
+ * returns 0 or negative errno code
+ */
+static int yt8521_config_intr(struct phy_device *phydev)
+{
+	int ret;
+
+	if (phydev->interrupts == PHY_INTERRUPT_ENABLED) {
+		ret = phy_read_paged(phydev, YT8521_RSSR_UTP_SPACE,
+				     YTPHY_INTERRUPT_STATUS_REG);
+		if (ret < 0)
+			return ret;
+
+		return phy_modify_paged(phydev, YT8521_RSSR_UTP_SPACE,
+					YTPHY_INTERRUPT_ENABLE_REG,
+					YTPHY_IER_LINK_MASK,
+					YTPHY_IER_LINK_MASK);
+	}
+
+	ret = phy_modify_paged(phydev, YT8521_RSSR_UTP_SPACE,
+			       YTPHY_INTERRUPT_ENABLE_REG,
+			       YTPHY_IER_LINK_MASK, 0);
+	if (ret < 0)
+		return ret;
+
+	ret = phy_read_paged(phydev, YT8521_RSSR_UTP_SPACE,
+			     YTPHY_INTERRUPT_STATUS_REG);
+
+	return ret < 0 ? ret : 0;
+}
+
+static irqreturn_t yt8521_handle_interrupt(struct phy_device *phydev)
+{
+	int irq_status;
+
+	irq_status = phy_read_paged(phydev, YT8521_RSSR_UTP_SPACE,
+				    YTPHY_INTERRUPT_STATUS_REG);
+	if (irq_status < 0) {
+		phy_error(phydev);
+		return IRQ_NONE;
+	}
+
+	if (!(irq_status & (YTPHY_ISR_LINK_MASK | YTPHY_ISR_WOL)))
+		return IRQ_NONE;
+
+	phy_trigger_machine(phydev);
+
+	return IRQ_HANDLED;
+}
+
 static int yt8511_read_page(struct phy_device *phydev)
 {
 	return __phy_read(phydev, YT8511_PAGE_SELECT);
@@ -2917,6 +3036,8 @@ static struct phy_driver motorcomm_phy_drvs[] = {
 		.aneg_done	= yt8521_aneg_done,
 		.config_init	= yt8521_config_init,
 		.read_status	= yt8521_read_status,
+		.config_intr	= yt8521_config_intr,
+		.handle_interrupt = yt8521_handle_interrupt,
 		.soft_reset	= yt8521_soft_reset,
 		.suspend	= yt8521_suspend,
 		.resume		= yt8521_resume,
@@ -2930,6 +3051,8 @@ static struct phy_driver motorcomm_phy_drvs[] = {
 		.resume		= genphy_resume,
 		.get_wol	= ytphy_get_wol,
 		.set_wol	= yt8531_set_wol,
+		.config_intr	= ytphy_config_intr,
+		.handle_interrupt = ytphy_handle_interrupt,
 		.link_change_notify = yt8531_link_change_notify,
 	},
 	{
@@ -2945,6 +3068,8 @@ static struct phy_driver motorcomm_phy_drvs[] = {
 		.aneg_done	= yt8521_aneg_done,
 		.config_init	= yt8521_config_init,
 		.read_status	= yt8521_read_status,
+		.config_intr	= yt8521_config_intr,
+		.handle_interrupt = yt8521_handle_interrupt,
 		.soft_reset	= yt8521_soft_reset,
 		.suspend	= yt8521_suspend,
 		.resume		= yt8521_resume,
@@ -6034,6 +6034,8 @@ void brcmf_cfg80211_free_netdev(struct net_device *ndev)
 	ifp = netdev_priv(ndev);
 	vif = ifp->vif;
 
+	gro_cells_destroy(&ifp->gro_cells);
+
 	if (vif)
 		brcmf_free_vif(vif);
 }
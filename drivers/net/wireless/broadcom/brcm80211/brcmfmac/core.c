@@ -423,7 +423,18 @@ void brcmf_netif_rx(struct brcmf_if *ifp, struct sk_buff *skb)
 	ifp->ndev->stats.rx_packets++;
 
 	brcmf_dbg(DATA, "rx proto=0x%X\n", ntohs(skb->protocol));
-	netif_rx(skb);
+
+	/* Bus workers deliver from process context, where the frames can go
+	 * through GRO. The cells expect BH to be off; a caller that disables
+	 * it around a batch of frames gets them aggregated in one poll.
+	 */
+	if (in_task()) {
+		local_bh_disable();
+		gro_cells_receive(&ifp->gro_cells, skb);
+		local_bh_enable();
+	} else {
+		netif_rx(skb);
+	}
 }
 
 void brcmf_netif_mon_rx(struct brcmf_if *ifp, struct sk_buff *skb)
@@ -658,12 +669,19 @@ int brcmf_net_attach(struct brcmf_if *ifp, bool locked)
 	INIT_WORK(&ifp->multicast_work, _brcmf_set_multicast_list);
 	INIT_WORK(&ifp->ndoffload_work, _brcmf_update_ndtable);
 
+	err = gro_cells_init(&ifp->gro_cells, ndev);
+	if (err) {
+		bphy_err(drvr, "couldn't init GRO cells\n");
+		goto fail;
+	}
+
 	if (locked)
 		err = cfg80211_register_netdevice(ndev);
 	else
 		err = register_netdev(ndev);
 	if (err != 0) {
 		bphy_err(drvr, "couldn't register the net device\n");
+		gro_cells_destroy(&ifp->gro_cells);
 		goto fail;
 	}
 
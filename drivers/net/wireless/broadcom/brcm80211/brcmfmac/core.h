@@ -11,6 +11,7 @@
 #define BRCMFMAC_CORE_H
 
 #include <net/cfg80211.h>
+#include <net/gro_cells.h>
 #include "fweh.h"
 
 #if IS_MODULE(CONFIG_BRCMFMAC)
@@ -184,6 +185,7 @@ enum brcmf_netif_stop_reason {
  * @pend_8021x_cnt: tracks outstanding number of 802.1x frames.
  * @pend_8021x_wait: used for signalling change in count.
  * @fwil_fwerr: flag indicating fwil layer should return firmware error codes.
+ * @gro_cells: GRO for frames received in process context.
  */
 struct brcmf_if {
 	struct brcmf_pub *drvr;
@@ -202,6 +204,7 @@ struct brcmf_if {
 	struct in6_addr ipv6_addr_tbl[NDOL_MAX_ENTRIES];
 	u8 ipv6addr_idx;
 	bool fwil_fwerr;
+	struct gro_cells gro_cells;
 };
 
 int brcmf_netdev_wait_pend8021x(struct brcmf_if *ifp);
@@ -1510,12 +1510,30 @@ static void brcmf_sdio_hdpack(struct brcmf_sdio *bus, u8 *header,
 	trace_brcmf_sdpcm_hdr(SDPCM_TX + !!(bus->txglom), header);
 }
 
+/* Hand the data frames of a superframe to the stack with BH off, so that GRO
+ * gets to see all of them in a single poll.
+ */
+static void brcmf_sdio_rx_batch(struct brcmf_sdio *bus,
+				struct sk_buff_head *rxq)
+{
+	struct sk_buff *skb;
+
+	if (skb_queue_empty(rxq))
+		return;
+
+	local_bh_disable();
+	while ((skb = __skb_dequeue(rxq)))
+		brcmf_rx_frame(bus->sdiodev->dev, skb, false, false);
+	local_bh_enable();
+}
+
 static u8 brcmf_sdio_rxglom(struct brcmf_sdio *bus, u8 rxseq)
 {
 	u16 dlen, totlen;
 	u8 *dptr, num = 0;
 	u16 sublen;
 	struct sk_buff *pfirst, *pnext;
+	struct sk_buff_head rxq;
 
 	int errcode;
 	u8 doff;
@@ -1684,6 +1702,7 @@ static u8 brcmf_sdio_rxglom(struct brcmf_sdio *bus, u8 rxseq)
 		}
 
 		/* Basic SD framing looks ok - process each packet (header) */
+		__skb_queue_head_init(&rxq);
 
 		skb_queue_walk_safe(&bus->glom, pfirst, pnext) {
 			dptr = (u8 *) (pfirst->data);
@@ -1711,13 +1730,15 @@ static u8 brcmf_sdio_rxglom(struct brcmf_sdio *bus, u8 rxseq)
 					   pfirst->len, pfirst->next,
 					   pfirst->prev);
 			skb_unlink(pfirst, &bus->glom);
-			if (brcmf_sdio_fromevntchan(&dptr[SDPCM_HWHDR_LEN]))
+			if (brcmf_sdio_fromevntchan(&dptr[SDPCM_HWHDR_LEN])) {
+				brcmf_sdio_rx_batch(bus, &rxq);
 				brcmf_rx_event(bus->sdiodev->dev, pfirst);
-			else
-				brcmf_rx_frame(bus->sdiodev->dev, pfirst,
-					       false, false);
+			} else {
+				__skb_queue_tail(&rxq, pfirst);
+			}
 			bus->sdcnt.rxglompkts++;
 		}
+		brcmf_sdio_rx_batch(bus, &rxq);
 
 		bus->sdcnt.rxglomframes++;
 	}
@@ -80,6 +80,7 @@ struct rockchip_otp {
 	struct clk_bulk_data *clks;
 	struct reset_control *rst;
 	const struct rockchip_data *data;
+	u8 *shadow;
 };
 
 static int rockchip_otp_reset(struct rockchip_otp *otp)
@@ -230,10 +231,9 @@ static int rk3588_otp_read(void *context, unsigned int offset,
 	return ret;
 }
 
-static int rockchip_otp_read(void *context, unsigned int offset,
-			     void *val, size_t bytes)
+static int rockchip_otp_read_hw(struct rockchip_otp *otp, unsigned int offset,
+				void *val, size_t bytes)
 {
-	struct rockchip_otp *otp = context;
 	int ret;
 
 	if (!otp->data || !otp->data->reg_read)
@@ -245,13 +245,50 @@ static int rockchip_otp_read(void *context, unsigned int offset,
 		return ret;
 	}
 
-	ret = otp->data->reg_read(context, offset, val, bytes);
+	ret = otp->data->reg_read(otp, offset, val, bytes);
 
 	clk_bulk_disable_unprepare(otp->data->num_clks, otp->clks);
 
 	return ret;
 }
 
+static int rockchip_otp_read(void *context, unsigned int offset,
+			     void *val, size_t bytes)
+{
+	struct rockchip_otp *otp = context;
+
+	if (!otp->shadow)
+		return rockchip_otp_read_hw(otp, offset, val, bytes);
+
+	memcpy(val, otp->shadow + offset, bytes);
+
+	return 0;
+}
+
+/*
+ * The OTP is small and can't change at runtime, so read it once here and
+ * serve the cells from memory, rather than resetting and clocking the OTP
+ * for every consumer.
+ */
+static void rockchip_otp_init_shadow(struct rockchip_otp *otp)
+{
+	u8 *shadow;
+	int ret;
+
+	shadow = devm_kzalloc(otp->dev, otp->data->size, GFP_KERNEL);
+	if (!shadow)
+		return;
+
+	ret = rockchip_otp_read_hw(otp, 0, shadow, otp->data->size);
+	if (ret) {
+		dev_warn(otp->dev, "failed to read otp, not caching: %d\n", ret);
+		devm_kfree(otp->dev, shadow);
+		return;
+	}
+
+	otp->shadow = shadow;
+}
+
 static struct nvmem_config otp_config = {
 	.name = "rockchip-otp",
 	.owner = THIS_MODULE,
@@ -356,6 +393,8 @@ static int rockchip_otp_probe(struct platform_device *pdev)
 		return dev_err_probe(dev, PTR_ERR(otp->rst),
 				     "failed to get resets\n");
 
+	rockchip_otp_init_shadow(otp);
+
 	otp_config.size = data->size;
 	otp_config.priv = otp;
 	otp_config.dev = dev;
@@ -8,6 +8,7 @@
 
 #include <linux/align.h>
 #include <linux/bitfield.h>
+#include <linux/log2.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 
@@ -204,6 +205,105 @@ static void dw_pcie_ep_clear_bar(struct pci_epc *epc, u8 func_no, u8 vfunc_no,
 	ep->bar_to_atu[bar] = 0;
 }
 
+static enum pci_epc_bar_type dw_pcie_ep_get_bar_type(struct dw_pcie_ep *ep,
+						     enum pci_barno bar)
+{
+	const struct pci_epc_features *epc_features;
+
+	if (!ep->ops->get_features)
+		return BAR_PROGRAMMABLE;
+
+	epc_features = ep->ops->get_features(ep);
+
+	return epc_features->bar[bar].type;
+}
+
+/*
+ * Sizes in REBAR_CAP start at 1 MB in BIT(4), see PCIe r6.0, sec 7.8.6.2.
+ * Sizes above 128 TB live in REBAR_CTRL and are not supported.
+ */
+static int dw_pcie_ep_bar_size_to_rebar_cap(size_t size, u32 *cap)
+{
+	if (size < SZ_1M || !is_power_of_2(size) ||
+	    (u64)size > (SZ_128G * 1024ULL))
+		return -EINVAL;
+
+	*cap = BIT(ilog2(size) - ilog2(SZ_1M) + 4);
+
+	return 0;
+}
+
+static unsigned int dw_pcie_ep_get_rebar_offset(struct dw_pcie *pci,
+						enum pci_barno bar)
+{
+	unsigned int offset, nbars;
+	u32 reg, i;
+
+	offset = dw_pcie_find_ext_capability(pci, PCI_EXT_CAP_ID_REBAR);
+	if (!offset)
+		return 0;
+
+	reg = dw_pcie_readl_dbi(pci, offset + PCI_REBAR_CTRL);
+	nbars = FIELD_GET(PCI_REBAR_CTRL_NBAR_MASK, reg);
+
+	for (i = 0; i < nbars; i++, offset += PCI_REBAR_CTRL) {
+		reg = dw_pcie_readl_dbi(pci, offset + PCI_REBAR_CTRL);
+		if (FIELD_GET(PCI_REBAR_CTRL_BAR_IDX, reg) == bar)
+			return offset;
+	}
+
+	return 0;
+}
+
+static int dw_pcie_ep_set_bar_resizable(struct dw_pcie_ep *ep, u8 func_no,
+					struct pci_epf_bar *epf_bar)
+{
+	struct dw_pcie *pci = to_dw_pcie_from_ep(ep);
+	enum pci_barno bar = epf_bar->barno;
+	u32 reg = PCI_BASE_ADDRESS_0 + (4 * bar);
+	int flags = epf_bar->flags;
+	unsigned int rebar_offset;
+	u32 rebar_cap, rebar_ctrl;
+	int ret;
+
+	rebar_offset = dw_pcie_ep_get_rebar_offset(pci, bar);
+	if (!rebar_offset)
+		return -EINVAL;
+
+	ret = dw_pcie_ep_bar_size_to_rebar_cap(epf_bar->size, &rebar_cap);
+	if (ret)
+		return ret;
+
+	dw_pcie_dbi_ro_wr_en(pci);
+
+	/*
+	 * The BAR mask of a resizable BAR is derived by the controller from
+	 * the "selected size" field, so just set the BAR enable bit here.
+	 */
+	dw_pcie_ep_writel_dbi2(ep, func_no, reg, BIT(0));
+	dw_pcie_ep_writel_dbi(ep, func_no, reg, flags);
+
+	if (flags & PCI_BASE_ADDRESS_MEM_TYPE_64) {
+		dw_pcie_ep_writel_dbi2(ep, func_no, reg + 4, 0);
+		dw_pcie_ep_writel_dbi(ep, func_no, reg + 4, 0);
+	}
+
+	/* Don't advertise the 256 TB to 8 EB sizes held in REBAR_CTRL[31:16] */
+	rebar_ctrl = dw_pcie_readl_dbi(pci, rebar_offset + PCI_REBAR_CTRL);
+	rebar_ctrl &= ~GENMASK(31, 16);
+	dw_pcie_writel_dbi(pci, rebar_offset + PCI_REBAR_CTRL, rebar_ctrl);
+
+	/*
+	 * Writing REBAR_CAP with a single supported size makes the controller
+	 * update the "selected size" field to match it.
+	 */
+	dw_pcie_writel_dbi(pci, rebar_offset + PCI_REBAR_CAP, rebar_cap);
+
+	dw_pcie_dbi_ro_wr_dis(pci);
+
+	return 0;
+}
+
 static int dw_pcie_ep_set_bar(struct pci_epc *epc, u8 func_no, u8 vfunc_no,
 			      struct pci_epf_bar *epf_bar)
 {
@@ -245,6 +345,14 @@ static int dw_pcie_ep_set_bar(struct pci_epc *epc, u8 func_no, u8 vfunc_no,
 		goto config_atu;
 	}
 
+	if (dw_pcie_ep_get_bar_type(ep, bar) == BAR_RESIZABLE) {
+		ret = dw_pcie_ep_set_bar_resizable(ep, func_no, epf_bar);
+		if (ret)
+			return ret;
+
+		goto config_atu;
+	}
+
 	reg = PCI_BASE_ADDRESS_0 + (4 * bar);
 
 	dw_pcie_dbi_ro_wr_en(pci);
@@ -693,9 +801,11 @@ static unsigned int dw_pcie_ep_find_ext_capability(struct dw_pcie *pci, int cap)
 
 static void dw_pcie_ep_init_non_sticky_registers(struct dw_pcie *pci)
 {
+	struct dw_pcie_ep *ep = &pci->ep;
 	unsigned int offset;
 	unsigned int nbars;
-	u32 reg, i;
+	enum pci_barno bar;
+	u32 reg, i, val;
 
 	offset = dw_pcie_ep_find_ext_capability(pci, PCI_EXT_CAP_ID_REBAR);
 
@@ -709,10 +819,20 @@ static void dw_pcie_ep_init_non_sticky_registers(struct dw_pcie *pci)
 		/*
 		 * PCIe r6.0, sec 7.8.6.2 require us to support at least one
 		 * size in the range from 1 MB to 512 GB. Advertise support
-		 * for 1 MB BAR size only.
+		 * for 1 MB BAR size only, unless the BAR has already been
+		 * configured via dw_pcie_ep_set_bar(), in which case the
+		 * selected size (non-sticky) has to be restored.
 		 */
-		for (i = 0; i < nbars; i++, offset += PCI_REBAR_CTRL)
-			dw_pcie_writel_dbi(pci, offset + PCI_REBAR_CAP, BIT(4));
+		for (i = 0; i < nbars; i++, offset += PCI_REBAR_CTRL) {
+			val = dw_pcie_readl_dbi(pci, offset + PCI_REBAR_CTRL);
+			bar = FIELD_GET(PCI_REBAR_CTRL_BAR_IDX, val);
+			if (!ep->epf_bar[bar] ||
+			    dw_pcie_ep_bar_size_to_rebar_cap(ep->epf_bar[bar]->size,
+							     &val))
+				val = BIT(4);
+
+			dw_pcie_writel_dbi(pci, offset + PCI_REBAR_CAP, val);
+		}
 	}
 
 	dw_pcie_setup(pci);
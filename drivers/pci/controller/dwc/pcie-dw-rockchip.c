@@ -9,7 +9,9 @@
  */
 
 #include <linux/clk.h>
+#include <linux/debugfs.h>
 #include <linux/gpio/consumer.h>
+#include <linux/iopoll.h>
 #include <linux/irqchip/chained_irq.h>
 #include <linux/irqdomain.h>
 #include <linux/mfd/syscon.h>
@@ -39,6 +41,10 @@
 #define PCIE_CLIENT_DISABLE_LTSSM	HIWORD_UPDATE(0x0c, 0x8)
 #define PCIE_CLIENT_INTR_STATUS_MISC	0x10
 #define PCIE_CLIENT_INTR_MASK_MISC	0x24
+#define PCIE_CLIENT_POWER_CON		0x2c
+#define PCIE_CLKREQ_READY		HIWORD_UPDATE_BIT(BIT(0))
+#define PCIE_CLKREQ_NOT_READY		HIWORD_UPDATE(BIT(0), 0)
+#define PCIE_CLKREQ_PULL_DOWN		HIWORD_UPDATE(GENMASK(13, 12), BIT(12))
 #define PCIE_SMLH_LINKUP		BIT(16)
 #define PCIE_RDLH_LINKUP		BIT(17)
 #define PCIE_LINKUP			(PCIE_SMLH_LINKUP | PCIE_RDLH_LINKUP)
@@ -53,6 +59,8 @@
 #define PCIE_LTSSM_ENABLE_ENHANCE	BIT(4)
 #define PCIE_LTSSM_STATUS_MASK		GENMASK(5, 0)
 
+#define PCIE_LINK_RETRAIN_TIMEOUT_US	(100 * USEC_PER_MSEC)
+
 struct rockchip_pcie {
 	struct dw_pcie pci;
 	void __iomem *apb_base;
@@ -64,6 +72,8 @@ struct rockchip_pcie {
 	struct regulator *vpcie3v3;
 	struct irq_domain *irq_domain;
 	const struct rockchip_pcie_of_data *data;
+	bool supports_clkreq;
+	struct dentry *debugfs;
 };
 
 struct rockchip_pcie_of_data {
@@ -206,6 +216,42 @@ static int rockchip_pcie_start_link(struct dw_pcie *pci)
 	return 0;
 }
 
+/*
+ * L1 substates need CLKREQ# to be wired to the device, which is what the
+ * "supports-clkreq" DT property tells us. Tell the controller CLKREQ# is
+ * ready in that case, otherwise keep it asserted and hide L1SS from the
+ * ASPM core so that it never enables L1.1/L1.2 on a board that can't
+ * wake up from them.
+ */
+static void rockchip_pcie_configure_l1ss(struct dw_pcie *pci, bool enable)
+{
+	struct rockchip_pcie *rockchip = to_rockchip_pcie(pci);
+	u32 cap, l1ss;
+
+	if (enable) {
+		rockchip_pcie_writel_apb(rockchip, PCIE_CLKREQ_READY,
+					 PCIE_CLIENT_POWER_CON);
+		return;
+	}
+
+	rockchip_pcie_writel_apb(rockchip,
+				 PCIE_CLKREQ_PULL_DOWN | PCIE_CLKREQ_NOT_READY,
+				 PCIE_CLIENT_POWER_CON);
+
+	l1ss = dw_pcie_find_ext_capability(pci, PCI_EXT_CAP_ID_L1SS);
+	if (!l1ss)
+		return;
+
+	cap = dw_pcie_readl_dbi(pci, l1ss + PCI_L1SS_CAP);
+	cap &= ~(PCI_L1SS_CAP_PCIPM_L1_1 | PCI_L1SS_CAP_PCIPM_L1_2 |
+		 PCI_L1SS_CAP_ASPM_L1_1 | PCI_L1SS_CAP_ASPM_L1_2 |
+		 PCI_L1SS_CAP_L1_PM_SS);
+
+	dw_pcie_dbi_ro_wr_en(pci);
+	dw_pcie_writel_dbi(pci, l1ss + PCI_L1SS_CAP, cap);
+	dw_pcie_dbi_ro_wr_dis(pci);
+}
+
 static void rockchip_pcie_stop_link(struct dw_pcie *pci)
 {
 	struct rockchip_pcie *rockchip = to_rockchip_pcie(pci);
@@ -231,6 +277,8 @@ static int rockchip_pcie_host_init(struct dw_pcie_rp *pp)
 	irq_set_chained_handler_and_data(irq, rockchip_pcie_intx_handler,
 					 rockchip);
 
+	rockchip_pcie_configure_l1ss(pci, rockchip->supports_clkreq);
+
 	return 0;
 }
 
@@ -243,6 +291,9 @@ static void rockchip_pcie_ep_init(struct dw_pcie_ep *ep)
 	struct dw_pcie *pci = to_dw_pcie_from_ep(ep);
 	enum pci_barno bar;
 
+	/* Saving power in L1SS needs more work on the EP side, keep it off */
+	rockchip_pcie_configure_l1ss(pci, false);
+
 	for (bar = 0; bar < PCI_STD_NUM_BARS; bar++)
 		dw_pcie_ep_reset_bar(pci, bar);
 };
@@ -271,12 +322,12 @@ static const struct pci_epc_features rockchip_pcie_epc_features_rk3568 = {
 	.msi_capable = true,
 	.msix_capable = true,
 	.align = SZ_64K,
-	.bar[BAR_0] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
-	.bar[BAR_1] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
-	.bar[BAR_2] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
-	.bar[BAR_3] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
-	.bar[BAR_4] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
-	.bar[BAR_5] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
+	.bar[BAR_0] = { .type = BAR_RESIZABLE, },
+	.bar[BAR_1] = { .type = BAR_RESIZABLE, },
+	.bar[BAR_2] = { .type = BAR_RESIZABLE, },
+	.bar[BAR_3] = { .type = BAR_RESIZABLE, },
+	.bar[BAR_4] = { .type = BAR_RESIZABLE, },
+	.bar[BAR_5] = { .type = BAR_RESIZABLE, },
 };
 
 /*
@@ -291,12 +342,12 @@ static const struct pci_epc_features rockchip_pcie_epc_features_rk3588 = {
 	.msi_capable = true,
 	.msix_capable = true,
 	.align = SZ_64K,
-	.bar[BAR_0] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
-	.bar[BAR_1] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
-	.bar[BAR_2] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
-	.bar[BAR_3] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
+	.bar[BAR_0] = { .type = BAR_RESIZABLE, },
+	.bar[BAR_1] = { .type = BAR_RESIZABLE, },
+	.bar[BAR_2] = { .type = BAR_RESIZABLE, },
+	.bar[BAR_3] = { .type = BAR_RESIZABLE, },
 	.bar[BAR_4] = { .type = BAR_RESERVED, },
-	.bar[BAR_5] = { .type = BAR_FIXED, .fixed_size = SZ_1M, },
+	.bar[BAR_5] = { .type = BAR_RESIZABLE, },
 };
 
 static const struct pci_epc_features *
@@ -332,6 +383,39 @@ static int rockchip_pcie_clk_init(struct rockchip_pcie *rockchip)
 	return 0;
 }
 
+/*
+ * The unrolled port logic space sits at DBI + DEFAULT_DBI_ATU_OFFSET: 512 KiB
+ * of iATU registers followed by the eDMA registers. Older DTs neither
+ * describe an "atu" nor a "dma" region, so the DWC core would only assume
+ * 4 KiB of iATU space, i.e. at most 8 outbound/inbound windows, and miss the
+ * eDMA engine. If the DBI region is large enough, advertise the whole iATU
+ * space so that every implemented window is detected, and extend it over the
+ * eDMA registers if the eDMA interrupts are wired up, so that the core
+ * registers the eDMA as a dmaengine provider for both the RC and EP modes.
+ */
+static void rockchip_pcie_atu_get(struct platform_device *pdev,
+				  struct rockchip_pcie *rockchip)
+{
+	struct resource *res;
+
+	if (platform_get_resource_byname(pdev, IORESOURCE_MEM, "atu") ||
+	    platform_get_resource_byname(pdev, IORESOURCE_MEM, "dma"))
+		return;
+
+	res = platform_get_resource_byname(pdev, IORESOURCE_MEM, "dbi");
+	if (!res || resource_size(res) < DEFAULT_DBI_ATU_OFFSET +
+					 2 * DEFAULT_DBI_DMA_OFFSET)
+		return;
+
+	rockchip->pci.atu_size = DEFAULT_DBI_DMA_OFFSET;
+
+	if (platform_get_irq_byname_optional(pdev, "dma") <= 0 &&
+	    platform_get_irq_byname_optional(pdev, "dma0") <= 0)
+		return;
+
+	rockchip->pci.atu_size = 2 * DEFAULT_DBI_DMA_OFFSET;
+}
+
 static int rockchip_pcie_resource_get(struct platform_device *pdev,
 				      struct rockchip_pcie *rockchip)
 {
@@ -351,6 +435,11 @@ static int rockchip_pcie_resource_get(struct platform_device *pdev,
 		return dev_err_probe(&pdev->dev, PTR_ERR(rockchip->rst),
 				     "failed to get reset lines\n");
 
+	rockchip_pcie_atu_get(pdev, rockchip);
+
+	rockchip->supports_clkreq = of_property_read_bool(pdev->dev.of_node,
+							  "supports-clkreq");
+
 	return 0;
 }
 
@@ -416,10 +505,133 @@ static irqreturn_t rockchip_pcie_ep_sys_irq_thread(int irq, void *arg)
 	return IRQ_HANDLED;
 }
 
+/*
+ * Retrain the Root Port link to @gen without going through Detect again,
+ * so that the link can be dropped to a lower rate when the traffic does
+ * not need it and brought back up to the maximum rate for bursts. The
+ * Target Link Speed encoding matches the generation number. Link Control
+ * is also written by the ASPM core, so it is only updated through the
+ * locked PCIe capability accessors of the Root Port.
+ */
+static int rockchip_pcie_retrain_link(struct rockchip_pcie *rockchip, int gen)
+{
+	struct dw_pcie *pci = &rockchip->pci;
+	u8 offset = dw_pcie_find_capability(pci, PCI_CAP_ID_EXP);
+	struct pci_dev *root;
+	u16 val;
+	int ret;
+
+	if (gen < 1 || gen > pci->max_link_speed)
+		return -EINVAL;
+
+	if (!dw_pcie_link_up(pci))
+		return -ENOLINK;
+
+	root = pci_get_slot(pci->pp.bridge->bus, PCI_DEVFN(0, 0));
+	if (!root)
+		return -ENODEV;
+
+	pcie_capability_clear_and_set_word(root, PCI_EXP_LNKCTL2,
+					   PCI_EXP_LNKCTL2_TLS, gen);
+	pcie_capability_set_word(root, PCI_EXP_LNKCTL, PCI_EXP_LNKCTL_RL);
+	pci_dev_put(root);
+
+	ret = read_poll_timeout(dw_pcie_readw_dbi, val,
+				!(val & PCI_EXP_LNKSTA_LT), USEC_PER_MSEC,
+				PCIE_LINK_RETRAIN_TIMEOUT_US, false, pci,
+				offset + PCI_EXP_LNKSTA);
+	if (ret) {
+		dev_err(pci->dev, "link retraining to Gen%d timed out\n", gen);
+		return ret;
+	}
+
+	dev_dbg(pci->dev, "link retrained: Gen%u x%u\n",
+		FIELD_GET(PCI_EXP_LNKSTA_CLS, val),
+		FIELD_GET(PCI_EXP_LNKSTA_NLW, val));
+
+	return 0;
+}
+
+static int rockchip_pcie_link_speed_show(struct seq_file *s, void *data)
+{
+	struct rockchip_pcie *rockchip = s->private;
+	struct dw_pcie *pci = &rockchip->pci;
+	u8 offset = dw_pcie_find_capability(pci, PCI_CAP_ID_EXP);
+	u16 val;
+
+	val = dw_pcie_readw_dbi(pci, offset + PCI_EXP_LNKSTA);
+	seq_printf(s, "Gen%u x%u (max Gen%d)\n",
+		   FIELD_GET(PCI_EXP_LNKSTA_CLS, val),
+		   FIELD_GET(PCI_EXP_LNKSTA_NLW, val),
+		   pci->max_link_speed);
+
+	return 0;
+}
+
+static int rockchip_pcie_link_speed_open(struct inode *inode,
+					 struct file *file)
+{
+	return single_open(file, rockchip_pcie_link_speed_show,
+			   inode->i_private);
+}
+
+static ssize_t rockchip_pcie_link_speed_write(struct file *file,
+					      const char __user *buf,
+					      size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct rockchip_pcie *rockchip = s->private;
+	int gen, ret;
+
+	ret = kstrtoint_from_user(buf, count, 0, &gen);
+	if (ret)
+		return ret;
+
+	ret = rockchip_pcie_retrain_link(rockchip, gen);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+static const struct file_operations rockchip_pcie_link_speed_fops = {
+	.owner = THIS_MODULE,
+	.open = rockchip_pcie_link_speed_open,
+	.read = seq_read,
+	.write = rockchip_pcie_link_speed_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void rockchip_pcie_remove_debugfs(void *data)
+{
+	struct rockchip_pcie *rockchip = data;
+
+	debugfs_remove_recursive(rockchip->debugfs);
+}
+
+static void rockchip_pcie_init_debugfs(struct rockchip_pcie *rockchip)
+{
+	struct device *dev = rockchip->pci.dev;
+	char *name;
+
+	name = devm_kasprintf(dev, GFP_KERNEL, "%pOFP", dev->of_node);
+	if (!name)
+		return;
+
+	/* The DWC core has no debugfs directory of its own to nest under */
+	rockchip->debugfs = debugfs_create_dir(name, NULL);
+	debugfs_create_file("link_speed", 0644, rockchip->debugfs, rockchip,
+			    &rockchip_pcie_link_speed_fops);
+
+	devm_add_action_or_reset(dev, rockchip_pcie_remove_debugfs, rockchip);
+}
+
 static int rockchip_pcie_configure_rc(struct rockchip_pcie *rockchip)
 {
 	struct dw_pcie_rp *pp;
 	u32 val;
+	int ret;
 
 	if (!IS_ENABLED(CONFIG_PCIE_ROCKCHIP_DW_HOST))
 		return -ENODEV;
@@ -434,7 +646,13 @@ static int rockchip_pcie_configure_rc(struct rockchip_pcie *rockchip)
 	pp = &rockchip->pci.pp;
 	pp->ops = &rockchip_pcie_host_ops;
 
-	return dw_pcie_host_init(pp);
+	ret = dw_pcie_host_init(pp);
+	if (ret)
+		return ret;
+
+	rockchip_pcie_init_debugfs(rockchip);
+
+	return 0;
 }
 
 static int rockchip_pcie_configure_ep(struct platform_device *pdev,
@@ -614,6 +832,7 @@ static struct platform_driver rockchip_pcie_driver = {
 		.name	= "rockchip-dw-pcie",
 		.of_match_table = rockchip_pcie_of_match,
 		.suppress_bind_attrs = true,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = rockchip_pcie_probe,
 };
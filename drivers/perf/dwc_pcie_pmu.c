@@ -108,6 +108,7 @@ struct dwc_pcie_vendor_id {
 static const struct dwc_pcie_vendor_id dwc_pcie_vendor_ids[] = {
 	{.vendor_id = PCI_VENDOR_ID_ALIBABA },
 	{.vendor_id = PCI_VENDOR_ID_QCOM },
+	{.vendor_id = PCI_VENDOR_ID_ROCKCHIP },
 	{} /* terminator */
 };
 
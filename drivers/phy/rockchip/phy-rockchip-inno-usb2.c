@@ -640,6 +640,11 @@ static const struct phy_ops rockchip_usb2phy_ops = {
 	.owner		= THIS_MODULE,
 };
 
+static bool rockchip_chg_det_supported(struct rockchip_usb2phy *rphy)
+{
+	return rphy->phy_cfg->chg_det.cp_det.offset;
+}
+
 static void rockchip_usb2phy_otg_sm_work(struct work_struct *work)
 {
 	struct rockchip_usb2phy_port *rport =
@@ -675,8 +680,18 @@ static void rockchip_usb2phy_otg_sm_work(struct work_struct *work)
 			dev_dbg(&rport->phy->dev, "vbus_attach\n");
 			switch (rphy->chg_state) {
 			case USB_CHG_STATE_UNDEFINED:
-				schedule_delayed_work(&rport->chg_work, 0);
-				return;
+				if (rockchip_chg_det_supported(rphy)) {
+					schedule_delayed_work(&rport->chg_work, 0);
+					return;
+				}
+				/*
+				 * Without a BC1.2 detection block there is
+				 * nothing to wait for, treat the port as an
+				 * SDP and bring the PHY up right away.
+				 */
+				rphy->chg_type = POWER_SUPPLY_TYPE_USB;
+				rphy->chg_state = USB_CHG_STATE_DETECTED;
+				fallthrough;
 			case USB_CHG_STATE_DETECTED:
 				switch (rphy->chg_type) {
 				case POWER_SUPPLY_TYPE_USB:
@@ -1097,6 +1112,14 @@ static irqreturn_t rockchip_usb2phy_host_disc_irq(int irq, void *data)
 
 	mutex_unlock(&rport->mutex);
 
+	/*
+	 * Let the state machine see the disconnect now rather than on its
+	 * next periodic run, so the port is suspended and the linestate irq
+	 * rearmed before the next device is plugged in.
+	 */
+	if (rport->host_disconnect && !rport->suspended)
+		mod_delayed_work(system_wq, &rport->sm_work, 0);
+
 	return IRQ_HANDLED;
 }
 
@@ -1255,7 +1278,8 @@ static int rockchip_otg_event(struct notifier_block *nb,
 	struct rockchip_usb2phy_port *rport =
 		container_of(nb, struct rockchip_usb2phy_port, event_nb);
 
-	schedule_delayed_work(&rport->otg_sm_work, OTG_SCHEDULE_DELAY);
+	/* Act on the id change right away, not after a fixed delay. */
+	mod_delayed_work(system_wq, &rport->otg_sm_work, 0);
 
 	return NOTIFY_DONE;
 }
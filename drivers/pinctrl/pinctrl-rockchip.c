@@ -1199,6 +1199,65 @@ static int rockchip_verify_mux(struct rockchip_pin_bank *bank,
 	return 0;
 }
 
+/*
+ * Collects the mux settings of pins sharing one iomux register so that a
+ * whole group can be switched with one access per register rather than
+ * one per pin.
+ *
+ * Pull, drive strength and schmitt are not batched. The DT maps hand them
+ * to the core as per-pin configs, which it applies one pin at a time
+ * through rockchip_pinconf_set() without any end-of-state hook where a
+ * batch could be flushed.
+ */
+struct rockchip_mux_batch {
+	struct regmap *regmap;
+	u32 reg;
+	u32 mask;
+	u32 val;
+};
+
+static int rockchip_mux_batch_flush(struct rockchip_mux_batch *batch)
+{
+	u32 orig;
+	int ret;
+
+	if (!batch->regmap)
+		return 0;
+
+	/* The pins often already are in the requested state, e.g. on resume. */
+	ret = regmap_read(batch->regmap, batch->reg, &orig);
+	if (ret || (orig & batch->mask) != batch->val)
+		ret = regmap_write(batch->regmap, batch->reg,
+				   (batch->mask << 16) | batch->val);
+
+	batch->regmap = NULL;
+	batch->mask = 0;
+	batch->val = 0;
+
+	return ret;
+}
+
+static int rockchip_mux_batch_add(struct rockchip_mux_batch *batch,
+				  struct regmap *regmap, u32 reg, u8 bit,
+				  u32 mask, int mux)
+{
+	int ret;
+
+	if (batch->regmap && (batch->regmap != regmap || batch->reg != reg)) {
+		ret = rockchip_mux_batch_flush(batch);
+		if (ret)
+			return ret;
+	}
+
+	batch->regmap = regmap;
+	batch->reg = reg;
+	batch->mask |= mask << bit;
+	batch->val &= ~(mask << bit);
+	batch->val |= (mux & mask) << bit;
+
+	return 0;
+}
+
 /*
  * Set a new mux function for a pin.
  *
@@ -1211,8 +1270,10 @@ static int rockchip_verify_mux(struct rockchip_pin_bank *bank,
  * @bank: pin bank to change
  * @pin: pin to change
  * @mux: new mux function to set
+ * @batch: batch to add the mux register write to, NULL to write it now
  */
-static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
+static int rockchip_set_mux_batch(struct rockchip_pin_bank *bank, int pin,
+				  int mux, struct rockchip_mux_batch *batch)
 {
 	struct rockchip_pinctrl *info = bank->drvdata;
 	struct rockchip_pin_ctrl *ctrl = info->ctrl;
@@ -1326,6 +1387,9 @@ static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 		}
 	}
 
+	if (batch)
+		return rockchip_mux_batch_add(batch, regmap, reg, bit, mask, mux);
+
 	data = (mask << (bit + 16));
 	rmask = data | (data >> 16);
 	data |= (mux & mask) << bit;
@@ -1334,6 +1398,11 @@ static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 	return ret;
 }
 
+static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
+{
+	return rockchip_set_mux_batch(bank, pin, mux, NULL);
+}
+
 #define PX30_PULL_PMU_OFFSET		0x10
 #define PX30_PULL_GRF_OFFSET		0x60
 #define PX30_PULL_BITS_PER_PIN		2
@@ -2890,6 +2959,7 @@ static int rockchip_pmx_set(struct pinctrl_dev *pctldev, unsigned selector,
 	struct rockchip_pinctrl *info = pinctrl_dev_get_drvdata(pctldev);
 	const unsigned int *pins = info->groups[group].pins;
 	const struct rockchip_pin_config *data = info->groups[group].data;
+	struct rockchip_mux_batch batch = {};
 	struct device *dev = info->dev;
 	struct rockchip_pin_bank *bank;
 	int cnt, ret = 0;
@@ -2903,12 +2973,15 @@ static int rockchip_pmx_set(struct pinctrl_dev *pctldev, unsigned selector,
 	 */
 	for (cnt = 0; cnt < info->groups[group].npins; cnt++) {
 		bank = pin_to_bank(info, pins[cnt]);
-		ret = rockchip_set_mux(bank, pins[cnt] - bank->pin_base,
-				       data[cnt].func);
+		ret = rockchip_set_mux_batch(bank, pins[cnt] - bank->pin_base,
+					     data[cnt].func, &batch);
 		if (ret)
 			break;
 	}
 
+	if (!ret)
+		ret = rockchip_mux_batch_flush(&batch);
+
 	if (ret) {
 		/* revert the already done pin settings */
 		for (cnt--; cnt >= 0; cnt--) {
@@ -779,7 +779,12 @@ static int rockchip_pm_add_one_domain(struct rockchip_pmu *pmu,
 	pd->genpd.flags = GENPD_FLAG_PM_CLK;
 	if (pd_info->active_wakeup)
 		pd->genpd.flags |= GENPD_FLAG_ACTIVE_WAKEUP;
-	pm_genpd_init(&pd->genpd, NULL,
+	/*
+	 * Hand the domain a governor so genpd times each power transition
+	 * and keeps the domain on while a consumer's resume latency
+	 * constraint is shorter than the measured off/on cost.
+	 */
+	pm_genpd_init(&pd->genpd, &simple_qos_governor,
 		      !rockchip_pmu_domain_is_on(pd) ||
 		      (pd->info->mem_status_mask && !rockchip_pmu_domain_is_mem_on(pd)));
 
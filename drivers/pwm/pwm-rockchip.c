@@ -8,6 +8,7 @@
 
 #include <linux/clk.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
@@ -20,6 +21,8 @@
 
 #define PWM_ENABLE		(1 << 0)
 #define PWM_CONTINUOUS		(1 << 1)
+#define PWM_CAPTURE		(2 << 1)
+#define PWM_MODE_MASK		(3 << 1)
 #define PWM_DUTY_POSITIVE	(1 << 3)
 #define PWM_DUTY_NEGATIVE	(0 << 3)
 #define PWM_INACTIVE_NEGATIVE	(0 << 4)
@@ -48,6 +51,7 @@ struct rockchip_pwm_data {
 	unsigned int prescaler;
 	bool supports_polarity;
 	bool supports_lock;
+	bool supports_capture;
 	u32 enable_conf;
 };
 
@@ -224,7 +228,93 @@ static int rockchip_pwm_apply(struct pwm_chip *chip, struct pwm_device *pwm,
 	return ret;
 }
 
+static bool rockchip_pwm_capture_done(struct rockchip_pwm_chip *pc)
+{
+	return readl_relaxed(pc->base + pc->data->regs.period) &&
+	       readl_relaxed(pc->base + pc->data->regs.duty);
+}
+
+/*
+ * In capture mode the period and duty registers latch the number of PWM
+ * clock cycles the input stayed high and low for, and keep being updated
+ * by the hardware on every edge. A single read after both have been
+ * filled in thus gives the latest waveform without any per-edge work.
+ *
+ * The first phase is only counted from when capture got enabled, so the
+ * first pair is cleared again once it is complete. The phase that is in
+ * progress at that point has been counted from its start, so the next
+ * pair is a full period.
+ */
+static int rockchip_pwm_capture(struct pwm_chip *chip, struct pwm_device *pwm,
+				struct pwm_capture *result,
+				unsigned long timeout)
+{
+	struct rockchip_pwm_chip *pc = to_rockchip_pwm_chip(chip);
+	unsigned long clk_rate;
+	u32 ctrl, high, low;
+	bool done;
+	u64 tmp;
+	int ret;
+
+	if (!pc->data->supports_capture)
+		return -EOPNOTSUPP;
+
+	if (pwm->state.enabled)
+		return -EBUSY;
+
+	ret = clk_enable(pc->pclk);
+	if (ret)
+		return ret;
+
+	ret = clk_enable(pc->clk);
+	if (ret)
+		goto out_pclk;
+
+	clk_rate = clk_get_rate(pc->clk);
+
+	/* Drop the output configuration so that stale values aren't read. */
+	writel_relaxed(0, pc->base + pc->data->regs.period);
+	writel_relaxed(0, pc->base + pc->data->regs.duty);
+
+	ctrl = readl_relaxed(pc->base + pc->data->regs.ctrl);
+	writel((ctrl & ~PWM_MODE_MASK) | PWM_CAPTURE | PWM_ENABLE,
+	       pc->base + pc->data->regs.ctrl);
+
+	ret = read_poll_timeout(rockchip_pwm_capture_done, done, done,
+				USEC_PER_MSEC, timeout * USEC_PER_MSEC, false,
+				pc);
+	if (!ret) {
+		writel_relaxed(0, pc->base + pc->data->regs.period);
+		writel_relaxed(0, pc->base + pc->data->regs.duty);
+		ret = read_poll_timeout(rockchip_pwm_capture_done, done, done,
+					USEC_PER_MSEC, timeout * USEC_PER_MSEC,
+					false, pc);
+	}
+
+	high = readl_relaxed(pc->base + pc->data->regs.period);
+	low = readl_relaxed(pc->base + pc->data->regs.duty);
+
+	writel_relaxed(ctrl, pc->base + pc->data->regs.ctrl);
+
+	if (ret)
+		goto out_clk;
+
+	tmp = ((u64)high + low) * pc->data->prescaler * NSEC_PER_SEC;
+	result->period = DIV_ROUND_CLOSEST_ULL(tmp, clk_rate);
+
+	tmp = (u64)high * pc->data->prescaler * NSEC_PER_SEC;
+	result->duty_cycle = DIV_ROUND_CLOSEST_ULL(tmp, clk_rate);
+
+out_clk:
+	clk_disable(pc->clk);
+out_pclk:
+	clk_disable(pc->pclk);
+
+	return ret;
+}
+
 static const struct pwm_ops rockchip_pwm_ops = {
+	.capture = rockchip_pwm_capture,
 	.get_state = rockchip_pwm_get_state,
 	.apply = rockchip_pwm_apply,
 };
@@ -239,6 +329,7 @@ static const struct rockchip_pwm_data pwm_data_v1 = {
 	.prescaler = 2,
 	.supports_polarity = false,
 	.supports_lock = false,
+	.supports_capture = false,
 	.enable_conf = PWM_CTRL_OUTPUT_EN | PWM_CTRL_TIMER_EN,
 };
 
@@ -252,6 +343,7 @@ static const struct rockchip_pwm_data pwm_data_v2 = {
 	.prescaler = 1,
 	.supports_polarity = true,
 	.supports_lock = false,
+	.supports_capture = true,
 	.enable_conf = PWM_OUTPUT_LEFT | PWM_LP_DISABLE | PWM_ENABLE |
 		       PWM_CONTINUOUS,
 };
@@ -266,6 +358,7 @@ static const struct rockchip_pwm_data pwm_data_vop = {
 	.prescaler = 1,
 	.supports_polarity = true,
 	.supports_lock = false,
+	.supports_capture = false,
 	.enable_conf = PWM_OUTPUT_LEFT | PWM_LP_DISABLE | PWM_ENABLE |
 		       PWM_CONTINUOUS,
 };
@@ -280,6 +373,7 @@ static const struct rockchip_pwm_data pwm_data_v3 = {
 	.prescaler = 1,
 	.supports_polarity = true,
 	.supports_lock = true,
+	.supports_capture = true,
 	.enable_conf = PWM_OUTPUT_LEFT | PWM_LP_DISABLE | PWM_ENABLE |
 		       PWM_CONTINUOUS,
 };
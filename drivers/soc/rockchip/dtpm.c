@@ -41,8 +41,33 @@ static struct dtpm_node __initdata rk3399_hierarchy[] = {
 	[9] = { /* sentinel */ }
 };
 
+static struct dtpm_node __initdata rk3568_hierarchy[] = {
+	[0] = { .name = "rk3568",
+		.type = DTPM_NODE_VIRTUAL },
+	[1] = { .name = "package",
+		.type = DTPM_NODE_VIRTUAL,
+		.parent = &rk3568_hierarchy[0] },
+	[2] = { .name = "/cpus/cpu@0",
+		.type = DTPM_NODE_DT,
+		.parent = &rk3568_hierarchy[1] },
+	[3] = { .name = "/cpus/cpu@100",
+		.type = DTPM_NODE_DT,
+		.parent = &rk3568_hierarchy[1] },
+	[4] = { .name = "/cpus/cpu@200",
+		.type = DTPM_NODE_DT,
+		.parent = &rk3568_hierarchy[1] },
+	[5] = { .name = "/cpus/cpu@300",
+		.type = DTPM_NODE_DT,
+		.parent = &rk3568_hierarchy[1] },
+	[6] = { .name = "/gpu@fde60000",
+		.type = DTPM_NODE_DT,
+		.parent = &rk3568_hierarchy[1] },
+	[7] = { /* sentinel */ }
+};
+
 static struct of_device_id __initdata rockchip_dtpm_match_table[] = {
         { .compatible = "rockchip,rk3399", .data = rk3399_hierarchy },
+        { .compatible = "rockchip,rk3568", .data = rk3568_hierarchy },
         {},
 };
 
@@ -8,12 +8,15 @@
 
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/debugfs.h>
 #include <linux/err.h>
+#include <linux/ktime.h>
 #include <linux/mfd/syscon.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/regmap.h>
 #include <linux/regulator/consumer.h>
+#include <linux/seq_file.h>
 
 #define MAX_SUPPLIES		16
 
@@ -66,6 +69,13 @@ struct rockchip_iodomain_supply {
 	struct regulator *reg;
 	struct notifier_block nb;
 	int idx;
+
+	/* statistics, updated from the serialized regulator notifier */
+	unsigned int switches;
+	ktime_t pre_time;
+	s64 write_max_ns;
+	s64 switch_last_ns;
+	s64 switch_max_ns;
 };
 
 struct rockchip_iodomain_soc_data {
@@ -81,6 +91,7 @@ struct rockchip_iodomain {
 	const struct rockchip_iodomain_soc_data *soc_data;
 	struct rockchip_iodomain_supply supplies[MAX_SUPPLIES];
 	int (*write)(struct rockchip_iodomain_supply *supply, int uV);
+	struct dentry *debugfs;
 };
 
 static int rk3568_iodomain_write(struct rockchip_iodomain_supply *supply, int uV)
@@ -151,6 +162,8 @@ static int rockchip_iodomain_notify(struct notifier_block *nb,
 {
 	struct rockchip_iodomain_supply *supply =
 			container_of(nb, struct rockchip_iodomain_supply, nb);
+	ktime_t start;
+	s64 delta;
 	int uV;
 	int ret;
 
@@ -187,7 +200,24 @@ static int rockchip_iodomain_notify(struct notifier_block *nb,
 			return NOTIFY_BAD;
 	}
 
+	start = ktime_get();
 	ret = supply->iod->write(supply, uV);
+	delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+	supply->write_max_ns = max(supply->write_max_ns, delta);
+
+	/* Time the regulator took between the pre and post notifications */
+	if (event & REGULATOR_EVENT_PRE_VOLTAGE_CHANGE) {
+		supply->pre_time = start;
+	} else {
+		if ((event & REGULATOR_EVENT_VOLTAGE_CHANGE) && supply->pre_time) {
+			delta = ktime_to_ns(ktime_sub(start, supply->pre_time));
+			supply->switch_last_ns = delta;
+			supply->switch_max_ns = max(supply->switch_max_ns, delta);
+			supply->switches++;
+		}
+		supply->pre_time = 0;
+	}
+
 	if (ret && event == REGULATOR_EVENT_PRE_VOLTAGE_CHANGE)
 		return NOTIFY_BAD;
 
@@ -195,6 +225,35 @@ static int rockchip_iodomain_notify(struct notifier_block *nb,
 	return NOTIFY_OK;
 }
 
+/*
+ * Per supply number of voltage switches, the duration of the last and the
+ * longest one as seen between the regulator's pre and post change
+ * notifications, and the longest time spent updating the GRF.
+ */
+static int rockchip_iodomain_stats_show(struct seq_file *s, void *data)
+{
+	struct rockchip_iodomain *iod = dev_get_drvdata(s->private);
+	int i;
+
+	seq_printf(s, "%-12s %8s %12s %12s %12s\n", "supply", "switches",
+		   "last_us", "max_us", "grf_max_ns");
+
+	for (i = 0; i < MAX_SUPPLIES; i++) {
+		struct rockchip_iodomain_supply *supply = &iod->supplies[i];
+
+		if (!supply->reg)
+			continue;
+
+		seq_printf(s, "%-12s %8u %12lld %12lld %12lld\n",
+			   iod->soc_data->supply_names[i], supply->switches,
+			   div_s64(supply->switch_last_ns, NSEC_PER_USEC),
+			   div_s64(supply->switch_max_ns, NSEC_PER_USEC),
+			   supply->write_max_ns);
+	}
+
+	return 0;
+}
+
 static void px30_iodomain_init(struct rockchip_iodomain *iod)
 {
 	int ret;
@@ -713,6 +772,10 @@ static int rockchip_iodomain_probe(struct platform_device *pdev)
 	if (iod->soc_data->init)
 		iod->soc_data->init(iod);
 
+	iod->debugfs = debugfs_create_dir(dev_name(iod->dev), NULL);
+	debugfs_create_devm_seqfile(iod->dev, "stats", iod->debugfs,
+				    rockchip_iodomain_stats_show);
+
 	return 0;
 
 unreg_notify:
@@ -732,6 +795,8 @@ static void rockchip_iodomain_remove(struct platform_device *pdev)
 	struct rockchip_iodomain *iod = platform_get_drvdata(pdev);
 	int i;
 
+	debugfs_remove_recursive(iod->debugfs);
+
 	for (i = MAX_SUPPLIES - 1; i >= 0; i--) {
 		struct rockchip_iodomain_supply *io_supply = &iod->supplies[i];
 
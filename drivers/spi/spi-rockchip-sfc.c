@@ -17,6 +17,7 @@
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/interrupt.h>
 #include <linux/spi/spi-mem.h>
@@ -161,6 +162,12 @@
  */
 #define SFC_MAX_IOSIZE_VER3		(512 * 31)
 
+/* VER4+ has a 32-bit length register, limit DMA straight to the caller's
+ * buffer to 1MB per op to stay well within the 2s transfer timeout even
+ * at low single-line clock rates.
+ */
+#define SFC_MAX_IOSIZE_DMA_DIRECT	SZ_1M
+
 /* DMA is only enabled for large data transmission */
 #define SFC_DMA_TRANS_THRETHOLD		(0x40)
 
@@ -445,24 +452,60 @@ static int rockchip_sfc_xfer_data_poll(struct rockchip_sfc *sfc,
 		return rockchip_sfc_read_fifo(sfc, op->data.buf.in, len);
 }
 
+/*
+ * The SFC DMA master takes a single word aligned address, so only linearly
+ * mapped buffers can be handed to it directly. vmalloc'ed or unaligned
+ * buffers go through the coherent bounce buffer.
+ */
+static bool rockchip_sfc_can_dma_direct(const void *buf, u32 len)
+{
+	return virt_addr_valid(buf) && IS_ALIGNED((unsigned long)buf | len, 4);
+}
+
 static int rockchip_sfc_xfer_data_dma(struct rockchip_sfc *sfc,
 				      const struct spi_mem_op *op, u32 len)
 {
+	enum dma_data_direction dir;
+	dma_addr_t dma_buf;
+	bool direct;
+	void *buf;
 	int ret;
 
 	dev_dbg(sfc->dev, "sfc xfer_dma len=%x\n", len);
 
-	if (op->data.dir == SPI_MEM_DATA_OUT)
-		memcpy(sfc->buffer, op->data.buf.out, len);
+	if (op->data.dir == SPI_MEM_DATA_OUT) {
+		buf = (void *)op->data.buf.out;
+		dir = DMA_TO_DEVICE;
+	} else {
+		buf = op->data.buf.in;
+		dir = DMA_FROM_DEVICE;
+	}
 
-	ret = rockchip_sfc_fifo_transfer_dma(sfc, sfc->dma_buffer, len);
+	direct = rockchip_sfc_can_dma_direct(buf, len);
+	if (direct) {
+		dma_buf = dma_map_single(sfc->dev, buf, len, dir);
+		if (dma_mapping_error(sfc->dev, dma_buf))
+			return -ENOMEM;
+	} else {
+		if (len > sfc->max_iosize)
+			return -EINVAL;
+
+		dma_buf = sfc->dma_buffer;
+		if (op->data.dir == SPI_MEM_DATA_OUT)
+			memcpy(sfc->buffer, buf, len);
+	}
+
+	ret = rockchip_sfc_fifo_transfer_dma(sfc, dma_buf, len);
 	if (!wait_for_completion_timeout(&sfc->cp, msecs_to_jiffies(2000))) {
 		dev_err(sfc->dev, "DMA wait for transfer finish timeout\n");
 		ret = -ETIMEDOUT;
 	}
 	rockchip_sfc_irq_mask(sfc, SFC_IMR_DMA);
-	if (op->data.dir == SPI_MEM_DATA_IN)
-		memcpy(op->data.buf.in, sfc->buffer, len);
+
+	if (direct)
+		dma_unmap_single(sfc->dev, dma_buf, len, dir);
+	else if (op->data.dir == SPI_MEM_DATA_IN)
+		memcpy(buf, sfc->buffer, len);
 
 	return ret;
 }
@@ -524,6 +567,24 @@ static int rockchip_sfc_exec_mem_op(struct spi_mem *mem, const struct spi_mem_op
 static int rockchip_sfc_adjust_op_size(struct spi_mem *mem, struct spi_mem_op *op)
 {
 	struct rockchip_sfc *sfc = spi_controller_get_devdata(mem->spi->controller);
+	u32 len;
+
+	/*
+	 * Large linear buffers can be DMA'ed to directly, so let those go
+	 * beyond the bounce buffer size where the length register allows it.
+	 */
+	if (sfc->use_dma && sfc->version >= SFC_VER_4 &&
+	    op->data.nbytes > sfc->max_iosize) {
+		len = min_t(size_t, op->data.nbytes,
+			    min_t(size_t, SFC_MAX_IOSIZE_DMA_DIRECT,
+				  dma_max_mapping_size(sfc->dev)));
+		len = ALIGN_DOWN(len, 4);
+		if (rockchip_sfc_can_dma_direct(op->data.buf.in, len)) {
+			op->data.nbytes = len;
+
+			return 0;
+		}
+	}
 
 	op->data.nbytes = min(op->data.nbytes, sfc->max_iosize);
 
@@ -7,6 +7,7 @@
 #include <linux/clk.h>
 #include <linux/dmaengine.h>
 #include <linux/interrupt.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/pinctrl/consumer.h>
@@ -166,6 +167,14 @@
 
 #define ROCKCHIP_AUTOSUSPEND_TIMEOUT		2000
 
+/* Timeout for a transfer run in polling mode, ms */
+#define ROCKCHIP_SPI_POLL_TIMEOUT		5
+
+static unsigned int polling_limit_us = 30;
+module_param(polling_limit_us, uint, 0664);
+MODULE_PARM_DESC(polling_limit_us,
+		 "time in us to run a transfer fitting the FIFO in polling mode");
+
 struct rockchip_spi {
 	struct device *dev;
 
@@ -317,6 +326,22 @@ static void rockchip_spi_pio_writer(struct rockchip_spi *rs)
 	}
 }
 
+static void rockchip_spi_pio_read_words(struct rockchip_spi *rs, u32 words)
+{
+	for (; words; words--) {
+		u32 rxw = readl_relaxed(rs->regs + ROCKCHIP_SPI_RXDR);
+
+		if (!rs->rx)
+			continue;
+
+		if (rs->n_bytes == 1)
+			*(u8 *)rs->rx = (u8)rxw;
+		else
+			*(u16 *)rs->rx = (u16)rxw;
+		rs->rx += rs->n_bytes;
+	}
+}
+
 static void rockchip_spi_pio_reader(struct rockchip_spi *rs)
 {
 	u32 words = readl_relaxed(rs->regs + ROCKCHIP_SPI_RXFLR);
@@ -337,18 +362,7 @@ static void rockchip_spi_pio_reader(struct rockchip_spi *rs)
 	}
 
 	rs->rx_left = rx_left;
-	for (; words; words--) {
-		u32 rxw = readl_relaxed(rs->regs + ROCKCHIP_SPI_RXDR);
-
-		if (!rs->rx)
-			continue;
-
-		if (rs->n_bytes == 1)
-			*(u8 *)rs->rx = (u8)rxw;
-		else
-			*(u16 *)rs->rx = (u16)rxw;
-		rs->rx += rs->n_bytes;
-	}
+	rockchip_spi_pio_read_words(rs, words);
 }
 
 static irqreturn_t rockchip_spi_isr(int irq, void *dev_id)
@@ -404,6 +418,70 @@ static int rockchip_spi_prepare_irq(struct rockchip_spi *rs,
 	return 1;
 }
 
+/*
+ * For short transfers fitting the FIFO, the interrupt and the context
+ * switches it implies cost more than the transfer itself, so just fill
+ * the FIFO and spin until everything has been clocked back in.
+ */
+static int rockchip_spi_poll_transfer(struct rockchip_spi *rs,
+				      struct spi_transfer *xfer)
+{
+	unsigned long timeout;
+	u32 words;
+	int ret = 0;
+
+	rs->tx = xfer->tx_buf;
+	rs->rx = xfer->rx_buf;
+	rs->tx_left = rs->tx ? xfer->len / rs->n_bytes : 0;
+	rs->rx_left = xfer->len / rs->n_bytes;
+
+	writel_relaxed(0xffffffff, rs->regs + ROCKCHIP_SPI_ICR);
+
+	spi_enable_chip(rs, true);
+
+	if (rs->tx_left)
+		rockchip_spi_pio_writer(rs);
+
+	timeout = jiffies + msecs_to_jiffies(ROCKCHIP_SPI_POLL_TIMEOUT);
+	while (rs->rx_left) {
+		words = min(readl_relaxed(rs->regs + ROCKCHIP_SPI_RXFLR),
+			    rs->rx_left);
+		if (words) {
+			rs->rx_left -= words;
+			rockchip_spi_pio_read_words(rs, words);
+			continue;
+		}
+
+		if (time_after(jiffies, timeout)) {
+			dev_err(rs->dev, "polling transfer timed out\n");
+			ret = -ETIMEDOUT;
+			break;
+		}
+
+		cpu_relax();
+	}
+
+	spi_enable_chip(rs, false);
+
+	return ret;
+}
+
+static bool rockchip_spi_can_poll(struct rockchip_spi *rs,
+				  struct spi_controller *ctlr,
+				  struct spi_transfer *xfer)
+{
+	u64 xfer_us;
+
+	if (ctlr->target || !polling_limit_us || !xfer->speed_hz ||
+	    xfer->len / rs->n_bytes > rs->fifo_len)
+		return false;
+
+	xfer_us = div_u64((u64)xfer->len * BITS_PER_BYTE * USEC_PER_SEC,
+			  xfer->speed_hz);
+
+	return xfer_us <= polling_limit_us;
+}
+
 static void rockchip_spi_dma_rxcb(void *data)
 {
 	struct spi_controller *ctlr = data;
@@ -709,6 +787,9 @@ static int rockchip_spi_transfer_one(
 	if (use_dma)
 		return rockchip_spi_prepare_dma(rs, ctlr, xfer);
 
+	if (rockchip_spi_can_poll(rs, ctlr, xfer))
+		return rockchip_spi_poll_transfer(rs, xfer);
+
 	return rockchip_spi_prepare_irq(rs, ctlr, xfer);
 }
 
@@ -9,6 +9,7 @@
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
 #include <linux/of_irq.h>
@@ -72,6 +73,8 @@ struct chip_tsadc_table {
  * @tshut_temp: the hardware-controlled shutdown temperature value
  * @tshut_mode: the hardware-controlled shutdown mode (0:CRU 1:GPIO)
  * @tshut_polarity: the hardware-controlled active polarity (0:LOW 1:HIGH)
+ * @alarm_step: if non-zero, arm the alarm at most this many millicelsius
+ *		above the current temperature rather than at the next trip
  * @initialize: SoC special initialize tsadc controller method
  * @irq_ack: clear the interrupt
  * @control: enable/disable method for the tsadc controller
@@ -91,6 +94,9 @@ struct rockchip_tsadc_chip {
 	enum tshut_mode tshut_mode;
 	enum tshut_polarity tshut_polarity;
 
+	/* The alarm interrupt granularity below the next trip point */
+	int alarm_step;
+
 	/* Chip-wide methods */
 	void (*initialize)(struct regmap *grf,
 			   void __iomem *reg, enum tshut_polarity p);
@@ -115,11 +121,15 @@ struct rockchip_tsadc_chip {
  * @thermal:  pointer to the platform/configuration data
  * @tzd: pointer to a thermal zone
  * @id: identifier of the thermal sensor
+ * @alarm_lock: serializes arming the alarm
+ * @trip_high: the high trip last passed to set_trips
  */
 struct rockchip_thermal_sensor {
 	struct rockchip_thermal_data *thermal;
 	struct thermal_zone_device *tzd;
 	int id;
+	struct mutex alarm_lock;
+	int trip_high;
 };
 
 /**
@@ -1268,6 +1278,8 @@ static const struct rockchip_tsadc_chip rk3568_tsadc_data = {
 	.tshut_polarity = TSHUT_LOW_ACTIVE, /* default TSHUT LOW ACTIVE */
 	.tshut_temp = 95000,
 
+	.alarm_step = 2000,
+
 	.initialize = rk_tsadcv7_initialize,
 	.irq_ack = rk_tsadcv3_irq_ack,
 	.control = rk_tsadcv3_control,
@@ -1361,6 +1373,30 @@ rockchip_thermal_toggle_sensor(struct rockchip_thermal_sensor *sensor, bool on)
 		thermal_zone_device_disable(tzd);
 }
 
+static int rockchip_thermal_arm_alarm(struct rockchip_thermal_sensor *sensor)
+{
+	struct rockchip_thermal_data *thermal = sensor->thermal;
+	const struct rockchip_tsadc_chip *tsadc = thermal->chip;
+	int high = sensor->trip_high;
+	int temp;
+
+	lockdep_assert_held(&sensor->alarm_lock);
+
+	/*
+	 * The TSADC only has a high temperature comparator, so with trips
+	 * set far apart the zone is only re-evaluated by polling while the
+	 * temperature climbs towards the next trip. Where the chip asks for
+	 * it, arm the alarm a small step above the current temperature so
+	 * the governor sees every step of the rise as an interrupt.
+	 */
+	if (tsadc->alarm_step && high != INT_MAX &&
+	    !tsadc->get_temp(&tsadc->table, sensor->id, thermal->regs, &temp))
+		high = min(high, temp + tsadc->alarm_step);
+
+	return tsadc->set_alarm_temp(&tsadc->table,
+				     sensor->id, thermal->regs, high);
+}
+
 static irqreturn_t rockchip_thermal_alarm_irq_thread(int irq, void *dev)
 {
 	struct rockchip_thermal_data *thermal = dev;
@@ -1370,10 +1406,24 @@ static irqreturn_t rockchip_thermal_alarm_irq_thread(int irq, void *dev)
 
 	thermal->chip->irq_ack(thermal->regs);
 
-	for (i = 0; i < thermal->chip->chn_num; i++)
-		thermal_zone_device_update(thermal->sensors[i].tzd,
+	for (i = 0; i < thermal->chip->chn_num; i++) {
+		struct rockchip_thermal_sensor *sensor = &thermal->sensors[i];
+
+		thermal_zone_device_update(sensor->tzd,
 					   THERMAL_EVENT_UNSPECIFIED);
 
+		/*
+		 * The trip window rarely changes between two steps, and the
+		 * core doesn't call set_trips for an unchanged window, so move
+		 * the stepped alarm up from here.
+		 */
+		if (thermal->chip->alarm_step) {
+			mutex_lock(&sensor->alarm_lock);
+			rockchip_thermal_arm_alarm(sensor);
+			mutex_unlock(&sensor->alarm_lock);
+		}
+	}
+
 	return IRQ_HANDLED;
 }
 
@@ -1381,13 +1431,17 @@ static int rockchip_thermal_set_trips(struct thermal_zone_device *tz, int low, i
 {
 	struct rockchip_thermal_sensor *sensor = thermal_zone_device_priv(tz);
 	struct rockchip_thermal_data *thermal = sensor->thermal;
-	const struct rockchip_tsadc_chip *tsadc = thermal->chip;
+	int ret;
 
 	dev_dbg(&thermal->pdev->dev, "%s: sensor %d: low: %d, high %d\n",
 		__func__, sensor->id, low, high);
 
-	return tsadc->set_alarm_temp(&tsadc->table,
-				     sensor->id, thermal->regs, high);
+	mutex_lock(&sensor->alarm_lock);
+	sensor->trip_high = high;
+	ret = rockchip_thermal_arm_alarm(sensor);
+	mutex_unlock(&sensor->alarm_lock);
+
+	return ret;
 }
 
 static int rockchip_thermal_get_temp(struct thermal_zone_device *tz, int *out_temp)
@@ -1489,6 +1543,8 @@ rockchip_thermal_register_sensor(struct platform_device *pdev,
 
 	sensor->thermal = thermal;
 	sensor->id = id;
+	sensor->trip_high = INT_MAX;
+	mutex_init(&sensor->alarm_lock);
 	sensor->tzd = devm_thermal_of_zone_register(&pdev->dev, id, sensor,
 						    &rockchip_of_thermal_ops);
 	if (IS_ERR(sensor->tzd)) {
@@ -1688,6 +1744,7 @@ static struct platform_driver rockchip_thermal_driver = {
 		.name = "rockchip-thermal",
 		.pm = &rockchip_thermal_pm_ops,
 		.of_match_table = of_rockchip_thermal_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = rockchip_thermal_probe,
 	.remove_new = rockchip_thermal_remove,
@@ -12,6 +12,7 @@
 #include <linux/clk.h>
 #include <linux/delay.h>
 #include <linux/device.h>
+#include <linux/hrtimer.h>
 #include <linux/io.h>
 #include <linux/mod_devicetable.h>
 #include <linux/module.h>
@@ -20,7 +21,9 @@
 #include <linux/pm_runtime.h>
 #include <linux/property.h>
 #include <linux/reset.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
+#include <linux/tty_flip.h>
 #include <linux/workqueue.h>
 
 #include <asm/byteorder.h>
@@ -56,6 +59,12 @@
 #define DW_UART_QUIRK_IS_DMA_FC		BIT(3)
 #define DW_UART_QUIRK_APMC0D08		BIT(4)
 #define DW_UART_QUIRK_CPR_VALUE		BIT(5)
+#define DW_UART_QUIRK_RX_DMA_CYCLIC	BIT(6)
+
+#define DW_UART_RX_RING_SIZE		SZ_16K
+#define DW_UART_RX_RING_PERIODS		4
+/* Shortest idle timer period, and so the worst RX latency while streaming */
+#define DW_UART_RX_IDLE_MIN_NS		NSEC_PER_MSEC
 
 struct dw8250_platform_data {
 	u8 usr_reg;
@@ -75,6 +84,11 @@ struct dw8250_data {
 	struct work_struct	clk_work;
 	struct reset_control	*rst;
 
+	/* Read position in the cyclic RX DMA ring */
+	unsigned int		rx_pos;
+	bool			rx_moved;
+	struct hrtimer		rx_idle_timer;
+
 	unsigned int		skip_autocfg:1;
 	unsigned int		uart_16550_compatible:1;
 };
@@ -274,9 +288,10 @@ static int dw8250_handle_irq(struct uart_port *p)
 	 * fire forever.
 	 *
 	 * This problem has only been observed so far when not in DMA mode
-	 * so we limit the workaround only to non-DMA mode.
+	 * so we limit the workaround only to non-DMA mode, which includes
+	 * the time the cyclic RX ring is stopped.
 	 */
-	if (!up->dma && rx_timeout) {
+	if ((!up->dma || !up->dma->rx_running) && rx_timeout) {
 		uart_port_lock_irqsave(p, &flags);
 		status = serial_lsr_in(up);
 
@@ -457,6 +472,192 @@ static void dw8250_prepare_rx_dma(struct uart_8250_port *p)
 	dw8250_writel_ext(up, RZN1_UART_RDMACR, val);
 }
 
+/*
+ * Hand everything the DMA engine has written to the ring since the last call
+ * over to the tty layer. Must be called with the port lock held.
+ */
+static void dw8250_rx_dma_cyclic_push(struct uart_8250_port *up)
+{
+	struct dw8250_data *d = to_dw8250_data(up->port.private_data);
+	struct tty_port *tport = &up->port.state->port;
+	struct uart_8250_dma *dma = up->dma;
+	struct dma_tx_state state;
+	unsigned int head;
+	int count = 0;
+
+	dmaengine_tx_status(dma->rxchan, dma->rx_cookie, &state);
+	head = (dma->rx_size - state.residue) % dma->rx_size;
+
+	if (head < d->rx_pos) {
+		count += tty_insert_flip_string(tport, dma->rx_buf + d->rx_pos,
+						dma->rx_size - d->rx_pos);
+		d->rx_pos = 0;
+	}
+
+	if (head > d->rx_pos) {
+		count += tty_insert_flip_string(tport, dma->rx_buf + d->rx_pos,
+						head - d->rx_pos);
+		d->rx_pos = head;
+	}
+
+	if (count) {
+		d->rx_moved = true;
+		up->port.icount.rx += count;
+		tty_flip_buffer_push(tport);
+	}
+}
+
+/*
+ * Stop the cyclic transfer, which the pl330 cannot resume, once the ring is
+ * pushed up to where it stopped, so that the FIFO can be read by PIO without
+ * racing the DMA. Data available interrupts are unmasked again, the next one
+ * starts a new ring. Must be called with the port lock held.
+ */
+static void dw8250_rx_dma_cyclic_stop(struct uart_8250_port *up)
+{
+	struct uart_8250_dma *dma = up->dma;
+
+	dmaengine_pause(dma->rxchan);
+	dw8250_rx_dma_cyclic_push(up);
+	dmaengine_terminate_async(dma->rxchan);
+	dma->rx_running = 0;
+
+	up->ier |= UART_IER_RDI;
+	serial_port_out(&up->port, UART_IER, up->ier);
+}
+
+static void dw8250_rx_dma_cyclic_complete(void *param)
+{
+	struct uart_8250_port *up = param;
+	unsigned long flags;
+
+	uart_port_lock_irqsave(&up->port, &flags);
+	if (up->dma->rx_running)
+		dw8250_rx_dma_cyclic_push(up);
+	uart_port_unlock_irqrestore(&up->port, flags);
+}
+
+/*
+ * The line is idle once a FIFO's worth of frames went by without any data.
+ * At high rates that is only a few bursts of the RX trigger level, so the
+ * timer is not run faster than DW_UART_RX_IDLE_MIN_NS: at 3 Mbaud that is
+ * one wakeup per ~300 bytes rather than one interrupt per 32.
+ */
+static ktime_t dw8250_rx_idle_timeout(struct uart_port *p)
+{
+	u64 ns = (u64)READ_ONCE(p->frame_time) * p->fifosize;
+
+	return ns_to_ktime(max_t(u64, ns, DW_UART_RX_IDLE_MIN_NS));
+}
+
+/*
+ * With data available interrupts masked, this is what notices that the line
+ * went idle: pending data is pushed every period, and a period without any
+ * stops the ring and reads the bytes short of a DMA burst from the FIFO.
+ */
+static enum hrtimer_restart dw8250_rx_idle_timer(struct hrtimer *t)
+{
+	struct dw8250_data *d = container_of(t, struct dw8250_data,
+					     rx_idle_timer);
+	struct uart_8250_port *up = serial8250_get_port(d->data.line);
+	enum hrtimer_restart ret = HRTIMER_NORESTART;
+	unsigned long flags;
+	u16 lsr;
+
+	uart_port_lock_irqsave(&up->port, &flags);
+
+	if (!up->dma->rx_running)
+		goto out;
+
+	d->rx_moved = false;
+	dw8250_rx_dma_cyclic_push(up);
+	if (d->rx_moved) {
+		hrtimer_forward_now(t, dw8250_rx_idle_timeout(&up->port));
+		ret = HRTIMER_RESTART;
+		goto out;
+	}
+
+	dw8250_rx_dma_cyclic_stop(up);
+	lsr = serial_lsr_in(up);
+	if (lsr & (UART_LSR_DR | UART_LSR_BI))
+		serial8250_rx_chars(up, lsr);
+
+out:
+	uart_port_unlock_irqrestore(&up->port, flags);
+
+	return ret;
+}
+
+/*
+ * Instead of one transfer per burst of received data, keep a cyclic transfer
+ * running into a ring for as long as data keeps coming. It is started by a
+ * data available or receive timeout interrupt, after which both are masked,
+ * as they share their enable bit: completed periods are pushed from the DMA
+ * callback, and the idle timer above pushes partial ones and stops the ring
+ * once the line is quiet. A line status interrupt makes the 8250 core call
+ * the flush hook below, which also stops the ring before the core reads the
+ * FIFO. Transmit and modem status interrupts are not affected.
+ */
+static int dw8250_rx_dma_cyclic(struct uart_8250_port *up)
+{
+	struct dw8250_data *d = to_dw8250_data(up->port.private_data);
+	struct uart_8250_dma *dma = up->dma;
+	struct dma_async_tx_descriptor *desc;
+
+	if (dma->rx_running)
+		return 0;
+
+	desc = dmaengine_prep_dma_cyclic(dma->rxchan, dma->rx_addr,
+					 dma->rx_size,
+					 dma->rx_size / DW_UART_RX_RING_PERIODS,
+					 DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT);
+	if (!desc)
+		return -EBUSY;
+
+	d->rx_pos = 0;
+	dma->rx_running = 1;
+	desc->callback = dw8250_rx_dma_cyclic_complete;
+	desc->callback_param = up;
+
+	dma->rx_cookie = dmaengine_submit(desc);
+	dma_async_issue_pending(dma->rxchan);
+
+	up->ier &= ~UART_IER_RDI;
+	serial_port_out(&up->port, UART_IER, up->ier);
+
+	hrtimer_start(&d->rx_idle_timer, dw8250_rx_idle_timeout(&up->port),
+		      HRTIMER_MODE_REL);
+
+	return 0;
+}
+
+static void dw8250_rx_dma_cyclic_flush(struct uart_8250_port *up)
+{
+	if (up->dma->rx_running)
+		dw8250_rx_dma_cyclic_stop(up);
+}
+
+static void dw8250_cyclic_shutdown(struct uart_port *p)
+{
+	struct uart_8250_port *up = up_to_u8250p(p);
+	struct dw8250_data *d = to_dw8250_data(p->private_data);
+	unsigned long flags;
+
+	/*
+	 * No interrupt can start a new ring once IER is cleared, stop the idle
+	 * timer before the core releases the DMA channels under it.
+	 */
+	uart_port_lock_irqsave(p, &flags);
+	up->ier = 0;
+	serial_port_out(p, UART_IER, 0);
+	uart_port_unlock_irqrestore(p, flags);
+
+	synchronize_irq(p->irq);
+	hrtimer_cancel(&d->rx_idle_timer);
+
+	serial8250_do_shutdown(p);
+}
+
 static void dw8250_quirks(struct uart_port *p, struct dw8250_data *data)
 {
 	unsigned int quirks = data->pdata ? data->pdata->quirks : 0;
@@ -491,6 +692,17 @@ static void dw8250_quirks(struct uart_port *p, struct dw8250_data *data)
 		p->serial_in = dw8250_serial_in32;
 		data->uart_16550_compatible = true;
 	}
+	if (quirks & DW_UART_QUIRK_RX_DMA_CYCLIC) {
+		data->data.dma.rx_size = DW_UART_RX_RING_SIZE;
+		data->data.dma.rx_dma = dw8250_rx_dma_cyclic;
+		data->data.dma.rx_dma_flush = dw8250_rx_dma_cyclic_flush;
+		/* Only RX is moved to DMA, transmit keeps using THRE */
+		data->data.dma.rx_only = 1;
+		hrtimer_init(&data->rx_idle_timer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL);
+		data->rx_idle_timer.function = dw8250_rx_idle_timer;
+		p->shutdown = dw8250_cyclic_shutdown;
+	}
 
 	/* Platforms with iDMA 64-bit */
 	if (platform_get_resource_byname(to_platform_device(p->dev),
@@ -641,7 +853,11 @@ static int dw8250_probe(struct platform_device *pdev)
 		data->data.dma.txconf.dst_maxburst = p->fifosize / 4;
 		up->dma = &data->data.dma;
 	}
-	up->dma=NULL;
+
+	/* Only the cyclic RX mode uses DMA, TX and other ports stay on PIO */
+	if (!(data->pdata && data->pdata->quirks & DW_UART_QUIRK_RX_DMA_CYCLIC))
+		up->dma = NULL;
+
 	p->rs485_config = serial8250_em485_config;
 	up->rs485_start_tx = serial8250_em485_start_tx;
 	up->rs485_stop_tx = serial8250_em485_stop_tx;
@@ -754,6 +970,11 @@ static const struct dw8250_platform_data dw8250_renesas_rzn1_data = {
 	.quirks = DW_UART_QUIRK_CPR_VALUE | DW_UART_QUIRK_IS_DMA_FC,
 };
 
+static const struct dw8250_platform_data dw8250_rockchip_data = {
+	.usr_reg = DW_UART_USR,
+	.quirks = DW_UART_QUIRK_RX_DMA_CYCLIC,
+};
+
 static const struct dw8250_platform_data dw8250_skip_set_rate_data = {
 	.usr_reg = DW_UART_USR,
 	.quirks = DW_UART_QUIRK_SKIP_SET_RATE,
@@ -764,6 +985,7 @@ static const struct of_device_id dw8250_of_match[] = {
 	{ .compatible = "cavium,octeon-3860-uart", .data = &dw8250_octeon_3860_data },
 	{ .compatible = "marvell,armada-38x-uart", .data = &dw8250_armada_38x_data },
 	{ .compatible = "renesas,rzn1-uart", .data = &dw8250_renesas_rzn1_data },
+	{ .compatible = "rockchip,rk3568-uart", .data = &dw8250_rockchip_data },
 	{ .compatible = "sophgo,sg2044-uart", .data = &dw8250_skip_set_rate_data },
 	{ .compatible = "starfive,jh7100-uart", .data = &dw8250_skip_set_rate_data },
 	{ /* Sentinel */ }
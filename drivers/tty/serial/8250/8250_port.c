@@ -1518,7 +1518,7 @@ static inline void __start_tx(struct uart_port *port)
 {
 	struct uart_8250_port *up = up_to_u8250p(port);
 
-	if (up->dma && !up->dma->tx_dma(up))
+	if (up->dma && !up->dma->rx_only && !up->dma->tx_dma(up))
 		return;
 
 	if (serial8250_set_THRI(up)) {
@@ -1928,7 +1928,7 @@ int serial8250_handle_irq(struct uart_port *port, unsigned int iir)
 	}
 	serial8250_modem_status(up);
 	if ((status & UART_LSR_THRE) && (up->ier & UART_IER_THRI)) {
-		if (!up->dma || up->dma->tx_err)
+		if (!up->dma || up->dma->rx_only || up->dma->tx_err)
 			serial8250_tx_chars(up);
 		else if (!up->dma->tx_running)
 			__stop_tx(up);
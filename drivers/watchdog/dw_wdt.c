@@ -92,6 +92,11 @@ struct dw_wdt {
 	u32			control;
 	u32			timeout;
 
+	/* Pre-timeout IRQ, kept disabled from when it fires until the ping */
+	int			irq;
+	spinlock_t		irq_lock;
+	bool			irq_masked;
+
 #ifdef CONFIG_DEBUG_FS
 	struct dentry		*dbgfs_dir;
 #endif
@@ -188,10 +193,19 @@ static unsigned int dw_wdt_get_timeout(struct dw_wdt *dw_wdt)
 static int dw_wdt_ping(struct watchdog_device *wdd)
 {
 	struct dw_wdt *dw_wdt = to_dw_wdt(wdd);
+	unsigned long flags;
 
 	writel(WDOG_COUNTER_RESTART_KICK_VALUE, dw_wdt->regs +
 	       WDOG_COUNTER_RESTART_REG_OFFSET);
 
+	/* The kick cleared the pre-timeout IRQ, let the next one through */
+	spin_lock_irqsave(&dw_wdt->irq_lock, flags);
+	if (dw_wdt->irq_masked) {
+		dw_wdt->irq_masked = false;
+		enable_irq(dw_wdt->irq);
+	}
+	spin_unlock_irqrestore(&dw_wdt->irq_lock, flags);
+
 	return 0;
 }
 
@@ -370,6 +384,17 @@ static irqreturn_t dw_wdt_irq(int irq, void *devid)
 	if (!val)
 		return IRQ_NONE;
 
+	/*
+	 * Where the line is level triggered, it would fire again as soon as
+	 * the handler returns, until the ping. Keep it disabled until then.
+	 */
+	spin_lock(&dw_wdt->irq_lock);
+	if (!dw_wdt->irq_masked) {
+		dw_wdt->irq_masked = true;
+		disable_irq_nosync(irq);
+	}
+	spin_unlock(&dw_wdt->irq_lock);
+
 	watchdog_notify_pretimeout(&dw_wdt->wdd);
 
 	return IRQ_HANDLED;
@@ -601,8 +626,10 @@ static int dw_wdt_drv_probe(struct platform_device *pdev)
 	 * pending either until the next watchdog kick event or up to the
 	 * system reset.
 	 */
+	spin_lock_init(&dw_wdt->irq_lock);
 	ret = platform_get_irq_optional(pdev, 0);
 	if (ret > 0) {
+		dw_wdt->irq = ret;
 		ret = devm_request_irq(dev, ret, dw_wdt_irq,
 				       IRQF_SHARED | IRQF_TRIGGER_RISING,
 				       pdev->name, dw_wdt);
@@ -73,6 +73,31 @@ static void watchdog_set_open_deadline(struct watchdog_core_data *data)
 		ktime_get() + ktime_set(open_timeout, 0) : KTIME_MAX;
 }
 
+#if IS_ENABLED(CONFIG_WATCHDOG_PRETIMEOUT_GOV_KEEPALIVE)
+static void watchdog_gov_keepalive_pretimeout(struct watchdog_device *wdd);
+
+static struct watchdog_governor watchdog_gov_keepalive = {
+	.name		= "keepalive",
+	.pretimeout	= watchdog_gov_keepalive_pretimeout,
+};
+
+/*
+ * With the keepalive governor the hardware pretimeout interrupt queues the
+ * worker heartbeats instead of the hrtimer, so no CPU is woken up
+ * periodically just to feed the watchdog.
+ */
+static bool watchdog_keepalive_on_pretimeout(struct watchdog_device *wdd)
+{
+	return READ_ONCE(wdd->gov) == &watchdog_gov_keepalive &&
+	       (wdd->info->options & WDIOF_PRETIMEOUT) && wdd->pretimeout;
+}
+#else
+static bool watchdog_keepalive_on_pretimeout(struct watchdog_device *wdd)
+{
+	return false;
+}
+#endif
+
 static inline bool watchdog_need_worker(struct watchdog_device *wdd)
 {
 	/* All variables in milli-seconds */
@@ -121,7 +146,8 @@ static ktime_t watchdog_next_keepalive(struct watchdog_device *wdd)
 	 */
 	last_heartbeat = ktime_sub(virt_timeout, ms_to_ktime(hw_heartbeat_ms));
 	latest_heartbeat = ktime_sub(last_heartbeat, ktime_get());
-	if (ktime_before(latest_heartbeat, keepalive_interval))
+	if (ktime_before(latest_heartbeat, keepalive_interval) ||
+	    watchdog_keepalive_on_pretimeout(wdd))
 		return latest_heartbeat;
 	return keepalive_interval;
 }
@@ -214,14 +240,26 @@ static bool watchdog_worker_should_ping(struct watchdog_core_data *wd_data)
 	return watchdog_hw_running(wdd) && !watchdog_past_open_deadline(wd_data);
 }
 
+/*
+ * A heartbeat queued by a pretimeout must neither take over from userspace
+ * nor extend the watchdog beyond the time userspace asked for.
+ */
+static bool watchdog_pretimeout_may_ping(struct watchdog_device *wdd)
+{
+	return watchdog_need_worker(wdd) && watchdog_next_keepalive(wdd) >= 0;
+}
+
 static void watchdog_ping_work(struct kthread_work *work)
 {
 	struct watchdog_core_data *wd_data;
+	bool pretimeout;
 
 	wd_data = container_of(work, struct watchdog_core_data, work);
+	pretimeout = test_and_clear_bit(_WDOG_PRETIMEOUT, &wd_data->status);
 
 	mutex_lock(&wd_data->lock);
-	if (watchdog_worker_should_ping(wd_data))
+	if (watchdog_worker_should_ping(wd_data) &&
+	    (!pretimeout || watchdog_pretimeout_may_ping(wd_data->wdd)))
 		__watchdog_ping(wd_data->wdd);
 	mutex_unlock(&wd_data->lock);
 }
@@ -232,10 +270,34 @@ static enum hrtimer_restart watchdog_timer_expired(struct hrtimer *timer)
 
 	wd_data = container_of(timer, struct watchdog_core_data, timer);
 
+	clear_bit(_WDOG_PRETIMEOUT, &wd_data->status);
 	kthread_queue_work(watchdog_kworker, &wd_data->work);
 	return HRTIMER_NORESTART;
 }
 
+#if IS_ENABLED(CONFIG_WATCHDOG_PRETIMEOUT_GOV_KEEPALIVE)
+/**
+ * watchdog_gov_keepalive_pretimeout - Feed the watchdog on pretimeout event
+ * @wdd - watchdog_device
+ *
+ * Called in interrupt context. The heartbeat is left to the watchdog worker,
+ * so a system which can no longer schedule it still gets reset.
+ */
+static void watchdog_gov_keepalive_pretimeout(struct watchdog_device *wdd)
+{
+	struct watchdog_core_data *wd_data = wdd->wd_data;
+
+	/* Userspace is feeding the watchdog and it is late */
+	if (!watchdog_need_worker(wdd)) {
+		pr_alert_ratelimited("watchdog%d: pretimeout event\n", wdd->id);
+		return;
+	}
+
+	set_bit(_WDOG_PRETIMEOUT, &wd_data->status);
+	kthread_queue_work(watchdog_kworker, &wd_data->work);
+}
+#endif
+
 /*
  * watchdog_start - wrapper to start the watchdog
  * @wdd: The watchdog device to start
@@ -414,6 +476,10 @@ static int watchdog_set_pretimeout(struct watchdog_device *wdd,
 	else
 		wdd->pretimeout = timeout;
 
+	/* The pretimeout may now take over or hand back the heartbeats */
+	if (!err && watchdog_need_worker(wdd))
+		watchdog_update_worker(wdd);
+
 	return err;
 }
 
@@ -608,10 +674,16 @@ static ssize_t pretimeout_governor_store(struct device *dev,
 					 const char *buf, size_t count)
 {
 	struct watchdog_device *wdd = dev_get_drvdata(dev);
+	struct watchdog_core_data *wd_data = wdd->wd_data;
 	int ret = watchdog_pretimeout_governor_set(wdd, buf);
 
-	if (!ret)
+	if (!ret) {
+		mutex_lock(&wd_data->lock);
+		if (watchdog_need_worker(wdd))
+			watchdog_update_worker(wdd);
+		mutex_unlock(&wd_data->lock);
 		ret = count;
+	}
 
 	return ret;
 }
@@ -1248,8 +1320,20 @@ int __init watchdog_dev_init(void)
 		goto err_alloc;
 	}
 
+#if IS_ENABLED(CONFIG_WATCHDOG_PRETIMEOUT_GOV_KEEPALIVE)
+	err = watchdog_register_governor(&watchdog_gov_keepalive);
+	if (err < 0) {
+		pr_err("watchdog: unable to register keepalive governor\n");
+		goto err_gov;
+	}
+#endif
+
 	return 0;
 
+#if IS_ENABLED(CONFIG_WATCHDOG_PRETIMEOUT_GOV_KEEPALIVE)
+err_gov:
+	unregister_chrdev_region(watchdog_devt, MAX_DOGS);
+#endif
 err_alloc:
 	class_unregister(&watchdog_class);
 err_register:
@@ -1264,6 +1348,9 @@ int __init watchdog_dev_init(void)
  */
 void __exit watchdog_dev_exit(void)
 {
+#if IS_ENABLED(CONFIG_WATCHDOG_PRETIMEOUT_GOV_KEEPALIVE)
+	watchdog_unregister_governor(&watchdog_gov_keepalive);
+#endif
 	unregister_chrdev_region(watchdog_devt, MAX_DOGS);
 	class_unregister(&watchdog_class);
 	kthread_destroy_worker(watchdog_kworker);
@@ -26,11 +26,8 @@ static struct ubifs_compressor none_compr = {
 };
 
 #ifdef CONFIG_UBIFS_FS_LZO
-static DEFINE_MUTEX(lzo_mutex);
-
 static struct ubifs_compressor lzo_compr = {
 	.compr_type = UBIFS_COMPR_LZO,
-	.comp_mutex = &lzo_mutex,
 	.name = "lzo",
 	.capi_name = "lzo",
 };
@@ -42,13 +39,8 @@ static struct ubifs_compressor lzo_compr = {
 #endif
 
 #ifdef CONFIG_UBIFS_FS_ZLIB
-static DEFINE_MUTEX(deflate_mutex);
-static DEFINE_MUTEX(inflate_mutex);
-
 static struct ubifs_compressor zlib_compr = {
 	.compr_type = UBIFS_COMPR_ZLIB,
-	.comp_mutex = &deflate_mutex,
-	.decomp_mutex = &inflate_mutex,
 	.name = "zlib",
 	.capi_name = "deflate",
 };
@@ -60,13 +52,8 @@ static struct ubifs_compressor zlib_compr = {
 #endif
 
 #ifdef CONFIG_UBIFS_FS_ZSTD
-static DEFINE_MUTEX(zstd_enc_mutex);
-static DEFINE_MUTEX(zstd_dec_mutex);
-
 static struct ubifs_compressor zstd_compr = {
 	.compr_type = UBIFS_COMPR_ZSTD,
-	.comp_mutex = &zstd_enc_mutex,
-	.decomp_mutex = &zstd_dec_mutex,
 	.name = "zstd",
 	.capi_name = "zstd",
 };
@@ -77,6 +64,30 @@ static struct ubifs_compressor zstd_compr = {
 };
 #endif
 
+#ifdef CONFIG_UBIFS_FS_LZ4
+static struct ubifs_compressor lz4_compr = {
+	.compr_type = UBIFS_COMPR_LZ4,
+	.name = "lz4",
+	.capi_name = "lz4",
+};
+
+static struct ubifs_compressor lz4hc_compr = {
+	.compr_type = UBIFS_COMPR_LZ4HC,
+	.name = "lz4hc",
+	.capi_name = "lz4hc",
+};
+#else
+static struct ubifs_compressor lz4_compr = {
+	.compr_type = UBIFS_COMPR_LZ4,
+	.name = "lz4",
+};
+
+static struct ubifs_compressor lz4hc_compr = {
+	.compr_type = UBIFS_COMPR_LZ4HC,
+	.name = "lz4hc",
+};
+#endif
+
 /* All UBIFS compressors */
 struct ubifs_compressor *ubifs_compressors[UBIFS_COMPR_TYPES_CNT];
 
@@ -104,6 +115,7 @@ void ubifs_compress(const struct ubifs_info *c, const void *in_buf,
 {
 	int err;
 	struct ubifs_compressor *compr = ubifs_compressors[*compr_type];
+	struct ubifs_compr_ctx *ctx;
 
 	if (*compr_type == UBIFS_COMPR_NONE)
 		goto no_compr;
@@ -112,12 +124,11 @@ void ubifs_compress(const struct ubifs_info *c, const void *in_buf,
 	if (in_len < UBIFS_MIN_COMPR_LEN)
 		goto no_compr;
 
-	if (compr->comp_mutex)
-		mutex_lock(compr->comp_mutex);
-	err = crypto_comp_compress(compr->cc, in_buf, in_len, out_buf,
+	local_lock(&compr->ctx->lock);
+	ctx = this_cpu_ptr(compr->ctx);
+	err = crypto_comp_compress(ctx->cc, in_buf, in_len, out_buf,
 				   (unsigned int *)out_len);
-	if (compr->comp_mutex)
-		mutex_unlock(compr->comp_mutex);
+	local_unlock(&compr->ctx->lock);
 	if (unlikely(err)) {
 		ubifs_warn(c, "cannot compress %d bytes, compressor %s, error %d, leave data uncompressed",
 			   in_len, compr->name, err);
@@ -157,6 +168,7 @@ int ubifs_decompress(const struct ubifs_info *c, const void *in_buf,
 {
 	int err;
 	struct ubifs_compressor *compr;
+	struct ubifs_compr_ctx *ctx;
 
 	if (unlikely(compr_type < 0 || compr_type >= UBIFS_COMPR_TYPES_CNT)) {
 		ubifs_err(c, "invalid compression type %d", compr_type);
@@ -176,12 +188,11 @@ int ubifs_decompress(const struct ubifs_info *c, const void *in_buf,
 		return 0;
 	}
 
-	if (compr->decomp_mutex)
-		mutex_lock(compr->decomp_mutex);
-	err = crypto_comp_decompress(compr->cc, in_buf, in_len, out_buf,
+	local_lock(&compr->ctx->lock);
+	ctx = this_cpu_ptr(compr->ctx);
+	err = crypto_comp_decompress(ctx->cc, in_buf, in_len, out_buf,
 				     (unsigned int *)out_len);
-	if (compr->decomp_mutex)
-		mutex_unlock(compr->decomp_mutex);
+	local_unlock(&compr->ctx->lock);
 	if (err)
 		ubifs_err(c, "cannot decompress %d bytes, compressor %s, error %d",
 			  in_len, compr->name, err);
@@ -189,21 +200,60 @@ int ubifs_decompress(const struct ubifs_info *c, const void *in_buf,
 	return err;
 }
 
+/**
+ * compr_exit - de-initialize a compressor.
+ * @compr: compressor description object
+ */
+static void compr_exit(struct ubifs_compressor *compr)
+{
+	int cpu;
+
+	if (!compr->ctx)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct ubifs_compr_ctx *ctx = per_cpu_ptr(compr->ctx, cpu);
+
+		if (ctx->cc)
+			crypto_free_comp(ctx->cc);
+	}
+
+	free_percpu(compr->ctx);
+	compr->ctx = NULL;
+}
+
 /**
  * compr_init - initialize a compressor.
  * @compr: compressor description object
  *
  * This function initializes the requested compressor and returns zero in case
- * of success or a negative error code in case of failure.
+ * of success or a negative error code in case of failure. Each CPU gets its
+ * own cryptoapi handle, so that (de)compression runs in parallel on all CPUs
+ * instead of being serialized on a single handle.
  */
 static int __init compr_init(struct ubifs_compressor *compr)
 {
+	struct crypto_comp *cc;
+	int cpu;
+
 	if (compr->capi_name) {
-		compr->cc = crypto_alloc_comp(compr->capi_name, 0, 0);
-		if (IS_ERR(compr->cc)) {
-			pr_err("UBIFS error (pid %d): cannot initialize compressor %s, error %ld",
-			       current->pid, compr->name, PTR_ERR(compr->cc));
-			return PTR_ERR(compr->cc);
+		compr->ctx = alloc_percpu(struct ubifs_compr_ctx);
+		if (!compr->ctx)
+			return -ENOMEM;
+
+		for_each_possible_cpu(cpu) {
+			struct ubifs_compr_ctx *ctx = per_cpu_ptr(compr->ctx, cpu);
+
+			cc = crypto_alloc_comp(compr->capi_name, 0, 0);
+			if (IS_ERR(cc)) {
+				pr_err("UBIFS error (pid %d): cannot initialize compressor %s, error %ld",
+				       current->pid, compr->name, PTR_ERR(cc));
+				compr_exit(compr);
+				return PTR_ERR(cc);
+			}
+
+			local_lock_init(&ctx->lock);
+			ctx->cc = cc;
 		}
 	}
 
@@ -211,16 +261,6 @@ static int __init compr_init(struct ubifs_compressor *compr)
 	return 0;
 }
 
-/**
- * compr_exit - de-initialize a compressor.
- * @compr: compressor description object
- */
-static void compr_exit(struct ubifs_compressor *compr)
-{
-	if (compr->capi_name)
-		crypto_free_comp(compr->cc);
-}
-
 /**
  * ubifs_compressors_init - initialize UBIFS compressors.
  *
@@ -243,9 +283,21 @@ int __init ubifs_compressors_init(void)
 	if (err)
 		goto out_zstd;
 
+	err = compr_init(&lz4_compr);
+	if (err)
+		goto out_zlib;
+
+	err = compr_init(&lz4hc_compr);
+	if (err)
+		goto out_lz4;
+
 	ubifs_compressors[UBIFS_COMPR_NONE] = &none_compr;
 	return 0;
 
+out_lz4:
+	compr_exit(&lz4_compr);
+out_zlib:
+	compr_exit(&zlib_compr);
 out_zstd:
 	compr_exit(&zstd_compr);
 out_lzo:
@@ -261,4 +313,6 @@ void ubifs_compressors_exit(void)
 	compr_exit(&lzo_compr);
 	compr_exit(&zlib_compr);
 	compr_exit(&zstd_compr);
+	compr_exit(&lz4_compr);
+	compr_exit(&lz4hc_compr);
 }
@@ -699,6 +699,94 @@ static int populate_page(struct ubifs_info *c, struct folio *folio,
 	return -EINVAL;
 }
 
+/* Below this many folios, decompressing them in parallel isn't worth it */
+#define UBIFS_BU_MIN_PARALLEL 4
+
+/**
+ * struct bu_worker - a share of the folios of a bulk-read.
+ * @work: work item populating the share
+ * @c: UBIFS file-system description object
+ * @bu: bulk-read information
+ * @first: index in @bu->folios of the first folio of the share
+ * @step: distance between two folios of the share
+ */
+struct bu_worker {
+	struct work_struct work;
+	struct ubifs_info *c;
+	struct bu_info *bu;
+	int first;
+	int step;
+};
+
+static void bu_populate_share(struct ubifs_info *c, struct bu_info *bu,
+			      int first, int step)
+{
+	int i, n;
+
+	for (i = first; i < bu->folio_cnt; i += step) {
+		struct folio *folio = bu->folios[i];
+
+		/*
+		 * A folio that fails here is left !uptodate and gets read
+		 * again, node by node, through ->read_folio().
+		 */
+		n = bu->folio_zbr[i];
+		populate_page(c, folio, bu, &n);
+		folio_unlock(folio);
+		folio_put(folio);
+	}
+}
+
+static void bu_populate_work(struct work_struct *work)
+{
+	struct bu_worker *w = container_of(work, struct bu_worker, work);
+
+	bu_populate_share(w->c, w->bu, w->first, w->step);
+}
+
+/**
+ * bu_populate_folios - populate the folios collected by a bulk-read.
+ * @c: UBIFS file-system description object
+ * @bu: bulk-read information
+ *
+ * The data nodes are already in @bu->buf, so the folios don't depend on each
+ * other and are decompressed by up to one worker per online CPU, the caller
+ * taking one share itself. Returns when all of them have been unlocked.
+ */
+static void bu_populate_folios(struct ubifs_info *c, struct bu_info *bu)
+{
+	struct bu_worker *workers = NULL;
+	int i, nr = 1;
+
+	if (bu->folio_cnt >= UBIFS_BU_MIN_PARALLEL) {
+		nr = min_t(int, num_online_cpus(),
+			   bu->folio_cnt / (UBIFS_BU_MIN_PARALLEL / 2));
+		if (nr > 1)
+			workers = kmalloc_array(nr - 1, sizeof(*workers),
+						GFP_NOFS | __GFP_NOWARN);
+		if (!workers)
+			nr = 1;
+	}
+
+	for (i = 1; i < nr; i++) {
+		struct bu_worker *w = &workers[i - 1];
+
+		INIT_WORK(&w->work, bu_populate_work);
+		w->c = c;
+		w->bu = bu;
+		w->first = i;
+		w->step = nr;
+		queue_work(ubifs_bu_wq, &w->work);
+	}
+
+	bu_populate_share(c, bu, 0, nr);
+
+	for (i = 1; i < nr; i++)
+		flush_work(&workers[i - 1].work);
+
+	kfree(workers);
+}
+
 /**
  * ubifs_do_bulk_read - do bulk-read.
  * @c: UBIFS file-system description object
@@ -714,7 +802,7 @@ static int ubifs_do_bulk_read(struct ubifs_info *c, struct bu_info *bu,
 	struct address_space *mapping = folio1->mapping;
 	struct inode *inode = mapping->host;
 	struct ubifs_inode *ui = ubifs_inode(inode);
-	int err, page_idx, page_cnt, ret = 0, n = 0;
+	int err, page_idx, page_cnt, ret = 0, n = 0, nn;
 	int allocate = bu->buf ? 0 : 1;
 	loff_t isize;
 	gfp_t ra_gfp_mask = readahead_gfp_mask(mapping) & ~__GFP_FS;
@@ -773,8 +861,11 @@ static int ubifs_do_bulk_read(struct ubifs_info *c, struct bu_info *bu,
 		goto out_free;
 	end_index = ((isize - 1) >> PAGE_SHIFT);
 
+	bu->folio_cnt = 0;
+	nn = n;
 	for (page_idx = 1; page_idx < page_cnt; page_idx++) {
 		pgoff_t page_offset = offset + page_idx;
+		unsigned int page_block;
 		struct folio *folio;
 
 		if (page_offset > end_index)
@@ -784,14 +875,25 @@ static int ubifs_do_bulk_read(struct ubifs_info *c, struct bu_info *bu,
 				 ra_gfp_mask);
 		if (IS_ERR(folio))
 			break;
-		if (!folio_test_uptodate(folio))
-			err = populate_page(c, folio, bu, &n);
-		folio_unlock(folio);
-		folio_put(folio);
-		if (err)
-			break;
+		if (folio_test_uptodate(folio)) {
+			folio_unlock(folio);
+			folio_put(folio);
+			continue;
+		}
+
+		/* Skip the data nodes of the pages before this one */
+		page_block = page_offset << UBIFS_BLOCKS_PER_PAGE_SHIFT;
+		while (nn < bu->cnt &&
+		       key_block(c, &bu->zbranch[nn].key) < page_block)
+			nn += 1;
+
+		bu->folios[bu->folio_cnt] = folio;
+		bu->folio_zbr[bu->folio_cnt] = nn;
+		bu->folio_cnt += 1;
 	}
 
+	bu_populate_folios(c, bu);
+
 	ui->last_page_read = offset + page_idx - 1;
 
 out_free:
@@ -59,6 +59,7 @@
  */
 
 #include <linux/crc32.h>
+#include <linux/delay.h>
 #include <linux/slab.h>
 #include "ubifs.h"
 
@@ -1226,6 +1227,29 @@ static int wbuf_has_ino(struct ubifs_wbuf *wbuf, ino_t inum)
 	return ret;
 }
 
+/**
+ * wbuf_batch_wait - let concurrent fsyncs share a write-buffer flush.
+ * @c: UBIFS file-system description object
+ * @wbuf: write-buffer which is about to be synchronized
+ *
+ * If the write-buffer was last synchronized on behalf of another task, several
+ * tasks are likely to be fsync'ing at the same time. Give them up to
+ * @c->fsync_batch_us to add their nodes to the write-buffer, so that a single
+ * flush writes all of them out instead of each fsync padding and writing a
+ * mostly empty min. I/O unit. Whoever flushes first takes the other inodes
+ * off the write-buffer, and 'ubifs_sync_wbufs_by_inode()' then finds nothing
+ * left to do for them. A task fsync'ing on its own never waits.
+ */
+static void wbuf_batch_wait(struct ubifs_info *c, struct ubifs_wbuf *wbuf)
+{
+	unsigned int us = READ_ONCE(c->fsync_batch_us);
+
+	if (!us || READ_ONCE(wbuf->last_syncer) == current->pid)
+		return;
+
+	usleep_range(us, us + us / 4);
+}
+
 /**
  * ubifs_sync_wbufs_by_inode - synchronize write-buffers for an inode.
  * @c: UBIFS file-system description object
@@ -1254,9 +1278,13 @@ int ubifs_sync_wbufs_by_inode(struct ubifs_info *c, struct inode *inode)
 		if (!wbuf_has_ino(wbuf, inode->i_ino))
 			continue;
 
+		wbuf_batch_wait(c, wbuf);
+
 		mutex_lock_nested(&wbuf->io_mutex, wbuf->jhead);
-		if (wbuf_has_ino(wbuf, inode->i_ino))
+		if (wbuf_has_ino(wbuf, inode->i_ino)) {
 			err = ubifs_wbuf_sync_nolock(wbuf);
+			WRITE_ONCE(wbuf->last_syncer, current->pid);
+		}
 		mutex_unlock(&wbuf->io_mutex);
 
 		if (err) {
@@ -117,6 +117,18 @@ static inline const char *ubifs_compr_name(struct ubifs_info *c, int compr_type)
 	return ubifs_compressors[compr_type]->name;
 }
 
+/**
+ * ubifs_compr_is_lz4 - check if a compressor type produces LZ4 nodes.
+ * @compr_type: compressor type
+ *
+ * This function returns %1 for %UBIFS_COMPR_LZ4 and %UBIFS_COMPR_LZ4HC, which
+ * need %UBIFS_FLG_LZ4 in the superblock, and %0 otherwise.
+ */
+static inline int ubifs_compr_is_lz4(int compr_type)
+{
+	return compr_type == UBIFS_COMPR_LZ4 || compr_type == UBIFS_COMPR_LZ4HC;
+}
+
 /**
  * ubifs_wbuf_sync - synchronize write-buffer.
  * @wbuf: write-buffer to synchronize
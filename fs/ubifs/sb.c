@@ -210,6 +210,8 @@ static int create_default_filesystem(struct ubifs_info *c)
 		sup->default_compr = cpu_to_le16(c->mount_opts.compr_type);
 	else
 		sup->default_compr = cpu_to_le16(get_default_compressor(c));
+	if (ubifs_compr_is_lz4(le16_to_cpu(sup->default_compr)))
+		sup->flags |= cpu_to_le32(UBIFS_FLG_LZ4);
 
 	generate_random_uuid(sup->uuid);
 
@@ -734,6 +736,7 @@ int ubifs_read_superblock(struct ubifs_info *c)
 	c->space_fixup = !!(sup_flags & UBIFS_FLG_SPACE_FIXUP);
 	c->double_hash = !!(sup_flags & UBIFS_FLG_DOUBLE_HASH);
 	c->encrypted = !!(sup_flags & UBIFS_FLG_ENCRYPTION);
+	c->lz4 = !!(sup_flags & UBIFS_FLG_LZ4);
 
 	err = authenticate_sb_node(c, sup);
 	if (err)
@@ -753,6 +756,13 @@ int ubifs_read_superblock(struct ubifs_info *c)
 		goto out;
 	}
 
+	if (!IS_ENABLED(CONFIG_UBIFS_FS_LZ4) && c->lz4) {
+		ubifs_err(c, "file system may contain LZ4 compressed nodes but"
+			     " UBIFS was built without LZ4 support.");
+		err = -EINVAL;
+		goto out;
+	}
+
 	/* Automatically increase file system size to the maximum size */
 	if (c->leb_cnt < c->vi.size && c->leb_cnt < c->max_leb_cnt) {
 		int old_leb_cnt = c->leb_cnt;
@@ -927,6 +937,25 @@ int ubifs_fixup_free_space(struct ubifs_info *c)
 	return err;
 }
 
+/**
+ * ubifs_flag_lz4 - mark the superblock before the first LZ4 node is written.
+ * @c: UBIFS file-system description object
+ *
+ * New inodes take their compressor from @c->default_compr, so once it is LZ4
+ * or LZ4HC on a read-write mount the file system may get LZ4 nodes. Set
+ * %UBIFS_FLG_LZ4 so that kernels without LZ4 refuse the mount instead of
+ * failing on the first such node. The caller writes the superblock.
+ */
+void ubifs_flag_lz4(struct ubifs_info *c)
+{
+	if (c->lz4 || c->ro_mount || !ubifs_compr_is_lz4(c->default_compr))
+		return;
+
+	c->sup_node->flags |= cpu_to_le32(UBIFS_FLG_LZ4);
+	c->superblock_need_write = 1;
+	c->lz4 = 1;
+}
+
 int ubifs_enable_encryption(struct ubifs_info *c)
 {
 	int err;
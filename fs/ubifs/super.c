@@ -56,6 +56,9 @@ static struct kmem_cache *ubifs_inode_slab;
 /* UBIFS TNC shrinker description */
 static struct shrinker *ubifs_shrinker_info;
 
+/* Workqueue decompressing bulk-read data nodes in parallel */
+struct workqueue_struct *ubifs_bu_wq;
+
 /**
  * validate_inode - validate inode.
  * @c: UBIFS file-system description object
@@ -454,6 +457,9 @@ static int ubifs_show_options(struct seq_file *s, struct dentry *root)
 			   ubifs_compr_name(c, c->mount_opts.compr_type));
 	}
 
+	if (c->fsync_batch_us)
+		seq_printf(s, ",fsync_batch=%u", c->fsync_batch_us);
+
 	seq_printf(s, ",assert=%s", ubifs_assert_action_name(c));
 	seq_printf(s, ",ubi=%d,vol=%d", c->vi.ubi_num, c->vi.vol_id);
 
@@ -967,6 +973,7 @@ static int check_volume_empty(struct ubifs_info *c)
  * Opt_assert: set ubifs_assert() action
  * Opt_auth_key: The key name used for authentication
  * Opt_auth_hash_name: The hash type used for authentication
+ * Opt_fsync_batch: how long fsync waits to share a write-buffer flush
  * Opt_err: just end of array marker
  */
 enum {
@@ -980,6 +987,7 @@ enum {
 	Opt_assert,
 	Opt_auth_key,
 	Opt_auth_hash_name,
+	Opt_fsync_batch,
 	Opt_ignore,
 	Opt_err,
 };
@@ -994,6 +1002,7 @@ static const match_table_t tokens = {
 	{Opt_override_compr, "compr=%s"},
 	{Opt_auth_key, "auth_key=%s"},
 	{Opt_auth_hash_name, "auth_hash_name=%s"},
+	{Opt_fsync_batch, "fsync_batch=%u"},
 	{Opt_ignore, "ubi=%s"},
 	{Opt_ignore, "vol=%s"},
 	{Opt_assert, "assert=%s"},
@@ -1089,6 +1098,10 @@ static int ubifs_parse_options(struct ubifs_info *c, char *options,
 				c->mount_opts.compr_type = UBIFS_COMPR_ZLIB;
 			else if (!strcmp(name, "zstd"))
 				c->mount_opts.compr_type = UBIFS_COMPR_ZSTD;
+			else if (!strcmp(name, "lz4"))
+				c->mount_opts.compr_type = UBIFS_COMPR_LZ4;
+			else if (!strcmp(name, "lz4hc"))
+				c->mount_opts.compr_type = UBIFS_COMPR_LZ4HC;
 			else {
 				ubifs_err(c, "unknown compressor \"%s\"", name); //FIXME: is c ready?
 				kfree(name);
@@ -1135,6 +1148,18 @@ static int ubifs_parse_options(struct ubifs_info *c, char *options,
 					return -ENOMEM;
 			}
 			break;
+		case Opt_fsync_batch:
+		{
+			unsigned int us;
+
+			if (match_uint(&args[0], &us) || us > USEC_PER_SEC) {
+				ubifs_err(c, "bad fsync_batch value \"%s\"",
+					  args[0].from);
+				return -EINVAL;
+			}
+			c->fsync_batch_us = us;
+			break;
+		}
 		case Opt_ignore:
 			break;
 		default:
@@ -1440,6 +1465,8 @@ static int mount_ubifs(struct ubifs_info *c)
 		c->superblock_need_write = 1;
 	}
 
+	ubifs_flag_lz4(c);
+
 	if (!c->ro_mount && c->superblock_need_write) {
 		err = ubifs_write_sb_node(c, c->sup_node);
 		if (err)
@@ -1766,6 +1793,8 @@ static int ubifs_remount_rw(struct ubifs_info *c)
 			goto out;
 	}
 
+	ubifs_flag_lz4(c);
+
 	if (c->superblock_need_write) {
 		struct ubifs_sb_node *sup = c->sup_node;
 
@@ -2035,6 +2064,15 @@ static int ubifs_remount_fs(struct super_block *sb, int *flags, char *data)
 			return -EROFS;
 		}
 		ubifs_remount_ro(c);
+	} else if (!c->ro_mount) {
+		/* "compr=" may have switched an R/W mount over to LZ4 */
+		ubifs_flag_lz4(c);
+		if (c->superblock_need_write) {
+			err = ubifs_write_sb_node(c, c->sup_node);
+			if (err)
+				return err;
+			c->superblock_need_write = 0;
+		}
 	}
 
 	if (c->bulk_read == 1)
@@ -2417,12 +2455,12 @@ static int __init ubifs_init(void)
 	BUILD_BUG_ON(UBIFS_REF_NODE_SZ != 64);
 
 	/*
-	 * We use 2 bit wide bit-fields to store compression type, which should
+	 * We use 3 bit wide bit-fields to store compression type, which should
 	 * be amended if more compressors are added. The bit-fields are:
 	 * @compr_type in 'struct ubifs_inode', @default_compr in
 	 * 'struct ubifs_info' and @compr_type in 'struct ubifs_mount_opts'.
 	 */
-	BUILD_BUG_ON(UBIFS_COMPR_TYPES_CNT > 4);
+	BUILD_BUG_ON(UBIFS_COMPR_TYPES_CNT > 8);
 
 	/*
 	 * We require that PAGE_SIZE is greater-than-or-equal-to
@@ -2454,6 +2492,13 @@ static int __init ubifs_init(void)
 	if (err)
 		goto out_shrinker;
 
+	/* Bulk-read workers run on behalf of ->read_folio() */
+	ubifs_bu_wq = alloc_workqueue("ubifs_bu", WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	if (!ubifs_bu_wq) {
+		err = -ENOMEM;
+		goto out_compr;
+	}
+
 	dbg_debugfs_init();
 
 	err = ubifs_sysfs_init();
@@ -2472,6 +2517,8 @@ static int __init ubifs_init(void)
 	ubifs_sysfs_exit();
 out_dbg:
 	dbg_debugfs_exit();
+	destroy_workqueue(ubifs_bu_wq);
+out_compr:
 	ubifs_compressors_exit();
 out_shrinker:
 	shrinker_free(ubifs_shrinker_info);
@@ -2489,6 +2536,7 @@ static void __exit ubifs_exit(void)
 
 	dbg_debugfs_exit();
 	ubifs_sysfs_exit();
+	destroy_workqueue(ubifs_bu_wq);
 	ubifs_compressors_exit();
 	shrinker_free(ubifs_shrinker_info);
 
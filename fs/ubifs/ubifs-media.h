@@ -341,6 +341,8 @@ enum {
  * UBIFS_COMPR_LZO: LZO compression
  * UBIFS_COMPR_ZLIB: ZLIB compression
  * UBIFS_COMPR_ZSTD: ZSTD compression
+ * UBIFS_COMPR_LZ4: LZ4 compression
+ * UBIFS_COMPR_LZ4HC: LZ4 high compression mode
  * UBIFS_COMPR_TYPES_CNT: count of supported compression types
  */
 enum {
@@ -348,6 +350,8 @@ enum {
 	UBIFS_COMPR_LZO,
 	UBIFS_COMPR_ZLIB,
 	UBIFS_COMPR_ZSTD,
+	UBIFS_COMPR_LZ4,
+	UBIFS_COMPR_LZ4HC,
 	UBIFS_COMPR_TYPES_CNT,
 };
 
@@ -427,6 +431,7 @@ enum {
  *			  support 64bit cookies for lookups by hash
  * UBIFS_FLG_ENCRYPTION: this filesystem contains encrypted files
  * UBIFS_FLG_AUTHENTICATION: this filesystem contains hashes for authentication
+ * UBIFS_FLG_LZ4: this filesystem may contain LZ4 or LZ4HC compressed nodes
  */
 enum {
 	UBIFS_FLG_BIGLPT = 0x02,
@@ -434,11 +439,12 @@ enum {
 	UBIFS_FLG_DOUBLE_HASH = 0x08,
 	UBIFS_FLG_ENCRYPTION = 0x10,
 	UBIFS_FLG_AUTHENTICATION = 0x20,
+	UBIFS_FLG_LZ4 = 0x40,
 };
 
 #define UBIFS_FLG_MASK (UBIFS_FLG_BIGLPT | UBIFS_FLG_SPACE_FIXUP | \
 		UBIFS_FLG_DOUBLE_HASH | UBIFS_FLG_ENCRYPTION | \
-		UBIFS_FLG_AUTHENTICATION)
+		UBIFS_FLG_AUTHENTICATION | UBIFS_FLG_LZ4)
 
 /**
  * struct ubifs_ch - common header node.
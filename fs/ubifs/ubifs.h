@@ -20,6 +20,8 @@
 #include <linux/vmalloc.h>
 #include <linux/spinlock.h>
 #include <linux/mutex.h>
+#include <linux/local_lock.h>
+#include <linux/percpu.h>
 #include <linux/rwsem.h>
 #include <linux/mtd/ubi.h>
 #include <linux/pagemap.h>
@@ -410,7 +412,7 @@ struct ubifs_inode {
 	unsigned int dirty:1;
 	unsigned int xattr:1;
 	unsigned int bulk_read:1;
-	unsigned int compr_type:2;
+	unsigned int compr_type:3;
 	struct mutex ui_mutex;
 	struct rw_semaphore xattr_sem;
 	spinlock_t ui_lock;
@@ -671,6 +673,8 @@ typedef int (*ubifs_lpt_scan_callback)(struct ubifs_info *c,
  * @need_sync: non-zero if the timer expired and the wbuf needs sync'ing
  * @next_ino: points to the next position of the following inode number
  * @inodes: stores the inode numbers of the nodes which are in wbuf
+ * @last_syncer: PID of the task which last synchronized the write-buffer from
+ *               'ubifs_sync_wbufs_by_inode()'
  *
  * The write-buffer synchronization callback is called when the write-buffer is
  * synchronized in order to notify how much space was wasted due to
@@ -699,6 +703,7 @@ struct ubifs_wbuf {
 	unsigned int need_sync:1;
 	int next_ino;
 	ino_t *inodes;
+	pid_t last_syncer;
 };
 
 /**
@@ -803,6 +808,9 @@ struct ubifs_znode {
  * @cnt: number of data nodes for bulk read
  * @blk_cnt: number of data blocks including holes
  * @oef: end of file reached
+ * @folios: locked folios to populate after the first one
+ * @folio_zbr: index of the first zbranch to look at for each of @folios
+ * @folio_cnt: number of folios in @folios
  */
 struct bu_info {
 	union ubifs_key key;
@@ -813,6 +821,9 @@ struct bu_info {
 	int cnt;
 	int blk_cnt;
 	int eof;
+	struct folio *folios[UBIFS_MAX_BULK_READ];
+	int folio_zbr[UBIFS_MAX_BULK_READ];
+	int folio_cnt;
 };
 
 /**
@@ -831,20 +842,26 @@ struct ubifs_node_range {
 	int max_len;
 };
 
+/**
+ * struct ubifs_compr_ctx - per-CPU compressor context.
+ * @lock: serializes users of @cc on the local CPU
+ * @cc: cryptoapi compressor handle
+ */
+struct ubifs_compr_ctx {
+	local_lock_t lock;
+	struct crypto_comp *cc;
+};
+
 /**
  * struct ubifs_compressor - UBIFS compressor description structure.
  * @compr_type: compressor type (%UBIFS_COMPR_LZO, etc)
- * @cc: cryptoapi compressor handle
- * @comp_mutex: mutex used during compression
- * @decomp_mutex: mutex used during decompression
+ * @ctx: per-CPU cryptoapi compressor contexts
  * @name: compressor name
  * @capi_name: cryptoapi compressor name
  */
 struct ubifs_compressor {
 	int compr_type;
-	struct crypto_comp *cc;
-	struct mutex *comp_mutex;
-	struct mutex *decomp_mutex;
+	struct ubifs_compr_ctx __percpu *ctx;
 	const char *name;
 	const char *capi_name;
 };
@@ -952,7 +969,7 @@ struct ubifs_mount_opts {
 	unsigned int bulk_read:2;
 	unsigned int chk_data_crc:2;
 	unsigned int override_compr:1;
-	unsigned int compr_type:2;
+	unsigned int compr_type:3;
 };
 
 /**
@@ -1049,6 +1066,7 @@ struct ubifs_debug_info;
  * @space_fixup: flag indicating that free space in LEBs needs to be cleaned up
  * @double_hash: flag indicating that we can do lookups by hash
  * @encrypted: flag indicating that this file system contains encrypted files
+ * @lz4: flag indicating that this file system may contain LZ4 compressed nodes
  * @no_chk_data_crc: do not check CRCs when reading data nodes (except during
  *                   recovery)
  * @bulk_read: enable bulk-reads
@@ -1056,6 +1074,8 @@ struct ubifs_debug_info;
  * @rw_incompat: the media is not R/W compatible
  * @assert_action: action to take when a ubifs_assert() fails
  * @authenticated: flag indigating the FS is mounted in authenticated mode
+ * @fsync_batch_us: how long 'fsync()' waits for concurrent fsyncs to share a
+ *                  write-buffer flush, in microseconds (%0 - do not wait)
  *
  * @tnc_mutex: protects the Tree Node Cache (TNC), @zroot, @cnext, @enext, and
  *             @calc_idx_sz
@@ -1312,13 +1332,15 @@ struct ubifs_info {
 	unsigned int space_fixup:1;
 	unsigned int double_hash:1;
 	unsigned int encrypted:1;
+	unsigned int lz4:1;
 	unsigned int no_chk_data_crc:1;
 	unsigned int bulk_read:1;
-	unsigned int default_compr:2;
+	unsigned int default_compr:3;
 	unsigned int rw_incompat:1;
 	unsigned int assert_action:2;
 	unsigned int authenticated:1;
 	unsigned int superblock_need_write:1;
+	unsigned int fsync_batch_us;
 
 	struct mutex tnc_mutex;
 	struct ubifs_zbranch zroot;
@@ -1529,6 +1551,7 @@ extern const struct file_operations ubifs_dir_operations;
 extern const struct inode_operations ubifs_dir_inode_operations;
 extern const struct inode_operations ubifs_symlink_inode_operations;
 extern struct ubifs_compressor *ubifs_compressors[UBIFS_COMPR_TYPES_CNT];
+extern struct workqueue_struct *ubifs_bu_wq;
 extern int ubifs_default_version;
 
 /* auth.c */
@@ -1933,6 +1956,7 @@ int ubifs_read_superblock(struct ubifs_info *c);
 int ubifs_write_sb_node(struct ubifs_info *c, struct ubifs_sb_node *sup);
 int ubifs_fixup_free_space(struct ubifs_info *c);
 int ubifs_enable_encryption(struct ubifs_info *c);
+void ubifs_flag_lz4(struct ubifs_info *c);
 
 /* replay.c */
 int ubifs_validate_entry(struct ubifs_info *c,
@@ -131,6 +131,8 @@ struct dw_hdmi_plat_data {
 	unsigned long input_bus_encoding;
 	bool use_drm_infoframe;
 	bool ycbcr_420_allowed;
+	/* Deepest YCbCr 4:2:0 color the encoder can output, 0 for no limit */
+	u8 ycbcr_420_max_bpc;
 
 	/*
 	 * Private data passed to all the .mode_valid() and .configure_phy()
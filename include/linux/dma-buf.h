@@ -570,6 +570,19 @@ static inline void get_dma_buf(struct dma_buf *dmabuf)
 	get_file(dmabuf->file);
 }
 
+/**
+ * dma_buf_ino - identify a dma-buf in traces
+ * @dmabuf:	[in]	pointer to dma_buf
+ *
+ * Returns the inode number of the dma-buf file, which is also the "ino" shown
+ * in its fdinfo. It is the same for every importer of the buffer, so it ties
+ * together the trace events of the devices a buffer moves between.
+ */
+static inline unsigned long dma_buf_ino(struct dma_buf *dmabuf)
+{
+	return file_inode(dmabuf->file)->i_ino;
+}
+
 /**
  * dma_buf_is_dynamic - check if a DMA-buf uses dynamic mappings.
  * @dmabuf: the DMA-buf to check
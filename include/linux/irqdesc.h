@@ -48,6 +48,8 @@ struct irqstat {
  * @lock:		locking for SMP
  * @affinity_hint:	hint to user space for preferred irq affinity
  * @affinity_notify:	context for notification of affinity changes
+ * @balance_count:	interrupt count seen by the last balancing pass
+ * @balance_owned:	affinity is managed by the in-kernel balancer
  * @pending_mask:	pending rebalanced interrupts
  * @threads_oneshot:	bitfield to handle shared oneshot threads
  * @threads_active:	number of irqaction threads currently running
@@ -86,6 +88,10 @@ struct irq_desc {
 #ifdef CONFIG_SMP
 	const struct cpumask	*affinity_hint;
 	struct irq_affinity_notify *affinity_notify;
+#ifdef CONFIG_IRQ_BALANCE
+	unsigned int		balance_count;
+	bool			balance_owned;
+#endif
 #ifdef CONFIG_GENERIC_PENDING_IRQ
 	cpumask_var_t		pending_mask;
 #endif
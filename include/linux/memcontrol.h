@@ -210,6 +210,14 @@ struct mem_cgroup {
 	 * swap, and from being swapped out on zswap store failures.
 	 */
 	bool zswap_writeback;
+
+	/*
+	 * memory.zswap.writeback.rate: pages per second that may be written
+	 * back from zswap to swap, and the one-second window accounting it.
+	 */
+	unsigned long zswap_writeback_rate;
+	unsigned long zswap_writeback_stamp;
+	atomic_long_t zswap_writeback_used;
 #endif
 
 	/* vmpressure notifications */
@@ -1839,6 +1847,7 @@ bool obj_cgroup_may_zswap(struct obj_cgroup *objcg);
 void obj_cgroup_charge_zswap(struct obj_cgroup *objcg, size_t size);
 void obj_cgroup_uncharge_zswap(struct obj_cgroup *objcg, size_t size);
 bool mem_cgroup_zswap_writeback_enabled(struct mem_cgroup *memcg);
+bool obj_cgroup_may_zswap_writeback(struct obj_cgroup *objcg);
 #else
 static inline bool obj_cgroup_may_zswap(struct obj_cgroup *objcg)
 {
@@ -1857,6 +1866,10 @@ static inline bool mem_cgroup_zswap_writeback_enabled(struct mem_cgroup *memcg)
 	/* if zswap is disabled, do not block pages going to the swapping device */
 	return true;
 }
+static inline bool obj_cgroup_may_zswap_writeback(struct obj_cgroup *objcg)
+{
+	return true;
+}
 #endif
 
 
@@ -113,6 +113,13 @@ enum mmc_err_stat {
 	MMC_ERR_MAX,
 };
 
+/*
+ * Data request latency histogram buckets: bucket 0 counts requests done in
+ * less than 1us, bucket n those taking [2^(n-1), 2^n) us, and the last bucket
+ * everything slower.
+ */
+#define MMC_LAT_BUCKETS		24
+
 struct mmc_host_ops {
 	/*
 	 * It is optional for the host to implement pre_req and post_req in
@@ -506,6 +513,7 @@ struct mmc_host {
 	int			hsq_depth;
 
 	u32			err_stats[MMC_ERR_MAX];
+	u32			lat_hist[2][MMC_LAT_BUCKETS];	/* read, write */
 	unsigned long		private[] ____cacheline_aligned;
 };
 
@@ -155,11 +155,15 @@ struct pci_epc {
  * @BAR_PROGRAMMABLE: The BAR mask can be configured by the EPC.
  * @BAR_FIXED: The BAR mask is fixed by the hardware.
  * @BAR_RESERVED: The BAR should not be touched by an EPF driver.
+ * @BAR_RESIZABLE: The BAR implements the PCI-SIG Resizable BAR Capability.
+ *		   The EPC advertises exactly the size set by the EPF driver,
+ *		   which must be a power of two of at least 1 MB.
  */
 enum pci_epc_bar_type {
 	BAR_PROGRAMMABLE = 0,
 	BAR_FIXED,
 	BAR_RESERVED,
+	BAR_RESIZABLE,
 };
 
 /**
@@ -435,6 +435,18 @@ static inline bool arch_has_hw_pte_young(void)
 }
 #endif
 
+#ifndef exec_folio_order
+/*
+ * Return the preferred minimum folio order for executable file-backed
+ * memory. Must be smaller than PMD_ORDER. Order-0 keeps the generic
+ * read-around behaviour.
+ */
+static inline unsigned int exec_folio_order(void)
+{
+	return 0;
+}
+#endif
+
 #ifndef arch_check_zapped_pte
 static inline void arch_check_zapped_pte(struct vm_area_struct *vma,
 					 pte_t pte)
@@ -81,6 +81,8 @@ struct vb2_buffer;
  *		   dbuf is the shared dma_buf; returns ERR_PTR() on failure;
  *		   allocator private per-buffer structure on success;
  *		   this needs to be used for further accesses to the buffer.
+ *		   The core may move a mapped attachment to another buffer
+ *		   of the same queue, so it must not keep using @vb.
  * @detach_dmabuf: inform the exporter of the buffer that the current DMABUF
  *		   buffer is no longer used; the @buf_priv argument is the
  *		   allocator private per-buffer structure previously returned
@@ -173,6 +175,8 @@ struct vb2_mem_ops {
  *		descriptor associated with this plane.
  * @data_offset:	offset in the plane to the start of data; usually 0,
  *		unless there is a header in front of the data.
+ * @exp_ino:	when memory is %VB2_MEMORY_MMAP, the dma_buf_ino() of the
+ *		dma-buf last exported from this plane, reported in traces.
  *
  * Should contain enough information to be able to cover all the fields
  * of &struct v4l2_plane at videodev2.h.
@@ -191,6 +195,23 @@ struct vb2_plane {
 		int		fd;
 	} m;
 	unsigned int		data_offset;
+	unsigned long		exp_ino;
+};
+
+#define VB2_DMABUF_CACHE_SIZE	16
+
+/**
+ * struct vb2_dmabuf_cache_entry - mapped DMABUF attachment no buffer uses.
+ * @dbuf:	dma_buf the attachment is for, a reference is held on it.
+ * @mem_priv:	attachment as returned by &vb2_mem_ops->attach_dmabuf, mapped.
+ * @dev:	device the attachment was made for.
+ * @length:	length the attachment was made with.
+ */
+struct vb2_dmabuf_cache_entry {
+	struct dma_buf		*dbuf;
+	void			*mem_priv;
+	struct device		*dev;
+	unsigned int		length;
 };
 
 /**
@@ -607,6 +628,10 @@ struct vb2_buf_ops {
  * @threadio:	thread io internal data, used only if thread is active
  * @name:	queue name, used for logging purpose. Initialized automatically
  *		if left empty by drivers.
+ * @dmabuf_cache: DMABUF attachments kept mapped after the buffer they were
+ *		made for got a different dma_buf, so that queueing the old
+ *		dma_buf into any buffer again doesn't need a new mapping.
+ * @dmabuf_cache_next: next @dmabuf_cache entry to replace.
  */
 struct vb2_queue {
 	unsigned int			type;
@@ -674,6 +699,9 @@ struct vb2_queue {
 
 	char				name[32];
 
+	struct vb2_dmabuf_cache_entry	dmabuf_cache[VB2_DMABUF_CACHE_SIZE];
+	unsigned int			dmabuf_cache_next;
+
 #ifdef CONFIG_VIDEO_ADV_DEBUG
 	/*
 	 * Counters for how often these queue-related ops are
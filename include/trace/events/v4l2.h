@@ -198,6 +198,7 @@ DECLARE_EVENT_CLASS(vb2_v4l2_event_class,
 		__field(u8, timecode_userbits2)
 		__field(u8, timecode_userbits3)
 		__field(u32, sequence)
+		__field(unsigned long, dmabuf)
 	),
 
 	TP_fast_assign(
@@ -219,12 +220,16 @@ DECLARE_EVENT_CLASS(vb2_v4l2_event_class,
 		__entry->timecode_userbits2 = vbuf->timecode.userbits[2];
 		__entry->timecode_userbits3 = vbuf->timecode.userbits[3];
 		__entry->sequence = vbuf->sequence;
+		__entry->dmabuf = vb->planes[0].dbuf ?
+				  dma_buf_ino(vb->planes[0].dbuf) :
+				  vb->planes[0].exp_ino;
 	),
 
 	TP_printk("minor=%d flags = %s, field = %s, "
 		  "timestamp = %llu, timecode = { type = %s, flags = %s, "
 		  "frames = %u, seconds = %u, minutes = %u, hours = %u, "
-		  "userbits = { %u %u %u %u } }, sequence = %u", __entry->minor,
+		  "userbits = { %u %u %u %u } }, sequence = %u, dmabuf = %lu",
+		  __entry->minor,
 		  show_flags(__entry->flags),
 		  show_field(__entry->field),
 		  __entry->timestamp,
@@ -238,7 +243,8 @@ DECLARE_EVENT_CLASS(vb2_v4l2_event_class,
 		  __entry->timecode_userbits1,
 		  __entry->timecode_userbits2,
 		  __entry->timecode_userbits3,
-		  __entry->sequence
+		  __entry->sequence,
+		  __entry->dmabuf
 	)
 )
 
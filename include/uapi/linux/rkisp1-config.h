@@ -8,6 +8,7 @@
 #define _UAPI_RKISP1_CONFIG_H
 
 #include <linux/types.h>
+#include <linux/videodev2.h>
 
 /* Defect Pixel Cluster Detection */
 #define RKISP1_CIF_ISP_MODULE_DPCC		(1U << 0)
@@ -1574,4 +1575,32 @@ struct rkisp1_ext_params_cfg {
 	__u8 data[RKISP1_EXT_PARAMS_MAX_SIZE];
 };
 
+/*---------- PART4: Main path capture ------------*/
+
+/*
+ * Number of luma lines after which the main path capture node sends a
+ * V4L2_EVENT_RKISP1_FILL_LEVEL event for the buffer being written, 0 sends
+ * none. Takes effect from the next frame on.
+ */
+#define V4L2_CID_RKISP1_FILL_LEVEL	(V4L2_CID_USER_RKISP1_BASE + 0)
+
+#define V4L2_EVENT_RKISP1_FILL_LEVEL	(V4L2_EVENT_PRIVATE_START | 0x200)
+
+/**
+ * struct rkisp1_fill_level_event - V4L2_EVENT_RKISP1_FILL_LEVEL data
+ *
+ * The buffer stays queued and is still being written, but the first @lines
+ * lines of its luma plane already hold the frame. The chroma planes are
+ * written at the same pace.
+ *
+ * @frame_sequence: sequence number the buffer will be completed with
+ * @index: index of the buffer
+ * @lines: number of luma lines written, as set by V4L2_CID_RKISP1_FILL_LEVEL
+ */
+struct rkisp1_fill_level_event {
+	__u32 frame_sequence;
+	__u32 index;
+	__u32 lines;
+};
+
 #endif /* _UAPI_RKISP1_CONFIG_H */
@@ -1137,17 +1137,17 @@ struct blacklist_entry {
 };
 
 static __initdata_or_module LIST_HEAD(blacklisted_initcalls);
+static __initdata LIST_HEAD(async_initcalls);
 
-static int __init initcall_blacklist(char *str)
+/* str argument is a comma-separated list of functions */
+static void __init initcall_list_add(char *str, struct list_head *list)
 {
 	char *str_entry;
 	struct blacklist_entry *entry;
 
-	/* str argument is a comma-separated list of functions */
 	do {
 		str_entry = strsep(&str, ",");
 		if (str_entry) {
-			pr_debug("blacklisting initcall %s\n", str_entry);
 			entry = memblock_alloc(sizeof(*entry),
 					       SMP_CACHE_BYTES);
 			if (!entry)
@@ -1159,20 +1159,19 @@ static int __init initcall_blacklist(char *str)
 				panic("%s: Failed to allocate %zu bytes\n",
 				      __func__, strlen(str_entry) + 1);
 			strcpy(entry->buf, str_entry);
-			list_add(&entry->next, &blacklisted_initcalls);
+			list_add(&entry->next, list);
 		}
 	} while (str_entry);
-
-	return 1;
 }
 
-static bool __init_or_module initcall_blacklisted(initcall_t fn)
+static bool __init_or_module initcall_listed(initcall_t fn,
+					     struct list_head *list)
 {
 	struct blacklist_entry *entry;
 	char fn_name[KSYM_SYMBOL_LEN];
 	unsigned long addr;
 
-	if (list_empty(&blacklisted_initcalls))
+	if (list_empty(list))
 		return false;
 
 	addr = (unsigned long) dereference_function_descriptor(fn);
@@ -1184,15 +1183,40 @@ static bool __init_or_module initcall_blacklisted(initcall_t fn)
 	 */
 	strreplace(fn_name, ' ', '\0');
 
-	list_for_each_entry(entry, &blacklisted_initcalls, next) {
-		if (!strcmp(fn_name, entry->buf)) {
-			pr_debug("initcall %s blacklisted\n", fn_name);
+	list_for_each_entry(entry, list, next) {
+		if (!strcmp(fn_name, entry->buf))
 			return true;
-		}
 	}
 
 	return false;
 }
+
+static int __init initcall_blacklist(char *str)
+{
+	pr_debug("blacklisting initcalls %s\n", str);
+	initcall_list_add(str, &blacklisted_initcalls);
+	return 1;
+}
+
+static bool __init_or_module initcall_blacklisted(initcall_t fn)
+{
+	if (!initcall_listed(fn, &blacklisted_initcalls))
+		return false;
+
+	pr_debug("initcall %ps blacklisted\n", fn);
+	return true;
+}
+
+static int __init initcall_async(char *str)
+{
+	initcall_list_add(str, &async_initcalls);
+	return 1;
+}
+
+static bool __init initcall_is_async(initcall_t fn)
+{
+	return initcall_listed(fn, &async_initcalls);
+}
 #else
 static int __init initcall_blacklist(char *str)
 {
@@ -1204,8 +1228,20 @@ static bool __init_or_module initcall_blacklisted(initcall_t fn)
 {
 	return false;
 }
+
+static int __init initcall_async(char *str)
+{
+	pr_warn("initcall_async requires CONFIG_KALLSYMS\n");
+	return 0;
+}
+
+static bool __init initcall_is_async(initcall_t fn)
+{
+	return false;
+}
 #endif
 __setup("initcall_blacklist=", initcall_blacklist);
+__setup("initcall_async=", initcall_async);
 
 static __init_or_module void
 trace_initcall_start_cb(void *data, initcall_t fn)
@@ -1316,6 +1352,18 @@ static int __init ignore_unknown_bootoption(char *param, char *val,
 	return 0;
 }
 
+static ASYNC_DOMAIN_EXCLUSIVE(initcall_domain);
+
+static void __init do_one_initcall_async(void *data, async_cookie_t cookie)
+{
+	do_one_initcall((initcall_t)data);
+}
+
+/*
+ * Initcalls named in initcall_async= run concurrently with the rest of their
+ * level, and are waited for before the next level starts. It is up to the
+ * user to only list initcalls that nothing else in the level depends on.
+ */
 static void __init do_initcall_level(int level, char *command_line)
 {
 	initcall_entry_t *fn;
@@ -1327,8 +1375,16 @@ static void __init do_initcall_level(int level, char *command_line)
 		   NULL, ignore_unknown_bootoption);
 
 	trace_initcall_level(initcall_level_names[level]);
-	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++)
-		do_one_initcall(initcall_from_entry(fn));
+	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++) {
+		initcall_t call = initcall_from_entry(fn);
+
+		if (initcall_is_async(call))
+			async_schedule_domain(do_one_initcall_async,
+					      (void *)call, &initcall_domain);
+		else
+			do_one_initcall(call);
+	}
+	async_synchronize_full_domain(&initcall_domain);
 }
 
 static void __init do_initcalls(void)
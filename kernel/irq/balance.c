@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Load based placement of unmanaged device interrupts.
+ *
+ * Every period the hardirq and softirq time of each online CPU is split
+ * among the interrupts it handled, in proportion to their rate. Movable
+ * interrupts are then visited from the most to the least expensive one,
+ * and each is moved to the least loaded housekeeping CPU when that makes
+ * the pair of CPUs noticeably better balanced.
+ *
+ * Only interrupts nobody else cares about are moved: not managed, not
+ * per CPU, balancing allowed, and no affinity set by a driver or from
+ * user space. Setting the affinity of an interrupt by any other means
+ * takes it away from the balancer for good.
+ */
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/kernel_stat.h>
+#include <linux/sched/isolation.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/workqueue.h>
+
+#include "internals.h"
+
+struct irq_balance_cpu {
+	u64		time;
+	unsigned long	count;
+	u64		avg;
+	u64		load;
+};
+
+struct irq_balance_irq {
+	unsigned int	irq;
+	unsigned int	cpu;
+	u64		cost;
+};
+
+static DEFINE_PER_CPU(struct irq_balance_cpu, irq_balance_cpus);
+static unsigned int irq_balance_interval_ms = 2000;
+static cpumask_var_t irq_balance_allowed;
+static bool irq_balance_primed;
+
+static void irq_balance_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(irq_balance_work, irq_balance_fn);
+
+static int __init irq_balance_setup(char *str)
+{
+	return kstrtouint(str, 0, &irq_balance_interval_ms) == 0;
+}
+__setup("irqbalance=", irq_balance_setup);
+
+static bool irq_balance_movable(struct irq_desc *desc)
+{
+	struct irq_data *data = &desc->irq_data;
+
+	if (!desc->action || !desc->kstat_irqs || !irqd_can_balance(data) ||
+	    irqd_affinity_is_managed(data) || irqd_is_setaffinity_pending(data))
+		return false;
+
+	if (!data->chip || !data->chip->irq_set_affinity)
+		return false;
+
+	return desc->balance_owned || !irqd_affinity_was_set(data);
+}
+
+static void irq_balance_update_cpus(void)
+{
+	unsigned int cpu;
+
+	for_each_online_cpu(cpu) {
+		struct irq_balance_cpu *st = per_cpu_ptr(&irq_balance_cpus, cpu);
+		struct kernel_cpustat *kcs = &kcpustat_cpu(cpu);
+		unsigned long count = kstat_cpu_irqs_sum(cpu);
+		u64 time;
+
+		time = kcpustat_field(kcs, CPUTIME_IRQ, cpu) +
+		       kcpustat_field(kcs, CPUTIME_SOFTIRQ, cpu);
+
+		/* Average cost of an interrupt on this CPU, softirq included */
+		st->load = time - st->time;
+		st->avg = count != st->count ?
+			  div64_u64(st->load, count - st->count) : 0;
+		st->time = time;
+		st->count = count;
+	}
+}
+
+/* Returns the number of movable interrupts which fired since the last pass */
+static unsigned int irq_balance_collect(struct irq_balance_irq *irqs,
+					unsigned int max)
+{
+	unsigned int irq, cnt = 0;
+
+	for_each_active_irq(irq) {
+		struct irq_desc *desc = irq_to_desc(irq);
+		unsigned int count, delta, cpu;
+
+		if (cnt == max)
+			break;
+
+		raw_spin_lock_irq(&desc->lock);
+		if (!irq_balance_movable(desc)) {
+			raw_spin_unlock_irq(&desc->lock);
+			continue;
+		}
+
+		count = kstat_irqs_desc(desc, cpu_possible_mask);
+		delta = count - desc->balance_count;
+		desc->balance_count = count;
+		cpu = cpumask_first(irq_data_get_effective_affinity_mask(&desc->irq_data));
+		raw_spin_unlock_irq(&desc->lock);
+
+		if (!delta || cpu >= nr_cpu_ids || !cpu_online(cpu))
+			continue;
+
+		irqs[cnt].irq = irq;
+		irqs[cnt].cpu = cpu;
+		irqs[cnt].cost = per_cpu(irq_balance_cpus, cpu).avg * delta;
+		cnt++;
+	}
+
+	return cnt;
+}
+
+static int irq_balance_cmp(const void *a, const void *b)
+{
+	const struct irq_balance_irq *ia = a, *ib = b;
+
+	if (ia->cost == ib->cost)
+		return 0;
+	return ia->cost < ib->cost ? 1 : -1;
+}
+
+static unsigned int irq_balance_least_loaded(void)
+{
+	unsigned int cpu, best = nr_cpu_ids;
+	u64 min = U64_MAX;
+
+	for_each_cpu(cpu, irq_balance_allowed) {
+		u64 load = per_cpu(irq_balance_cpus, cpu).load;
+
+		if (load < min) {
+			min = load;
+			best = cpu;
+		}
+	}
+
+	return best;
+}
+
+static bool irq_balance_move(unsigned int irq, unsigned int cpu)
+{
+	struct irq_desc *desc = irq_to_desc(irq);
+	unsigned long flags;
+	bool moved = false;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	if (irq_balance_movable(desc) &&
+	    !irq_set_affinity_locked(&desc->irq_data, cpumask_of(cpu), false)) {
+		desc->balance_owned = true;
+		moved = true;
+	}
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+	return moved;
+}
+
+static void irq_balance_spread(struct irq_balance_irq *irqs, unsigned int cnt)
+{
+	unsigned int i, cpu;
+
+	sort(irqs, cnt, sizeof(*irqs), irq_balance_cmp, NULL);
+
+	for (i = 0; i < cnt; i++) {
+		struct irq_balance_cpu *src, *dst;
+		u64 cost = irqs[i].cost;
+
+		cpu = irq_balance_least_loaded();
+		if (cpu >= nr_cpu_ids || cpu == irqs[i].cpu)
+			continue;
+
+		src = per_cpu_ptr(&irq_balance_cpus, irqs[i].cpu);
+		dst = per_cpu_ptr(&irq_balance_cpus, cpu);
+
+		/*
+		 * Interrupts on a CPU outside the allowed set always move.
+		 * Otherwise require the busier side of the pair to shed at
+		 * least an eighth of its load, so noise does not make
+		 * interrupts bounce between CPUs.
+		 */
+		if (cpumask_test_cpu(irqs[i].cpu, irq_balance_allowed) &&
+		    dst->load + cost + (src->load >> 3) >= src->load)
+			continue;
+
+		if (!irq_balance_move(irqs[i].irq, cpu))
+			continue;
+
+		src->load -= min(cost, src->load);
+		dst->load += cost;
+	}
+}
+
+static void irq_balance_fn(struct work_struct *work)
+{
+	struct irq_balance_irq *irqs;
+	unsigned int cnt, max;
+
+	cpus_read_lock();
+	irq_lock_sparse();
+
+	cpumask_and(irq_balance_allowed, irq_default_affinity,
+		    housekeeping_cpumask(HK_TYPE_DOMAIN));
+	cpumask_and(irq_balance_allowed, irq_balance_allowed, cpu_online_mask);
+
+	max = nr_irqs;
+	irqs = kmalloc_array(max, sizeof(*irqs), GFP_KERNEL);
+	if (!irqs)
+		goto out;
+
+	irq_balance_update_cpus();
+	cnt = irq_balance_collect(irqs, max);
+
+	/* The first pass only takes the reference counts */
+	if (irq_balance_primed && cpumask_weight(irq_balance_allowed) > 1)
+		irq_balance_spread(irqs, cnt);
+	irq_balance_primed = true;
+
+	kfree(irqs);
+out:
+	irq_unlock_sparse();
+	cpus_read_unlock();
+
+	queue_delayed_work(system_unbound_wq, &irq_balance_work,
+			   msecs_to_jiffies(irq_balance_interval_ms));
+}
+
+static int __init irq_balance_init(void)
+{
+	if (!irq_balance_interval_ms)
+		return 0;
+
+	if (!zalloc_cpumask_var(&irq_balance_allowed, GFP_KERNEL))
+		return -ENOMEM;
+
+	queue_delayed_work(system_unbound_wq, &irq_balance_work,
+			   msecs_to_jiffies(irq_balance_interval_ms));
+	return 0;
+}
+late_initcall(irq_balance_init);
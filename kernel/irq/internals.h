@@ -469,6 +469,16 @@ static inline bool irq_fixup_move_pending(struct irq_desc *desc, bool fclear)
 }
 #endif /* !CONFIG_GENERIC_PENDING_IRQ */
 
+#ifdef CONFIG_IRQ_BALANCE
+/* Any affinity setting other than the balancer's own takes the IRQ back */
+static inline void irq_balance_release(struct irq_desc *desc)
+{
+	desc->balance_owned = false;
+}
+#else
+static inline void irq_balance_release(struct irq_desc *desc) { }
+#endif
+
 static inline bool handle_enforce_irqctx(struct irq_data *data)
 {
 	return irqd_is_handle_enforce_irqctx(data);
@@ -378,6 +378,7 @@ int irq_set_affinity_locked(struct irq_data *data, const struct cpumask *mask,
 				 desc->affinity_notify->release);
 		}
 	}
+	irq_balance_release(desc);
 	irqd_set(data, IRQD_AFFINITY_SET);
 
 	return ret;
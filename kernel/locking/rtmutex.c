@@ -1683,6 +1683,7 @@ static int __sched __rt_mutex_slowlock(struct rt_mutex_base *lock,
 {
 	struct rt_mutex *rtm = container_of(lock, struct rt_mutex, rtmutex);
 	struct ww_mutex *ww = ww_container_of(rtm);
+	struct rt_mutex_prof_sample prof;
 	int ret;
 
 	lockdep_assert_held(&lock->wait_lock);
@@ -1699,6 +1700,7 @@ static int __sched __rt_mutex_slowlock(struct rt_mutex_base *lock,
 	set_current_state(state);
 
 	trace_contention_begin(lock, LCB_F_RT);
+	rt_mutex_prof_begin(lock, &prof);
 
 	ret = task_blocks_on_rt_mutex(lock, waiter, current, ww_ctx, chwalk);
 	if (likely(!ret))
@@ -1723,6 +1725,7 @@ static int __sched __rt_mutex_slowlock(struct rt_mutex_base *lock,
 	 */
 	fixup_rt_mutex_waiters(lock, true);
 
+	rt_mutex_prof_end(lock, &prof);
 	trace_contention_end(lock, ret);
 
 	return ret;
@@ -1806,6 +1809,7 @@ static __always_inline int __rt_mutex_lock(struct rt_mutex_base *lock,
  */
 static void __sched rtlock_slowlock_locked(struct rt_mutex_base *lock)
 {
+	struct rt_mutex_prof_sample prof;
 	struct rt_mutex_waiter waiter;
 	struct task_struct *owner;
 
@@ -1820,6 +1824,7 @@ static void __sched rtlock_slowlock_locked(struct rt_mutex_base *lock)
 	current_save_and_set_rtlock_wait_state();
 
 	trace_contention_begin(lock, LCB_F_RT);
+	rt_mutex_prof_begin(lock, &prof);
 
 	task_blocks_on_rt_mutex(lock, &waiter, current, NULL, RT_MUTEX_MIN_CHAINWALK);
 
@@ -1851,6 +1856,7 @@ static void __sched rtlock_slowlock_locked(struct rt_mutex_base *lock)
 	fixup_rt_mutex_waiters(lock, true);
 	debug_rt_mutex_free_waiter(&waiter);
 
+	rt_mutex_prof_end(lock, &prof);
 	trace_contention_end(lock, 0);
 }
 
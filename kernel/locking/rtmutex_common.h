@@ -14,6 +14,7 @@
 #define __KERNEL_RTMUTEX_COMMON_H
 
 #include <linux/debug_locks.h>
+#include <linux/jump_label.h>
 #include <linux/rtmutex.h>
 #include <linux/sched/wake_q.h>
 
@@ -102,6 +103,48 @@ extern bool __rt_mutex_futex_unlock(struct rt_mutex_base *lock,
 
 extern void rt_mutex_postunlock(struct rt_wake_q_head *wqh);
 
+/*
+ * Contention profiling, see rtmutex_prof.c. A sample lives on the stack of
+ * the waiter for the duration of one slow path acquisition.
+ */
+#ifdef CONFIG_RT_MUTEX_PROF
+struct rt_mutex_prof_sample {
+	u64		start;
+	unsigned long	site;
+	int		waiter_prio;
+	int		owner_prio;
+};
+
+DECLARE_STATIC_KEY_FALSE(rt_mutex_prof_enabled);
+
+extern void rt_mutex_prof_sample_begin(struct rt_mutex_base *lock,
+				       struct rt_mutex_prof_sample *s);
+extern void rt_mutex_prof_sample_end(struct rt_mutex_base *lock,
+				     struct rt_mutex_prof_sample *s);
+
+static __always_inline void rt_mutex_prof_begin(struct rt_mutex_base *lock,
+						struct rt_mutex_prof_sample *s)
+{
+	s->start = 0;
+	if (static_branch_unlikely(&rt_mutex_prof_enabled))
+		rt_mutex_prof_sample_begin(lock, s);
+}
+
+static __always_inline void rt_mutex_prof_end(struct rt_mutex_base *lock,
+					      struct rt_mutex_prof_sample *s)
+{
+	if (s->start)
+		rt_mutex_prof_sample_end(lock, s);
+}
+#else
+struct rt_mutex_prof_sample { };
+
+static inline void rt_mutex_prof_begin(struct rt_mutex_base *lock,
+				       struct rt_mutex_prof_sample *s) { }
+static inline void rt_mutex_prof_end(struct rt_mutex_base *lock,
+				     struct rt_mutex_prof_sample *s) { }
+#endif
+
 /*
  * Must be guarded because this header is included from rcu/tree_plugin.h
  * unconditionally.
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Sampling contention profiler for rtmutex based locks
+ *
+ * Every sample_period'th contended slow path acquisition on a CPU is timed
+ * from blocking to acquisition, and accounted to the pair of lock and call
+ * site. On PREEMPT_RT that covers spinlock_t and rwlock_t as well, the locks
+ * most likely to cause priority inversion wait.
+ *
+ * For each pair the number of sampled waits, the total and longest wait and
+ * how often the waiter had a higher priority than the owner, i.e. the owner
+ * had to be boosted, are kept. The owner and waiter priorities seen during
+ * the longest wait are recorded too. Priorities are kernel priorities, lower
+ * is more important.
+ *
+ * Nothing is recorded until the profiler is enabled, and the table has a
+ * fixed size: once full, new pairs are counted as dropped.
+ */
+#include <linux/debugfs.h>
+#include <linux/hash.h>
+#include <linux/sched.h>
+#include <linux/sched/clock.h>
+#include <linux/sched/debug.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/stacktrace.h>
+
+#include "rtmutex_common.h"
+
+#define RT_MUTEX_PROF_BITS	8
+#define RT_MUTEX_PROF_ENTRIES	(1 << RT_MUTEX_PROF_BITS)
+#define RT_MUTEX_PROF_DEPTH	8
+
+struct rt_mutex_prof_entry {
+	const void	*lock;
+	unsigned long	site;
+	u64		count;
+	u64		boosted;
+	u64		total_ns;
+	u64		max_ns;
+	int		waiter_prio;
+	int		owner_prio;
+};
+
+DEFINE_STATIC_KEY_FALSE(rt_mutex_prof_enabled);
+
+static struct rt_mutex_prof_entry rt_mutex_prof_table[RT_MUTEX_PROF_ENTRIES];
+static DEFINE_RAW_SPINLOCK(rt_mutex_prof_lock);
+static unsigned long rt_mutex_prof_dropped;
+static u32 rt_mutex_prof_period = 16;
+static DEFINE_PER_CPU(u32, rt_mutex_prof_count);
+
+/*
+ * This and the rtmutex slow paths live in the scheduler text, so the first
+ * address outside of it is where the lock was taken.
+ */
+void __sched rt_mutex_prof_sample_begin(struct rt_mutex_base *lock,
+					struct rt_mutex_prof_sample *s)
+{
+	unsigned long entries[RT_MUTEX_PROF_DEPTH];
+	u32 period = READ_ONCE(rt_mutex_prof_period) ?: 1;
+	struct task_struct *owner;
+	unsigned int i, nr;
+
+	if (this_cpu_inc_return(rt_mutex_prof_count) % period)
+		return;
+
+	nr = stack_trace_save(entries, ARRAY_SIZE(entries), 0);
+	s->site = 0;
+	for (i = 0; i < nr; i++) {
+		if (!in_sched_functions(entries[i])) {
+			s->site = entries[i];
+			break;
+		}
+	}
+
+	/* The owner can't go away, it needs wait_lock to hand over the lock */
+	owner = rt_mutex_owner(lock);
+	s->owner_prio = owner ? owner->normal_prio : MAX_PRIO;
+	s->waiter_prio = current->prio;
+	s->start = local_clock() ?: 1;
+}
+
+static struct rt_mutex_prof_entry *rt_mutex_prof_lookup(const void *lock,
+							unsigned long site)
+{
+	unsigned int i, idx = hash_long((unsigned long)lock ^ site,
+					RT_MUTEX_PROF_BITS);
+
+	for (i = 0; i < RT_MUTEX_PROF_ENTRIES; i++) {
+		struct rt_mutex_prof_entry *e;
+
+		e = &rt_mutex_prof_table[(idx + i) % RT_MUTEX_PROF_ENTRIES];
+		if (!e->lock) {
+			e->lock = lock;
+			e->site = site;
+			return e;
+		}
+		if (e->lock == lock && e->site == site)
+			return e;
+	}
+
+	return NULL;
+}
+
+void rt_mutex_prof_sample_end(struct rt_mutex_base *lock,
+			      struct rt_mutex_prof_sample *s)
+{
+	u64 wait = local_clock() - s->start;
+	struct rt_mutex_prof_entry *e;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&rt_mutex_prof_lock, flags);
+	e = rt_mutex_prof_lookup(lock, s->site);
+	if (!e) {
+		rt_mutex_prof_dropped++;
+		goto out;
+	}
+
+	e->count++;
+	e->total_ns += wait;
+	if (s->waiter_prio < s->owner_prio)
+		e->boosted++;
+	if (wait > e->max_ns) {
+		e->max_ns = wait;
+		e->waiter_prio = s->waiter_prio;
+		e->owner_prio = s->owner_prio;
+	}
+out:
+	raw_spin_unlock_irqrestore(&rt_mutex_prof_lock, flags);
+}
+
+static int rt_mutex_prof_cmp(const void *a, const void *b)
+{
+	const struct rt_mutex_prof_entry *ea = a, *eb = b;
+
+	if (ea->total_ns == eb->total_ns)
+		return 0;
+	return ea->total_ns < eb->total_ns ? 1 : -1;
+}
+
+static int rt_mutex_prof_show(struct seq_file *m, void *v)
+{
+	struct rt_mutex_prof_entry *snap;
+	unsigned long dropped;
+	unsigned int i, nr = 0;
+
+	snap = kvmalloc_array(RT_MUTEX_PROF_ENTRIES, sizeof(*snap), GFP_KERNEL);
+	if (!snap)
+		return -ENOMEM;
+
+	raw_spin_lock_irq(&rt_mutex_prof_lock);
+	for (i = 0; i < RT_MUTEX_PROF_ENTRIES; i++) {
+		if (rt_mutex_prof_table[i].lock)
+			snap[nr++] = rt_mutex_prof_table[i];
+	}
+	dropped = rt_mutex_prof_dropped;
+	raw_spin_unlock_irq(&rt_mutex_prof_lock);
+
+	sort(snap, nr, sizeof(*snap), rt_mutex_prof_cmp, NULL);
+
+	seq_printf(m, "%-18s %10s %10s %12s %10s %6s %6s  %s\n",
+		   "lock", "samples", "boosted", "total_us", "max_us",
+		   "wprio", "oprio", "site");
+	for (i = 0; i < nr; i++) {
+		struct rt_mutex_prof_entry *e = &snap[i];
+
+		/* Hashed, only good to tell locks apart within this table */
+		seq_printf(m, "%-18p %10llu %10llu %12llu %10llu %6d %6d  %pS\n",
+			   e->lock, e->count, e->boosted,
+			   div_u64(e->total_ns, NSEC_PER_USEC),
+			   div_u64(e->max_ns, NSEC_PER_USEC),
+			   e->waiter_prio, e->owner_prio, (void *)e->site);
+	}
+	if (dropped)
+		seq_printf(m, "dropped: %lu\n", dropped);
+
+	kvfree(snap);
+	return 0;
+}
+
+static int rt_mutex_prof_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rt_mutex_prof_show, NULL);
+}
+
+/* Any write clears the table */
+static ssize_t rt_mutex_prof_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	raw_spin_lock_irq(&rt_mutex_prof_lock);
+	memset(rt_mutex_prof_table, 0, sizeof(rt_mutex_prof_table));
+	rt_mutex_prof_dropped = 0;
+	raw_spin_unlock_irq(&rt_mutex_prof_lock);
+
+	return count;
+}
+
+static const struct file_operations rt_mutex_prof_fops = {
+	.open		= rt_mutex_prof_open,
+	.read		= seq_read,
+	.write		= rt_mutex_prof_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int rt_mutex_prof_enable_get(void *data, u64 *val)
+{
+	*val = static_key_enabled(&rt_mutex_prof_enabled);
+	return 0;
+}
+
+static int rt_mutex_prof_enable_set(void *data, u64 val)
+{
+	if (val)
+		static_branch_enable(&rt_mutex_prof_enabled);
+	else
+		static_branch_disable(&rt_mutex_prof_enabled);
+	return 0;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(rt_mutex_prof_enable_fops, rt_mutex_prof_enable_get,
+			 rt_mutex_prof_enable_set, "%llu\n");
+
+static int __init rt_mutex_prof_init(void)
+{
+	struct dentry *dir = debugfs_create_dir("rtmutex_prof", NULL);
+
+	debugfs_create_file_unsafe("enable", 0600, dir, NULL,
+				   &rt_mutex_prof_enable_fops);
+	debugfs_create_u32("sample_period", 0600, dir, &rt_mutex_prof_period);
+	debugfs_create_file("stats", 0600, dir, NULL, &rt_mutex_prof_fops);
+
+	return 0;
+}
+late_initcall(rt_mutex_prof_init);
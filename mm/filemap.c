@@ -3203,6 +3203,33 @@ static struct file *do_sync_mmap_readahead(struct vm_fault *vmf)
 	if (mmap_miss > MMAP_LOTSAMISS)
 		return fpin;
 
+	if ((vm_flags & VM_EXEC) && exec_folio_order()) {
+		struct vm_area_struct *vma = vmf->vma;
+		unsigned int order = exec_folio_order();
+		unsigned long start = vma->vm_pgoff;
+		unsigned long end = start + vma_pages(vma);
+		unsigned long ra_end;
+
+		/*
+		 * Text is faulted in randomly and rarely benefits from async
+		 * readahead, but it does benefit from being mapped with the
+		 * arch's preferred folio size (e.g. an arm64 contpte block).
+		 * Read around the fault in naturally aligned folios of that
+		 * order, clamped to the VMA so the padding between sections
+		 * is not pulled in.
+		 */
+		fpin = maybe_unlock_mmap_for_io(vmf, fpin);
+		ra->start = round_down(vmf->pgoff, 1UL << order);
+		ra->start = max(ra->start, start);
+		ra_end = round_up(ra->start + ra->ra_pages, 1UL << order);
+		ra_end = min(ra_end, end);
+		ra->size = ra_end - ra->start;
+		ra->async_size = 0;
+		ractl._index = ra->start;
+		page_cache_ra_order(&ractl, ra, order);
+		return fpin;
+	}
+
 	/*
 	 * mmap read-around
 	 */
@@ -3211,7 +3238,7 @@ static struct file *do_sync_mmap_readahead(struct vm_fault *vmf)
 	ra->size = ra->ra_pages;
 	ra->async_size = ra->ra_pages / 4;
 	ractl._index = ra->start;
-	page_cache_ra_order(&ractl, ra, 0);
+	page_cache_ra_order(&ractl, ra, 2);
 	return fpin;
 }
 
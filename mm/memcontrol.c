@@ -439,6 +439,7 @@ static const unsigned int memcg_vm_event_stat[] = {
 	ZSWPIN,
 	ZSWPOUT,
 	ZSWPWB,
+	ZSWPWB_THROTTLED,
 #endif
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	THP_FAULT_ALLOC,
@@ -3582,6 +3583,8 @@ mem_cgroup_css_alloc(struct cgroup_subsys_state *parent_css)
 #ifdef CONFIG_ZSWAP
 	memcg->zswap_max = PAGE_COUNTER_MAX;
 	WRITE_ONCE(memcg->zswap_writeback, true);
+	memcg->zswap_writeback_rate = PAGE_COUNTER_MAX;
+	memcg->zswap_writeback_stamp = jiffies;
 #endif
 	page_counter_set_high(&memcg->swap, PAGE_COUNTER_MAX);
 	if (parent) {
@@ -5368,6 +5371,61 @@ bool mem_cgroup_zswap_writeback_enabled(struct mem_cgroup *memcg)
 	return true;
 }
 
+/*
+ * Account one page of writeback against @memcg's budget for the current
+ * one-second window. The window is restarted lazily by whoever first sees
+ * it expire; the races around the reset only let a few pages slip through.
+ */
+static bool zswap_writeback_charge(struct mem_cgroup *memcg)
+{
+	unsigned long rate = READ_ONCE(memcg->zswap_writeback_rate);
+	unsigned long stamp;
+
+	if (rate == PAGE_COUNTER_MAX)
+		return true;
+	if (!rate)
+		return false;
+
+	stamp = READ_ONCE(memcg->zswap_writeback_stamp);
+	if (time_after_eq(jiffies, stamp + HZ) &&
+	    try_cmpxchg(&memcg->zswap_writeback_stamp, &stamp, jiffies))
+		atomic_long_set(&memcg->zswap_writeback_used, 0);
+
+	return atomic_long_inc_return(&memcg->zswap_writeback_used) <= rate;
+}
+
+/**
+ * obj_cgroup_may_zswap_writeback - check the zswap writeback rate limits
+ * @objcg: the object cgroup of the zswap entry about to be written back
+ *
+ * Charge one page against the memory.zswap.writeback.rate budget of every
+ * limited cgroup in the hierarchy. Returns false, and leaves the entry in
+ * zswap, if any of them has used up its budget for the current second, so
+ * that one cgroup cannot monopolize the swap device with writeback.
+ */
+bool obj_cgroup_may_zswap_writeback(struct obj_cgroup *objcg)
+{
+	struct mem_cgroup *memcg, *original_memcg;
+	bool ret = true;
+
+	if (!cgroup_subsys_on_dfl(memory_cgrp_subsys))
+		return true;
+
+	original_memcg = get_mem_cgroup_from_objcg(objcg);
+	for (memcg = original_memcg; !mem_cgroup_is_root(memcg);
+	     memcg = parent_mem_cgroup(memcg)) {
+		if (!zswap_writeback_charge(memcg)) {
+			ret = false;
+			break;
+		}
+	}
+
+	if (!ret)
+		count_memcg_events(original_memcg, ZSWPWB_THROTTLED, 1);
+	mem_cgroup_put(original_memcg);
+	return ret;
+}
+
 static u64 zswap_current_read(struct cgroup_subsys_state *css,
 			      struct cftype *cft)
 {
@@ -5425,6 +5483,29 @@ static ssize_t zswap_writeback_write(struct kernfs_open_file *of,
 	return nbytes;
 }
 
+static int zswap_writeback_rate_show(struct seq_file *m, void *v)
+{
+	return seq_puts_memcg_tunable(m,
+		READ_ONCE(mem_cgroup_from_seq(m)->zswap_writeback_rate));
+}
+
+static ssize_t zswap_writeback_rate_write(struct kernfs_open_file *of,
+					  char *buf, size_t nbytes, loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	unsigned long rate;
+	int err;
+
+	buf = strstrip(buf);
+	err = page_counter_memparse(buf, "max", &rate);
+	if (err)
+		return err;
+
+	WRITE_ONCE(memcg->zswap_writeback_rate, rate);
+
+	return nbytes;
+}
+
 static struct cftype zswap_files[] = {
 	{
 		.name = "zswap.current",
@@ -5442,6 +5523,12 @@ static struct cftype zswap_files[] = {
 		.seq_show = zswap_writeback_show,
 		.write = zswap_writeback_write,
 	},
+	{
+		.name = "zswap.writeback.rate",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = zswap_writeback_rate_show,
+		.write = zswap_writeback_rate_write,
+	},
 	{ }	/* terminate */
 };
 #endif /* CONFIG_ZSWAP */
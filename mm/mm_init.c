@@ -724,6 +724,26 @@ static void __meminit init_reserved_page(unsigned long pfn, int nid)
 	}
 	__init_single_page(pfn_to_page(pfn), pfn, zid, nid);
 }
+
+/*
+ * Report which part of the memory map was left to deferred_init_memmap();
+ * only the highest zone of a node is ever deferred.
+ */
+static void __init deferred_init_report(void)
+{
+	int nid;
+
+	for_each_node_state(nid, N_MEMORY) {
+		pg_data_t *pgdat = NODE_DATA(nid);
+
+		if (pgdat->first_deferred_pfn == ULONG_MAX)
+			continue;
+
+		pr_info("On node %d, memmap init of pfns %#lx-%#lx deferred\n",
+			nid, pgdat->first_deferred_pfn,
+			pgdat_end_pfn(pgdat) - 1);
+	}
+}
 #else
 static inline void pgdat_set_deferred_range(pg_data_t *pgdat) {}
 
@@ -740,6 +760,8 @@ static inline bool defer_init(int nid, unsigned long pfn, unsigned long end_pfn)
 static inline void init_reserved_page(unsigned long pfn, int nid)
 {
 }
+
+static inline void deferred_init_report(void) {}
 #endif /* CONFIG_DEFERRED_STRUCT_PAGE_INIT */
 
 /*
@@ -1857,6 +1879,7 @@ void __init free_area_init(unsigned long *max_zone_pfn)
 
 	calc_nr_kernel_pages();
 	memmap_init();
+	deferred_init_report();
 
 	/* disable hash distribution for systems with a single node */
 	fixup_hashdist();
@@ -2093,6 +2116,7 @@ static int __init deferred_init_memmap(void *data)
 	unsigned long spfn = 0, epfn = 0;
 	unsigned long first_init_pfn, flags;
 	unsigned long start = jiffies;
+	unsigned long nr_managed;
 	struct zone *zone;
 	int max_threads;
 	u64 i = 0;
@@ -2125,6 +2149,7 @@ static int __init deferred_init_memmap(void *data)
 	zone = pgdat->node_zones + pgdat->nr_zones - 1;
 
 	max_threads = deferred_page_init_max_threads(cpumask);
+	nr_managed = zone_managed_pages(zone);
 
 	while (deferred_init_mem_pfn_range_in_zone(&i, zone, &spfn, &epfn, first_init_pfn)) {
 		first_init_pfn = ALIGN(epfn, PAGES_PER_SECTION);
@@ -2142,11 +2167,14 @@ static int __init deferred_init_memmap(void *data)
 		padata_do_multithreaded(&job);
 	}
 
+	nr_managed = zone_managed_pages(zone) - nr_managed;
+
 	/* Sanity check that the next zone really is unpopulated */
 	WARN_ON(pgdat->nr_zones < MAX_NR_ZONES && populated_zone(++zone));
 
-	pr_info("node %d deferred pages initialised in %ums\n",
-		pgdat->node_id, jiffies_to_msecs(jiffies - start));
+	pr_info("node %d deferred pages initialised in %ums (%luK freed, up to %d threads)\n",
+		pgdat->node_id, jiffies_to_msecs(jiffies - start),
+		K(nr_managed), max_threads);
 
 	pgdat_init_report_one_done();
 	return 0;
@@ -471,9 +471,6 @@ void page_cache_ra_order(struct readahead_control *ractl,
 
 	limit = min(limit, index + ra->size - 1);
 
-	if (new_order < mapping_max_folio_order(mapping))
-		new_order += 2;
-
 	new_order = min(mapping_max_folio_order(mapping), new_order);
 	new_order = min_t(unsigned int, new_order, ilog2(ra->size));
 	new_order = max(new_order, min_order);
@@ -604,7 +601,7 @@ void page_cache_sync_ra(struct readahead_control *ractl,
 	ra->async_size = 1;
 readit:
 	ractl->_index = ra->start;
-	page_cache_ra_order(ractl, ra, 0);
+	page_cache_ra_order(ractl, ra, 2);
 }
 EXPORT_SYMBOL_GPL(page_cache_sync_ra);
 
@@ -670,7 +667,7 @@ void page_cache_async_ra(struct readahead_control *ractl,
 	ra->async_size = ra->size;
 readit:
 	ractl->_index = ra->start;
-	page_cache_ra_order(ractl, ra, order);
+	page_cache_ra_order(ractl, ra, order + 2);
 }
 EXPORT_SYMBOL_GPL(page_cache_async_ra);
 
@@ -187,7 +187,7 @@ static int __try_to_reclaim_swap(struct swap_info_struct *si,
 	struct address_space *address_space = swap_address_space(entry);
 	struct swap_cluster_info *ci;
 	struct folio *folio;
-	int ret, nr_pages;
+	int ret, nr_pages, i;
 	bool need_reclaim;
 
 	folio = filemap_get_folio(address_space, swap_cache_index(entry));
@@ -243,9 +243,8 @@ static int __try_to_reclaim_swap(struct swap_info_struct *si,
 	folio_set_dirty(folio);
 
 	spin_lock(&si->lock);
-	/* Only sinple page folio can be backed by zswap */
-	if (nr_pages == 1)
-		zswap_invalidate(entry);
+	for (i = 0; i < nr_pages; i++)
+		zswap_invalidate(swp_entry(si->type, offset + i));
 	swap_entry_range_free(si, entry, nr_pages);
 	spin_unlock(&si->lock);
 	ret = nr_pages;
@@ -1662,6 +1661,8 @@ void put_swap_folio(struct folio *folio, swp_entry_t entry)
 	ci = lock_cluster_or_swap_info(si, offset);
 	if (size > 1 && swap_is_has_cache(si, offset, size)) {
 		unlock_cluster_or_swap_info(si, ci);
+		for (int i = 0; i < size; i++)
+			zswap_invalidate(swp_entry(si->type, offset + i));
 		spin_lock(&si->lock);
 		swap_entry_range_free(si, entry, size);
 		spin_unlock(&si->lock);
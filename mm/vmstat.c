@@ -1428,6 +1428,7 @@ const char * const vmstat_text[] = {
 	"zswpin",
 	"zswpout",
 	"zswpwb",
+	"zswpwb_throttled",
 #endif
 #ifdef CONFIG_X86
 	"direct_map_level2_splits",
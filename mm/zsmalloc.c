@@ -1941,7 +1941,8 @@ static unsigned long zs_can_compact(struct size_class *class)
 }
 
 static unsigned long __zs_compact(struct zs_pool *pool,
-				  struct size_class *class)
+				  struct size_class *class,
+				  unsigned long budget)
 {
 	struct zspage *src_zspage = NULL;
 	struct zspage *dst_zspage = NULL;
@@ -1953,7 +1954,7 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 	 */
 	write_lock(&pool->migrate_lock);
 	spin_lock(&class->lock);
-	while (zs_can_compact(class)) {
+	while (pages_freed < budget && zs_can_compact(class)) {
 		int fg;
 
 		if (!dst_zspage) {
@@ -1978,7 +1979,8 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 		src_zspage = NULL;
 
 		if (get_fullness_group(class, dst_zspage) == ZS_INUSE_RATIO_100
-		    || rwlock_is_contended(&pool->migrate_lock)) {
+		    || rwlock_is_contended(&pool->migrate_lock)
+		    || spin_is_contended(&class->lock)) {
 			putback_zspage(class, dst_zspage);
 			dst_zspage = NULL;
 
@@ -2002,7 +2004,12 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 	return pages_freed;
 }
 
-unsigned long zs_compact(struct zs_pool *pool)
+/*
+ * Compacts size classes, largest first, until about @budget pages have been
+ * freed or nothing is left to compact.
+ */
+static unsigned long zs_compact_budget(struct zs_pool *pool,
+				       unsigned long budget)
 {
 	int i;
 	struct size_class *class;
@@ -2017,17 +2024,22 @@ unsigned long zs_compact(struct zs_pool *pool)
 	if (atomic_xchg(&pool->compaction_in_progress, 1))
 		return 0;
 
-	for (i = ZS_SIZE_CLASSES - 1; i >= 0; i--) {
+	for (i = ZS_SIZE_CLASSES - 1; i >= 0 && pages_freed < budget; i--) {
 		class = pool->size_class[i];
 		if (class->index != i)
 			continue;
-		pages_freed += __zs_compact(pool, class);
+		pages_freed += __zs_compact(pool, class, budget - pages_freed);
 	}
 	atomic_long_add(pages_freed, &pool->stats.pages_compacted);
 	atomic_set(&pool->compaction_in_progress, 0);
 
 	return pages_freed;
 }
+
+unsigned long zs_compact(struct zs_pool *pool)
+{
+	return zs_compact_budget(pool, ULONG_MAX);
+}
 EXPORT_SYMBOL_GPL(zs_compact);
 
 void zs_pool_stats(struct zs_pool *pool, struct zs_pool_stats *stats)
@@ -2046,8 +2058,13 @@ static unsigned long zs_shrinker_scan(struct shrinker *shrinker,
 	 * Compact classes and calculate compaction delta.
 	 * Can run concurrently with a manually triggered
 	 * (by user) compaction.
+	 *
+	 * Only free what this call was asked for: the shrinker core calls
+	 * back in batches until its target is met, so a large backlog is
+	 * worked off in bounded steps instead of in one long pass holding
+	 * pool->migrate_lock.
 	 */
-	pages_freed = zs_compact(pool);
+	pages_freed = zs_compact_budget(pool, sc->nr_to_scan);
 
 	return pages_freed ? pages_freed : SHRINK_STOP;
 }
@@ -930,9 +930,11 @@ static void acomp_ctx_put_unlock(struct crypto_acomp_ctx *acomp_ctx)
 	mutex_unlock(&acomp_ctx->mutex);
 }
 
-static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
+/* Called with @acomp_ctx, the caller's locked context of @pool, held */
+static bool zswap_compress(struct page *page, struct zswap_entry *entry,
+			   struct zswap_pool *pool,
+			   struct crypto_acomp_ctx *acomp_ctx)
 {
-	struct crypto_acomp_ctx *acomp_ctx;
 	struct scatterlist input, output;
 	int comp_ret = 0, alloc_ret = 0;
 	unsigned int dlen = PAGE_SIZE;
@@ -942,10 +944,9 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	gfp_t gfp;
 	u8 *dst;
 
-	acomp_ctx = acomp_ctx_get_cpu_lock(entry->pool);
 	dst = acomp_ctx->buffer;
 	sg_init_table(&input, 1);
-	sg_set_folio(&input, folio, PAGE_SIZE, 0);
+	sg_set_page(&input, page, PAGE_SIZE, 0);
 
 	/*
 	 * We need PAGE_SIZE * 2 here since there maybe over-compression case,
@@ -970,15 +971,15 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	comp_ret = crypto_wait_req(crypto_acomp_compress(acomp_ctx->req), &acomp_ctx->wait);
 	dlen = acomp_ctx->req->dlen;
 	if (comp_ret)
-		goto unlock;
+		goto out;
 
-	zpool = entry->pool->zpool;
+	zpool = pool->zpool;
 	gfp = __GFP_NORETRY | __GFP_NOWARN | __GFP_KSWAPD_RECLAIM;
 	if (zpool_malloc_support_movable(zpool))
 		gfp |= __GFP_HIGHMEM | __GFP_MOVABLE;
 	alloc_ret = zpool_malloc(zpool, dlen, gfp, &handle);
 	if (alloc_ret)
-		goto unlock;
+		goto out;
 
 	buf = zpool_map_handle(zpool, handle, ZPOOL_MM_WO);
 	memcpy(buf, dst, dlen);
@@ -987,7 +988,7 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	entry->handle = handle;
 	entry->length = dlen;
 
-unlock:
+out:
 	if (comp_ret == -ENOSPC || alloc_ret == -ENOSPC)
 		zswap_reject_compress_poor++;
 	else if (comp_ret)
@@ -995,7 +996,6 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	else if (alloc_ret)
 		zswap_reject_alloc_fail++;
 
-	acomp_ctx_put_unlock(acomp_ctx);
 	return comp_ret == 0 && alloc_ret == 0;
 }
 
@@ -1164,6 +1164,13 @@ static enum lru_status shrink_memcg_cb(struct list_head *item, struct list_lru_o
 		return LRU_ROTATE;
 	}
 
+	/*
+	 * The entry's cgroup has used up its writeback budget for now. Leave
+	 * the rest of its LRU alone until the next window opens.
+	 */
+	if (entry->objcg && !obj_cgroup_may_zswap_writeback(entry->objcg))
+		return LRU_STOP;
+
 	/*
 	 * As soon as we drop the LRU lock, the entry can be freed by
 	 * a concurrent invalidation. This means the following:
@@ -1453,22 +1460,131 @@ static void shrink_worker(struct work_struct *w)
 /*********************************
 * main API
 **********************************/
+/* Number of pages of a large folio compressed per hold of the acomp context */
+#define ZSWAP_STORE_BATCH 8
+
+/*
+ * Stores @nr pages of @folio, starting at page @start, as a batch. The entries
+ * are allocated first, the pages are then compressed under a single hold of
+ * the per-CPU acomp context, and only then are the entries published. Both
+ * the entry allocations and the xarray stores may enter direct reclaim, which
+ * can recurse into zswap_store() and the same context, so they stay outside.
+ *
+ * Each entry is accounted as it is published: it takes its own pool and objcg
+ * references, charges its compressed length to the objcg and counts as a
+ * stored page, all of which zswap_entry_free() drops again. On failure, the
+ * entries of the batch that were published are left for the caller to erase,
+ * and the ones that were not are freed here without touching any of that.
+ */
+static bool zswap_store_pages(struct folio *folio, long start, long nr,
+			      struct obj_cgroup *objcg,
+			      struct zswap_pool *pool)
+{
+	struct zswap_entry *entries[ZSWAP_STORE_BATCH], *entry, *old;
+	struct crypto_acomp_ctx *acomp_ctx;
+	long i = 0, allocated, compressed = 0;
+
+	for (allocated = 0; allocated < nr; allocated++) {
+		entry = zswap_entry_cache_alloc(GFP_KERNEL, folio_nid(folio));
+		if (!entry) {
+			zswap_reject_kmemcache_fail++;
+			goto unwind;
+		}
+		entries[allocated] = entry;
+	}
+
+	acomp_ctx = acomp_ctx_get_cpu_lock(pool);
+	while (compressed < nr &&
+	       zswap_compress(folio_page(folio, start + compressed),
+			      entries[compressed], pool, acomp_ctx))
+		compressed++;
+	acomp_ctx_put_unlock(acomp_ctx);
+	if (compressed < nr)
+		goto unwind;
+
+	for (i = 0; i < nr; i++) {
+		swp_entry_t page_swpentry;
+
+		page_swpentry = page_swap_entry(folio_page(folio, start + i));
+		entry = entries[i];
+
+		old = xa_store(swap_zswap_tree(page_swpentry),
+			       swp_offset(page_swpentry), entry, GFP_KERNEL);
+		if (xa_is_err(old)) {
+			int err = xa_err(old);
+
+			WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
+			zswap_reject_alloc_fail++;
+			goto unwind;
+		}
+
+		/*
+		 * We may have had an existing entry that became stale when
+		 * the folio was redirtied and now the new version is being
+		 * swapped out. Get rid of the old.
+		 */
+		if (old)
+			zswap_entry_free(old);
+
+		/*
+		 * The entry is in the tree and nothing can fail for it
+		 * anymore: take the references, the charge and the stored
+		 * page that zswap_entry_free() drops again when it is freed.
+		 * The caller holds a reference on both already, so these
+		 * cannot fail either.
+		 */
+		percpu_ref_get(&pool->ref);
+		if (objcg) {
+			obj_cgroup_get(objcg);
+			obj_cgroup_charge_zswap(objcg, entry->length);
+		}
+		atomic_inc(&zswap_stored_pages);
+
+		/*
+		 * We finish initializing the entry while it's already in
+		 * xarray. This is safe because:
+		 *
+		 * 1. Concurrent stores and invalidations are excluded by folio
+		 *    lock.
+		 *
+		 * 2. Writeback is excluded by the entry not being on the LRU
+		 *    yet. The publishing order matters to prevent writeback from
+		 *    seeing an incoherent entry.
+		 */
+		entry->pool = pool;
+		entry->swpentry = page_swpentry;
+		entry->objcg = objcg;
+		entry->referenced = true;
+		if (entry->length) {
+			INIT_LIST_HEAD(&entry->lru);
+			zswap_lru_add(&zswap_list_lru, entry);
+		}
+	}
+
+	return true;
+
+unwind:
+	for (; i < allocated; i++) {
+		if (i < compressed)
+			zpool_free(pool->zpool, entries[i]->handle);
+		zswap_entry_cache_free(entries[i]);
+	}
+	return false;
+}
+
 bool zswap_store(struct folio *folio)
 {
+	long nr_pages = folio_nr_pages(folio);
 	swp_entry_t swp = folio->swap;
-	pgoff_t offset = swp_offset(swp);
-	struct xarray *tree = swap_zswap_tree(swp);
-	struct zswap_entry *entry, *old;
 	struct obj_cgroup *objcg = NULL;
 	struct mem_cgroup *memcg = NULL;
+	struct zswap_pool *pool;
+	bool ret = false;
+	long index;
 
 	VM_WARN_ON_ONCE(!folio_test_locked(folio));
 	VM_WARN_ON_ONCE(!folio_test_swapcache(folio));
 
-	/* Large folios aren't supported */
-	if (folio_test_large(folio))
-		return false;
-
 	if (!zswap_enabled)
 		goto check_old;
 
@@ -1478,25 +1594,17 @@ bool zswap_store(struct folio *folio)
 		memcg = get_mem_cgroup_from_objcg(objcg);
 		if (shrink_memcg(memcg)) {
 			mem_cgroup_put(memcg);
-			goto reject;
+			goto put_objcg;
 		}
 		mem_cgroup_put(memcg);
 	}
 
 	if (zswap_check_limits())
-		goto reject;
-
-	/* allocate entry */
-	entry = zswap_entry_cache_alloc(GFP_KERNEL, folio_nid(folio));
-	if (!entry) {
-		zswap_reject_kmemcache_fail++;
-		goto reject;
-	}
+		goto put_objcg;
 
-	/* if entry is successfully added, it keeps the reference */
-	entry->pool = zswap_pool_current_get();
-	if (!entry->pool)
-		goto freepage;
+	pool = zswap_pool_current_get();
+	if (!pool)
+		goto put_objcg;
 
 	if (objcg) {
 		memcg = get_mem_cgroup_from_objcg(objcg);
@@ -1507,76 +1615,57 @@ bool zswap_store(struct folio *folio)
 		mem_cgroup_put(memcg);
 	}
 
-	if (!zswap_compress(folio, entry))
-		goto put_pool;
-
-	entry->swpentry = swp;
-	entry->objcg = objcg;
-	entry->referenced = true;
-
-	old = xa_store(tree, offset, entry, GFP_KERNEL);
-	if (xa_is_err(old)) {
-		int err = xa_err(old);
-
-		WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
-		zswap_reject_alloc_fail++;
-		goto store_failed;
-	}
-
 	/*
-	 * We may have had an existing entry that became stale when
-	 * the folio was redirtied and now the new version is being
-	 * swapped out. Get rid of the old.
+	 * Large folios are stored page by page, each page with its own entry,
+	 * so that writeback, invalidation and order-0 swapin keep working on
+	 * single swap slots. The folio is only accepted if all of its pages
+	 * are; on failure the pages stored so far are dropped again below.
 	 */
-	if (old)
-		zswap_entry_free(old);
+	for (index = 0; index < nr_pages; index += ZSWAP_STORE_BATCH) {
+		long nr = min_t(long, nr_pages - index, ZSWAP_STORE_BATCH);
 
-	if (objcg) {
-		obj_cgroup_charge_zswap(objcg, entry->length);
-		count_objcg_events(objcg, ZSWPOUT, 1);
+		if (!zswap_store_pages(folio, index, nr, objcg, pool))
+			goto put_pool;
 	}
 
-	/*
-	 * We finish initializing the entry while it's already in xarray.
-	 * This is safe because:
-	 *
-	 * 1. Concurrent stores and invalidations are excluded by folio lock.
-	 *
-	 * 2. Writeback is excluded by the entry not being on the LRU yet.
-	 *    The publishing order matters to prevent writeback from seeing
-	 *    an incoherent entry.
-	 */
-	if (entry->length) {
-		INIT_LIST_HEAD(&entry->lru);
-		zswap_lru_add(&zswap_list_lru, entry);
-	}
+	if (objcg)
+		count_objcg_events(objcg, ZSWPOUT, nr_pages);
 
 	/* update stats */
-	atomic_inc(&zswap_stored_pages);
-	count_vm_event(ZSWPOUT);
+	count_vm_events(ZSWPOUT, nr_pages);
+	if (folio_test_large(folio))
+		count_mthp_stat(folio_order(folio), MTHP_STAT_ZSWPOUT);
 
-	return true;
+	ret = true;
 
-store_failed:
-	zpool_free(entry->pool->zpool, entry->handle);
 put_pool:
-	zswap_pool_put(entry->pool);
-freepage:
-	zswap_entry_cache_free(entry);
-reject:
+	zswap_pool_put(pool);
+put_objcg:
 	obj_cgroup_put(objcg);
-	if (zswap_pool_reached_full)
+	if (!ret && zswap_pool_reached_full)
 		queue_work(shrink_wq, &zswap_shrink_work);
 check_old:
 	/*
 	 * If the zswap store fails or zswap is disabled, we must invalidate the
-	 * possibly stale entry which was previously stored at this offset.
-	 * Otherwise, writeback could overwrite the new data in the swapfile.
+	 * possibly stale entries which were previously stored at the offsets of
+	 * the folio's pages. Otherwise, writeback could overwrite the new data
+	 * in the swapfile.
 	 */
-	entry = xa_erase(tree, offset);
-	if (entry)
-		zswap_entry_free(entry);
-	return false;
+	if (!ret) {
+		unsigned int type = swp_type(swp);
+		pgoff_t offset = swp_offset(swp);
+		struct zswap_entry *entry;
+		struct xarray *tree;
+
+		for (index = 0; index < nr_pages; index++) {
+			tree = swap_zswap_tree(swp_entry(type, offset + index));
+			entry = xa_erase(tree, offset + index);
+			if (entry)
+				zswap_entry_free(entry);
+		}
+	}
+
+	return ret;
 }
 
 bool zswap_load(struct folio *folio)
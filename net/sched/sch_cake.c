@@ -254,6 +254,12 @@ struct cake_sched_data {
 	u16		max_adjlen;
 	u16		min_netlen;
 	u16		min_adjlen;
+
+	/* rate sharing with sibling instances under an mq root */
+	u64		mq_sync_time;
+	ktime_t		mq_last_sync;
+	ktime_t		mq_last_active;
+	u16		mq_active_queues;
 };
 
 enum {
@@ -280,6 +286,16 @@ static u64 us_to_ns(u64 us)
 	return us * NSEC_PER_USEC;
 }
 
+/* With mq rate sharing, each active instance shapes to an equal share of the
+ * configured rate.
+ */
+static u64 cake_shaper_rate(const struct cake_sched_data *q)
+{
+	if (q->mq_sync_time && q->mq_active_queues > 1)
+		return div_u64(q->rate_bps, q->mq_active_queues);
+	return q->rate_bps;
+}
+
 static struct cobalt_skb_cb *get_cobalt_cb(const struct sk_buff *skb)
 {
 	qdisc_cb_private_validate(skb, sizeof(struct cobalt_skb_cb));
@@ -1930,6 +1946,9 @@ static s32 cake_enqueue(struct sk_buff *skb, struct Qdisc *sch,
 		}
 		b->drop_overlimit += dropped;
 	}
+
+	if (q->mq_sync_time)
+		WRITE_ONCE(q->mq_last_active, now);
 	return NET_XMIT_SUCCESS;
 }
 
@@ -1968,6 +1987,46 @@ static void cake_clear_tin(struct Qdisc *sch, u16 tin)
 			kfree_skb(skb);
 }
 
+/* When cake runs as the child of each TX queue of an mq root, every instance
+ * has its own lock and the configured rate would be applied per queue. With
+ * mq_sync_time set, periodically count the sibling cake instances that saw
+ * traffic within the last sync period and shape to an equal share of the
+ * rate. The siblings are only read locklessly; qdiscs are freed after an RCU
+ * grace period and dequeue runs with BH disabled.
+ */
+static void cake_mq_sync(struct Qdisc *sch, ktime_t now)
+{
+	struct cake_sched_data *q = qdisc_priv(sch);
+	struct net_device *dev = qdisc_dev(sch);
+	u16 active = 1;
+	unsigned int i;
+
+	if (ktime_before(now, ktime_add_ns(q->mq_last_sync, q->mq_sync_time)))
+		return;
+	q->mq_last_sync = now;
+
+	for (i = 0; i < dev->num_tx_queues; i++) {
+		struct netdev_queue *txq = netdev_get_tx_queue(dev, i);
+		struct Qdisc *qdisc = rcu_dereference_bh(txq->qdisc_sleeping);
+		struct cake_sched_data *sq;
+
+		if (!qdisc || qdisc == sch || qdisc->ops != sch->ops)
+			continue;
+
+		sq = qdisc_priv(qdisc);
+		if (!READ_ONCE(sq->mq_sync_time))
+			continue;
+		if (ktime_before(now, ktime_add_ns(READ_ONCE(sq->mq_last_active),
+						   q->mq_sync_time)))
+			active++;
+	}
+
+	if (active != q->mq_active_queues) {
+		q->mq_active_queues = active;
+		cake_reconfigure(sch);
+	}
+}
+
 static struct sk_buff *cake_dequeue(struct Qdisc *sch)
 {
 	struct cake_sched_data *q = qdisc_priv(sch);
@@ -1980,6 +2039,9 @@ static struct sk_buff *cake_dequeue(struct Qdisc *sch)
 	u64 delay;
 	u32 len;
 
+	if (q->mq_sync_time)
+		cake_mq_sync(sch, now);
+
 begin:
 	if (!sch->q.qlen)
 		return NULL;
@@ -2249,6 +2311,7 @@ static const struct nla_policy cake_policy[TCA_CAKE_MAX + 1] = {
 	[TCA_CAKE_ACK_FILTER]	 = { .type = NLA_U32 },
 	[TCA_CAKE_SPLIT_GSO]	 = { .type = NLA_U32 },
 	[TCA_CAKE_FWMARK]	 = { .type = NLA_U32 },
+	[TCA_CAKE_MQ_SYNC_TIME]	 = { .type = NLA_U32 },
 };
 
 static void cake_set_rate(struct cake_tin_data *b, u64 rate, u32 mtu,
@@ -2295,7 +2358,7 @@ static int cake_config_besteffort(struct Qdisc *sch)
 	struct cake_sched_data *q = qdisc_priv(sch);
 	struct cake_tin_data *b = &q->tins[0];
 	u32 mtu = psched_mtu(qdisc_dev(sch));
-	u64 rate = q->rate_bps;
+	u64 rate = cake_shaper_rate(q);
 
 	q->tin_cnt = 1;
 
@@ -2314,7 +2377,7 @@ static int cake_config_precedence(struct Qdisc *sch)
 	/* convert high-level (user visible) parameters into internal format */
 	struct cake_sched_data *q = qdisc_priv(sch);
 	u32 mtu = psched_mtu(qdisc_dev(sch));
-	u64 rate = q->rate_bps;
+	u64 rate = cake_shaper_rate(q);
 	u32 quantum = 256;
 	u32 i;
 
@@ -2403,7 +2466,7 @@ static int cake_config_diffserv8(struct Qdisc *sch)
 
 	struct cake_sched_data *q = qdisc_priv(sch);
 	u32 mtu = psched_mtu(qdisc_dev(sch));
-	u64 rate = q->rate_bps;
+	u64 rate = cake_shaper_rate(q);
 	u32 quantum = 256;
 	u32 i;
 
@@ -2447,7 +2510,7 @@ static int cake_config_diffserv4(struct Qdisc *sch)
 
 	struct cake_sched_data *q = qdisc_priv(sch);
 	u32 mtu = psched_mtu(qdisc_dev(sch));
-	u64 rate = q->rate_bps;
+	u64 rate = cake_shaper_rate(q);
 	u32 quantum = 1024;
 
 	q->tin_cnt = 4;
@@ -2484,7 +2547,7 @@ static int cake_config_diffserv3(struct Qdisc *sch)
  */
 	struct cake_sched_data *q = qdisc_priv(sch);
 	u32 mtu = psched_mtu(qdisc_dev(sch));
-	u64 rate = q->rate_bps;
+	u64 rate = cake_shaper_rate(q);
 	u32 quantum = 1024;
 
 	q->tin_cnt = 3;
@@ -2686,6 +2749,12 @@ static int cake_change(struct Qdisc *sch, struct nlattr *opt,
 			   q->fwmark_mask ? __ffs(q->fwmark_mask) : 0);
 	}
 
+	if (tb[TCA_CAKE_MQ_SYNC_TIME]) {
+		WRITE_ONCE(q->mq_sync_time,
+			   us_to_ns(nla_get_u32(tb[TCA_CAKE_MQ_SYNC_TIME])));
+		q->mq_active_queues = 0;
+	}
+
 	WRITE_ONCE(q->rate_flags, rate_flags);
 	WRITE_ONCE(q->flow_mode, flow_mode);
 	if (q->tins) {
@@ -2850,6 +2919,10 @@ static int cake_dump(struct Qdisc *sch, struct sk_buff *skb)
 	if (nla_put_u32(skb, TCA_CAKE_FWMARK, READ_ONCE(q->fwmark_mask)))
 		goto nla_put_failure;
 
+	if (nla_put_u32(skb, TCA_CAKE_MQ_SYNC_TIME,
+			div_u64(READ_ONCE(q->mq_sync_time), NSEC_PER_USEC)))
+		goto nla_put_failure;
+
 	return nla_nest_end(skb, opts);
 
 nla_put_failure:
@@ -2884,6 +2957,8 @@ static int cake_dump_stats(struct Qdisc *sch, struct gnet_dump *d)
 	PUT_STAT_U32(MAX_ADJLEN, q->max_adjlen);
 	PUT_STAT_U32(MIN_NETLEN, q->min_netlen);
 	PUT_STAT_U32(MIN_ADJLEN, q->min_adjlen);
+	if (q->mq_sync_time)
+		PUT_STAT_U32(ACTIVE_QUEUES, q->mq_active_queues);
 
 #undef PUT_STAT_U32
 #undef PUT_STAT_U64
@@ -55,6 +55,9 @@ struct sched_entry {
 	 */
 	u64 gate_duration[TC_MAX_QUEUE];
 	atomic_t budget[TC_MAX_QUEUE];
+	/* Budgets to start the entry with, valid for budget_ppb */
+	int budget_init[TC_MAX_QUEUE];
+	s64 budget_ppb;
 	/* The qdisc makes some effort so that no packet leaves
 	 * after this time
 	 */
@@ -663,19 +666,29 @@ static void taprio_set_budgets(struct taprio_sched *q,
 			       struct sched_entry *entry)
 {
 	struct net_device *dev = qdisc_dev(q->root);
+	s64 picos_per_byte = atomic64_read(&q->picos_per_byte);
 	int num_tc = netdev_get_num_tc(dev);
 	int tc, budget;
 
-	for (tc = 0; tc < num_tc; tc++) {
-		/* Traffic classes which never close have infinite budget */
-		if (entry->gate_duration[tc] == sched->cycle_time)
-			budget = INT_MAX;
-		else
-			budget = div64_u64((u64)entry->gate_duration[tc] * PSEC_PER_NSEC,
-					   atomic64_read(&q->picos_per_byte));
-
-		atomic_set(&entry->budget[tc], budget);
+	/* This runs from the hrtimer on every entry, so only redo the
+	 * divisions when the link speed has changed since the last time.
+	 */
+	if (entry->budget_ppb != picos_per_byte) {
+		for (tc = 0; tc < num_tc; tc++) {
+			/* Traffic classes which never close have infinite budget */
+			if (entry->gate_duration[tc] == sched->cycle_time)
+				budget = INT_MAX;
+			else
+				budget = div64_u64((u64)entry->gate_duration[tc] * PSEC_PER_NSEC,
+						   picos_per_byte);
+
+			entry->budget_init[tc] = budget;
+		}
+		entry->budget_ppb = picos_per_byte;
 	}
+
+	for (tc = 0; tc < num_tc; tc++)
+		atomic_set(&entry->budget[tc], entry->budget_init[tc]);
 }
 
 /* When an skb is sent, it consumes from the budget of all traffic classes */
@@ -7,9 +7,13 @@
 
 #include <linux/clk.h>
 #include <linux/clk-provider.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 #include <linux/mfd/syscon.h>
 #include <linux/module.h>
+#include <linux/log2.h>
 #include <linux/of.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
@@ -29,6 +33,18 @@
 #define TRCM_TX 1
 #define TRCM_RX 2
 
+#define I2S_TDM_FIFO_DEPTH			32
+#define I2S_TDM_DMA_LEVEL_DEFAULT		16
+#define I2S_TDM_DMA_LEVEL_LOW_LATENCY		4
+#define I2S_TDM_CLK_PPM_MIN			-1000
+#define I2S_TDM_CLK_PPM_MAX			1000
+#define I2S_TDM_MAXBURST_MAX			8
+
+static bool low_latency;
+module_param(low_latency, bool, 0444);
+MODULE_PARM_DESC(low_latency,
+		 "use a DMA level of 4 unless the device tree sets one");
+
 struct txrx_config {
 	u32 addr;
 	u32 reg;
@@ -54,6 +70,7 @@ struct rk_i2s_tdm_dev {
 	struct regmap *grf;
 	struct snd_dmaengine_dai_dma_data capture_dma_data;
 	struct snd_dmaengine_dai_dma_data playback_dma_data;
+	struct snd_dmaengine_pcm_config pcm_config;
 	struct reset_control *tx_reset;
 	struct reset_control *rx_reset;
 	const struct rk_i2s_soc_data *soc_data;
@@ -71,8 +88,31 @@ struct rk_i2s_tdm_dev {
 	struct snd_soc_dai_driver *dai;
 	unsigned int mclk_rx_freq;
 	unsigned int mclk_tx_freq;
+	int clk_ppm;
+	unsigned int tx_dma_level;
+	unsigned int rx_dma_level;
+	/* sync group, protected by rockchip_i2s_tdm_sync_lock */
+	u32 sync_group;
+	struct list_head sync_node;
+	unsigned int sync_pending;
+	unsigned int sync_running;
+	/* rate tracking, protected by lock */
+	struct snd_pcm_substream *substreams[SNDRV_PCM_STREAM_LAST + 1];
+	ktime_t start_time[SNDRV_PCM_STREAM_LAST + 1];
+	snd_pcm_uframes_t start_ptr[SNDRV_PCM_STREAM_LAST + 1];
 };
 
+/*
+ * Controllers sharing a "rockchip,sync-group" id are wired to the same
+ * BCLK/LRCK. A clock consumer in the group holds back its XFER start until
+ * the clock provider starts, at which point all of them are kicked in one
+ * go, so that every member latches the same first LRCK edge. A group with
+ * no provider among its members is clocked from outside, and its members
+ * start right away.
+ */
+static LIST_HEAD(rockchip_i2s_tdm_sync_list);
+static DEFINE_SPINLOCK(rockchip_i2s_tdm_sync_lock);
+
 static int to_ch_num(unsigned int val)
 {
 	switch (val) {
@@ -209,6 +249,83 @@ static void rockchip_snd_reset(struct reset_control *rc)
 	udelay(10);
 }
 
+/*
+ * A consumer only waits when a member of its group provides the clocks and
+ * hasn't started yet. Without a provider in the group, the clocks come from
+ * outside (e.g. a codec in master mode) and there is nothing to wait for.
+ */
+static bool rockchip_snd_sync_group_wait(struct rk_i2s_tdm_dev *i2s_tdm)
+{
+	struct rk_i2s_tdm_dev *member;
+	bool has_provider = false;
+
+	list_for_each_entry(member, &rockchip_i2s_tdm_sync_list, sync_node) {
+		if (member->sync_group != i2s_tdm->sync_group ||
+		    !member->is_master_mode)
+			continue;
+
+		if (member->sync_running)
+			return false;
+
+		has_provider = true;
+	}
+
+	return has_provider;
+}
+
+static void rockchip_snd_xfer_start(struct rk_i2s_tdm_dev *i2s_tdm,
+				    unsigned int xfer)
+{
+	struct rk_i2s_tdm_dev *member;
+	unsigned long flags;
+
+	if (!i2s_tdm->sync_group) {
+		regmap_update_bits(i2s_tdm->regmap, I2S_XFER, xfer, xfer);
+		return;
+	}
+
+	spin_lock_irqsave(&rockchip_i2s_tdm_sync_lock, flags);
+	if (!i2s_tdm->is_master_mode &&
+	    rockchip_snd_sync_group_wait(i2s_tdm)) {
+		i2s_tdm->sync_pending |= xfer;
+		goto out;
+	}
+
+	if (i2s_tdm->is_master_mode) {
+		list_for_each_entry(member, &rockchip_i2s_tdm_sync_list,
+				    sync_node) {
+			if (member->sync_group != i2s_tdm->sync_group ||
+			    !member->sync_pending)
+				continue;
+
+			regmap_update_bits(member->regmap, I2S_XFER,
+					   member->sync_pending,
+					   member->sync_pending);
+			member->sync_running |= member->sync_pending;
+			member->sync_pending = 0;
+		}
+	}
+
+	regmap_update_bits(i2s_tdm->regmap, I2S_XFER, xfer, xfer);
+	i2s_tdm->sync_running |= xfer;
+out:
+	spin_unlock_irqrestore(&rockchip_i2s_tdm_sync_lock, flags);
+}
+
+static void rockchip_snd_xfer_stop(struct rk_i2s_tdm_dev *i2s_tdm,
+				   unsigned int xfer)
+{
+	unsigned long flags;
+
+	if (!i2s_tdm->sync_group)
+		return;
+
+	spin_lock_irqsave(&rockchip_i2s_tdm_sync_lock, flags);
+	i2s_tdm->sync_pending &= ~xfer;
+	i2s_tdm->sync_running &= ~xfer;
+	spin_unlock_irqrestore(&rockchip_i2s_tdm_sync_lock, flags);
+}
+
 static void rockchip_snd_xfer_clear(struct rk_i2s_tdm_dev *i2s_tdm,
 				    unsigned int clr)
 {
@@ -231,6 +348,7 @@ static void rockchip_snd_xfer_clear(struct rk_i2s_tdm_dev *i2s_tdm,
 		xfer_val |= I2S_XFER_RXS_STOP;
 	}
 
+	rockchip_snd_xfer_stop(i2s_tdm, xfer_mask);
 	regmap_update_bits(i2s_tdm->regmap, I2S_XFER, xfer_mask, xfer_val);
 	udelay(150);
 	regmap_update_bits(i2s_tdm->regmap, I2S_CLR, clr, clr);
@@ -295,11 +413,8 @@ static void rockchip_snd_txrxctrl(struct snd_pcm_substream *substream,
 
 		if (++i2s_tdm->refcount == 1) {
 			rockchip_snd_xfer_sync_reset(i2s_tdm);
-			regmap_update_bits(i2s_tdm->regmap, I2S_XFER,
-					   I2S_XFER_TXS_START |
-					   I2S_XFER_RXS_START,
-					   I2S_XFER_TXS_START |
-					   I2S_XFER_RXS_START);
+			rockchip_snd_xfer_start(i2s_tdm, I2S_XFER_TXS_START |
+						I2S_XFER_RXS_START);
 		}
 	} else {
 		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
@@ -320,9 +435,7 @@ static void rockchip_snd_txctrl(struct rk_i2s_tdm_dev *i2s_tdm, int on)
 	if (on) {
 		rockchip_enable_tde(i2s_tdm->regmap);
 
-		regmap_update_bits(i2s_tdm->regmap, I2S_XFER,
-				   I2S_XFER_TXS_START,
-				   I2S_XFER_TXS_START);
+		rockchip_snd_xfer_start(i2s_tdm, I2S_XFER_TXS_START);
 	} else {
 		rockchip_disable_tde(i2s_tdm->regmap);
 
@@ -335,9 +448,7 @@ static void rockchip_snd_rxctrl(struct rk_i2s_tdm_dev *i2s_tdm, int on)
 	if (on) {
 		rockchip_enable_rde(i2s_tdm->regmap);
 
-		regmap_update_bits(i2s_tdm->regmap, I2S_XFER,
-				   I2S_XFER_RXS_START,
-				   I2S_XFER_RXS_START);
+		rockchip_snd_xfer_start(i2s_tdm, I2S_XFER_RXS_START);
 	} else {
 		rockchip_disable_rde(i2s_tdm->regmap);
 
@@ -667,6 +778,13 @@ static int rockchip_i2s_tdm_set_sysclk(struct snd_soc_dai *cpu_dai, int stream,
 	return 0;
 }
 
+/* Returns @freq trimmed by the "PCM Clock Compensation In PPM" control */
+static unsigned long rockchip_i2s_tdm_trim_rate(struct rk_i2s_tdm_dev *i2s_tdm,
+						unsigned int freq)
+{
+	return freq + div_s64((s64)freq * i2s_tdm->clk_ppm, 1000000);
+}
+
 static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 				      struct snd_pcm_hw_params *params,
 				      struct snd_soc_dai *dai)
@@ -693,7 +811,8 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 			mclk_rate = i2s_tdm->mclk_rx_freq;
 		}
 
-		err = clk_set_rate(mclk, mclk_rate);
+		err = clk_set_rate(mclk, rockchip_i2s_tdm_trim_rate(i2s_tdm,
+								   mclk_rate));
 		if (err)
 			return err;
 
@@ -770,6 +889,23 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 	return rockchip_i2s_io_multiplex(substream, dai);
 }
 
+static void rockchip_i2s_tdm_track(struct rk_i2s_tdm_dev *i2s_tdm,
+				   struct snd_pcm_substream *substream, bool on)
+{
+	int stream = substream->stream;
+	unsigned long flags;
+
+	spin_lock_irqsave(&i2s_tdm->lock, flags);
+	if (on) {
+		i2s_tdm->substreams[stream] = substream;
+		i2s_tdm->start_time[stream] = ktime_get();
+		i2s_tdm->start_ptr[stream] = substream->runtime->status->hw_ptr;
+	} else {
+		i2s_tdm->substreams[stream] = NULL;
+	}
+	spin_unlock_irqrestore(&i2s_tdm->lock, flags);
+}
+
 static int rockchip_i2s_tdm_trigger(struct snd_pcm_substream *substream,
 				    int cmd, struct snd_soc_dai *dai)
 {
@@ -779,6 +915,7 @@ static int rockchip_i2s_tdm_trigger(struct snd_pcm_substream *substream,
 	case SNDRV_PCM_TRIGGER_START:
 	case SNDRV_PCM_TRIGGER_RESUME:
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
+		rockchip_i2s_tdm_track(i2s_tdm, substream, true);
 		if (i2s_tdm->clk_trcm)
 			rockchip_snd_txrxctrl(substream, dai, 1);
 		else if (substream->stream == SNDRV_PCM_STREAM_CAPTURE)
@@ -789,6 +926,7 @@ static int rockchip_i2s_tdm_trigger(struct snd_pcm_substream *substream,
 	case SNDRV_PCM_TRIGGER_SUSPEND:
 	case SNDRV_PCM_TRIGGER_STOP:
 	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
+		rockchip_i2s_tdm_track(i2s_tdm, substream, false);
 		if (i2s_tdm->clk_trcm)
 			rockchip_snd_txrxctrl(substream, dai, 0);
 		else if (substream->stream == SNDRV_PCM_STREAM_CAPTURE)
@@ -803,6 +941,78 @@ static int rockchip_i2s_tdm_trigger(struct snd_pcm_substream *substream,
 	return 0;
 }
 
+/*
+ * Report the frames sitting in the lane 0 FIFO, which carries two
+ * channels in I2S mode and every slot in TDM mode. Along with the DMA
+ * residue this makes the ALSA position and audio_tstamp cover the FIFO.
+ */
+static snd_pcm_sframes_t rockchip_i2s_tdm_delay(struct snd_pcm_substream *substream,
+						struct snd_soc_dai *dai)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = to_info(dai);
+	unsigned int channels = substream->runtime->channels;
+	unsigned int val, level;
+
+	if (!i2s_tdm->tdm_mode)
+		channels = min(channels, 2U);
+
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		regmap_read(i2s_tdm->regmap, I2S_TXFIFOLR, &val);
+		level = (val & I2S_FIFOLR_TFL0_MASK) >> I2S_FIFOLR_TFL0_SHIFT;
+	} else {
+		regmap_read(i2s_tdm->regmap, I2S_RXFIFOLR, &val);
+		level = (val & I2S_RXFIFOLR_RFL0_MASK) >> I2S_RXFIFOLR_RFL0_SHIFT;
+	}
+
+	return level / channels;
+}
+
+#ifdef CONFIG_DEBUG_FS
+/*
+ * Average LRCK rate of each running stream since it was started, measured
+ * against the system clock. The resolution is one period over the
+ * elapsed time, so the figure settles the longer the stream runs.
+ */
+static int rockchip_i2s_tdm_rate_show(struct seq_file *s, void *unused)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = s->private;
+	struct snd_pcm_substream *substream;
+	unsigned long flags;
+	unsigned int rate;
+	u64 frames, elapsed, mhz;
+	s64 ppm;
+	int i;
+
+	for (i = 0; i <= SNDRV_PCM_STREAM_LAST; i++) {
+		spin_lock_irqsave(&i2s_tdm->lock, flags);
+		substream = i2s_tdm->substreams[i];
+		if (!substream) {
+			spin_unlock_irqrestore(&i2s_tdm->lock, flags);
+			continue;
+		}
+		rate = substream->runtime->rate;
+		frames = substream->runtime->status->hw_ptr -
+			 i2s_tdm->start_ptr[i];
+		elapsed = ktime_to_ns(ktime_sub(ktime_get(),
+						i2s_tdm->start_time[i]));
+		spin_unlock_irqrestore(&i2s_tdm->lock, flags);
+
+		if (!elapsed || !frames)
+			continue;
+
+		mhz = mul_u64_u64_div_u64(frames, NSEC_PER_SEC * 1000ULL,
+					  elapsed);
+		ppm = div_s64(((s64)mhz - rate * 1000LL) * 1000, rate);
+		seq_printf(s, "%s: nominal %u Hz measured %llu.%03llu Hz drift %lld ppm\n",
+			   i == SNDRV_PCM_STREAM_PLAYBACK ? "playback" : "capture",
+			   rate, mhz / 1000, mhz % 1000, ppm);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rockchip_i2s_tdm_rate);
+#endif
+
 static int rockchip_i2s_tdm_dai_probe(struct snd_soc_dai *dai)
 {
 	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_dai_get_drvdata(dai);
@@ -812,6 +1022,11 @@ static int rockchip_i2s_tdm_dai_probe(struct snd_soc_dai *dai)
 	if (i2s_tdm->has_playback)
 		snd_soc_dai_dma_data_set_playback(dai, &i2s_tdm->playback_dma_data);
 
+#ifdef CONFIG_DEBUG_FS
+	debugfs_create_file("rate", 0444, dai->component->debugfs_root,
+			    i2s_tdm, &rockchip_i2s_tdm_rate_fops);
+#endif
+
 	return 0;
 }
 
@@ -856,10 +1071,95 @@ static const struct snd_soc_dai_ops rockchip_i2s_tdm_dai_ops = {
 	.set_sysclk = rockchip_i2s_tdm_set_sysclk,
 	.set_tdm_slot = rockchip_dai_tdm_slot,
 	.trigger = rockchip_i2s_tdm_trigger,
+	.delay = rockchip_i2s_tdm_delay,
+};
+
+static int rockchip_i2s_tdm_clk_ppm_info(struct snd_kcontrol *kcontrol,
+					 struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = I2S_TDM_CLK_PPM_MIN;
+	uinfo->value.integer.max = I2S_TDM_CLK_PPM_MAX;
+	uinfo->value.integer.step = 1;
+
+	return 0;
+}
+
+static int rockchip_i2s_tdm_clk_ppm_get(struct snd_kcontrol *kcontrol,
+					struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.integer.value[0] = i2s_tdm->clk_ppm;
+
+	return 0;
+}
+
+/*
+ * Trim the MCLKs to keep a stream in step with a remote clock, e.g. the
+ * sender of a network stream, instead of resampling. The I2S dividers are
+ * left alone, so BCLK and LRCK follow the MCLK and a running stream picks
+ * up the change right away. Only a clock master has MCLKs to trim, so the
+ * control is refused in slave mode.
+ */
+static int rockchip_i2s_tdm_clk_ppm_put(struct snd_kcontrol *kcontrol,
+					struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_soc_kcontrol_component(kcontrol);
+	struct rk_i2s_tdm_dev *i2s_tdm = snd_soc_component_get_drvdata(component);
+	int ppm = ucontrol->value.integer.value[0];
+	int old_ppm = i2s_tdm->clk_ppm;
+	int ret = 0;
+
+	if (ppm < I2S_TDM_CLK_PPM_MIN || ppm > I2S_TDM_CLK_PPM_MAX)
+		return -EINVAL;
+
+	/* BCLK and LRCK come from the codec, there is no clock to trim */
+	if (!i2s_tdm->is_master_mode)
+		return -EBUSY;
+
+	if (ppm == i2s_tdm->clk_ppm)
+		return 0;
+
+	i2s_tdm->clk_ppm = ppm;
+
+	if (i2s_tdm->mclk_tx_freq)
+		ret = clk_set_rate(i2s_tdm->mclk_tx,
+				   rockchip_i2s_tdm_trim_rate(i2s_tdm,
+							      i2s_tdm->mclk_tx_freq));
+	if (!ret && i2s_tdm->mclk_rx_freq)
+		ret = clk_set_rate(i2s_tdm->mclk_rx,
+				   rockchip_i2s_tdm_trim_rate(i2s_tdm,
+							      i2s_tdm->mclk_rx_freq));
+	if (ret) {
+		/* Put TX back too, so both directions keep the old trim */
+		i2s_tdm->clk_ppm = old_ppm;
+		if (i2s_tdm->mclk_tx_freq)
+			clk_set_rate(i2s_tdm->mclk_tx,
+				     rockchip_i2s_tdm_trim_rate(i2s_tdm,
+								i2s_tdm->mclk_tx_freq));
+		return ret;
+	}
+
+	return 1;
+}
+
+static const struct snd_kcontrol_new rockchip_i2s_tdm_controls[] = {
+	{
+		.iface = SNDRV_CTL_ELEM_IFACE_MIXER,
+		.name = "PCM Clock Compensation In PPM",
+		.info = rockchip_i2s_tdm_clk_ppm_info,
+		.get = rockchip_i2s_tdm_clk_ppm_get,
+		.put = rockchip_i2s_tdm_clk_ppm_put,
+	},
 };
 
 static const struct snd_soc_component_driver rockchip_i2s_tdm_component = {
 	.name = DRV_NAME,
+	.controls = rockchip_i2s_tdm_controls,
+	.num_controls = ARRAY_SIZE(rockchip_i2s_tdm_controls),
 	.legacy_dai_naming = 1,
 };
 
@@ -1247,9 +1547,72 @@ static int rockchip_i2s_tdm_rx_path_prepare(struct rk_i2s_tdm_dev *i2s_tdm,
 	return rockchip_i2s_tdm_path_prepare(i2s_tdm, np, 1);
 }
 
+/*
+ * The TX request fires once the FIFO drains to tx_dma_level entries and the
+ * RX request once it fills to rx_dma_level, so keeping both small shortens
+ * the time a sample spends in the FIFO. The burst has to fit in the room
+ * (TX) or in the data (RX) available at request time.
+ */
+static int rockchip_i2s_tdm_dma_level_init(struct rk_i2s_tdm_dev *i2s_tdm,
+					   struct device_node *np)
+{
+	unsigned int level = I2S_TDM_DMA_LEVEL_DEFAULT;
+
+	if (low_latency)
+		level = I2S_TDM_DMA_LEVEL_LOW_LATENCY;
+
+	i2s_tdm->tx_dma_level = level;
+	i2s_tdm->rx_dma_level = level;
+	of_property_read_u32(np, "rockchip,tx-dma-level", &i2s_tdm->tx_dma_level);
+	of_property_read_u32(np, "rockchip,rx-dma-level", &i2s_tdm->rx_dma_level);
+
+	if (i2s_tdm->tx_dma_level >= I2S_TDM_FIFO_DEPTH ||
+	    !i2s_tdm->rx_dma_level ||
+	    i2s_tdm->rx_dma_level > I2S_TDM_FIFO_DEPTH) {
+		dev_err(i2s_tdm->dev, "invalid DMA level tx %u rx %u\n",
+			i2s_tdm->tx_dma_level, i2s_tdm->rx_dma_level);
+		return -EINVAL;
+	}
+
+	i2s_tdm->playback_dma_data.maxburst =
+		rounddown_pow_of_two(min_t(unsigned int,
+					   I2S_TDM_FIFO_DEPTH - i2s_tdm->tx_dma_level,
+					   I2S_TDM_MAXBURST_MAX));
+	i2s_tdm->capture_dma_data.maxburst =
+		rounddown_pow_of_two(min_t(unsigned int, i2s_tdm->rx_dma_level,
+					   I2S_TDM_MAXBURST_MAX));
+
+	return 0;
+}
+
+static void rockchip_i2s_tdm_sync_del(void *data)
+{
+	struct rk_i2s_tdm_dev *i2s_tdm = data;
+
+	spin_lock_irq(&rockchip_i2s_tdm_sync_lock);
+	list_del(&i2s_tdm->sync_node);
+	spin_unlock_irq(&rockchip_i2s_tdm_sync_lock);
+}
+
+static int rockchip_i2s_tdm_sync_add(struct rk_i2s_tdm_dev *i2s_tdm,
+				     struct device_node *np)
+{
+	of_property_read_u32(np, "rockchip,sync-group", &i2s_tdm->sync_group);
+	if (!i2s_tdm->sync_group)
+		return 0;
+
+	spin_lock_irq(&rockchip_i2s_tdm_sync_lock);
+	list_add_tail(&i2s_tdm->sync_node, &rockchip_i2s_tdm_sync_list);
+	spin_unlock_irq(&rockchip_i2s_tdm_sync_lock);
+
+	return devm_add_action_or_reset(i2s_tdm->dev, rockchip_i2s_tdm_sync_del,
+					i2s_tdm);
+}
+
 static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 {
 	struct device_node *node = pdev->dev.of_node;
+	const struct snd_dmaengine_pcm_config *pcm_config = NULL;
 	struct rk_i2s_tdm_dev *i2s_tdm;
 	struct resource *res;
 	void __iomem *regs;
@@ -1334,15 +1697,17 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	if (i2s_tdm->has_playback) {
 		i2s_tdm->playback_dma_data.addr = res->start + I2S_TXDR;
 		i2s_tdm->playback_dma_data.addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
-		i2s_tdm->playback_dma_data.maxburst = 8;
 	}
 
 	if (i2s_tdm->has_capture) {
 		i2s_tdm->capture_dma_data.addr = res->start + I2S_RXDR;
 		i2s_tdm->capture_dma_data.addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
-		i2s_tdm->capture_dma_data.maxburst = 8;
 	}
 
+	ret = rockchip_i2s_tdm_dma_level_init(i2s_tdm, node);
+	if (ret)
+		return ret;
+
 	ret = rockchip_i2s_tdm_tx_path_prepare(i2s_tdm, node);
 	if (ret < 0) {
 		dev_err(&pdev->dev, "I2S TX path prepare failed: %d\n", ret);
@@ -1373,15 +1738,19 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 	pm_runtime_enable(&pdev->dev);
 
 	regmap_update_bits(i2s_tdm->regmap, I2S_DMACR, I2S_DMACR_TDL_MASK,
-			   I2S_DMACR_TDL(16));
+			   I2S_DMACR_TDL(i2s_tdm->tx_dma_level));
 	regmap_update_bits(i2s_tdm->regmap, I2S_DMACR, I2S_DMACR_RDL_MASK,
-			   I2S_DMACR_RDL(16));
+			   I2S_DMACR_RDL(i2s_tdm->rx_dma_level));
 	regmap_update_bits(i2s_tdm->regmap, I2S_CKR, I2S_CKR_TRCM_MASK,
 			   i2s_tdm->clk_trcm << I2S_CKR_TRCM_SHIFT);
 
 	if (i2s_tdm->soc_data && i2s_tdm->soc_data->init)
 		i2s_tdm->soc_data->init(&pdev->dev, res->start);
 
+	ret = rockchip_i2s_tdm_sync_add(i2s_tdm, node);
+	if (ret)
+		goto err_suspend;
+
 	ret = devm_snd_soc_register_component(&pdev->dev,
 					      &rockchip_i2s_tdm_component,
 					      i2s_tdm->dai, 1);
@@ -1391,7 +1760,19 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 		goto err_suspend;
 	}
 
-	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, 0);
+	/*
+	 * The generic PCM allocates from the DMA controller's "iram" pool
+	 * when there is one, so a prealloc size that fits keeps the ring
+	 * buffers in on-chip SRAM.
+	 */
+	if (!of_property_read_u32(node, "rockchip,prealloc-buffer-size",
+				  &i2s_tdm->pcm_config.prealloc_buffer_size)) {
+		i2s_tdm->pcm_config.prepare_slave_config =
+			snd_dmaengine_pcm_prepare_slave_config;
+		pcm_config = &i2s_tdm->pcm_config;
+	}
+
+	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, pcm_config, 0);
 	if (ret) {
 		dev_err(&pdev->dev, "Could not register PCM\n");
 		goto err_suspend;
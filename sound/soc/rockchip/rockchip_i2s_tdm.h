@@ -132,6 +132,8 @@
 #define I2S_FIFOLR_TFL1_MASK	(0x3f << I2S_FIFOLR_TFL1_SHIFT)
 #define I2S_FIFOLR_TFL0_SHIFT	0
 #define I2S_FIFOLR_TFL0_MASK	(0x3f << I2S_FIFOLR_TFL0_SHIFT)
+#define I2S_RXFIFOLR_RFL0_SHIFT	0
+#define I2S_RXFIFOLR_RFL0_MASK	(0x3f << I2S_RXFIFOLR_RFL0_SHIFT)
 
 /*
  * DMACR
@@ -33,6 +33,7 @@ struct rk_pdm_dev {
 	struct clk *hclk;
 	struct regmap *regmap;
 	struct snd_dmaengine_dai_dma_data capture_dma_data;
+	struct snd_dmaengine_pcm_config pcm_config;
 	struct reset_control *reset;
 	enum rk_pdm_version version;
 };
@@ -571,6 +572,7 @@ static int rockchip_pdm_path_parse(struct rk_pdm_dev *pdm, struct device_node *n
 static int rockchip_pdm_probe(struct platform_device *pdev)
 {
 	struct device_node *node = pdev->dev.of_node;
+	const struct snd_dmaengine_pcm_config *pcm_config = NULL;
 	struct rk_pdm_dev *pdm;
 	struct resource *res;
 	void __iomem *regs;
@@ -637,7 +639,15 @@ static int rockchip_pdm_probe(struct platform_device *pdev)
 	if (ret != 0 && ret != -ENOENT)
 		goto err_suspend;
 
-	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, 0);
+	/* A small enough buffer is taken from the DMAC's SRAM pool */
+	if (!of_property_read_u32(node, "rockchip,prealloc-buffer-size",
+				  &pdm->pcm_config.prealloc_buffer_size)) {
+		pdm->pcm_config.prepare_slave_config =
+			snd_dmaengine_pcm_prepare_slave_config;
+		pcm_config = &pdm->pcm_config;
+	}
+
+	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, pcm_config, 0);
 	if (ret) {
 		dev_err(&pdev->dev, "could not register pcm: %d\n", ret);
 		goto err_suspend;
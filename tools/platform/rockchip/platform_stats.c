@@ -0,0 +1,678 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Platform counter collector for Rockchip SoCs.
+ *
+ * Samples, every INTERVAL_MS milliseconds and in a single pass:
+ *
+ *  - the ethtool statistics of every stmmac (st_gmac) interface,
+ *  - the DDR read/write bytes and cycles of the rockchip_ddr perf PMU, read
+ *    as one perf event group,
+ *  - the current frequency of every cpufreq policy and devfreq device, and
+ *    the number of cpufreq transitions,
+ *  - the time every devfreq device, the GPU included, spent at each of its
+ *    frequencies and its number of transitions, from its trans_stat file,
+ *  - the temperature of every thermal zone,
+ *  - the I/O counters of every mmcblk device,
+ *
+ * and appends them as one record to a ring buffer in a file, /dev/shm by
+ * default, that any number of readers can mmap. Sources missing on the
+ * running system are skipped.
+ *
+ * The GPU busy time panfrost feeds its governor with is not exported; its
+ * residency at each frequency is the closest cumulative load figure.
+ *
+ * The ring is set up in a new file that is then renamed over the old one,
+ * so that readers still mapping a previous ring keep it instead of faulting
+ * on a truncated file.
+ *
+ * The counters live in different subsystems and cannot be read atomically;
+ * each record carries the time the pass started and how long it took, which
+ * bounds the skew between its counters. A counter that could not be read
+ * during a pass is 0 in that record.
+ *
+ * Ring layout, all fields native endian:
+ *
+ *	struct ring_hdr				at offset 0
+ *	char names[nr_counters][NAME_LEN]	at names_offset
+ *	struct ring_rec records[nr_slots]	at data_offset
+ *
+ * Record i lives in slot i % nr_slots. Its seq is set to 0 while it is
+ * written and to i + 1 once complete, after which head is set to i + 1. A
+ * reader copies a record and checks that seq did not change meanwhile.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <linux/ethtool.h>
+#include <linux/perf_event.h>
+#include <linux/sockios.h>
+
+#define RING_MAGIC	"RKSTATS1"
+#define RING_VERSION	1
+#define NAME_LEN	64
+#define MAX_COUNTERS	1024
+#define MAX_SOURCES	128
+#define DDR_PMU		"/sys/bus/event_source/devices/rockchip_ddr"
+
+struct ring_hdr {
+	char magic[8];
+	uint32_t version;
+	uint32_t nr_counters;
+	uint32_t nr_slots;
+	uint32_t interval_ms;
+	uint64_t rec_size;
+	uint64_t names_offset;
+	uint64_t data_offset;
+	uint64_t head;
+};
+
+struct ring_rec {
+	uint64_t seq;
+	uint64_t time_ns;	/* CLOCK_MONOTONIC at the start of the pass */
+	uint64_t dur_ns;	/* time taken to read all counters */
+	uint64_t val[];
+};
+
+enum source_type {
+	SRC_SYSFS,		/* one value per file */
+	SRC_BLOCK_STAT,		/* selected fields of a block stat file */
+	SRC_DEVFREQ_STAT,	/* time in state and transitions of a devfreq */
+	SRC_ETHTOOL,
+	SRC_PERF_GROUP,
+};
+
+struct source {
+	enum source_type type;
+	int fd;
+	unsigned int first, count;
+	char ifname[IF_NAMESIZE];
+	struct ethtool_stats *estats;
+};
+
+/* Fields of /sys/block/<dev>/stat, see Documentation/block/stat.rst */
+static const struct {
+	unsigned int field;
+	const char *name;
+} block_fields[] = {
+	{ 0, "read_ios" },
+	{ 2, "read_sectors" },
+	{ 4, "write_ios" },
+	{ 6, "write_sectors" },
+	{ 9, "io_ticks" },
+};
+
+static const char * const ddr_events[] = {
+	"cycles", "read-bytes", "write-bytes",
+};
+
+static struct source sources[MAX_SOURCES];
+static unsigned int nr_sources;
+static char names[MAX_COUNTERS][NAME_LEN];
+static unsigned int nr_counters;
+static volatile sig_atomic_t stop;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sigint_handler(int dummy)
+{
+	stop = 1;
+}
+
+static struct source *add_source(enum source_type type, int fd,
+				 unsigned int count)
+{
+	struct source *src;
+
+	if (nr_sources == MAX_SOURCES || nr_counters + count > MAX_COUNTERS) {
+		fprintf(stderr, "too many counters, ignoring the rest\n");
+		return NULL;
+	}
+
+	src = &sources[nr_sources++];
+	src->type = type;
+	src->fd = fd;
+	src->first = nr_counters;
+	src->count = count;
+	nr_counters += count;
+
+	return src;
+}
+
+static void add_sysfs_glob(const char *pattern, int name_depth,
+			   const char *suffix)
+{
+	glob_t g;
+	size_t i;
+
+	if (glob(pattern, 0, NULL, &g))
+		return;
+
+	for (i = 0; i < g.gl_pathc; i++) {
+		char *path = g.gl_pathv[i], *p = path + strlen(path);
+		struct source *src;
+		int depth = 0, fd;
+
+		fd = open(path, O_RDONLY);
+		if (fd < 0)
+			continue;
+
+		src = add_source(SRC_SYSFS, fd, 1);
+		if (!src) {
+			close(fd);
+			break;
+		}
+
+		/* Name the counter after the directory name_depth levels up */
+		while (p > path && depth <= name_depth) {
+			if (*--p == '/')
+				depth++;
+		}
+		snprintf(names[src->first], NAME_LEN, "%.*s.%s",
+			 (int)strcspn(p + 1, "/"), p + 1, suffix);
+	}
+
+	globfree(&g);
+}
+
+static void add_block_stats(void)
+{
+	unsigned int j;
+	glob_t g;
+	size_t i;
+
+	if (glob("/sys/block/mmcblk*/stat", 0, NULL, &g))
+		return;
+
+	for (i = 0; i < g.gl_pathc; i++) {
+		const char *dev = g.gl_pathv[i] + strlen("/sys/block/");
+		struct source *src;
+		int fd;
+
+		fd = open(g.gl_pathv[i], O_RDONLY);
+		if (fd < 0)
+			continue;
+
+		src = add_source(SRC_BLOCK_STAT, fd, sizeof(block_fields) /
+						     sizeof(block_fields[0]));
+		if (!src) {
+			close(fd);
+			break;
+		}
+
+		for (j = 0; j < src->count; j++)
+			snprintf(names[src->first + j], NAME_LEN, "%.*s.%s",
+				 (int)strcspn(dev, "/"), dev,
+				 block_fields[j].name);
+	}
+
+	globfree(&g);
+}
+
+/*
+ * Parses a devfreq trans_stat file into the frequency and the time in ms spent
+ * at it of at most max_rows rows, and the total number of transitions. Returns
+ * the number of rows, or -1 if the file could not be read.
+ */
+static int read_trans_stat(int fd, uint64_t *freq, uint64_t *time_ms,
+			   unsigned int max_rows, uint64_t *total_trans)
+{
+	char buf[4096], *line, *save;
+	unsigned long long n;
+	unsigned int rows = 0;
+	ssize_t ret;
+
+	ret = pread(fd, buf, sizeof(buf) - 1, 0);
+	if (ret <= 0)
+		return -1;
+	buf[ret] = '\0';
+
+	for (line = strtok_r(buf, "\n", &save); line;
+	     line = strtok_r(NULL, "\n", &save)) {
+		char *end;
+
+		if (sscanf(line, "Total transition : %llu", &n) == 1) {
+			*total_trans = n;
+			continue;
+		}
+
+		/* "*<freq>: <transitions...> <time>", '*' marks the current one */
+		if ((*line != '*' && *line != ' ') || rows == max_rows)
+			continue;
+		n = strtoull(line + 1, &end, 10);
+		if (end == line + 1 || *end != ':')
+			continue;
+
+		if (freq)
+			freq[rows] = n;
+		time_ms[rows++] = strtoull(strrchr(line, ' '), NULL, 10);
+	}
+
+	return rows;
+}
+
+static void add_devfreq_stats(void)
+{
+	uint64_t freq[MAX_COUNTERS], time_ms[MAX_COUNTERS], total;
+	glob_t g;
+	size_t i;
+
+	if (glob("/sys/class/devfreq/*/trans_stat", 0, NULL, &g))
+		return;
+
+	for (i = 0; i < g.gl_pathc; i++) {
+		const char *dev = g.gl_pathv[i] + strlen("/sys/class/devfreq/");
+		int len = strcspn(dev, "/");
+		struct source *src;
+		int fd, rows, j;
+
+		fd = open(g.gl_pathv[i], O_RDONLY);
+		if (fd < 0)
+			continue;
+
+		/* Devices without a frequency table keep no statistics */
+		rows = read_trans_stat(fd, freq, time_ms, MAX_COUNTERS, &total);
+		if (rows <= 0) {
+			close(fd);
+			continue;
+		}
+
+		src = add_source(SRC_DEVFREQ_STAT, fd, rows + 1);
+		if (!src) {
+			close(fd);
+			break;
+		}
+
+		for (j = 0; j < rows; j++)
+			snprintf(names[src->first + j], NAME_LEN,
+				 "%.*s.time_ms.%llu", len, dev,
+				 (unsigned long long)freq[j]);
+		snprintf(names[src->first + rows], NAME_LEN, "%.*s.total_trans",
+			 len, dev);
+	}
+
+	globfree(&g);
+}
+
+static int ethtool_ioctl(int sock, const char *ifname, void *data)
+{
+	struct ifreq ifr = {};
+
+	snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+	ifr.ifr_data = data;
+
+	return ioctl(sock, SIOCETHTOOL, &ifr);
+}
+
+static void add_ethtool_stats(int sock)
+{
+	struct if_nameindex *ifs, *it;
+
+	ifs = if_nameindex();
+	if (!ifs)
+		return;
+
+	for (it = ifs; it->if_index; it++) {
+		struct ethtool_drvinfo drvinfo = { .cmd = ETHTOOL_GDRVINFO };
+		struct ethtool_gstrings *strings;
+		struct source *src;
+		unsigned int j, n;
+
+		if (ethtool_ioctl(sock, it->if_name, &drvinfo) ||
+		    strcmp(drvinfo.driver, "st_gmac") || !drvinfo.n_stats)
+			continue;
+
+		n = drvinfo.n_stats;
+		strings = calloc(1, sizeof(*strings) + n * ETH_GSTRING_LEN);
+		if (!strings)
+			break;
+
+		strings->cmd = ETHTOOL_GSTRINGS;
+		strings->string_set = ETH_SS_STATS;
+		strings->len = n;
+		if (ethtool_ioctl(sock, it->if_name, strings)) {
+			free(strings);
+			continue;
+		}
+
+		src = add_source(SRC_ETHTOOL, sock, n);
+		if (!src) {
+			free(strings);
+			break;
+		}
+
+		src->estats = calloc(1, sizeof(*src->estats) + n * sizeof(__u64));
+		if (!src->estats) {
+			free(strings);
+			nr_sources--;
+			nr_counters -= n;
+			break;
+		}
+		src->estats->cmd = ETHTOOL_GSTATS;
+		src->estats->n_stats = n;
+		snprintf(src->ifname, sizeof(src->ifname), "%s", it->if_name);
+
+		for (j = 0; j < n; j++)
+			snprintf(names[src->first + j], NAME_LEN, "%s.%.*s",
+				 it->if_name, ETH_GSTRING_LEN,
+				 (char *)strings->data + j * ETH_GSTRING_LEN);
+		free(strings);
+	}
+
+	if_freenameindex(ifs);
+}
+
+static int read_pmu_file(const char *file, char *buf, size_t len)
+{
+	char path[256];
+	ssize_t ret;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", DDR_PMU, file);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	ret = read(fd, buf, len - 1);
+	close(fd);
+	if (ret <= 0)
+		return -1;
+	buf[ret] = '\0';
+
+	return 0;
+}
+
+static void add_ddr_pmu(void)
+{
+	int fds[sizeof(ddr_events) / sizeof(ddr_events[0])];
+	unsigned int i, n = sizeof(ddr_events) / sizeof(ddr_events[0]);
+	struct source *src = NULL;
+	char buf[64];
+	int type;
+
+	if (read_pmu_file("type", buf, sizeof(buf)))
+		return;
+	type = atoi(buf);
+
+	for (i = 0; i < n; i++) {
+		struct perf_event_attr attr = {
+			.size = sizeof(attr),
+			.type = type,
+			.read_format = PERF_FORMAT_GROUP,
+		};
+		char file[64];
+		char *cfg;
+
+		snprintf(file, sizeof(file), "events/%s", ddr_events[i]);
+		if (read_pmu_file(file, buf, sizeof(buf)))
+			goto err;
+		cfg = strstr(buf, "event=");
+		if (!cfg)
+			goto err;
+		attr.config = strtoull(cfg + strlen("event="), NULL, 0);
+
+		/* Uncore PMU: system wide, counted by the CPU it is bound to */
+		fds[i] = syscall(__NR_perf_event_open, &attr, -1, 0,
+				 i ? fds[0] : -1, 0);
+		if (fds[i] < 0)
+			goto err;
+	}
+
+	src = add_source(SRC_PERF_GROUP, fds[0], n);
+	if (!src)
+		goto err_close;
+
+	for (i = 0; i < n; i++)
+		snprintf(names[src->first + i], NAME_LEN, "ddr.%s",
+			 ddr_events[i]);
+	return;
+
+err:
+	fprintf(stderr, "rockchip_ddr PMU not usable: %s\n", strerror(errno));
+err_close:
+	while (i--)
+		close(fds[i]);
+}
+
+static uint64_t sysfs_read(int fd, char *buf, size_t len)
+{
+	ssize_t ret = pread(fd, buf, len - 1, 0);
+
+	if (ret <= 0)
+		return 0;
+	buf[ret] = '\0';
+
+	/* Thermal zones may report negative temperatures */
+	return (uint64_t)strtoll(buf, NULL, 10);
+}
+
+static void sample(struct source *src, uint64_t *val)
+{
+	char buf[256];
+	unsigned int j;
+
+	/* Don't leave the values of an older record behind on a failed read */
+	memset(&val[src->first], 0, src->count * sizeof(*val));
+
+	switch (src->type) {
+	case SRC_SYSFS:
+		val[src->first] = sysfs_read(src->fd, buf, sizeof(buf));
+		break;
+	case SRC_BLOCK_STAT: {
+		uint64_t fields[16] = {};
+		char *p = buf;
+		ssize_t ret;
+
+		ret = pread(src->fd, buf, sizeof(buf) - 1, 0);
+		if (ret <= 0)
+			break;
+		buf[ret] = '\0';
+		for (j = 0; j < 16 && *p; j++)
+			fields[j] = strtoull(p, &p, 10);
+		for (j = 0; j < src->count; j++)
+			val[src->first + j] = fields[block_fields[j].field];
+		break;
+	}
+	case SRC_DEVFREQ_STAT:
+		read_trans_stat(src->fd, NULL, &val[src->first], src->count - 1,
+				&val[src->first + src->count - 1]);
+		break;
+	case SRC_ETHTOOL:
+		if (ethtool_ioctl(src->fd, src->ifname, src->estats))
+			break;
+		memcpy(&val[src->first], src->estats->data,
+		       src->count * sizeof(uint64_t));
+		break;
+	case SRC_PERF_GROUP: {
+		uint64_t data[1 + sizeof(ddr_events) / sizeof(ddr_events[0])];
+
+		if (read(src->fd, data, sizeof(data)) != sizeof(data))
+			break;
+		memcpy(&val[src->first], &data[1], src->count * sizeof(uint64_t));
+		break;
+	}
+	}
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-i INTERVAL_MS] [-n SLOTS] [-d SECONDS] [-o FILE] [-v]\n"
+		"\n"
+		"  -i INTERVAL_MS  sampling interval (default: 1000)\n"
+		"  -n SLOTS        records kept in the ring (default: 3600)\n"
+		"  -d SECONDS      stop after this long (default: run until signalled)\n"
+		"  -o FILE         ring buffer file (default: /dev/shm/rk_platform_stats)\n"
+		"  -v              print every record\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = "/dev/shm/rk_platform_stats";
+	char tmp[PATH_MAX];
+	unsigned int interval_ms = 1000, nr_slots = 3600, duration = 0;
+	uint64_t rec_size, size, next, end = 0, i;
+	struct timespec ts;
+	struct ring_hdr *hdr;
+	bool verbose = false;
+	unsigned int s;
+	void *map;
+	int opt, fd, sock;
+
+	while ((opt = getopt(argc, argv, "i:n:d:o:vh")) != -1) {
+		switch (opt) {
+		case 'i':
+			interval_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			nr_slots = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			duration = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			path = optarg;
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		default:
+			usage(argv[0]);
+			return opt != 'h';
+		}
+	}
+
+	if (!interval_ms || !nr_slots) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock >= 0)
+		add_ethtool_stats(sock);
+	add_ddr_pmu();
+	add_sysfs_glob("/sys/devices/system/cpu/cpufreq/policy*/scaling_cur_freq",
+		       1, "cur_freq");
+	add_sysfs_glob("/sys/devices/system/cpu/cpufreq/policy*/stats/total_trans",
+		       2, "total_trans");
+	add_sysfs_glob("/sys/class/devfreq/*/cur_freq", 1, "cur_freq");
+	add_devfreq_stats();
+	add_sysfs_glob("/sys/class/thermal/thermal_zone*/temp", 1, "temp");
+	add_block_stats();
+
+	if (!nr_counters) {
+		fprintf(stderr, "no counters found\n");
+		return 1;
+	}
+
+	rec_size = sizeof(struct ring_rec) + nr_counters * sizeof(uint64_t);
+	size = sizeof(*hdr) + nr_counters * NAME_LEN + nr_slots * rec_size;
+
+	/* Never truncate a ring someone may still have mapped */
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+	fd = mkstemp(tmp);
+	if (fd < 0) {
+		perror(tmp);
+		return 1;
+	}
+	if (fchmod(fd, 0644) || ftruncate(fd, size)) {
+		perror(tmp);
+		unlink(tmp);
+		return 1;
+	}
+
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		perror("mmap");
+		unlink(tmp);
+		return 1;
+	}
+
+	hdr = map;
+	hdr->version = RING_VERSION;
+	hdr->nr_counters = nr_counters;
+	hdr->nr_slots = nr_slots;
+	hdr->interval_ms = interval_ms;
+	hdr->rec_size = rec_size;
+	hdr->names_offset = sizeof(*hdr);
+	hdr->data_offset = sizeof(*hdr) + nr_counters * NAME_LEN;
+	memcpy((char *)map + hdr->names_offset, names, nr_counters * NAME_LEN);
+	/* Readers must not see a valid magic before the layout is set up */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(hdr->magic, RING_MAGIC, sizeof(hdr->magic));
+
+	if (rename(tmp, path)) {
+		perror(path);
+		unlink(tmp);
+		return 1;
+	}
+
+	printf("%u counters from %u sources, %llu bytes ring in %s\n",
+	       nr_counters, nr_sources, (unsigned long long)size, path);
+
+	signal(SIGINT, sigint_handler);
+	signal(SIGTERM, sigint_handler);
+
+	next = now_ns();
+	if (duration)
+		end = next + duration * 1000000000ULL;
+
+	for (i = 0; !stop && (!end || next < end); i++) {
+		struct ring_rec *rec = (void *)((char *)map + hdr->data_offset +
+						(i % nr_slots) * rec_size);
+		uint64_t start;
+
+		__atomic_store_n(&rec->seq, 0, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		start = now_ns();
+		for (s = 0; s < nr_sources; s++)
+			sample(&sources[s], rec->val);
+		rec->time_ns = start;
+		rec->dur_ns = now_ns() - start;
+
+		__atomic_store_n(&rec->seq, i + 1, __ATOMIC_RELEASE);
+		__atomic_store_n(&hdr->head, i + 1, __ATOMIC_RELEASE);
+
+		if (verbose) {
+			printf("record %llu: %llu ns\n", (unsigned long long)i,
+			       (unsigned long long)rec->dur_ns);
+			for (s = 0; s < nr_counters; s++)
+				printf("  %-32s %llu\n", names[s],
+				       (unsigned long long)rec->val[s]);
+		}
+
+		next += interval_ms * 1000000ULL;
+		ts.tv_sec = next / 1000000000ULL;
+		ts.tv_nsec = next % 1000000000ULL;
+		while (!stop && clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+						&ts, NULL) == EINTR)
+			;
+	}
+
+	munmap(map, size);
+	close(fd);
+
+	return 0;
+}
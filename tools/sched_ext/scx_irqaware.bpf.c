@@ -0,0 +1,303 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * An IRQ aware scheduler for small multicore SoCs.
+ *
+ * Aimed at boards with a handful of identical in-order cores, where the cost
+ * of a cold cache dominates and device interrupts are a large part of the
+ * load. Apart from a shared FIFO, the policy has three rules:
+ *
+ * - A task woken up from hardirq or softirq context, or by an IRQ thread, is
+ *   most likely consuming a completion. If the waking CPU is otherwise idle,
+ *   the task runs there, as that CPU just pulled the descriptors and often
+ *   the payload into its cache, unless it is already busy with interrupts.
+ *
+ * - Other wakeups stay on the previous CPU when it is idle, and otherwise go
+ *   to the idle CPU handling the least hardirq and softirq time. That time is
+ *   sampled from kernel_cpustat every IRQLOAD_INTERVAL_NS.
+ *
+ * - The CPUs in shield_mask only run tasks which can't run anywhere else,
+ *   leaving them to RT tasks, which sched_ext doesn't schedule, and to
+ *   threads pinned there on purpose.
+ *
+ * IRQ context detection reads the preempt count from thread_info, which is
+ * only done on arm64. Elsewhere only IRQ threads are recognized.
+ */
+#include <scx/common.bpf.h>
+
+char _license[] SEC("license") = "GPL";
+
+#define MAX_CPUS		64
+#define SHARED_DSQ		0
+#define IRQLOAD_INTERVAL_NS	(100 * 1000 * 1000ULL)
+
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC		1
+#endif
+
+/* Not in vmlinux.h, as these are macros */
+#define PF_KTHREAD		0x00200000
+#define SOFTIRQ_OFFSET		(1U << 8)
+#define HARDIRQ_MASK		(0xfU << 16)
+
+const volatile u32 nr_cpus = 1;
+const volatile u64 shield_mask;
+const volatile u64 slice_ns = SCX_SLICE_DFL;
+const volatile u32 irq_busy_pct = 50;
+
+struct cpu_ctx {
+	u64	irq_time;
+	u32	irq_pct;
+};
+
+/* Read by user space every second */
+struct cpu_ctx cpu_ctxs[MAX_CPUS];
+
+UEI_DEFINE(uei);
+
+extern const struct kernel_cpustat kernel_cpustat __ksym;
+
+enum {
+	STAT_IRQ_WAKE,		/* kept on the CPU which took the interrupt */
+	STAT_LOCAL,		/* dispatched to an idle CPU on wakeup */
+	STAT_PINNED,		/* tasks with no CPU outside shield_mask */
+	STAT_SHARED,		/* queued on the shared DSQ */
+	NR_STATS,
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(key_size, sizeof(u32));
+	__uint(value_size, sizeof(u64));
+	__uint(max_entries, NR_STATS);
+} stats SEC(".maps");
+
+struct irqload_timer {
+	struct bpf_timer timer;
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_ARRAY);
+	__uint(max_entries, 1);
+	__type(key, u32);
+	__type(value, struct irqload_timer);
+} irqload_timer SEC(".maps");
+
+static void stat_inc(u32 idx)
+{
+	u64 *cnt_p = bpf_map_lookup_elem(&stats, &idx);
+
+	if (cnt_p)
+		(*cnt_p)++;
+}
+
+static struct cpu_ctx *lookup_cpu_ctx(s32 cpu)
+{
+	if (cpu < 0 || cpu >= MAX_CPUS)
+		return NULL;
+	return &cpu_ctxs[cpu];
+}
+
+static bool cpu_irq_busy(s32 cpu)
+{
+	struct cpu_ctx *cctx = lookup_cpu_ctx(cpu);
+
+	return !cctx || cctx->irq_pct >= irq_busy_pct;
+}
+
+static bool cpu_shielded(s32 cpu)
+{
+	return cpu >= 0 && cpu < MAX_CPUS && (shield_mask & (1ULL << cpu));
+}
+
+/*
+ * Whether @p must run on the CPU it's on: it either has a single CPU or all
+ * of its CPUs are shielded, so that no CPU looking at the shared DSQ would
+ * ever pick it up.
+ */
+static bool task_pinned(const struct task_struct *p)
+{
+	s32 cpu;
+
+	if (p->nr_cpus_allowed == 1)
+		return true;
+
+	bpf_for(cpu, 0, nr_cpus) {
+		if (!cpu_shielded(cpu) && bpf_cpumask_test_cpu(cpu, p->cpus_ptr))
+			return false;
+	}
+
+	return true;
+}
+
+static bool cpu_usable(const struct task_struct *p, s32 cpu)
+{
+	if (cpu < 0 || cpu >= nr_cpus || !bpf_cpumask_test_cpu(cpu, p->cpus_ptr))
+		return false;
+
+	return !cpu_shielded(cpu) || task_pinned(p);
+}
+
+static bool irq_wakeup(void)
+{
+	struct task_struct *cur = (void *)bpf_get_current_task_btf();
+	char comm[4];
+
+#if defined(__TARGET_ARCH_arm64)
+	if (cur->thread_info.preempt.count & (HARDIRQ_MASK | SOFTIRQ_OFFSET))
+		return true;
+#endif
+	if (!(cur->flags & PF_KTHREAD))
+		return false;
+
+	if (bpf_probe_read_kernel(comm, sizeof(comm), cur->comm))
+		return false;
+
+	return comm[0] == 'i' && comm[1] == 'r' && comm[2] == 'q' &&
+	       comm[3] == '/';
+}
+
+/* Returns the idle CPU with the least interrupt load, or -EBUSY */
+static s32 pick_idle_cpu(const struct task_struct *p)
+{
+	const struct cpumask *idle = scx_bpf_get_idle_cpumask();
+	u32 best_pct = 101;
+	s32 cpu, best = -EBUSY;
+
+	bpf_for(cpu, 0, nr_cpus) {
+		struct cpu_ctx *cctx;
+
+		if (!cpu_usable(p, cpu) || !bpf_cpumask_test_cpu(cpu, idle))
+			continue;
+
+		cctx = lookup_cpu_ctx(cpu);
+		if (cctx && cctx->irq_pct < best_pct) {
+			best_pct = cctx->irq_pct;
+			best = cpu;
+		}
+	}
+
+	scx_bpf_put_idle_cpumask(idle);
+
+	if (best >= 0 && !scx_bpf_test_and_clear_cpu_idle(best))
+		best = -EBUSY;
+
+	return best;
+}
+
+s32 BPF_STRUCT_OPS(irqaware_select_cpu, struct task_struct *p, s32 prev_cpu,
+		   u64 wake_flags)
+{
+	s32 this_cpu = bpf_get_smp_processor_id();
+	s32 cpu;
+
+	/*
+	 * An IRQ which interrupted the idle loop leaves its CPU idle. Queueing
+	 * behind a running task instead would trade the cache for latency.
+	 */
+	if (irq_wakeup() && cpu_usable(p, this_cpu) && !cpu_irq_busy(this_cpu) &&
+	    scx_bpf_test_and_clear_cpu_idle(this_cpu)) {
+		stat_inc(STAT_IRQ_WAKE);
+		scx_bpf_dispatch(p, SCX_DSQ_LOCAL, slice_ns, 0);
+		return this_cpu;
+	}
+
+	if (cpu_usable(p, prev_cpu) && scx_bpf_test_and_clear_cpu_idle(prev_cpu)) {
+		stat_inc(STAT_LOCAL);
+		scx_bpf_dispatch(p, SCX_DSQ_LOCAL, slice_ns, 0);
+		return prev_cpu;
+	}
+
+	cpu = pick_idle_cpu(p);
+	if (cpu >= 0) {
+		stat_inc(STAT_LOCAL);
+		scx_bpf_dispatch(p, SCX_DSQ_LOCAL, slice_ns, 0);
+		return cpu;
+	}
+
+	return prev_cpu;
+}
+
+void BPF_STRUCT_OPS(irqaware_enqueue, struct task_struct *p, u64 enq_flags)
+{
+	s32 cpu;
+
+	/* The shielded CPUs never look at the shared DSQ */
+	if (task_pinned(p)) {
+		cpu = scx_bpf_task_cpu(p);
+		stat_inc(STAT_PINNED);
+		scx_bpf_dispatch(p, SCX_DSQ_LOCAL_ON | cpu, slice_ns, enq_flags);
+		scx_bpf_kick_cpu(cpu, SCX_KICK_IDLE);
+		return;
+	}
+
+	stat_inc(STAT_SHARED);
+	scx_bpf_dispatch(p, SHARED_DSQ, slice_ns, enq_flags);
+
+	cpu = pick_idle_cpu(p);
+	if (cpu >= 0)
+		scx_bpf_kick_cpu(cpu, SCX_KICK_IDLE);
+}
+
+void BPF_STRUCT_OPS(irqaware_dispatch, s32 cpu, struct task_struct *prev)
+{
+	if (!cpu_shielded(cpu))
+		scx_bpf_consume(SHARED_DSQ);
+}
+
+static int irqload_timerfn(void *map, int *key, struct bpf_timer *timer)
+{
+	s32 cpu;
+
+	bpf_for(cpu, 0, nr_cpus) {
+		const struct kernel_cpustat *kcs;
+		struct cpu_ctx *cctx;
+		u64 now, delta;
+
+		kcs = bpf_per_cpu_ptr(&kernel_cpustat, cpu);
+		cctx = lookup_cpu_ctx(cpu);
+		if (!kcs || !cctx)
+			continue;
+
+		now = kcs->cpustat[CPUTIME_IRQ] + kcs->cpustat[CPUTIME_SOFTIRQ];
+		delta = now - cctx->irq_time;
+		cctx->irq_time = now;
+		cctx->irq_pct = delta >= IRQLOAD_INTERVAL_NS ? 100 :
+				delta * 100 / IRQLOAD_INTERVAL_NS;
+	}
+
+	bpf_timer_start(timer, IRQLOAD_INTERVAL_NS, 0);
+	return 0;
+}
+
+s32 BPF_STRUCT_OPS_SLEEPABLE(irqaware_init)
+{
+	struct bpf_timer *timer;
+	u32 key = 0;
+	int ret;
+
+	ret = scx_bpf_create_dsq(SHARED_DSQ, -1);
+	if (ret)
+		return ret;
+
+	timer = bpf_map_lookup_elem(&irqload_timer, &key);
+	if (!timer)
+		return -ESRCH;
+
+	bpf_timer_init(timer, &irqload_timer, CLOCK_MONOTONIC);
+	bpf_timer_set_callback(timer, irqload_timerfn);
+
+	return bpf_timer_start(timer, IRQLOAD_INTERVAL_NS, 0);
+}
+
+void BPF_STRUCT_OPS(irqaware_exit, struct scx_exit_info *ei)
+{
+	UEI_RECORD(uei, ei);
+}
+
+SCX_OPS_DEFINE(irqaware_ops,
+	       .select_cpu		= (void *)irqaware_select_cpu,
+	       .enqueue			= (void *)irqaware_enqueue,
+	       .dispatch		= (void *)irqaware_dispatch,
+	       .init			= (void *)irqaware_init,
+	       .exit			= (void *)irqaware_exit,
+	       .name			= "irqaware");
@@ -0,0 +1,156 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <libgen.h>
+#include <bpf/bpf.h>
+#include <scx/common.h>
+#include "scx_irqaware.bpf.skel.h"
+
+#define MAX_CPUS	64
+
+enum {
+	STAT_IRQ_WAKE,
+	STAT_LOCAL,
+	STAT_PINNED,
+	STAT_SHARED,
+	NR_STATS,
+};
+
+const char help_fmt[] =
+"An IRQ aware sched_ext scheduler for small multicore SoCs.\n"
+"\n"
+"See the top-level comment in .bpf.c for more details.\n"
+"\n"
+"Usage: %s [-s SLICE_US] [-S CPU_LIST] [-b PCT] [-v]\n"
+"\n"
+"  -s SLICE_US   Override slice duration\n"
+"  -S CPU_LIST   CPUs only running tasks pinned to them, e.g. 3 or 2,3\n"
+"  -b PCT        Hardirq+softirq load above which a CPU stops attracting\n"
+"                the consumers of its interrupts (default: 50)\n"
+"  -v            Print libbpf debug messages\n"
+"  -h            Display this help and exit\n";
+
+static bool verbose;
+static volatile int exit_req;
+
+static int libbpf_print_fn(enum libbpf_print_level level, const char *format, va_list args)
+{
+	if (level == LIBBPF_DEBUG && !verbose)
+		return 0;
+	return vfprintf(stderr, format, args);
+}
+
+static void sigint_handler(int dummy)
+{
+	exit_req = 1;
+}
+
+static __u64 parse_cpu_list(const char *str)
+{
+	char *list = strdup(str), *tok, *saveptr;
+	__u64 mask = 0;
+
+	for (tok = strtok_r(list, ",", &saveptr); tok;
+	     tok = strtok_r(NULL, ",", &saveptr)) {
+		int cpu = atoi(tok);
+
+		SCX_BUG_ON(cpu < 0 || cpu >= MAX_CPUS, "Invalid CPU %s", tok);
+		mask |= 1ULL << cpu;
+	}
+
+	free(list);
+	return mask;
+}
+
+static void read_stats(struct scx_irqaware *skel, __u64 *stats)
+{
+	int nr_cpus = libbpf_num_possible_cpus();
+	__u64 cnts[NR_STATS][nr_cpus];
+	__u32 idx;
+
+	memset(stats, 0, sizeof(stats[0]) * NR_STATS);
+
+	for (idx = 0; idx < NR_STATS; idx++) {
+		int ret, cpu;
+
+		ret = bpf_map_lookup_elem(bpf_map__fd(skel->maps.stats),
+					  &idx, cnts[idx]);
+		if (ret < 0)
+			continue;
+		for (cpu = 0; cpu < nr_cpus; cpu++)
+			stats[idx] += cnts[idx][cpu];
+	}
+}
+
+int main(int argc, char **argv)
+{
+	struct scx_irqaware *skel;
+	struct bpf_link *link;
+	__u32 opt, nr_cpus;
+	__u64 ecode;
+
+	libbpf_set_print(libbpf_print_fn);
+	signal(SIGINT, sigint_handler);
+	signal(SIGTERM, sigint_handler);
+restart:
+	skel = SCX_OPS_OPEN(irqaware_ops, scx_irqaware);
+
+	nr_cpus = libbpf_num_possible_cpus();
+	SCX_BUG_ON(nr_cpus > MAX_CPUS, "Only up to %d CPUs are supported",
+		   MAX_CPUS);
+	skel->rodata->nr_cpus = nr_cpus;
+
+	while ((opt = getopt(argc, argv, "s:S:b:vh")) != -1) {
+		switch (opt) {
+		case 's':
+			skel->rodata->slice_ns = strtoull(optarg, NULL, 0) * 1000;
+			break;
+		case 'S':
+			skel->rodata->shield_mask = parse_cpu_list(optarg);
+			break;
+		case 'b':
+			skel->rodata->irq_busy_pct = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		default:
+			fprintf(stderr, help_fmt, basename(argv[0]));
+			return opt != 'h';
+		}
+	}
+
+	SCX_BUG_ON(!(~skel->rodata->shield_mask &
+		     (nr_cpus < MAX_CPUS ? (1ULL << nr_cpus) - 1 : ~0ULL)),
+		   "Cannot shield every CPU");
+
+	SCX_OPS_LOAD(skel, irqaware_ops, scx_irqaware, uei);
+	link = SCX_OPS_ATTACH(skel, irqaware_ops, scx_irqaware);
+
+	while (!exit_req && !UEI_EXITED(skel, uei)) {
+		__u64 stats[NR_STATS];
+		__u32 cpu;
+
+		read_stats(skel, stats);
+		printf("irq_wake=%llu local=%llu pinned=%llu shared=%llu\n",
+		       stats[STAT_IRQ_WAKE], stats[STAT_LOCAL],
+		       stats[STAT_PINNED], stats[STAT_SHARED]);
+		printf("irq_load:");
+		for (cpu = 0; cpu < nr_cpus; cpu++)
+			printf(" %u%%", skel->bss->cpu_ctxs[cpu].irq_pct);
+		printf("\n");
+		fflush(stdout);
+		sleep(1);
+	}
+
+	bpf_link__destroy(link);
+	ecode = UEI_REPORT(skel, uei);
+	scx_irqaware__destroy(skel);
+
+	if (UEI_ECODE_RESTART(ecode))
+		goto restart;
+	return 0;
+}
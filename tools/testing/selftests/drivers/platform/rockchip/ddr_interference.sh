@@ -0,0 +1,190 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# DDR bandwidth interference benchmark for Rockchip SoCs.
+#
+# Runs a set of DMA masters alone and then all together, samples the DDR
+# traffic seen by the DFI through the rockchip_ddr perf PMU and reports,
+# per traffic mix, the mean and p50/p90/p99 of the sampled DDR bandwidth
+# together with the throughput each master achieved.
+#
+# Masters, all optional except the first one:
+#   pl330   dmatest memcpy on $DMA_CHANNEL (default: all free channels)
+#   gmac    $GMAC_CMD, e.g. "iperf3 -c 192.168.1.2 -t 10"
+#   sdhci   sequential reads from $SDHCI_DEV, e.g. /dev/mmcblk0
+#   pcie    sequential reads from $PCIE_DEV, e.g. /dev/nvme0n1
+#
+# VOP2 scanout is not started by this script; if a display pipeline is
+# running, its computed plane fetch bandwidth is read from debugfs and
+# reported alongside each mix.
+#
+# Tunables: DURATION (seconds per mix, default 10), INTERVAL (perf sampling
+# period in ms, default 100), DMA_THREADS (dmatest threads, default 1),
+# DMA_BUF_SIZE (dmatest buffer size, default 1048576).
+
+ksft_skip=4
+
+DURATION=${DURATION:-10}
+INTERVAL=${INTERVAL:-100}
+DMA_THREADS=${DMA_THREADS:-1}
+DMA_BUF_SIZE=${DMA_BUF_SIZE:-1048576}
+
+DMATEST=/sys/module/dmatest/parameters
+PMU=/sys/bus/event_source/devices/rockchip_ddr
+DEBUGFS=/sys/kernel/debug
+
+TMPDIR=$(mktemp -d)
+PIDS=()
+
+cleanup()
+{
+	stop_masters
+	[ -w "$DMATEST/run" ] && echo 0 > "$DMATEST/run"
+	rm -rf "$TMPDIR"
+}
+trap cleanup EXIT
+
+skip()
+{
+	echo "SKIP: $*"
+	exit $ksft_skip
+}
+
+check_env()
+{
+	[ "$(id -u)" -eq 0 ] || skip "must be run as root"
+	command -v perf > /dev/null || skip "perf not found"
+	[ -d "$PMU" ] || skip "rockchip_ddr PMU not available"
+
+	if [ ! -d "$DMATEST" ]; then
+		modprobe dmatest 2> /dev/null || skip "dmatest not available"
+	fi
+}
+
+# $1: master name, $2: output file
+start_master()
+{
+	case "$1" in
+	pl330)
+		echo 0 > "$DMATEST/iterations"
+		echo "$DMA_BUF_SIZE" > "$DMATEST/test_buf_size"
+		echo "$DMA_THREADS" > "$DMATEST/threads_per_chan"
+		echo 1 > "$DMATEST/norandom"
+		echo 1 > "$DMATEST/noverify"
+		echo "${DMA_CHANNEL:-}" > "$DMATEST/channel"
+		# Mark the log rather than clear it, the summaries follow it
+		echo "ddr_interference: $$ $(date +%s%N)" | tee "$2" > /dev/kmsg
+		echo 1 > "$DMATEST/run"
+		;;
+	gmac)
+		$GMAC_CMD > "$2" 2>&1 &
+		PIDS+=($!)
+		;;
+	sdhci|pcie)
+		local dev=$SDHCI_DEV
+
+		[ "$1" = pcie ] && dev=$PCIE_DEV
+		timeout "$DURATION" dd if="$dev" of=/dev/null bs=1M \
+			iflag=direct status=progress > "$2" 2>&1 &
+		PIDS+=($!)
+		;;
+	esac
+}
+
+stop_masters()
+{
+	local pid
+
+	for pid in "${PIDS[@]}"; do
+		kill "$pid" 2> /dev/null
+		wait "$pid" 2> /dev/null
+	done
+	PIDS=()
+}
+
+# $1: master name, $2: output file
+report_master()
+{
+	case "$1" in
+	pl330)
+		echo 0 > "$DMATEST/run"
+		dmesg | awk -v mark="$(cat "$2")" 'seen; index($0, mark) { seen = 1 }' | \
+			grep -o 'summary.*KB/s' | \
+			awk '{ kbs += $(NF - 1) } END { printf "%.1f MB/s\n", kbs / 1024 }'
+		;;
+	gmac)
+		grep -E 'bits/sec' "$2" | tail -n 1 | \
+			awk '{ print $(NF - 2), $(NF - 1) }'
+		;;
+	sdhci|pcie)
+		tr '\r' '\n' < "$2" | grep -o '[0-9.]* [kMG]B/s' | tail -n 1
+		;;
+	esac
+}
+
+report_vop2()
+{
+	local f
+
+	for f in "$DEBUGFS"/dri/*/crtc-*/bandwidth; do
+		[ -r "$f" ] || continue
+		printf "  vop2 %s: %s\n" "$(basename "$(dirname "$f")")" \
+			"$(grep '^total' "$f" | cut -d' ' -f2-)"
+	done
+}
+
+# Turns perf interval CSV into per-interval MB/s and prints statistics.
+report_ddr()
+{
+	awk -F, -v ms="$INTERVAL" '
+		$4 ~ /rockchip_ddr/ { bw[$1] += $2 * 1000 / ms }
+		END { for (t in bw) print bw[t] }' "$1" | sort -n > "$1.sorted"
+
+	awk '{ v[NR] = $1; sum += $1 }
+	     function pct(p) { i = int(NR * p / 100 + 0.5); return v[i < 1 ? 1 : i] }
+	     END {
+		if (!NR) { print "  ddr: no samples"; exit }
+		printf "  ddr: mean %.1f p50 %.1f p90 %.1f p99 %.1f MB/s\n",
+		       sum / NR, pct(50), pct(90), pct(99)
+	     }' "$1.sorted"
+}
+
+# $@: masters taking part in the mix
+run_mix()
+{
+	local name=${*:-idle}
+	local m
+
+	echo "mix: $name"
+
+	for m in "$@"; do
+		start_master "$m" "$TMPDIR/$m.out"
+	done
+
+	perf stat -a -x, -I "$INTERVAL" \
+		-e rockchip_ddr/read-bytes/,rockchip_ddr/write-bytes/ \
+		-o "$TMPDIR/perf.csv" sleep "$DURATION"
+
+	stop_masters
+	for m in "$@"; do
+		printf "  %s: %s\n" "$m" "$(report_master "$m" "$TMPDIR/$m.out")"
+	done
+
+	report_ddr "$TMPDIR/perf.csv"
+	report_vop2
+}
+
+check_env
+
+masters=(pl330)
+[ -n "$GMAC_CMD" ] && masters+=(gmac)
+[ -b "$SDHCI_DEV" ] && masters+=(sdhci)
+[ -b "$PCIE_DEV" ] && masters+=(pcie)
+
+run_mix
+for m in "${masters[@]}"; do
+	run_mix "$m"
+done
+[ ${#masters[@]} -gt 1 ] && run_mix "${masters[@]}"
+
+exit 0
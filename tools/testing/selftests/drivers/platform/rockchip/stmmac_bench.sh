@@ -0,0 +1,286 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Packet processing benchmark for stmmac in MAC loopback mode.
+#
+# Puts the MAC in loopback ("ethtool -K $IFACE loopback on"), so that every
+# frame sent comes back on the RX side without a link partner, and then runs
+# one stage at a time while counting CPU cycles on all CPUs with perf:
+#
+#   xdp-drop  pktgen frames dropped by an XDP_DROP program (xdp-bench drop)
+#   xdp-tx    pktgen frames bounced back by an XDP_TX program (xdp-bench tx)
+#   rx        pktgen frames up the skb path, GRO off
+#   rx-gro    pktgen frames up the skb path, GRO on
+#   tcp       iperf3 TCP through the MAC, TSO and GRO on
+#   tcp-notso same with TSO off
+#   tcp-nogro same with GRO off
+#
+# The pktgen stages are run once per TX queue, and each reports the packets
+# seen by every RX queue and the cycles spent per received packet. Frames
+# sent back by XDP_TX loop back again, so xdp-tx counts every bounce. The TCP
+# stages push a stream from a macvlan in a network namespace to the stmmac
+# interface itself; the frames leave through the MAC and loop back, so they
+# cross the TSO and GRO paths of the driver. They report the throughput and
+# cycles per packet (TX and RX) for each queue mix. Comparing tcp with
+# tcp-notso and tcp-nogro gives the cost of segmentation and of GRO.
+#
+# Stages whose tools are missing (xdp-bench from xdp-tools, iperf3) are
+# skipped. Cycles are counted system wide, so run on an otherwise idle
+# system.
+#
+# Usage: stmmac_bench.sh <iface>
+# Tunables: DURATION (seconds per run, default 10), PKT_SIZE (pktgen frame
+# size, default 64), STAGES (space separated list, default all).
+
+ksft_skip=4
+
+IFACE=$1
+DURATION=${DURATION:-10}
+PKT_SIZE=${PKT_SIZE:-64}
+STAGES=${STAGES:-"xdp-drop xdp-tx rx rx-gro tcp tcp-notso tcp-nogro"}
+
+PGDIR=/proc/net/pktgen
+NS=stmmac-bench
+MACVLAN=mvl-bench
+NS_ADDR=192.0.2.2
+IF_ADDR=192.0.2.1
+
+TMPDIR=$(mktemp -d)
+PIDS=()
+
+skip()
+{
+	echo "SKIP: $*"
+	exit $ksft_skip
+}
+
+stop_bg()
+{
+	local pid
+
+	for pid in "${PIDS[@]}"; do
+		kill "$pid" 2> /dev/null
+		wait "$pid" 2> /dev/null
+	done
+	PIDS=()
+}
+
+cleanup()
+{
+	stop_bg
+	[ -w "$PGDIR/pgctrl" ] && echo reset > "$PGDIR/pgctrl"
+	ip netns del "$NS" 2> /dev/null
+	ip addr del "$IF_ADDR/24" dev "$IFACE" 2> /dev/null
+	if [ -n "$FEATURES" ]; then
+		ethtool -K "$IFACE" $FEATURES 2> /dev/null
+		ip link set dev "$IFACE" promisc off
+	fi
+	rm -rf "$TMPDIR"
+}
+trap cleanup EXIT
+
+check_env()
+{
+	[ "$(id -u)" -eq 0 ] || skip "must be run as root"
+	[ -n "$IFACE" ] || skip "usage: $0 <iface>"
+	[ -d "/sys/class/net/$IFACE" ] || skip "$IFACE not found"
+	command -v perf > /dev/null || skip "perf not found"
+	command -v ethtool > /dev/null || skip "ethtool not found"
+
+	ethtool -k "$IFACE" | grep -q '^loopback: off$' ||
+		skip "$IFACE can't toggle MAC loopback"
+
+	if [ ! -d "$PGDIR" ]; then
+		modprobe pktgen 2> /dev/null || skip "pktgen not available"
+	fi
+}
+
+# Remembers the offloads touched here so that cleanup() can restore them
+save_features()
+{
+	FEATURES=$(ethtool -k "$IFACE" | awk -F': ' '
+		$1 == "tcp-segmentation-offload" { printf "tso %s ", $2 }
+		$1 == "generic-receive-offload" { printf "gro %s ", $2 }
+		$1 == "loopback" { printf "loopback %s ", $2 }')
+}
+
+# $1: rx or tx, prints "packets" for each of the interface's queues
+queue_counts()
+{
+	ethtool -S "$IFACE" | awk -v dir="$1" '
+		$1 ~ "^q[0-9]+_" dir "_pkt_n:$" { printf "%s ", $2 }'
+}
+
+# $1: counts before, $2: counts after, prints the per-queue differences
+queue_delta()
+{
+	local -a before=($1) after=($2)
+	local i
+
+	for i in "${!after[@]}"; do
+		printf "%s " $((after[i] - before[i]))
+	done
+}
+
+# $@: per-queue counts, prints their sum
+sum()
+{
+	local n total=0
+
+	for n in "$@"; do
+		total=$((total + n))
+	done
+	echo $total
+}
+
+# Counts the cycles of all CPUs for DURATION seconds
+count_cycles()
+{
+	perf stat -a -x, -e cycles -o "$TMPDIR/cycles.csv" \
+		sleep "$DURATION" > /dev/null 2>&1
+	awk -F, '$3 ~ /cycles/ { print $1 }' "$TMPDIR/cycles.csv"
+}
+
+# $1: TX queue to send from
+pktgen_start()
+{
+	local dev=$PGDIR/$IFACE
+	local mac
+
+	mac=$(cat "/sys/class/net/$IFACE/address")
+
+	echo reset > "$PGDIR/pgctrl"
+	echo "add_device $IFACE" > "$PGDIR/kpktgend_0"
+	echo "count 0" > "$dev"
+	echo "pkt_size $PKT_SIZE" > "$dev"
+	echo "dst_mac $mac" > "$dev"
+	echo "dst $IF_ADDR" > "$dev"
+	echo "queue_map_min $1" > "$dev"
+	echo "queue_map_max $1" > "$dev"
+	echo "burst 32" > "$dev"
+
+	echo start > "$PGDIR/pgctrl" &
+	PIDS+=($!)
+}
+
+pktgen_stop()
+{
+	echo stop > "$PGDIR/pgctrl"
+	stop_bg
+}
+
+# $1: stage name, $2: stage setup command run in the background, if any
+run_pktgen_stage()
+{
+	local ntxq q rx_before rx_after rx cycles
+
+	ntxq=$(queue_counts tx | wc -w)
+
+	for q in $(seq 0 $((ntxq - 1))); do
+		if [ -n "$2" ]; then
+			$2 > "$TMPDIR/$1.out" 2>&1 &
+			PIDS+=($!)
+			sleep 1
+		fi
+
+		pktgen_start "$q"
+		rx_before=$(queue_counts rx)
+		cycles=$(count_cycles)
+		rx_after=$(queue_counts rx)
+		pktgen_stop
+
+		rx=($(queue_delta "$rx_before" "$rx_after"))
+		printf "  txq%d: rxq pkts [%s] %.1f cycles/pkt\n" "$q" \
+			"${rx[*]}" "$(echo "$cycles $(sum "${rx[@]}")" |
+				awk '{ print $2 ? $1 / $2 : 0 }')"
+	done
+}
+
+setup_macvlan()
+{
+	ip addr add "$IF_ADDR/24" dev "$IFACE"
+	ip netns add "$NS"
+	ip link add "$MACVLAN" link "$IFACE" type macvlan mode private
+	ip link set "$MACVLAN" netns "$NS"
+	ip -n "$NS" addr add "$NS_ADDR/24" dev "$MACVLAN"
+	ip -n "$NS" link set "$MACVLAN" up
+}
+
+run_tcp_stage()
+{
+	local rx_before rx_after tx_before tx_after rx tx cycles bw
+
+	iperf3 -s -B "$IF_ADDR" -1 > /dev/null 2>&1 &
+	PIDS+=($!)
+	sleep 1
+
+	ip netns exec "$NS" iperf3 -c "$IF_ADDR" -t $((DURATION + 2)) \
+		-f m > "$TMPDIR/iperf3.out" 2>&1 &
+	PIDS+=($!)
+	sleep 1
+
+	rx_before=$(queue_counts rx)
+	tx_before=$(queue_counts tx)
+	cycles=$(count_cycles)
+	rx_after=$(queue_counts rx)
+	tx_after=$(queue_counts tx)
+
+	wait "${PIDS[1]}"
+	stop_bg
+
+	rx=($(queue_delta "$rx_before" "$rx_after"))
+	tx=($(queue_delta "$tx_before" "$tx_after"))
+	bw=$(grep -E 'sender$' "$TMPDIR/iperf3.out" | awk '{ print $(NF - 2) }')
+	printf "  %s Mbit/s, txq pkts [%s] rxq pkts [%s] %.1f cycles/pkt\n" \
+		"${bw:-?}" "${tx[*]}" "${rx[*]}" \
+		"$(echo "$cycles $(sum "${tx[@]}" "${rx[@]}")" |
+			awk '{ print $2 ? $1 / $2 : 0 }')"
+}
+
+# $1: stage name
+run_stage()
+{
+	echo "stage: $1"
+
+	case "$1" in
+	xdp-drop|xdp-tx)
+		if ! command -v xdp-bench > /dev/null; then
+			echo "  skipped, xdp-bench not found"
+			return
+		fi
+		ethtool -K "$IFACE" gro off
+		run_pktgen_stage "$1" "xdp-bench ${1#xdp-} -m native $IFACE"
+		;;
+	rx|rx-gro)
+		ethtool -K "$IFACE" gro $([ "$1" = rx ] && echo off || echo on)
+		run_pktgen_stage "$1"
+		;;
+	tcp|tcp-notso|tcp-nogro)
+		if ! command -v iperf3 > /dev/null; then
+			echo "  skipped, iperf3 not found"
+			return
+		fi
+		ethtool -K "$IFACE" \
+			tso $([ "$1" = tcp-notso ] && echo off || echo on) \
+			gro $([ "$1" = tcp-nogro ] && echo off || echo on)
+		run_tcp_stage
+		;;
+	*)
+		echo "  unknown stage"
+		;;
+	esac
+}
+
+check_env
+save_features
+
+ip link set dev "$IFACE" up
+ip link set dev "$IFACE" promisc on
+ethtool -K "$IFACE" loopback on
+setup_macvlan
+
+for stage in $STAGES; do
+	run_stage "$stage"
+done
+
+exit 0
@@ -0,0 +1,705 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Atomic commit latency and throughput of the Rockchip VOP2.
+ *
+ * For a growing number of planes, linear and AFBC framebuffers, with and
+ * without 2x upscaling, the test page flips FRAMES times and reports:
+ *
+ *  - the time from the commit ioctl to the vblank event and the time spent
+ *    in the ioctl itself,
+ *  - the flip rate,
+ *  - the time spent in vop2_plane_atomic_update() and vop2_crtc_atomic_flush()
+ *    per flip when the ftrace function profiler is available.
+ *
+ * Finally the primary plane is flipped with DRM_MODE_PAGE_FLIP_ASYNC for
+ * as many commits per second as the driver takes.
+ *
+ * Combinations the driver rejects in a TEST_ONLY commit are skipped. The
+ * framebuffers are zero filled dumb buffers, so AFBC windows decode all
+ * blocks as solid colour, which is fine for timing. The test needs to be
+ * DRM master: stop any compositor first.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include <drm/drm.h>
+#include <drm/drm_fourcc.h>
+#include <drm/drm_mode.h>
+
+#include "../../../kselftest.h"
+
+#define MAX_PLANES	16
+#define MAX_PROPS	64
+#define TRACEFS		"/sys/kernel/tracing"
+
+/* Values of the plane "type" property, enum drm_plane_type in the kernel */
+#define DRM_PLANE_TYPE_PRIMARY	1
+#define DRM_PLANE_TYPE_CURSOR	2
+
+static int frames = 120;
+
+struct plane {
+	uint32_t id;
+	uint32_t type;
+	uint64_t afbc_mod;
+	uint32_t prop_fb_id, prop_crtc_id;
+	uint32_t prop_src[4], prop_crtc[4];
+};
+
+struct fb {
+	uint32_t handle;
+	uint32_t id;
+};
+
+struct atomic_req {
+	uint32_t objs[MAX_PLANES + 2];
+	uint32_t count_props[MAX_PLANES + 2];
+	uint32_t props[MAX_PROPS];
+	uint64_t values[MAX_PROPS];
+	unsigned int nobjs, nprops;
+};
+
+static int fd;
+static uint32_t crtc_id, conn_id, mode_blob;
+static uint32_t crtc_prop_active, crtc_prop_mode, conn_prop_crtc;
+static unsigned int crtc_index;
+static struct drm_mode_modeinfo mode;
+static struct plane planes[MAX_PLANES];
+static unsigned int nplanes;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t get_prop(uint32_t obj, uint32_t type, const char *name,
+			 uint64_t *value)
+{
+	struct drm_mode_obj_get_properties op = {
+		.obj_id = obj,
+		.obj_type = type,
+	};
+	uint32_t ids[MAX_PROPS];
+	uint64_t vals[MAX_PROPS];
+	unsigned int i;
+
+	if (ioctl(fd, DRM_IOCTL_MODE_OBJ_GETPROPERTIES, &op) ||
+	    op.count_props > MAX_PROPS)
+		return 0;
+
+	op.props_ptr = (uintptr_t)ids;
+	op.prop_values_ptr = (uintptr_t)vals;
+	if (ioctl(fd, DRM_IOCTL_MODE_OBJ_GETPROPERTIES, &op))
+		return 0;
+
+	for (i = 0; i < op.count_props; i++) {
+		struct drm_mode_get_property p = { .prop_id = ids[i] };
+
+		if (ioctl(fd, DRM_IOCTL_MODE_GETPROPERTY, &p))
+			continue;
+		if (!strcmp(p.name, name)) {
+			if (value)
+				*value = vals[i];
+			return ids[i];
+		}
+	}
+
+	return 0;
+}
+
+/* Returns the first AFBC modifier the plane supports for XRGB8888, or 0 */
+static uint64_t find_afbc_modifier(uint32_t plane_id)
+{
+	struct drm_mode_get_blob gb = { 0 };
+	struct drm_format_modifier_blob *blob;
+	struct drm_format_modifier *mods;
+	uint64_t blob_id, found = 0;
+	uint32_t *formats;
+	unsigned int i, fmt = ~0U;
+
+	if (!get_prop(plane_id, DRM_MODE_OBJECT_PLANE, "IN_FORMATS", &blob_id))
+		return 0;
+
+	gb.blob_id = blob_id;
+	if (ioctl(fd, DRM_IOCTL_MODE_GETPROPBLOB, &gb))
+		return 0;
+	blob = malloc(gb.length);
+	if (!blob)
+		return 0;
+	gb.data = (uintptr_t)blob;
+	if (ioctl(fd, DRM_IOCTL_MODE_GETPROPBLOB, &gb))
+		goto out;
+
+	formats = (uint32_t *)((char *)blob + blob->formats_offset);
+	mods = (struct drm_format_modifier *)((char *)blob +
+					      blob->modifiers_offset);
+
+	for (i = 0; i < blob->count_formats; i++) {
+		if (formats[i] == DRM_FORMAT_XRGB8888)
+			fmt = i;
+	}
+
+	for (i = 0; i < blob->count_modifiers && fmt != ~0U; i++) {
+		if (fmt < mods[i].offset || fmt >= mods[i].offset + 64)
+			continue;
+		if (!(mods[i].formats & (1ULL << (fmt - mods[i].offset))))
+			continue;
+		if ((mods[i].modifier >> 56) == DRM_FORMAT_MOD_VENDOR_ARM) {
+			found = mods[i].modifier;
+			break;
+		}
+	}
+out:
+	free(blob);
+	return found;
+}
+
+static int open_rockchip(void)
+{
+	char path[32], name[32];
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		struct drm_version v = {
+			.name = name,
+			.name_len = sizeof(name) - 1,
+		};
+
+		snprintf(path, sizeof(path), "/dev/dri/card%d", i);
+		fd = open(path, O_RDWR | O_CLOEXEC);
+		if (fd < 0)
+			continue;
+
+		memset(name, 0, sizeof(name));
+		if (!ioctl(fd, DRM_IOCTL_VERSION, &v) && !strcmp(name, "rockchip"))
+			return 0;
+		close(fd);
+	}
+
+	return -ENODEV;
+}
+
+static int setup_output(void)
+{
+	struct drm_mode_card_res res = { 0 };
+	struct drm_mode_create_blob cb = { 0 };
+	uint32_t crtcs[8], conns[16], encs[16];
+	unsigned int i;
+
+	if (ioctl(fd, DRM_IOCTL_MODE_GETRESOURCES, &res))
+		return -errno;
+	if (res.count_crtcs > 8 || res.count_connectors > 16 ||
+	    res.count_encoders > 16)
+		return -E2BIG;
+
+	res.crtc_id_ptr = (uintptr_t)crtcs;
+	res.connector_id_ptr = (uintptr_t)conns;
+	res.encoder_id_ptr = (uintptr_t)encs;
+	res.count_fbs = 0;
+	if (ioctl(fd, DRM_IOCTL_MODE_GETRESOURCES, &res))
+		return -errno;
+
+	for (i = 0; i < res.count_connectors && !conn_id; i++) {
+		struct drm_mode_get_connector c = { .connector_id = conns[i] };
+		struct drm_mode_modeinfo modes[64];
+		struct drm_mode_get_encoder e = { 0 };
+		uint32_t conn_encs[8];
+		unsigned int j;
+
+		if (ioctl(fd, DRM_IOCTL_MODE_GETCONNECTOR, &c))
+			continue;
+		if (c.connection != 1 || !c.count_modes ||
+		    c.count_modes > 64 || c.count_encoders > 8)
+			continue;
+
+		c.modes_ptr = (uintptr_t)modes;
+		c.encoders_ptr = (uintptr_t)conn_encs;
+		c.count_props = 0;
+		if (ioctl(fd, DRM_IOCTL_MODE_GETCONNECTOR, &c) || !c.count_encoders)
+			continue;
+
+		e.encoder_id = conn_encs[0];
+		if (ioctl(fd, DRM_IOCTL_MODE_GETENCODER, &e))
+			continue;
+
+		for (j = 0; j < res.count_crtcs; j++) {
+			if (!(e.possible_crtcs & (1 << j)))
+				continue;
+			crtc_id = crtcs[j];
+			crtc_index = j;
+			conn_id = conns[i];
+			mode = modes[0];
+			break;
+		}
+	}
+
+	if (!conn_id)
+		return -ENODEV;
+
+	crtc_prop_active = get_prop(crtc_id, DRM_MODE_OBJECT_CRTC, "ACTIVE", NULL);
+	crtc_prop_mode = get_prop(crtc_id, DRM_MODE_OBJECT_CRTC, "MODE_ID", NULL);
+	conn_prop_crtc = get_prop(conn_id, DRM_MODE_OBJECT_CONNECTOR, "CRTC_ID",
+				  NULL);
+
+	cb.data = (uintptr_t)&mode;
+	cb.length = sizeof(mode);
+	if (ioctl(fd, DRM_IOCTL_MODE_CREATEPROPBLOB, &cb))
+		return -errno;
+	mode_blob = cb.blob_id;
+
+	return 0;
+}
+
+static void setup_planes(void)
+{
+	static const char * const src[] = { "SRC_X", "SRC_Y", "SRC_W", "SRC_H" };
+	static const char * const dst[] = { "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H" };
+	struct drm_mode_get_plane_res pr = { 0 };
+	uint32_t ids[MAX_PLANES];
+	unsigned int i, j;
+
+	if (ioctl(fd, DRM_IOCTL_MODE_GETPLANERESOURCES, &pr) ||
+	    pr.count_planes > MAX_PLANES)
+		return;
+	pr.plane_id_ptr = (uintptr_t)ids;
+	if (ioctl(fd, DRM_IOCTL_MODE_GETPLANERESOURCES, &pr))
+		return;
+
+	for (i = 0; i < pr.count_planes; i++) {
+		struct drm_mode_get_plane gp = { .plane_id = ids[i] };
+		struct plane *p = &planes[nplanes];
+		uint64_t type;
+
+		if (ioctl(fd, DRM_IOCTL_MODE_GETPLANE, &gp) ||
+		    !(gp.possible_crtcs & (1 << crtc_index)))
+			continue;
+
+		if (!get_prop(ids[i], DRM_MODE_OBJECT_PLANE, "type", &type) ||
+		    type == DRM_PLANE_TYPE_CURSOR)
+			continue;
+
+		p->id = ids[i];
+		p->type = type;
+		p->prop_fb_id = get_prop(p->id, DRM_MODE_OBJECT_PLANE, "FB_ID", NULL);
+		p->prop_crtc_id = get_prop(p->id, DRM_MODE_OBJECT_PLANE, "CRTC_ID",
+					   NULL);
+		for (j = 0; j < 4; j++) {
+			p->prop_src[j] = get_prop(p->id, DRM_MODE_OBJECT_PLANE,
+						  src[j], NULL);
+			p->prop_crtc[j] = get_prop(p->id, DRM_MODE_OBJECT_PLANE,
+						   dst[j], NULL);
+		}
+		p->afbc_mod = find_afbc_modifier(p->id);
+
+		/* Keep the primary plane first, it is the one flipped async */
+		if (type == DRM_PLANE_TYPE_PRIMARY && nplanes) {
+			struct plane tmp = planes[0];
+
+			planes[0] = *p;
+			*p = tmp;
+		}
+		nplanes++;
+	}
+}
+
+static int create_fb(unsigned int w, unsigned int h, uint64_t modifier,
+		     struct fb *fb)
+{
+	struct drm_mode_create_dumb cd = { .bpp = 32 };
+	struct drm_mode_fb_cmd2 f = {
+		.width = w,
+		.height = h,
+		.pixel_format = DRM_FORMAT_XRGB8888,
+	};
+
+	/* AFBC needs 16x16 aligned blocks plus a header, be generous */
+	cd.width = (w + 15) & ~15;
+	cd.height = modifier ? ((h + 15) & ~15) * 2 : h;
+	if (ioctl(fd, DRM_IOCTL_MODE_CREATE_DUMB, &cd))
+		return -errno;
+
+	f.handles[0] = cd.handle;
+	f.pitches[0] = modifier ? cd.width * 4 : cd.pitch;
+	if (modifier) {
+		f.flags = DRM_MODE_FB_MODIFIERS;
+		f.modifier[0] = modifier;
+	}
+	if (ioctl(fd, DRM_IOCTL_MODE_ADDFB2, &f)) {
+		struct drm_mode_destroy_dumb dd = { .handle = cd.handle };
+		int ret = -errno;
+
+		ioctl(fd, DRM_IOCTL_MODE_DESTROY_DUMB, &dd);
+		return ret;
+	}
+
+	fb->handle = cd.handle;
+	fb->id = f.fb_id;
+	return 0;
+}
+
+static void destroy_fb(struct fb *fb)
+{
+	struct drm_mode_destroy_dumb dd = { .handle = fb->handle };
+
+	if (!fb->id)
+		return;
+	ioctl(fd, DRM_IOCTL_MODE_RMFB, &fb->id);
+	ioctl(fd, DRM_IOCTL_MODE_DESTROY_DUMB, &dd);
+	fb->id = 0;
+}
+
+static void req_add(struct atomic_req *req, uint32_t obj, uint32_t prop,
+		    uint64_t value)
+{
+	if (!prop || req->nprops == MAX_PROPS)
+		return;
+
+	if (!req->nobjs || req->objs[req->nobjs - 1] != obj) {
+		req->objs[req->nobjs] = obj;
+		req->count_props[req->nobjs++] = 0;
+	}
+	req->count_props[req->nobjs - 1]++;
+	req->props[req->nprops] = prop;
+	req->values[req->nprops++] = value;
+}
+
+static int req_commit(struct atomic_req *req, uint32_t flags)
+{
+	struct drm_mode_atomic a = {
+		.flags = flags,
+		.count_objs = req->nobjs,
+		.objs_ptr = (uintptr_t)req->objs,
+		.count_props_ptr = (uintptr_t)req->count_props,
+		.props_ptr = (uintptr_t)req->props,
+		.prop_values_ptr = (uintptr_t)req->values,
+	};
+
+	return ioctl(fd, DRM_IOCTL_MODE_ATOMIC, &a) ? -errno : 0;
+}
+
+static void req_plane(struct atomic_req *req, struct plane *p, uint32_t fb,
+		      unsigned int src_w, unsigned int src_h)
+{
+	req_add(req, p->id, p->prop_fb_id, fb);
+	req_add(req, p->id, p->prop_crtc_id, fb ? crtc_id : 0);
+	if (!fb)
+		return;
+	req_add(req, p->id, p->prop_src[0], 0);
+	req_add(req, p->id, p->prop_src[1], 0);
+	req_add(req, p->id, p->prop_src[2], (uint64_t)src_w << 16);
+	req_add(req, p->id, p->prop_src[3], (uint64_t)src_h << 16);
+	req_add(req, p->id, p->prop_crtc[0], 0);
+	req_add(req, p->id, p->prop_crtc[1], 0);
+	req_add(req, p->id, p->prop_crtc[2], mode.hdisplay);
+	req_add(req, p->id, p->prop_crtc[3], mode.vdisplay);
+}
+
+/* Returns the vblank event timestamp in ns, 0 on timeout */
+static uint64_t wait_flip(void)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	struct drm_event_vblank ev;
+
+	if (poll(&pfd, 1, 1000) != 1)
+		return 0;
+	if (read(fd, &ev, sizeof(ev)) < (ssize_t)sizeof(ev) ||
+	    ev.base.type != DRM_EVENT_FLIP_COMPLETE)
+		return 0;
+
+	return ev.tv_sec * 1000000000ULL + ev.tv_usec * 1000ULL;
+}
+
+static int tracefs_write(const char *file, const char *val)
+{
+	char path[128];
+	int tfd, ret;
+
+	snprintf(path, sizeof(path), TRACEFS "/%s", file);
+	tfd = open(path, O_WRONLY | O_TRUNC);
+	if (tfd < 0)
+		return -errno;
+	ret = write(tfd, val, strlen(val)) < 0 ? -errno : 0;
+	close(tfd);
+	return ret;
+}
+
+static int profile_start(void)
+{
+	if (tracefs_write("set_ftrace_filter",
+			  "vop2_plane_atomic_update\nvop2_crtc_atomic_flush\n"))
+		return -1;
+	tracefs_write("function_profile_enabled", "0");
+	return tracefs_write("function_profile_enabled", "1");
+}
+
+/* Sums the per CPU profiles of @func, in microseconds */
+static double profile_read(const char *func)
+{
+	char path[64], line[256], name[128];
+	double total = 0, us;
+	unsigned long hits;
+	int cpu;
+
+	for (cpu = 0; ; cpu++) {
+		FILE *f;
+
+		snprintf(path, sizeof(path), TRACEFS "/trace_stat/function%d", cpu);
+		f = fopen(path, "r");
+		if (!f)
+			break;
+		while (fgets(line, sizeof(line), f)) {
+			if (sscanf(line, " %127s %lu %lf", name, &hits, &us) == 3 &&
+			    !strcmp(name, func))
+				total += us;
+		}
+		fclose(f);
+	}
+
+	return total;
+}
+
+static void profile_stop(void)
+{
+	tracefs_write("function_profile_enabled", "0");
+	tracefs_write("set_ftrace_filter", "");
+}
+
+static int modeset(void)
+{
+	struct atomic_req req = { 0 };
+
+	req_add(&req, crtc_id, crtc_prop_active, 1);
+	req_add(&req, crtc_id, crtc_prop_mode, mode_blob);
+	req_add(&req, conn_id, conn_prop_crtc, crtc_id);
+	req_plane(&req, &planes[0], 0, 0, 0);
+
+	return req_commit(&req, DRM_MODE_ATOMIC_ALLOW_MODESET);
+}
+
+static void disable_planes(void)
+{
+	struct atomic_req req = { 0 };
+	unsigned int i;
+
+	for (i = 0; i < nplanes; i++)
+		req_plane(&req, &planes[i], 0, 0, 0);
+	req_commit(&req, 0);
+}
+
+static void run_case(unsigned int n, bool afbc, bool scale)
+{
+	unsigned int w = scale ? mode.hdisplay / 2 : mode.hdisplay;
+	unsigned int h = scale ? mode.vdisplay / 2 : mode.vdisplay;
+	struct fb fbs[MAX_PLANES][2] = { 0 };
+	uint64_t lat_sum = 0, lat_max = 0, ioctl_sum = 0, start, end;
+	struct atomic_req req;
+	bool profiling;
+	char name[64];
+	unsigned int i, f, done = 0;
+	int ret;
+
+	snprintf(name, sizeof(name), "%u plane(s) %s%s", n,
+		 afbc ? "afbc" : "linear", scale ? " 2x scaled" : "");
+
+	for (i = 0; i < n; i++) {
+		if (afbc && !planes[i].afbc_mod) {
+			ksft_test_result_skip("%s: plane %u has no AFBC\n",
+					      name, planes[i].id);
+			goto out;
+		}
+		for (f = 0; f < 2; f++) {
+			ret = create_fb(w, h, afbc ? planes[i].afbc_mod : 0,
+					&fbs[i][f]);
+			if (ret) {
+				ksft_test_result_skip("%s: no framebuffer: %s\n",
+						      name, strerror(-ret));
+				goto out;
+			}
+		}
+	}
+
+	memset(&req, 0, sizeof(req));
+	for (i = 0; i < n; i++)
+		req_plane(&req, &planes[i], fbs[i][0].id, w, h);
+	ret = req_commit(&req, DRM_MODE_ATOMIC_TEST_ONLY);
+	if (ret) {
+		ksft_test_result_skip("%s: rejected: %s\n", name, strerror(-ret));
+		goto out;
+	}
+
+	profiling = !profile_start();
+
+	start = now_ns();
+	for (f = 0; f < (unsigned int)frames; f++) {
+		uint64_t submit, returned, vblank;
+
+		memset(&req, 0, sizeof(req));
+		for (i = 0; i < n; i++)
+			req_plane(&req, &planes[i], fbs[i][f & 1].id, w, h);
+
+		submit = now_ns();
+		ret = req_commit(&req, DRM_MODE_ATOMIC_NONBLOCK |
+				 DRM_MODE_PAGE_FLIP_EVENT);
+		returned = now_ns();
+		if (ret)
+			break;
+
+		vblank = wait_flip();
+		if (!vblank)
+			break;
+
+		ioctl_sum += returned - submit;
+		lat_sum += vblank - submit;
+		if (vblank - submit > lat_max)
+			lat_max = vblank - submit;
+		done++;
+	}
+	end = now_ns();
+
+	if (done) {
+		ksft_print_msg("%s: %u flips, %.1f flips/s, commit to vblank avg %.2f ms max %.2f ms, ioctl avg %.1f us\n",
+			       name, done, done * 1e9 / (end - start),
+			       lat_sum / 1e6 / done, lat_max / 1e6,
+			       ioctl_sum / 1e3 / done);
+		if (profiling)
+			ksft_print_msg("%s: per flip vop2_plane_atomic_update %.1f us, vop2_crtc_atomic_flush %.1f us\n",
+				       name,
+				       profile_read("vop2_plane_atomic_update") / done,
+				       profile_read("vop2_crtc_atomic_flush") / done);
+	}
+	if (profiling)
+		profile_stop();
+
+	if (done == (unsigned int)frames)
+		ksft_test_result_pass("%s\n", name);
+	else
+		ksft_test_result_fail("%s: %s after %u flips\n", name,
+				      ret ? strerror(-ret) : "flip timeout", done);
+out:
+	disable_planes();
+	for (i = 0; i < n; i++) {
+		destroy_fb(&fbs[i][0]);
+		destroy_fb(&fbs[i][1]);
+	}
+}
+
+static void run_async(void)
+{
+	struct drm_get_cap cap = { .capability = DRM_CAP_ATOMIC_ASYNC_PAGE_FLIP };
+	struct fb fbs[2] = { 0 };
+	uint64_t start, end;
+	struct atomic_req req;
+	unsigned int f, done = 0;
+	int ret;
+
+	if (ioctl(fd, DRM_IOCTL_GET_CAP, &cap) || !cap.value) {
+		ksft_test_result_skip("async flips: not supported\n");
+		return;
+	}
+
+	for (f = 0; f < 2; f++) {
+		ret = create_fb(mode.hdisplay, mode.vdisplay, 0, &fbs[f]);
+		if (ret) {
+			ksft_test_result_skip("async flips: no framebuffer: %s\n",
+					      strerror(-ret));
+			goto out;
+		}
+	}
+
+	/* Async commits may only change FB_ID, so show the plane first */
+	memset(&req, 0, sizeof(req));
+	req_plane(&req, &planes[0], fbs[0].id, mode.hdisplay, mode.vdisplay);
+	ret = req_commit(&req, 0);
+	if (ret) {
+		ksft_test_result_skip("async flips: %s\n", strerror(-ret));
+		goto out;
+	}
+
+	start = now_ns();
+	for (f = 1; f <= (unsigned int)frames * 4; f++) {
+		memset(&req, 0, sizeof(req));
+		req_add(&req, planes[0].id, planes[0].prop_fb_id, fbs[f & 1].id);
+		ret = req_commit(&req, DRM_MODE_ATOMIC_NONBLOCK |
+				 DRM_MODE_PAGE_FLIP_ASYNC |
+				 DRM_MODE_PAGE_FLIP_EVENT);
+		if (ret || !wait_flip())
+			break;
+		done++;
+	}
+	end = now_ns();
+
+	if (done)
+		ksft_print_msg("async flips: %u commits, %.1f commits/s\n",
+			       done, done * 1e9 / (end - start));
+	if (done == (unsigned int)frames * 4)
+		ksft_test_result_pass("async flips\n");
+	else
+		ksft_test_result_fail("async flips: %s after %u commits\n",
+				      ret ? strerror(-ret) : "flip timeout", done);
+out:
+	disable_planes();
+	destroy_fb(&fbs[0]);
+	destroy_fb(&fbs[1]);
+}
+
+int main(int argc, char **argv)
+{
+	struct drm_set_client_cap cc;
+	unsigned int n;
+	int ret;
+
+	if (argc > 1)
+		frames = atoi(argv[1]) ?: frames;
+
+	ksft_print_header();
+
+	if (open_rockchip())
+		ksft_exit_skip("no rockchip DRM device\n");
+
+	cc.capability = DRM_CLIENT_CAP_UNIVERSAL_PLANES;
+	cc.value = 1;
+	ioctl(fd, DRM_IOCTL_SET_CLIENT_CAP, &cc);
+	cc.capability = DRM_CLIENT_CAP_ATOMIC;
+	if (ioctl(fd, DRM_IOCTL_SET_CLIENT_CAP, &cc))
+		ksft_exit_skip("atomic modesetting not supported\n");
+
+	ret = setup_output();
+	if (ret)
+		ksft_exit_skip("no connected output: %s\n", strerror(-ret));
+
+	setup_planes();
+	if (!nplanes)
+		ksft_exit_skip("no usable planes\n");
+
+	ret = modeset();
+	if (ret)
+		ksft_exit_skip("modeset failed (is a compositor running?): %s\n",
+			       strerror(-ret));
+
+	ksft_print_msg("%ux%u@%u on crtc %u, %u planes\n", mode.hdisplay,
+		       mode.vdisplay, mode.vrefresh, crtc_id, nplanes);
+	ksft_set_plan(nplanes * 4 + 1);
+
+	for (n = 1; n <= nplanes; n++) {
+		run_case(n, false, false);
+		run_case(n, false, true);
+		run_case(n, true, false);
+		run_case(n, true, true);
+	}
+	run_async();
+
+	close(fd);
+	ksft_finished();
+}